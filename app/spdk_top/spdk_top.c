@@ -61,6 +61,10 @@
 #define MAX_TIME_STR_LEN 12
 #define MAX_FLOAT_STR_LEN 8
 #define MAX_POLLER_RUN_COUNT 20
+#define MAX_POLLER_HISTOGRAM_BUCKETS 64
+#define MAX_LATENCY_STR_LEN 12
+#define LATENCY_HISTORY_LEN 16
+#define MAX_LATENCY_HISTORY_STR_LEN (LATENCY_HISTORY_LEN + 1)
 #define MAX_PERIOD_STR_LEN 12
 #define MAX_INTR_LEN 6
 #define WINDOW_HEADER 12
@@ -71,7 +75,7 @@
 #define CORE_WIN_FIRST_COL 16
 #define CORE_WIN_WIDTH 48
 #define CORE_WIN_HEIGHT 11
-#define POLLER_WIN_HEIGHT 8
+#define POLLER_WIN_HEIGHT 9
 #define POLLER_WIN_WIDTH 64
 #define POLLER_WIN_FIRST_COL 14
 #define FIRST_DATA_ROW 7
@@ -108,6 +112,9 @@ enum column_pollers_type {
 	COL_POLLERS_RUN_COUNTER,
 	COL_POLLERS_PERIOD,
 	COL_POLLERS_BUSY_COUNT,
+	COL_POLLERS_AVG_TIME,
+	COL_POLLERS_MAX_TIME,
+	COL_POLLERS_LATENCY_HISTORY,
 	COL_POLLERS_NONE = 255,
 };
 
@@ -146,6 +153,12 @@ struct run_counter_history {
 	uint64_t thread_id;
 	uint64_t last_run_counter;
 	uint64_t last_busy_counter;
+	uint64_t last_run_ticks;
+	uint64_t last_run_ticks_histogram[MAX_POLLER_HISTOGRAM_BUCKETS];
+	/* Worst execution time bucket (plus one, 0 means no executions) seen
+	 * in each of the last LATENCY_HISTORY_LEN refresh intervals. */
+	uint8_t latency_history[LATENCY_HISTORY_LEN];
+	uint8_t latency_history_pos;
 	TAILQ_ENTRY(run_counter_history) link;
 };
 
@@ -186,6 +199,9 @@ static struct col_desc g_col_desc[NUMBER_OF_TABS][TABS_COL_COUNT] = {
 		{.name = "Run count", .max_data_string = MAX_POLLER_RUN_COUNT},
 		{.name = "Period [us]", .max_data_string = MAX_PERIOD_STR_LEN},
 		{.name = "Status (busy count)", .max_data_string = MAX_POLLER_IND_STR_LEN},
+		{.name = "Avg [us]", .max_data_string = MAX_LATENCY_STR_LEN},
+		{.name = "Max [us]", .max_data_string = MAX_LATENCY_STR_LEN},
+		{.name = "Latency history", .max_data_string = MAX_LATENCY_HISTORY_STR_LEN},
 		{.name = (char *)NULL}
 	},
 	{	{.name = "Core", .max_data_string = MAX_CORE_STR_LEN},
@@ -226,6 +242,10 @@ struct rpc_poller_info {
 	uint64_t run_count;
 	uint64_t busy_count;
 	uint64_t period_ticks;
+	uint64_t run_ticks;
+	uint64_t max_run_ticks;
+	uint64_t run_ticks_histogram[MAX_POLLER_HISTOGRAM_BUCKETS];
+	size_t run_ticks_histogram_count;
 	enum spdk_poller_type type;
 	char thread_name[MAX_THREAD_NAME];
 	uint64_t thread_id;
@@ -364,6 +384,17 @@ free_rpc_core_info(struct rpc_core_info *core_info, size_t size)
 	}
 }
 
+static int
+decode_run_ticks_histogram(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_poller_info *poller = SPDK_CONTAINEROF(out, struct rpc_poller_info,
+				       run_ticks_histogram);
+
+	return spdk_json_decode_array(val, spdk_json_decode_uint64, poller->run_ticks_histogram,
+				      MAX_POLLER_HISTOGRAM_BUCKETS, &poller->run_ticks_histogram_count,
+				      sizeof(uint64_t));
+}
+
 static const struct spdk_json_object_decoder rpc_pollers_decoders[] = {
 	{"name", offsetof(struct rpc_poller_info, name), spdk_json_decode_string},
 	{"state", offsetof(struct rpc_poller_info, state), spdk_json_decode_string},
@@ -371,6 +402,9 @@ static const struct spdk_json_object_decoder rpc_pollers_decoders[] = {
 	{"run_count", offsetof(struct rpc_poller_info, run_count), spdk_json_decode_uint64},
 	{"busy_count", offsetof(struct rpc_poller_info, busy_count), spdk_json_decode_uint64},
 	{"period_ticks", offsetof(struct rpc_poller_info, period_ticks), spdk_json_decode_uint64, true},
+	{"run_ticks", offsetof(struct rpc_poller_info, run_ticks), spdk_json_decode_uint64, true},
+	{"max_run_ticks", offsetof(struct rpc_poller_info, max_run_ticks), spdk_json_decode_uint64, true},
+	{"run_ticks_histogram", offsetof(struct rpc_poller_info, run_ticks_histogram), decode_run_ticks_histogram, true},
 };
 
 static int
@@ -699,31 +733,101 @@ sort_threads(const void *p1, const void *p2)
 	return res;
 }
 
-static void
-store_last_counters(uint64_t poller_id, uint64_t thread_id, uint64_t last_run_counter,
-		    uint64_t last_busy_counter)
+static struct run_counter_history *
+get_run_counter_history(uint64_t poller_id, uint64_t thread_id)
 {
 	struct run_counter_history *history;
 
 	TAILQ_FOREACH(history, &g_run_counter_history, link) {
 		if ((history->poller_id == poller_id) && (history->thread_id == thread_id)) {
-			history->last_run_counter = last_run_counter;
-			history->last_busy_counter = last_busy_counter;
+			return history;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+store_last_counters(const struct rpc_poller_info *poller)
+{
+	struct run_counter_history *history;
+
+	history = get_run_counter_history(poller->id, poller->thread_id);
+	if (history == NULL) {
+		history = calloc(1, sizeof(*history));
+		if (history == NULL) {
+			fprintf(stderr, "Unable to allocate a history object in store_last_counters.\n");
 			return;
 		}
+		history->poller_id = poller->id;
+		history->thread_id = poller->thread_id;
+
+		TAILQ_INSERT_TAIL(&g_run_counter_history, history, link);
 	}
 
-	history = calloc(1, sizeof(*history));
+	history->last_run_counter = poller->run_count;
+	history->last_busy_counter = poller->busy_count;
+	history->last_run_ticks = poller->run_ticks;
+	memset(history->last_run_ticks_histogram, 0, sizeof(history->last_run_ticks_histogram));
+	memcpy(history->last_run_ticks_histogram, poller->run_ticks_histogram,
+	       poller->run_ticks_histogram_count * sizeof(uint64_t));
+}
+
+/* Record the worst execution time bucket of the last refresh interval.  Must be
+ * called after store_last_counters() has saved the previous poller counters. */
+static void
+store_latency_history(const struct rpc_poller_info *poller)
+{
+	struct run_counter_history *history;
+	uint8_t level = 0;
+	size_t i;
+
+	history = get_run_counter_history(poller->id, poller->thread_id);
 	if (history == NULL) {
-		fprintf(stderr, "Unable to allocate a history object in store_last_counters.\n");
 		return;
 	}
-	history->poller_id = poller_id;
-	history->thread_id = thread_id;
-	history->last_run_counter = last_run_counter;
-	history->last_busy_counter = last_busy_counter;
 
-	TAILQ_INSERT_TAIL(&g_run_counter_history, history, link);
+	for (i = poller->run_ticks_histogram_count; i > 0; i--) {
+		if (poller->run_ticks_histogram[i - 1] > history->last_run_ticks_histogram[i - 1]) {
+			level = i;
+			break;
+		}
+	}
+
+	history->latency_history[history->latency_history_pos] = level;
+	history->latency_history_pos = (history->latency_history_pos + 1) % LATENCY_HISTORY_LEN;
+}
+
+static uint8_t
+get_last_latency_level(const struct rpc_poller_info *poller)
+{
+	struct run_counter_history *history;
+
+	history = get_run_counter_history(poller->id, poller->thread_id);
+	if (history == NULL) {
+		return 0;
+	}
+
+	return history->latency_history[(history->latency_history_pos + LATENCY_HISTORY_LEN - 1) %
+					LATENCY_HISTORY_LEN];
+}
+
+static uint64_t
+get_avg_run_ticks(const struct rpc_poller_info *poller)
+{
+	struct run_counter_history *history;
+	uint64_t run_count = poller->run_count;
+	uint64_t run_ticks = poller->run_ticks;
+
+	if (g_interval_data) {
+		history = get_run_counter_history(poller->id, poller->thread_id);
+		if (history != NULL) {
+			run_count -= history->last_run_counter;
+			run_ticks -= history->last_run_ticks;
+		}
+	}
+
+	return run_count != 0 ? run_ticks / run_count : 0;
 }
 
 static int
@@ -871,6 +975,18 @@ subsort_pollers(enum column_pollers_type sort_column, const void *p1, const void
 			}
 		}
 		break;
+	case COL_POLLERS_AVG_TIME:
+		count1 = get_avg_run_ticks(poller1);
+		count2 = get_avg_run_ticks(poller2);
+		break;
+	case COL_POLLERS_MAX_TIME:
+		count1 = poller1->max_run_ticks;
+		count2 = poller2->max_run_ticks;
+		break;
+	case COL_POLLERS_LATENCY_HISTORY:
+		count1 = get_last_latency_level(poller1);
+		count2 = get_last_latency_level(poller2);
+		break;
 	case COL_POLLERS_NONE:
 	default:
 		return 0;
@@ -925,8 +1041,11 @@ get_pollers_data(void)
 
 	/* Save last run counter of each poller before updating g_pollers_stats. */
 	for (i = 0; i < g_last_pollers_count; i++) {
-		store_last_counters(g_pollers_info[i].id, g_pollers_info[i].thread_id,
-				    g_pollers_info[i].run_count, g_pollers_info[i].busy_count);
+		store_last_counters(&g_pollers_info[i]);
+	}
+
+	for (i = 0; i < current_pollers_count; i++) {
+		store_latency_history(&pollers_info[i]);
 	}
 
 	/* Free old pollers values before allocating memory for new ones */
@@ -1306,6 +1425,45 @@ get_time_str(uint64_t ticks, char *time_str)
 	snprintf(time_str, MAX_TIME_STR_LEN, "%" PRIu64, time);
 }
 
+static void
+get_latency_str(uint64_t ticks, char *latency_str)
+{
+	double time;
+
+	time = (double)ticks * SPDK_SEC_TO_USEC / g_tick_rate;
+	snprintf(latency_str, MAX_LATENCY_STR_LEN, "%.2f", time);
+}
+
+static void
+get_latency_history_str(const struct rpc_poller_info *poller, char *history_str)
+{
+	static const char levels[] = " .:-=+*#";
+	struct run_counter_history *history;
+	uint8_t level, max_level = 0;
+	int i;
+
+	memset(history_str, ' ', LATENCY_HISTORY_LEN);
+	history_str[LATENCY_HISTORY_LEN] = '\0';
+
+	history = get_run_counter_history(poller->id, poller->thread_id);
+	if (history == NULL) {
+		return;
+	}
+
+	for (i = 0; i < LATENCY_HISTORY_LEN; i++) {
+		max_level = spdk_max(max_level, history->latency_history[i]);
+	}
+	if (max_level == 0) {
+		return;
+	}
+
+	/* Oldest interval first, each one scaled against the worst in the window */
+	for (i = 0; i < LATENCY_HISTORY_LEN; i++) {
+		level = history->latency_history[(history->latency_history_pos + i) % LATENCY_HISTORY_LEN];
+		history_str[i] = levels[level * (sizeof(levels) - 2) / max_level];
+	}
+}
+
 static void
 draw_row_background(uint8_t item_index, uint8_t tab)
 {
@@ -1489,7 +1647,8 @@ draw_poller_tab_row(uint64_t current_row, uint8_t item_index)
 	uint64_t last_run_counter, last_busy_counter;
 	uint16_t col = TABS_DATA_START_COL;
 	char run_count[MAX_POLLER_RUN_COUNT], period_ticks[MAX_PERIOD_STR_LEN],
-	     status[MAX_POLLER_IND_STR_LEN];
+	     status[MAX_POLLER_IND_STR_LEN], latency[MAX_LATENCY_STR_LEN],
+	     latency_history[MAX_LATENCY_HISTORY_STR_LEN];
 
 	last_busy_counter = get_last_busy_counter(g_pollers_info[current_row].id,
 			    g_pollers_info[current_row].thread_id);
@@ -1578,6 +1737,27 @@ draw_poller_tab_row(uint64_t current_row, uint8_t item_index)
 				wattroff(g_tabs[POLLERS_TAB], COLOR_PAIR(9));
 			}
 		}
+		col += col_desc[COL_POLLERS_BUSY_COUNT].max_data_string;
+	}
+
+	if (!col_desc[COL_POLLERS_AVG_TIME].disabled) {
+		get_latency_str(get_avg_run_ticks(&g_pollers_info[current_row]), latency);
+		print_max_len(g_tabs[POLLERS_TAB], TABS_DATA_START_ROW + item_index, col,
+			      col_desc[COL_POLLERS_AVG_TIME].max_data_string, ALIGN_RIGHT, latency);
+		col += col_desc[COL_POLLERS_AVG_TIME].max_data_string;
+	}
+
+	if (!col_desc[COL_POLLERS_MAX_TIME].disabled) {
+		get_latency_str(g_pollers_info[current_row].max_run_ticks, latency);
+		print_max_len(g_tabs[POLLERS_TAB], TABS_DATA_START_ROW + item_index, col,
+			      col_desc[COL_POLLERS_MAX_TIME].max_data_string, ALIGN_RIGHT, latency);
+		col += col_desc[COL_POLLERS_MAX_TIME].max_data_string + 2;
+	}
+
+	if (!col_desc[COL_POLLERS_LATENCY_HISTORY].disabled) {
+		get_latency_history_str(&g_pollers_info[current_row], latency_history);
+		print_max_len(g_tabs[POLLERS_TAB], TABS_DATA_START_ROW + item_index, col,
+			      col_desc[COL_POLLERS_LATENCY_HISTORY].max_data_string, ALIGN_LEFT, latency_history);
 	}
 }
 
@@ -2797,7 +2977,7 @@ static void
 draw_poller_win_content(WINDOW *poller_win, struct rpc_poller_info *poller_info)
 {
 	uint64_t last_run_counter, last_busy_counter, busy_count;
-	char poller_period[MAX_TIME_STR_LEN];
+	char poller_period[MAX_TIME_STR_LEN], latency[MAX_LATENCY_STR_LEN];
 
 	box(poller_win, 0, 0);
 
@@ -2826,23 +3006,29 @@ draw_poller_win_content(WINDOW *poller_win, struct rpc_poller_info *poller_info)
 		get_time_str(poller_info->period_ticks, poller_period);
 		mvwprintw(poller_win, 4, POLLER_WIN_FIRST_COL + 23, "%s", poller_period);
 	}
-	mvwhline(poller_win, 5, 1, ACS_HLINE, POLLER_WIN_WIDTH - 2);
+
+	print_left(poller_win, 5, 2, POLLER_WIN_WIDTH, "Avg [us]:              Max [us]:", COLOR_PAIR(5));
+	get_latency_str(get_avg_run_ticks(poller_info), latency);
+	mvwprintw(poller_win, 5, POLLER_WIN_FIRST_COL, "%s", latency);
+	get_latency_str(poller_info->max_run_ticks, latency);
+	mvwprintw(poller_win, 5, POLLER_WIN_FIRST_COL + 23, "%s", latency);
+	mvwhline(poller_win, 6, 1, ACS_HLINE, POLLER_WIN_WIDTH - 2);
 
 	busy_count = g_interval_data ? poller_info->busy_count - last_busy_counter :
 		     poller_info->busy_count;
 	if (busy_count != 0) {
-		print_left(poller_win, 6, 2, POLLER_WIN_WIDTH,  "Status:               Busy count:", COLOR_PAIR(5));
+		print_left(poller_win, 7, 2, POLLER_WIN_WIDTH,  "Status:               Busy count:", COLOR_PAIR(5));
 
 		if (g_interval_data == false && poller_info->busy_count == last_busy_counter) {
-			print_left(poller_win, 6, POLLER_WIN_FIRST_COL, POLLER_WIN_WIDTH, "Idle", COLOR_PAIR(7));
+			print_left(poller_win, 7, POLLER_WIN_FIRST_COL, POLLER_WIN_WIDTH, "Idle", COLOR_PAIR(7));
 		} else {
-			print_left(poller_win, 6, POLLER_WIN_FIRST_COL, POLLER_WIN_WIDTH, "Busy", COLOR_PAIR(6));
+			print_left(poller_win, 7, POLLER_WIN_FIRST_COL, POLLER_WIN_WIDTH, "Busy", COLOR_PAIR(6));
 		}
 
-		mvwprintw(poller_win, 6, POLLER_WIN_FIRST_COL + 23, "%" PRIu64, busy_count);
+		mvwprintw(poller_win, 7, POLLER_WIN_FIRST_COL + 23, "%" PRIu64, busy_count);
 	} else {
-		print_in_middle(poller_win, 6, 1, POLLER_WIN_WIDTH - 7, "Status:", COLOR_PAIR(5));
-		print_in_middle(poller_win, 6, 1, POLLER_WIN_WIDTH + 6, "Idle", COLOR_PAIR(7));
+		print_in_middle(poller_win, 7, 1, POLLER_WIN_WIDTH - 7, "Status:", COLOR_PAIR(5));
+		print_in_middle(poller_win, 7, 1, POLLER_WIN_WIDTH + 6, "Idle", COLOR_PAIR(7));
 	}
 
 	wnoutrefresh(poller_win);
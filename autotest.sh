@@ -374,6 +374,7 @@ if [ $SPDK_RUN_FUNCTIONAL_TEST -eq 1 ]; then
 
 	if [[ $SPDK_TEST_RAID5 -eq 1 ]]; then
 		run_test "blockdev_raid5f" $rootdir/test/bdev/blockdev.sh "raid5f"
+		run_test "blockdev_raid6f" $rootdir/test/bdev/blockdev.sh "raid6f"
 	fi
 fi
 
@@ -14,6 +14,9 @@
 #include "spdk/util.h"
 #include "spdk/xor.h"
 #include "spdk/dif.h"
+#include "spdk/endian.h"
+#include "spdk/sha256.h"
+#include "spdk/xxhash.h"
 
 #define DATA_PATTERN 0x5a
 #define ALIGN_4K 0x1000
@@ -44,6 +47,10 @@ static const char *g_module_name = NULL;
 static struct worker_thread *g_workers = NULL;
 static int g_num_workers = 0;
 static char *g_cd_file_in_name = NULL;
+static enum spdk_accel_comp_algo g_comp_algo = SPDK_ACCEL_COMP_ALGO_DEFLATE;
+/* -1 selects the fastest level supported by the module */
+static int g_comp_level = -1;
+static enum spdk_accel_hash_algo g_hash_algo = SPDK_ACCEL_HASH_ALGO_XXH64;
 static pthread_mutex_t g_workers_lock = PTHREAD_MUTEX_INITIALIZER;
 static struct spdk_app_opts g_opts = {};
 
@@ -134,6 +141,8 @@ dump_user_config(void)
 		printf("Failure inject: %u percent\n", g_fail_percent_goal);
 	} else if (g_workload_selection == SPDK_ACCEL_OPC_XOR) {
 		printf("Source buffers: %u\n", g_xor_src_count);
+	} else if (g_workload_selection == SPDK_ACCEL_OPC_HASH) {
+		printf("Hash algorithm: %s\n", spdk_accel_get_hash_algo_name(g_hash_algo));
 	}
 	if (g_workload_selection == SPDK_ACCEL_OPC_COPY_CRC32C ||
 	    g_workload_selection == SPDK_ACCEL_OPC_DIF_VERIFY ||
@@ -154,6 +163,10 @@ dump_user_config(void)
 	if (g_workload_selection == SPDK_ACCEL_OPC_COMPRESS ||
 	    g_workload_selection == SPDK_ACCEL_OPC_DECOMPRESS) {
 		printf("File Name:      %s\n", g_cd_file_in_name);
+		printf("Algorithm:      %s\n", spdk_accel_get_comp_algo_name(g_comp_algo));
+		if (g_workload_selection == SPDK_ACCEL_OPC_COMPRESS) {
+			printf("Level:          %d\n", g_comp_level);
+		}
 	}
 	printf("Queue depth:    %u\n", g_queue_depth);
 	printf("Allocate depth: %u\n", g_allocate_depth);
@@ -173,13 +186,16 @@ usage(void)
 	printf("\t[-o transfer size in bytes (default: 4KiB. For compress/decompress, 0 means the input file size)]\n");
 	printf("\t[-t time in seconds]\n");
 	printf("\t[-w workload type must be one of these: copy, fill, crc32c, copy_crc32c, compare, compress, decompress, dualcast, xor,\n");
-	printf("\t[                                       dif_verify, dif_verify_copy, dif_generate, dif_generate_copy\n");
+	printf("\t[                                       dif_verify, dif_verify_copy, dif_generate, dif_generate_copy, hash\n");
 	printf("\t[-M assign module to the operation, not compatible with accel_assign_opc RPC\n");
 	printf("\t[-l for compress/decompress workloads, name of uncompressed input file\n");
+	printf("\t[-k for compress/decompress workloads, compression algorithm: deflate, lz4 or zstd (default: deflate)\n");
+	printf("\t[-K for compress/decompress workloads, compression level (default: fastest level supported)\n");
 	printf("\t[-S for crc32c workload, use this seed value (default 0)\n");
 	printf("\t[-P for compare workload, percentage of operations that should miscompare (percent, default 0)\n");
 	printf("\t[-f for fill workload, use this BYTE value (default 255)\n");
 	printf("\t[-x for xor workload, use this number of source buffers (default, minimum: 2)]\n");
+	printf("\t[-H for hash workload, hash algorithm: xxh64 or sha256 (default: xxh64)\n");
 	printf("\t[-y verify result if this switch is on]\n");
 	printf("\t[-a tasks to allocate per core (default: same value as -q)]\n");
 	printf("\t\tCan be used to spread operations across a wider range of memory.\n");
@@ -194,6 +210,7 @@ parse_args(int ch, char *arg)
 	case 'a':
 	case 'C':
 	case 'f':
+	case 'K':
 	case 'T':
 	case 'o':
 	case 'P':
@@ -222,6 +239,23 @@ parse_args(int ch, char *arg)
 	case 'l':
 		g_cd_file_in_name = optarg;
 		break;
+	case 'k':
+		if (spdk_accel_get_comp_algo_by_name(optarg, &g_comp_algo) != 0) {
+			fprintf(stderr, "Unsupported compression algorithm: %s\n", optarg);
+			usage();
+			return 1;
+		}
+		break;
+	case 'K':
+		g_comp_level = argval;
+		break;
+	case 'H':
+		if (spdk_accel_get_hash_algo_by_name(optarg, &g_hash_algo) != 0) {
+			fprintf(stderr, "Unsupported hash algorithm: %s\n", optarg);
+			usage();
+			return 1;
+		}
+		break;
 	case 'f':
 		g_fill_pattern = (uint8_t)argval;
 		break;
@@ -277,6 +311,8 @@ parse_args(int ch, char *arg)
 			g_workload_selection = SPDK_ACCEL_OPC_DIF_GENERATE;
 		} else if (!strcmp(g_workload_type, "dif_generate_copy")) {
 			g_workload_selection = SPDK_ACCEL_OPC_DIF_GENERATE_COPY;
+		} else if (!strcmp(g_workload_type, "hash")) {
+			g_workload_selection = SPDK_ACCEL_OPC_HASH;
 		} else {
 			fprintf(stderr, "Unsupported workload type: %s\n", optarg);
 			usage();
@@ -495,7 +531,8 @@ _get_task_data_bufs(struct ap_task *task)
 	    g_workload_selection == SPDK_ACCEL_OPC_COPY_CRC32C ||
 	    g_workload_selection == SPDK_ACCEL_OPC_DIF_VERIFY ||
 	    g_workload_selection == SPDK_ACCEL_OPC_DIF_GENERATE ||
-	    g_workload_selection == SPDK_ACCEL_OPC_DIF_GENERATE_COPY) {
+	    g_workload_selection == SPDK_ACCEL_OPC_DIF_GENERATE_COPY ||
+	    g_workload_selection == SPDK_ACCEL_OPC_HASH) {
 		assert(g_chained_count > 0);
 		task->src_iovcnt = g_chained_count;
 		task->src_iovs = calloc(task->src_iovcnt, sizeof(struct iovec));
@@ -506,6 +543,9 @@ _get_task_data_bufs(struct ap_task *task)
 
 		if (g_workload_selection == SPDK_ACCEL_OPC_COPY_CRC32C) {
 			dst_buff_len = g_xfer_size_bytes * g_chained_count;
+		} else if (g_workload_selection == SPDK_ACCEL_OPC_HASH) {
+			/* The digest is written to the dst buffer */
+			dst_buff_len = SPDK_ACCEL_HASH_MAX_DIGEST_LEN;
 		}
 
 		if (g_workload_selection == SPDK_ACCEL_OPC_DIF_GENERATE ||
@@ -656,6 +696,10 @@ _submit_single(struct worker_thread *worker, struct ap_task *task)
 		rc = spdk_accel_submit_copy_crc32cv(worker->ch, task->dst, task->src_iovs, task->src_iovcnt,
 						    task->crc_dst, g_crc32c_seed, accel_done, task);
 		break;
+	case SPDK_ACCEL_OPC_HASH:
+		rc = spdk_accel_submit_hash(worker->ch, task->dst, task->src_iovs, task->src_iovcnt,
+					    g_hash_algo, accel_done, task);
+		break;
 	case SPDK_ACCEL_OPC_COMPARE:
 		random_num = rand() % 100;
 		if (random_num < g_fail_percent_goal) {
@@ -675,15 +719,16 @@ _submit_single(struct worker_thread *worker, struct ap_task *task)
 	case SPDK_ACCEL_OPC_COMPRESS:
 		task->src_iovs = task->cur_seg->uncompressed_iovs;
 		task->src_iovcnt = task->cur_seg->uncompressed_iovcnt;
-		rc = spdk_accel_submit_compress(worker->ch, task->dst, task->cur_seg->compressed_len_padded,
-						task->src_iovs,
-						task->src_iovcnt, &task->compressed_sz, accel_done, task);
+		rc = spdk_accel_submit_compress_ext(worker->ch, task->dst, task->cur_seg->compressed_len_padded,
+						    task->src_iovs, task->src_iovcnt, g_comp_algo, g_comp_level,
+						    &task->compressed_sz, accel_done, task);
 		break;
 	case SPDK_ACCEL_OPC_DECOMPRESS:
 		task->src_iovs = task->cur_seg->compressed_iovs;
 		task->src_iovcnt = task->cur_seg->compressed_iovcnt;
-		rc = spdk_accel_submit_decompress(worker->ch, task->dst_iovs, task->dst_iovcnt, task->src_iovs,
-						  task->src_iovcnt, NULL, accel_done, task);
+		rc = spdk_accel_submit_decompress_ext(worker->ch, task->dst_iovs, task->dst_iovcnt,
+						      task->src_iovs, task->src_iovcnt, g_comp_algo, NULL,
+						      accel_done, task);
 		break;
 	case SPDK_ACCEL_OPC_XOR:
 		rc = spdk_accel_submit_xor(worker->ch, task->dst, task->sources, g_xor_src_count,
@@ -732,7 +777,8 @@ _free_task_buffers(struct ap_task *task)
 		   g_workload_selection == SPDK_ACCEL_OPC_DIF_VERIFY ||
 		   g_workload_selection == SPDK_ACCEL_OPC_DIF_GENERATE ||
 		   g_workload_selection == SPDK_ACCEL_OPC_DIF_GENERATE_COPY ||
-		   g_workload_selection == SPDK_ACCEL_OPC_DIF_VERIFY_COPY) {
+		   g_workload_selection == SPDK_ACCEL_OPC_DIF_VERIFY_COPY ||
+		   g_workload_selection == SPDK_ACCEL_OPC_HASH) {
 		if (task->crc_dst) {
 			spdk_dma_free(task->crc_dst);
 		}
@@ -769,6 +815,34 @@ _free_task_buffers(struct ap_task *task)
 	}
 }
 
+static void
+accel_perf_hash_iovs(struct iovec *iovs, uint32_t iovcnt, uint8_t *digest)
+{
+	struct spdk_xxh64_state xxh;
+	struct spdk_sha256_ctx sha;
+	uint32_t i;
+
+	switch (g_hash_algo) {
+	case SPDK_ACCEL_HASH_ALGO_XXH64:
+		spdk_xxh64_init(&xxh, 0);
+		for (i = 0; i < iovcnt; i++) {
+			spdk_xxh64_update(&xxh, iovs[i].iov_base, iovs[i].iov_len);
+		}
+		to_be64(digest, spdk_xxh64_digest(&xxh));
+		break;
+	case SPDK_ACCEL_HASH_ALGO_SHA256:
+		spdk_sha256_init(&sha);
+		for (i = 0; i < iovcnt; i++) {
+			spdk_sha256_update(&sha, iovs[i].iov_base, iovs[i].iov_len);
+		}
+		spdk_sha256_final(&sha, digest);
+		break;
+	default:
+		assert(0);
+		break;
+	}
+}
+
 static int
 _vector_memcmp(void *_dst, struct iovec *src_src_iovs, uint32_t iovcnt)
 {
@@ -799,6 +873,7 @@ accel_done(void *arg1, int status)
 	struct ap_task *task = arg1;
 	struct worker_thread *worker = task->worker;
 	uint32_t sw_crc32c;
+	uint8_t sw_digest[SPDK_ACCEL_HASH_MAX_DIGEST_LEN];
 	struct spdk_dif_error err_blk;
 
 	assert(worker);
@@ -824,6 +899,13 @@ accel_done(void *arg1, int status)
 				worker->xfer_failed++;
 			}
 			break;
+		case SPDK_ACCEL_OPC_HASH:
+			accel_perf_hash_iovs(task->src_iovs, task->src_iovcnt, sw_digest);
+			if (memcmp(task->dst, sw_digest, spdk_accel_get_hash_digest_len(g_hash_algo))) {
+				SPDK_NOTICELOG("Hash miscompare\n");
+				worker->xfer_failed++;
+			}
+			break;
 		case SPDK_ACCEL_OPC_COPY:
 			if (memcmp(task->src, task->dst, g_xfer_size_bytes)) {
 				SPDK_NOTICELOG("Data miscompare\n");
@@ -965,6 +1047,22 @@ dump_result(void)
 	printf("%-12s %18" PRIu64 "/s %10" PRIu64 " MiB/s %16"PRIu64 " %16" PRIu64 "\n",
 	       "Total", total_xfer_per_sec, total_bw_in_MiBps, total_failed, total_miscompared);
 
+	if (g_workload_selection == SPDK_ACCEL_OPC_COMPRESS ||
+	    g_workload_selection == SPDK_ACCEL_OPC_DECOMPRESS) {
+		struct ap_compress_seg *seg;
+		uint64_t uncompressed = 0, compressed = 0;
+
+		STAILQ_FOREACH(seg, &g_compress_segs, link) {
+			uncompressed += seg->uncompressed_len;
+			compressed += seg->compressed_len;
+		}
+		if (compressed != 0) {
+			printf("Compression ratio (%s, level %d): %.2f\n",
+			       spdk_accel_get_comp_algo_name(g_comp_algo), g_comp_level,
+			       (double)uncompressed / compressed);
+		}
+	}
+
 	return total_failed ? 1 : 0;
 }
 
@@ -1285,8 +1383,9 @@ accel_perf_prep_process_seg(struct accel_perf_prep_ctx *ctx)
 	 * to hold the compressed data.  This example app simply adds 10% buffer for compressed data
 	 * but real applications may want to consider a more sophisticated method.
 	 */
-	rc = spdk_accel_submit_compress(ctx->ch, seg->compressed_data, seg->compressed_len_padded, iov, 1,
-					&seg->compressed_len, accel_perf_prep_process_seg_cpl, ctx);
+	rc = spdk_accel_submit_compress_ext(ctx->ch, seg->compressed_data, seg->compressed_len_padded,
+					    iov, 1, g_comp_algo, g_comp_level, &seg->compressed_len,
+					    accel_perf_prep_process_seg_cpl, ctx);
 	if (rc < 0) {
 		fprintf(stderr, "error (%d) on initial compress submission\n", rc);
 		goto error;
@@ -1306,6 +1405,7 @@ accel_perf_prep(void *arg1)
 {
 	struct accel_perf_prep_ctx *ctx;
 	const char *module_name = NULL;
+	uint32_t min_level, max_level;
 	int rc = 0;
 
 	if (g_module_name) {
@@ -1337,6 +1437,21 @@ accel_perf_prep(void *arg1)
 		goto error_end;
 	}
 
+	rc = spdk_accel_get_compress_level_range(g_comp_algo, &min_level, &max_level);
+	if (rc != 0) {
+		fprintf(stderr, "Compression algorithm %s is not supported\n",
+			spdk_accel_get_comp_algo_name(g_comp_algo));
+		goto error_end;
+	}
+	if (g_comp_level < 0) {
+		g_comp_level = (int)min_level;
+	} else if ((uint32_t)g_comp_level < min_level || (uint32_t)g_comp_level > max_level) {
+		fprintf(stderr, "Compression level %d is out of range [%u, %u] for %s\n", g_comp_level,
+			min_level, max_level, spdk_accel_get_comp_algo_name(g_comp_algo));
+		rc = -EINVAL;
+		goto error_end;
+	}
+
 	printf("Preparing input file...\n");
 
 	ctx = calloc(1, sizeof(*ctx));
@@ -1417,7 +1532,7 @@ main(int argc, char **argv)
 	g_opts.shutdown_cb = shutdown_cb;
 	g_opts.rpc_addr = NULL;
 
-	rc = spdk_app_parse_args(argc, argv, &g_opts, "a:C:o:q:t:yw:M:P:f:T:l:S:x:", NULL,
+	rc = spdk_app_parse_args(argc, argv, &g_opts, "a:C:o:q:t:yw:M:P:f:T:l:S:x:k:K:H:", NULL,
 				 parse_args, usage);
 	if (rc != SPDK_APP_PARSE_ARGS_SUCCESS) {
 		return rc == SPDK_APP_PARSE_ARGS_HELP ? 0 : 1;
@@ -1442,7 +1557,8 @@ main(int argc, char **argv)
 	if ((g_workload_selection == SPDK_ACCEL_OPC_CRC32C ||
 	     g_workload_selection == SPDK_ACCEL_OPC_COPY_CRC32C ||
 	     g_workload_selection == SPDK_ACCEL_OPC_DIF_VERIFY ||
-	     g_workload_selection == SPDK_ACCEL_OPC_DIF_GENERATE) &&
+	     g_workload_selection == SPDK_ACCEL_OPC_DIF_GENERATE ||
+	     g_workload_selection == SPDK_ACCEL_OPC_HASH) &&
 	    g_chained_count == 0) {
 		usage();
 		return -1;
@@ -49,7 +49,9 @@ enum spdk_accel_opcode {
 	SPDK_ACCEL_OPC_DIF_VERIFY_COPY		= 12,
 	SPDK_ACCEL_OPC_DIF_GENERATE		= 13,
 	SPDK_ACCEL_OPC_DIF_GENERATE_COPY	= 14,
-	SPDK_ACCEL_OPC_LAST			= 15,
+	SPDK_ACCEL_OPC_HASH			= 15,
+	SPDK_ACCEL_OPC_PQ_GEN			= 16,
+	SPDK_ACCEL_OPC_LAST			= 17,
 };
 
 enum spdk_accel_cipher {
@@ -57,6 +59,26 @@ enum spdk_accel_cipher {
 	SPDK_ACCEL_CIPHER_AES_XTS,
 };
 
+/** Compression algorithms */
+enum spdk_accel_comp_algo {
+	SPDK_ACCEL_COMP_ALGO_DEFLATE	= 0,
+	SPDK_ACCEL_COMP_ALGO_LZ4	= 1,
+	SPDK_ACCEL_COMP_ALGO_ZSTD	= 2,
+	SPDK_ACCEL_COMP_ALGO_LAST
+};
+
+/** Content hash algorithms */
+enum spdk_accel_hash_algo {
+	/** XXH64 with a seed of 0, stored as a big-endian (canonical) 8-byte digest */
+	SPDK_ACCEL_HASH_ALGO_XXH64	= 0,
+	/** SHA-256, 32-byte digest */
+	SPDK_ACCEL_HASH_ALGO_SHA256	= 1,
+	SPDK_ACCEL_HASH_ALGO_LAST
+};
+
+/** Maximum size of a digest calculated by a hash operation */
+#define SPDK_ACCEL_HASH_MAX_DIGEST_LEN	32
+
 /**
  * Acceleration operation callback.
  *
@@ -303,6 +325,53 @@ int spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_i
 				 size_t src_iovcnt, uint32_t *output_size,
 				 spdk_accel_completion_cb cb_fn, void *cb_arg);
 
+/**
+ * Build and submit a memory compress request using a given algorithm and level.
+ *
+ * \param ch I/O channel associated with this call
+ * \param dst Destination to write the data to.
+ * \param nbytes Length in bytes.
+ * \param src_iovs The io vector array which stores the src data and len.
+ * \param src_iovcnt The size of the src io vectors.
+ * \param comp_algo Compression algorithm.
+ * \param comp_level Compression level, see `spdk_accel_get_compress_level_range()`.
+ * \param output_size The size of the compressed data (may be NULL if not desired)
+ * \param cb_fn Callback function which will be called when the request is complete.
+ * \param cb_arg Opaque value which will be passed back as the arg parameter in
+ * the completion callback.
+ *
+ * \return 0 on success, -EINVAL if the algorithm or the level isn't supported by the module
+ * executing compress operations, other negative errno on failure.
+ */
+int spdk_accel_submit_compress_ext(struct spdk_io_channel *ch, void *dst,
+				   uint64_t nbytes, struct iovec *src_iovs,
+				   size_t src_iovcnt, enum spdk_accel_comp_algo comp_algo,
+				   uint32_t comp_level, uint32_t *output_size,
+				   spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Build and submit a memory decompress request of data compressed with a given algorithm.
+ *
+ * \param ch I/O channel associated with this call
+ * \param dst_iovs The io vector array which stores the dst data and len.
+ * \param dst_iovcnt The size of the dst io vectors.
+ * \param src_iovs The io vector array which stores the src data and len.
+ * \param src_iovcnt The size of the src io vectors.
+ * \param decomp_algo Algorithm used to compress the data.
+ * \param output_size The size of the decompressed data (may be NULL if not desired)
+ * \param cb_fn Callback function which will be called when the request is complete.
+ * \param cb_arg Opaque value which will be passed back as the arg parameter in
+ * the completion callback.
+ *
+ * \return 0 on success, -EINVAL if the algorithm isn't supported by the module executing
+ * decompress operations, other negative errno on failure.
+ */
+int spdk_accel_submit_decompress_ext(struct spdk_io_channel *ch, struct iovec *dst_iovs,
+				     size_t dst_iovcnt, struct iovec *src_iovs,
+				     size_t src_iovcnt, enum spdk_accel_comp_algo decomp_algo,
+				     uint32_t *output_size, spdk_accel_completion_cb cb_fn,
+				     void *cb_arg);
+
 /**
  * Submit an xor request.
  *
@@ -319,6 +388,25 @@ int spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_i
 int spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uint32_t nsrcs,
 			  uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg);
 
+/**
+ * Submit a request generating P (xor) and Q (GF(2^8) Reed-Solomon syndrome) parity, as
+ * calculated by spdk_xor_gen_pq().
+ *
+ * \param ch I/O channel associated with this call.
+ * \param p Destination buffer for the P parity.
+ * \param q Destination buffer for the Q parity.
+ * \param sources Array of source buffers.
+ * \param nsrcs Number of source buffers in the array.
+ * \param nbytes Length in bytes.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_pq_gen(struct spdk_io_channel *ch, void *p, void *q, void **sources,
+			     uint32_t nsrcs, uint64_t nbytes, spdk_accel_completion_cb cb_fn,
+			     void *cb_arg);
+
 /**
  * Build and submit a data encryption request.
  *
@@ -488,6 +576,68 @@ int spdk_accel_submit_dif_generate_copy(struct spdk_io_channel *ch, struct iovec
 					uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
 					spdk_accel_completion_cb cb_fn, void *cb_arg);
 
+/**
+ * Submit a content hash calculation request.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param digest Destination buffer of `spdk_accel_get_hash_digest_len(algo)` bytes to write the
+ *        digest to.
+ * \param src_iovs The io vector array which stores the src data and len.
+ * \param src_iovcnt The size of the src iovs.
+ * \param algo Hash algorithm.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_hash(struct spdk_io_channel *ch, uint8_t *digest, struct iovec *src_iovs,
+			   size_t src_iovcnt, enum spdk_accel_hash_algo algo,
+			   spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/** Object grouping multiple independent operations to be submitted to the modules at once */
+struct spdk_accel_batch;
+
+/**
+ * Open a batch on a given I/O channel.  While a batch is open, operations submitted on that
+ * channel via `spdk_accel_submit_*()` aren't executed right away, but are collected in the batch
+ * instead.  They're handed to the modules together once `spdk_accel_batch_submit()` is called,
+ * which allows modules that support it (e.g. DSA) to execute them as a single hardware batch.
+ * Only one batch can be open on a channel at a time.  Operations appended to sequences are not
+ * affected by an open batch.
+ *
+ * The operations in a batch are independent, so their completion callbacks (which can be NULL)
+ * may be executed in any order.
+ *
+ * \param ch I/O channel.
+ *
+ * \return Batch object or NULL if a batch is already open on the channel or if there are no free
+ *         batch objects left.
+ */
+struct spdk_accel_batch *spdk_accel_batch_create(struct spdk_io_channel *ch);
+
+/**
+ * Close a batch and submit all of its operations.  The completion callback of each operation is
+ * executed once that operation is done, followed by `cb_fn`, which is executed once all
+ * operations in the batch are completed.  After that, the batch object is freed.
+ *
+ * \param batch Batch to submit.
+ * \param cb_fn Callback to be executed once all operations are completed.  Can be NULL.  Its
+ *        status is 0 if all operations succeeded, or the status of the first failed operation.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 on success, -EINVAL if the batch is empty (in which case it's left open).
+ */
+int spdk_accel_batch_submit(struct spdk_accel_batch *batch, spdk_accel_completion_cb cb_fn,
+			    void *cb_arg);
+
+/**
+ * Abort a batch.  This will execute the completion callbacks of all operations that were added
+ * to the batch with -ECANCELED status and will then free the batch object.
+ *
+ * \param batch Batch to abort.
+ */
+void spdk_accel_batch_abort(struct spdk_accel_batch *batch);
+
 /** Object grouping multiple accel operations to be executed at the same point in time */
 struct spdk_accel_sequence;
 
@@ -663,6 +813,28 @@ int spdk_accel_append_crc32c(struct spdk_accel_sequence **seq, struct spdk_io_ch
 			     struct spdk_memory_domain *domain, void *domain_ctx,
 			     uint32_t seed, spdk_accel_step_cb cb_fn, void *cb_arg);
 
+/**
+ * Append a content hash operation to a sequence.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param digest Destination buffer of `spdk_accel_get_hash_digest_len(algo)` bytes to write the
+ *        digest to.
+ * \param iovs Source I/O vector array.
+ * \param iovcnt Size of the `iovs` array.
+ * \param domain Memory domain to which the source buffers belong.
+ * \param domain_ctx Source buffer domain context.
+ * \param algo Hash algorithm.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_hash(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			   uint8_t *digest, struct iovec *iovs, uint32_t iovcnt,
+			   struct spdk_memory_domain *domain, void *domain_ctx,
+			   enum spdk_accel_hash_algo algo, spdk_accel_step_cb cb_fn, void *cb_arg);
+
 /**
  * Finish a sequence and execute all its operations. After the completion callback is executed, the
  * sequence object is automatically freed.
@@ -789,6 +961,8 @@ struct spdk_accel_opts {
 	uint32_t	sequence_count;
 	/** Maximum number of accel buffers per IO channel */
 	uint32_t	buf_count;
+	/** Maximum number of batches per IO channel */
+	uint32_t	batch_count;
 
 } __attribute__((packed));
 
@@ -878,6 +1052,66 @@ int spdk_accel_get_opc_memory_domains(enum spdk_accel_opcode opcode,
  */
 const char *spdk_accel_get_opcode_name(enum spdk_accel_opcode opcode);
 
+/**
+ * Return the name of a compression algorithm.
+ *
+ * \param algo Compression algorithm.
+ *
+ * \return Name of the algorithm or NULL if the algorithm is invalid.
+ */
+const char *spdk_accel_get_comp_algo_name(enum spdk_accel_comp_algo algo);
+
+/**
+ * Find a compression algorithm by its name.
+ *
+ * \param name Name of the algorithm, as returned by `spdk_accel_get_comp_algo_name()`.
+ * \param algo Pointer to update with the algorithm.
+ *
+ * \return 0 on success, -EINVAL if the name doesn't match any algorithm.
+ */
+int spdk_accel_get_comp_algo_by_name(const char *name, enum spdk_accel_comp_algo *algo);
+
+/**
+ * Get the range of compression levels supported for a given algorithm by the module assigned to
+ * execute compress operations.  Higher levels trade speed for a better compression ratio.
+ *
+ * \param algo Compression algorithm.
+ * \param min_level Pointer to update with the minimum level.
+ * \param max_level Pointer to update with the maximum level.
+ *
+ * \return 0 on success, -EINVAL if the algorithm isn't supported.
+ */
+int spdk_accel_get_compress_level_range(enum spdk_accel_comp_algo algo, uint32_t *min_level,
+					uint32_t *max_level);
+
+/**
+ * Return the name of a hash algorithm.
+ *
+ * \param algo Hash algorithm.
+ *
+ * \return Name of the algorithm or NULL if the algorithm is invalid.
+ */
+const char *spdk_accel_get_hash_algo_name(enum spdk_accel_hash_algo algo);
+
+/**
+ * Find a hash algorithm by its name.
+ *
+ * \param name Name of the algorithm, as returned by `spdk_accel_get_hash_algo_name()`.
+ * \param algo Pointer to update with the algorithm.
+ *
+ * \return 0 on success, -EINVAL if the name doesn't match any algorithm.
+ */
+int spdk_accel_get_hash_algo_by_name(const char *name, enum spdk_accel_hash_algo *algo);
+
+/**
+ * Return the size of the digest calculated by a hash algorithm.
+ *
+ * \param algo Hash algorithm.
+ *
+ * \return Digest size in bytes or 0 if the algorithm is invalid.
+ */
+uint32_t spdk_accel_get_hash_digest_len(enum spdk_accel_hash_algo algo);
+
 #ifdef __cplusplus
 }
 #endif
@@ -95,9 +95,12 @@ struct spdk_accel_task {
 	uint8_t				op_code;
 	bool				has_aux;
 	int16_t				status;
-	uint8_t				reserved[4];
+	/* Used by the accel framework to track the module executing the task */
+	uint8_t				route;
+	uint8_t				reserved[3];
 	struct accel_io_channel		*accel_ch;
 	struct spdk_accel_sequence	*seq;
+	struct spdk_accel_batch		*batch;
 	union {
 		/* Used by spdk_accel_submit_* functions */
 		spdk_accel_completion_cb	cb_fn;
@@ -146,11 +149,25 @@ struct spdk_accel_task {
 	};
 	union {
 		uint32_t		*crc_dst;
+		uint8_t			*digest; /* for hash op */
 		uint32_t		*output_size;
 		uint32_t		block_size; /* for crypto op */
 	};
-	uint64_t			iv; /* Initialization vector (tweak) for crypto op */
+	union {
+		uint64_t		iv; /* Initialization vector (tweak) for crypto op */
+		struct {
+			/* Uses enum spdk_accel_comp_algo */
+			uint32_t	algo;
+			uint32_t	level;
+		} comp;
+		struct {
+			/* Uses enum spdk_accel_hash_algo */
+			uint32_t	algo;
+		} hash;
+	};
 	struct spdk_accel_task_aux_data	*aux;
+	/* Used by the accel framework to measure the latency of the task */
+	uint64_t			submit_tsc;
 };
 
 struct spdk_accel_opcode_info {
@@ -212,6 +229,14 @@ struct spdk_accel_module_if {
 	 */
 	int (*submit_tasks)(struct spdk_io_channel *ch, struct spdk_accel_task *accel_task);
 
+	/**
+	 * Set if `submit_tasks()` accepts a list of tasks linked via the `link` field.  Such
+	 * modules are expected to execute all of the tasks on the list and must not fail the
+	 * submission of the whole list, i.e. if a task cannot be executed, it needs to be
+	 * completed with an error via `spdk_accel_task_complete()`.
+	 */
+	bool submit_task_lists;
+
 	/**
 	 * Create crypto key function. Module is responsible to fill all necessary parameters in
 	 * \b spdk_accel_crypto_key structure
@@ -231,6 +256,25 @@ struct spdk_accel_module_if {
 	 */
 	bool (*crypto_supports_cipher)(enum spdk_accel_cipher cipher, size_t key_size);
 
+	/**
+	 * Returns true if given compression algorithm is supported.  If module doesn't implement
+	 * that function it shall only support DEFLATE.
+	 */
+	bool (*compress_supports_algo)(enum spdk_accel_comp_algo algo);
+
+	/**
+	 * Returns the range of levels supported for a given compression algorithm.  If module
+	 * doesn't implement that function, only level 0 is allowed.
+	 */
+	int (*get_compress_level_range)(enum spdk_accel_comp_algo algo, uint32_t *min_level,
+					uint32_t *max_level);
+
+	/**
+	 * Returns true if given hash algorithm is supported.  Modules supporting
+	 * `SPDK_ACCEL_OPC_HASH` are required to define this function.
+	 */
+	bool (*hash_supports_algo)(enum spdk_accel_hash_algo algo);
+
 	/**
 	 * Returns memory domains supported by the module.  If NULL, the module does not support
 	 * memory domains.  The `domains` array can be NULL, in which case this function only
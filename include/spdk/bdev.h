@@ -1984,6 +1984,20 @@ int spdk_bdev_queue_io_wait(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
 void spdk_bdev_get_io_stat(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
 			   struct spdk_bdev_io_stat *stat);
 
+struct spdk_obj_cache_stats;
+
+/**
+ * Return the statistics of the bdev_io cache used by this channel.  The cache is shared by all
+ * bdev channels on the thread of the channel.
+ *
+ * \param ch I/O channel. Obtained by calling spdk_bdev_get_io_channel().
+ * \param stats The cache statistics.
+ *
+ * \return the number of bdev_ios currently in the cache.
+ */
+uint32_t spdk_bdev_get_io_cache_stats(struct spdk_io_channel *ch,
+				      struct spdk_obj_cache_stats *stats);
+
 
 /**
  * Return I/O statistics for this bdev. All the required information will be passed
@@ -460,6 +460,15 @@ struct spdk_bdev {
 	 */
 	bool split_on_write_unit;
 
+	/**
+	 * Specifies whether WRITE I/O smaller than write_unit_size are
+	 * allowed. Only meaningful if split_on_write_unit is set to true.
+	 * If set, the bdev layer still splits WRITE I/O on write_unit_size
+	 * boundaries, but submits the resulting partial write units to the
+	 * bdev module instead of failing them.
+	 */
+	bool allow_partial_write_unit;
+
 	/** Number of blocks required for write */
 	uint32_t write_unit_size;
 
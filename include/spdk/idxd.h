@@ -416,6 +416,18 @@ int spdk_idxd_submit_raw_desc(struct spdk_idxd_io_channel *chan,
  */
 int spdk_idxd_process_events(struct spdk_idxd_io_channel *chan);
 
+/**
+ * Submit the descriptors prepared on an IDXD channel to the hardware.  Descriptors of the
+ * operations submitted on a channel are accumulated in a batch descriptor, which is normally
+ * submitted once it's big enough or when `spdk_idxd_process_events()` is called.  This function
+ * can be used to submit it right away, e.g. after preparing a group of related operations.
+ *
+ * \param chan IDXD channel to flush.
+ * \return 0 on success, -EBUSY if the batch couldn't be submitted.  In that case, it will be
+ *         submitted by the next call to `spdk_idxd_process_events()`.
+ */
+int spdk_idxd_flush(struct spdk_idxd_io_channel *chan);
+
 /**
  * Returns an IDXD channel for a given IDXD device.
  *
@@ -58,6 +58,20 @@ struct spdk_reduce_vol_params {
 	 *  of the chunk size.
 	 */
 	uint64_t		vol_size;
+
+	/**
+	 * Compression algorithm used for the chunks of the volume.  libreduce only
+	 *  records it, the value is interpreted by the user of the library (e.g. as an
+	 *  enum spdk_accel_comp_algo).  Volumes created before this field was added
+	 *  report 0.
+	 */
+	uint32_t		comp_algo;
+
+	/**
+	 * Compression level used for the chunks of the volume.  Like comp_algo, it
+	 *  is only recorded by libreduce.
+	 */
+	uint32_t		comp_level;
 };
 
 struct spdk_reduce_vol;
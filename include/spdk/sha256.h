@@ -0,0 +1,74 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/**
+ * \file
+ * SHA-256 utility functions
+ */
+
+#ifndef SPDK_SHA256_H
+#define SPDK_SHA256_H
+
+#include "spdk/stdinc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size of a SHA-256 digest in bytes */
+#define SPDK_SHA256_DIGEST_LEN	32
+
+/** SHA-256 block size in bytes */
+#define SPDK_SHA256_BLOCK_LEN	64
+
+/**
+ * SHA-256 calculation context.  Its contents are private and should only be modified through the
+ * `spdk_sha256_*()` functions.
+ */
+struct spdk_sha256_ctx {
+	uint32_t	state[8];
+	uint64_t	length;
+	uint32_t	buflen;
+	uint8_t		buf[SPDK_SHA256_BLOCK_LEN];
+};
+
+/**
+ * Initialize a SHA-256 context.
+ *
+ * \param ctx Context to initialize.
+ */
+void spdk_sha256_init(struct spdk_sha256_ctx *ctx);
+
+/**
+ * Update a SHA-256 context with a data buffer.
+ *
+ * \param ctx SHA-256 context.
+ * \param buf Data buffer.
+ * \param len Length of buf in bytes.
+ */
+void spdk_sha256_update(struct spdk_sha256_ctx *ctx, const void *buf, size_t len);
+
+/**
+ * Finish a SHA-256 calculation.  The context needs to be reinitialized before being reused.
+ *
+ * \param ctx SHA-256 context.
+ * \param digest Buffer of `SPDK_SHA256_DIGEST_LEN` bytes to store the digest.
+ */
+void spdk_sha256_final(struct spdk_sha256_ctx *ctx, uint8_t *digest);
+
+/**
+ * Calculate the SHA-256 digest of a data buffer.
+ *
+ * \param buf Data buffer.
+ * \param len Length of buf in bytes.
+ * \param digest Buffer of `SPDK_SHA256_DIGEST_LEN` bytes to store the digest.
+ */
+void spdk_sha256(const void *buf, size_t len, uint8_t *digest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPDK_SHA256_H */
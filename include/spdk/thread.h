@@ -1012,6 +1012,131 @@ void spdk_spin_unlock(struct spdk_spinlock *sspin);
  */
 bool spdk_spin_held(struct spdk_spinlock *sspin);
 
+/** Maximum number of objects moved between an object cache and its pool at once */
+#define SPDK_OBJ_CACHE_MAX_BATCH 64
+
+struct spdk_obj_cache_opts {
+	/**
+	 * The size of spdk_obj_cache_opts according to the caller of this library is used for ABI
+	 * compatibility.  The library uses this field to know how many fields in this structure
+	 * are valid. And the library will populate any remaining fields with default values.
+	 */
+	size_t opts_size;
+	/** Maximum number of objects kept in the cache */
+	uint32_t high_watermark;
+	/**
+	 * Number of objects left in the cache after it exceeds `high_watermark` and its excess is
+	 * returned to the pool.  Must not be greater than `high_watermark`.
+	 */
+	uint32_t low_watermark;
+	/**
+	 * Number of objects fetched from the pool at once when the cache runs empty.  Must be in the
+	 * range of 1 to SPDK_OBJ_CACHE_MAX_BATCH.
+	 */
+	uint32_t batch_size;
+} __attribute__((packed));
+SPDK_STATIC_ASSERT(sizeof(struct spdk_obj_cache_opts) == 20, "Incorrect size");
+
+/** Object cache statistics */
+struct spdk_obj_cache_stats {
+	/** Number of objects taken from the cache */
+	uint64_t gets;
+	/** Number of objects put back into the cache */
+	uint64_t puts;
+	/** Number of times the cache was refilled from the pool */
+	uint64_t refills;
+	/** Number of times the excess of the cache was returned to the pool */
+	uint64_t returns;
+	/** Number of gets that failed, because both the cache and the pool were empty */
+	uint64_t starved;
+};
+
+/**
+ * Object cache.  Keeps objects allocated from an spdk_mempool in a list local to a single thread
+ * to avoid the cost of accessing the shared pool on each allocation.  Objects are moved between
+ * the cache and the pool in batches.  The cache is not thread safe, it must only be used by a
+ * single thread at a time.  While an object is in the cache, its first sizeof(void *) bytes are
+ * used to link it with other cached objects, so its contents aren't preserved.
+ */
+struct spdk_obj_cache {
+	/** Pool the objects are allocated from */
+	struct spdk_mempool		*pool;
+	/** First cached object */
+	void				*head;
+	/** Number of cached objects */
+	uint32_t			count;
+	uint32_t			high_watermark;
+	uint32_t			low_watermark;
+	uint32_t			batch_size;
+	/** Cache usage statistics */
+	struct spdk_obj_cache_stats	stats;
+};
+
+/**
+ * Initialize an object cache.  The cache is initially empty.
+ *
+ * \param cache Object cache to initialize.
+ * \param pool Pool the objects are allocated from.  Its elements must be at least
+ * sizeof(void *) bytes long.
+ * \param opts Cache options.
+ *
+ * \return 0 on success, negative errno otherwise.
+ */
+int spdk_obj_cache_init(struct spdk_obj_cache *cache, struct spdk_mempool *pool,
+			const struct spdk_obj_cache_opts *opts);
+
+/**
+ * Return all cached objects to the pool.
+ *
+ * \param cache Object cache.
+ */
+void spdk_obj_cache_fini(struct spdk_obj_cache *cache);
+
+/**
+ * Move objects from the pool to the cache, e.g. to reserve objects for a thread that must not be
+ * starved.  Either all of the requested objects are moved, or none.
+ *
+ * \param cache Object cache.
+ * \param count Number of objects to move.
+ *
+ * \return 0 on success, -ENOMEM if the pool doesn't contain enough objects.
+ */
+int spdk_obj_cache_fill(struct spdk_obj_cache *cache, uint32_t count);
+
+/**
+ * Get an object from the cache.  If the cache is empty, it's refilled from the pool first.
+ *
+ * \param cache Object cache.
+ *
+ * \return pointer to the object or NULL if both the cache and the pool are empty.
+ */
+void *spdk_obj_cache_get(struct spdk_obj_cache *cache);
+
+/**
+ * Put an object into the cache.  If that makes the cache exceed its high watermark, objects are
+ * returned to the pool until the low watermark is reached.
+ *
+ * \param cache Object cache.
+ * \param obj Object to put.  It must have been allocated from the cache's pool.
+ */
+void spdk_obj_cache_put(struct spdk_obj_cache *cache, void *obj);
+
+/**
+ * Get the number of objects in the cache.
+ *
+ * \param cache Object cache.
+ *
+ * \return number of cached objects.
+ */
+static inline uint32_t
+spdk_obj_cache_count(const struct spdk_obj_cache *cache)
+{
+	return cache->count;
+}
+
+/** Maximum number of intermediate (medium) iobuf size classes */
+#define SPDK_IOBUF_MAX_MEDIUM_CLASSES 4
+
 struct spdk_iobuf_opts {
 	/** Maximum number of small buffers */
 	uint64_t small_pool_count;
@@ -1030,6 +1155,24 @@ struct spdk_iobuf_opts {
 	 */
 	size_t opts_size;
 
+	/**
+	 * Maximum number of buffers of each medium size class.  Only the entries corresponding to
+	 * a non-zero `medium_bufsize` are used.
+	 */
+	uint64_t medium_pool_count[SPDK_IOBUF_MAX_MEDIUM_CLASSES];
+	/**
+	 * Sizes of the medium size classes placed between `small_bufsize` and `large_bufsize`.
+	 * The sizes must be in ascending order after being rounded up to 4KiB.  The first zero
+	 * entry terminates the list, so leaving the whole array zeroed results in only two (small
+	 * and large) size classes.
+	 */
+	uint32_t medium_bufsize[SPDK_IOBUF_MAX_MEDIUM_CLASSES];
+	/**
+	 * Number of buffers of each medium size class cached by every iobuf channel.  Channels
+	 * created with both the small and large cache sizes passed to `spdk_iobuf_channel_init()`
+	 * set to zero don't cache any medium buffers.
+	 */
+	uint32_t medium_cache_size[SPDK_IOBUF_MAX_MEDIUM_CLASSES];
 };
 
 struct spdk_iobuf_pool_stats {
@@ -1045,6 +1188,9 @@ struct spdk_iobuf_module_stats {
 	struct spdk_iobuf_pool_stats	small_pool;
 	struct spdk_iobuf_pool_stats	large_pool;
 	const char			*module;
+	/** Number of valid entries in `medium_pool` */
+	uint32_t			num_medium_pools;
+	struct spdk_iobuf_pool_stats	medium_pool[SPDK_IOBUF_MAX_MEDIUM_CLASSES];
 };
 
 struct spdk_iobuf_entry;
@@ -1092,6 +1238,10 @@ struct spdk_iobuf_channel {
 	const void			*module;
 	/** Parent IO channel */
 	struct spdk_io_channel		*parent;
+	/** Number of medium size classes in use */
+	uint32_t			num_medium;
+	/** Medium buffer memory pools, sorted by ascending buffer size */
+	struct spdk_iobuf_pool		medium[SPDK_IOBUF_MAX_MEDIUM_CLASSES];
 };
 
 /**
@@ -1153,7 +1303,9 @@ int spdk_iobuf_unregister_module(const char *name);
  * \param ch iobuf channel to initialize.
  * \param name Name of the module registered via `spdk_iobuf_register_module()`.
  * \param small_cache_size Number of small buffers to be cached by this channel.
- * \param large_cache_size Number of large buffers to be cached by this channel.
+ * \param large_cache_size Number of large buffers to be cached by this channel.  The cache sizes
+ * of the medium size classes are set by `spdk_iobuf_opts.medium_cache_size`, unless both
+ * `small_cache_size` and `large_cache_size` are zero, in which case no medium buffers are cached.
  *
  * \return 0 on success, negative errno otherwise.
  */
@@ -1175,7 +1327,7 @@ typedef int (*spdk_iobuf_for_each_entry_fn)(struct spdk_iobuf_channel *ch,
  * using `ch`.  The iteration is stopped if the callback returns non-zero status.
  *
  * \param ch iobuf channel to iterate over.
- * \param pool Pool to iterate over (`small` or `large`).
+ * \param pool Pool to iterate over (`small`, `large` or one of `medium`).
  * \param cb_fn Callback to execute on each entry on the queue that was requested using `ch`.
  * \param cb_ctx Argument passed to `cb_fn`.
  *
@@ -1196,8 +1348,9 @@ void spdk_iobuf_entry_abort(struct spdk_iobuf_channel *ch, struct spdk_iobuf_ent
 			    uint64_t len);
 
 /**
- * Get a buffer from the iobuf pool. If no buffers are available and entry with cb_fn provided
- * then the request is queued until a buffer becomes available.
+ * Get a buffer from the iobuf pool. The buffer is taken from the smallest size class that fits
+ * `len`. If no buffers are available and entry with cb_fn provided then the request is queued
+ * until a buffer becomes available.
  *
  * \param ch iobuf channel.
  * \param len Length of the buffer to retrieve. The user is responsible for making sure the length
@@ -223,6 +223,44 @@ size_t spdk_iovcpy(struct iovec *siov, size_t siovcnt, struct iovec *diov, size_
  */
 size_t spdk_iovmove(struct iovec *siov, size_t siovcnt, struct iovec *diov, size_t diovcnt);
 
+/** Default size of the copies from which spdk_iovcpy_nt() uses non-temporal stores */
+#define SPDK_IOV_NT_THRESHOLD_DEFAULT (256 * 1024)
+
+/**
+ * Copy memory using non-temporal (streaming) stores, which write the data to memory without
+ * allocating it in the CPU caches.  This avoids evicting other data from the last level cache
+ * when copying buffers that won't be accessed by the CPU soon, e.g. bounce buffers that are
+ * about to be transferred by a device.  Falls back to memcpy() on platforms without such stores.
+ *
+ * \param dst Destination buffer.
+ * \param src Source buffer.  Must not overlap with `dst`.
+ * \param len Number of bytes to copy.
+ */
+void spdk_memcpy_nt(void *dst, const void *src, size_t len);
+
+/**
+ * Same as spdk_iovcpy(), but the data is copied using non-temporal stores (see spdk_memcpy_nt())
+ * if the size of the source is at least the threshold set by spdk_iov_set_nt_threshold().
+ * The start of each source iovec is prefetched before its predecessor is copied.
+ *
+ * \return The number of bytes copied.
+ */
+size_t spdk_iovcpy_nt(struct iovec *siov, size_t siovcnt, struct iovec *diov, size_t diovcnt);
+
+/**
+ * Set the size of the copies from which spdk_iovcpy_nt() uses non-temporal stores.
+ *
+ * \param threshold Size in bytes, 0 to always use regular stores.
+ */
+void spdk_iov_set_nt_threshold(size_t threshold);
+
+/**
+ * Get the size of the copies from which spdk_iovcpy_nt() uses non-temporal stores.
+ *
+ * \return Size in bytes, 0 if non-temporal stores are disabled.
+ */
+size_t spdk_iov_get_nt_threshold(void);
+
 /**
  * Transfer state for iterative copying in or out of an iovec.
  */
@@ -28,6 +28,38 @@ extern "C" {
  */
 int spdk_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len);
 
+/**
+ * Generate P (XOR) and Q (Reed-Solomon syndrome) parity from multiple source buffers, as used by
+ * RAID 6.  Q is calculated in GF(2^8) with the polynomial 0x11d and the generator 2, i.e.
+ * Q = D[0] + 2 * D[1] + 2^2 * D[2] + ... + 2^(n-1) * D[n-1].
+ *
+ * \param p Destination buffer for the P parity.
+ * \param q Destination buffer for the Q parity.
+ * \param sources Array of source buffers.
+ * \param n Number of source buffers in the array, at most 255.
+ * \param len Length of each buffer in bytes.
+ * \return 0 on success, negative error code otherwise.
+ */
+int spdk_xor_gen_pq(void *p, void *q, void **sources, uint32_t n, uint32_t len);
+
+/**
+ * Reconstruct one or two missing source buffers from the remaining ones and the P and Q parity
+ * generated by spdk_xor_gen_pq().  A single missing buffer is recovered using P if it's
+ * available, and using Q otherwise.  Two missing buffers require both P and Q.  Only the missing
+ * buffers are written, P and Q aren't updated.
+ *
+ * \param p P parity buffer, may be NULL if P is unavailable.
+ * \param q Q parity buffer, may be NULL if Q is unavailable.
+ * \param sources Array of source buffers, including the missing ones to be reconstructed.
+ * \param n Number of source buffers in the array, at most 255.
+ * \param missing Array of indexes of the missing buffers in the sources array.
+ * \param nmissing Number of missing buffers, 1 or 2.
+ * \param len Length of each buffer in bytes.
+ * \return 0 on success, negative error code otherwise.
+ */
+int spdk_xor_rec_pq(void *p, void *q, void **sources, uint32_t n, const uint32_t *missing,
+		    uint32_t nmissing, uint32_t len);
+
 /**
  * Get the optimal buffer alignment for XOR functions.
  *
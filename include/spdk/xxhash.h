@@ -0,0 +1,72 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/**
+ * \file
+ * xxHash utility functions
+ */
+
+#ifndef SPDK_XXHASH_H
+#define SPDK_XXHASH_H
+
+#include "spdk/stdinc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * XXH64 calculation state.  Its contents are private and should only be modified through the
+ * `spdk_xxh64_*()` functions.
+ */
+struct spdk_xxh64_state {
+	uint64_t	acc[4];
+	uint64_t	seed;
+	uint64_t	length;
+	uint32_t	buflen;
+	uint8_t		buf[32];
+};
+
+/**
+ * Initialize an XXH64 state.
+ *
+ * \param state State to initialize.
+ * \param seed Seed value.
+ */
+void spdk_xxh64_init(struct spdk_xxh64_state *state, uint64_t seed);
+
+/**
+ * Update an XXH64 state with a data buffer.
+ *
+ * \param state XXH64 state.
+ * \param buf Data buffer.
+ * \param len Length of buf in bytes.
+ */
+void spdk_xxh64_update(struct spdk_xxh64_state *state, const void *buf, size_t len);
+
+/**
+ * Calculate the hash of the data the state was updated with so far.  The state isn't modified and
+ * can be updated further.
+ *
+ * \param state XXH64 state.
+ * \return XXH64 hash value.
+ */
+uint64_t spdk_xxh64_digest(const struct spdk_xxh64_state *state);
+
+/**
+ * Calculate the XXH64 hash of a data buffer.
+ *
+ * \param buf Data buffer.
+ * \param len Length of buf in bytes.
+ * \param seed Seed value.
+ * \return XXH64 hash value.
+ */
+uint64_t spdk_xxh64(const void *buf, size_t len, uint64_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPDK_XXHASH_H */
@@ -16,6 +16,7 @@ extern "C" {
 #include "spdk/json.h"
 #include "spdk/thread.h"
 #include "spdk/util.h"
+#include "spdk_internal/thread.h"
 
 struct spdk_event {
 	uint32_t		lcore;
@@ -50,6 +51,51 @@ struct spdk_lw_thread {
  */
 typedef void (*spdk_reactor_set_interrupt_mode_cb)(void *cb_arg);
 
+/**
+ * Completion callback to set the hybrid polling options of the reactors.
+ *
+ * \param cb_arg Argument to pass to the callback function.
+ */
+typedef void (*spdk_reactors_set_hybrid_opts_cb)(void *cb_arg);
+
+#define SPDK_REACTOR_STALL_NAME_LEN	64
+#define SPDK_REACTOR_STALL_MAX_FRAMES	32
+#define SPDK_REACTOR_STALL_HISTORY	16
+
+/**
+ * A reactor iteration that ran longer than the watchdog budget.  Captured on the stalled
+ * reactor while the stall is in progress.
+ */
+struct spdk_reactor_stall {
+	/* Start of the stalled iteration, in ticks */
+	uint64_t	tsc;
+	/* Duration of the whole iteration, in ticks; filled in once the iteration ends */
+	uint64_t	duration_tsc;
+	char		thread_name[SPDK_REACTOR_STALL_NAME_LEN];
+	/* Name of the poller that was running, empty if it was a message or an event */
+	char		poller_name[SPDK_REACTOR_STALL_NAME_LEN];
+	/* The poller, message or event function that was running and its resolved name */
+	void		*fn;
+	char		fn_name[SPDK_REACTOR_STALL_NAME_LEN];
+	void		*frames[SPDK_REACTOR_STALL_MAX_FRAMES];
+	int		num_frames;
+};
+
+/**
+ * Hybrid polling options.  When enabled, a reactor in poll mode that finds no work for
+ * `idle_iterations` consecutive iterations starts sleeping between iterations.  The first sleep
+ * lasts `min_sleep_us` and every following sleep that is not interrupted by work doubles in length
+ * up to `max_sleep_us`.  A single iteration that finds work puts the reactor back into busy
+ * polling.  Sleeps never extend past the expiration of the nearest timed poller and end as soon
+ * as a message or an event is sent to the reactor.
+ */
+struct spdk_reactor_hybrid_opts {
+	bool		enabled;
+	uint32_t	idle_iterations;
+	uint32_t	min_sleep_us;
+	uint32_t	max_sleep_us;
+};
+
 struct spdk_reactor {
 	/* Lightweight threads running on this reactor */
 	TAILQ_HEAD(, spdk_lw_thread)			threads;
@@ -86,6 +132,39 @@ struct spdk_reactor {
 
 	struct spdk_fd_group				*fgrp;
 	int						resched_fd;
+
+	/* Hybrid polling: options of this reactor, only changed by an event on the reactor */
+	struct spdk_reactor_hybrid_opts			hybrid_opts;
+	/* Hybrid polling: number of consecutive iterations that found no work */
+	uint32_t					idle_iterations;
+	/* Hybrid polling: length of the next sleep in microseconds */
+	uint32_t					sleep_us;
+	/* Hybrid polling: REACTOR_HYBRID_SLEEPING while sleeping, replaced with the tick count
+	 * by the first sender of a message or an event that wakes the reactor up */
+	uint64_t					hybrid_sleep;
+	struct spdk_thread_wakeup			hybrid_wakeup;
+	/* Hybrid polling: time spent sleeping (subset of idle_tsc) */
+	uint64_t					sleep_tsc;
+	uint64_t					sleep_count;
+	/* Hybrid polling: number of sleeps cut short by a message or an event and the time
+	 * between sending it and the reactor running again */
+	uint64_t					wakeup_count;
+	uint64_t					wakeup_latency_tsc;
+	uint64_t					max_wakeup_latency_tsc;
+
+	/* Watchdog: start of the current iteration, 0 while waiting for work in interrupt mode */
+	volatile uint64_t				watchdog_tsc;
+	/* Watchdog: iteration start of the last stall signalled by the monitor thread */
+	uint64_t					watchdog_signalled_tsc;
+	pthread_t					pthread;
+	/* The event function being executed, for the watchdog */
+	spdk_event_fn					running_event_fn;
+	/* Set by the watchdog signal handler once it has filled stall_capture */
+	volatile bool					stall_captured;
+	struct spdk_reactor_stall			stall_capture;
+	/* The most recent stalls, reported once the stalled iteration completed */
+	struct spdk_reactor_stall			stalls[SPDK_REACTOR_STALL_HISTORY];
+	uint64_t					stall_count;
 } __attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
 
 int spdk_reactors_init(size_t msg_mempool_size);
@@ -128,6 +207,52 @@ void spdk_for_each_reactor(spdk_event_fn fn, void *arg1, void *arg2, spdk_event_
 int spdk_reactor_set_interrupt_mode(uint32_t lcore, bool new_in_interrupt,
 				    spdk_reactor_set_interrupt_mode_cb cb_fn, void *cb_arg);
 
+/**
+ * Set the hybrid polling options of all reactors.
+ *
+ * The options are passed to each reactor with an event.  This function is only permitted
+ * within the scheduling reactor, which runs the spdk application thread.
+ *
+ * \param opts Hybrid polling options.
+ * \param cb_fn This will be called on spdk application thread once all reactors use the
+ * new options.
+ * \param cb_arg Argument will be passed to cb_fn when called.
+ *
+ * \return 0 on success, negative errno on failure: -EINVAL if the options are invalid,
+ * -EBUSY if a previous call hasn't completed yet.
+ */
+int spdk_reactors_set_hybrid_opts(const struct spdk_reactor_hybrid_opts *opts,
+				  spdk_reactors_set_hybrid_opts_cb cb_fn, void *cb_arg);
+
+/**
+ * Get the hybrid polling options of all reactors.
+ *
+ * \param opts Output parameter for the options.
+ */
+void spdk_reactors_get_hybrid_opts(struct spdk_reactor_hybrid_opts *opts);
+
+/**
+ * Set the reactor stall watchdog budget.
+ *
+ * A monitor thread checks the reactors periodically.  When a reactor spends more than
+ * `budget_us` in a single iteration, its stack is captured and, once the iteration
+ * completes, the stall is logged, recorded in the trace buffer and kept in the reactor's
+ * stall history.
+ *
+ * \param budget_us Maximum duration of a reactor iteration in microseconds, 0 disables
+ * the watchdog.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_reactors_set_watchdog_budget(uint64_t budget_us);
+
+/**
+ * Get the reactor stall watchdog budget.
+ *
+ * \return the budget in microseconds, 0 if the watchdog is disabled.
+ */
+uint64_t spdk_reactors_get_watchdog_budget(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,9 +11,21 @@
 
 struct spdk_poller;
 
+/*
+ * Number of buckets in the poller execution time histogram.  Bucket N counts
+ * the executions that took [2^N, 2^(N+1)) ticks, bucket 0 also counts the ones
+ * that took 0 ticks and the last bucket counts everything that took longer.
+ */
+#define SPDK_POLLER_RUN_TSC_HISTOGRAM_BUCKETS	32
+
 struct spdk_poller_stats {
 	uint64_t	run_count;
 	uint64_t	busy_count;
+	/* Total number of ticks spent executing the poller. */
+	uint64_t	run_tsc;
+	/* The longest single execution of the poller, in ticks. */
+	uint64_t	max_run_tsc;
+	uint64_t	run_tsc_histogram[SPDK_POLLER_RUN_TSC_HISTOGRAM_BUCKETS];
 };
 
 struct io_device;
@@ -30,6 +42,58 @@ int spdk_io_channel_get_ref_count(struct spdk_io_channel *ch);
 
 const char *spdk_io_device_get_name(struct io_device *dev);
 
+/**
+ * Get the poller or the message function the thread is currently executing.
+ *
+ * Meant for diagnostics, e.g. from a signal handler interrupting the thread.  The returned
+ * values are only stable when called on the thread itself.
+ *
+ * \param thread Thread to query.
+ * \param poller_name Set to the name of the poller if a poller is running, NULL otherwise.
+ *
+ * \return the function being executed or NULL.
+ */
+void *spdk_thread_get_running_fn(struct spdk_thread *thread, const char **poller_name);
+
+/**
+ * Get the cache of message objects of the thread.
+ *
+ * \param thread Thread to query.
+ *
+ * \return the thread's message cache.
+ */
+const struct spdk_obj_cache *spdk_thread_get_msg_cache(struct spdk_thread *thread);
+
+/**
+ * Hook called by message senders to wake up a thread whose poll loop is sleeping.
+ */
+struct spdk_thread_wakeup {
+	/* Called from the sender's context, must be thread safe. */
+	void (*fn)(void *ctx);
+	void *ctx;
+};
+
+/**
+ * Arm a wakeup hook on the thread.  Any message or critical message sent to the
+ * thread after this call invokes the hook until spdk_thread_disarm_wakeup() is called.
+ *
+ * Must be called on the thread running the poll loop of the given thread.
+ *
+ * \param thread Thread to arm.
+ * \param wakeup Hook to invoke. Must stay valid until the thread is disarmed.
+ *
+ * \return 0 on success, -EAGAIN if the thread already has messages pending, in which
+ * case the hook is left disarmed.
+ */
+int spdk_thread_arm_wakeup(struct spdk_thread *thread, const struct spdk_thread_wakeup *wakeup);
+
+/**
+ * Disarm the wakeup hook of the thread.
+ *
+ * \param thread Thread to disarm.
+ */
+void spdk_thread_disarm_wakeup(struct spdk_thread *thread);
+
 struct spdk_poller *spdk_thread_get_first_active_poller(struct spdk_thread *thread);
 struct spdk_poller *spdk_thread_get_next_active_poller(struct spdk_poller *prev);
 struct spdk_poller *spdk_thread_get_first_timed_poller(struct spdk_thread *thread);
@@ -32,6 +32,7 @@
 #define MAX_TASKS_PER_CHANNEL		0x800
 #define ACCEL_SMALL_CACHE_SIZE		128
 #define ACCEL_LARGE_CACHE_SIZE		16
+#define ACCEL_BATCH_COUNT		64
 /* Set MSB, so we don't return NULL pointers as buffers */
 #define ACCEL_BUFFER_BASE		((void *)(1ull << 63))
 #define ACCEL_BUFFER_OFFSET_MASK	((uintptr_t)ACCEL_BUFFER_BASE - 1)
@@ -71,14 +72,33 @@ static struct spdk_accel_opts g_opts = {
 	.task_count = MAX_TASKS_PER_CHANNEL,
 	.sequence_count = MAX_TASKS_PER_CHANNEL,
 	.buf_count = MAX_TASKS_PER_CHANNEL,
+	.batch_count = ACCEL_BATCH_COUNT,
 };
 static struct accel_stats g_stats;
 static struct spdk_spinlock g_stats_lock;
+static struct accel_route_opts g_route_opts;
+/* Set if tasks are tracked by the routing engine, i.e. if either telemetry or routing is enabled */
+static bool g_route_tracking;
+static struct spdk_accel_module_if *g_sw_module_if;
 
 static const char *g_opcode_strings[SPDK_ACCEL_OPC_LAST] = {
 	"copy", "fill", "dualcast", "compare", "crc32c", "copy_crc32c",
 	"compress", "decompress", "encrypt", "decrypt", "xor",
-	"dif_verify", "dif_verify_copy", "dif_generate", "dif_generate_copy"
+	"dif_verify", "dif_verify_copy", "dif_generate", "dif_generate_copy", "hash",
+	"pq_gen"
+};
+
+static const char *g_comp_algo_strings[SPDK_ACCEL_COMP_ALGO_LAST] = {
+	"deflate", "lz4", "zstd"
+};
+
+static const char *g_hash_algo_strings[SPDK_ACCEL_HASH_ALGO_LAST] = {
+	"xxh64", "sha256"
+};
+
+static const uint32_t g_hash_digest_lens[SPDK_ACCEL_HASH_ALGO_LAST] = {
+	[SPDK_ACCEL_HASH_ALGO_XXH64] = sizeof(uint64_t),
+	[SPDK_ACCEL_HASH_ALGO_SHA256] = 32,
 };
 
 enum accel_sequence_state {
@@ -141,20 +161,38 @@ struct accel_buffer {
 
 struct accel_io_channel {
 	struct spdk_io_channel			*module_ch[SPDK_ACCEL_OPC_LAST];
+	/* Software module's channel used by the routing engine */
+	struct spdk_io_channel			*sw_ch;
 	struct spdk_io_channel			*driver_channel;
 	void					*task_pool_base;
 	struct spdk_accel_sequence		*seq_pool_base;
 	struct accel_buffer			*buf_pool_base;
+	struct spdk_accel_batch			*batch_pool_base;
 	struct spdk_accel_task_aux_data		*task_aux_data_base;
 	STAILQ_HEAD(, spdk_accel_task)		task_pool;
 	SLIST_HEAD(, spdk_accel_task_aux_data)	task_aux_data_pool;
 	SLIST_HEAD(, spdk_accel_sequence)	seq_pool;
 	SLIST_HEAD(, accel_buffer)		buf_pool;
+	SLIST_HEAD(, spdk_accel_batch)		batch_pool;
+	/* Batch currently open on this channel */
+	struct spdk_accel_batch			*batch;
 	struct spdk_iobuf_channel		iobuf;
 	struct accel_stats			stats;
 };
 
 TAILQ_HEAD(accel_sequence_tasks, spdk_accel_task);
+STAILQ_HEAD(accel_task_list, spdk_accel_task);
+
+struct spdk_accel_batch {
+	struct accel_io_channel			*ch;
+	struct accel_task_list			tasks;
+	uint32_t				count;
+	uint32_t				outstanding;
+	int					status;
+	spdk_accel_completion_cb		cb_fn;
+	void					*cb_arg;
+	SLIST_ENTRY(spdk_accel_batch)		link;
+};
 
 struct spdk_accel_sequence {
 	struct accel_io_channel			*ch;
@@ -178,7 +216,18 @@ SPDK_STATIC_ASSERT(sizeof(struct spdk_accel_sequence) == 64, "invalid size");
 #define accel_update_task_stats(ch, task, event, v) \
 	accel_update_stats(ch, operations[(task)->op_code].event, v)
 
+/* accel_task->route holds the route + 1 of the tasks tracked by the routing engine, 0 otherwise,
+ * and a flag indicating whether the task's latency is measured */
+#define ACCEL_TASK_ROUTE(route)		((route) + 1)
+#define ACCEL_TASK_ROUTE_MASK		0x7f
+#define ACCEL_TASK_ROUTE_TIMED		0x80
+
 static inline void accel_sequence_task_cb(void *cb_arg, int status);
+static void accel_batch_put_task(struct spdk_accel_batch *batch, int status);
+static void accel_route_task_done(struct accel_io_channel *accel_ch, struct spdk_accel_task *task,
+				  bool executed);
+static inline void accel_batch_add_task(struct spdk_accel_batch *batch,
+					struct spdk_accel_task *task);
 
 static inline void
 accel_sequence_set_state(struct spdk_accel_sequence *seq, enum accel_sequence_state state)
@@ -276,6 +325,7 @@ void
 spdk_accel_task_complete(struct spdk_accel_task *accel_task, int status)
 {
 	struct accel_io_channel		*accel_ch = accel_task->accel_ch;
+	struct spdk_accel_batch		*batch;
 	spdk_accel_completion_cb	cb_fn;
 	void				*cb_arg;
 
@@ -285,6 +335,10 @@ spdk_accel_task_complete(struct spdk_accel_task *accel_task, int status)
 		accel_update_task_stats(accel_ch, accel_task, failed, 1);
 	}
 
+	if (spdk_unlikely(accel_task->route != 0)) {
+		accel_route_task_done(accel_ch, accel_task, true);
+	}
+
 	if (accel_task->seq) {
 		accel_sequence_task_cb(accel_task->seq, status);
 		return;
@@ -292,6 +346,8 @@ spdk_accel_task_complete(struct spdk_accel_task *accel_task, int status)
 
 	cb_fn = accel_task->cb_fn;
 	cb_arg = accel_task->cb_arg;
+	batch = accel_task->batch;
+	accel_task->batch = NULL;
 
 	if (accel_task->has_aux) {
 		SLIST_INSERT_HEAD(&accel_ch->task_aux_data_pool, accel_task->aux, link);
@@ -305,6 +361,15 @@ spdk_accel_task_complete(struct spdk_accel_task *accel_task, int status)
 	 */
 	STAILQ_INSERT_HEAD(&accel_ch->task_pool, accel_task, link);
 
+	if (spdk_unlikely(batch != NULL)) {
+		/* Tasks submitted within a batch are allowed to skip the per-task callback */
+		if (cb_fn != NULL) {
+			cb_fn(cb_arg, status);
+		}
+		accel_batch_put_task(batch, status);
+		return;
+	}
+
 	cb_fn(cb_arg, status);
 }
 
@@ -331,16 +396,151 @@ _get_task(struct accel_io_channel *accel_ch, spdk_accel_completion_cb cb_fn, voi
 	return accel_task;
 }
 
+static inline bool
+accel_route_sw_allowed(struct spdk_accel_task *task)
+{
+	switch (task->op_code) {
+	/* Crypto keys are bound to a module and compression levels are module-specific */
+	case SPDK_ACCEL_OPC_ENCRYPT:
+	case SPDK_ACCEL_OPC_DECRYPT:
+	case SPDK_ACCEL_OPC_COMPRESS:
+	case SPDK_ACCEL_OPC_DECOMPRESS:
+		return false;
+	default:
+		break;
+	}
+
+	/* The software module doesn't support memory domains */
+	if (task->src_domain != NULL || task->dst_domain != NULL) {
+		return false;
+	}
+
+	return g_sw_module_if != NULL && g_modules_opc[task->op_code].module != g_sw_module_if &&
+	       g_sw_module_if->supports_opcode(task->op_code);
+}
+
+static inline enum accel_route
+accel_route_select(struct accel_io_channel *accel_ch, struct spdk_accel_task *task)
+{
+	struct accel_opcode_route_stats *stats = &accel_ch->stats.routing[task->op_code];
+
+	if (!g_route_opts.routing || !accel_route_sw_allowed(task)) {
+		stats->decisions.module++;
+		return ACCEL_ROUTE_MODULE;
+	}
+
+	if (task->nbytes <= g_route_opts.sw_max_size) {
+		stats->decisions.size++;
+		return ACCEL_ROUTE_SW;
+	}
+
+	if (g_route_opts.max_queue_depth != 0 &&
+	    stats->routes[ACCEL_ROUTE_MODULE].queue_depth >= g_route_opts.max_queue_depth) {
+		stats->decisions.backlog++;
+		return ACCEL_ROUTE_SW;
+	}
+
+	stats->decisions.module++;
+	return ACCEL_ROUTE_MODULE;
+}
+
+static void
+accel_route_task(struct accel_io_channel *accel_ch, struct spdk_accel_task *task)
+{
+	enum accel_route route = accel_route_select(accel_ch, task);
+	struct accel_route_stats *stats = &accel_ch->stats.routing[task->op_code].routes[route];
+
+	task->route = ACCEL_TASK_ROUTE(route);
+	if (g_route_opts.telemetry) {
+		task->route |= ACCEL_TASK_ROUTE_TIMED;
+		task->submit_tsc = spdk_get_ticks();
+	}
+	stats->queue_depth++;
+	stats->max_queue_depth = spdk_max(stats->max_queue_depth, stats->queue_depth);
+}
+
+static void
+accel_route_task_done(struct accel_io_channel *accel_ch, struct spdk_accel_task *task,
+		      bool executed)
+{
+	struct accel_route_stats *stats;
+	uint64_t ticks, bucket = 0;
+	uint8_t route = task->route;
+
+	assert((route & ACCEL_TASK_ROUTE_MASK) > 0 &&
+	       (route & ACCEL_TASK_ROUTE_MASK) <= ACCEL_ROUTE_COUNT);
+	stats = &accel_ch->stats.routing[task->op_code].routes[(route & ACCEL_TASK_ROUTE_MASK) - 1];
+	task->route = 0;
+
+	assert(stats->queue_depth > 0);
+	stats->queue_depth--;
+	if (!executed) {
+		return;
+	}
+
+	stats->executed++;
+	if (route & ACCEL_TASK_ROUTE_TIMED) {
+		ticks = spdk_get_ticks() - task->submit_tsc;
+		stats->latency_ticks += ticks;
+		stats->max_latency_ticks = spdk_max(stats->max_latency_ticks, ticks);
+		if (ticks != 0) {
+			bucket = spdk_min(spdk_u64log2(ticks), ACCEL_ROUTE_LATENCY_BUCKETS - 1);
+		}
+		stats->latency_histogram[bucket]++;
+	}
+}
+
+static inline bool
+accel_task_routed_to_sw(struct spdk_accel_task *task)
+{
+	return (task->route & ACCEL_TASK_ROUTE_MASK) == ACCEL_TASK_ROUTE(ACCEL_ROUTE_SW);
+}
+
+static inline struct spdk_accel_module_if *
+accel_task_get_module(struct spdk_accel_task *task)
+{
+	if (spdk_unlikely(accel_task_routed_to_sw(task))) {
+		return g_sw_module_if;
+	}
+
+	return g_modules_opc[task->op_code].module;
+}
+
+static inline struct spdk_io_channel *
+accel_task_get_module_ch(struct accel_io_channel *accel_ch, struct spdk_accel_task *task)
+{
+	if (spdk_unlikely(accel_task_routed_to_sw(task))) {
+		return accel_ch->sw_ch;
+	}
+
+	return accel_ch->module_ch[task->op_code];
+}
+
 static inline int
 accel_submit_task(struct accel_io_channel *accel_ch, struct spdk_accel_task *task)
 {
-	struct spdk_io_channel *module_ch = accel_ch->module_ch[task->op_code];
-	struct spdk_accel_module_if *module = g_modules_opc[task->op_code].module;
+	struct spdk_io_channel *module_ch;
+	struct spdk_accel_module_if *module;
 	int rc;
 
+	/* Tasks that are part of a sequence are never batched */
+	if (spdk_unlikely(accel_ch->batch != NULL) && task->seq == NULL) {
+		accel_batch_add_task(accel_ch->batch, task);
+		return 0;
+	}
+
+	if (spdk_unlikely(g_route_tracking)) {
+		accel_route_task(accel_ch, task);
+	}
+
+	module = accel_task_get_module(task);
+	module_ch = accel_task_get_module_ch(accel_ch, task);
 	rc = module->submit_tasks(module_ch, task);
 	if (spdk_unlikely(rc != 0)) {
 		accel_update_task_stats(accel_ch, task, failed, 1);
+		if (task->route != 0) {
+			accel_route_task_done(accel_ch, task, false);
+		}
 	}
 
 	return rc;
@@ -655,10 +855,148 @@ spdk_accel_submit_copy_crc32cv(struct spdk_io_channel *ch, void *dst,
 	return accel_submit_task(accel_ch, accel_task);
 }
 
+static bool
+accel_compress_supports_algo(enum spdk_accel_opcode opcode, enum spdk_accel_comp_algo algo)
+{
+	struct spdk_accel_module_if *module = g_modules_opc[opcode].module;
+
+	if (algo >= SPDK_ACCEL_COMP_ALGO_LAST || module == NULL) {
+		return false;
+	}
+
+	if (module->compress_supports_algo == NULL) {
+		return algo == SPDK_ACCEL_COMP_ALGO_DEFLATE;
+	}
+
+	return module->compress_supports_algo(algo);
+}
+
 int
-spdk_accel_submit_compress(struct spdk_io_channel *ch, void *dst, uint64_t nbytes,
-			   struct iovec *src_iovs, size_t src_iovcnt, uint32_t *output_size,
-			   spdk_accel_completion_cb cb_fn, void *cb_arg)
+spdk_accel_get_compress_level_range(enum spdk_accel_comp_algo algo, uint32_t *min_level,
+				    uint32_t *max_level)
+{
+	struct spdk_accel_module_if *module = g_modules_opc[SPDK_ACCEL_OPC_COMPRESS].module;
+
+	if (!accel_compress_supports_algo(SPDK_ACCEL_OPC_COMPRESS, algo)) {
+		return -EINVAL;
+	}
+
+	if (module->get_compress_level_range == NULL) {
+		*min_level = 0;
+		*max_level = 0;
+		return 0;
+	}
+
+	return module->get_compress_level_range(algo, min_level, max_level);
+}
+
+const char *
+spdk_accel_get_comp_algo_name(enum spdk_accel_comp_algo algo)
+{
+	if (algo < SPDK_ACCEL_COMP_ALGO_LAST) {
+		return g_comp_algo_strings[algo];
+	}
+
+	return NULL;
+}
+
+int
+spdk_accel_get_comp_algo_by_name(const char *name, enum spdk_accel_comp_algo *algo)
+{
+	int i;
+
+	for (i = 0; i < SPDK_ACCEL_COMP_ALGO_LAST; i++) {
+		if (strcmp(name, g_comp_algo_strings[i]) == 0) {
+			*algo = i;
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
+
+const char *
+spdk_accel_get_hash_algo_name(enum spdk_accel_hash_algo algo)
+{
+	if (algo < SPDK_ACCEL_HASH_ALGO_LAST) {
+		return g_hash_algo_strings[algo];
+	}
+
+	return NULL;
+}
+
+int
+spdk_accel_get_hash_algo_by_name(const char *name, enum spdk_accel_hash_algo *algo)
+{
+	int i;
+
+	for (i = 0; i < SPDK_ACCEL_HASH_ALGO_LAST; i++) {
+		if (strcmp(name, g_hash_algo_strings[i]) == 0) {
+			*algo = i;
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
+
+uint32_t
+spdk_accel_get_hash_digest_len(enum spdk_accel_hash_algo algo)
+{
+	if (algo < SPDK_ACCEL_HASH_ALGO_LAST) {
+		return g_hash_digest_lens[algo];
+	}
+
+	return 0;
+}
+
+static bool
+accel_hash_supports_algo(enum spdk_accel_hash_algo algo)
+{
+	struct spdk_accel_module_if *module = g_modules_opc[SPDK_ACCEL_OPC_HASH].module;
+
+	if (algo >= SPDK_ACCEL_HASH_ALGO_LAST || module == NULL ||
+	    module->hash_supports_algo == NULL) {
+		return false;
+	}
+
+	return module->hash_supports_algo(algo);
+}
+
+int
+spdk_accel_submit_hash(struct spdk_io_channel *ch, uint8_t *digest, struct iovec *src_iovs,
+		       size_t src_iovcnt, enum spdk_accel_hash_algo algo,
+		       spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+
+	if (spdk_unlikely(!accel_hash_supports_algo(algo))) {
+		return -EINVAL;
+	}
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (spdk_unlikely(accel_task == NULL)) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = src_iovs;
+	accel_task->s.iovcnt = src_iovcnt;
+	accel_task->nbytes = accel_get_iovlen(src_iovs, src_iovcnt);
+	accel_task->digest = digest;
+	accel_task->hash.algo = algo;
+	accel_task->op_code = SPDK_ACCEL_OPC_HASH;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+
+	return accel_submit_task(accel_ch, accel_task);
+}
+
+static int
+accel_submit_compress(struct spdk_io_channel *ch, void *dst, uint64_t nbytes,
+		      struct iovec *src_iovs, size_t src_iovcnt,
+		      enum spdk_accel_comp_algo comp_algo, uint32_t comp_level,
+		      uint32_t *output_size, spdk_accel_completion_cb cb_fn, void *cb_arg)
 {
 	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
 	struct spdk_accel_task *accel_task;
@@ -678,6 +1016,8 @@ spdk_accel_submit_compress(struct spdk_io_channel *ch, void *dst, uint64_t nbyte
 	accel_task->s.iovs = src_iovs;
 	accel_task->s.iovcnt = src_iovcnt;
 	accel_task->nbytes = nbytes;
+	accel_task->comp.algo = comp_algo;
+	accel_task->comp.level = comp_level;
 	accel_task->op_code = SPDK_ACCEL_OPC_COMPRESS;
 	accel_task->src_domain = NULL;
 	accel_task->dst_domain = NULL;
@@ -686,10 +1026,47 @@ spdk_accel_submit_compress(struct spdk_io_channel *ch, void *dst, uint64_t nbyte
 }
 
 int
-spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_iovs,
-			     size_t dst_iovcnt, struct iovec *src_iovs, size_t src_iovcnt,
-			     uint32_t *output_size, spdk_accel_completion_cb cb_fn,
-			     void *cb_arg)
+spdk_accel_submit_compress(struct spdk_io_channel *ch, void *dst, uint64_t nbytes,
+			   struct iovec *src_iovs, size_t src_iovcnt, uint32_t *output_size,
+			   spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	uint32_t min_level = 0, max_level;
+
+	/* Use the fastest level supported by the module */
+	spdk_accel_get_compress_level_range(SPDK_ACCEL_COMP_ALGO_DEFLATE, &min_level, &max_level);
+
+	return accel_submit_compress(ch, dst, nbytes, src_iovs, src_iovcnt,
+				     SPDK_ACCEL_COMP_ALGO_DEFLATE, min_level, output_size,
+				     cb_fn, cb_arg);
+}
+
+int
+spdk_accel_submit_compress_ext(struct spdk_io_channel *ch, void *dst, uint64_t nbytes,
+			       struct iovec *src_iovs, size_t src_iovcnt,
+			       enum spdk_accel_comp_algo comp_algo, uint32_t comp_level,
+			       uint32_t *output_size, spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	uint32_t min_level, max_level;
+	int rc;
+
+	rc = spdk_accel_get_compress_level_range(comp_algo, &min_level, &max_level);
+	if (spdk_unlikely(rc != 0)) {
+		return rc;
+	}
+
+	if (spdk_unlikely(comp_level < min_level || comp_level > max_level)) {
+		return -EINVAL;
+	}
+
+	return accel_submit_compress(ch, dst, nbytes, src_iovs, src_iovcnt, comp_algo, comp_level,
+				     output_size, cb_fn, cb_arg);
+}
+
+static int
+accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_iovs,
+			size_t dst_iovcnt, struct iovec *src_iovs, size_t src_iovcnt,
+			enum spdk_accel_comp_algo decomp_algo, uint32_t *output_size,
+			spdk_accel_completion_cb cb_fn, void *cb_arg)
 {
 	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
 	struct spdk_accel_task *accel_task;
@@ -705,6 +1082,7 @@ spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_iovs,
 	accel_task->d.iovs = dst_iovs;
 	accel_task->d.iovcnt = dst_iovcnt;
 	accel_task->nbytes = accel_get_iovlen(src_iovs, src_iovcnt);
+	accel_task->comp.algo = decomp_algo;
 	accel_task->op_code = SPDK_ACCEL_OPC_DECOMPRESS;
 	accel_task->src_domain = NULL;
 	accel_task->dst_domain = NULL;
@@ -712,6 +1090,30 @@ spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_iovs,
 	return accel_submit_task(accel_ch, accel_task);
 }
 
+int
+spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_iovs,
+			     size_t dst_iovcnt, struct iovec *src_iovs, size_t src_iovcnt,
+			     uint32_t *output_size, spdk_accel_completion_cb cb_fn,
+			     void *cb_arg)
+{
+	return accel_submit_decompress(ch, dst_iovs, dst_iovcnt, src_iovs, src_iovcnt,
+				       SPDK_ACCEL_COMP_ALGO_DEFLATE, output_size, cb_fn, cb_arg);
+}
+
+int
+spdk_accel_submit_decompress_ext(struct spdk_io_channel *ch, struct iovec *dst_iovs,
+				 size_t dst_iovcnt, struct iovec *src_iovs, size_t src_iovcnt,
+				 enum spdk_accel_comp_algo decomp_algo, uint32_t *output_size,
+				 spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	if (spdk_unlikely(!accel_compress_supports_algo(SPDK_ACCEL_OPC_DECOMPRESS, decomp_algo))) {
+		return -EINVAL;
+	}
+
+	return accel_submit_decompress(ch, dst_iovs, dst_iovcnt, src_iovs, src_iovcnt, decomp_algo,
+				       output_size, cb_fn, cb_arg);
+}
+
 int
 spdk_accel_submit_encrypt(struct spdk_io_channel *ch, struct spdk_accel_crypto_key *key,
 			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
@@ -808,6 +1210,38 @@ spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uin
 	return accel_submit_task(accel_ch, accel_task);
 }
 
+int
+spdk_accel_submit_pq_gen(struct spdk_io_channel *ch, void *p, void *q, void **sources,
+			 uint32_t nsrcs, uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (spdk_unlikely(accel_task == NULL)) {
+		return -ENOMEM;
+	}
+
+	ACCEL_TASK_ALLOC_AUX_BUF(accel_task);
+
+	accel_task->d.iovs = &accel_task->aux->iovs[SPDK_ACCEL_AUX_IOV_DST];
+	accel_task->d2.iovs = &accel_task->aux->iovs[SPDK_ACCEL_AUX_IOV_DST2];
+	accel_task->nsrcs.srcs = sources;
+	accel_task->nsrcs.cnt = nsrcs;
+	accel_task->d.iovs[0].iov_base = p;
+	accel_task->d.iovs[0].iov_len = nbytes;
+	accel_task->d.iovcnt = 1;
+	accel_task->d2.iovs[0].iov_base = q;
+	accel_task->d2.iovs[0].iov_len = nbytes;
+	accel_task->d2.iovcnt = 1;
+	accel_task->nbytes = nbytes;
+	accel_task->op_code = SPDK_ACCEL_OPC_PQ_GEN;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+
+	return accel_submit_task(accel_ch, accel_task);
+}
+
 int
 spdk_accel_submit_dif_verify(struct spdk_io_channel *ch,
 			     struct iovec *iovs, size_t iovcnt, uint32_t num_blocks,
@@ -919,6 +1353,162 @@ spdk_accel_submit_dif_verify_copy(struct spdk_io_channel *ch,
 	return accel_submit_task(accel_ch, accel_task);
 }
 
+struct spdk_accel_batch *
+spdk_accel_batch_create(struct spdk_io_channel *ch)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_batch *batch;
+
+	if (spdk_unlikely(accel_ch->batch != NULL)) {
+		SPDK_ERRLOG("A batch is already open on this channel\n");
+		return NULL;
+	}
+
+	batch = SLIST_FIRST(&accel_ch->batch_pool);
+	if (spdk_unlikely(batch == NULL)) {
+		return NULL;
+	}
+
+	SLIST_REMOVE_HEAD(&accel_ch->batch_pool, link);
+	STAILQ_INIT(&batch->tasks);
+	batch->ch = accel_ch;
+	batch->count = 0;
+	batch->outstanding = 0;
+	batch->status = 0;
+	batch->cb_fn = NULL;
+	batch->cb_arg = NULL;
+	accel_ch->batch = batch;
+
+	return batch;
+}
+
+static inline void
+accel_batch_add_task(struct spdk_accel_batch *batch, struct spdk_accel_task *task)
+{
+	task->batch = batch;
+	STAILQ_INSERT_TAIL(&batch->tasks, task, link);
+	batch->count++;
+}
+
+static void
+accel_batch_put_task(struct spdk_accel_batch *batch, int status)
+{
+	struct accel_io_channel *ch = batch->ch;
+	spdk_accel_completion_cb cb_fn = batch->cb_fn;
+	void *cb_arg = batch->cb_arg;
+
+	if (spdk_unlikely(status != 0) && batch->status == 0) {
+		batch->status = status;
+	}
+
+	assert(batch->outstanding > 0);
+	if (--batch->outstanding > 0) {
+		return;
+	}
+
+	status = batch->status;
+	SLIST_INSERT_HEAD(&ch->batch_pool, batch, link);
+
+	if (cb_fn != NULL) {
+		cb_fn(cb_arg, status);
+	}
+}
+
+int
+spdk_accel_batch_submit(struct spdk_accel_batch *batch, spdk_accel_completion_cb cb_fn,
+			void *cb_arg)
+{
+	struct accel_io_channel *ch = batch->ch;
+	struct accel_task_list group, rest;
+	struct spdk_accel_module_if *module;
+	struct spdk_io_channel *module_ch;
+	struct spdk_accel_task *task, *tmp;
+	int rc;
+
+	assert(ch->batch == batch);
+	if (spdk_unlikely(STAILQ_EMPTY(&batch->tasks))) {
+		return -EINVAL;
+	}
+
+	ch->batch = NULL;
+	batch->cb_fn = cb_fn;
+	batch->cb_arg = cb_arg;
+	/* Hold an extra reference to make sure the batch isn't completed before all of its tasks
+	 * are submitted */
+	batch->outstanding = batch->count + 1;
+
+	if (spdk_unlikely(g_route_tracking)) {
+		STAILQ_FOREACH(task, &batch->tasks, link) {
+			accel_route_task(ch, task);
+		}
+	}
+
+	while (!STAILQ_EMPTY(&batch->tasks)) {
+		task = STAILQ_FIRST(&batch->tasks);
+		module = accel_task_get_module(task);
+		module_ch = accel_task_get_module_ch(ch, task);
+
+		if (!module->submit_task_lists) {
+			STAILQ_REMOVE_HEAD(&batch->tasks, link);
+			task->link.stqe_next = NULL;
+			rc = module->submit_tasks(module_ch, task);
+			if (spdk_unlikely(rc != 0)) {
+				spdk_accel_task_complete(task, rc);
+			}
+			continue;
+		}
+
+		/* Hand all tasks executed on the same module channel in a single list */
+		STAILQ_INIT(&group);
+		STAILQ_INIT(&rest);
+		STAILQ_FOREACH_SAFE(task, &batch->tasks, link, tmp) {
+			if (accel_task_get_module_ch(ch, task) == module_ch) {
+				STAILQ_INSERT_TAIL(&group, task, link);
+			} else {
+				STAILQ_INSERT_TAIL(&rest, task, link);
+			}
+		}
+		STAILQ_SWAP(&batch->tasks, &rest, spdk_accel_task);
+
+		rc = module->submit_tasks(module_ch, STAILQ_FIRST(&group));
+		assert(rc == 0);
+	}
+
+	accel_batch_put_task(batch, 0);
+
+	return 0;
+}
+
+void
+spdk_accel_batch_abort(struct spdk_accel_batch *batch)
+{
+	struct accel_io_channel *ch = batch->ch;
+	struct spdk_accel_task *task;
+	spdk_accel_completion_cb cb_fn;
+	void *cb_arg;
+
+	assert(ch->batch == batch);
+	ch->batch = NULL;
+
+	while ((task = STAILQ_FIRST(&batch->tasks)) != NULL) {
+		STAILQ_REMOVE_HEAD(&batch->tasks, link);
+		cb_fn = task->cb_fn;
+		cb_arg = task->cb_arg;
+		task->batch = NULL;
+		if (task->has_aux) {
+			SLIST_INSERT_HEAD(&ch->task_aux_data_pool, task->aux, link);
+			task->aux = NULL;
+			task->has_aux = false;
+		}
+		STAILQ_INSERT_HEAD(&ch->task_pool, task, link);
+		if (cb_fn != NULL) {
+			cb_fn(cb_arg, -ECANCELED);
+		}
+	}
+
+	SLIST_INSERT_HEAD(&ch->batch_pool, batch, link);
+}
+
 static inline struct accel_buffer *
 accel_get_buf(struct accel_io_channel *ch, uint64_t len)
 {
@@ -1156,6 +1746,7 @@ spdk_accel_append_decompress(struct spdk_accel_sequence **pseq, struct spdk_io_c
 	task->s.iovs = src_iovs;
 	task->s.iovcnt = src_iovcnt;
 	task->nbytes = accel_get_iovlen(src_iovs, src_iovcnt);
+	task->comp.algo = SPDK_ACCEL_COMP_ALGO_DEFLATE;
 	task->op_code = SPDK_ACCEL_OPC_DECOMPRESS;
 
 	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
@@ -1313,6 +1904,53 @@ spdk_accel_append_crc32c(struct spdk_accel_sequence **pseq, struct spdk_io_chann
 	return 0;
 }
 
+int
+spdk_accel_append_hash(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+		       uint8_t *digest, struct iovec *iovs, uint32_t iovcnt,
+		       struct spdk_memory_domain *domain, void *domain_ctx,
+		       enum spdk_accel_hash_algo algo, spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	if (spdk_unlikely(!accel_hash_supports_algo(algo))) {
+		return -EINVAL;
+	}
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	task->s.iovs = iovs;
+	task->s.iovcnt = iovcnt;
+	task->src_domain = domain;
+	task->src_domain_ctx = domain_ctx;
+	task->nbytes = accel_get_iovlen(iovs, iovcnt);
+	task->digest = digest;
+	task->hash.algo = algo;
+	task->op_code = SPDK_ACCEL_OPC_HASH;
+	task->dst_domain = NULL;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
 int
 spdk_accel_get_buf(struct spdk_io_channel *ch, uint64_t len, void **buf,
 		   struct spdk_memory_domain **domain, void **domain_ctx)
@@ -1991,6 +2629,7 @@ accel_task_set_dstbuf(struct spdk_accel_task *task, struct spdk_accel_task *next
 	case SPDK_ACCEL_OPC_FILL:
 	case SPDK_ACCEL_OPC_ENCRYPT:
 	case SPDK_ACCEL_OPC_DECRYPT:
+	case SPDK_ACCEL_OPC_COPY_CRC32C:
 		if (task->dst_domain != next->src_domain) {
 			return false;
 		}
@@ -2004,7 +2643,8 @@ accel_task_set_dstbuf(struct spdk_accel_task *task, struct spdk_accel_task *next
 		task->dst_domain_ctx = next->dst_domain_ctx;
 		break;
 	case SPDK_ACCEL_OPC_CRC32C:
-		/* crc32 is special, because it doesn't have a dst buffer */
+	case SPDK_ACCEL_OPC_HASH:
+		/* crc32 and hash are special, because they don't have a dst buffer */
 		if (task->src_domain != next->src_domain) {
 			return false;
 		}
@@ -2032,6 +2672,64 @@ accel_task_set_dstbuf(struct spdk_accel_task *task, struct spdk_accel_task *next
 	return true;
 }
 
+static bool
+accel_sequence_can_fuse(enum spdk_accel_opcode first, enum spdk_accel_opcode second,
+			enum spdk_accel_opcode fused_opcode)
+{
+	struct spdk_accel_module_if *module = g_modules_opc[fused_opcode].module;
+
+	/* Only fuse operations if both of them are executed by the same module as the fused
+	 * operation, otherwise we might end up moving work from a hardware accelerator to the CPU.
+	 */
+	return g_modules_opc[first].module == module && g_modules_opc[second].module == module;
+}
+
+/* Fuse a copy with a crc32c calculated over either its source or its destination buffer into
+ * a single copy+crc32c task, so that the data is only read once.  The crc32c task is the one
+ * being kept, as its step callback can only be executed once the crc is calculated.
+ */
+static bool
+accel_sequence_fuse_copy_crc32c(struct spdk_accel_task *copy, struct spdk_accel_task *crc)
+{
+	if (!accel_sequence_can_fuse(SPDK_ACCEL_OPC_COPY, SPDK_ACCEL_OPC_CRC32C,
+				     SPDK_ACCEL_OPC_COPY_CRC32C)) {
+		return false;
+	}
+
+	if (TAILQ_NEXT(copy, seq_link) == crc) {
+		/* copy -> crc32c(copy's dst) */
+		if (copy->dst_domain != crc->src_domain) {
+			return false;
+		}
+		if (!accel_compare_iovs(copy->d.iovs, copy->d.iovcnt,
+					crc->s.iovs, crc->s.iovcnt)) {
+			return false;
+		}
+		crc->s.iovs = copy->s.iovs;
+		crc->s.iovcnt = copy->s.iovcnt;
+		crc->src_domain = copy->src_domain;
+		crc->src_domain_ctx = copy->src_domain_ctx;
+	} else {
+		/* crc32c(copy's src) -> copy */
+		assert(TAILQ_NEXT(crc, seq_link) == copy);
+		if (copy->src_domain != crc->src_domain) {
+			return false;
+		}
+		if (!accel_compare_iovs(copy->s.iovs, copy->s.iovcnt,
+					crc->s.iovs, crc->s.iovcnt)) {
+			return false;
+		}
+	}
+
+	crc->d.iovs = copy->d.iovs;
+	crc->d.iovcnt = copy->d.iovcnt;
+	crc->dst_domain = copy->dst_domain;
+	crc->dst_domain_ctx = copy->dst_domain_ctx;
+	crc->op_code = SPDK_ACCEL_OPC_COPY_CRC32C;
+
+	return true;
+}
+
 static void
 accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_task *task,
 			   struct spdk_accel_task **next_task)
@@ -2040,6 +2738,13 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 
 	switch (task->op_code) {
 	case SPDK_ACCEL_OPC_COPY:
+		if (next->op_code == SPDK_ACCEL_OPC_CRC32C) {
+			if (accel_sequence_fuse_copy_crc32c(task, next)) {
+				accel_update_stats(seq->ch, sequence_fused, 1);
+				accel_sequence_complete_task(seq, task);
+			}
+			break;
+		}
 		/* We only allow changing src of operations that actually have a src, e.g. we never
 		 * do it for fill.  Theoretically, it is possible, but we'd have to be careful to
 		 * change the src of the operation after fill (which in turn could also be a fill).
@@ -2070,12 +2775,19 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 	case SPDK_ACCEL_OPC_ENCRYPT:
 	case SPDK_ACCEL_OPC_DECRYPT:
 	case SPDK_ACCEL_OPC_CRC32C:
+	case SPDK_ACCEL_OPC_COPY_CRC32C:
+	case SPDK_ACCEL_OPC_HASH:
 		/* We can only merge tasks when one of them is a copy */
 		if (next->op_code != SPDK_ACCEL_OPC_COPY) {
 			break;
 		}
 		if (!accel_task_set_dstbuf(task, next)) {
-			break;
+			/* If the copy can't be removed, try to fuse it with the crc32c */
+			if (task->op_code != SPDK_ACCEL_OPC_CRC32C ||
+			    !accel_sequence_fuse_copy_crc32c(next, task)) {
+				break;
+			}
+			accel_update_stats(seq->ch, sequence_fused, 1);
 		}
 		/* We're removing next_task from the tasks queue, so we need to update its pointer,
 		 * so that the TAILQ_FOREACH_SAFE() loop below works correctly */
@@ -2094,7 +2806,7 @@ spdk_accel_sequence_finish(struct spdk_accel_sequence *seq,
 {
 	struct spdk_accel_task *task, *next;
 
-	/* Try to remove any copy operations if possible */
+	/* Try to remove any copy operations if possible or fuse them with other operations */
 	TAILQ_FOREACH_SAFE(task, &seq->tasks, seq_link, next) {
 		if (next == NULL) {
 			break;
@@ -2549,10 +3261,16 @@ accel_create_channel(void *io_device, void *ctx_buf)
 		goto err;
 	}
 
+	accel_ch->batch_pool_base = calloc(g_opts.batch_count, sizeof(struct spdk_accel_batch));
+	if (accel_ch->batch_pool_base == NULL) {
+		goto err;
+	}
+
 	STAILQ_INIT(&accel_ch->task_pool);
 	SLIST_INIT(&accel_ch->task_aux_data_pool);
 	SLIST_INIT(&accel_ch->seq_pool);
 	SLIST_INIT(&accel_ch->buf_pool);
+	SLIST_INIT(&accel_ch->batch_pool);
 
 	task_mem = accel_ch->task_pool_base;
 	for (i = 0; i < g_opts.task_count; i++) {
@@ -2571,6 +3289,9 @@ accel_create_channel(void *io_device, void *ctx_buf)
 		buf = &accel_ch->buf_pool_base[i];
 		SLIST_INSERT_HEAD(&accel_ch->buf_pool, buf, link);
 	}
+	for (i = 0; i < g_opts.batch_count; i++) {
+		SLIST_INSERT_HEAD(&accel_ch->batch_pool, &accel_ch->batch_pool_base[i], link);
+	}
 
 	/* Assign modules and get IO channels for each */
 	for (i = 0; i < SPDK_ACCEL_OPC_LAST; i++) {
@@ -2590,6 +3311,14 @@ accel_create_channel(void *io_device, void *ctx_buf)
 		}
 	}
 
+	if (g_sw_module_if != NULL) {
+		accel_ch->sw_ch = g_sw_module_if->get_io_channel();
+		if (accel_ch->sw_ch == NULL) {
+			SPDK_ERRLOG("Failed to get software module's IO channel\n");
+			goto err;
+		}
+	}
+
 	rc = spdk_iobuf_channel_init(&accel_ch->iobuf, "accel", g_opts.small_cache_size,
 				     g_opts.large_cache_size);
 	if (rc != 0) {
@@ -2599,6 +3328,9 @@ accel_create_channel(void *io_device, void *ctx_buf)
 
 	return 0;
 err:
+	if (accel_ch->sw_ch != NULL) {
+		spdk_put_io_channel(accel_ch->sw_ch);
+	}
 	if (accel_ch->driver_channel != NULL) {
 		spdk_put_io_channel(accel_ch->driver_channel);
 	}
@@ -2609,10 +3341,37 @@ err:
 	free(accel_ch->task_aux_data_base);
 	free(accel_ch->seq_pool_base);
 	free(accel_ch->buf_pool_base);
+	free(accel_ch->batch_pool_base);
 
 	return -ENOMEM;
 }
 
+static void
+accel_add_route_stats(struct accel_opcode_route_stats *total,
+		      struct accel_opcode_route_stats *stats)
+{
+	struct accel_route_stats *troute, *sroute;
+	int i, j;
+
+	total->decisions.module += stats->decisions.module;
+	total->decisions.size += stats->decisions.size;
+	total->decisions.backlog += stats->decisions.backlog;
+	for (i = 0; i < ACCEL_ROUTE_COUNT; ++i) {
+		troute = &total->routes[i];
+		sroute = &stats->routes[i];
+		troute->executed += sroute->executed;
+		troute->queue_depth += sroute->queue_depth;
+		troute->max_queue_depth = spdk_max(troute->max_queue_depth,
+						   sroute->max_queue_depth);
+		troute->latency_ticks += sroute->latency_ticks;
+		troute->max_latency_ticks = spdk_max(troute->max_latency_ticks,
+						     sroute->max_latency_ticks);
+		for (j = 0; j < ACCEL_ROUTE_LATENCY_BUCKETS; ++j) {
+			troute->latency_histogram[j] += sroute->latency_histogram[j];
+		}
+	}
+}
+
 static void
 accel_add_stats(struct accel_stats *total, struct accel_stats *stats)
 {
@@ -2620,6 +3379,7 @@ accel_add_stats(struct accel_stats *total, struct accel_stats *stats)
 
 	total->sequence_executed += stats->sequence_executed;
 	total->sequence_failed += stats->sequence_failed;
+	total->sequence_fused += stats->sequence_fused;
 	total->retry.task += stats->retry.task;
 	total->retry.sequence += stats->retry.sequence;
 	total->retry.iobuf += stats->retry.iobuf;
@@ -2628,6 +3388,7 @@ accel_add_stats(struct accel_stats *total, struct accel_stats *stats)
 		total->operations[i].executed += stats->operations[i].executed;
 		total->operations[i].failed += stats->operations[i].failed;
 		total->operations[i].num_bytes += stats->operations[i].num_bytes;
+		accel_add_route_stats(&total->routing[i], &stats->routing[i]);
 	}
 }
 
@@ -2640,6 +3401,10 @@ accel_destroy_channel(void *io_device, void *ctx_buf)
 
 	spdk_iobuf_channel_fini(&accel_ch->iobuf);
 
+	if (accel_ch->sw_ch != NULL) {
+		spdk_put_io_channel(accel_ch->sw_ch);
+	}
+
 	if (accel_ch->driver_channel != NULL) {
 		spdk_put_io_channel(accel_ch->driver_channel);
 	}
@@ -2659,6 +3424,7 @@ accel_destroy_channel(void *io_device, void *ctx_buf)
 	free(accel_ch->task_aux_data_base);
 	free(accel_ch->seq_pool_base);
 	free(accel_ch->buf_pool_base);
+	free(accel_ch->batch_pool_base);
 }
 
 struct spdk_io_channel *
@@ -2836,6 +3602,8 @@ spdk_accel_initialize(void)
 		accel_module_init_opcode(op);
 	}
 
+	g_sw_module_if = _module_find_by_name("software");
+
 	rc = spdk_iobuf_register_module("accel");
 	if (rc != 0) {
 		SPDK_ERRLOG("Failed to register accel iobuf module\n");
@@ -2914,6 +3682,25 @@ accel_write_options(struct spdk_json_write_ctx *w)
 	spdk_json_write_named_uint32(w, "task_count", g_opts.task_count);
 	spdk_json_write_named_uint32(w, "sequence_count", g_opts.sequence_count);
 	spdk_json_write_named_uint32(w, "buf_count", g_opts.buf_count);
+	spdk_json_write_named_uint32(w, "batch_count", g_opts.batch_count);
+	spdk_json_write_object_end(w);
+	spdk_json_write_object_end(w);
+}
+
+static void
+accel_write_route_opts(struct spdk_json_write_ctx *w)
+{
+	if (!g_route_opts.telemetry && !g_route_opts.routing) {
+		return;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "accel_set_route_policy");
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_bool(w, "telemetry", g_route_opts.telemetry);
+	spdk_json_write_named_bool(w, "routing", g_route_opts.routing);
+	spdk_json_write_named_uint32(w, "sw_max_size", g_route_opts.sw_max_size);
+	spdk_json_write_named_uint32(w, "max_queue_depth", g_route_opts.max_queue_depth);
 	spdk_json_write_object_end(w);
 	spdk_json_write_object_end(w);
 }
@@ -2948,6 +3735,7 @@ spdk_accel_write_config_json(struct spdk_json_write_ctx *w)
 
 	spdk_json_write_array_begin(w);
 	accel_write_options(w);
+	accel_write_route_opts(w);
 
 	TAILQ_FOREACH(accel_module, &spdk_accel_module_list, tailq) {
 		if (accel_module->write_config_json) {
@@ -3095,6 +3883,7 @@ spdk_accel_set_opts(const struct spdk_accel_opts *opts)
 	SET_FIELD(task_count);
 	SET_FIELD(sequence_count);
 	SET_FIELD(buf_count);
+	SET_FIELD(batch_count);
 
 	g_opts.opts_size = opts->opts_size;
 
@@ -3128,12 +3917,33 @@ spdk_accel_get_opts(struct spdk_accel_opts *opts, size_t opts_size)
 	SET_FIELD(task_count);
 	SET_FIELD(sequence_count);
 	SET_FIELD(buf_count);
+	SET_FIELD(batch_count);
 
 #undef SET_FIELD
 
 	/* Do not remove this statement, you should always update this statement when you adding a new field,
 	 * and do not forget to add the SET_FIELD statement for your added field. */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_accel_opts) == 28, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_accel_opts) == 32, "Incorrect size");
+}
+
+int
+accel_set_route_opts(const struct accel_route_opts *opts)
+{
+	if (opts->routing && opts->sw_max_size == 0 && opts->max_queue_depth == 0) {
+		SPDK_ERRLOG("Routing requires either sw_max_size or max_queue_depth to be set\n");
+		return -EINVAL;
+	}
+
+	g_route_opts = *opts;
+	g_route_tracking = opts->telemetry || opts->routing;
+
+	return 0;
+}
+
+void
+accel_get_route_opts(struct accel_route_opts *opts)
+{
+	*opts = g_route_opts;
 }
 
 struct accel_get_stats_ctx {
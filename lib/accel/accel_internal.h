@@ -12,6 +12,7 @@
 #include "spdk/accel.h"
 #include "spdk/queue.h"
 #include "spdk/config.h"
+#include "spdk/cpuset.h"
 
 #define ACCEL_AES_XTS "AES_XTS"
 
@@ -28,10 +29,44 @@ struct accel_operation_stats {
 	uint64_t num_bytes;
 };
 
+#define ACCEL_ROUTE_LATENCY_BUCKETS 32
+
+enum accel_route {
+	/* Module assigned to execute a given opcode */
+	ACCEL_ROUTE_MODULE,
+	/* Software module, selected by the routing policy */
+	ACCEL_ROUTE_SW,
+	ACCEL_ROUTE_COUNT,
+};
+
+struct accel_route_stats {
+	uint64_t executed;
+	uint64_t queue_depth;
+	uint64_t max_queue_depth;
+	uint64_t latency_ticks;
+	uint64_t max_latency_ticks;
+	/* log2 histogram of the latency in ticks */
+	uint64_t latency_histogram[ACCEL_ROUTE_LATENCY_BUCKETS];
+};
+
+struct accel_opcode_route_stats {
+	struct accel_route_stats	routes[ACCEL_ROUTE_COUNT];
+	struct {
+		/* Executed by the assigned module */
+		uint64_t module;
+		/* Executed in software due to their size */
+		uint64_t size;
+		/* Executed in software due to the assigned module's queue depth */
+		uint64_t backlog;
+	} decisions;
+};
+
 struct accel_stats {
 	struct accel_operation_stats	operations[SPDK_ACCEL_OPC_LAST];
+	struct accel_opcode_route_stats	routing[SPDK_ACCEL_OPC_LAST];
 	uint64_t			sequence_executed;
 	uint64_t			sequence_failed;
+	uint64_t			sequence_fused;
 
 	struct {
 		uint64_t task;
@@ -48,4 +83,32 @@ void _accel_crypto_keys_dump_param(struct spdk_json_write_ctx *w);
 typedef void (*accel_get_stats_cb)(struct accel_stats *stats, void *cb_arg);
 int accel_get_stats(accel_get_stats_cb cb_fn, void *cb_arg);
 
+struct accel_route_opts {
+	/* Track the latency of the operations executed by each module */
+	bool		telemetry;
+	/* Allow executing operations in software instead of the assigned module */
+	bool		routing;
+	/* Operations of at most this many bytes are executed in software, 0 to disable */
+	uint32_t	sw_max_size;
+	/* Operations are executed in software once the assigned module has this many operations
+	 * outstanding on a channel, 0 to disable */
+	uint32_t	max_queue_depth;
+};
+
+int accel_set_route_opts(const struct accel_route_opts *opts);
+void accel_get_route_opts(struct accel_route_opts *opts);
+
+struct accel_sw_opts {
+	/* Number of helper threads executing large tasks of the software module, 0 to disable */
+	uint32_t		helper_threads;
+	/* Tasks of at least this many bytes are executed by the helper threads */
+	uint32_t		offload_threshold;
+	/* CPUs the helper threads are allowed to run on, empty for no restriction */
+	struct spdk_cpuset	helper_cpumask;
+};
+
+int accel_sw_set_opts(const struct accel_sw_opts *opts);
+void accel_sw_get_opts(struct accel_sw_opts *opts);
+void accel_sw_write_helper_stats(struct spdk_json_write_ctx *w);
+
 #endif
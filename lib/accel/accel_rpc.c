@@ -361,6 +361,7 @@ struct rpc_accel_opts {
 	uint32_t	task_count;
 	uint32_t	sequence_count;
 	uint32_t	buf_count;
+	uint32_t	batch_count;
 };
 
 static const struct spdk_json_object_decoder rpc_accel_set_options_decoders[] = {
@@ -369,6 +370,7 @@ static const struct spdk_json_object_decoder rpc_accel_set_options_decoders[] =
 	{"task_count", offsetof(struct rpc_accel_opts, task_count), spdk_json_decode_uint32, true},
 	{"sequence_count", offsetof(struct rpc_accel_opts, sequence_count), spdk_json_decode_uint32, true},
 	{"buf_count", offsetof(struct rpc_accel_opts, buf_count), spdk_json_decode_uint32, true},
+	{"batch_count", offsetof(struct rpc_accel_opts, batch_count), spdk_json_decode_uint32, true},
 };
 
 static void
@@ -386,6 +388,7 @@ rpc_accel_set_options(struct spdk_jsonrpc_request *request, const struct spdk_js
 	rpc_opts.task_count = opts.task_count;
 	rpc_opts.sequence_count = opts.sequence_count;
 	rpc_opts.buf_count = opts.buf_count;
+	rpc_opts.batch_count = opts.batch_count;
 
 	if (spdk_json_decode_object(params, rpc_accel_set_options_decoders,
 				    SPDK_COUNTOF(rpc_accel_set_options_decoders), &rpc_opts)) {
@@ -399,6 +402,7 @@ rpc_accel_set_options(struct spdk_jsonrpc_request *request, const struct spdk_js
 	opts.task_count = rpc_opts.task_count;
 	opts.sequence_count = rpc_opts.sequence_count;
 	opts.buf_count = rpc_opts.buf_count;
+	opts.batch_count = rpc_opts.batch_count;
 
 	rc = spdk_accel_set_opts(&opts);
 	if (rc != 0) {
@@ -410,6 +414,59 @@ rpc_accel_set_options(struct spdk_jsonrpc_request *request, const struct spdk_js
 }
 SPDK_RPC_REGISTER("accel_set_options", rpc_accel_set_options, SPDK_RPC_STARTUP)
 
+struct rpc_accel_sw_opts {
+	uint32_t	helper_threads;
+	uint32_t	offload_threshold;
+	char		*helper_cpumask;
+};
+
+static const struct spdk_json_object_decoder rpc_accel_sw_set_options_decoders[] = {
+	{"helper_threads", offsetof(struct rpc_accel_sw_opts, helper_threads), spdk_json_decode_uint32, true},
+	{"offload_threshold", offsetof(struct rpc_accel_sw_opts, offload_threshold), spdk_json_decode_uint32, true},
+	{"helper_cpumask", offsetof(struct rpc_accel_sw_opts, helper_cpumask), spdk_json_decode_string, true},
+};
+
+static void
+rpc_accel_sw_set_options(struct spdk_jsonrpc_request *request, const struct spdk_json_val *params)
+{
+	struct rpc_accel_sw_opts rpc_opts = {};
+	struct accel_sw_opts opts;
+	int rc;
+
+	accel_sw_get_opts(&opts);
+	rpc_opts.helper_threads = opts.helper_threads;
+	rpc_opts.offload_threshold = opts.offload_threshold;
+
+	if (spdk_json_decode_object(params, rpc_accel_sw_set_options_decoders,
+				    SPDK_COUNTOF(rpc_accel_sw_set_options_decoders), &rpc_opts)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_PARSE_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	opts.helper_threads = rpc_opts.helper_threads;
+	opts.offload_threshold = rpc_opts.offload_threshold;
+	if (rpc_opts.helper_cpumask != NULL) {
+		rc = spdk_cpuset_parse(&opts.helper_cpumask, rpc_opts.helper_cpumask);
+		if (rc != 0) {
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+							 "Invalid helper_cpumask");
+			goto cleanup;
+		}
+	}
+
+	rc = accel_sw_set_opts(&opts);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+cleanup:
+	free(rpc_opts.helper_cpumask);
+}
+SPDK_RPC_REGISTER("accel_sw_set_options", rpc_accel_sw_set_options, SPDK_RPC_STARTUP)
+
 static void
 rpc_accel_get_stats_done(struct accel_stats *stats, void *cb_arg)
 {
@@ -423,6 +480,7 @@ rpc_accel_get_stats_done(struct accel_stats *stats, void *cb_arg)
 
 	spdk_json_write_named_uint64(w, "sequence_executed", stats->sequence_executed);
 	spdk_json_write_named_uint64(w, "sequence_failed", stats->sequence_failed);
+	spdk_json_write_named_uint64(w, "sequence_fused", stats->sequence_fused);
 	spdk_json_write_named_array_begin(w, "operations");
 	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
 		if (stats->operations[i].executed + stats->operations[i].failed == 0) {
@@ -446,6 +504,7 @@ rpc_accel_get_stats_done(struct accel_stats *stats, void *cb_arg)
 	spdk_json_write_named_uint64(w, "retry_sequence", stats->retry.sequence);
 	spdk_json_write_named_uint64(w, "retry_iobuf", stats->retry.iobuf);
 	spdk_json_write_named_uint64(w, "retry_bufdesc", stats->retry.bufdesc);
+	accel_sw_write_helper_stats(w);
 
 	spdk_json_write_object_end(w);
 	spdk_jsonrpc_end_result(request, w);
@@ -462,3 +521,128 @@ rpc_accel_get_stats(struct spdk_jsonrpc_request *request, const struct spdk_json
 	}
 }
 SPDK_RPC_REGISTER("accel_get_stats", rpc_accel_get_stats, SPDK_RPC_RUNTIME)
+
+static const struct spdk_json_object_decoder rpc_accel_set_route_policy_decoders[] = {
+	{"telemetry", offsetof(struct accel_route_opts, telemetry), spdk_json_decode_bool, true},
+	{"routing", offsetof(struct accel_route_opts, routing), spdk_json_decode_bool, true},
+	{"sw_max_size", offsetof(struct accel_route_opts, sw_max_size), spdk_json_decode_uint32, true},
+	{"max_queue_depth", offsetof(struct accel_route_opts, max_queue_depth), spdk_json_decode_uint32, true},
+};
+
+static void
+rpc_accel_set_route_policy(struct spdk_jsonrpc_request *request,
+			   const struct spdk_json_val *params)
+{
+	struct accel_route_opts opts;
+	int rc;
+
+	accel_get_route_opts(&opts);
+	if (params != NULL &&
+	    spdk_json_decode_object(params, rpc_accel_set_route_policy_decoders,
+				    SPDK_COUNTOF(rpc_accel_set_route_policy_decoders), &opts)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_PARSE_ERROR,
+						 "spdk_json_decode_object failed");
+		return;
+	}
+
+	rc = accel_set_route_opts(&opts);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("accel_set_route_policy", rpc_accel_set_route_policy,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
+static void
+rpc_accel_write_route_stats(struct spdk_json_write_ctx *w, const char *name,
+			    const char *module_name, struct accel_route_stats *stats)
+{
+	int i, last_bucket;
+
+	/* Skip the trailing empty buckets of the histogram */
+	for (last_bucket = ACCEL_ROUTE_LATENCY_BUCKETS - 1; last_bucket >= 0; last_bucket--) {
+		if (stats->latency_histogram[last_bucket] != 0) {
+			break;
+		}
+	}
+
+	spdk_json_write_named_object_begin(w, name);
+	spdk_json_write_named_string(w, "module_name", module_name);
+	spdk_json_write_named_uint64(w, "executed", stats->executed);
+	spdk_json_write_named_uint64(w, "queue_depth", stats->queue_depth);
+	spdk_json_write_named_uint64(w, "max_queue_depth", stats->max_queue_depth);
+	spdk_json_write_named_uint64(w, "latency_ticks", stats->latency_ticks);
+	spdk_json_write_named_uint64(w, "max_latency_ticks", stats->max_latency_ticks);
+	spdk_json_write_named_array_begin(w, "latency_ticks_histogram");
+	for (i = 0; i <= last_bucket; i++) {
+		spdk_json_write_uint64(w, stats->latency_histogram[i]);
+	}
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+}
+
+static void
+rpc_accel_get_route_stats_done(struct accel_stats *stats, void *cb_arg)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+	struct accel_opcode_route_stats *route;
+	struct spdk_json_write_ctx *w;
+	struct accel_route_opts opts;
+	const char *module_name;
+	int i, rc;
+
+	accel_get_route_opts(&opts);
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_bool(w, "telemetry", opts.telemetry);
+	spdk_json_write_named_bool(w, "routing", opts.routing);
+	spdk_json_write_named_uint64(w, "tick_rate", spdk_get_ticks_hz());
+	spdk_json_write_named_array_begin(w, "operations");
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		route = &stats->routing[i];
+		if (route->decisions.module + route->decisions.size +
+		    route->decisions.backlog == 0) {
+			continue;
+		}
+		rc = spdk_accel_get_opc_module_name(i, &module_name);
+		if (rc) {
+			continue;
+		}
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "opcode", spdk_accel_get_opcode_name(i));
+		spdk_json_write_named_object_begin(w, "decisions");
+		spdk_json_write_named_uint64(w, "module", route->decisions.module);
+		spdk_json_write_named_uint64(w, "size", route->decisions.size);
+		spdk_json_write_named_uint64(w, "backlog", route->decisions.backlog);
+		spdk_json_write_object_end(w);
+		rpc_accel_write_route_stats(w, "module", module_name,
+					    &route->routes[ACCEL_ROUTE_MODULE]);
+		if (route->decisions.size + route->decisions.backlog > 0) {
+			rpc_accel_write_route_stats(w, "software", "software",
+						    &route->routes[ACCEL_ROUTE_SW]);
+		}
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+static void
+rpc_accel_get_route_stats(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	int rc;
+
+	rc = accel_get_stats(rpc_accel_get_route_stats_done, request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+	}
+}
+SPDK_RPC_REGISTER("accel_get_route_stats", rpc_accel_get_route_stats, SPDK_RPC_RUNTIME)
@@ -14,10 +14,15 @@
 #include "spdk/log.h"
 #include "spdk/thread.h"
 #include "spdk/json.h"
+#include "spdk/cpuset.h"
 #include "spdk/crc32.h"
 #include "spdk/util.h"
 #include "spdk/xor.h"
 #include "spdk/dif.h"
+#include "spdk/endian.h"
+#include "spdk/sha256.h"
+#include "spdk/string.h"
+#include "spdk/xxhash.h"
 
 #ifdef SPDK_CONFIG_ISAL
 #include "../isa-l/include/igzip_lib.h"
@@ -26,19 +31,100 @@
 #endif
 #endif
 
+#ifdef SPDK_CONFIG_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+#ifdef SPDK_CONFIG_ZSTD
+#include <zstd.h>
+#endif
+
 /* Per the AES-XTS spec, the size of data unit cannot be bigger than 2^20 blocks, 128b each block */
 #define ACCEL_AES_XTS_MAX_BLOCK_SIZE (1 << 24)
 
-struct sw_accel_io_channel {
+#define SW_ACCEL_DEFAULT_OFFLOAD_THRESHOLD	(32 * 1024)
+#define SW_ACCEL_MAX_HELPER_THREADS		64
+#define SW_ACCEL_HELPER_RING_SIZE		4096
+#define SW_ACCEL_HELPER_BATCH_SIZE		32
+/* Number of empty polls after which an idle helper thread starts sleeping */
+#define SW_ACCEL_HELPER_IDLE_POLLS		1000
+#define SW_ACCEL_HELPER_IDLE_SLEEP_US		10
+/* Size of the chunks processed by fused operations, chosen to stay within L1 cache */
+#define SW_ACCEL_FUSED_CHUNK_SIZE		4096
+
+/* Contiguous copy of scattered data, for algorithms operating on flat buffers */
+struct sw_accel_flat_buf {
+	void				*buf;
+	size_t				size;
+};
+
+/* State needed to execute tasks, owned either by an IO channel or by a helper thread */
+struct sw_accel_exec_ctx {
 	/* for ISAL */
 #ifdef SPDK_CONFIG_ISAL
 	struct isal_zstream		stream;
 	struct inflate_state		state;
 #endif
-	struct spdk_poller		*completion_poller;
-	STAILQ_HEAD(, spdk_accel_task)	tasks_to_complete;
+#ifdef SPDK_CONFIG_LZ4
+	void				*lz4_state;
+	void				*lz4hc_state;
+	struct sw_accel_flat_buf	lz4_src;
+	struct sw_accel_flat_buf	lz4_dst;
+#endif
+#ifdef SPDK_CONFIG_ZSTD
+	ZSTD_CCtx			*zstd_cctx;
+	ZSTD_DCtx			*zstd_dctx;
+#endif
+};
+
+/*
+ * Tasks a channel handed over to the helper threads.  Allocated separately from the channel, so
+ * that it can outlive the channel until the helpers are done with it.
+ */
+struct sw_accel_helper_completions {
+	/* Tasks completed by the helper threads */
+	struct spdk_ring		*ring;
+	uint32_t			outstanding;
+	/* Drains the ring after the channel is destroyed */
+	struct spdk_poller		*drain_poller;
+};
+
+struct sw_accel_io_channel {
+	struct sw_accel_exec_ctx		exec;
+	struct spdk_poller			*completion_poller;
+	STAILQ_HEAD(, spdk_accel_task)		tasks_to_complete;
+	struct sw_accel_helper_completions	*helper_completions;
+};
+
+struct sw_accel_task {
+	struct spdk_accel_task			task;
+	struct sw_accel_helper_completions	*completions;
+};
+
+struct sw_accel_helper {
+	pthread_t			thread;
+	uint32_t			id;
+	struct sw_accel_exec_ctx	exec;
+	uint64_t			start_tsc;
+	/* Updated by the helper thread only */
+	uint64_t			tasks_executed;
+	uint64_t			busy_tsc;
+};
+
+static struct accel_sw_opts g_sw_opts = {
+	.helper_threads = 0,
+	.offload_threshold = SW_ACCEL_DEFAULT_OFFLOAD_THRESHOLD,
 };
 
+static struct {
+	struct sw_accel_helper		*helpers;
+	uint32_t			num_helpers;
+	/* Tasks waiting to be picked up by the helper threads */
+	struct spdk_ring		*submissions;
+	bool				stop;
+} g_sw_helpers;
+
 typedef void (*sw_accel_crypto_op)(uint8_t *k2, uint8_t *k1, uint8_t *tweak, uint64_t lba_size,
 				   const uint8_t *src, uint8_t *dst);
 
@@ -81,6 +167,8 @@ sw_accel_supports_opcode(enum spdk_accel_opcode opc)
 	case SPDK_ACCEL_OPC_DIF_GENERATE:
 	case SPDK_ACCEL_OPC_DIF_GENERATE_COPY:
 	case SPDK_ACCEL_OPC_DIF_VERIFY_COPY:
+	case SPDK_ACCEL_OPC_HASH:
+	case SPDK_ACCEL_OPC_PQ_GEN:
 		return true;
 	default:
 		return false;
@@ -111,16 +199,7 @@ static void
 _sw_accel_copy_iovs(struct iovec *dst_iovs, uint32_t dst_iovcnt,
 		    struct iovec *src_iovs, uint32_t src_iovcnt)
 {
-	struct spdk_ioviter iter;
-	void *src, *dst;
-	size_t len;
-
-	for (len = spdk_ioviter_first(&iter, src_iovs, src_iovcnt,
-				      dst_iovs, dst_iovcnt, &src, &dst);
-	     len != 0;
-	     len = spdk_ioviter_next(&iter, &src, &dst)) {
-		memcpy(dst, src, len);
-	}
+	spdk_iovcpy_nt(src_iovs, src_iovcnt, dst_iovs, dst_iovcnt);
 }
 
 static int
@@ -162,8 +241,33 @@ _sw_accel_crc32cv(uint32_t *crc_dst, struct iovec *iov, uint32_t iovcnt, uint32_
 	*crc_dst = spdk_crc32c_iov_update(iov, iovcnt, ~seed);
 }
 
+static void
+_sw_accel_copy_crc32cv(uint32_t *crc_dst, struct iovec *dst_iovs, uint32_t dst_iovcnt,
+		       struct iovec *src_iovs, uint32_t src_iovcnt, uint32_t seed)
+{
+	struct spdk_ioviter iter;
+	void *src, *dst;
+	size_t len, chunk, offset;
+	uint32_t crc = ~seed;
+
+	/* Calculate the crc of each chunk right after copying it, while it's still in cache,
+	 * instead of walking the whole buffer twice */
+	for (len = spdk_ioviter_first(&iter, src_iovs, src_iovcnt,
+				      dst_iovs, dst_iovcnt, &src, &dst);
+	     len != 0;
+	     len = spdk_ioviter_next(&iter, &src, &dst)) {
+		for (offset = 0; offset < len; offset += chunk) {
+			chunk = spdk_min(len - offset, SW_ACCEL_FUSED_CHUNK_SIZE);
+			memcpy((uint8_t *)dst + offset, (uint8_t *)src + offset, chunk);
+			crc = spdk_crc32c_update((uint8_t *)src + offset, chunk, crc);
+		}
+	}
+
+	*crc_dst = crc;
+}
+
 static int
-_sw_accel_compress(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+_sw_accel_compress_deflate(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
 {
 #ifdef SPDK_CONFIG_ISAL
 	size_t last_seglen = accel_task->s.iovs[accel_task->s.iovcnt - 1].iov_len;
@@ -178,27 +282,28 @@ _sw_accel_compress(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *ac
 		remaining += accel_task->s.iovs[i].iov_len;
 	}
 
-	isal_deflate_reset(&sw_ch->stream);
-	sw_ch->stream.end_of_stream = 0;
-	sw_ch->stream.next_out = diov[d].iov_base;
-	sw_ch->stream.avail_out = diov[d].iov_len;
-	sw_ch->stream.next_in = siov[s].iov_base;
-	sw_ch->stream.avail_in = siov[s].iov_len;
+	isal_deflate_reset(&ctx->stream);
+	ctx->stream.level = accel_task->comp.level;
+	ctx->stream.end_of_stream = 0;
+	ctx->stream.next_out = diov[d].iov_base;
+	ctx->stream.avail_out = diov[d].iov_len;
+	ctx->stream.next_in = siov[s].iov_base;
+	ctx->stream.avail_in = siov[s].iov_len;
 
 	do {
 		/* if isal has exhausted the current dst iovec, move to the next
 		 * one if there is one */
-		if (sw_ch->stream.avail_out == 0) {
+		if (ctx->stream.avail_out == 0) {
 			if (++d < accel_task->d.iovcnt) {
-				sw_ch->stream.next_out = diov[d].iov_base;
-				sw_ch->stream.avail_out = diov[d].iov_len;
-				assert(sw_ch->stream.avail_out > 0);
+				ctx->stream.next_out = diov[d].iov_base;
+				ctx->stream.avail_out = diov[d].iov_len;
+				assert(ctx->stream.avail_out > 0);
 			} else {
 				/* we have no avail_out but also no more iovecs left so this is
 				* the case where either the output buffer was a perfect fit
 				* or not enough was provided.  Check the ISAL state to determine
 				* which. */
-				if (sw_ch->stream.internal_state.state != ZSTATE_END) {
+				if (ctx->stream.internal_state.state != ZSTATE_END) {
 					SPDK_ERRLOG("Not enough destination buffer provided.\n");
 					rc = -ENOMEM;
 				}
@@ -208,35 +313,35 @@ _sw_accel_compress(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *ac
 
 		/* if isal has exhausted the current src iovec, move to the next
 		 * one if there is one */
-		if (sw_ch->stream.avail_in == 0 && ((s + 1) < accel_task->s.iovcnt)) {
+		if (ctx->stream.avail_in == 0 && ((s + 1) < accel_task->s.iovcnt)) {
 			s++;
-			sw_ch->stream.next_in = siov[s].iov_base;
-			sw_ch->stream.avail_in = siov[s].iov_len;
-			assert(sw_ch->stream.avail_in > 0);
+			ctx->stream.next_in = siov[s].iov_base;
+			ctx->stream.avail_in = siov[s].iov_len;
+			assert(ctx->stream.avail_in > 0);
 		}
 
 		if (remaining <= last_seglen) {
 			/* Need to set end of stream on last block */
-			sw_ch->stream.end_of_stream = 1;
+			ctx->stream.end_of_stream = 1;
 		}
 
-		rc = isal_deflate(&sw_ch->stream);
+		rc = isal_deflate(&ctx->stream);
 		if (rc) {
 			SPDK_ERRLOG("isal_deflate returned error %d.\n", rc);
 		}
 
 		if (remaining > 0) {
-			assert(siov[s].iov_len > sw_ch->stream.avail_in);
-			remaining -= (siov[s].iov_len - sw_ch->stream.avail_in);
+			assert(siov[s].iov_len > ctx->stream.avail_in);
+			remaining -= (siov[s].iov_len - ctx->stream.avail_in);
 		}
 
-	} while (remaining > 0 || sw_ch->stream.avail_out == 0);
-	assert(sw_ch->stream.avail_in  == 0);
+	} while (remaining > 0 || ctx->stream.avail_out == 0);
+	assert(ctx->stream.avail_in  == 0);
 
 	/* Get our total output size */
 	if (accel_task->output_size != NULL) {
-		assert(sw_ch->stream.total_out > 0);
-		*accel_task->output_size = sw_ch->stream.total_out;
+		assert(ctx->stream.total_out > 0);
+		*accel_task->output_size = ctx->stream.total_out;
 	}
 
 	return rc;
@@ -247,7 +352,7 @@ _sw_accel_compress(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *ac
 }
 
 static int
-_sw_accel_decompress(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+_sw_accel_decompress_deflate(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
 {
 #ifdef SPDK_CONFIG_ISAL
 	struct iovec *siov = accel_task->s.iovs;
@@ -255,43 +360,43 @@ _sw_accel_decompress(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *
 	uint32_t s = 0, d = 0;
 	int rc = 0;
 
-	isal_inflate_reset(&sw_ch->state);
-	sw_ch->state.next_out = diov[d].iov_base;
-	sw_ch->state.avail_out = diov[d].iov_len;
-	sw_ch->state.next_in = siov[s].iov_base;
-	sw_ch->state.avail_in = siov[s].iov_len;
+	isal_inflate_reset(&ctx->state);
+	ctx->state.next_out = diov[d].iov_base;
+	ctx->state.avail_out = diov[d].iov_len;
+	ctx->state.next_in = siov[s].iov_base;
+	ctx->state.avail_in = siov[s].iov_len;
 
 	do {
 		/* if isal has exhausted the current dst iovec, move to the next
 		 * one if there is one */
-		if (sw_ch->state.avail_out == 0 && ((d + 1) < accel_task->d.iovcnt)) {
+		if (ctx->state.avail_out == 0 && ((d + 1) < accel_task->d.iovcnt)) {
 			d++;
-			sw_ch->state.next_out = diov[d].iov_base;
-			sw_ch->state.avail_out = diov[d].iov_len;
-			assert(sw_ch->state.avail_out > 0);
+			ctx->state.next_out = diov[d].iov_base;
+			ctx->state.avail_out = diov[d].iov_len;
+			assert(ctx->state.avail_out > 0);
 		}
 
 		/* if isal has exhausted the current src iovec, move to the next
 		 * one if there is one */
-		if (sw_ch->state.avail_in == 0 && ((s + 1) < accel_task->s.iovcnt)) {
+		if (ctx->state.avail_in == 0 && ((s + 1) < accel_task->s.iovcnt)) {
 			s++;
-			sw_ch->state.next_in = siov[s].iov_base;
-			sw_ch->state.avail_in = siov[s].iov_len;
-			assert(sw_ch->state.avail_in > 0);
+			ctx->state.next_in = siov[s].iov_base;
+			ctx->state.avail_in = siov[s].iov_len;
+			assert(ctx->state.avail_in > 0);
 		}
 
-		rc = isal_inflate(&sw_ch->state);
+		rc = isal_inflate(&ctx->state);
 		if (rc) {
 			SPDK_ERRLOG("isal_inflate returned error %d.\n", rc);
 		}
 
-	} while (sw_ch->state.block_state < ISAL_BLOCK_FINISH);
-	assert(sw_ch->state.avail_in == 0);
+	} while (ctx->state.block_state < ISAL_BLOCK_FINISH);
+	assert(ctx->state.avail_in == 0);
 
 	/* Get our total output size */
 	if (accel_task->output_size != NULL) {
-		assert(sw_ch->state.total_out > 0);
-		*accel_task->output_size = sw_ch->state.total_out;
+		assert(ctx->state.total_out > 0);
+		*accel_task->output_size = ctx->state.total_out;
 	}
 
 	return rc;
@@ -301,6 +406,301 @@ _sw_accel_decompress(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *
 #endif
 }
 
+#if defined(SPDK_CONFIG_LZ4) || defined(SPDK_CONFIG_ZSTD)
+static inline size_t
+_sw_accel_get_iovlen(struct iovec *iovs, uint32_t iovcnt)
+{
+	size_t result = 0;
+	uint32_t i;
+
+	for (i = 0; i < iovcnt; i++) {
+		result += iovs[i].iov_len;
+	}
+
+	return result;
+}
+#endif
+
+#ifdef SPDK_CONFIG_LZ4
+static void *
+_sw_accel_flat_buf_get(struct sw_accel_flat_buf *fbuf, size_t size)
+{
+	void *buf;
+
+	if (fbuf->size < size) {
+		buf = realloc(fbuf->buf, size);
+		if (buf == NULL) {
+			return NULL;
+		}
+
+		fbuf->buf = buf;
+		fbuf->size = size;
+	}
+
+	return fbuf->buf;
+}
+
+/* Returns a contiguous view of the data described by iovs, copying it if needed */
+static void *
+_sw_accel_flatten_src(struct sw_accel_flat_buf *fbuf, struct iovec *iovs, uint32_t iovcnt,
+		      size_t len)
+{
+	void *buf;
+
+	if (iovcnt == 1) {
+		return iovs[0].iov_base;
+	}
+
+	buf = _sw_accel_flat_buf_get(fbuf, len);
+	if (buf != NULL) {
+		spdk_copy_iovs_to_buf(buf, len, iovs, iovcnt);
+	}
+
+	return buf;
+}
+
+/* Returns a contiguous buffer for the output, which needs to be copied to iovs afterwards if it
+ * isn't iovs[0] */
+static void *
+_sw_accel_flatten_dst(struct sw_accel_flat_buf *fbuf, struct iovec *iovs, uint32_t iovcnt,
+		      size_t len)
+{
+	if (iovcnt == 1) {
+		return iovs[0].iov_base;
+	}
+
+	return _sw_accel_flat_buf_get(fbuf, len);
+}
+
+/* Data is compressed into a single LZ4 block, without a frame, so decompression requires the
+ * exact size of the compressed data as input. */
+static int
+_sw_accel_compress_lz4(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
+{
+	size_t src_len = _sw_accel_get_iovlen(accel_task->s.iovs, accel_task->s.iovcnt);
+	size_t dst_len = _sw_accel_get_iovlen(accel_task->d.iovs, accel_task->d.iovcnt);
+	char *src, *dst;
+	int rc;
+
+	if (spdk_unlikely(src_len > LZ4_MAX_INPUT_SIZE || dst_len > INT_MAX)) {
+		return -EINVAL;
+	}
+
+	src = _sw_accel_flatten_src(&ctx->lz4_src, accel_task->s.iovs, accel_task->s.iovcnt, src_len);
+	dst = _sw_accel_flatten_dst(&ctx->lz4_dst, accel_task->d.iovs, accel_task->d.iovcnt, dst_len);
+	if (spdk_unlikely(src == NULL || dst == NULL)) {
+		return -ENOMEM;
+	}
+
+	if (accel_task->comp.level <= 1) {
+		rc = LZ4_compress_fast_extState(ctx->lz4_state, src, dst, src_len, dst_len, 1);
+	} else {
+		rc = LZ4_compress_HC_extStateHC(ctx->lz4hc_state, src, dst, src_len, dst_len,
+						accel_task->comp.level);
+	}
+
+	if (rc == 0) {
+		SPDK_ERRLOG("Not enough destination buffer provided.\n");
+		return -ENOMEM;
+	}
+
+	if (dst != accel_task->d.iovs[0].iov_base) {
+		spdk_copy_buf_to_iovs(accel_task->d.iovs, accel_task->d.iovcnt, dst, rc);
+	}
+
+	if (accel_task->output_size != NULL) {
+		*accel_task->output_size = rc;
+	}
+
+	return 0;
+}
+
+static int
+_sw_accel_decompress_lz4(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
+{
+	size_t src_len = _sw_accel_get_iovlen(accel_task->s.iovs, accel_task->s.iovcnt);
+	size_t dst_len = _sw_accel_get_iovlen(accel_task->d.iovs, accel_task->d.iovcnt);
+	char *src, *dst;
+	int rc;
+
+	if (spdk_unlikely(src_len > INT_MAX || dst_len > INT_MAX)) {
+		return -EINVAL;
+	}
+
+	src = _sw_accel_flatten_src(&ctx->lz4_src, accel_task->s.iovs, accel_task->s.iovcnt, src_len);
+	dst = _sw_accel_flatten_dst(&ctx->lz4_dst, accel_task->d.iovs, accel_task->d.iovcnt, dst_len);
+	if (spdk_unlikely(src == NULL || dst == NULL)) {
+		return -ENOMEM;
+	}
+
+	rc = LZ4_decompress_safe(src, dst, src_len, dst_len);
+	if (rc < 0) {
+		SPDK_ERRLOG("LZ4_decompress_safe returned error %d.\n", rc);
+		return -EINVAL;
+	}
+
+	if (dst != accel_task->d.iovs[0].iov_base) {
+		spdk_copy_buf_to_iovs(accel_task->d.iovs, accel_task->d.iovcnt, dst, rc);
+	}
+
+	if (accel_task->output_size != NULL) {
+		*accel_task->output_size = rc;
+	}
+
+	return 0;
+}
+#endif
+
+#ifdef SPDK_CONFIG_ZSTD
+static int
+_sw_accel_compress_zstd(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
+{
+	struct iovec *siov = accel_task->s.iovs;
+	struct iovec *diov = accel_task->d.iovs;
+	ZSTD_inBuffer in = { .src = siov[0].iov_base, .size = siov[0].iov_len };
+	ZSTD_outBuffer out = { .dst = diov[0].iov_base, .size = diov[0].iov_len };
+	uint32_t s = 0, d = 0;
+	size_t rc, total = 0;
+
+	ZSTD_CCtx_reset(ctx->zstd_cctx, ZSTD_reset_session_only);
+	ZSTD_CCtx_setParameter(ctx->zstd_cctx, ZSTD_c_compressionLevel, accel_task->comp.level);
+	ZSTD_CCtx_setPledgedSrcSize(ctx->zstd_cctx,
+				    _sw_accel_get_iovlen(accel_task->s.iovs, accel_task->s.iovcnt));
+
+	while (true) {
+		rc = ZSTD_compressStream2(ctx->zstd_cctx, &out, &in,
+					  s + 1 < accel_task->s.iovcnt ? ZSTD_e_continue : ZSTD_e_end);
+		if (ZSTD_isError(rc)) {
+			SPDK_ERRLOG("ZSTD_compressStream2 returned error: %s.\n", ZSTD_getErrorName(rc));
+			return -EINVAL;
+		}
+
+		if (in.pos == in.size && s + 1 < accel_task->s.iovcnt) {
+			s++;
+			in.src = siov[s].iov_base;
+			in.size = siov[s].iov_len;
+			in.pos = 0;
+		} else if (in.pos == in.size && rc == 0) {
+			/* The whole frame has been flushed */
+			break;
+		}
+
+		if (out.pos == out.size) {
+			total += out.pos;
+			if (++d == accel_task->d.iovcnt) {
+				SPDK_ERRLOG("Not enough destination buffer provided.\n");
+				return -ENOMEM;
+			}
+
+			out.dst = diov[d].iov_base;
+			out.size = diov[d].iov_len;
+			out.pos = 0;
+		}
+	}
+
+	if (accel_task->output_size != NULL) {
+		*accel_task->output_size = total + out.pos;
+	}
+
+	return 0;
+}
+
+static int
+_sw_accel_decompress_zstd(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
+{
+	struct iovec *siov = accel_task->s.iovs;
+	struct iovec *diov = accel_task->d.iovs;
+	ZSTD_inBuffer in = { .src = siov[0].iov_base, .size = siov[0].iov_len };
+	ZSTD_outBuffer out = { .dst = diov[0].iov_base, .size = diov[0].iov_len };
+	uint32_t s = 0, d = 0;
+	size_t rc, total = 0;
+
+	ZSTD_DCtx_reset(ctx->zstd_dctx, ZSTD_reset_session_only);
+
+	while (true) {
+		rc = ZSTD_decompressStream(ctx->zstd_dctx, &out, &in);
+		if (ZSTD_isError(rc)) {
+			SPDK_ERRLOG("ZSTD_decompressStream returned error: %s.\n", ZSTD_getErrorName(rc));
+			return -EINVAL;
+		}
+
+		if (rc == 0) {
+			/* The frame has been fully decoded */
+			break;
+		}
+
+		if (in.pos == in.size) {
+			if (++s == accel_task->s.iovcnt) {
+				SPDK_ERRLOG("Incomplete zstd frame.\n");
+				return -EINVAL;
+			}
+
+			in.src = siov[s].iov_base;
+			in.size = siov[s].iov_len;
+			in.pos = 0;
+		}
+
+		if (out.pos == out.size) {
+			total += out.pos;
+			if (++d == accel_task->d.iovcnt) {
+				SPDK_ERRLOG("Not enough destination buffer provided.\n");
+				return -ENOMEM;
+			}
+
+			out.dst = diov[d].iov_base;
+			out.size = diov[d].iov_len;
+			out.pos = 0;
+		}
+	}
+
+	if (accel_task->output_size != NULL) {
+		*accel_task->output_size = total + out.pos;
+	}
+
+	return 0;
+}
+#endif
+
+static int
+_sw_accel_compress(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
+{
+	switch (accel_task->comp.algo) {
+	case SPDK_ACCEL_COMP_ALGO_DEFLATE:
+		return _sw_accel_compress_deflate(ctx, accel_task);
+#ifdef SPDK_CONFIG_LZ4
+	case SPDK_ACCEL_COMP_ALGO_LZ4:
+		return _sw_accel_compress_lz4(ctx, accel_task);
+#endif
+#ifdef SPDK_CONFIG_ZSTD
+	case SPDK_ACCEL_COMP_ALGO_ZSTD:
+		return _sw_accel_compress_zstd(ctx, accel_task);
+#endif
+	default:
+		assert(0);
+		return -EINVAL;
+	}
+}
+
+static int
+_sw_accel_decompress(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
+{
+	switch (accel_task->comp.algo) {
+	case SPDK_ACCEL_COMP_ALGO_DEFLATE:
+		return _sw_accel_decompress_deflate(ctx, accel_task);
+#ifdef SPDK_CONFIG_LZ4
+	case SPDK_ACCEL_COMP_ALGO_LZ4:
+		return _sw_accel_decompress_lz4(ctx, accel_task);
+#endif
+#ifdef SPDK_CONFIG_ZSTD
+	case SPDK_ACCEL_COMP_ALGO_ZSTD:
+		return _sw_accel_decompress_zstd(ctx, accel_task);
+#endif
+	default:
+		assert(0);
+		return -EINVAL;
+	}
+}
+
 static int
 _sw_accel_crypto_operation(struct spdk_accel_task *accel_task, struct spdk_accel_crypto_key *key,
 			   sw_accel_crypto_op op)
@@ -399,7 +799,7 @@ _sw_accel_crypto_operation(struct spdk_accel_task *accel_task, struct spdk_accel
 }
 
 static int
-_sw_accel_encrypt(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+_sw_accel_encrypt(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
 {
 	struct spdk_accel_crypto_key *key;
 	struct sw_accel_crypto_key_data *key_data;
@@ -418,7 +818,7 @@ _sw_accel_encrypt(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *acc
 }
 
 static int
-_sw_accel_decrypt(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+_sw_accel_decrypt(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
 {
 	struct spdk_accel_crypto_key *key;
 	struct sw_accel_crypto_key_data *key_data;
@@ -437,7 +837,7 @@ _sw_accel_decrypt(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *acc
 }
 
 static int
-_sw_accel_xor(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+_sw_accel_xor(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
 {
 	return spdk_xor_gen(accel_task->d.iovs[0].iov_base,
 			    accel_task->nsrcs.srcs,
@@ -446,7 +846,17 @@ _sw_accel_xor(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_t
 }
 
 static int
-_sw_accel_dif_verify(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+_sw_accel_pq_gen(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
+{
+	return spdk_xor_gen_pq(accel_task->d.iovs[0].iov_base,
+			       accel_task->d2.iovs[0].iov_base,
+			       accel_task->nsrcs.srcs,
+			       accel_task->nsrcs.cnt,
+			       accel_task->d.iovs[0].iov_len);
+}
+
+static int
+_sw_accel_dif_verify(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
 {
 	return spdk_dif_verify(accel_task->s.iovs,
 			       accel_task->s.iovcnt,
@@ -456,7 +866,7 @@ _sw_accel_dif_verify(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *
 }
 
 static int
-_sw_accel_dif_verify_copy(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+_sw_accel_dif_verify_copy(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
 {
 	return spdk_dif_verify_copy(accel_task->d.iovs,
 				    accel_task->d.iovcnt,
@@ -468,7 +878,7 @@ _sw_accel_dif_verify_copy(struct sw_accel_io_channel *sw_ch, struct spdk_accel_t
 }
 
 static int
-_sw_accel_dif_generate(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+_sw_accel_dif_generate(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
 {
 	return spdk_dif_generate(accel_task->s.iovs,
 				 accel_task->s.iovcnt,
@@ -477,7 +887,7 @@ _sw_accel_dif_generate(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task
 }
 
 static int
-_sw_accel_dif_generate_copy(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+_sw_accel_dif_generate_copy(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
 {
 	return spdk_dif_generate_copy(accel_task->s.iovs,
 				      accel_task->s.iovcnt,
@@ -487,15 +897,447 @@ _sw_accel_dif_generate_copy(struct sw_accel_io_channel *sw_ch, struct spdk_accel
 				      accel_task->dif.ctx);
 }
 
+static int
+_sw_accel_hash(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
+{
+	struct iovec *iovs = accel_task->s.iovs;
+	uint32_t i, iovcnt = accel_task->s.iovcnt;
+
+	switch (accel_task->hash.algo) {
+	case SPDK_ACCEL_HASH_ALGO_XXH64: {
+		struct spdk_xxh64_state state;
+
+		spdk_xxh64_init(&state, 0);
+		for (i = 0; i < iovcnt; i++) {
+			spdk_xxh64_update(&state, iovs[i].iov_base, iovs[i].iov_len);
+		}
+		to_be64(accel_task->digest, spdk_xxh64_digest(&state));
+		return 0;
+	}
+	case SPDK_ACCEL_HASH_ALGO_SHA256: {
+		struct spdk_sha256_ctx sha;
+
+		spdk_sha256_init(&sha);
+		for (i = 0; i < iovcnt; i++) {
+			spdk_sha256_update(&sha, iovs[i].iov_base, iovs[i].iov_len);
+		}
+		spdk_sha256_final(&sha, accel_task->digest);
+		return 0;
+	}
+	default:
+		return -EINVAL;
+	}
+}
+
+static int
+sw_accel_execute_task(struct sw_accel_exec_ctx *ctx, struct spdk_accel_task *accel_task)
+{
+	int rc = 0;
+
+	switch (accel_task->op_code) {
+	case SPDK_ACCEL_OPC_COPY:
+		_sw_accel_copy_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
+				    accel_task->s.iovs, accel_task->s.iovcnt);
+		break;
+	case SPDK_ACCEL_OPC_FILL:
+		rc = _sw_accel_fill(accel_task->d.iovs, accel_task->d.iovcnt,
+				    accel_task->fill_pattern);
+		break;
+	case SPDK_ACCEL_OPC_DUALCAST:
+		rc = _sw_accel_dualcast_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
+					     accel_task->d2.iovs, accel_task->d2.iovcnt,
+					     accel_task->s.iovs, accel_task->s.iovcnt);
+		break;
+	case SPDK_ACCEL_OPC_COMPARE:
+		rc = _sw_accel_compare(accel_task->s.iovs, accel_task->s.iovcnt,
+				       accel_task->s2.iovs, accel_task->s2.iovcnt);
+		break;
+	case SPDK_ACCEL_OPC_CRC32C:
+		_sw_accel_crc32cv(accel_task->crc_dst, accel_task->s.iovs, accel_task->s.iovcnt, accel_task->seed);
+		break;
+	case SPDK_ACCEL_OPC_COPY_CRC32C:
+		_sw_accel_copy_crc32cv(accel_task->crc_dst, accel_task->d.iovs, accel_task->d.iovcnt,
+				       accel_task->s.iovs, accel_task->s.iovcnt, accel_task->seed);
+		break;
+	case SPDK_ACCEL_OPC_COMPRESS:
+		rc = _sw_accel_compress(ctx, accel_task);
+		break;
+	case SPDK_ACCEL_OPC_DECOMPRESS:
+		rc = _sw_accel_decompress(ctx, accel_task);
+		break;
+	case SPDK_ACCEL_OPC_XOR:
+		rc = _sw_accel_xor(ctx, accel_task);
+		break;
+	case SPDK_ACCEL_OPC_PQ_GEN:
+		rc = _sw_accel_pq_gen(ctx, accel_task);
+		break;
+	case SPDK_ACCEL_OPC_ENCRYPT:
+		rc = _sw_accel_encrypt(ctx, accel_task);
+		break;
+	case SPDK_ACCEL_OPC_DECRYPT:
+		rc = _sw_accel_decrypt(ctx, accel_task);
+		break;
+	case SPDK_ACCEL_OPC_DIF_VERIFY:
+		rc = _sw_accel_dif_verify(ctx, accel_task);
+		break;
+	case SPDK_ACCEL_OPC_DIF_VERIFY_COPY:
+		rc = _sw_accel_dif_verify_copy(ctx, accel_task);
+		break;
+	case SPDK_ACCEL_OPC_DIF_GENERATE:
+		rc = _sw_accel_dif_generate(ctx, accel_task);
+		break;
+	case SPDK_ACCEL_OPC_DIF_GENERATE_COPY:
+		rc = _sw_accel_dif_generate_copy(ctx, accel_task);
+		break;
+	case SPDK_ACCEL_OPC_HASH:
+		rc = _sw_accel_hash(ctx, accel_task);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+
+	return rc;
+}
+
+static void sw_accel_exec_ctx_fini(struct sw_accel_exec_ctx *ctx);
+
+static int
+sw_accel_exec_ctx_init(struct sw_accel_exec_ctx *ctx)
+{
+#ifdef SPDK_CONFIG_ISAL
+	isal_deflate_init(&ctx->stream);
+	ctx->stream.flush = NO_FLUSH;
+	ctx->stream.level = 1;
+	/* Big enough for any of the supported levels */
+	ctx->stream.level_buf = calloc(1, ISAL_DEF_LVL3_DEFAULT);
+	if (ctx->stream.level_buf == NULL) {
+		SPDK_ERRLOG("Could not allocate isal internal buffer\n");
+		return -ENOMEM;
+	}
+	ctx->stream.level_buf_size = ISAL_DEF_LVL3_DEFAULT;
+	isal_inflate_init(&ctx->state);
+#endif
+#ifdef SPDK_CONFIG_LZ4
+	ctx->lz4_state = calloc(1, LZ4_sizeofState());
+	ctx->lz4hc_state = calloc(1, LZ4_sizeofStateHC());
+	if (ctx->lz4_state == NULL || ctx->lz4hc_state == NULL) {
+		SPDK_ERRLOG("Could not allocate lz4 state\n");
+		goto err;
+	}
+#endif
+#ifdef SPDK_CONFIG_ZSTD
+	ctx->zstd_cctx = ZSTD_createCCtx();
+	ctx->zstd_dctx = ZSTD_createDCtx();
+	if (ctx->zstd_cctx == NULL || ctx->zstd_dctx == NULL) {
+		SPDK_ERRLOG("Could not allocate zstd contexts\n");
+		goto err;
+	}
+#endif
+
+	return 0;
+#if defined(SPDK_CONFIG_LZ4) || defined(SPDK_CONFIG_ZSTD)
+err:
+	sw_accel_exec_ctx_fini(ctx);
+	return -ENOMEM;
+#endif
+}
+
+static void
+sw_accel_exec_ctx_fini(struct sw_accel_exec_ctx *ctx)
+{
+#ifdef SPDK_CONFIG_ISAL
+	free(ctx->stream.level_buf);
+	ctx->stream.level_buf = NULL;
+#endif
+#ifdef SPDK_CONFIG_LZ4
+	free(ctx->lz4_state);
+	free(ctx->lz4hc_state);
+	free(ctx->lz4_src.buf);
+	free(ctx->lz4_dst.buf);
+	memset(&ctx->lz4_src, 0, sizeof(ctx->lz4_src));
+	memset(&ctx->lz4_dst, 0, sizeof(ctx->lz4_dst));
+	ctx->lz4_state = ctx->lz4hc_state = NULL;
+#endif
+#ifdef SPDK_CONFIG_ZSTD
+	ZSTD_freeCCtx(ctx->zstd_cctx);
+	ZSTD_freeDCtx(ctx->zstd_dctx);
+	ctx->zstd_cctx = NULL;
+	ctx->zstd_dctx = NULL;
+#endif
+}
+
+static int
+sw_accel_helper_set_cpumask(const struct spdk_cpuset *cpumask)
+{
+#ifdef __linux__
+	uint32_t lcore;
+	cpu_set_t mask;
+
+	CPU_ZERO(&mask);
+	for (lcore = 0; lcore < SPDK_CPUSET_SIZE; lcore++) {
+		if (spdk_cpuset_get_cpu(cpumask, lcore)) {
+			CPU_SET(lcore, &mask);
+		}
+	}
+
+	if (sched_setaffinity(0, sizeof(mask), &mask) < 0) {
+		SPDK_ERRLOG("Failed to set software accel helper cpumask (errno=%d)\n", errno);
+		return -errno;
+	}
+
+	return 0;
+#else
+	SPDK_ERRLOG("Software accel helper cpumask is only supported on Linux\n");
+	return -ENOTSUP;
+#endif
+}
+
+static void
+sw_accel_helper_complete(struct sw_accel_task **tasks, uint32_t count)
+{
+	struct sw_accel_helper_completions *completions;
+	uint32_t i, first = 0;
+	size_t rc;
+
+	/* Hand the completions back in batches of consecutive tasks from the same channel */
+	for (i = 1; i <= count; i++) {
+		if (i < count && tasks[i]->completions == tasks[first]->completions) {
+			continue;
+		}
+
+		completions = tasks[first]->completions;
+		/* The ring is big enough to hold all of the channel's outstanding tasks */
+		rc = spdk_ring_enqueue(completions->ring, (void **)&tasks[first], i - first, NULL);
+		assert(rc == i - first);
+		(void)rc;
+		first = i;
+	}
+}
+
+static void *
+sw_accel_helper_run(void *arg)
+{
+	struct sw_accel_helper *helper = arg;
+	struct sw_accel_task *tasks[SW_ACCEL_HELPER_BATCH_SIZE];
+	uint64_t tsc;
+	uint32_t i, count, idle_polls = 0;
+
+	if (spdk_cpuset_count(&g_sw_opts.helper_cpumask) > 0) {
+		sw_accel_helper_set_cpumask(&g_sw_opts.helper_cpumask);
+	}
+
+	while (!__atomic_load_n(&g_sw_helpers.stop, __ATOMIC_ACQUIRE)) {
+		count = spdk_ring_dequeue(g_sw_helpers.submissions, (void **)tasks,
+					  SW_ACCEL_HELPER_BATCH_SIZE);
+		if (count == 0) {
+			if (++idle_polls >= SW_ACCEL_HELPER_IDLE_POLLS) {
+				usleep(SW_ACCEL_HELPER_IDLE_SLEEP_US);
+			} else {
+				spdk_pause();
+			}
+			continue;
+		}
+
+		idle_polls = 0;
+		tsc = spdk_get_ticks();
+		for (i = 0; i < count; i++) {
+			tasks[i]->task.status = sw_accel_execute_task(&helper->exec, &tasks[i]->task);
+		}
+
+		sw_accel_helper_complete(tasks, count);
+
+		helper->busy_tsc += spdk_get_ticks() - tsc;
+		helper->tasks_executed += count;
+	}
+
+	return NULL;
+}
+
+static void
+sw_accel_helpers_stop(void)
+{
+	uint32_t i;
+
+	__atomic_store_n(&g_sw_helpers.stop, true, __ATOMIC_RELEASE);
+	for (i = 0; i < g_sw_helpers.num_helpers; i++) {
+		pthread_join(g_sw_helpers.helpers[i].thread, NULL);
+		sw_accel_exec_ctx_fini(&g_sw_helpers.helpers[i].exec);
+	}
+
+	free(g_sw_helpers.helpers);
+	spdk_ring_free(g_sw_helpers.submissions);
+	memset(&g_sw_helpers, 0, sizeof(g_sw_helpers));
+}
+
+static void *
+_sw_accel_helpers_start(void *ctx)
+{
+	struct sw_accel_helper *helper;
+	uint32_t i;
+	int rc;
+
+	for (i = 0; i < g_sw_opts.helper_threads; i++) {
+		helper = &g_sw_helpers.helpers[i];
+		helper->id = i;
+		helper->start_tsc = spdk_get_ticks();
+
+		rc = sw_accel_exec_ctx_init(&helper->exec);
+		if (rc != 0) {
+			return NULL;
+		}
+
+		rc = pthread_create(&helper->thread, NULL, sw_accel_helper_run, helper);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to create software accel helper thread: %s\n",
+				    spdk_strerror(rc));
+			sw_accel_exec_ctx_fini(&helper->exec);
+			return NULL;
+		}
+
+		g_sw_helpers.num_helpers++;
+	}
+
+	return &g_sw_helpers;
+}
+
+static int
+sw_accel_helpers_start(void)
+{
+	assert(g_sw_helpers.num_helpers == 0);
+
+	g_sw_helpers.helpers = calloc(g_sw_opts.helper_threads, sizeof(*g_sw_helpers.helpers));
+	if (g_sw_helpers.helpers == NULL) {
+		return -ENOMEM;
+	}
+
+	g_sw_helpers.submissions = spdk_ring_create(SPDK_RING_TYPE_MP_MC, SW_ACCEL_HELPER_RING_SIZE,
+				   SPDK_ENV_SOCKET_ID_ANY);
+	if (g_sw_helpers.submissions == NULL) {
+		SPDK_ERRLOG("Failed to create software accel helper ring\n");
+		free(g_sw_helpers.helpers);
+		g_sw_helpers.helpers = NULL;
+		return -ENOMEM;
+	}
+
+	/* Don't let the helpers inherit the affinity of the reactor starting them */
+	if (spdk_call_unaffinitized(_sw_accel_helpers_start, NULL) == NULL) {
+		sw_accel_helpers_stop();
+		return -ENOMEM;
+	}
+
+	SPDK_NOTICELOG("Started %" PRIu32 " software accel helper threads\n", g_sw_helpers.num_helpers);
+
+	return 0;
+}
+
+int
+accel_sw_set_opts(const struct accel_sw_opts *opts)
+{
+	if (g_sw_helpers.num_helpers > 0) {
+		SPDK_ERRLOG("Software accel helper threads are already running\n");
+		return -EBUSY;
+	}
+
+	if (opts->helper_threads > SW_ACCEL_MAX_HELPER_THREADS) {
+		SPDK_ERRLOG("Number of software accel helper threads (%" PRIu32 ") exceeds %d\n",
+			    opts->helper_threads, SW_ACCEL_MAX_HELPER_THREADS);
+		return -EINVAL;
+	}
+
+	g_sw_opts = *opts;
+
+	return 0;
+}
+
+void
+accel_sw_get_opts(struct accel_sw_opts *opts)
+{
+	*opts = g_sw_opts;
+}
+
+void
+accel_sw_write_helper_stats(struct spdk_json_write_ctx *w)
+{
+	struct sw_accel_helper *helper;
+	uint64_t now = spdk_get_ticks();
+	uint32_t i;
+
+	if (g_sw_helpers.num_helpers == 0) {
+		return;
+	}
+
+	spdk_json_write_named_object_begin(w, "sw_helpers");
+	spdk_json_write_named_uint64(w, "tick_rate", spdk_get_ticks_hz());
+	spdk_json_write_named_uint32(w, "offload_threshold", g_sw_opts.offload_threshold);
+	spdk_json_write_named_array_begin(w, "threads");
+	for (i = 0; i < g_sw_helpers.num_helpers; i++) {
+		helper = &g_sw_helpers.helpers[i];
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "id", helper->id);
+		spdk_json_write_named_uint64(w, "tasks_executed", helper->tasks_executed);
+		spdk_json_write_named_uint64(w, "busy", helper->busy_tsc);
+		spdk_json_write_named_uint64(w, "elapsed", now - helper->start_tsc);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+}
+
+static uint32_t
+sw_accel_helper_poll(struct sw_accel_helper_completions *completions)
+{
+	struct sw_accel_task *tasks[SW_ACCEL_HELPER_BATCH_SIZE];
+	uint32_t i, count;
+
+	if (completions == NULL || completions->outstanding == 0) {
+		return 0;
+	}
+
+	count = spdk_ring_dequeue(completions->ring, (void **)tasks, SW_ACCEL_HELPER_BATCH_SIZE);
+	assert(count <= completions->outstanding);
+	completions->outstanding -= count;
+	for (i = 0; i < count; i++) {
+		spdk_accel_task_complete(&tasks[i]->task, tasks[i]->task.status);
+	}
+
+	return count;
+}
+
+static void
+sw_accel_helper_completions_free(struct sw_accel_helper_completions *completions)
+{
+	spdk_ring_free(completions->ring);
+	free(completions);
+}
+
+static int
+sw_accel_helper_drain(void *arg)
+{
+	struct sw_accel_helper_completions *completions = arg;
+	uint32_t count;
+
+	count = sw_accel_helper_poll(completions);
+	if (completions->outstanding == 0) {
+		spdk_poller_unregister(&completions->drain_poller);
+		sw_accel_helper_completions_free(completions);
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
 static int
 accel_comp_poll(void *arg)
 {
 	struct sw_accel_io_channel	*sw_ch = arg;
 	STAILQ_HEAD(, spdk_accel_task)	tasks_to_complete;
 	struct spdk_accel_task		*accel_task;
+	uint32_t			count;
+
+	count = sw_accel_helper_poll(sw_ch->helper_completions);
 
 	if (STAILQ_EMPTY(&sw_ch->tasks_to_complete)) {
-		return SPDK_POLLER_IDLE;
+		return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 	}
 
 	STAILQ_INIT(&tasks_to_complete);
@@ -513,8 +1355,9 @@ static int
 sw_accel_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *accel_task)
 {
 	struct sw_accel_io_channel *sw_ch = spdk_io_channel_get_ctx(ch);
+	struct sw_accel_task *sw_task;
 	struct spdk_accel_task *tmp;
-	int rc = 0;
+	int rc;
 
 	/*
 	 * Lazily initialize our completion poller. We don't want to complete
@@ -525,67 +1368,22 @@ sw_accel_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *accel_
 	}
 
 	do {
-		switch (accel_task->op_code) {
-		case SPDK_ACCEL_OPC_COPY:
-			_sw_accel_copy_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
-					    accel_task->s.iovs, accel_task->s.iovcnt);
-			break;
-		case SPDK_ACCEL_OPC_FILL:
-			rc = _sw_accel_fill(accel_task->d.iovs, accel_task->d.iovcnt,
-					    accel_task->fill_pattern);
-			break;
-		case SPDK_ACCEL_OPC_DUALCAST:
-			rc = _sw_accel_dualcast_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
-						     accel_task->d2.iovs, accel_task->d2.iovcnt,
-						     accel_task->s.iovs, accel_task->s.iovcnt);
-			break;
-		case SPDK_ACCEL_OPC_COMPARE:
-			rc = _sw_accel_compare(accel_task->s.iovs, accel_task->s.iovcnt,
-					       accel_task->s2.iovs, accel_task->s2.iovcnt);
-			break;
-		case SPDK_ACCEL_OPC_CRC32C:
-			_sw_accel_crc32cv(accel_task->crc_dst, accel_task->s.iovs, accel_task->s.iovcnt, accel_task->seed);
-			break;
-		case SPDK_ACCEL_OPC_COPY_CRC32C:
-			_sw_accel_copy_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
-					    accel_task->s.iovs, accel_task->s.iovcnt);
-			_sw_accel_crc32cv(accel_task->crc_dst, accel_task->s.iovs,
-					  accel_task->s.iovcnt, accel_task->seed);
-			break;
-		case SPDK_ACCEL_OPC_COMPRESS:
-			rc = _sw_accel_compress(sw_ch, accel_task);
-			break;
-		case SPDK_ACCEL_OPC_DECOMPRESS:
-			rc = _sw_accel_decompress(sw_ch, accel_task);
-			break;
-		case SPDK_ACCEL_OPC_XOR:
-			rc = _sw_accel_xor(sw_ch, accel_task);
-			break;
-		case SPDK_ACCEL_OPC_ENCRYPT:
-			rc = _sw_accel_encrypt(sw_ch, accel_task);
-			break;
-		case SPDK_ACCEL_OPC_DECRYPT:
-			rc = _sw_accel_decrypt(sw_ch, accel_task);
-			break;
-		case SPDK_ACCEL_OPC_DIF_VERIFY:
-			rc = _sw_accel_dif_verify(sw_ch, accel_task);
-			break;
-		case SPDK_ACCEL_OPC_DIF_VERIFY_COPY:
-			rc = _sw_accel_dif_verify_copy(sw_ch, accel_task);
-			break;
-		case SPDK_ACCEL_OPC_DIF_GENERATE:
-			rc = _sw_accel_dif_generate(sw_ch, accel_task);
-			break;
-		case SPDK_ACCEL_OPC_DIF_GENERATE_COPY:
-			rc = _sw_accel_dif_generate_copy(sw_ch, accel_task);
-			break;
-		default:
-			assert(false);
-			break;
-		}
-
 		tmp = STAILQ_NEXT(accel_task, link);
 
+		/* Hand large tasks over to the helper threads, if there's room for them */
+		if (sw_ch->helper_completions != NULL &&
+		    accel_task->nbytes >= g_sw_opts.offload_threshold &&
+		    sw_ch->helper_completions->outstanding < SW_ACCEL_HELPER_RING_SIZE) {
+			sw_task = SPDK_CONTAINEROF(accel_task, struct sw_accel_task, task);
+			sw_task->completions = sw_ch->helper_completions;
+			if (spdk_ring_enqueue(g_sw_helpers.submissions, (void **)&sw_task, 1, NULL) == 1) {
+				sw_ch->helper_completions->outstanding++;
+				accel_task = tmp;
+				continue;
+			}
+		}
+
+		rc = sw_accel_execute_task(&sw_ch->exec, accel_task);
 		_add_to_comp_list(sw_ch, accel_task, rc);
 
 		accel_task = tmp;
@@ -598,22 +1396,36 @@ static int
 sw_accel_create_cb(void *io_device, void *ctx_buf)
 {
 	struct sw_accel_io_channel *sw_ch = ctx_buf;
+	struct sw_accel_helper_completions *completions;
+	int rc;
 
 	STAILQ_INIT(&sw_ch->tasks_to_complete);
 	sw_ch->completion_poller = NULL;
+	sw_ch->helper_completions = NULL;
 
-#ifdef SPDK_CONFIG_ISAL
-	isal_deflate_init(&sw_ch->stream);
-	sw_ch->stream.flush = NO_FLUSH;
-	sw_ch->stream.level = 1;
-	sw_ch->stream.level_buf = calloc(1, ISAL_DEF_LVL1_DEFAULT);
-	if (sw_ch->stream.level_buf == NULL) {
-		SPDK_ERRLOG("Could not allocate isal internal buffer\n");
-		return -ENOMEM;
+	rc = sw_accel_exec_ctx_init(&sw_ch->exec);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (g_sw_helpers.num_helpers > 0) {
+		completions = calloc(1, sizeof(*completions));
+		if (completions == NULL) {
+			sw_accel_exec_ctx_fini(&sw_ch->exec);
+			return -ENOMEM;
+		}
+
+		completions->ring = spdk_ring_create(SPDK_RING_TYPE_MP_SC, SW_ACCEL_HELPER_RING_SIZE,
+						     SPDK_ENV_SOCKET_ID_ANY);
+		if (completions->ring == NULL) {
+			SPDK_ERRLOG("Failed to create software accel completion ring\n");
+			free(completions);
+			sw_accel_exec_ctx_fini(&sw_ch->exec);
+			return -ENOMEM;
+		}
+
+		sw_ch->helper_completions = completions;
 	}
-	sw_ch->stream.level_buf_size = ISAL_DEF_LVL1_DEFAULT;
-	isal_inflate_init(&sw_ch->state);
-#endif
 
 	return 0;
 }
@@ -622,12 +1434,23 @@ static void
 sw_accel_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct sw_accel_io_channel *sw_ch = ctx_buf;
+	struct sw_accel_helper_completions *completions = sw_ch->helper_completions;
 
-#ifdef SPDK_CONFIG_ISAL
-	free(sw_ch->stream.level_buf);
-#endif
-
+	sw_accel_exec_ctx_fini(&sw_ch->exec);
 	spdk_poller_unregister(&sw_ch->completion_poller);
+
+	if (completions == NULL) {
+		return;
+	}
+
+	if (completions->outstanding == 0) {
+		sw_accel_helper_completions_free(completions);
+		return;
+	}
+
+	/* Tasks are never left outstanding when a channel is released, but don't let the helper
+	 * threads touch freed memory if they are.  The completions are freed once drained. */
+	completions->drain_poller = SPDK_POLLER_REGISTER(sw_accel_helper_drain, completions, 0);
 }
 
 static struct spdk_io_channel *
@@ -639,12 +1462,23 @@ sw_accel_get_io_channel(void)
 static size_t
 sw_accel_module_get_ctx_size(void)
 {
-	return sizeof(struct spdk_accel_task);
+	return sizeof(struct sw_accel_task);
 }
 
 static int
 sw_accel_module_init(void)
 {
+	int rc;
+
+	if (g_sw_opts.helper_threads > 0) {
+		rc = sw_accel_helpers_start();
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to start software accel helper threads: %s\n",
+				    spdk_strerror(-rc));
+			return rc;
+		}
+	}
+
 	spdk_io_device_register(&g_sw_module, sw_accel_create_cb, sw_accel_destroy_cb,
 				sizeof(struct sw_accel_io_channel), "sw_accel_module");
 
@@ -655,9 +1489,31 @@ static void
 sw_accel_module_fini(void *ctxt)
 {
 	spdk_io_device_unregister(&g_sw_module, NULL);
+	if (g_sw_helpers.num_helpers > 0) {
+		sw_accel_helpers_stop();
+	}
 	spdk_accel_module_finish();
 }
 
+static void
+sw_accel_write_config_json(struct spdk_json_write_ctx *w)
+{
+	if (g_sw_opts.helper_threads == 0) {
+		return;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "accel_sw_set_options");
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_uint32(w, "helper_threads", g_sw_opts.helper_threads);
+	spdk_json_write_named_uint32(w, "offload_threshold", g_sw_opts.offload_threshold);
+	if (spdk_cpuset_count(&g_sw_opts.helper_cpumask) > 0) {
+		spdk_json_write_named_string(w, "helper_cpumask", spdk_cpuset_fmt(&g_sw_opts.helper_cpumask));
+	}
+	spdk_json_write_object_end(w);
+	spdk_json_write_object_end(w);
+}
+
 static int
 sw_accel_create_aes_xts(struct spdk_accel_crypto_key *key)
 {
@@ -725,6 +1581,69 @@ sw_accel_crypto_supports_cipher(enum spdk_accel_cipher cipher, size_t key_size)
 	}
 }
 
+static bool
+sw_accel_compress_supports_algo(enum spdk_accel_comp_algo algo)
+{
+	switch (algo) {
+#ifdef SPDK_CONFIG_ISAL
+	case SPDK_ACCEL_COMP_ALGO_DEFLATE:
+		return true;
+#endif
+#ifdef SPDK_CONFIG_LZ4
+	case SPDK_ACCEL_COMP_ALGO_LZ4:
+		return true;
+#endif
+#ifdef SPDK_CONFIG_ZSTD
+	case SPDK_ACCEL_COMP_ALGO_ZSTD:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+static int
+sw_accel_get_compress_level_range(enum spdk_accel_comp_algo algo, uint32_t *min_level,
+				  uint32_t *max_level)
+{
+	switch (algo) {
+#ifdef SPDK_CONFIG_ISAL
+	case SPDK_ACCEL_COMP_ALGO_DEFLATE:
+		/* Level 0 (Huffman only) isn't exposed, level 1 has always been used by default */
+		*min_level = 1;
+		*max_level = ISAL_DEF_MAX_LEVEL;
+		return 0;
+#endif
+#ifdef SPDK_CONFIG_LZ4
+	case SPDK_ACCEL_COMP_ALGO_LZ4:
+		/* Level 1 selects the fast compressor, higher levels the high compression one */
+		*min_level = 1;
+		*max_level = LZ4HC_CLEVEL_MAX;
+		return 0;
+#endif
+#ifdef SPDK_CONFIG_ZSTD
+	case SPDK_ACCEL_COMP_ALGO_ZSTD:
+		*min_level = 1;
+		*max_level = ZSTD_maxCLevel();
+		return 0;
+#endif
+	default:
+		return -EINVAL;
+	}
+}
+
+static bool
+sw_accel_hash_supports_algo(enum spdk_accel_hash_algo algo)
+{
+	switch (algo) {
+	case SPDK_ACCEL_HASH_ALGO_XXH64:
+	case SPDK_ACCEL_HASH_ALGO_SHA256:
+		return true;
+	default:
+		return false;
+	}
+}
+
 static int
 sw_accel_get_operation_info(enum spdk_accel_opcode opcode,
 			    const struct spdk_accel_operation_exec_ctx *ctx,
@@ -738,17 +1657,21 @@ sw_accel_get_operation_info(enum spdk_accel_opcode opcode,
 static struct spdk_accel_module_if g_sw_module = {
 	.module_init			= sw_accel_module_init,
 	.module_fini			= sw_accel_module_fini,
-	.write_config_json		= NULL,
+	.write_config_json		= sw_accel_write_config_json,
 	.get_ctx_size			= sw_accel_module_get_ctx_size,
 	.name				= "software",
 	.priority			= SPDK_ACCEL_SW_PRIORITY,
 	.supports_opcode		= sw_accel_supports_opcode,
 	.get_io_channel			= sw_accel_get_io_channel,
 	.submit_tasks			= sw_accel_submit_tasks,
+	.submit_task_lists		= true,
 	.crypto_key_init		= sw_accel_crypto_key_init,
 	.crypto_key_deinit		= sw_accel_crypto_key_deinit,
 	.crypto_supports_tweak_mode	= sw_accel_crypto_supports_tweak_mode,
 	.crypto_supports_cipher		= sw_accel_crypto_supports_cipher,
+	.compress_supports_algo		= sw_accel_compress_supports_algo,
+	.get_compress_level_range	= sw_accel_get_compress_level_range,
+	.hash_supports_algo		= sw_accel_hash_supports_algo,
 	.get_operation_info		= sw_accel_get_operation_info,
 };
 
@@ -37,6 +37,7 @@ int __itt_init_ittlib(const char *, __itt_group_id);
 
 #define SPDK_BDEV_IO_POOL_SIZE			(64 * 1024 - 1)
 #define SPDK_BDEV_IO_CACHE_SIZE			256
+#define BDEV_IO_CACHE_BATCH_SIZE		16
 #define SPDK_BDEV_AUTO_EXAMINE			true
 #define BUF_SMALL_CACHE_SIZE			128
 #define BUF_LARGE_CACHE_SIZE			16
@@ -215,9 +216,7 @@ struct spdk_bdev_mgmt_channel {
 	 *  this, non-DPDK threads fetching from the mempool
 	 *  incur a cmpxchg on get and put.
 	 */
-	bdev_io_stailq_t per_thread_cache;
-	uint32_t	per_thread_cache_count;
-	uint32_t	bdev_io_cache_size;
+	struct spdk_obj_cache per_thread_cache;
 
 	struct spdk_iobuf_channel iobuf;
 
@@ -1325,10 +1324,8 @@ bdev_io_pull_data(struct spdk_bdev_io *bdev_io)
 			}
 		} else {
 			assert(bdev_io->u.bdev.iovcnt == 1);
-			spdk_copy_iovs_to_buf(bdev_io->u.bdev.iovs[0].iov_base,
-					      bdev_io->u.bdev.iovs[0].iov_len,
-					      bdev_io->internal.orig_iovs,
-					      bdev_io->internal.orig_iovcnt);
+			spdk_iovcpy_nt(bdev_io->internal.orig_iovs, bdev_io->internal.orig_iovcnt,
+				       bdev_io->u.bdev.iovs, 1);
 		}
 	}
 
@@ -1735,10 +1732,8 @@ bdev_io_push_bounce_data(struct spdk_bdev_io *bdev_io)
 						    bdev_io->internal.memory_domain));
 			}
 		} else {
-			spdk_copy_buf_to_iovs(bdev_io->internal.orig_iovs,
-					      bdev_io->internal.orig_iovcnt,
-					      bdev_io->internal.bounce_iov.iov_base,
-					      bdev_io->internal.bounce_iov.iov_len);
+			spdk_iovcpy_nt(&bdev_io->internal.bounce_iov, 1,
+				       bdev_io->internal.orig_iovs, bdev_io->internal.orig_iovcnt);
 		}
 	}
 
@@ -1973,26 +1968,16 @@ static void
 bdev_mgmt_channel_destroy(void *io_device, void *ctx_buf)
 {
 	struct spdk_bdev_mgmt_channel *ch = ctx_buf;
-	struct spdk_bdev_io *bdev_io;
 
 	spdk_iobuf_channel_fini(&ch->iobuf);
-
-	while (!STAILQ_EMPTY(&ch->per_thread_cache)) {
-		bdev_io = STAILQ_FIRST(&ch->per_thread_cache);
-		STAILQ_REMOVE_HEAD(&ch->per_thread_cache, internal.buf_link);
-		ch->per_thread_cache_count--;
-		spdk_mempool_put(g_bdev_mgr.bdev_io_pool, (void *)bdev_io);
-	}
-
-	assert(ch->per_thread_cache_count == 0);
+	spdk_obj_cache_fini(&ch->per_thread_cache);
 }
 
 static int
 bdev_mgmt_channel_create(void *io_device, void *ctx_buf)
 {
 	struct spdk_bdev_mgmt_channel *ch = ctx_buf;
-	struct spdk_bdev_io *bdev_io;
-	uint32_t i;
+	struct spdk_obj_cache_opts cache_opts = {};
 	int rc;
 
 	rc = spdk_iobuf_channel_init(&ch->iobuf, "bdev",
@@ -2003,21 +1988,30 @@ bdev_mgmt_channel_create(void *io_device, void *ctx_buf)
 		return -1;
 	}
 
-	STAILQ_INIT(&ch->per_thread_cache);
-	ch->bdev_io_cache_size = g_bdev_opts.bdev_io_cache_size;
+	/*
+	 * The cache never drops below its initial size, so that the bdev_ios reserved for this
+	 *  thread are kept.  Only the bdev_ios fetched on top of that are returned to the pool,
+	 *  a whole batch at once.
+	 */
+	cache_opts.opts_size = sizeof(cache_opts);
+	cache_opts.batch_size = spdk_max(spdk_min(g_bdev_opts.bdev_io_cache_size,
+					 BDEV_IO_CACHE_BATCH_SIZE), 1);
+	cache_opts.low_watermark = g_bdev_opts.bdev_io_cache_size;
+	cache_opts.high_watermark = g_bdev_opts.bdev_io_cache_size + cache_opts.batch_size;
+	rc = spdk_obj_cache_init(&ch->per_thread_cache, g_bdev_mgr.bdev_io_pool, &cache_opts);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to initialize bdev_io cache: %s\n", spdk_strerror(-rc));
+		spdk_iobuf_channel_fini(&ch->iobuf);
+		return -1;
+	}
 
 	/* Pre-populate bdev_io cache to ensure this thread cannot be starved. */
-	ch->per_thread_cache_count = 0;
-	for (i = 0; i < ch->bdev_io_cache_size; i++) {
-		bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool);
-		if (bdev_io == NULL) {
-			SPDK_ERRLOG("You need to increase bdev_io_pool_size using bdev_set_options RPC.\n");
-			assert(false);
-			bdev_mgmt_channel_destroy(io_device, ctx_buf);
-			return -1;
-		}
-		ch->per_thread_cache_count++;
-		STAILQ_INSERT_HEAD(&ch->per_thread_cache, bdev_io, internal.buf_link);
+	rc = spdk_obj_cache_fill(&ch->per_thread_cache, g_bdev_opts.bdev_io_cache_size);
+	if (rc != 0) {
+		SPDK_ERRLOG("You need to increase bdev_io_pool_size using bdev_set_options RPC.\n");
+		assert(false);
+		bdev_mgmt_channel_destroy(io_device, ctx_buf);
+		return -1;
 	}
 
 	TAILQ_INIT(&ch->shared_resources);
@@ -2454,23 +2448,17 @@ struct spdk_bdev_io *
 bdev_channel_get_io(struct spdk_bdev_channel *channel)
 {
 	struct spdk_bdev_mgmt_channel *ch = channel->shared_resource->mgmt_ch;
-	struct spdk_bdev_io *bdev_io;
 
-	if (ch->per_thread_cache_count > 0) {
-		bdev_io = STAILQ_FIRST(&ch->per_thread_cache);
-		STAILQ_REMOVE_HEAD(&ch->per_thread_cache, internal.buf_link);
-		ch->per_thread_cache_count--;
-	} else if (spdk_unlikely(!TAILQ_EMPTY(&ch->io_wait_queue))) {
+	if (spdk_unlikely(spdk_obj_cache_count(&ch->per_thread_cache) == 0 &&
+			  !TAILQ_EMPTY(&ch->io_wait_queue))) {
 		/*
 		 * Don't try to look for bdev_ios in the global pool if there are
 		 * waiters on bdev_ios - we don't want this caller to jump the line.
 		 */
-		bdev_io = NULL;
-	} else {
-		bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool);
+		return NULL;
 	}
 
-	return bdev_io;
+	return spdk_obj_cache_get(&ch->per_thread_cache);
 }
 
 void
@@ -2487,20 +2475,13 @@ spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
 		bdev_io_put_buf(bdev_io);
 	}
 
-	if (ch->per_thread_cache_count < ch->bdev_io_cache_size) {
-		ch->per_thread_cache_count++;
-		STAILQ_INSERT_HEAD(&ch->per_thread_cache, bdev_io, internal.buf_link);
-		while (ch->per_thread_cache_count > 0 && !TAILQ_EMPTY(&ch->io_wait_queue)) {
-			struct spdk_bdev_io_wait_entry *entry;
+	spdk_obj_cache_put(&ch->per_thread_cache, bdev_io);
+	while (spdk_obj_cache_count(&ch->per_thread_cache) > 0 && !TAILQ_EMPTY(&ch->io_wait_queue)) {
+		struct spdk_bdev_io_wait_entry *entry;
 
-			entry = TAILQ_FIRST(&ch->io_wait_queue);
-			TAILQ_REMOVE(&ch->io_wait_queue, entry, link);
-			entry->cb_fn(entry->cb_arg);
-		}
-	} else {
-		/* We should never have a full cache with entries on the io wait queue. */
-		assert(TAILQ_EMPTY(&ch->io_wait_queue));
-		spdk_mempool_put(g_bdev_mgr.bdev_io_pool, (void *)bdev_io);
+		entry = TAILQ_FIRST(&ch->io_wait_queue);
+		TAILQ_REMOVE(&ch->io_wait_queue, entry, link);
+		entry->cb_fn(entry->cb_arg);
 	}
 }
 
@@ -2755,6 +2736,7 @@ bdev_io_do_submit(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_i
 
 	if (spdk_unlikely(bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE &&
 			  bdev_io->bdev->split_on_write_unit &&
+			  !bdev_io->bdev->allow_partial_write_unit &&
 			  bdev_io->u.bdev.num_blocks < bdev_io->bdev->write_unit_size)) {
 		SPDK_ERRLOG("IO num_blocks %lu does not match the write_unit_size %u\n",
 			    bdev_io->u.bdev.num_blocks, bdev_io->bdev->write_unit_size);
@@ -4234,8 +4216,14 @@ bdev_abort_all_buf_io_cb(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry
 static void
 bdev_abort_all_buf_io(struct spdk_bdev_mgmt_channel *mgmt_ch, struct spdk_bdev_channel *ch)
 {
+	uint32_t i;
+
 	spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.small,
 				  bdev_abort_all_buf_io_cb, ch);
+	for (i = 0; i < mgmt_ch->iobuf.num_medium; i++) {
+		spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.medium[i],
+					  bdev_abort_all_buf_io_cb, ch);
+	}
 	spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.large,
 				  bdev_abort_all_buf_io_cb, ch);
 }
@@ -4302,6 +4290,7 @@ bdev_abort_buf_io_cb(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *ent
 static bool
 bdev_abort_buf_io(struct spdk_bdev_mgmt_channel *mgmt_ch, struct spdk_bdev_io *bio_to_abort)
 {
+	uint32_t i;
 	int rc;
 
 	rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.small,
@@ -4310,6 +4299,14 @@ bdev_abort_buf_io(struct spdk_bdev_mgmt_channel *mgmt_ch, struct spdk_bdev_io *b
 		return true;
 	}
 
+	for (i = 0; i < mgmt_ch->iobuf.num_medium; i++) {
+		rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.medium[i],
+					       bdev_abort_buf_io_cb, bio_to_abort);
+		if (rc == 1) {
+			return true;
+		}
+	}
+
 	rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.large,
 				       bdev_abort_buf_io_cb, bio_to_abort);
 	return rc == 1;
@@ -6592,6 +6589,17 @@ spdk_bdev_get_io_stat(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
 	bdev_get_io_stat(stat, channel->stat);
 }
 
+uint32_t
+spdk_bdev_get_io_cache_stats(struct spdk_io_channel *ch, struct spdk_obj_cache_stats *stats)
+{
+	struct spdk_bdev_channel *channel = __io_ch_to_bdev_ch(ch);
+	struct spdk_obj_cache *cache = &channel->shared_resource->mgmt_ch->per_thread_cache;
+
+	*stats = cache->stats;
+
+	return spdk_obj_cache_count(cache);
+}
+
 static void
 bdev_get_device_stat_done(struct spdk_bdev *bdev, void *_ctx, int status)
 {
@@ -6976,7 +6984,7 @@ _bdev_abort(struct spdk_bdev_io *parent_io)
 	struct spdk_bdev_desc *desc = parent_io->internal.desc;
 	struct spdk_bdev_channel *channel = parent_io->internal.ch;
 	void *bio_cb_arg;
-	struct spdk_bdev_io *bio_to_abort;
+	struct spdk_bdev_io *bio_to_abort, *tmp_io;
 	uint32_t matched_ios;
 	int rc;
 
@@ -6995,7 +7003,7 @@ _bdev_abort(struct spdk_bdev_io *parent_io)
 	matched_ios = 0;
 	parent_io->internal.status = SPDK_BDEV_IO_STATUS_SUCCESS;
 
-	TAILQ_FOREACH(bio_to_abort, &channel->io_submitted, internal.ch_link) {
+	TAILQ_FOREACH_SAFE(bio_to_abort, &channel->io_submitted, internal.ch_link, tmp_io) {
 		if (bio_to_abort->internal.caller_ctx != bio_cb_arg) {
 			continue;
 		}
@@ -7125,7 +7133,7 @@ spdk_bdev_queue_io_wait(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
 		return -EINVAL;
 	}
 
-	if (mgmt_ch->per_thread_cache_count > 0) {
+	if (spdk_obj_cache_count(&mgmt_ch->per_thread_cache) > 0) {
 		SPDK_ERRLOG("Cannot queue io_wait if spdk_bdev_io available in per-thread cache\n");
 		return -EINVAL;
 	}
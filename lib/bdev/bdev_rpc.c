@@ -298,12 +298,23 @@ bdev_get_per_channel_stat(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bd
 {
 	struct bdev_get_iostat_ctx *bdev_ctx = ctx;
 	struct spdk_json_write_ctx *w = bdev_ctx->rpc_ctx->w;
+	struct spdk_obj_cache_stats cache_stats;
+	uint32_t cache_count;
 
 	spdk_bdev_get_io_stat(bdev, ch, bdev_ctx->stat);
+	cache_count = spdk_bdev_get_io_cache_stats(ch, &cache_stats);
 
 	spdk_json_write_object_begin(w);
 	spdk_json_write_named_uint64(w, "thread_id", spdk_thread_get_id(spdk_get_thread()));
 	spdk_bdev_dump_io_stat_json(bdev_ctx->stat, w);
+	spdk_json_write_named_object_begin(w, "bdev_io_cache");
+	spdk_json_write_named_uint32(w, "count", cache_count);
+	spdk_json_write_named_uint64(w, "gets", cache_stats.gets);
+	spdk_json_write_named_uint64(w, "puts", cache_stats.puts);
+	spdk_json_write_named_uint64(w, "refills", cache_stats.refills);
+	spdk_json_write_named_uint64(w, "returns", cache_stats.returns);
+	spdk_json_write_named_uint64(w, "starved", cache_stats.starved);
+	spdk_json_write_object_end(w);
 	spdk_json_write_object_end(w);
 
 	spdk_bdev_for_each_channel_continue(i, 0);
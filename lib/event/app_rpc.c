@@ -4,6 +4,7 @@
  */
 
 #include "spdk/stdinc.h"
+#include "spdk/config.h"
 
 #include "spdk/event.h"
 #include "spdk/rpc.h"
@@ -19,6 +20,10 @@
 #include "spdk_internal/thread.h"
 #include "event_internal.h"
 
+#ifdef SPDK_CONFIG_HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
+
 struct rpc_spdk_kill_instance {
 	char *sig_name;
 };
@@ -172,6 +177,7 @@ _rpc_thread_get_stats(void *arg)
 	struct spdk_cpuset tmp_mask = {};
 	struct spdk_poller *poller;
 	struct spdk_thread_stats stats;
+	const struct spdk_obj_cache *msg_cache;
 	uint64_t active_pollers_count = 0;
 	uint64_t timed_pollers_count = 0;
 	uint64_t paused_pollers_count = 0;
@@ -203,6 +209,15 @@ _rpc_thread_get_stats(void *arg)
 		spdk_json_write_named_uint64(ctx->w, "active_pollers_count", active_pollers_count);
 		spdk_json_write_named_uint64(ctx->w, "timed_pollers_count", timed_pollers_count);
 		spdk_json_write_named_uint64(ctx->w, "paused_pollers_count", paused_pollers_count);
+		msg_cache = spdk_thread_get_msg_cache(thread);
+		spdk_json_write_named_object_begin(ctx->w, "msg_cache");
+		spdk_json_write_named_uint32(ctx->w, "count", spdk_obj_cache_count(msg_cache));
+		spdk_json_write_named_uint64(ctx->w, "gets", msg_cache->stats.gets);
+		spdk_json_write_named_uint64(ctx->w, "puts", msg_cache->stats.puts);
+		spdk_json_write_named_uint64(ctx->w, "refills", msg_cache->stats.refills);
+		spdk_json_write_named_uint64(ctx->w, "returns", msg_cache->stats.returns);
+		spdk_json_write_named_uint64(ctx->w, "starved", msg_cache->stats.starved);
+		spdk_json_write_object_end(ctx->w);
 		spdk_json_write_object_end(ctx->w);
 	}
 }
@@ -227,10 +242,18 @@ rpc_get_poller(struct spdk_poller *poller, struct spdk_json_write_ctx *w)
 {
 	struct spdk_poller_stats stats;
 	uint64_t period_ticks;
+	int i, last_bucket;
 
 	period_ticks = spdk_poller_get_period_ticks(poller);
 	spdk_poller_get_stats(poller, &stats);
 
+	/* Skip the trailing empty buckets of the histogram */
+	for (last_bucket = SPDK_POLLER_RUN_TSC_HISTOGRAM_BUCKETS - 1; last_bucket >= 0; last_bucket--) {
+		if (stats.run_tsc_histogram[last_bucket] != 0) {
+			break;
+		}
+	}
+
 	spdk_json_write_object_begin(w);
 	spdk_json_write_named_string(w, "name", spdk_poller_get_name(poller));
 	spdk_json_write_named_uint64(w, "id", spdk_poller_get_id(poller));
@@ -240,6 +263,13 @@ rpc_get_poller(struct spdk_poller *poller, struct spdk_json_write_ctx *w)
 	if (period_ticks) {
 		spdk_json_write_named_uint64(w, "period_ticks", period_ticks);
 	}
+	spdk_json_write_named_uint64(w, "run_ticks", stats.run_tsc);
+	spdk_json_write_named_uint64(w, "max_run_ticks", stats.max_run_tsc);
+	spdk_json_write_named_array_begin(w, "run_ticks_histogram");
+	for (i = 0; i <= last_bucket; i++) {
+		spdk_json_write_uint64(w, stats.run_tsc_histogram[i]);
+	}
+	spdk_json_write_array_end(w);
 	spdk_json_write_object_end(w);
 }
 
@@ -375,6 +405,11 @@ _rpc_framework_get_reactors(void *arg1, void *arg2)
 	spdk_json_write_named_uint64(ctx->w, "busy", reactor->busy_tsc);
 	spdk_json_write_named_uint64(ctx->w, "idle", reactor->idle_tsc);
 	spdk_json_write_named_bool(ctx->w, "in_interrupt", reactor->in_interrupt);
+	spdk_json_write_named_uint64(ctx->w, "sleep", reactor->sleep_tsc);
+	spdk_json_write_named_uint64(ctx->w, "sleep_count", reactor->sleep_count);
+	spdk_json_write_named_uint64(ctx->w, "wakeup_count", reactor->wakeup_count);
+	spdk_json_write_named_uint64(ctx->w, "wakeup_latency", reactor->wakeup_latency_tsc);
+	spdk_json_write_named_uint64(ctx->w, "max_wakeup_latency", reactor->max_wakeup_latency_tsc);
 
 	if (app_get_proc_stat(current_core, &usr, &sys, &irq) != 0) {
 		irq = sys = usr = 0;
@@ -443,6 +478,176 @@ rpc_framework_get_reactors(struct spdk_jsonrpc_request *request,
 
 SPDK_RPC_REGISTER("framework_get_reactors", rpc_framework_get_reactors, SPDK_RPC_RUNTIME)
 
+static const struct spdk_json_object_decoder rpc_framework_set_hybrid_polling_decoders[] = {
+	{"enabled", offsetof(struct spdk_reactor_hybrid_opts, enabled), spdk_json_decode_bool},
+	{"idle_iterations", offsetof(struct spdk_reactor_hybrid_opts, idle_iterations), spdk_json_decode_uint32, true},
+	{"min_sleep_us", offsetof(struct spdk_reactor_hybrid_opts, min_sleep_us), spdk_json_decode_uint32, true},
+	{"max_sleep_us", offsetof(struct spdk_reactor_hybrid_opts, max_sleep_us), spdk_json_decode_uint32, true},
+};
+
+static void
+rpc_framework_set_hybrid_polling_done(void *cb_arg)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+
+static void
+rpc_framework_set_hybrid_polling(struct spdk_jsonrpc_request *request,
+				 const struct spdk_json_val *params)
+{
+	struct spdk_reactor_hybrid_opts opts;
+	int rc;
+
+	spdk_reactors_get_hybrid_opts(&opts);
+	if (spdk_json_decode_object(params, rpc_framework_set_hybrid_polling_decoders,
+				    SPDK_COUNTOF(rpc_framework_set_hybrid_polling_decoders), &opts)) {
+		SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		return;
+	}
+
+	rc = spdk_reactors_set_hybrid_opts(&opts, rpc_framework_set_hybrid_polling_done, request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+	}
+}
+SPDK_RPC_REGISTER("framework_set_hybrid_polling", rpc_framework_set_hybrid_polling,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
+struct rpc_framework_set_watchdog {
+	uint64_t budget_us;
+};
+
+static const struct spdk_json_object_decoder rpc_framework_set_watchdog_decoders[] = {
+	{"budget_us", offsetof(struct rpc_framework_set_watchdog, budget_us), spdk_json_decode_uint64},
+};
+
+static void
+rpc_framework_set_watchdog(struct spdk_jsonrpc_request *request,
+			   const struct spdk_json_val *params)
+{
+	struct rpc_framework_set_watchdog req = {};
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_framework_set_watchdog_decoders,
+				    SPDK_COUNTOF(rpc_framework_set_watchdog_decoders), &req)) {
+		SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		return;
+	}
+
+	rc = spdk_reactors_set_watchdog_budget(req.budget_us);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("framework_set_watchdog", rpc_framework_set_watchdog,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
+static void
+rpc_write_reactor_stall(struct spdk_json_write_ctx *w, const struct spdk_reactor_stall *stall)
+{
+#ifdef SPDK_CONFIG_HAVE_EXECINFO_H
+	char **symbols;
+	int i;
+#endif
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "tsc", stall->tsc);
+	spdk_json_write_named_uint64(w, "duration", stall->duration_tsc);
+	if (stall->poller_name[0] != '\0') {
+		spdk_json_write_named_string(w, "type", "poller");
+	} else if (stall->thread_name[0] != '\0') {
+		spdk_json_write_named_string(w, "type", "message");
+	} else {
+		spdk_json_write_named_string(w, "type", "event");
+	}
+	if (stall->thread_name[0] != '\0') {
+		spdk_json_write_named_string(w, "thread", stall->thread_name);
+	}
+	spdk_json_write_named_string(w, "function", stall->fn_name);
+
+	spdk_json_write_named_array_begin(w, "backtrace");
+#ifdef SPDK_CONFIG_HAVE_EXECINFO_H
+	symbols = backtrace_symbols(stall->frames, stall->num_frames);
+	if (symbols != NULL) {
+		for (i = 0; i < stall->num_frames; i++) {
+			spdk_json_write_string(w, symbols[i]);
+		}
+		free(symbols);
+	}
+#endif
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+}
+
+static void
+_rpc_framework_get_reactor_stalls(void *arg1, void *arg2)
+{
+	struct rpc_get_stats_ctx *ctx = arg1;
+	struct spdk_reactor *reactor;
+	uint64_t i, first;
+
+	reactor = spdk_reactor_get(spdk_env_get_current_core());
+	assert(reactor != NULL);
+
+	spdk_json_write_object_begin(ctx->w);
+	spdk_json_write_named_uint32(ctx->w, "lcore", reactor->lcore);
+	spdk_json_write_named_uint64(ctx->w, "stall_count", reactor->stall_count);
+
+	/* Oldest first */
+	first = reactor->stall_count > SPDK_REACTOR_STALL_HISTORY ?
+		reactor->stall_count - SPDK_REACTOR_STALL_HISTORY : 0;
+	spdk_json_write_named_array_begin(ctx->w, "stalls");
+	for (i = first; i < reactor->stall_count; i++) {
+		rpc_write_reactor_stall(ctx->w, &reactor->stalls[i % SPDK_REACTOR_STALL_HISTORY]);
+	}
+	spdk_json_write_array_end(ctx->w);
+
+	spdk_json_write_object_end(ctx->w);
+}
+
+static void
+rpc_framework_get_reactor_stalls(struct spdk_jsonrpc_request *request,
+				 const struct spdk_json_val *params)
+{
+	struct rpc_get_stats_ctx *ctx;
+
+	if (params) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "`framework_get_reactor_stalls` requires no arguments");
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Memory allocation error");
+		return;
+	}
+
+	ctx->now = spdk_get_ticks();
+	ctx->request = request;
+	ctx->w = spdk_jsonrpc_begin_result(ctx->request);
+
+	spdk_json_write_object_begin(ctx->w);
+	spdk_json_write_named_uint64(ctx->w, "tick_rate", spdk_get_ticks_hz());
+	spdk_json_write_named_uint64(ctx->w, "budget_us", spdk_reactors_get_watchdog_budget());
+	spdk_json_write_named_array_begin(ctx->w, "reactors");
+
+	spdk_for_each_reactor(_rpc_framework_get_reactor_stalls, ctx, NULL,
+			      rpc_framework_get_reactors_done);
+}
+SPDK_RPC_REGISTER("framework_get_reactor_stalls", rpc_framework_get_reactor_stalls,
+		  SPDK_RPC_RUNTIME)
+
 struct rpc_set_scheduler_ctx {
 	char *name;
 	uint64_t period;
@@ -4,6 +4,7 @@
  */
 
 #include "spdk/stdinc.h"
+#include "spdk/config.h"
 #include "spdk/likely.h"
 
 #include "spdk_internal/event.h"
@@ -16,6 +17,9 @@
 #include "spdk/scheduler.h"
 #include "spdk/string.h"
 #include "spdk/fd_group.h"
+#include "spdk/trace.h"
+#include "spdk_internal/thread.h"
+#include "spdk_internal/trace_defs.h"
 
 #ifdef __linux__
 #include <sys/prctl.h>
@@ -26,8 +30,24 @@
 #include <pthread_np.h>
 #endif
 
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+#ifdef SPDK_CONFIG_HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
+
 #define SPDK_EVENT_BATCH_SIZE		8
 
+#define REACTOR_HYBRID_DEFAULT_IDLE_ITERATIONS	10000
+#define REACTOR_HYBRID_DEFAULT_MIN_SLEEP_US	1
+#define REACTOR_HYBRID_DEFAULT_MAX_SLEEP_US	100
+
+#define REACTOR_WATCHDOG_SIGNAL			SIGRTMIN
+#define REACTOR_WATCHDOG_MIN_PERIOD_US		100
+#define REACTOR_WATCHDOG_MAX_PERIOD_US		100000
+
 static struct spdk_reactor *g_reactors;
 static uint32_t g_reactor_count;
 static struct spdk_cpuset g_reactor_core_mask;
@@ -54,10 +74,34 @@ static struct spdk_governor *g_governor = NULL;
 
 static int reactor_interrupt_init(struct spdk_reactor *reactor);
 static void reactor_interrupt_fini(struct spdk_reactor *reactor);
+static void _set_thread_name(const char *thread_name);
+static void reactor_hybrid_wakeup(void *ctx);
 
 static pthread_mutex_t g_stopping_reactors_mtx = PTHREAD_MUTEX_INITIALIZER;
 static bool g_stopping_reactors = false;
 
+static struct spdk_reactor_hybrid_opts g_reactor_hybrid_opts = {
+	.enabled = false,
+	.idle_iterations = REACTOR_HYBRID_DEFAULT_IDLE_ITERATIONS,
+	.min_sleep_us = REACTOR_HYBRID_DEFAULT_MIN_SLEEP_US,
+	.max_sleep_us = REACTOR_HYBRID_DEFAULT_MAX_SLEEP_US,
+};
+static bool g_reactor_set_hybrid_opts_in_progress = false;
+/* Set once hybrid polling gets enabled, keeps the wakeup check off the event path otherwise */
+static bool g_reactor_hybrid_used = false;
+/* Whether the CPU supports the UMONITOR/UMWAIT instructions (WAITPKG) */
+static bool g_reactor_has_waitpkg = false;
+
+#define REACTOR_HYBRID_SLEEPING	1
+
+static uint64_t g_reactor_watchdog_budget_us = 0;
+static pthread_t g_reactor_watchdog_thread;
+static bool g_reactor_watchdog_running = false;
+/* Protects g_reactor_watchdog_stop, the monitor waits on the condvar between its checks */
+static pthread_mutex_t g_reactor_watchdog_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_reactor_watchdog_cond;
+static bool g_reactor_watchdog_stop = false;
+
 static struct spdk_scheduler *
 _scheduler_find(const char *name)
 {
@@ -155,6 +199,10 @@ reactor_construct(struct spdk_reactor *reactor, uint32_t lcore)
 	TAILQ_INIT(&reactor->threads);
 	reactor->thread_count = 0;
 	spdk_cpuset_zero(&reactor->notify_cpuset);
+	reactor->hybrid_opts = g_reactor_hybrid_opts;
+	reactor->sleep_us = g_reactor_hybrid_opts.min_sleep_us;
+	reactor->hybrid_wakeup.fn = reactor_hybrid_wakeup;
+	reactor->hybrid_wakeup.ctx = reactor;
 
 	reactor->events = spdk_ring_create(SPDK_RING_TYPE_MP_SC, 65536, SPDK_ENV_SOCKET_ID_ANY);
 	if (reactor->events == NULL) {
@@ -211,6 +259,19 @@ spdk_reactor_get(uint32_t lcore)
 static int reactor_thread_op(struct spdk_thread *thread, enum spdk_thread_op op);
 static bool reactor_thread_op_supported(enum spdk_thread_op op);
 
+static bool
+reactor_detect_waitpkg(void)
+{
+#if defined(__x86_64__)
+	unsigned int eax, ebx, ecx, edx;
+
+	if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+		return (ecx & (1u << 5)) != 0;
+	}
+#endif
+	return false;
+}
+
 int
 spdk_reactors_init(size_t msg_mempool_size)
 {
@@ -252,6 +313,8 @@ spdk_reactors_init(size_t msg_mempool_size)
 
 	memset(g_reactors, 0, (g_reactor_count) * sizeof(struct spdk_reactor));
 
+	g_reactor_has_waitpkg = reactor_detect_waitpkg();
+
 	rc = spdk_thread_lib_init_ext(reactor_thread_op, reactor_thread_op_supported,
 				      sizeof(struct spdk_lw_thread), msg_mempool_size);
 	if (rc != 0) {
@@ -467,6 +530,363 @@ spdk_reactor_set_interrupt_mode(uint32_t lcore, bool new_in_interrupt,
 	return 0;
 }
 
+struct reactor_set_hybrid_opts_ctx {
+	struct spdk_reactor_hybrid_opts		opts;
+	spdk_reactors_set_hybrid_opts_cb	cb_fn;
+	void					*cb_arg;
+};
+
+static void
+_reactors_set_hybrid_opts_done(void *arg)
+{
+	struct reactor_set_hybrid_opts_ctx *ctx = arg;
+
+	g_reactor_set_hybrid_opts_in_progress = false;
+	if (ctx->cb_fn != NULL) {
+		ctx->cb_fn(ctx->cb_arg);
+	}
+	free(ctx);
+}
+
+static void
+_reactor_set_hybrid_opts_cpl(void *arg1, void *arg2)
+{
+	spdk_thread_send_msg(spdk_thread_get_app_thread(), _reactors_set_hybrid_opts_done, arg1);
+}
+
+static void
+_reactor_set_hybrid_opts(void *arg1, void *arg2)
+{
+	struct reactor_set_hybrid_opts_ctx *ctx = arg1;
+	struct spdk_reactor *reactor = spdk_reactor_get(spdk_env_get_current_core());
+
+	assert(reactor != NULL);
+
+	/* The current sleep length is clamped to the new range on the next idle iteration */
+	reactor->hybrid_opts = ctx->opts;
+	reactor->idle_iterations = 0;
+}
+
+int
+spdk_reactors_set_hybrid_opts(const struct spdk_reactor_hybrid_opts *opts,
+			      spdk_reactors_set_hybrid_opts_cb cb_fn, void *cb_arg)
+{
+	struct reactor_set_hybrid_opts_ctx *ctx;
+
+	if (spdk_env_get_current_core() != g_scheduling_reactor->lcore) {
+		SPDK_ERRLOG("It is only permitted within scheduling reactor.\n");
+		return -EPERM;
+	}
+
+	if (opts->idle_iterations == 0) {
+		SPDK_ERRLOG("idle_iterations must be greater than 0\n");
+		return -EINVAL;
+	}
+
+	if (opts->min_sleep_us == 0 || opts->min_sleep_us > opts->max_sleep_us) {
+		SPDK_ERRLOG("min_sleep_us must be greater than 0 and not greater than max_sleep_us\n");
+		return -EINVAL;
+	}
+
+	if (g_reactor_set_hybrid_opts_in_progress) {
+		SPDK_ERRLOG("Hybrid polling options are already being set\n");
+		return -EBUSY;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->opts = *opts;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	if (opts->enabled) {
+		__atomic_store_n(&g_reactor_hybrid_used, true, __ATOMIC_RELAXED);
+	}
+
+	g_reactor_hybrid_opts = *opts;
+	g_reactor_set_hybrid_opts_in_progress = true;
+	spdk_for_each_reactor(_reactor_set_hybrid_opts, ctx, NULL, _reactor_set_hybrid_opts_cpl);
+
+	return 0;
+}
+
+void
+spdk_reactors_get_hybrid_opts(struct spdk_reactor_hybrid_opts *opts)
+{
+	*opts = g_reactor_hybrid_opts;
+}
+
+static void
+reactor_stall_copy_name(char *dst, const char *src)
+{
+	size_t i;
+
+	/* Called from a signal handler, so avoid anything that's not async-signal-safe */
+	for (i = 0; i < SPDK_REACTOR_STALL_NAME_LEN - 1 && src[i] != '\0'; i++) {
+		dst[i] = src[i];
+	}
+	dst[i] = '\0';
+}
+
+/* Runs on the stalled reactor, interrupting whatever it's executing */
+static void
+reactor_watchdog_signal_handler(int signo)
+{
+	struct spdk_reactor *reactor;
+	struct spdk_reactor_stall *stall;
+	struct spdk_thread *thread;
+	const char *poller_name;
+	uint32_t lcore;
+	int saved_errno = errno;
+
+	lcore = spdk_env_get_current_core();
+	if (g_reactors == NULL || lcore >= g_reactor_count) {
+		return;
+	}
+
+	reactor = &g_reactors[lcore];
+	/* The previous stall hasn't been reported yet or the stalled iteration is already over */
+	if (reactor->stall_captured || reactor->watchdog_tsc != reactor->watchdog_signalled_tsc) {
+		return;
+	}
+
+	stall = &reactor->stall_capture;
+	memset(stall, 0, sizeof(*stall));
+	stall->tsc = reactor->watchdog_tsc;
+
+	thread = spdk_get_thread();
+	if (thread != NULL) {
+		reactor_stall_copy_name(stall->thread_name, spdk_thread_get_name(thread));
+		stall->fn = spdk_thread_get_running_fn(thread, &poller_name);
+		if (poller_name != NULL) {
+			reactor_stall_copy_name(stall->poller_name, poller_name);
+		}
+	} else {
+		stall->fn = (void *)reactor->running_event_fn;
+	}
+
+#ifdef SPDK_CONFIG_HAVE_EXECINFO_H
+	stall->num_frames = backtrace(stall->frames, SPDK_COUNTOF(stall->frames));
+#endif
+	reactor->stall_captured = true;
+
+	errno = saved_errno;
+}
+
+static void *
+reactor_watchdog_monitor(void *arg)
+{
+	struct spdk_reactor *reactor;
+	struct timespec ts;
+	uint64_t budget_us, budget_tsc, tsc, now, period_ns;
+	uint32_t i;
+
+	_set_thread_name("reactor_watchdog");
+
+	pthread_mutex_lock(&g_reactor_watchdog_mtx);
+	while (!g_reactor_watchdog_stop) {
+		budget_us = g_reactor_watchdog_budget_us;
+		budget_tsc = budget_us * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+
+		period_ns = spdk_min(spdk_max(budget_us / 2, REACTOR_WATCHDOG_MIN_PERIOD_US),
+				     REACTOR_WATCHDOG_MAX_PERIOD_US) * 1000;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		period_ns += ts.tv_nsec;
+		ts.tv_sec += period_ns / SPDK_SEC_TO_NSEC;
+		ts.tv_nsec = period_ns % SPDK_SEC_TO_NSEC;
+
+		/* Woken up early by reactor_watchdog_stop() */
+		pthread_cond_timedwait(&g_reactor_watchdog_cond, &g_reactor_watchdog_mtx, &ts);
+		if (g_reactor_watchdog_stop) {
+			break;
+		}
+
+		now = spdk_get_ticks();
+		SPDK_ENV_FOREACH_CORE(i) {
+			reactor = &g_reactors[i];
+			tsc = reactor->watchdog_tsc;
+
+			/* Only signal each stalled iteration once */
+			if (tsc == 0 || tsc == reactor->watchdog_signalled_tsc ||
+			    now < tsc + budget_tsc || reactor->stall_captured) {
+				continue;
+			}
+
+			reactor->watchdog_signalled_tsc = tsc;
+			pthread_kill(reactor->pthread, REACTOR_WATCHDOG_SIGNAL);
+		}
+	}
+	pthread_mutex_unlock(&g_reactor_watchdog_mtx);
+
+	return NULL;
+}
+
+static int
+reactor_watchdog_start(void)
+{
+	struct sigaction sigact = {};
+	pthread_condattr_t attr;
+#ifdef SPDK_CONFIG_HAVE_EXECINFO_H
+	void *frame;
+#endif
+	int rc;
+
+	if (g_reactor_watchdog_running) {
+		return 0;
+	}
+
+#ifdef SPDK_CONFIG_HAVE_EXECINFO_H
+	/* backtrace() loads libgcc on the first call, which is not safe to do from
+	 * a signal handler. */
+	backtrace(&frame, 1);
+#endif
+
+	sigact.sa_handler = reactor_watchdog_signal_handler;
+	sigact.sa_flags = SA_RESTART;
+	sigemptyset(&sigact.sa_mask);
+	if (sigaction(REACTOR_WATCHDOG_SIGNAL, &sigact, NULL) != 0) {
+		SPDK_ERRLOG("Failed to install the watchdog signal handler: %s\n", spdk_strerror(errno));
+		return -errno;
+	}
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	rc = pthread_cond_init(&g_reactor_watchdog_cond, &attr);
+	pthread_condattr_destroy(&attr);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to initialize the watchdog condvar: %s\n", spdk_strerror(rc));
+		return -rc;
+	}
+
+	g_reactor_watchdog_stop = false;
+	rc = pthread_create(&g_reactor_watchdog_thread, NULL, reactor_watchdog_monitor, NULL);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to create the watchdog thread: %s\n", spdk_strerror(rc));
+		pthread_cond_destroy(&g_reactor_watchdog_cond);
+		return -rc;
+	}
+
+	g_reactor_watchdog_running = true;
+
+	return 0;
+}
+
+static void
+reactor_watchdog_stop(void)
+{
+	if (!g_reactor_watchdog_running) {
+		return;
+	}
+
+	/* Wake the monitor up instead of waiting for its current period to end */
+	pthread_mutex_lock(&g_reactor_watchdog_mtx);
+	g_reactor_watchdog_stop = true;
+	pthread_cond_signal(&g_reactor_watchdog_cond);
+	pthread_mutex_unlock(&g_reactor_watchdog_mtx);
+
+	pthread_join(g_reactor_watchdog_thread, NULL);
+	pthread_cond_destroy(&g_reactor_watchdog_cond);
+	g_reactor_watchdog_running = false;
+}
+
+int
+spdk_reactors_set_watchdog_budget(uint64_t budget_us)
+{
+	uint64_t prev_budget_us = g_reactor_watchdog_budget_us;
+	int rc;
+
+	g_reactor_watchdog_budget_us = budget_us;
+
+	/* Before the reactors start, the monitor is started by spdk_reactors_start() */
+	if (g_reactor_state != SPDK_REACTOR_STATE_RUNNING) {
+		return 0;
+	}
+
+	if (budget_us == 0) {
+		reactor_watchdog_stop();
+		return 0;
+	}
+
+	rc = reactor_watchdog_start();
+	if (rc != 0) {
+		g_reactor_watchdog_budget_us = prev_budget_us;
+	}
+
+	return rc;
+}
+
+uint64_t
+spdk_reactors_get_watchdog_budget(void)
+{
+	return g_reactor_watchdog_budget_us;
+}
+
+static void
+reactor_stall_resolve_fn_name(struct spdk_reactor_stall *stall)
+{
+#ifdef SPDK_CONFIG_HAVE_EXECINFO_H
+	char **symbols;
+#endif
+
+	if (stall->poller_name[0] != '\0') {
+		spdk_strcpy_pad(stall->fn_name, stall->poller_name, sizeof(stall->fn_name), '\0');
+		stall->fn_name[sizeof(stall->fn_name) - 1] = '\0';
+		return;
+	}
+
+#ifdef SPDK_CONFIG_HAVE_EXECINFO_H
+	if (stall->fn != NULL) {
+		symbols = backtrace_symbols(&stall->fn, 1);
+		if (symbols != NULL) {
+			snprintf(stall->fn_name, sizeof(stall->fn_name), "%s", symbols[0]);
+			free(symbols);
+			return;
+		}
+	}
+#endif
+	snprintf(stall->fn_name, sizeof(stall->fn_name), "%p", stall->fn);
+}
+
+static void
+reactor_watchdog_report(struct spdk_reactor *reactor)
+{
+	struct spdk_reactor_stall *stall;
+	uint64_t duration_us;
+#ifdef SPDK_CONFIG_HAVE_EXECINFO_H
+	char **symbols;
+	int i;
+#endif
+
+	stall = &reactor->stalls[reactor->stall_count % SPDK_REACTOR_STALL_HISTORY];
+	*stall = reactor->stall_capture;
+	stall->duration_tsc = spdk_get_ticks() - stall->tsc;
+	duration_us = stall->duration_tsc * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+	reactor_stall_resolve_fn_name(stall);
+
+	reactor->stall_count++;
+	reactor->stall_captured = false;
+
+	spdk_trace_record(TRACE_THREAD_STALL, 0, 0, 0, stall->duration_tsc, stall->fn_name);
+
+	SPDK_WARNLOG("Reactor %u stalled for %" PRIu64 " us in %s %s on thread %s\n",
+		     reactor->lcore, duration_us,
+		     stall->poller_name[0] != '\0' ? "poller" :
+		     stall->thread_name[0] != '\0' ? "message" : "event",
+		     stall->fn_name, stall->thread_name[0] != '\0' ? stall->thread_name : "(none)");
+#ifdef SPDK_CONFIG_HAVE_EXECINFO_H
+	symbols = backtrace_symbols(stall->frames, stall->num_frames);
+	if (symbols != NULL) {
+		for (i = 0; i < stall->num_frames; i++) {
+			SPDK_WARNLOG("  #%d: %s\n", i, symbols[i]);
+		}
+		free(symbols);
+	}
+#endif
+}
+
 struct spdk_event *
 spdk_event_allocate(uint32_t lcore, spdk_event_fn fn, void *arg1, void *arg2)
 {
@@ -527,6 +947,12 @@ spdk_event_call(struct spdk_event *event)
 			SPDK_ERRLOG("failed to notify event queue: %s.\n", spdk_strerror(errno));
 		}
 	}
+
+	if (spdk_unlikely(__atomic_load_n(&g_reactor_hybrid_used, __ATOMIC_RELAXED))) {
+		/* Order the enqueue before the check, pairs with the fence in reactor_hybrid_sleep() */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		reactor_hybrid_wakeup(reactor);
+	}
 }
 
 static inline int
@@ -585,8 +1011,10 @@ event_queue_run_batch(void *arg)
 		assert(spdk_get_thread() == NULL);
 		SPDK_DTRACE_PROBE3(event_exec, event->fn,
 				   event->arg1, event->arg2);
+		reactor->running_event_fn = event->fn;
 		event->fn(event->arg1, event->arg2);
 	}
+	reactor->running_event_fn = NULL;
 
 	spdk_mempool_put_bulk(g_spdk_event_mempool, events, count);
 
@@ -881,15 +1309,17 @@ reactor_interrupt_run(struct spdk_reactor *reactor)
 	spdk_fd_group_wait(reactor->fgrp, block_timeout);
 }
 
-static void
+/* Returns true if any work (an event or a busy thread poll) was done */
+static bool
 _reactor_run(struct spdk_reactor *reactor)
 {
 	struct spdk_thread	*thread;
 	struct spdk_lw_thread	*lw_thread, *tmp;
 	uint64_t		now;
 	int			rc;
+	bool			busy;
 
-	event_queue_run_batch(reactor);
+	busy = event_queue_run_batch(reactor) > 0;
 
 	/* If no threads are present on the reactor,
 	 * tsc_last gets outdated. Update it to track
@@ -898,7 +1328,7 @@ _reactor_run(struct spdk_reactor *reactor)
 		now = spdk_get_ticks();
 		reactor->idle_tsc += now - reactor->tsc_last;
 		reactor->tsc_last = now;
-		return;
+		return busy;
 	}
 
 	TAILQ_FOREACH_SAFE(lw_thread, &reactor->threads, link, tmp) {
@@ -910,11 +1340,217 @@ _reactor_run(struct spdk_reactor *reactor)
 			reactor->idle_tsc += now - reactor->tsc_last;
 		} else if (rc > 0) {
 			reactor->busy_tsc += now - reactor->tsc_last;
+			busy = true;
 		}
 		reactor->tsc_last = now;
 
 		reactor_post_process_lw_thread(reactor, lw_thread);
 	}
+
+	return busy;
+}
+
+static void
+reactor_hybrid_wakeup(void *ctx)
+{
+	struct spdk_reactor *reactor = ctx;
+	uint64_t expected = REACTOR_HYBRID_SLEEPING;
+	uint64_t notify = 1;
+
+	if (__atomic_load_n(&reactor->hybrid_sleep, __ATOMIC_RELAXED) != REACTOR_HYBRID_SLEEPING) {
+		return;
+	}
+
+	/* Only the first sender records the time and notifies the reactor */
+	if (!__atomic_compare_exchange_n(&reactor->hybrid_sleep, &expected, spdk_get_ticks(), false,
+					 __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+		return;
+	}
+
+	/* With WAITPKG the reactor monitors hybrid_sleep, the store above already woke it up */
+	if (g_reactor_has_waitpkg || reactor->fgrp == NULL) {
+		return;
+	}
+
+	if (write(reactor->events_fd, &notify, sizeof(notify)) < 0) {
+		SPDK_ERRLOG("failed to wake up reactor: %s.\n", spdk_strerror(errno));
+	}
+}
+
+#if defined(__x86_64__)
+static inline void
+reactor_umonitor(void *addr)
+{
+	/* Encoded manually, so that it doesn't require compiling with -mwaitpkg */
+	__asm__ volatile(".byte 0xf3, 0x0f, 0xae, 0xf0" : : "a"(addr) : "memory");
+}
+
+static inline void
+reactor_umwait(uint64_t deadline)
+{
+	/* ECX = 0 requests the C0.2 state, which has the lowest power consumption among the
+	 * user-level wait states. */
+	__asm__ volatile(".byte 0xf2, 0x0f, 0xae, 0xf1"
+			 :
+			 : "c"(0), "a"((uint32_t)deadline), "d"((uint32_t)(deadline >> 32))
+			 : "cc", "memory");
+}
+#endif
+
+static void
+reactor_hybrid_wait(struct spdk_reactor *reactor, uint64_t now, uint64_t deadline)
+{
+	struct pollfd pfd = { .fd = reactor->events_fd, .events = POLLIN };
+	struct timespec ts;
+	uint64_t nsec;
+
+#if defined(__x86_64__)
+	if (g_reactor_has_waitpkg) {
+		/* UMWAIT may wake up earlier (e.g. when hitting the OS-defined limit), so repeat it
+		 * until either the deadline passes or a sender clears the sleeping state. */
+		while (spdk_get_ticks() < deadline) {
+			reactor_umonitor(&reactor->hybrid_sleep);
+			if (__atomic_load_n(&reactor->hybrid_sleep,
+					    __ATOMIC_ACQUIRE) != REACTOR_HYBRID_SLEEPING) {
+				break;
+			}
+			reactor_umwait(deadline);
+		}
+		return;
+	}
+#endif
+	nsec = (deadline - now) * SPDK_SEC_TO_USEC / spdk_get_ticks_hz() * 1000;
+	ts.tv_sec = nsec / SPDK_SEC_TO_NSEC;
+	ts.tv_nsec = nsec % SPDK_SEC_TO_NSEC;
+
+	if (reactor->fgrp == NULL) {
+		/* No eventfd to wait on, so the sleep can't be cut short */
+		nanosleep(&ts, NULL);
+		return;
+	}
+
+	ppoll(&pfd, 1, &ts, NULL);
+}
+
+/* Sleep until the deadline or until a message or an event is sent to the reactor.  Sets woken
+ * to the time the reactor was woken up at, or 0 if it slept until the deadline.  Returns -EAGAIN
+ * without sleeping if there's work pending already. */
+static int
+reactor_hybrid_sleep(struct spdk_reactor *reactor, uint64_t now, uint64_t deadline,
+		     uint64_t *woken)
+{
+	struct spdk_lw_thread *lw_thread;
+	uint64_t notify;
+	bool sleep;
+
+	if (reactor->fgrp != NULL && !g_reactor_has_waitpkg) {
+		/* Drop a notification left over from a previous sleep */
+		if (read(reactor->events_fd, &notify, sizeof(notify)) < 0 && errno != EAGAIN) {
+			SPDK_ERRLOG("failed to acknowledge event queue: %s.\n", spdk_strerror(errno));
+		}
+	}
+
+	__atomic_store_n(&reactor->hybrid_sleep, REACTOR_HYBRID_SLEEPING, __ATOMIC_RELAXED);
+	/* A sender either sees the sleeping state or its event is visible below */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
+		if (spdk_thread_arm_wakeup(spdk_thread_get_from_ctx(lw_thread),
+					   &reactor->hybrid_wakeup) != 0) {
+			break;
+		}
+	}
+
+	sleep = lw_thread == NULL && spdk_ring_count(reactor->events) == 0;
+	if (sleep) {
+		reactor_hybrid_wait(reactor, now, deadline);
+	}
+
+	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
+		spdk_thread_disarm_wakeup(spdk_thread_get_from_ctx(lw_thread));
+	}
+
+	*woken = __atomic_exchange_n(&reactor->hybrid_sleep, 0, __ATOMIC_SEQ_CST);
+	if (*woken == REACTOR_HYBRID_SLEEPING) {
+		*woken = 0;
+	}
+
+	return sleep ? 0 : -EAGAIN;
+}
+
+static void
+reactor_hybrid_poll(struct spdk_reactor *reactor, bool busy)
+{
+	const struct spdk_reactor_hybrid_opts *opts = &reactor->hybrid_opts;
+	struct spdk_lw_thread *lw_thread;
+	uint64_t now, deadline, next, woken, latency;
+
+	if (busy) {
+		/* Go back to busy polling immediately and start with the shortest sleep once the
+		 * reactor becomes idle again. */
+		reactor->idle_iterations = 0;
+		reactor->sleep_us = opts->min_sleep_us;
+		return;
+	}
+
+	if (++reactor->idle_iterations < opts->idle_iterations) {
+		return;
+	}
+
+	/* Don't go to sleep if there's an event waiting already */
+	if (spdk_ring_count(reactor->events) != 0) {
+		return;
+	}
+
+	reactor->sleep_us = spdk_max(reactor->sleep_us, opts->min_sleep_us);
+	reactor->sleep_us = spdk_min(reactor->sleep_us, opts->max_sleep_us);
+
+	now = spdk_get_ticks();
+	deadline = now + reactor->sleep_us * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+
+	/* Never sleep through the expiration of a timed poller */
+	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
+		next = spdk_thread_next_poller_expiration(spdk_thread_get_from_ctx(lw_thread));
+		if (next != 0 && next < deadline) {
+			deadline = next;
+		}
+	}
+
+	if (deadline <= now) {
+		return;
+	}
+
+	/* Sleeping is not a stall */
+	reactor->watchdog_tsc = 0;
+	if (reactor_hybrid_sleep(reactor, now, deadline, &woken) != 0) {
+		return;
+	}
+
+	now = spdk_get_ticks();
+	reactor->sleep_count++;
+	if (woken != 0) {
+		/* Latency from sending the message or the event to the reactor running again */
+		latency = now > woken ? now - woken : 0;
+		reactor->wakeup_count++;
+		reactor->wakeup_latency_tsc += latency;
+		reactor->max_wakeup_latency_tsc = spdk_max(reactor->max_wakeup_latency_tsc, latency);
+	}
+
+	/* Time spent sleeping is accounted as idle time, so that the scheduler's view of the
+	 * reactor's load doesn't change. */
+	if (now > reactor->tsc_last) {
+		reactor->sleep_tsc += now - reactor->tsc_last;
+		reactor->idle_tsc += now - reactor->tsc_last;
+		reactor->tsc_last = now;
+	}
+
+	if (woken != 0) {
+		/* Work is arriving, start over with the shortest sleep */
+		reactor->idle_iterations = 0;
+		reactor->sleep_us = opts->min_sleep_us;
+	} else {
+		reactor->sleep_us = spdk_min(reactor->sleep_us * 2, opts->max_sleep_us);
+	}
 }
 
 static int
@@ -925,6 +1561,7 @@ reactor_run(void *arg)
 	struct spdk_lw_thread	*lw_thread, *tmp;
 	char			thread_name[32];
 	uint64_t		last_sched = 0;
+	bool			busy;
 
 	SPDK_NOTICELOG("Reactor started on core %u\n", reactor->lcore);
 
@@ -935,13 +1572,23 @@ reactor_run(void *arg)
 	_set_thread_name(thread_name);
 
 	reactor->tsc_last = spdk_get_ticks();
+	reactor->pthread = pthread_self();
 
 	while (1) {
+		if (spdk_unlikely(reactor->stall_captured)) {
+			reactor_watchdog_report(reactor);
+		}
+
 		/* Execute interrupt process fn if this reactor currently runs in interrupt state */
 		if (spdk_unlikely(reactor->in_interrupt)) {
+			reactor->watchdog_tsc = 0;
 			reactor_interrupt_run(reactor);
 		} else {
-			_reactor_run(reactor);
+			reactor->watchdog_tsc = reactor->tsc_last;
+			busy = _reactor_run(reactor);
+			if (spdk_unlikely(reactor->hybrid_opts.enabled)) {
+				reactor_hybrid_poll(reactor, busy);
+			}
 		}
 
 		if (g_framework_context_switch_monitor_enabled) {
@@ -965,6 +1612,8 @@ reactor_run(void *arg)
 		}
 	}
 
+	reactor->watchdog_tsc = 0;
+
 	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
 		thread = spdk_thread_get_from_ctx(lw_thread);
 		/* All threads should have already had spdk_thread_exit() called on them, except
@@ -1054,6 +1703,10 @@ spdk_reactors_start(void)
 		spdk_cpuset_set_cpu(&g_reactor_core_mask, i, true);
 	}
 
+	if (g_reactor_watchdog_budget_us != 0) {
+		reactor_watchdog_start();
+	}
+
 	/* Start the main reactor */
 	reactor = spdk_reactor_get(current_core);
 	assert(reactor != NULL);
@@ -1061,6 +1714,8 @@ spdk_reactors_start(void)
 
 	spdk_env_thread_wait_all();
 
+	reactor_watchdog_stop();
+
 	g_reactor_state = SPDK_REACTOR_STATE_SHUTDOWN;
 }
 
@@ -1896,6 +1896,18 @@ _dump_sw_error_reg(struct spdk_idxd_io_channel *chan)
 	idxd->impl->dump_sw_error(idxd, chan->portal);
 }
 
+int
+spdk_idxd_flush(struct spdk_idxd_io_channel *chan)
+{
+	assert(chan != NULL);
+
+	if (chan->batch == NULL) {
+		return 0;
+	}
+
+	return idxd_batch_submit(chan, NULL, NULL);
+}
+
 /* TODO: more performance experiments. */
 #define IDXD_COMPLETION(x) ((x) > (0) ? (1) : (0))
 #define IDXD_FAILURE(x) ((x) > (1) ? (1) : (0))
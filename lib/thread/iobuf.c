@@ -16,6 +16,7 @@
 #define IOBUF_ALIGNMENT			4096
 #define IOBUF_MIN_SMALL_BUFSIZE		4096
 #define IOBUF_MIN_LARGE_BUFSIZE		8192
+#define IOBUF_MIN_MEDIUM_POOL_SIZE	IOBUF_MIN_LARGE_POOL_SIZE
 #define IOBUF_DEFAULT_SMALL_BUFSIZE	(8 * 1024)
 /* 132k is a weird choice at first, but this needs to be large enough to accomodate
  * the default maximum size (128k) plus metadata everywhere. For code paths that
@@ -32,6 +33,7 @@ static bool g_iobuf_is_initialized = false;
 struct iobuf_channel {
 	spdk_iobuf_entry_stailq_t	small_queue;
 	spdk_iobuf_entry_stailq_t	large_queue;
+	spdk_iobuf_entry_stailq_t	medium_queue[SPDK_IOBUF_MAX_MEDIUM_CLASSES];
 	struct spdk_iobuf_channel	*channels[IOBUF_MAX_CHANNELS];
 };
 
@@ -45,6 +47,9 @@ struct iobuf {
 	struct spdk_ring		*large_pool;
 	void				*small_pool_base;
 	void				*large_pool_base;
+	struct spdk_ring		*medium_pool[SPDK_IOBUF_MAX_MEDIUM_CLASSES];
+	void				*medium_pool_base[SPDK_IOBUF_MAX_MEDIUM_CLASSES];
+	uint32_t			num_medium;
 	struct spdk_iobuf_opts		opts;
 	TAILQ_HEAD(, iobuf_module)	modules;
 	spdk_iobuf_finish_cb		finish_cb;
@@ -72,13 +77,31 @@ struct iobuf_get_stats_ctx {
 	void				*cb_arg;
 };
 
+static uint32_t
+iobuf_get_num_medium(const struct spdk_iobuf_opts *opts)
+{
+	uint32_t i;
+
+	for (i = 0; i < SPDK_IOBUF_MAX_MEDIUM_CLASSES; ++i) {
+		if (opts->medium_bufsize[i] == 0) {
+			break;
+		}
+	}
+
+	return i;
+}
+
 static int
 iobuf_channel_create_cb(void *io_device, void *ctx)
 {
 	struct iobuf_channel *ch = ctx;
+	uint32_t i;
 
 	STAILQ_INIT(&ch->small_queue);
 	STAILQ_INIT(&ch->large_queue);
+	for (i = 0; i < SPDK_IOBUF_MAX_MEDIUM_CLASSES; ++i) {
+		STAILQ_INIT(&ch->medium_queue[i]);
+	}
 
 	return 0;
 }
@@ -87,9 +110,13 @@ static void
 iobuf_channel_destroy_cb(void *io_device, void *ctx)
 {
 	struct iobuf_channel *ch __attribute__((unused)) = ctx;
+	uint32_t i __attribute__((unused));
 
 	assert(STAILQ_EMPTY(&ch->small_queue));
 	assert(STAILQ_EMPTY(&ch->large_queue));
+	for (i = 0; i < SPDK_IOBUF_MAX_MEDIUM_CLASSES; ++i) {
+		assert(STAILQ_EMPTY(&ch->medium_queue[i]));
+	}
 }
 
 int
@@ -98,6 +125,7 @@ spdk_iobuf_initialize(void)
 	struct spdk_iobuf_opts *opts = &g_iobuf.opts;
 	int rc = 0;
 	uint64_t i;
+	uint32_t j;
 	struct spdk_iobuf_buffer *buf;
 
 	g_iobuf.small_pool = spdk_ring_create(SPDK_RING_TYPE_MP_MC, opts->small_pool_count,
@@ -136,6 +164,29 @@ spdk_iobuf_initialize(void)
 		goto error;
 	}
 
+	g_iobuf.num_medium = iobuf_get_num_medium(opts);
+	for (j = 0; j < g_iobuf.num_medium; j++) {
+		g_iobuf.medium_pool[j] = spdk_ring_create(SPDK_RING_TYPE_MP_MC,
+					 opts->medium_pool_count[j],
+					 SPDK_ENV_SOCKET_ID_ANY);
+		if (!g_iobuf.medium_pool[j]) {
+			SPDK_ERRLOG("Failed to create medium iobuf pool %"PRIu32"\n", j);
+			rc = -ENOMEM;
+			goto error;
+		}
+
+		/* Round up to the nearest alignment so that each element remains aligned */
+		opts->medium_bufsize[j] = SPDK_ALIGN_CEIL(opts->medium_bufsize[j], IOBUF_ALIGNMENT);
+		g_iobuf.medium_pool_base[j] = spdk_malloc(opts->medium_bufsize[j] *
+					      opts->medium_pool_count[j], IOBUF_ALIGNMENT, NULL,
+					      SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+		if (g_iobuf.medium_pool_base[j] == NULL) {
+			SPDK_ERRLOG("Unable to allocate requested medium iobuf pool %"PRIu32" size\n", j);
+			rc = -ENOMEM;
+			goto error;
+		}
+	}
+
 	for (i = 0; i < opts->small_pool_count; i++) {
 		buf = g_iobuf.small_pool_base + i * opts->small_bufsize;
 		spdk_ring_enqueue(g_iobuf.small_pool, (void **)&buf, 1, NULL);
@@ -146,6 +197,13 @@ spdk_iobuf_initialize(void)
 		spdk_ring_enqueue(g_iobuf.large_pool, (void **)&buf, 1, NULL);
 	}
 
+	for (j = 0; j < g_iobuf.num_medium; j++) {
+		for (i = 0; i < opts->medium_pool_count[j]; i++) {
+			buf = g_iobuf.medium_pool_base[j] + i * opts->medium_bufsize[j];
+			spdk_ring_enqueue(g_iobuf.medium_pool[j], (void **)&buf, 1, NULL);
+		}
+	}
+
 	spdk_io_device_register(&g_iobuf, iobuf_channel_create_cb, iobuf_channel_destroy_cb,
 				sizeof(struct iobuf_channel), "iobuf");
 	g_iobuf_is_initialized = true;
@@ -156,6 +214,12 @@ error:
 	spdk_ring_free(g_iobuf.small_pool);
 	spdk_free(g_iobuf.large_pool_base);
 	spdk_ring_free(g_iobuf.large_pool);
+	for (j = 0; j < SPDK_IOBUF_MAX_MEDIUM_CLASSES; j++) {
+		spdk_free(g_iobuf.medium_pool_base[j]);
+		g_iobuf.medium_pool_base[j] = NULL;
+		spdk_ring_free(g_iobuf.medium_pool[j]);
+		g_iobuf.medium_pool[j] = NULL;
+	}
 
 	return rc;
 }
@@ -164,6 +228,7 @@ static void
 iobuf_unregister_cb(void *io_device)
 {
 	struct iobuf_module *module;
+	uint32_t i;
 
 	while (!TAILQ_EMPTY(&g_iobuf.modules)) {
 		module = TAILQ_FIRST(&g_iobuf.modules);
@@ -192,6 +257,19 @@ iobuf_unregister_cb(void *io_device)
 	spdk_ring_free(g_iobuf.large_pool);
 	g_iobuf.large_pool = NULL;
 
+	for (i = 0; i < g_iobuf.num_medium; i++) {
+		if (spdk_ring_count(g_iobuf.medium_pool[i]) != g_iobuf.opts.medium_pool_count[i]) {
+			SPDK_ERRLOG("medium iobuf pool %"PRIu32" count is %zu, expected %"PRIu64"\n", i,
+				    spdk_ring_count(g_iobuf.medium_pool[i]), g_iobuf.opts.medium_pool_count[i]);
+		}
+
+		spdk_free(g_iobuf.medium_pool_base[i]);
+		g_iobuf.medium_pool_base[i] = NULL;
+		spdk_ring_free(g_iobuf.medium_pool[i]);
+		g_iobuf.medium_pool[i] = NULL;
+	}
+	g_iobuf.num_medium = 0;
+
 	if (g_iobuf.finish_cb != NULL) {
 		g_iobuf.finish_cb(g_iobuf.finish_arg);
 	}
@@ -215,6 +293,9 @@ spdk_iobuf_finish(spdk_iobuf_finish_cb cb_fn, void *cb_arg)
 int
 spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
 {
+	struct spdk_iobuf_opts tmp = {};
+	uint32_t i, num_medium, prev_bufsize, bufsize;
+
 	if (!opts) {
 		SPDK_ERRLOG("opts cannot be NULL\n");
 		return -1;
@@ -248,6 +329,47 @@ spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
 		return -EINVAL;
 	}
 
+	/* Keep the current medium size classes unless the caller knows about them */
+	if (offsetof(struct spdk_iobuf_opts, medium_cache_size) + sizeof(opts->medium_cache_size) <=
+	    opts->opts_size) {
+		memcpy(tmp.medium_bufsize, opts->medium_bufsize, sizeof(tmp.medium_bufsize));
+		memcpy(tmp.medium_pool_count, opts->medium_pool_count, sizeof(tmp.medium_pool_count));
+		memcpy(tmp.medium_cache_size, opts->medium_cache_size, sizeof(tmp.medium_cache_size));
+	} else {
+		memcpy(tmp.medium_bufsize, g_iobuf.opts.medium_bufsize, sizeof(tmp.medium_bufsize));
+		memcpy(tmp.medium_pool_count, g_iobuf.opts.medium_pool_count,
+		       sizeof(tmp.medium_pool_count));
+		memcpy(tmp.medium_cache_size, g_iobuf.opts.medium_cache_size,
+		       sizeof(tmp.medium_cache_size));
+	}
+
+	/* The buffer sizes are rounded up to IOBUF_ALIGNMENT by spdk_iobuf_initialize(), so
+	 * validate the rounded values to make sure that no two size classes end up identical. */
+	num_medium = iobuf_get_num_medium(&tmp);
+	prev_bufsize = SPDK_ALIGN_CEIL(opts->small_bufsize, IOBUF_ALIGNMENT);
+	for (i = 0; i < num_medium; i++) {
+		bufsize = SPDK_ALIGN_CEIL(tmp.medium_bufsize[i], IOBUF_ALIGNMENT);
+		if (bufsize <= prev_bufsize) {
+			SPDK_ERRLOG("medium_bufsize[%" PRIu32 "] (%" PRIu32 " aligned to %" PRIu32 ") must be "
+				    "greater than %" PRIu32 "\n", i, tmp.medium_bufsize[i], bufsize,
+				    prev_bufsize);
+			return -EINVAL;
+		}
+		if (tmp.medium_pool_count[i] < IOBUF_MIN_MEDIUM_POOL_SIZE) {
+			SPDK_ERRLOG("medium_pool_count[%" PRIu32 "] must be at least %" PRIu32 "\n",
+				    i, IOBUF_MIN_MEDIUM_POOL_SIZE);
+			return -EINVAL;
+		}
+		prev_bufsize = bufsize;
+	}
+
+	if (num_medium > 0 && SPDK_ALIGN_CEIL(opts->large_bufsize, IOBUF_ALIGNMENT) <= prev_bufsize) {
+		SPDK_ERRLOG("large_bufsize (aligned to %" PRIu32 ") must be greater than the largest "
+			    "medium_bufsize (%" PRIu32 ")\n",
+			    (uint32_t)SPDK_ALIGN_CEIL(opts->large_bufsize, IOBUF_ALIGNMENT), prev_bufsize);
+		return -EINVAL;
+	}
+
 #define SET_FIELD(field) \
         if (offsetof(struct spdk_iobuf_opts, field) + sizeof(opts->field) <= opts->opts_size) { \
                 g_iobuf.opts.field = opts->field; \
@@ -262,6 +384,15 @@ spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
 
 #undef SET_FIELD
 
+	memcpy(g_iobuf.opts.medium_bufsize, tmp.medium_bufsize, sizeof(tmp.medium_bufsize));
+	memcpy(g_iobuf.opts.medium_pool_count, tmp.medium_pool_count, sizeof(tmp.medium_pool_count));
+	memcpy(g_iobuf.opts.medium_cache_size, tmp.medium_cache_size, sizeof(tmp.medium_cache_size));
+	for (i = num_medium; i < SPDK_IOBUF_MAX_MEDIUM_CLASSES; i++) {
+		g_iobuf.opts.medium_bufsize[i] = 0;
+		g_iobuf.opts.medium_pool_count[i] = 0;
+		g_iobuf.opts.medium_cache_size[i] = 0;
+	}
+
 	return 0;
 }
 
@@ -292,9 +423,20 @@ spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts, size_t opts_size)
 
 #undef SET_FIELD
 
+#define SET_ARRAY_FIELD(field) \
+	if (offsetof(struct spdk_iobuf_opts, field) + sizeof(opts->field) <= opts_size) { \
+		memcpy(opts->field, g_iobuf.opts.field, sizeof(opts->field)); \
+	} \
+
+	SET_ARRAY_FIELD(medium_pool_count);
+	SET_ARRAY_FIELD(medium_bufsize);
+	SET_ARRAY_FIELD(medium_cache_size);
+
+#undef SET_ARRAY_FIELD
+
 	/* Do not remove this statement, you should always update this statement when you adding a new field,
 	 * and do not forget to add the SET_FIELD statement for your added field. */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_iobuf_opts) == 32, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_iobuf_opts) == 96, "Incorrect size");
 }
 
 
@@ -306,7 +448,7 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 	struct iobuf_channel *iobuf_ch;
 	struct iobuf_module *module;
 	struct spdk_iobuf_buffer *buf;
-	uint32_t i;
+	uint32_t i, j;
 
 	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
 		if (strcmp(name, module->name) == 0) {
@@ -355,6 +497,20 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 	STAILQ_INIT(&ch->small.cache);
 	STAILQ_INIT(&ch->large.cache);
 
+	ch->num_medium = g_iobuf.num_medium;
+	for (i = 0; i < SPDK_IOBUF_MAX_MEDIUM_CLASSES; ++i) {
+		ch->medium[i].queue = &iobuf_ch->medium_queue[i];
+		ch->medium[i].pool = g_iobuf.medium_pool[i];
+		ch->medium[i].bufsize = g_iobuf.opts.medium_bufsize[i];
+		ch->medium[i].cache_size = 0;
+		/* Modules that don't cache small and large buffers don't cache medium ones either */
+		if (i < ch->num_medium && (small_cache_size > 0 || large_cache_size > 0)) {
+			ch->medium[i].cache_size = g_iobuf.opts.medium_cache_size[i];
+		}
+		ch->medium[i].cache_count = 0;
+		STAILQ_INIT(&ch->medium[i].cache);
+	}
+
 	for (i = 0; i < small_cache_size; ++i) {
 		if (spdk_ring_dequeue(g_iobuf.small_pool, (void **)&buf, 1) == 0) {
 			SPDK_ERRLOG("Failed to populate '%s' iobuf small buffer cache at %d/%d entries. "
@@ -379,6 +535,20 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 		STAILQ_INSERT_TAIL(&ch->large.cache, buf, stailq);
 		ch->large.cache_count++;
 	}
+	for (j = 0; j < ch->num_medium; ++j) {
+		for (i = 0; i < ch->medium[j].cache_size; ++i) {
+			if (spdk_ring_dequeue(ch->medium[j].pool, (void **)&buf, 1) == 0) {
+				SPDK_ERRLOG("Failed to populate '%s' iobuf medium (%"PRIu32") buffer cache at "
+					    "%d/%d entries. You may need to increase "
+					    "spdk_iobuf_opts.medium_pool_count[%"PRIu32"] (%"PRIu64")\n",
+					    name, ch->medium[j].bufsize, i, ch->medium[j].cache_size, j,
+					    g_iobuf.opts.medium_pool_count[j]);
+				goto error;
+			}
+			STAILQ_INSERT_TAIL(&ch->medium[j].cache, buf, stailq);
+			ch->medium[j].cache_count++;
+		}
+	}
 
 	return 0;
 error:
@@ -392,6 +562,7 @@ spdk_iobuf_channel_fini(struct spdk_iobuf_channel *ch)
 {
 	struct spdk_iobuf_entry *entry __attribute__((unused));
 	struct spdk_iobuf_buffer *buf;
+	struct spdk_iobuf_pool *pool;
 	struct iobuf_channel *iobuf_ch;
 	uint32_t i;
 
@@ -402,6 +573,11 @@ spdk_iobuf_channel_fini(struct spdk_iobuf_channel *ch)
 	STAILQ_FOREACH(entry, ch->large.queue, stailq) {
 		assert(entry->module != ch->module);
 	}
+	for (i = 0; i < ch->num_medium; ++i) {
+		STAILQ_FOREACH(entry, ch->medium[i].queue, stailq) {
+			assert(entry->module != ch->module);
+		}
+	}
 
 	/* Release cached buffers back to the pool */
 	while (!STAILQ_EMPTY(&ch->small.cache)) {
@@ -416,6 +592,16 @@ spdk_iobuf_channel_fini(struct spdk_iobuf_channel *ch)
 		spdk_ring_enqueue(g_iobuf.large_pool, (void **)&buf, 1, NULL);
 		ch->large.cache_count--;
 	}
+	for (i = 0; i < ch->num_medium; ++i) {
+		pool = &ch->medium[i];
+		while (!STAILQ_EMPTY(&pool->cache)) {
+			buf = STAILQ_FIRST(&pool->cache);
+			STAILQ_REMOVE_HEAD(&pool->cache, stailq);
+			spdk_ring_enqueue(pool->pool, (void **)&buf, 1, NULL);
+			pool->cache_count--;
+		}
+		assert(pool->cache_count == 0);
+	}
 
 	assert(ch->small.cache_count == 0);
 	assert(ch->large.cache_count == 0);
@@ -498,19 +684,31 @@ spdk_iobuf_for_each_entry(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool
 	return 0;
 }
 
-void
-spdk_iobuf_entry_abort(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *entry,
-		       uint64_t len)
+static inline struct spdk_iobuf_pool *
+iobuf_get_pool(struct spdk_iobuf_channel *ch, uint64_t len)
 {
-	struct spdk_iobuf_pool *pool;
+	uint32_t i;
 
 	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		assert(len <= ch->large.bufsize);
-		pool = &ch->large;
+		return &ch->small;
+	}
+
+	for (i = 0; i < ch->num_medium; i++) {
+		if (len <= ch->medium[i].bufsize) {
+			return &ch->medium[i];
+		}
 	}
 
+	assert(len <= ch->large.bufsize);
+	return &ch->large;
+}
+
+void
+spdk_iobuf_entry_abort(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *entry,
+		       uint64_t len)
+{
+	struct spdk_iobuf_pool *pool = iobuf_get_pool(ch, len);
+
 	STAILQ_REMOVE(pool->queue, entry, spdk_iobuf_entry, stailq);
 }
 
@@ -524,12 +722,7 @@ spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len,
 	void *buf;
 
 	assert(spdk_io_channel_get_thread(ch->parent) == spdk_get_thread());
-	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		assert(len <= ch->large.bufsize);
-		pool = &ch->large;
-	}
+	pool = iobuf_get_pool(ch, len);
 
 	buf = (void *)STAILQ_FIRST(&pool->cache);
 	if (buf) {
@@ -577,11 +770,7 @@ spdk_iobuf_put(struct spdk_iobuf_channel *ch, void *buf, uint64_t len)
 	size_t sz;
 
 	assert(spdk_io_channel_get_thread(ch->parent) == spdk_get_thread());
-	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		pool = &ch->large;
-	}
+	pool = iobuf_get_pool(ch, len);
 
 	if (STAILQ_EMPTY(pool->queue)) {
 		if (pool->cache_size == 0) {
@@ -637,7 +826,7 @@ iobuf_get_channel_stats(struct spdk_io_channel_iter *iter)
 	struct spdk_iobuf_channel *channel;
 	struct iobuf_module *module;
 	struct spdk_iobuf_module_stats *it;
-	uint32_t i, j;
+	uint32_t i, j, k;
 
 	for (i = 0; i < ctx->num_modules; ++i) {
 		for (j = 0; j < IOBUF_MAX_CHANNELS; ++j) {
@@ -655,6 +844,11 @@ iobuf_get_channel_stats(struct spdk_io_channel_iter *iter)
 				it->large_pool.cache += channel->large.stats.cache;
 				it->large_pool.main += channel->large.stats.main;
 				it->large_pool.retry += channel->large.stats.retry;
+				for (k = 0; k < channel->num_medium; ++k) {
+					it->medium_pool[k].cache += channel->medium[k].stats.cache;
+					it->medium_pool[k].main += channel->medium[k].stats.main;
+					it->medium_pool[k].retry += channel->medium[k].stats.retry;
+				}
 				break;
 			}
 		}
@@ -688,6 +882,7 @@ spdk_iobuf_get_stats(spdk_iobuf_get_stats_cb cb_fn, void *cb_arg)
 	i = 0;
 	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
 		ctx->modules[i].module = module->name;
+		ctx->modules[i].num_medium_pools = g_iobuf.num_medium;
 		++i;
 	}
 
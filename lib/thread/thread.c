@@ -32,6 +32,8 @@
 #endif
 
 #define SPDK_MSG_BATCH_SIZE		8
+#define MSG_CACHE_LOW_WATERMARK		(SPDK_MSG_MEMPOOL_CACHE_SIZE * 3 / 4)
+#define MSG_CACHE_BATCH_SIZE		32
 #define SPDK_MAX_DEVICE_NAME_LEN	256
 #define SPDK_THREAD_EXIT_TIMEOUT_SEC	5
 #define SPDK_MAX_POLLER_NAME_LEN	256
@@ -79,6 +81,8 @@ struct spdk_poller {
 	uint64_t			next_run_tick;
 	uint64_t			run_count;
 	uint64_t			busy_count;
+	uint64_t			run_tsc;
+	uint64_t			max_run_tsc;
 	uint64_t			id;
 	spdk_poller_fn			fn;
 	void				*arg;
@@ -88,6 +92,8 @@ struct spdk_poller {
 	void				*set_intr_cb_arg;
 
 	char				name[SPDK_MAX_POLLER_NAME_LEN + 1];
+
+	uint64_t			run_tsc_histogram[SPDK_POLLER_RUN_TSC_HISTOGRAM_BUCKETS];
 };
 
 enum spdk_thread_state {
@@ -126,9 +132,13 @@ struct spdk_thread {
 	TAILQ_HEAD(paused_pollers_head, spdk_poller)	paused_pollers;
 	struct spdk_ring		*messages;
 	int				msg_fd;
-	SLIST_HEAD(, spdk_msg)		msg_cache;
-	size_t				msg_cache_count;
+	struct spdk_obj_cache		msg_cache;
 	spdk_msg_fn			critical_msg;
+	/* Hook armed while the poll loop of the thread sleeps */
+	const struct spdk_thread_wakeup	*wakeup;
+	/* The poller or the message currently being executed, for diagnostics */
+	struct spdk_poller		*running_poller;
+	spdk_msg_fn			running_msg_fn;
 	uint64_t			id;
 	uint64_t			next_poller_id;
 	enum spdk_thread_state		state;
@@ -158,6 +168,9 @@ struct spdk_thread {
 
 static pthread_mutex_t g_devlist_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* Set once any thread arms a wakeup hook, keeps the hook check off the send path otherwise */
+static bool g_thread_wakeup_used;
+
 static spdk_new_thread_fn g_new_thread_fn = NULL;
 static spdk_thread_op_fn g_thread_op_fn = NULL;
 static spdk_thread_op_supported_fn g_thread_op_supported_fn;
@@ -275,8 +288,6 @@ RB_GENERATE_STATIC(io_channel_tree, spdk_io_channel, node, io_channel_cmp);
 struct spdk_msg {
 	spdk_msg_fn		fn;
 	void			*arg;
-
-	SLIST_ENTRY(spdk_msg)	link;
 };
 
 static struct spdk_mempool *g_spdk_msg_mempool = NULL;
@@ -298,6 +309,14 @@ SPDK_TRACE_REGISTER_FN(thread_trace, "thread", TRACE_GROUP_THREAD)
 			"THREAD_IOCH_PUT", TRACE_THREAD_IOCH_PUT,
 			OWNER_TYPE_NONE, OBJECT_NONE, 0,
 			{{ "refcnt", SPDK_TRACE_ARG_TYPE_INT, 4 }}
+		},
+		{
+			"THREAD_STALL", TRACE_THREAD_STALL,
+			OWNER_TYPE_NONE, OBJECT_NONE, 0,
+			{
+				{ "duration", SPDK_TRACE_ARG_TYPE_INT, 8 },
+				{ "function", SPDK_TRACE_ARG_TYPE_STR, 40 }
+			}
 		}
 	};
 
@@ -364,7 +383,6 @@ static void
 _free_thread(struct spdk_thread *thread)
 {
 	struct spdk_io_channel *ch;
-	struct spdk_msg *msg;
 	struct spdk_poller *poller, *ptmp;
 
 	RB_FOREACH(ch, io_channel_tree, &thread->io_channels) {
@@ -402,18 +420,7 @@ _free_thread(struct spdk_thread *thread)
 	TAILQ_REMOVE(&g_threads, thread, tailq);
 	pthread_mutex_unlock(&g_devlist_mutex);
 
-	msg = SLIST_FIRST(&thread->msg_cache);
-	while (msg != NULL) {
-		SLIST_REMOVE_HEAD(&thread->msg_cache, link);
-
-		assert(thread->msg_cache_count > 0);
-		thread->msg_cache_count--;
-		spdk_mempool_put(g_spdk_msg_mempool, msg);
-
-		msg = SLIST_FIRST(&thread->msg_cache);
-	}
-
-	assert(thread->msg_cache_count == 0);
+	spdk_obj_cache_fini(&thread->msg_cache);
 
 	if (spdk_interrupt_mode_is_enabled()) {
 		thread_interrupt_destroy(thread);
@@ -490,8 +497,8 @@ struct spdk_thread *
 spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 {
 	struct spdk_thread *thread, *null_thread;
-	struct spdk_msg *msgs[SPDK_MSG_MEMPOOL_CACHE_SIZE];
-	int rc = 0, i;
+	struct spdk_obj_cache_opts cache_opts = {};
+	int rc = 0;
 
 	thread = calloc(1, sizeof(*thread) + g_ctx_sz);
 	if (!thread) {
@@ -509,8 +516,6 @@ spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 	TAILQ_INIT(&thread->active_pollers);
 	RB_INIT(&thread->timed_pollers);
 	TAILQ_INIT(&thread->paused_pollers);
-	SLIST_INIT(&thread->msg_cache);
-	thread->msg_cache_count = 0;
 
 	thread->tsc_last = spdk_get_ticks();
 
@@ -526,17 +531,22 @@ spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 		return NULL;
 	}
 
-	/* Fill the local message pool cache. */
-	rc = spdk_mempool_get_bulk(g_spdk_msg_mempool, (void **)msgs, SPDK_MSG_MEMPOOL_CACHE_SIZE);
-	if (rc == 0) {
-		/* If we can't populate the cache it's ok. The cache will get filled
-		 * up organically as messages are passed to the thread. */
-		for (i = 0; i < SPDK_MSG_MEMPOOL_CACHE_SIZE; i++) {
-			SLIST_INSERT_HEAD(&thread->msg_cache, msgs[i], link);
-			thread->msg_cache_count++;
-		}
+	cache_opts.opts_size = sizeof(cache_opts);
+	cache_opts.high_watermark = SPDK_MSG_MEMPOOL_CACHE_SIZE;
+	cache_opts.low_watermark = MSG_CACHE_LOW_WATERMARK;
+	cache_opts.batch_size = MSG_CACHE_BATCH_SIZE;
+	rc = spdk_obj_cache_init(&thread->msg_cache, g_spdk_msg_mempool, &cache_opts);
+	if (rc != 0) {
+		SPDK_ERRLOG("Unable to initialize message cache\n");
+		spdk_ring_free(thread->messages);
+		free(thread);
+		return NULL;
 	}
 
+	/* Fill the local message pool cache.  If we can't populate the cache it's ok. The cache
+	 * will get filled up organically as messages are passed to the thread. */
+	spdk_obj_cache_fill(&thread->msg_cache, SPDK_MSG_MEMPOOL_CACHE_SIZE);
+
 	if (name) {
 		snprintf(thread->name, sizeof(thread->name), "%s", name);
 	} else {
@@ -851,19 +861,14 @@ msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 
 		SPDK_DTRACE_PROBE2(msg_exec, msg->fn, msg->arg);
 
+		thread->running_msg_fn = msg->fn;
 		msg->fn(msg->arg);
 
 		SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
 
-		if (thread->msg_cache_count < SPDK_MSG_MEMPOOL_CACHE_SIZE) {
-			/* Insert the messages at the head. We want to re-use the hot
-			 * ones. */
-			SLIST_INSERT_HEAD(&thread->msg_cache, msg, link);
-			thread->msg_cache_count++;
-		} else {
-			spdk_mempool_put(g_spdk_msg_mempool, msg);
-		}
+		spdk_obj_cache_put(&thread->msg_cache, msg);
 	}
+	thread->running_msg_fn = NULL;
 
 	return count;
 }
@@ -933,9 +938,30 @@ thread_update_stats(struct spdk_thread *thread, uint64_t end,
 	thread->tsc_last = end;
 }
 
+static inline void
+poller_update_run_stats(struct spdk_poller *poller, uint64_t run_tsc)
+{
+	uint64_t bucket = 0;
+
+	poller->run_tsc += run_tsc;
+	if (run_tsc > poller->max_run_tsc) {
+		poller->max_run_tsc = run_tsc;
+	}
+
+	if (run_tsc != 0) {
+		bucket = spdk_min(spdk_u64log2(run_tsc), SPDK_POLLER_RUN_TSC_HISTOGRAM_BUCKETS - 1);
+	}
+	poller->run_tsc_histogram[bucket]++;
+}
+
+/* The tsc argument holds the time the poller started executing and is updated
+ * with the time it finished, so that consecutive pollers share a single
+ * timestamp read.
+ */
 static inline int
-thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
+thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller, uint64_t *tsc)
 {
+	uint64_t end;
 	int rc;
 
 	switch (poller->state) {
@@ -956,7 +982,10 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 	}
 
 	poller->state = SPDK_POLLER_STATE_RUNNING;
+	thread->running_poller = poller;
 	rc = poller->fn(poller->arg);
+	thread->running_poller = NULL;
+	end = spdk_get_ticks();
 
 	SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
 
@@ -964,6 +993,8 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 	if (rc > 0) {
 		poller->busy_count++;
 	}
+	poller_update_run_stats(poller, end - *tsc);
+	*tsc = end;
 
 #ifdef DEBUG
 	if (rc == -1) {
@@ -997,8 +1028,9 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 
 static inline int
 thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poller,
-			    uint64_t now)
+			    uint64_t now, uint64_t *tsc)
 {
+	uint64_t end;
 	int rc;
 
 	switch (poller->state) {
@@ -1017,7 +1049,10 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 	}
 
 	poller->state = SPDK_POLLER_STATE_RUNNING;
+	thread->running_poller = poller;
 	rc = poller->fn(poller->arg);
+	thread->running_poller = NULL;
+	end = spdk_get_ticks();
 
 	SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
 
@@ -1025,6 +1060,8 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 	if (rc > 0) {
 		poller->busy_count++;
 	}
+	poller_update_run_stats(poller, end - *tsc);
+	*tsc = end;
 
 #ifdef DEBUG
 	if (rc == -1) {
@@ -1062,6 +1099,7 @@ thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 	uint32_t msg_count;
 	struct spdk_poller *poller, *tmp;
 	spdk_msg_fn critical_msg;
+	uint64_t tsc;
 	int rc = 0;
 
 	thread->tsc_last = now;
@@ -1078,11 +1116,12 @@ thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 		rc = 1;
 	}
 
+	tsc = spdk_get_ticks();
 	TAILQ_FOREACH_REVERSE_SAFE(poller, &thread->active_pollers,
 				   active_pollers_head, tailq, tmp) {
 		int poller_rc;
 
-		poller_rc = thread_execute_poller(thread, poller);
+		poller_rc = thread_execute_poller(thread, poller, &tsc);
 		if (poller_rc > rc) {
 			rc = poller_rc;
 		}
@@ -1107,7 +1146,7 @@ thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 			thread->first_timed_poller = tmp;
 		}
 
-		timer_rc = thread_execute_timed_poller(thread, poller, now);
+		timer_rc = thread_execute_timed_poller(thread, poller, now, &tsc);
 		if (timer_rc > rc) {
 			rc = timer_rc;
 		}
@@ -1328,9 +1367,20 @@ spdk_thread_get_last_tsc(struct spdk_thread *thread)
 static inline int
 thread_send_msg_notification(const struct spdk_thread *target_thread)
 {
+	const struct spdk_thread_wakeup *wakeup;
 	uint64_t notify = 1;
 	int rc;
 
+	if (spdk_unlikely(__atomic_load_n(&g_thread_wakeup_used, __ATOMIC_RELAXED))) {
+		/* Order the message enqueue before the hook check, pairs with the fence in
+		 * spdk_thread_arm_wakeup(). */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		wakeup = __atomic_load_n(&target_thread->wakeup, __ATOMIC_ACQUIRE);
+		if (wakeup != NULL) {
+			wakeup->fn(wakeup->ctx);
+		}
+	}
+
 	/* Not necessary to do notification if interrupt facility is not enabled */
 	if (spdk_likely(!spdk_interrupt_mode_is_enabled())) {
 		return 0;
@@ -1367,22 +1417,15 @@ spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx
 
 	local_thread = _get_thread();
 
-	msg = NULL;
 	if (local_thread != NULL) {
-		if (local_thread->msg_cache_count > 0) {
-			msg = SLIST_FIRST(&local_thread->msg_cache);
-			assert(msg != NULL);
-			SLIST_REMOVE_HEAD(&local_thread->msg_cache, link);
-			local_thread->msg_cache_count--;
-		}
+		msg = spdk_obj_cache_get(&local_thread->msg_cache);
+	} else {
+		msg = spdk_mempool_get(g_spdk_msg_mempool);
 	}
 
-	if (msg == NULL) {
-		msg = spdk_mempool_get(g_spdk_msg_mempool);
-		if (!msg) {
-			SPDK_ERRLOG("msg could not be allocated\n");
-			return -ENOMEM;
-		}
+	if (!msg) {
+		SPDK_ERRLOG("msg could not be allocated\n");
+		return -ENOMEM;
 	}
 
 	msg->fn = fn;
@@ -1926,6 +1969,57 @@ spdk_poller_get_stats(struct spdk_poller *poller, struct spdk_poller_stats *stat
 {
 	stats->run_count = poller->run_count;
 	stats->busy_count = poller->busy_count;
+	stats->run_tsc = poller->run_tsc;
+	stats->max_run_tsc = poller->max_run_tsc;
+	memcpy(stats->run_tsc_histogram, poller->run_tsc_histogram,
+	       sizeof(stats->run_tsc_histogram));
+}
+
+void *
+spdk_thread_get_running_fn(struct spdk_thread *thread, const char **poller_name)
+{
+	struct spdk_poller *poller = thread->running_poller;
+
+	if (poller != NULL) {
+		*poller_name = poller->name;
+		return (void *)poller->fn;
+	}
+
+	*poller_name = NULL;
+	return (void *)thread->running_msg_fn;
+}
+
+const struct spdk_obj_cache *
+spdk_thread_get_msg_cache(struct spdk_thread *thread)
+{
+	return &thread->msg_cache;
+}
+
+int
+spdk_thread_arm_wakeup(struct spdk_thread *thread, const struct spdk_thread_wakeup *wakeup)
+{
+	/* A sender racing with the very first arm may miss the hook, callers bound their sleeps */
+	if (spdk_unlikely(!__atomic_load_n(&g_thread_wakeup_used, __ATOMIC_RELAXED))) {
+		__atomic_store_n(&g_thread_wakeup_used, true, __ATOMIC_RELAXED);
+	}
+
+	__atomic_store_n(&thread->wakeup, wakeup, __ATOMIC_RELEASE);
+	/* A sender either sees the hook or its message is visible here */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	if (spdk_ring_count(thread->messages) != 0 ||
+	    __atomic_load_n(&thread->critical_msg, __ATOMIC_RELAXED) != NULL) {
+		__atomic_store_n(&thread->wakeup, NULL, __ATOMIC_RELAXED);
+		return -EAGAIN;
+	}
+
+	return 0;
+}
+
+void
+spdk_thread_disarm_wakeup(struct spdk_thread *thread)
+{
+	__atomic_store_n(&thread->wakeup, NULL, __ATOMIC_RELEASE);
 }
 
 struct spdk_poller *
@@ -3118,4 +3212,167 @@ spdk_spin_held(struct spdk_spinlock *sspin)
 	return sspin->thread == thread;
 }
 
+/* Overlaid on the first bytes of each cached object */
+struct obj_cache_entry {
+	struct obj_cache_entry	*next;
+};
+
+int
+spdk_obj_cache_init(struct spdk_obj_cache *cache, struct spdk_mempool *pool,
+		    const struct spdk_obj_cache_opts *opts)
+{
+	if (pool == NULL || opts == NULL || opts->opts_size == 0) {
+		return -EINVAL;
+	}
+
+	memset(cache, 0, sizeof(*cache));
+	cache->pool = pool;
+	cache->high_watermark = 0;
+	cache->low_watermark = 0;
+	cache->batch_size = 1;
+
+#define SET_FIELD(field) \
+	if (offsetof(struct spdk_obj_cache_opts, field) + sizeof(opts->field) <= opts->opts_size) { \
+		cache->field = opts->field; \
+	}
+
+	SET_FIELD(high_watermark);
+	cache->low_watermark = cache->high_watermark;
+	SET_FIELD(low_watermark);
+	SET_FIELD(batch_size);
+
+#undef SET_FIELD
+
+	if (cache->low_watermark > cache->high_watermark) {
+		SPDK_ERRLOG("Object cache low watermark (%" PRIu32 ") is greater than the high "
+			    "watermark (%" PRIu32 ")\n", cache->low_watermark, cache->high_watermark);
+		return -EINVAL;
+	}
+
+	if (cache->batch_size == 0 || cache->batch_size > SPDK_OBJ_CACHE_MAX_BATCH) {
+		SPDK_ERRLOG("Object cache batch size (%" PRIu32 ") must be in the range of 1 to %d\n",
+			    cache->batch_size, SPDK_OBJ_CACHE_MAX_BATCH);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+obj_cache_return(struct spdk_obj_cache *cache, uint32_t count)
+{
+	struct obj_cache_entry *entry;
+	void *objs[SPDK_OBJ_CACHE_MAX_BATCH];
+	uint32_t i, num;
+
+	assert(count <= cache->count);
+	while (count > 0) {
+		num = spdk_min(count, SPDK_OBJ_CACHE_MAX_BATCH);
+		for (i = 0; i < num; i++) {
+			entry = cache->head;
+			assert(entry != NULL);
+			cache->head = entry->next;
+			objs[i] = entry;
+		}
+
+		spdk_mempool_put_bulk(cache->pool, objs, num);
+		cache->count -= num;
+		count -= num;
+	}
+}
+
+void
+spdk_obj_cache_fini(struct spdk_obj_cache *cache)
+{
+	if (cache->pool == NULL) {
+		return;
+	}
+
+	obj_cache_return(cache, cache->count);
+	assert(cache->head == NULL);
+}
+
+static int
+obj_cache_refill(struct spdk_obj_cache *cache, uint32_t count)
+{
+	struct obj_cache_entry *entry;
+	void *objs[SPDK_OBJ_CACHE_MAX_BATCH];
+	uint32_t i;
+
+	assert(count <= SPDK_OBJ_CACHE_MAX_BATCH);
+	if (spdk_mempool_get_bulk(cache->pool, objs, count) != 0) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < count; i++) {
+		entry = objs[i];
+		entry->next = cache->head;
+		cache->head = entry;
+	}
+
+	cache->count += count;
+
+	return 0;
+}
+
+int
+spdk_obj_cache_fill(struct spdk_obj_cache *cache, uint32_t count)
+{
+	uint32_t num, filled = 0;
+
+	while (filled < count) {
+		num = spdk_min(count - filled, SPDK_OBJ_CACHE_MAX_BATCH);
+		if (obj_cache_refill(cache, num) != 0) {
+			obj_cache_return(cache, filled);
+			return -ENOMEM;
+		}
+
+		filled += num;
+	}
+
+	return 0;
+}
+
+void *
+spdk_obj_cache_get(struct spdk_obj_cache *cache)
+{
+	struct obj_cache_entry *entry;
+
+	if (spdk_unlikely(cache->count == 0)) {
+		/* The pool might not have a whole batch left, so try to get at least one object */
+		if (obj_cache_refill(cache, cache->batch_size) != 0 &&
+		    (cache->batch_size == 1 || obj_cache_refill(cache, 1) != 0)) {
+			cache->stats.starved++;
+			return NULL;
+		}
+
+		cache->stats.refills++;
+	}
+
+	entry = cache->head;
+	assert(entry != NULL);
+	cache->head = entry->next;
+	cache->count--;
+	cache->stats.gets++;
+
+	return entry;
+}
+
+void
+spdk_obj_cache_put(struct spdk_obj_cache *cache, void *obj)
+{
+	struct obj_cache_entry *entry = obj;
+
+	/* Insert the objects at the head, we want to re-use the hot ones */
+	entry->next = cache->head;
+	cache->head = entry;
+	cache->count++;
+	cache->stats.puts++;
+
+	if (spdk_unlikely(cache->count > cache->high_watermark)) {
+		obj_cache_return(cache, cache->count - cache->low_watermark);
+		cache->stats.returns++;
+	}
+}
+
 SPDK_LOG_REGISTER_COMPONENT(thread)
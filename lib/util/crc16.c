@@ -624,17 +624,157 @@ crc16_table_t10dif(uint16_t init_crc, const void *buf, size_t len)
 	return crc;
 }
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC16_HAVE_CLMUL
+#include <immintrin.h>
+
+/*
+ * Carry-less multiplication based implementation, folding the data 64 bytes at a time using four
+ * independent 128-bit accumulators.  Since the CRC isn't reflected, the data is byte-swapped so
+ * that bit i of an accumulator is the coefficient of x^i.  Folding an accumulator A = Ah * x^64 + Al
+ * by n bits is then done by A * x^n = Ah * (x^(n+64) mod P) + Al * (x^n mod P).  The remaining
+ * 128 bits are finally reduced using the table-driven implementation.
+ */
+#define CRC16_T10DIF_POLY		0x8bb7
+#define CRC16_CLMUL_LANES		4
+#define CRC16_CLMUL_MIN_LEN		(CRC16_CLMUL_LANES * 16 * 2)
+
+struct crc16_fold_consts {
+	/* { x^n mod P, x^(n+64) mod P } */
+	uint64_t	k[2];
+};
+
+static struct {
+	struct crc16_fold_consts	fold_512;
+	struct crc16_fold_consts	fold_384;
+	struct crc16_fold_consts	fold_256;
+	struct crc16_fold_consts	fold_128;
+	bool				enabled;
+} g_crc16_clmul;
+
+/* Calculate x^n mod P */
+static uint16_t
+crc16_xpow(uint32_t n)
+{
+	uint32_t r = 1;
+
+	while (n--) {
+		r <<= 1;
+		if (r & 0x10000) {
+			r ^= 0x10000 | CRC16_T10DIF_POLY;
+		}
+	}
+
+	return (uint16_t)r;
+}
+
+static void
+crc16_fold_consts_init(struct crc16_fold_consts *consts, uint32_t n)
+{
+	consts->k[0] = crc16_xpow(n);
+	consts->k[1] = crc16_xpow(n + 64);
+}
+
+__attribute__((constructor)) static void
+crc16_clmul_init(void)
+{
+	__builtin_cpu_init();
+	if (!__builtin_cpu_supports("pclmul") || !__builtin_cpu_supports("ssse3")) {
+		return;
+	}
+
+	crc16_fold_consts_init(&g_crc16_clmul.fold_512, 512);
+	crc16_fold_consts_init(&g_crc16_clmul.fold_384, 384);
+	crc16_fold_consts_init(&g_crc16_clmul.fold_256, 256);
+	crc16_fold_consts_init(&g_crc16_clmul.fold_128, 128);
+	g_crc16_clmul.enabled = true;
+}
+
+__attribute__((target("pclmul,ssse3"))) static inline __m128i
+crc16_fold(__m128i acc, __m128i k)
+{
+	return _mm_xor_si128(_mm_clmulepi64_si128(acc, k, 0x00),
+			     _mm_clmulepi64_si128(acc, k, 0x11));
+}
+
+__attribute__((target("pclmul,ssse3"))) static uint16_t
+crc16_clmul_t10dif(uint16_t init_crc, const void *buf, size_t len)
+{
+	const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	const uint8_t *data = buf;
+	__m128i acc[CRC16_CLMUL_LANES], k;
+	uint8_t tmp[16];
+	int i;
+
+	assert(len >= CRC16_CLMUL_MIN_LEN);
+
+	for (i = 0; i < CRC16_CLMUL_LANES; i++) {
+		acc[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data + i), bswap);
+	}
+
+	/* The initial CRC is added to the first 16 bits of the message */
+	acc[0] = _mm_xor_si128(acc[0], _mm_slli_si128(_mm_cvtsi32_si128(init_crc), 14));
+	data += CRC16_CLMUL_LANES * 16;
+	len -= CRC16_CLMUL_LANES * 16;
+
+	k = _mm_loadu_si128((const __m128i *)g_crc16_clmul.fold_512.k);
+	while (len >= CRC16_CLMUL_LANES * 16) {
+		for (i = 0; i < CRC16_CLMUL_LANES; i++) {
+			acc[i] = _mm_xor_si128(crc16_fold(acc[i], k),
+					       _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data + i),
+							       bswap));
+		}
+		data += CRC16_CLMUL_LANES * 16;
+		len -= CRC16_CLMUL_LANES * 16;
+	}
+
+	/* Combine the lanes into a single accumulator */
+	acc[3] = _mm_xor_si128(acc[3], crc16_fold(acc[0],
+				       _mm_loadu_si128((const __m128i *)g_crc16_clmul.fold_384.k)));
+	acc[3] = _mm_xor_si128(acc[3], crc16_fold(acc[1],
+				       _mm_loadu_si128((const __m128i *)g_crc16_clmul.fold_256.k)));
+	acc[3] = _mm_xor_si128(acc[3], crc16_fold(acc[2],
+				       _mm_loadu_si128((const __m128i *)g_crc16_clmul.fold_128.k)));
+
+	k = _mm_loadu_si128((const __m128i *)g_crc16_clmul.fold_128.k);
+	while (len >= 16) {
+		acc[3] = _mm_xor_si128(crc16_fold(acc[3], k),
+				       _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), bswap));
+		data += 16;
+		len -= 16;
+	}
+
+	/* The accumulator is congruent to the data processed so far, so its CRC is the same */
+	_mm_storeu_si128((__m128i *)tmp, _mm_shuffle_epi8(acc[3], bswap));
+
+	return crc_update_fast(crc_update_fast(0, tmp, sizeof(tmp)), data, len);
+}
+
+uint16_t
+spdk_crc16_t10dif(uint16_t init_crc, const void *buf, size_t len)
+{
+	if (g_crc16_clmul.enabled && len >= CRC16_CLMUL_MIN_LEN) {
+		return crc16_clmul_t10dif(init_crc, buf, len);
+	}
+
+	return (crc16_table_t10dif(init_crc, buf, len));
+}
+
+#else
+
 uint16_t
 spdk_crc16_t10dif(uint16_t init_crc, const void *buf, size_t len)
 {
 	return (crc16_table_t10dif(init_crc, buf, len));
 }
 
+#endif
+
 uint16_t
 spdk_crc16_t10dif_copy(uint16_t init_crc, uint8_t *dst, uint8_t *src, size_t len)
 {
 	memcpy(dst, src, len);
-	return (crc16_table_t10dif(init_crc, src, len));
+	return spdk_crc16_t10dif(init_crc, src, len);
 }
 
 #endif
@@ -6,6 +6,8 @@
 #include "util_internal.h"
 #include "crc_internal.h"
 #include "spdk/crc32.h"
+#include "spdk/likely.h"
+#include "spdk/util.h"
 
 #ifdef SPDK_HAVE_ISAL
 
@@ -15,76 +17,224 @@ spdk_crc32c_update(const void *buf, size_t len, uint32_t crc)
 	return crc32_iscsi((unsigned char *)buf, len, crc);
 }
 
-#elif defined(SPDK_HAVE_SSE4_2)
+#elif defined(SPDK_HAVE_SSE4_2) || defined(SPDK_HAVE_ARM_CRC)
 
-uint32_t
-spdk_crc32c_update(const void *buf, size_t len, uint32_t crc)
+/*
+ * The crc32 instruction has a latency of several cycles, but can be issued every cycle, so a
+ * single dependency chain can't use its full throughput.  Large buffers are therefore split into
+ * three consecutive blocks, whose CRCs are calculated in parallel and then combined:
+ *   crc(A|B|C) = shift(shift(crc(A), |B|) ^ crc(B), |C|) ^ crc(C)
+ * where shift(crc, n) advances the crc by n zero bytes, i.e. multiplies it by x^(8n) mod P.
+ * Since the block sizes are fixed, the x^(8n) constants are only calculated once.
+ */
+#define CRC32C_STREAMS		3
+#define CRC32C_LONG_BLOCK	1024
+#define CRC32C_SHORT_BLOCK	128
+
+struct crc32c_block {
+	size_t		len;
+	/* x^(8 * len) mod P */
+	uint32_t	xpow;
+	/* x^(8 * len - 33) mod P, used when multiplying with carry-less multiplication */
+	uint32_t	clmul_k;
+};
+
+static struct crc32c_block g_crc32c_blocks[] = {
+	{ .len = CRC32C_LONG_BLOCK },
+	{ .len = CRC32C_SHORT_BLOCK },
+};
+
+static bool g_crc32c_have_clmul;
+
+/* Multiply two bit-reflected polynomials modulo P */
+static uint32_t
+crc32c_multmodp(uint32_t a, uint32_t b)
 {
-	size_t count_pre, count_post, count_mid;
-	const uint64_t *dword_buf;
-	uint64_t crc_tmp64;
+	uint32_t m, p = 0;
 
-	/* process the head and tail bytes seperately to make the buf address
-	 * passed to _mm_crc32_u64 is 8 byte aligned. This can avoid unaligned loads.
-	 */
-	count_pre = ((uint64_t)buf & 7) == 0 ? 0 : 8 - ((uint64_t)buf & 7);
-	count_post = (uint64_t)((uintptr_t)buf + len) & 7;
-	count_mid = (len - count_pre - count_post) / 8;
+	for (m = 1u << 31; m != 0; m >>= 1) {
+		if (a & m) {
+			p ^= b;
+		}
+		b = (b & 1) ? (b >> 1) ^ SPDK_CRC32C_POLYNOMIAL_REFLECT : b >> 1;
+	}
 
-	while (count_pre--) {
-		crc = _mm_crc32_u8(crc, *(const uint8_t *)buf);
-		buf = (uint8_t *)buf + 1;
+	return p;
+}
+
+/* Calculate x^n mod P */
+static uint32_t
+crc32c_xpow(uint64_t n)
+{
+	uint32_t p = 1u << 31, xpow2 = 1u << 30;
+
+	for (; n != 0; n >>= 1) {
+		if (n & 1) {
+			p = crc32c_multmodp(p, xpow2);
+		}
+		xpow2 = crc32c_multmodp(xpow2, xpow2);
 	}
 
-	/* _mm_crc32_u64() needs a 64-bit intermediate value */
-	crc_tmp64 = crc;
-	dword_buf = (const uint64_t *)buf;
+	return p;
+}
 
-	while (count_mid--) {
-		crc_tmp64 = _mm_crc32_u64(crc_tmp64, *dword_buf);
-		dword_buf++;
+#ifdef SPDK_HAVE_SSE4_2
+
+static inline uint64_t
+crc32c_u64(uint64_t crc, uint64_t data)
+{
+	return _mm_crc32_u64(crc, data);
+}
+
+static inline uint32_t
+crc32c_u8(uint32_t crc, uint8_t data)
+{
+	return _mm_crc32_u8(crc, data);
+}
+
+/* crc32(0, clmul(crc, x^(8n - 33))) == crc * x^(8n - 33) * x^33 mod P */
+__attribute__((target("pclmul,sse4.2"))) static uint32_t
+crc32c_shift_clmul(uint32_t crc, uint32_t k)
+{
+	__m128i prod = _mm_clmulepi64_si128(_mm_cvtsi32_si128(crc), _mm_cvtsi32_si128(k), 0);
+
+	return (uint32_t)_mm_crc32_u64(0, (uint64_t)_mm_cvtsi128_si64(prod));
+}
+
+static void
+__attribute__((constructor))
+crc32c_detect_clmul(void)
+{
+	__builtin_cpu_init();
+	g_crc32c_have_clmul = __builtin_cpu_supports("pclmul");
+}
+
+#else /* SPDK_HAVE_ARM_CRC */
+
+static inline uint64_t
+crc32c_u64(uint64_t crc, uint64_t data)
+{
+	return __crc32cd((uint32_t)crc, data);
+}
+
+static inline uint32_t
+crc32c_u8(uint32_t crc, uint8_t data)
+{
+	return __crc32cb(crc, data);
+}
+
+#ifdef __ARM_FEATURE_CRYPTO
+#include <arm_neon.h>
+
+static uint32_t
+crc32c_shift_clmul(uint32_t crc, uint32_t k)
+{
+	poly128_t prod = vmull_p64((poly64_t)crc, (poly64_t)k);
+
+	return __crc32cd(0, vgetq_lane_u64(vreinterpretq_u64_p128(prod), 0));
+}
+
+static void
+__attribute__((constructor))
+crc32c_detect_clmul(void)
+{
+	g_crc32c_have_clmul = true;
+}
+
+#else
+
+static uint32_t
+crc32c_shift_clmul(uint32_t crc, uint32_t k)
+{
+	assert(0 && "PMULL not supported");
+	return 0;
+}
+
+#endif /* __ARM_FEATURE_CRYPTO */
+
+#endif /* SPDK_HAVE_SSE4_2 */
+
+static void
+__attribute__((constructor))
+crc32c_init_blocks(void)
+{
+	size_t i;
+
+	for (i = 0; i < SPDK_COUNTOF(g_crc32c_blocks); i++) {
+		g_crc32c_blocks[i].xpow = crc32c_xpow(8 * g_crc32c_blocks[i].len);
+		g_crc32c_blocks[i].clmul_k = crc32c_xpow(8 * g_crc32c_blocks[i].len - 33);
 	}
+}
 
-	buf = dword_buf;
-	crc = (uint32_t)crc_tmp64;
-	while (count_post--) {
-		crc = _mm_crc32_u8(crc, *(const uint8_t *)buf);
-		buf = (uint8_t *)buf + 1;
+static inline uint32_t
+crc32c_shift(uint32_t crc, const struct crc32c_block *block)
+{
+	if (spdk_likely(g_crc32c_have_clmul)) {
+		return crc32c_shift_clmul(crc, block->clmul_k);
 	}
 
-	return crc;
+	return crc32c_multmodp(block->xpow, crc);
 }
 
-#elif defined(SPDK_HAVE_ARM_CRC)
+static inline uint32_t
+crc32c_update_streams(const uint64_t *buf, const struct crc32c_block *block, uint32_t crc)
+{
+	const uint64_t *buf1 = buf + block->len / 8, *buf2 = buf + 2 * block->len / 8;
+	uint64_t crc0 = crc, crc1 = 0, crc2 = 0;
+	size_t i;
+
+	for (i = 0; i < block->len / 8; i++) {
+		crc0 = crc32c_u64(crc0, buf[i]);
+		crc1 = crc32c_u64(crc1, buf1[i]);
+		crc2 = crc32c_u64(crc2, buf2[i]);
+	}
+
+	crc = crc32c_shift((uint32_t)crc0, block) ^ (uint32_t)crc1;
+
+	return crc32c_shift(crc, block) ^ (uint32_t)crc2;
+}
 
 uint32_t
 spdk_crc32c_update(const void *buf, size_t len, uint32_t crc)
 {
-	size_t count_pre, count_post, count_mid;
+	size_t count_pre, count_post, count_mid, i;
 	const uint64_t *dword_buf;
+	uint64_t crc_tmp64;
 
 	/* process the head and tail bytes seperately to make the buf address
-	 * passed to crc32_cd is 8 byte aligned. This can avoid unaligned loads.
+	 * passed to crc32c_u64() is 8 byte aligned. This can avoid unaligned loads.
 	 */
-	count_pre = ((uint64_t)buf & 7) == 0 ? 0 : 8 - ((uint64_t)buf & 7);
-	count_post = (uint64_t)(buf + len) & 7;
+	count_pre = ((uintptr_t)buf & 7) == 0 ? 0 : 8 - ((uintptr_t)buf & 7);
+	count_pre = spdk_min(count_pre, len);
+	count_post = (len - count_pre) & 7;
 	count_mid = (len - count_pre - count_post) / 8;
 
 	while (count_pre--) {
-		crc = __crc32cb(crc, *(const uint8_t *)buf);
-		buf++;
+		crc = crc32c_u8(crc, *(const uint8_t *)buf);
+		buf = (const uint8_t *)buf + 1;
 	}
 
 	dword_buf = (const uint64_t *)buf;
+	for (i = 0; i < SPDK_COUNTOF(g_crc32c_blocks); i++) {
+		while (count_mid >= CRC32C_STREAMS * g_crc32c_blocks[i].len / 8) {
+			crc = crc32c_update_streams(dword_buf, &g_crc32c_blocks[i], crc);
+			dword_buf += CRC32C_STREAMS * g_crc32c_blocks[i].len / 8;
+			count_mid -= CRC32C_STREAMS * g_crc32c_blocks[i].len / 8;
+		}
+	}
+
+	/* crc32c_u64() needs a 64-bit intermediate value */
+	crc_tmp64 = crc;
 	while (count_mid--) {
-		crc = __crc32cd(crc, *dword_buf);
+		crc_tmp64 = crc32c_u64(crc_tmp64, *dword_buf);
 		dword_buf++;
 	}
 
 	buf = dword_buf;
+	crc = (uint32_t)crc_tmp64;
 	while (count_post--) {
-		crc = __crc32cb(crc, *(const uint8_t *)buf);
-		buf++;
+		crc = crc32c_u8(crc, *(const uint8_t *)buf);
+		buf = (const uint8_t *)buf + 1;
 	}
 
 	return crc;
@@ -616,13 +616,125 @@ _dif_generate(void *_dif, uint64_t guard, uint32_t offset_blocks,
 	}
 }
 
+/* PI of a batch of blocks, precomputed from the context, so that the tags of each block can be
+ * generated and checked using a few word operations, instead of handling each field separately.
+ */
+union _dif_pi {
+	struct spdk_dif	dif;
+	uint64_t	w[2];
+};
+
+struct _dif_batch_pi {
+	/* PI with the application tag and, if it's constant, the reference tag */
+	union _dif_pi	pi;
+	/* Bits of the PI being generated or checked */
+	union _dif_pi	mask;
+	uint64_t	ref_tag;
+	bool		ref_tag_inc;
+};
+
+struct _dif_batch {
+	struct _dif_batch_pi	generate;
+	struct _dif_batch_pi	verify;
+	uint8_t			pi_size;
+	uint8_t			dif_pi_format;
+};
+
+static void
+_dif_batch_init(struct _dif_batch *batch, const struct spdk_dif_ctx *ctx)
+{
+	struct _dif_batch_pi *gen = &batch->generate, *ver = &batch->verify;
+	enum spdk_dif_pi_format fmt = ctx->dif_pi_format;
+
+	memset(batch, 0, sizeof(*batch));
+	batch->pi_size = _dif_size(fmt);
+	batch->dif_pi_format = fmt;
+
+	if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
+		_dif_set_guard(&gen->mask.dif, UINT64_MAX, fmt);
+		_dif_set_guard(&ver->mask.dif, UINT64_MAX, fmt);
+	}
+
+	if (ctx->dif_flags & SPDK_DIF_FLAGS_APPTAG_CHECK) {
+		_dif_set_apptag(&gen->pi.dif, ctx->app_tag, fmt);
+		_dif_set_apptag(&gen->mask.dif, UINT16_MAX, fmt);
+		_dif_set_apptag(&ver->pi.dif, ctx->app_tag, fmt);
+		_dif_set_apptag(&ver->mask.dif, ctx->apptag_mask, fmt);
+	}
+
+	if (ctx->dif_flags & SPDK_DIF_FLAGS_REFTAG_CHECK) {
+		/* Same rules as _dif_generate() and _dif_reftag_check() */
+		_dif_set_reftag(&gen->mask.dif, UINT64_MAX, fmt);
+		gen->ref_tag = ctx->init_ref_tag + ctx->ref_tag_offset;
+		if (ctx->init_ref_tag == SPDK_DIF_REFTAG_IGNORE) {
+			gen->ref_tag = UINT64_MAX;
+		} else {
+			gen->ref_tag_inc = ctx->dif_type != SPDK_DIF_TYPE3;
+		}
+		_dif_set_reftag(&gen->pi.dif, gen->ref_tag, fmt);
+
+		if (ctx->dif_type == SPDK_DIF_TYPE1 || ctx->dif_type == SPDK_DIF_TYPE2) {
+			_dif_set_reftag(&ver->mask.dif, UINT64_MAX, fmt);
+			ver->ref_tag = ctx->init_ref_tag + ctx->ref_tag_offset;
+			ver->ref_tag_inc = true;
+		}
+	}
+}
+
+static inline void
+_dif_batch_get_pi(const struct _dif_batch *batch, const struct _dif_batch_pi *bpi,
+		  uint64_t guard, uint32_t offset_blocks, union _dif_pi *pi)
+{
+	*pi = bpi->pi;
+	_dif_set_guard(&pi->dif, guard, batch->dif_pi_format);
+	if (bpi->ref_tag_inc) {
+		_dif_set_reftag(&pi->dif, bpi->ref_tag + offset_blocks, batch->dif_pi_format);
+	}
+}
+
+static inline void
+_dif_batch_generate(const struct _dif_batch *batch, void *dif, uint64_t guard,
+		    uint32_t offset_blocks)
+{
+	const struct _dif_batch_pi *gen = &batch->generate;
+	union _dif_pi pi, cur = {};
+
+	_dif_batch_get_pi(batch, gen, guard, offset_blocks, &pi);
+
+	/* The PI isn't necessarily aligned */
+	memcpy(&cur, dif, batch->pi_size);
+	cur.w[0] = (cur.w[0] & ~gen->mask.w[0]) | (pi.w[0] & gen->mask.w[0]);
+	cur.w[1] = (cur.w[1] & ~gen->mask.w[1]) | (pi.w[1] & gen->mask.w[1]);
+	memcpy(dif, &cur, batch->pi_size);
+}
+
+/* Returns true if all checked fields match.  Otherwise, the block needs to be verified by
+ * _dif_verify(), which also handles the cases where the checks are disabled by the PI itself. */
+static inline bool
+_dif_batch_match(const struct _dif_batch *batch, void *dif, uint64_t guard,
+		 uint32_t offset_blocks)
+{
+	const struct _dif_batch_pi *ver = &batch->verify;
+	union _dif_pi pi, cur = {};
+
+	_dif_batch_get_pi(batch, ver, guard, offset_blocks, &pi);
+
+	memcpy(&cur, dif, batch->pi_size);
+
+	return (((cur.w[0] ^ pi.w[0]) & ver->mask.w[0]) |
+		((cur.w[1] ^ pi.w[1]) & ver->mask.w[1])) == 0;
+}
+
 static void
 dif_generate(struct _dif_sgl *sgl, uint32_t num_blocks, const struct spdk_dif_ctx *ctx)
 {
+	struct _dif_batch batch;
 	uint32_t offset_blocks = 0;
 	uint8_t *buf;
 	uint64_t guard = 0;
 
+	_dif_batch_init(&batch, ctx);
+
 	while (offset_blocks < num_blocks) {
 		_dif_sgl_get_buf(sgl, &buf, NULL);
 
@@ -630,7 +742,7 @@ dif_generate(struct _dif_sgl *sgl, uint32_t num_blocks, const struct spdk_dif_ct
 			guard = _dif_generate_guard(ctx->guard_seed, buf, ctx->guard_interval, ctx->dif_pi_format);
 		}
 
-		_dif_generate(buf + ctx->guard_interval, guard, offset_blocks, ctx);
+		_dif_batch_generate(&batch, buf + ctx->guard_interval, guard, offset_blocks);
 
 		_dif_sgl_advance(sgl, ctx->block_size);
 		offset_blocks++;
@@ -856,11 +968,14 @@ static int
 dif_verify(struct _dif_sgl *sgl, uint32_t num_blocks,
 	   const struct spdk_dif_ctx *ctx, struct spdk_dif_error *err_blk)
 {
+	struct _dif_batch batch;
 	uint32_t offset_blocks = 0;
 	int rc;
 	uint8_t *buf;
 	uint64_t guard = 0;
 
+	_dif_batch_init(&batch, ctx);
+
 	while (offset_blocks < num_blocks) {
 		_dif_sgl_get_buf(sgl, &buf, NULL);
 
@@ -868,9 +983,11 @@ dif_verify(struct _dif_sgl *sgl, uint32_t num_blocks,
 			guard = _dif_generate_guard(ctx->guard_seed, buf, ctx->guard_interval, ctx->dif_pi_format);
 		}
 
-		rc = _dif_verify(buf + ctx->guard_interval, guard, offset_blocks, ctx, err_blk);
-		if (rc != 0) {
-			return rc;
+		if (!_dif_batch_match(&batch, buf + ctx->guard_interval, guard, offset_blocks)) {
+			rc = _dif_verify(buf + ctx->guard_interval, guard, offset_blocks, ctx, err_blk);
+			if (rc != 0) {
+				return rc;
+			}
 		}
 
 		_dif_sgl_advance(sgl, ctx->block_size);
@@ -1488,10 +1605,13 @@ static void
 dix_generate(struct _dif_sgl *data_sgl, struct _dif_sgl *md_sgl,
 	     uint32_t num_blocks, const struct spdk_dif_ctx *ctx)
 {
+	struct _dif_batch batch;
 	uint32_t offset_blocks = 0;
 	uint8_t *data_buf, *md_buf;
 	uint64_t guard;
 
+	_dif_batch_init(&batch, ctx);
+
 	while (offset_blocks < num_blocks) {
 		_dif_sgl_get_buf(data_sgl, &data_buf, NULL);
 		_dif_sgl_get_buf(md_sgl, &md_buf, NULL);
@@ -1504,7 +1624,7 @@ dix_generate(struct _dif_sgl *data_sgl, struct _dif_sgl *md_sgl,
 						    ctx->dif_pi_format);
 		}
 
-		_dif_generate(md_buf + ctx->guard_interval, guard, offset_blocks, ctx);
+		_dif_batch_generate(&batch, md_buf + ctx->guard_interval, guard, offset_blocks);
 
 		_dif_sgl_advance(data_sgl, ctx->block_size);
 		_dif_sgl_advance(md_sgl, ctx->md_size);
@@ -1594,11 +1714,14 @@ dix_verify(struct _dif_sgl *data_sgl, struct _dif_sgl *md_sgl,
 	   uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
 	   struct spdk_dif_error *err_blk)
 {
+	struct _dif_batch batch;
 	uint32_t offset_blocks = 0;
 	uint8_t *data_buf, *md_buf;
 	uint64_t guard;
 	int rc;
 
+	_dif_batch_init(&batch, ctx);
+
 	while (offset_blocks < num_blocks) {
 		_dif_sgl_get_buf(data_sgl, &data_buf, NULL);
 		_dif_sgl_get_buf(md_sgl, &md_buf, NULL);
@@ -1611,9 +1734,11 @@ dix_verify(struct _dif_sgl *data_sgl, struct _dif_sgl *md_sgl,
 						    ctx->dif_pi_format);
 		}
 
-		rc = _dif_verify(md_buf + ctx->guard_interval, guard, offset_blocks, ctx, err_blk);
-		if (rc != 0) {
-			return rc;
+		if (!_dif_batch_match(&batch, md_buf + ctx->guard_interval, guard, offset_blocks)) {
+			rc = _dif_verify(md_buf + ctx->guard_interval, guard, offset_blocks, ctx, err_blk);
+			if (rc != 0) {
+				return rc;
+			}
 		}
 
 		_dif_sgl_advance(data_sgl, ctx->block_size);
@@ -6,6 +6,16 @@
 #include "spdk/util.h"
 #include "spdk/log.h"
 
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#define IOV_HAVE_NT_STORE
+#endif
+
+/* How far ahead of the copied data the source is prefetched */
+#define IOV_NT_PREFETCH_DISTANCE 512
+
+static size_t g_iov_nt_threshold = SPDK_IOV_NT_THRESHOLD_DEFAULT;
+
 void
 spdk_iov_memset(struct iovec *iovs, int iovcnt, int c)
 {
@@ -164,6 +174,106 @@ spdk_iovmove(struct iovec *siov, size_t siovcnt, struct iovec *diov, size_t diov
 	return total_sz;
 }
 
+void
+spdk_iov_set_nt_threshold(size_t threshold)
+{
+	g_iov_nt_threshold = threshold;
+}
+
+size_t
+spdk_iov_get_nt_threshold(void)
+{
+	return g_iov_nt_threshold;
+}
+
+/* Copies the data using non-temporal stores without the trailing store fence */
+static void
+_memcpy_nt(void *dst, const void *src, size_t len)
+{
+#ifdef IOV_HAVE_NT_STORE
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	__m128i x0, x1, x2, x3;
+	size_t head;
+
+	if (len < 64) {
+		memcpy(dst, src, len);
+		return;
+	}
+
+	/* Streaming stores require 16B aligned destination */
+	head = (16 - ((uintptr_t)d & 15)) & 15;
+	memcpy(d, s, head);
+	d += head;
+	s += head;
+	len -= head;
+
+	for (; len >= 64; len -= 64, d += 64, s += 64) {
+		__builtin_prefetch(s + IOV_NT_PREFETCH_DISTANCE, 0, 0);
+		x0 = _mm_loadu_si128((const __m128i *)s);
+		x1 = _mm_loadu_si128((const __m128i *)(s + 16));
+		x2 = _mm_loadu_si128((const __m128i *)(s + 32));
+		x3 = _mm_loadu_si128((const __m128i *)(s + 48));
+		_mm_stream_si128((__m128i *)d, x0);
+		_mm_stream_si128((__m128i *)(d + 16), x1);
+		_mm_stream_si128((__m128i *)(d + 32), x2);
+		_mm_stream_si128((__m128i *)(d + 48), x3);
+	}
+
+	memcpy(d, s, len);
+#else
+	memcpy(dst, src, len);
+#endif
+}
+
+static inline void
+_memcpy_nt_fence(void)
+{
+#ifdef IOV_HAVE_NT_STORE
+	/* Make the streaming stores visible before any subsequent store, e.g. a doorbell write */
+	_mm_sfence();
+#endif
+}
+
+void
+spdk_memcpy_nt(void *dst, const void *src, size_t len)
+{
+	_memcpy_nt(dst, src, len);
+	_memcpy_nt_fence();
+}
+
+size_t
+spdk_iovcpy_nt(struct iovec *siov, size_t siovcnt, struct iovec *diov, size_t diovcnt)
+{
+	struct spdk_ioviter iter;
+	size_t i, len, total_sz;
+	void *src, *dst;
+
+	total_sz = 0;
+	for (i = 0; i < siovcnt; i++) {
+		total_sz += siov[i].iov_len;
+	}
+
+	if (g_iov_nt_threshold == 0 || total_sz < g_iov_nt_threshold) {
+		return spdk_iovcpy(siov, siovcnt, diov, diovcnt);
+	}
+
+	total_sz = 0;
+	for (len = spdk_ioviter_first(&iter, siov, siovcnt, diov, diovcnt, &src, &dst);
+	     len != 0;
+	     len = spdk_ioviter_next(&iter, &src, &dst)) {
+		/* The iterator already points at the next source segment, which is usually in a
+		 * different buffer, so the prefetching done while copying won't reach it */
+		__builtin_prefetch(iter.iters[0].iov_base, 0, 0);
+		_memcpy_nt(dst, src, len);
+		total_sz += len;
+	}
+
+	_memcpy_nt_fence();
+
+	return total_sz;
+}
+
 void
 spdk_iov_xfer_init(struct spdk_iov_xfer *ix, struct iovec *iovs, int iovcnt)
 {
@@ -0,0 +1,279 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/sha256.h"
+#include "spdk/endian.h"
+#include "spdk/likely.h"
+#include "spdk/util.h"
+
+static const uint32_t g_sha256_k[64] __attribute__((aligned(16))) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t g_sha256_init[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static inline uint32_t
+sha256_ror(uint32_t x, uint32_t n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+static void
+sha256_blocks_generic(uint32_t state[8], const uint8_t *data, size_t nblocks)
+{
+	uint32_t w[64], a, b, c, d, e, f, g, h, t1, t2;
+	int i;
+
+	for (; nblocks > 0; nblocks--, data += SPDK_SHA256_BLOCK_LEN) {
+		for (i = 0; i < 16; i++) {
+			w[i] = from_be32(&data[i * 4]);
+		}
+		for (i = 16; i < 64; i++) {
+			w[i] = w[i - 16] + w[i - 7] +
+			       (sha256_ror(w[i - 15], 7) ^ sha256_ror(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+			       (sha256_ror(w[i - 2], 17) ^ sha256_ror(w[i - 2], 19) ^ (w[i - 2] >> 10));
+		}
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		for (i = 0; i < 64; i++) {
+			t1 = h + (sha256_ror(e, 6) ^ sha256_ror(e, 11) ^ sha256_ror(e, 25)) +
+			     ((e & f) ^ (~e & g)) + g_sha256_k[i] + w[i];
+			t2 = (sha256_ror(a, 2) ^ sha256_ror(a, 13) ^ sha256_ror(a, 22)) +
+			     ((a & b) ^ (a & c) ^ (b & c));
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+	}
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SHA256_HAVE_SHA_NI
+#include <immintrin.h>
+
+/*
+ * SHA extensions based implementation.  The state is kept in two registers in the {ABEF, CDGH}
+ * order required by sha256rnds2, which executes two rounds at a time.  The message schedule is
+ * calculated four words at a time with sha256msg1/sha256msg2, interleaved with the rounds.
+ */
+
+/* Execute four rounds using message words `m` and round constants starting at `k` */
+#define SHA256_NI_ROUNDS(m, k) \
+	do { \
+		msg = _mm_add_epi32(m, _mm_load_si128((const __m128i *)&g_sha256_k[k])); \
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+		msg = _mm_shuffle_epi32(msg, 0x0e); \
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg); \
+	} while (0)
+
+/* Calculate the message words four positions ahead of `cur` and store them in `next` */
+#define SHA256_NI_SCHED2(cur, prev, next) \
+	do { \
+		next = _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4)); \
+		next = _mm_sha256msg2_epu32(next, cur); \
+	} while (0)
+
+#define SHA256_NI_SCHED1(cur, prev) \
+	prev = _mm_sha256msg1_epu32(prev, cur)
+
+static bool g_sha256_have_sha_ni;
+
+__attribute__((constructor)) static void
+sha256_sha_ni_init(void)
+{
+	__builtin_cpu_init();
+	g_sha256_have_sha_ni = __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+}
+
+__attribute__((target("sha,sse4.1"))) static void
+sha256_blocks_sha_ni(uint32_t state[8], const uint8_t *data, size_t nblocks)
+{
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	__m128i state0, state1, abef, cdgh, msg, m0, m1, m2, m3, tmp;
+
+	/* {A, B, C, D}, {E, F, G, H} -> {A, B, E, F}, {C, D, G, H} */
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xb1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1b);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+	for (; nblocks > 0; nblocks--, data += SPDK_SHA256_BLOCK_LEN) {
+		abef = state0;
+		cdgh = state1;
+
+		m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&data[0]), bswap);
+		m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&data[16]), bswap);
+		m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&data[32]), bswap);
+		m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&data[48]), bswap);
+
+		SHA256_NI_ROUNDS(m0, 0);
+		SHA256_NI_ROUNDS(m1, 4);
+		SHA256_NI_SCHED1(m1, m0);
+		SHA256_NI_ROUNDS(m2, 8);
+		SHA256_NI_SCHED1(m2, m1);
+		SHA256_NI_ROUNDS(m3, 12);
+		SHA256_NI_SCHED2(m3, m2, m0);
+		SHA256_NI_SCHED1(m3, m2);
+		SHA256_NI_ROUNDS(m0, 16);
+		SHA256_NI_SCHED2(m0, m3, m1);
+		SHA256_NI_SCHED1(m0, m3);
+		SHA256_NI_ROUNDS(m1, 20);
+		SHA256_NI_SCHED2(m1, m0, m2);
+		SHA256_NI_SCHED1(m1, m0);
+		SHA256_NI_ROUNDS(m2, 24);
+		SHA256_NI_SCHED2(m2, m1, m3);
+		SHA256_NI_SCHED1(m2, m1);
+		SHA256_NI_ROUNDS(m3, 28);
+		SHA256_NI_SCHED2(m3, m2, m0);
+		SHA256_NI_SCHED1(m3, m2);
+		SHA256_NI_ROUNDS(m0, 32);
+		SHA256_NI_SCHED2(m0, m3, m1);
+		SHA256_NI_SCHED1(m0, m3);
+		SHA256_NI_ROUNDS(m1, 36);
+		SHA256_NI_SCHED2(m1, m0, m2);
+		SHA256_NI_SCHED1(m1, m0);
+		SHA256_NI_ROUNDS(m2, 40);
+		SHA256_NI_SCHED2(m2, m1, m3);
+		SHA256_NI_SCHED1(m2, m1);
+		SHA256_NI_ROUNDS(m3, 44);
+		SHA256_NI_SCHED2(m3, m2, m0);
+		SHA256_NI_SCHED1(m3, m2);
+		SHA256_NI_ROUNDS(m0, 48);
+		SHA256_NI_SCHED2(m0, m3, m1);
+		SHA256_NI_SCHED1(m0, m3);
+		SHA256_NI_ROUNDS(m1, 52);
+		SHA256_NI_SCHED2(m1, m0, m2);
+		SHA256_NI_ROUNDS(m2, 56);
+		SHA256_NI_SCHED2(m2, m1, m3);
+		SHA256_NI_ROUNDS(m3, 60);
+
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+	}
+
+	/* {A, B, E, F}, {C, D, G, H} -> {A, B, C, D}, {E, F, G, H} */
+	tmp = _mm_shuffle_epi32(state0, 0x1b);
+	state1 = _mm_shuffle_epi32(state1, 0xb1);
+	state0 = _mm_blend_epi16(tmp, state1, 0xf0);
+	state1 = _mm_alignr_epi8(state1, tmp, 8);
+	_mm_storeu_si128((__m128i *)&state[0], state0);
+	_mm_storeu_si128((__m128i *)&state[4], state1);
+}
+#endif
+
+static void
+sha256_blocks(uint32_t state[8], const uint8_t *data, size_t nblocks)
+{
+#ifdef SHA256_HAVE_SHA_NI
+	if (spdk_likely(g_sha256_have_sha_ni)) {
+		sha256_blocks_sha_ni(state, data, nblocks);
+		return;
+	}
+#endif
+	sha256_blocks_generic(state, data, nblocks);
+}
+
+void
+spdk_sha256_init(struct spdk_sha256_ctx *ctx)
+{
+	memcpy(ctx->state, g_sha256_init, sizeof(ctx->state));
+	ctx->length = 0;
+	ctx->buflen = 0;
+}
+
+void
+spdk_sha256_update(struct spdk_sha256_ctx *ctx, const void *buf, size_t len)
+{
+	const uint8_t *data = buf;
+	size_t n;
+
+	ctx->length += len;
+	if (ctx->buflen > 0) {
+		n = spdk_min(len, SPDK_SHA256_BLOCK_LEN - ctx->buflen);
+		memcpy(&ctx->buf[ctx->buflen], data, n);
+		ctx->buflen += n;
+		data += n;
+		len -= n;
+		if (ctx->buflen < SPDK_SHA256_BLOCK_LEN) {
+			return;
+		}
+		sha256_blocks(ctx->state, ctx->buf, 1);
+		ctx->buflen = 0;
+	}
+
+	n = len / SPDK_SHA256_BLOCK_LEN;
+	if (n > 0) {
+		sha256_blocks(ctx->state, data, n);
+		data += n * SPDK_SHA256_BLOCK_LEN;
+		len -= n * SPDK_SHA256_BLOCK_LEN;
+	}
+
+	memcpy(ctx->buf, data, len);
+	ctx->buflen = len;
+}
+
+void
+spdk_sha256_final(struct spdk_sha256_ctx *ctx, uint8_t *digest)
+{
+	uint64_t bits = ctx->length * 8;
+	int i;
+
+	/* Append the 0x80 terminator and pad the last block leaving room for the length */
+	ctx->buf[ctx->buflen++] = 0x80;
+	if (ctx->buflen > SPDK_SHA256_BLOCK_LEN - sizeof(bits)) {
+		memset(&ctx->buf[ctx->buflen], 0, SPDK_SHA256_BLOCK_LEN - ctx->buflen);
+		sha256_blocks(ctx->state, ctx->buf, 1);
+		ctx->buflen = 0;
+	}
+
+	memset(&ctx->buf[ctx->buflen], 0, SPDK_SHA256_BLOCK_LEN - sizeof(bits) - ctx->buflen);
+	to_be64(&ctx->buf[SPDK_SHA256_BLOCK_LEN - sizeof(bits)], bits);
+	sha256_blocks(ctx->state, ctx->buf, 1);
+
+	for (i = 0; i < 8; i++) {
+		to_be32(&digest[i * 4], ctx->state[i]);
+	}
+}
+
+void
+spdk_sha256(const void *buf, size_t len, uint8_t *digest)
+{
+	struct spdk_sha256_ctx ctx;
+
+	spdk_sha256_init(&ctx);
+	spdk_sha256_update(&ctx, buf, len);
+	spdk_sha256_final(&ctx, digest);
+}
@@ -8,37 +8,73 @@
 #include "spdk/assert.h"
 #include "spdk/util.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SPDK_XOR_HAVE_X86_DISPATCH
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define SPDK_XOR_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
 /* maximum number of source buffers */
 #define SPDK_XOR_MAX_SRC	256
 
-static inline bool
-is_aligned(void *ptr, size_t alignment)
+/* GF(2^8) generator polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11d) without its x^8 term */
+#define SPDK_XOR_GF_POLY	0x1d
+
+typedef void (*xor_gen_fn)(void *dest, void **sources, uint32_t n, uint32_t len);
+typedef void (*xor_gen_pq_fn)(void *p, void *q, void **sources, uint32_t n, uint32_t len);
+
+static inline uint64_t
+load_u64(const uint8_t *ptr)
 {
-	uintptr_t p = (uintptr_t)ptr;
+	uint64_t w;
 
-	return p == SPDK_ALIGN_FLOOR(p, alignment);
+	/* Compilers turn this into a single (possibly unaligned) load */
+	memcpy(&w, ptr, sizeof(w));
+	return w;
 }
 
-static bool
-buffers_aligned(void *dest, void **sources, uint32_t n, size_t alignment)
+static inline void
+store_u64(uint8_t *ptr, uint64_t w)
 {
-	uint32_t i;
+	memcpy(ptr, &w, sizeof(w));
+}
 
-	for (i = 0; i < n; i++) {
-		if (!is_aligned(sources[i], alignment)) {
-			return false;
-		}
-	}
+/* Multiply each byte of the word by 2 in GF(2^8) */
+static inline uint64_t
+gf_mul2_u64(uint64_t w)
+{
+	uint64_t hi = w & 0x8080808080808080ULL;
 
-	return is_aligned(dest, alignment);
+	/* (hi << 1) - (hi >> 7) turns each byte with its high bit set into 0xff */
+	return ((w << 1) & 0xfefefefefefefefeULL) ^
+	       (((hi << 1) - (hi >> 7)) & (0x0101010101010101ULL * SPDK_XOR_GF_POLY));
 }
 
+static inline uint8_t
+gf_mul2_u8(uint8_t b)
+{
+	return (uint8_t)(b << 1) ^ ((b & 0x80) ? SPDK_XOR_GF_POLY : 0);
+}
+
+/* Generate xor of the [offset, len) range of the buffers.  Handles any alignment of the buffers,
+ * only the last few bytes, if len isn't a multiple of 8, are processed byte by byte. */
 static void
-xor_gen_unaligned(void *dest, void **sources, uint32_t n, uint32_t len)
+xor_gen_words(void *dest, void **sources, uint32_t n, uint32_t offset, uint32_t len)
 {
 	uint32_t i, j;
 
-	for (i = 0; i < len; i++) {
+	for (i = offset; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t w = 0;
+
+		for (j = 0; j < n; j++) {
+			w ^= load_u64((uint8_t *)sources[j] + i);
+		}
+		store_u64((uint8_t *)dest + i, w);
+	}
+
+	for (; i < len; i++) {
 		uint8_t b = 0;
 
 		for (j = 0; j < n; j++) {
@@ -51,44 +87,298 @@ xor_gen_unaligned(void *dest, void **sources, uint32_t n, uint32_t len)
 static void
 xor_gen_basic(void *dest, void **sources, uint32_t n, uint32_t len)
 {
-	uint32_t shift;
-	uint32_t len_div, len_rem;
+	xor_gen_words(dest, sources, n, 0, len);
+}
+
+/* Generate P and Q of the [offset, len) range of the buffers using Horner's scheme, i.e.
+ * Q = ((D[n-1] * g + D[n-2]) * g + ...) * g + D[0] */
+static void
+xor_gen_pq_words(void *p, void *q, void **sources, uint32_t n, uint32_t offset, uint32_t len)
+{
+	uint32_t i;
+	int j;
+
+	for (i = offset; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t wp, wq, d;
+
+		wp = wq = load_u64((uint8_t *)sources[n - 1] + i);
+		for (j = n - 2; j >= 0; j--) {
+			d = load_u64((uint8_t *)sources[j] + i);
+			wp ^= d;
+			wq = gf_mul2_u64(wq) ^ d;
+		}
+		store_u64((uint8_t *)p + i, wp);
+		store_u64((uint8_t *)q + i, wq);
+	}
+
+	for (; i < len; i++) {
+		uint8_t bp, bq, d;
+
+		bp = bq = ((uint8_t *)sources[n - 1])[i];
+		for (j = n - 2; j >= 0; j--) {
+			d = ((uint8_t *)sources[j])[i];
+			bp ^= d;
+			bq = gf_mul2_u8(bq) ^ d;
+		}
+		((uint8_t *)p)[i] = bp;
+		((uint8_t *)q)[i] = bq;
+	}
+}
+
+static void
+xor_gen_pq_basic(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	xor_gen_pq_words(p, q, sources, n, 0, len);
+}
+
+#ifdef SPDK_XOR_HAVE_X86_DISPATCH
+__attribute__((target("avx2"))) static void
+xor_gen_avx2(void *dest, void **sources, uint32_t n, uint32_t len)
+{
 	uint32_t i, j;
 
-	if (!buffers_aligned(dest, sources, n, sizeof(uint64_t))) {
-		xor_gen_unaligned(dest, sources, n, len);
-		return;
+	for (i = 0; i + 4 * sizeof(__m256i) <= len; i += 4 * sizeof(__m256i)) {
+		__m256i w0, w1, w2, w3;
+		uint8_t *src = (uint8_t *)sources[0] + i;
+
+		w0 = _mm256_loadu_si256((__m256i *)src);
+		w1 = _mm256_loadu_si256((__m256i *)src + 1);
+		w2 = _mm256_loadu_si256((__m256i *)src + 2);
+		w3 = _mm256_loadu_si256((__m256i *)src + 3);
+		for (j = 1; j < n; j++) {
+			src = (uint8_t *)sources[j] + i;
+			w0 = _mm256_xor_si256(w0, _mm256_loadu_si256((__m256i *)src));
+			w1 = _mm256_xor_si256(w1, _mm256_loadu_si256((__m256i *)src + 1));
+			w2 = _mm256_xor_si256(w2, _mm256_loadu_si256((__m256i *)src + 2));
+			w3 = _mm256_xor_si256(w3, _mm256_loadu_si256((__m256i *)src + 3));
+		}
+		_mm256_storeu_si256((__m256i *)((uint8_t *)dest + i), w0);
+		_mm256_storeu_si256((__m256i *)((uint8_t *)dest + i) + 1, w1);
+		_mm256_storeu_si256((__m256i *)((uint8_t *)dest + i) + 2, w2);
+		_mm256_storeu_si256((__m256i *)((uint8_t *)dest + i) + 3, w3);
 	}
 
-	shift = spdk_u32log2(sizeof(uint64_t));
-	len_div = len >> shift;
-	len_rem = len_div << shift;
+	for (; i + sizeof(__m256i) <= len; i += sizeof(__m256i)) {
+		__m256i w = _mm256_loadu_si256((__m256i *)((uint8_t *)sources[0] + i));
 
-	for (i = 0; i < len_div; i++) {
-		uint64_t w = 0;
+		for (j = 1; j < n; j++) {
+			w = _mm256_xor_si256(w, _mm256_loadu_si256((__m256i *)((uint8_t *)sources[j] + i)));
+		}
+		_mm256_storeu_si256((__m256i *)((uint8_t *)dest + i), w);
+	}
 
-		for (j = 0; j < n; j++) {
-			w ^= ((uint64_t *)sources[j])[i];
+	xor_gen_words(dest, sources, n, i, len);
+}
+
+__attribute__((target("avx2"))) static void
+xor_gen_pq_avx2(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	const __m256i poly = _mm256_set1_epi8(SPDK_XOR_GF_POLY);
+	const __m256i zero = _mm256_setzero_si256();
+	uint32_t i;
+	int j;
+
+	for (i = 0; i + sizeof(__m256i) <= len; i += sizeof(__m256i)) {
+		__m256i wp, wq, d, hi;
+
+		wp = wq = _mm256_loadu_si256((__m256i *)((uint8_t *)sources[n - 1] + i));
+		for (j = n - 2; j >= 0; j--) {
+			d = _mm256_loadu_si256((__m256i *)((uint8_t *)sources[j] + i));
+			/* Bytes with the high bit set are negative */
+			hi = _mm256_cmpgt_epi8(zero, wq);
+			wq = _mm256_add_epi8(wq, wq);
+			wq = _mm256_xor_si256(wq, _mm256_and_si256(hi, poly));
+			wq = _mm256_xor_si256(wq, d);
+			wp = _mm256_xor_si256(wp, d);
 		}
-		((uint64_t *)dest)[i] = w;
+		_mm256_storeu_si256((__m256i *)((uint8_t *)p + i), wp);
+		_mm256_storeu_si256((__m256i *)((uint8_t *)q + i), wq);
 	}
 
-	if (len_rem < len) {
-		void *sources2[SPDK_XOR_MAX_SRC];
+	xor_gen_pq_words(p, q, sources, n, i, len);
+}
 
-		for (j = 0; j < n; j++) {
-			sources2[j] = (uint8_t *)sources[j] + len_rem;
+__attribute__((target("avx512f"))) static void
+xor_gen_avx512(void *dest, void **sources, uint32_t n, uint32_t len)
+{
+	uint32_t i, j;
+
+	for (i = 0; i + 4 * sizeof(__m512i) <= len; i += 4 * sizeof(__m512i)) {
+		__m512i w0, w1, w2, w3;
+		uint8_t *src = (uint8_t *)sources[0] + i;
+
+		w0 = _mm512_loadu_si512(src);
+		w1 = _mm512_loadu_si512(src + sizeof(__m512i));
+		w2 = _mm512_loadu_si512(src + 2 * sizeof(__m512i));
+		w3 = _mm512_loadu_si512(src + 3 * sizeof(__m512i));
+		for (j = 1; j < n; j++) {
+			src = (uint8_t *)sources[j] + i;
+			w0 = _mm512_xor_si512(w0, _mm512_loadu_si512(src));
+			w1 = _mm512_xor_si512(w1, _mm512_loadu_si512(src + sizeof(__m512i)));
+			w2 = _mm512_xor_si512(w2, _mm512_loadu_si512(src + 2 * sizeof(__m512i)));
+			w3 = _mm512_xor_si512(w3, _mm512_loadu_si512(src + 3 * sizeof(__m512i)));
+		}
+		_mm512_storeu_si512((uint8_t *)dest + i, w0);
+		_mm512_storeu_si512((uint8_t *)dest + i + sizeof(__m512i), w1);
+		_mm512_storeu_si512((uint8_t *)dest + i + 2 * sizeof(__m512i), w2);
+		_mm512_storeu_si512((uint8_t *)dest + i + 3 * sizeof(__m512i), w3);
+	}
+
+	for (; i + sizeof(__m512i) <= len; i += sizeof(__m512i)) {
+		__m512i w = _mm512_loadu_si512((uint8_t *)sources[0] + i);
+
+		for (j = 1; j < n; j++) {
+			w = _mm512_xor_si512(w, _mm512_loadu_si512((uint8_t *)sources[j] + i));
+		}
+		_mm512_storeu_si512((uint8_t *)dest + i, w);
+	}
+
+	xor_gen_words(dest, sources, n, i, len);
+}
+
+__attribute__((target("avx512f"))) static void
+xor_gen_pq_avx512(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	const __m512i mask_hi = _mm512_set1_epi8((char)0x80);
+	const __m512i mask_shl = _mm512_set1_epi8((char)0xfe);
+	const __m512i poly = _mm512_set1_epi8(SPDK_XOR_GF_POLY);
+	uint32_t i;
+	int j;
+
+	for (i = 0; i + sizeof(__m512i) <= len; i += sizeof(__m512i)) {
+		__m512i wp, wq, d, hi;
+
+		wp = wq = _mm512_loadu_si512((uint8_t *)sources[n - 1] + i);
+		for (j = n - 2; j >= 0; j--) {
+			d = _mm512_loadu_si512((uint8_t *)sources[j] + i);
+			/* AVX512F has no byte operations, so do the same as gf_mul2_u64() */
+			hi = _mm512_and_si512(wq, mask_hi);
+			hi = _mm512_sub_epi64(_mm512_slli_epi64(hi, 1), _mm512_srli_epi64(hi, 7));
+			wq = _mm512_and_si512(_mm512_slli_epi64(wq, 1), mask_shl);
+			wq = _mm512_xor_si512(wq, _mm512_and_si512(hi, poly));
+			wq = _mm512_xor_si512(wq, d);
+			wp = _mm512_xor_si512(wp, d);
+		}
+		_mm512_storeu_si512((uint8_t *)p + i, wp);
+		_mm512_storeu_si512((uint8_t *)q + i, wq);
+	}
+
+	xor_gen_pq_words(p, q, sources, n, i, len);
+}
+
+static xor_gen_fn g_xor_gen_fn = xor_gen_basic;
+static xor_gen_pq_fn g_xor_gen_pq_fn = xor_gen_pq_basic;
+
+static void
+__attribute__((constructor))
+xor_select_impl(void)
+{
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f")) {
+		g_xor_gen_fn = xor_gen_avx512;
+		g_xor_gen_pq_fn = xor_gen_pq_avx512;
+	} else if (__builtin_cpu_supports("avx2")) {
+		g_xor_gen_fn = xor_gen_avx2;
+		g_xor_gen_pq_fn = xor_gen_pq_avx2;
+	}
+}
+
+#elif defined(SPDK_XOR_HAVE_NEON)
+static void
+xor_gen_neon(void *dest, void **sources, uint32_t n, uint32_t len)
+{
+	uint32_t i, j;
+
+	for (i = 0; i + 4 * sizeof(uint8x16_t) <= len; i += 4 * sizeof(uint8x16_t)) {
+		uint8x16x4_t w, s;
+
+		w = vld1q_u8_x4((uint8_t *)sources[0] + i);
+		for (j = 1; j < n; j++) {
+			s = vld1q_u8_x4((uint8_t *)sources[j] + i);
+			w.val[0] = veorq_u8(w.val[0], s.val[0]);
+			w.val[1] = veorq_u8(w.val[1], s.val[1]);
+			w.val[2] = veorq_u8(w.val[2], s.val[2]);
+			w.val[3] = veorq_u8(w.val[3], s.val[3]);
 		}
+		vst1q_u8_x4((uint8_t *)dest + i, w);
+	}
+
+	for (; i + sizeof(uint8x16_t) <= len; i += sizeof(uint8x16_t)) {
+		uint8x16_t w = vld1q_u8((uint8_t *)sources[0] + i);
+
+		for (j = 1; j < n; j++) {
+			w = veorq_u8(w, vld1q_u8((uint8_t *)sources[j] + i));
+		}
+		vst1q_u8((uint8_t *)dest + i, w);
+	}
+
+	xor_gen_words(dest, sources, n, i, len);
+}
 
-		xor_gen_unaligned((uint8_t *)dest + len_rem, sources2, n, len - len_rem);
+static void
+xor_gen_pq_neon(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	const uint8x16_t poly = vdupq_n_u8(SPDK_XOR_GF_POLY);
+	uint32_t i;
+	int j;
+
+	for (i = 0; i + sizeof(uint8x16_t) <= len; i += sizeof(uint8x16_t)) {
+		uint8x16_t wp, wq, d, hi;
+
+		wp = wq = vld1q_u8((uint8_t *)sources[n - 1] + i);
+		for (j = n - 2; j >= 0; j--) {
+			d = vld1q_u8((uint8_t *)sources[j] + i);
+			/* Arithmetic shift turns each byte with its high bit set into 0xff */
+			hi = vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(wq), 7));
+			wq = veorq_u8(vshlq_n_u8(wq, 1), vandq_u8(hi, poly));
+			wq = veorq_u8(wq, d);
+			wp = veorq_u8(wp, d);
+		}
+		vst1q_u8((uint8_t *)p + i, wp);
+		vst1q_u8((uint8_t *)q + i, wq);
 	}
+
+	xor_gen_pq_words(p, q, sources, n, i, len);
 }
 
+static xor_gen_fn g_xor_gen_fn = xor_gen_neon;
+static xor_gen_pq_fn g_xor_gen_pq_fn = xor_gen_pq_neon;
+
+#else
+
+static xor_gen_fn g_xor_gen_fn = xor_gen_basic;
+static xor_gen_pq_fn g_xor_gen_pq_fn = xor_gen_pq_basic;
+
+#endif
+
 #ifdef SPDK_CONFIG_ISAL
 #include "isa-l/include/raid.h"
 
 #define SPDK_XOR_BUF_ALIGN 32
 
+static inline bool
+is_aligned(void *ptr, size_t alignment)
+{
+	uintptr_t p = (uintptr_t)ptr;
+
+	return p == SPDK_ALIGN_FLOOR(p, alignment);
+}
+
+static bool
+buffers_aligned(void *dest, void **sources, uint32_t n, size_t alignment)
+{
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		if (!is_aligned(sources[i], alignment)) {
+			return false;
+		}
+	}
+
+	return is_aligned(dest, alignment);
+}
+
 static int
 do_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len)
 {
@@ -106,7 +396,7 @@ do_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len)
 			return -EINVAL;
 		}
 	} else {
-		xor_gen_basic(dest, sources, n, len);
+		g_xor_gen_fn(dest, sources, n, len);
 	}
 
 	return 0;
@@ -119,7 +409,7 @@ do_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len)
 static inline int
 do_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len)
 {
-	xor_gen_basic(dest, sources, n, len);
+	g_xor_gen_fn(dest, sources, n, len);
 	return 0;
 }
 
@@ -135,6 +425,181 @@ spdk_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len)
 	return do_xor_gen(dest, sources, n, len);
 }
 
+int
+spdk_xor_gen_pq(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	/* The generator has 255 distinct powers, so Q can only cover 255 sources */
+	if (n < 2 || n > SPDK_XOR_MAX_SRC - 1) {
+		return -EINVAL;
+	}
+
+	g_xor_gen_pq_fn(p, q, sources, n, len);
+
+	return 0;
+}
+
+static uint8_t
+gf_mul(uint8_t a, uint8_t b)
+{
+	uint8_t r = 0;
+
+	while (b) {
+		if (b & 1) {
+			r ^= a;
+		}
+		a = gf_mul2_u8(a);
+		b >>= 1;
+	}
+
+	return r;
+}
+
+static uint8_t
+gf_pow(uint8_t a, uint32_t e)
+{
+	uint8_t r = 1;
+
+	while (e--) {
+		r = gf_mul(r, a);
+	}
+
+	return r;
+}
+
+static inline uint8_t
+gf_inv(uint8_t a)
+{
+	/* The multiplicative group has 255 elements, so a^254 * a = 1 */
+	return gf_pow(a, 254);
+}
+
+static void
+gf_mul_table(uint8_t *table, uint8_t c)
+{
+	uint32_t i;
+
+	for (i = 0; i < 256; i++) {
+		table[i] = gf_mul(i, c);
+	}
+}
+
+static inline void
+xor_rec_pq_solve(uint8_t *dx, uint8_t *dy, uint8_t bp, uint8_t bq, const uint8_t *a,
+		 const uint8_t *b)
+{
+	if (dy != NULL) {
+		*dx = a[bp] ^ b[bq];
+		*dy = bp ^ *dx;
+	} else {
+		*dx = b[bq];
+	}
+}
+
+/* Calculate Pxy and Qxy, i.e. P (if not NULL) and Q with the remaining data buffers' share
+ * removed, and solve them for the missing buffers x and y using the multiplication tables:
+ * Dx = A[Pxy] ^ B[Qxy] and Dy = Pxy ^ Dx.  If y == n, only x is missing and Dx = B[Qxy]. */
+static void
+xor_rec_pq_words(void *p, void *q, void **sources, uint32_t n, uint32_t x, uint32_t y,
+		 const uint8_t *a, const uint8_t *b, uint32_t len)
+{
+	uint8_t *dx = sources[x], *dy = y < n ? sources[y] : NULL;
+	uint32_t i, k;
+	int j;
+
+	for (i = 0; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t wp = p != NULL ? load_u64((uint8_t *)p + i) : 0;
+		uint64_t wq = 0, d;
+
+		for (j = n - 1; j >= 0; j--) {
+			wq = gf_mul2_u64(wq);
+			if ((uint32_t)j != x && (uint32_t)j != y) {
+				d = load_u64((uint8_t *)sources[j] + i);
+				wp ^= d;
+				wq ^= d;
+			}
+		}
+		wq ^= load_u64((uint8_t *)q + i);
+
+		for (k = 0; k < sizeof(uint64_t); k++) {
+			xor_rec_pq_solve(dx + i + k, dy != NULL ? dy + i + k : NULL,
+					 (uint8_t)(wp >> (8 * k)), (uint8_t)(wq >> (8 * k)), a, b);
+		}
+	}
+
+	for (; i < len; i++) {
+		uint8_t bp = p != NULL ? ((uint8_t *)p)[i] : 0;
+		uint8_t bq = 0, d;
+
+		for (j = n - 1; j >= 0; j--) {
+			bq = gf_mul2_u8(bq);
+			if ((uint32_t)j != x && (uint32_t)j != y) {
+				d = ((uint8_t *)sources[j])[i];
+				bp ^= d;
+				bq ^= d;
+			}
+		}
+		bq ^= ((uint8_t *)q)[i];
+
+		xor_rec_pq_solve(dx + i, dy != NULL ? dy + i : NULL, bp, bq, a, b);
+	}
+}
+
+int
+spdk_xor_rec_pq(void *p, void *q, void **sources, uint32_t n, const uint32_t *missing,
+		uint32_t nmissing, uint32_t len)
+{
+	void *srcs[SPDK_XOR_MAX_SRC];
+	uint8_t a[256], b[256];
+	uint8_t gyx, denom;
+	uint32_t x, y, i, j;
+
+	if (n < 2 || n > SPDK_XOR_MAX_SRC - 1 || nmissing < 1 || nmissing > 2) {
+		return -EINVAL;
+	}
+
+	x = missing[0];
+	y = nmissing == 2 ? missing[1] : n;
+	if (x > y) {
+		x = y;
+		y = missing[0];
+	}
+	if (x == y || y > n || (nmissing == 2 && y == n)) {
+		return -EINVAL;
+	}
+
+	if (nmissing == 1 && p != NULL) {
+		/* A single missing buffer is the xor of P and the remaining ones */
+		for (i = 0, j = 0; i < n; i++) {
+			if (i != x) {
+				srcs[j++] = sources[i];
+			}
+		}
+		srcs[j++] = p;
+
+		return do_xor_gen(sources[x], srcs, j, len);
+	}
+
+	if (q == NULL || (nmissing == 2 && p == NULL)) {
+		return -EINVAL;
+	}
+
+	if (nmissing == 1) {
+		/* Dx = Qx / g^x */
+		gf_mul_table(b, gf_inv(gf_pow(2, x)));
+		xor_rec_pq_words(NULL, q, sources, n, x, n, NULL, b, len);
+		return 0;
+	}
+
+	/* Dx = (g^(y-x) * Pxy + g^(-x) * Qxy) / (g^(y-x) + 1) */
+	gyx = gf_pow(2, y - x);
+	denom = gf_inv(gyx ^ 1);
+	gf_mul_table(a, gf_mul(gyx, denom));
+	gf_mul_table(b, gf_mul(gf_inv(gf_pow(2, x)), denom));
+	xor_rec_pq_words(p, q, sources, n, x, y, a, b, len);
+
+	return 0;
+}
+
 size_t
 spdk_xor_get_optimal_alignment(void)
 {
@@ -0,0 +1,163 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/xxhash.h"
+#include "spdk/endian.h"
+#include "spdk/util.h"
+
+/*
+ * XXH64, as specified in https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md.  The
+ * input is consumed in 32-byte stripes by four independent accumulators, so the main loop isn't
+ * bound by the latency of the multiplications.
+ */
+#define XXH64_PRIME1	0x9e3779b185ebca87ULL
+#define XXH64_PRIME2	0xc2b2ae3d27d4eb4fULL
+#define XXH64_PRIME3	0x165667b19e3779f9ULL
+#define XXH64_PRIME4	0x85ebca77c2b2ae63ULL
+#define XXH64_PRIME5	0x27d4eb2f165667c5ULL
+
+#define XXH64_STRIPE_LEN	32
+
+static inline uint64_t
+xxh64_rotl(uint64_t x, uint32_t r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t
+xxh64_round(uint64_t acc, uint64_t input)
+{
+	acc += input * XXH64_PRIME2;
+	acc = xxh64_rotl(acc, 31);
+
+	return acc * XXH64_PRIME1;
+}
+
+static inline uint64_t
+xxh64_merge_round(uint64_t hash, uint64_t acc)
+{
+	hash ^= xxh64_round(0, acc);
+
+	return hash * XXH64_PRIME1 + XXH64_PRIME4;
+}
+
+static const uint8_t *
+xxh64_stripes(uint64_t acc[4], const uint8_t *data, size_t nstripes)
+{
+	uint64_t a0 = acc[0], a1 = acc[1], a2 = acc[2], a3 = acc[3];
+
+	for (; nstripes > 0; nstripes--, data += XXH64_STRIPE_LEN) {
+		a0 = xxh64_round(a0, from_le64(&data[0]));
+		a1 = xxh64_round(a1, from_le64(&data[8]));
+		a2 = xxh64_round(a2, from_le64(&data[16]));
+		a3 = xxh64_round(a3, from_le64(&data[24]));
+	}
+
+	acc[0] = a0;
+	acc[1] = a1;
+	acc[2] = a2;
+	acc[3] = a3;
+
+	return data;
+}
+
+static uint64_t
+xxh64_finalize(uint64_t hash, const uint8_t *data, size_t len)
+{
+	for (; len >= 8; len -= 8, data += 8) {
+		hash ^= xxh64_round(0, from_le64(data));
+		hash = xxh64_rotl(hash, 27) * XXH64_PRIME1 + XXH64_PRIME4;
+	}
+
+	if (len >= 4) {
+		hash ^= (uint64_t)from_le32(data) * XXH64_PRIME1;
+		hash = xxh64_rotl(hash, 23) * XXH64_PRIME2 + XXH64_PRIME3;
+		data += 4;
+		len -= 4;
+	}
+
+	for (; len > 0; len--, data++) {
+		hash ^= *data * XXH64_PRIME5;
+		hash = xxh64_rotl(hash, 11) * XXH64_PRIME1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= XXH64_PRIME2;
+	hash ^= hash >> 29;
+	hash *= XXH64_PRIME3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+void
+spdk_xxh64_init(struct spdk_xxh64_state *state, uint64_t seed)
+{
+	state->acc[0] = seed + XXH64_PRIME1 + XXH64_PRIME2;
+	state->acc[1] = seed + XXH64_PRIME2;
+	state->acc[2] = seed;
+	state->acc[3] = seed - XXH64_PRIME1;
+	state->seed = seed;
+	state->length = 0;
+	state->buflen = 0;
+}
+
+void
+spdk_xxh64_update(struct spdk_xxh64_state *state, const void *buf, size_t len)
+{
+	const uint8_t *data = buf;
+	size_t n;
+
+	state->length += len;
+	if (state->buflen > 0) {
+		n = spdk_min(len, XXH64_STRIPE_LEN - state->buflen);
+		memcpy(&state->buf[state->buflen], data, n);
+		state->buflen += n;
+		data += n;
+		len -= n;
+		if (state->buflen < XXH64_STRIPE_LEN) {
+			return;
+		}
+		xxh64_stripes(state->acc, state->buf, 1);
+		state->buflen = 0;
+	}
+
+	data = xxh64_stripes(state->acc, data, len / XXH64_STRIPE_LEN);
+	len %= XXH64_STRIPE_LEN;
+
+	memcpy(state->buf, data, len);
+	state->buflen = len;
+}
+
+uint64_t
+spdk_xxh64_digest(const struct spdk_xxh64_state *state)
+{
+	const uint64_t *acc = state->acc;
+	uint64_t hash;
+
+	if (state->length >= XXH64_STRIPE_LEN) {
+		hash = xxh64_rotl(acc[0], 1) + xxh64_rotl(acc[1], 7) +
+		       xxh64_rotl(acc[2], 12) + xxh64_rotl(acc[3], 18);
+		hash = xxh64_merge_round(hash, acc[0]);
+		hash = xxh64_merge_round(hash, acc[1]);
+		hash = xxh64_merge_round(hash, acc[2]);
+		hash = xxh64_merge_round(hash, acc[3]);
+	} else {
+		hash = state->seed + XXH64_PRIME5;
+	}
+
+	return xxh64_finalize(hash + state->length, state->buf, state->buflen);
+}
+
+uint64_t
+spdk_xxh64(const void *buf, size_t len, uint64_t seed)
+{
+	struct spdk_xxh64_state state;
+
+	spdk_xxh64_init(&state, seed);
+	spdk_xxh64_update(&state, buf, len);
+
+	return spdk_xxh64_digest(&state);
+}
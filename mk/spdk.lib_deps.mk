@@ -150,6 +150,8 @@ DEPDIRS-bdev_passthru := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_raid := $(BDEV_DEPS_THREAD)
 ifeq ($(CONFIG_RAID5F),y)
 DEPDIRS-bdev_raid += accel
+else ifeq ($(CONFIG_RAID6F),y)
+DEPDIRS-bdev_raid += accel
 endif
 DEPDIRS-bdev_rbd := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_uring := $(BDEV_DEPS_THREAD)
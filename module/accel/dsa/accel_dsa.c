@@ -293,31 +293,58 @@ _process_single_task(struct spdk_io_channel *ch, struct spdk_accel_task *task)
 }
 
 static int
-dsa_submit_task(struct spdk_io_channel *ch, struct spdk_accel_task *task)
+dsa_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *first_task)
 {
 	struct idxd_io_channel *chan = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task, *tmp;
+	bool flush;
 	int rc = 0;
 
-	assert(STAILQ_NEXT(task, link) == NULL);
+	task = first_task;
+	flush = STAILQ_NEXT(first_task, link) != NULL;
 
 	if (spdk_unlikely(chan->state == IDXD_CHANNEL_ERROR)) {
-		spdk_accel_task_complete(task, -EINVAL);
+		while (task) {
+			tmp = STAILQ_NEXT(task, link);
+			spdk_accel_task_complete(task, -EINVAL);
+			task = tmp;
+		}
 		return 0;
 	}
 
 	if (!STAILQ_EMPTY(&chan->queued_tasks)) {
-		STAILQ_INSERT_TAIL(&chan->queued_tasks, task, link);
-		return 0;
+		goto queue_tasks;
 	}
 
-	rc = _process_single_task(ch, task);
-	if (rc == -EBUSY) {
-		STAILQ_INSERT_TAIL(&chan->queued_tasks, task, link);
-	} else if (rc) {
-		spdk_accel_task_complete(task, rc);
+	/* Multiple tasks are only passed in when the user submits an accel batch.  The descriptors
+	 * are accumulated in an idxd batch, so make sure it's sent to the device once all of them
+	 * are prepared, instead of waiting for the next poll.
+	 */
+	while (task) {
+		tmp = STAILQ_NEXT(task, link);
+		rc = _process_single_task(ch, task);
+
+		if (rc == -EBUSY) {
+			goto queue_tasks;
+		} else if (rc) {
+			spdk_accel_task_complete(task, rc);
+		}
+		task = tmp;
+	}
+
+	if (flush) {
+		spdk_idxd_flush(chan->chan);
 	}
 
 	return 0;
+
+queue_tasks:
+	while (task != NULL) {
+		tmp = STAILQ_NEXT(task, link);
+		STAILQ_INSERT_TAIL(&chan->queued_tasks, task, link);
+		task = tmp;
+	}
+	return 0;
 }
 
 static int
@@ -410,7 +437,8 @@ static struct spdk_accel_module_if g_dsa_module = {
 	.name			= "dsa",
 	.supports_opcode	= dsa_supports_opcode,
 	.get_io_channel		= dsa_get_io_channel,
-	.submit_tasks		= dsa_submit_task
+	.submit_tasks		= dsa_submit_tasks,
+	.submit_task_lists	= true,
 };
 
 static int
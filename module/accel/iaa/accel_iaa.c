@@ -165,9 +165,11 @@ iaa_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *first_task)
 {
 	struct idxd_io_channel *chan = spdk_io_channel_get_ctx(ch);
 	struct spdk_accel_task *task, *tmp;
+	bool flush;
 	int rc = 0;
 
 	task = first_task;
+	flush = STAILQ_NEXT(first_task, link) != NULL;
 
 	if (chan->state == IDXD_CHANNEL_ERROR) {
 		while (task) {
@@ -200,6 +202,10 @@ iaa_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *first_task)
 		task = tmp;
 	}
 
+	if (flush) {
+		spdk_idxd_flush(chan->chan);
+	}
+
 	return 0;
 
 queue_tasks:
@@ -271,7 +277,8 @@ static struct spdk_accel_module_if g_iaa_module = {
 	.name			= "iaa",
 	.supports_opcode	= iaa_supports_opcode,
 	.get_io_channel		= iaa_get_io_channel,
-	.submit_tasks		= iaa_submit_tasks
+	.submit_tasks		= iaa_submit_tasks,
+	.submit_task_lists	= true,
 };
 
 static int
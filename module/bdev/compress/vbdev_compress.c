@@ -50,6 +50,7 @@ struct vbdev_compress {
 	TAILQ_HEAD(, spdk_bdev_io)	pending_comp_ios;	/* outstanding operations to a comp library */
 	struct spdk_poller		*poller;	/* completion poller */
 	struct spdk_reduce_vol_params	params;		/* params for the reduce volume */
+	uint32_t			comp_level;	/* level used to compress the chunks */
 	struct spdk_reduce_backing_dev	backing_dev;	/* backing device info for the reduce volume */
 	struct spdk_reduce_vol		*vol;		/* the reduce volume */
 	struct vbdev_comp_delete_ctx	*delete_ctx;
@@ -133,13 +134,16 @@ _compress_operation(struct spdk_reduce_backing_dev *backing_dev, struct iovec *s
 
 	if (compress) {
 		assert(dst_iovcnt == 1);
-		rc = spdk_accel_submit_compress(comp_bdev->accel_channel, dst_iovs[0].iov_base, dst_iovs[0].iov_len,
-						src_iovs, src_iovcnt, &reduce_cb_arg->output_size,
-						reduce_cb_arg->cb_fn, reduce_cb_arg->cb_arg);
+		rc = spdk_accel_submit_compress_ext(comp_bdev->accel_channel, dst_iovs[0].iov_base,
+						    dst_iovs[0].iov_len, src_iovs, src_iovcnt,
+						    comp_bdev->params.comp_algo, comp_bdev->comp_level,
+						    &reduce_cb_arg->output_size, reduce_cb_arg->cb_fn,
+						    reduce_cb_arg->cb_arg);
 	} else {
-		rc = spdk_accel_submit_decompress(comp_bdev->accel_channel, dst_iovs, dst_iovcnt,
-						  src_iovs, src_iovcnt, &reduce_cb_arg->output_size,
-						  reduce_cb_arg->cb_fn, reduce_cb_arg->cb_arg);
+		rc = spdk_accel_submit_decompress_ext(comp_bdev->accel_channel, dst_iovs, dst_iovcnt,
+						      src_iovs, src_iovcnt, comp_bdev->params.comp_algo,
+						      &reduce_cb_arg->output_size, reduce_cb_arg->cb_fn,
+						      reduce_cb_arg->cb_arg);
 	}
 
 	return rc;
@@ -495,6 +499,9 @@ vbdev_compress_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
 	spdk_json_write_object_begin(w);
 	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&comp_bdev->comp_bdev));
 	spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(comp_bdev->base_bdev));
+	spdk_json_write_named_string(w, "comp_algo",
+				     spdk_accel_get_comp_algo_name(comp_bdev->params.comp_algo));
+	spdk_json_write_named_uint32(w, "comp_level", comp_bdev->comp_level);
 	spdk_json_write_object_end(w);
 
 	return 0;
@@ -757,9 +764,39 @@ _prepare_for_load_init(struct spdk_bdev_desc *bdev_desc, uint32_t lb_size)
 	return meta_ctx;
 }
 
+/* Checks that the compression algorithm of a volume is supported and returns the level to use,
+ * level 0 selecting the fastest one.
+ */
+static int
+vbdev_compress_get_level(uint32_t comp_algo, uint32_t comp_level, uint32_t *level)
+{
+	const char *name = spdk_accel_get_comp_algo_name(comp_algo);
+	uint32_t min_level, max_level;
+
+	if (spdk_accel_get_compress_level_range(comp_algo, &min_level, &max_level) != 0) {
+		SPDK_ERRLOG("Compression algorithm %s isn't supported\n", name ? name : "unknown");
+		return -ENOTSUP;
+	}
+
+	if (comp_level == 0) {
+		*level = min_level;
+		return 0;
+	}
+
+	if (comp_level < min_level || comp_level > max_level) {
+		SPDK_ERRLOG("Compression level %" PRIu32 " of %s is outside of supported range [%"
+			    PRIu32 ", %" PRIu32 "]\n", comp_level, name, min_level, max_level);
+		return -EINVAL;
+	}
+
+	*level = comp_level;
+	return 0;
+}
+
 /* Call reducelib to initialize a new volume */
 static int
-vbdev_init_reduce(const char *bdev_name, const char *pm_path, uint32_t lb_size)
+vbdev_init_reduce(const char *bdev_name, const char *pm_path, uint32_t lb_size,
+		  enum spdk_accel_comp_algo comp_algo, uint32_t comp_level)
 {
 	struct spdk_bdev_desc *bdev_desc = NULL;
 	struct vbdev_compress *meta_ctx;
@@ -778,6 +815,9 @@ vbdev_init_reduce(const char *bdev_name, const char *pm_path, uint32_t lb_size)
 		return -EINVAL;
 	}
 
+	meta_ctx->params.comp_algo = comp_algo;
+	meta_ctx->params.comp_level = comp_level;
+
 	/* Save the thread where the base device is opened */
 	meta_ctx->thread = spdk_get_thread();
 
@@ -864,22 +904,30 @@ comp_bdev_ch_destroy_cb(void *io_device, void *ctx_buf)
 
 /* RPC entry point for compression vbdev creation. */
 int
-create_compress_bdev(const char *bdev_name, const char *pm_path, uint32_t lb_size)
+create_compress_bdev(const char *bdev_name, const char *pm_path, uint32_t lb_size,
+		     enum spdk_accel_comp_algo comp_algo, uint32_t comp_level)
 {
 	struct vbdev_compress *comp_bdev = NULL;
+	uint32_t level;
+	int rc;
 
 	if ((lb_size != 0) && (lb_size != LB_SIZE_4K) && (lb_size != LB_SIZE_512B)) {
 		SPDK_ERRLOG("Logical block size must be 512 or 4096\n");
 		return -EINVAL;
 	}
 
+	rc = vbdev_compress_get_level(comp_algo, comp_level, &level);
+	if (rc != 0) {
+		return rc;
+	}
+
 	TAILQ_FOREACH(comp_bdev, &g_vbdev_comp, link) {
 		if (strcmp(bdev_name, comp_bdev->base_bdev->name) == 0) {
 			SPDK_ERRLOG("Bass bdev %s already being used for a compress bdev\n", bdev_name);
 			return -EBUSY;
 		}
 	}
-	return vbdev_init_reduce(bdev_name, pm_path, lb_size);
+	return vbdev_init_reduce(bdev_name, pm_path, lb_size, comp_algo, comp_level);
 }
 
 static int
@@ -953,6 +1001,12 @@ vbdev_compress_claim(struct vbdev_compress *comp_bdev)
 	struct spdk_uuid ns_uuid;
 	int rc;
 
+	rc = vbdev_compress_get_level(comp_bdev->params.comp_algo, comp_bdev->params.comp_level,
+				      &comp_bdev->comp_level);
+	if (rc != 0) {
+		return rc;
+	}
+
 	if (_set_compbdev_name(comp_bdev)) {
 		return -EINVAL;
 	}
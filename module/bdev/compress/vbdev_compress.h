@@ -9,6 +9,7 @@
 
 #include "spdk/stdinc.h"
 
+#include "spdk/accel.h"
 #include "spdk/bdev.h"
 
 #define LB_SIZE_4K	0x1000UL
@@ -53,9 +54,12 @@ typedef void (*spdk_delete_compress_complete)(void *cb_arg, int bdeverrno);
  * \param bdev_name Bdev on which compression bdev will be created.
  * \param pm_path Path to persistent memory.
  * \param lb_size Logical block size for the compressed volume in bytes. Must be 4K or 512.
+ * \param comp_algo Compression algorithm.
+ * \param comp_level Compression level, 0 selects the fastest level of the algorithm.
  * \return 0 on success, other on failure.
  */
-int create_compress_bdev(const char *bdev_name, const char *pm_path, uint32_t lb_size);
+int create_compress_bdev(const char *bdev_name, const char *pm_path, uint32_t lb_size,
+			 enum spdk_accel_comp_algo comp_algo, uint32_t comp_level);
 
 /**
  * Delete compress bdev.
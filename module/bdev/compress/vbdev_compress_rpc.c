@@ -76,6 +76,8 @@ struct rpc_construct_compress {
 	char *base_bdev_name;
 	char *pm_path;
 	uint32_t lb_size;
+	enum spdk_accel_comp_algo comp_algo;
+	uint32_t comp_level;
 };
 
 /* Free the allocated memory resource after the RPC handling. */
@@ -86,11 +88,28 @@ free_rpc_construct_compress(struct rpc_construct_compress *r)
 	free(r->pm_path);
 }
 
+static int
+decode_comp_algo(const struct spdk_json_val *val, void *out)
+{
+	int ret;
+	char *str = NULL;
+
+	ret = spdk_json_decode_string(val, &str);
+	if (ret == 0 && str != NULL) {
+		ret = spdk_accel_get_comp_algo_by_name(str, out);
+	}
+
+	free(str);
+	return ret;
+}
+
 /* Structure to decode the input parameters for this RPC method. */
 static const struct spdk_json_object_decoder rpc_construct_compress_decoders[] = {
 	{"base_bdev_name", offsetof(struct rpc_construct_compress, base_bdev_name), spdk_json_decode_string},
 	{"pm_path", offsetof(struct rpc_construct_compress, pm_path), spdk_json_decode_string},
 	{"lb_size", offsetof(struct rpc_construct_compress, lb_size), spdk_json_decode_uint32, true},
+	{"comp_algo", offsetof(struct rpc_construct_compress, comp_algo), decode_comp_algo, true},
+	{"comp_level", offsetof(struct rpc_construct_compress, comp_level), spdk_json_decode_uint32, true},
 };
 
 /* Decode the parameters for this RPC method and properly construct the compress
@@ -114,7 +133,8 @@ rpc_bdev_compress_create(struct spdk_jsonrpc_request *request,
 		goto cleanup;
 	}
 
-	rc = create_compress_bdev(req.base_bdev_name, req.pm_path, req.lb_size);
+	rc = create_compress_bdev(req.base_bdev_name, req.pm_path, req.lb_size, req.comp_algo,
+				  req.comp_level);
 	if (rc != 0) {
 		if (rc == -EBUSY) {
 			spdk_jsonrpc_send_error_response(request, rc, "Base bdev already in use for compression.");
@@ -5,6 +5,7 @@
  */
 
 #include "bdev_raid.h"
+#include "spdk/bit_array.h"
 #include "spdk/env.h"
 #include "spdk/thread.h"
 #include "spdk/log.h"
@@ -15,8 +16,11 @@
 
 #define RAID_OFFSET_BLOCKS_INVALID	UINT64_MAX
 #define RAID_BDEV_PROCESS_MAX_QD	16
+#define RAID_BDEV_PROCESS_MAX_WINDOW_SCALE	8
 
 #define RAID_BDEV_PROCESS_WINDOW_SIZE_KB_DEFAULT 1024
+#define RAID_BDEV_BITMAP_REGION_SIZE_KB_DEFAULT (64 * 1024)
+#define RAID_BDEV_BITMAP_CLEAN_PERIOD_US (1000 * 1000)
 
 static bool g_shutdown_started = false;
 
@@ -36,12 +40,23 @@ struct raid_bdev_io_channel {
 	/* Private raid module IO channel */
 	struct spdk_io_channel	*module_channel;
 
+	/* Number of base bdevs in the data layout used by this channel */
+	uint8_t			num_base_bdevs;
+
 	/* Background process data */
 	struct {
 		uint64_t offset;
 		struct spdk_io_channel *target_ch;
 		struct raid_bdev_io_channel *ch_processed;
 	} process;
+
+	/* Write-intent bitmap counters, only modified by the thread of this channel */
+	struct {
+		/* Number of writes started and completed per region */
+		uint32_t *starts;
+		uint32_t *completes;
+		TAILQ_ENTRY(raid_bdev_io_channel) link;
+	} bitmap;
 };
 
 enum raid_bdev_process_state {
@@ -58,17 +73,79 @@ struct raid_bdev_process {
 	struct spdk_thread		*thread;
 	struct raid_bdev_io_channel	*raid_ch;
 	TAILQ_HEAD(, raid_bdev_process_request) requests;
+	/* Requests that ran out of module resources, resubmitted as the others complete */
+	TAILQ_HEAD(, raid_bdev_process_request) nomem_requests;
+	uint64_t			nomem_blocks;
 	uint64_t			max_window_size;
 	uint64_t			window_size;
 	uint64_t			window_remaining;
 	int				window_status;
 	uint64_t			window_offset;
+	uint64_t			window_range_size;
 	bool				window_range_locked;
+	bool				use_bitmap;
+	/* Window size in units of max_window_size, changed by the adaptive mode */
+	uint32_t			window_scale;
+	uint32_t			window_num_requests;
+	uint64_t			window_start_tsc;
+	/* Sum of the per-block latencies of the window's requests */
+	uint64_t			window_latency_ticks;
+	/* Lowest per-block request latency seen, i.e. the latency of idle base bdevs */
+	uint64_t			baseline_latency_ticks;
+	/* The next window can't be started before this time because of the rate limits */
+	uint64_t			throttle_tsc;
+	struct spdk_poller		*throttle_poller;
+	/* Copies of the options taken when the process is created */
+	uint32_t			max_mbytes_per_sec;
+	uint32_t			max_ios_per_sec;
+	bool				adaptive;
 	struct raid_base_bdev_info	*target;
 	int				status;
 	TAILQ_HEAD(, raid_process_finish_action) finish_actions;
 };
 
+/*
+ * Write-intent bitmap. Each bit represents a region of the raid bdev that may have been written
+ * to only partially, e.g. because of a crash, and needs to be resynchronized. A region is marked
+ * dirty on disk before any write to it is submitted and cleared lazily, after it hasn't been
+ * written to for some time and all base bdevs are present.
+ */
+struct raid_bdev_bitmap {
+	struct raid_bdev		*raid_bdev;
+	/*
+	 * Protects the region state, which is accessed from the raid bdev I/O channel threads.
+	 * Writes to regions which are already dirty and persisted don't take it.
+	 */
+	struct spdk_spinlock		lock;
+	uint64_t			region_size;
+	uint32_t			num_regions;
+	/* Regions which may contain inconsistent data */
+	struct spdk_bit_array		*dirty;
+	/* Regions which are known to be marked as dirty on disk */
+	struct spdk_bit_array		*persisted;
+	/* Regions cleared by the clean poller, used to recheck them for racing writes */
+	struct spdk_bit_array		*cleared;
+	/* Sum of the per-channel write start counters seen by the last run of the clean poller */
+	uint32_t			*starts_seen;
+	/* I/O channels of the raid bdev, their counters are aggregated by the clean poller */
+	TAILQ_HEAD(, raid_bdev_io_channel) channels;
+	/* The on-disk representation of the bitmap */
+	uint8_t				*buf;
+	/* Incremented when a region is marked dirty and a bitmap write is required */
+	uint64_t			gen;
+	/* Value of gen at the time the bitmap write in progress was started */
+	uint64_t			write_gen;
+	bool				write_needed;
+	bool				writing;
+	/* Set if the dirty regions found when loading the bitmap were not resynchronized yet */
+	bool				needs_resync;
+	/* Writes waiting for their regions to be persisted as dirty */
+	TAILQ_HEAD(, raid_bdev_io)	waiters;
+	struct spdk_poller		*clean_poller;
+	spdk_msg_fn			stop_cb;
+	void				*stop_cb_ctx;
+};
+
 struct raid_process_finish_action {
 	spdk_msg_fn cb;
 	void *cb_ctx;
@@ -77,6 +154,7 @@ struct raid_process_finish_action {
 
 static struct spdk_raid_bdev_opts g_opts = {
 	.process_window_size_kb = RAID_BDEV_PROCESS_WINDOW_SIZE_KB_DEFAULT,
+	.bitmap_region_size_kb = RAID_BDEV_BITMAP_REGION_SIZE_KB_DEFAULT,
 };
 
 void
@@ -137,6 +215,12 @@ raid_bdev_channel_get_module_ctx(struct raid_bdev_io_channel *raid_ch)
 	return spdk_io_channel_get_ctx(raid_ch->module_channel);
 }
 
+uint8_t
+raid_bdev_channel_get_num_base_bdevs(struct raid_bdev_io_channel *raid_ch)
+{
+	return raid_ch->num_base_bdevs;
+}
+
 struct raid_base_bdev_info *
 raid_bdev_channel_get_base_info(struct raid_bdev_io_channel *raid_ch, struct spdk_bdev *base_bdev)
 {
@@ -161,6 +245,13 @@ static void	raid_bdev_examine(struct spdk_bdev *bdev);
 static int	raid_bdev_init(void);
 static void	raid_bdev_deconfigure(struct raid_bdev *raid_bdev,
 				      raid_bdev_destruct_cb cb_fn, void *cb_arg);
+static void	raid_bdev_bitmap_unmark(struct raid_bdev_io *raid_io);
+static int	raid_bdev_bitmap_ch_setup(struct raid_bdev_io_channel *raid_ch,
+		struct raid_bdev_bitmap *bitmap);
+static void	raid_bdev_bitmap_ch_cleanup(struct raid_bdev_io_channel *raid_ch,
+		struct raid_bdev_bitmap *bitmap);
+static void	raid_bdev_bitmap_stop(struct raid_bdev *raid_bdev, spdk_msg_fn cb, void *cb_ctx);
+static void	raid_bdev_bitmap_free(struct raid_bdev *raid_bdev);
 
 static void
 raid_bdev_ch_process_cleanup(struct raid_bdev_io_channel *raid_ch)
@@ -179,6 +270,55 @@ raid_bdev_ch_process_cleanup(struct raid_bdev_io_channel *raid_ch)
 	}
 }
 
+/*
+ * Makes the channel use the new data layout of a reshape below the offset. The base bdevs added
+ * by the reshape are only used by the new layout, so their channels are not obtained earlier.
+ */
+static int
+raid_bdev_ch_reshape_setup(struct raid_bdev_io_channel *raid_ch, struct raid_bdev *raid_bdev,
+			   uint64_t offset)
+{
+	struct raid_bdev_io_channel *raid_ch_processed;
+	uint8_t i;
+
+	if (raid_ch->process.ch_processed == NULL) {
+		for (i = raid_ch->num_base_bdevs; i < raid_bdev->num_base_bdevs; i++) {
+			if (raid_ch->base_channel[i] == NULL) {
+				raid_ch->base_channel[i] = spdk_bdev_get_io_channel(
+								   raid_bdev->base_bdev_info[i].desc);
+				if (raid_ch->base_channel[i] == NULL) {
+					goto err;
+				}
+			}
+		}
+
+		raid_ch_processed = calloc(1, sizeof(*raid_ch_processed));
+		if (raid_ch_processed == NULL) {
+			goto err;
+		}
+		raid_ch->process.ch_processed = raid_ch_processed;
+
+		raid_ch_processed->base_channel = calloc(raid_bdev->num_base_bdevs,
+						  sizeof(*raid_ch_processed->base_channel));
+		if (raid_ch_processed->base_channel == NULL) {
+			goto err;
+		}
+		memcpy(raid_ch_processed->base_channel, raid_ch->base_channel,
+		       raid_bdev->num_base_bdevs * sizeof(*raid_ch_processed->base_channel));
+
+		raid_ch_processed->module_channel = raid_ch->module_channel;
+		raid_ch_processed->num_base_bdevs = raid_bdev->num_base_bdevs;
+		raid_ch_processed->process.offset = RAID_OFFSET_BLOCKS_INVALID;
+	}
+
+	raid_ch->process.offset = offset;
+
+	return 0;
+err:
+	raid_bdev_ch_process_cleanup(raid_ch);
+	return -ENOMEM;
+}
+
 static int
 raid_bdev_ch_process_setup(struct raid_bdev_io_channel *raid_ch, struct raid_bdev_process *process)
 {
@@ -186,12 +326,17 @@ raid_bdev_ch_process_setup(struct raid_bdev_io_channel *raid_ch, struct raid_bde
 	struct raid_bdev_io_channel *raid_ch_processed;
 	struct raid_base_bdev_info *base_info;
 
-	raid_ch->process.offset = process->window_offset;
+	if (process->type == RAID_PROCESS_RESHAPE) {
+		return raid_bdev_ch_reshape_setup(raid_ch, raid_bdev, process->window_offset);
+	}
+
+	if (process->target == NULL) {
+		/* A process without a target, like resync, doesn't change the I/O path */
+		raid_ch->process.offset = RAID_OFFSET_BLOCKS_INVALID;
+		return 0;
+	}
 
-	/* In the future we may have other types of processes which don't use a target bdev,
-	 * like data scrubbing or strip size migration. Until then, expect that there always is
-	 * a process target. */
-	assert(process->target != NULL);
+	raid_ch->process.offset = process->window_offset;
 
 	raid_ch->process.target_ch = spdk_bdev_get_io_channel(process->target->desc);
 	if (raid_ch->process.target_ch == NULL) {
@@ -221,6 +366,7 @@ raid_bdev_ch_process_setup(struct raid_bdev_io_channel *raid_ch, struct raid_bde
 	}
 
 	raid_ch_processed->module_channel = raid_ch->module_channel;
+	raid_ch_processed->num_base_bdevs = raid_ch->num_base_bdevs;
 	raid_ch_processed->process.offset = RAID_OFFSET_BLOCKS_INVALID;
 
 	return 0;
@@ -258,6 +404,7 @@ raid_bdev_create_cb(void *io_device, void *ctx_buf)
 		SPDK_ERRLOG("Unable to allocate base bdevs io channel\n");
 		return -ENOMEM;
 	}
+	raid_ch->num_base_bdevs = raid_bdev_layout_num_base_bdevs(raid_bdev);
 
 	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
 		/*
@@ -265,10 +412,12 @@ raid_bdev_create_cb(void *io_device, void *ctx_buf)
 		 * split logic to send the respective child bdev ios to respective base
 		 * bdev io channel.
 		 * Skip missing base bdevs and the process target, which should also be treated as
-		 * missing until the process completes.
+		 * missing until the process completes. Base bdevs being added by a reshape are
+		 * skipped too, they are not part of the data layout yet.
 		 */
 		if (raid_bdev->base_bdev_info[i].is_configured == false ||
-		    raid_bdev->base_bdev_info[i].is_process_target == true) {
+		    raid_bdev->base_bdev_info[i].is_process_target == true ||
+		    i >= raid_ch->num_base_bdevs) {
 			continue;
 		}
 		raid_ch->base_channel[i] = spdk_bdev_get_io_channel(
@@ -293,10 +442,24 @@ raid_bdev_create_cb(void *io_device, void *ctx_buf)
 			SPDK_ERRLOG("Failed to setup process io channel\n");
 			goto err;
 		}
+	} else if (raid_bdev->reshape.restriping) {
+		ret = raid_bdev_ch_reshape_setup(raid_ch, raid_bdev, raid_bdev->reshape.offset);
+		if (ret != 0) {
+			SPDK_ERRLOG("Failed to setup reshape io channel\n");
+			goto err;
+		}
 	} else {
 		raid_ch->process.offset = RAID_OFFSET_BLOCKS_INVALID;
 	}
 
+	if (raid_bdev->bitmap != NULL) {
+		ret = raid_bdev_bitmap_ch_setup(raid_ch, raid_bdev->bitmap);
+		if (ret != 0) {
+			SPDK_ERRLOG("Failed to setup write-intent bitmap io channel\n");
+			goto err;
+		}
+	}
+
 	return 0;
 err:
 	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
@@ -347,6 +510,7 @@ raid_bdev_destroy_cb(void *io_device, void *ctx_buf)
 	raid_ch->base_channel = NULL;
 
 	raid_bdev_ch_process_cleanup(raid_ch);
+	raid_bdev_bitmap_ch_cleanup(raid_ch, raid_bdev->bitmap);
 }
 
 /*
@@ -379,6 +543,7 @@ raid_bdev_cleanup(struct raid_bdev *raid_bdev)
 static void
 raid_bdev_free(struct raid_bdev *raid_bdev)
 {
+	raid_bdev_bitmap_free(raid_bdev);
 	raid_bdev_free_superblock(raid_bdev);
 	free(raid_bdev->base_bdev_info);
 	free(raid_bdev->bdev.name);
@@ -425,6 +590,7 @@ raid_bdev_free_base_bdev_resource(struct raid_base_bdev_info *base_info)
 		spdk_uuid_set_null(&base_info->uuid);
 	}
 	base_info->is_failed = false;
+	base_info->partial_rebuild = false;
 
 	if (base_info->desc == NULL) {
 		return;
@@ -475,6 +641,12 @@ _raid_bdev_destruct(void *ctxt)
 
 	assert(raid_bdev->process == NULL);
 
+	if (raid_bdev->bitmap != NULL) {
+		/* Store the final state of the bitmap while the base bdevs are still open */
+		raid_bdev_bitmap_stop(raid_bdev, _raid_bdev_destruct, raid_bdev);
+		return;
+	}
+
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
 		/*
 		 * Close all base bdev descriptors for which call has come from below
@@ -644,6 +816,9 @@ raid_bdev_io_complete(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status sta
 				status = SPDK_BDEV_IO_STATUS_FAILED;
 			}
 		}
+		if (raid_io->bitmap.ch != NULL) {
+			raid_bdev_bitmap_unmark(raid_io);
+		}
 		spdk_bdev_io_complete(bdev_io, status);
 	}
 }
@@ -897,2481 +1072,4532 @@ raid_bdev_io_init(struct raid_bdev_io *raid_io, struct raid_bdev_io_channel *rai
 	raid_io->base_bdev_io_submitted = 0;
 	raid_io->completion_cb = NULL;
 	raid_io->split.offset = RAID_OFFSET_BLOCKS_INVALID;
+	raid_io->bitmap.ch = NULL;
 
 	raid_bdev_io_set_default_status(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
 }
 
-/*
- * brief:
- * raid_bdev_submit_request function is the submit_request function pointer of
- * raid bdev function table. This is used to submit the io on raid_bdev to below
- * layers.
- * params:
- * ch - pointer to raid bdev io channel
- * bdev_io - pointer to parent bdev_io on raid bdev device
- * returns:
- * none
- */
 static void
-raid_bdev_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+raid_bdev_submit_null_payload_request(struct raid_bdev_io *raid_io)
 {
-	struct raid_bdev_io *raid_io = (struct raid_bdev_io *)bdev_io->driver_ctx;
-
-	raid_bdev_io_init(raid_io, spdk_io_channel_get_ctx(ch), bdev_io->type,
-			  bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks,
-			  bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, bdev_io->u.bdev.md_buf,
-			  bdev_io->u.bdev.memory_domain, bdev_io->u.bdev.memory_domain_ctx);
-
-	switch (bdev_io->type) {
-	case SPDK_BDEV_IO_TYPE_READ:
-		spdk_bdev_io_get_buf(bdev_io, raid_bdev_get_buf_cb,
-				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
-		break;
-	case SPDK_BDEV_IO_TYPE_WRITE:
-		raid_bdev_submit_rw_request(raid_io);
-		break;
+	if (raid_io->raid_bdev->process != NULL) {
+		/* TODO: rebuild support */
+		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+	raid_io->raid_bdev->module->submit_null_payload_request(raid_io);
+}
 
-	case SPDK_BDEV_IO_TYPE_RESET:
-		raid_bdev_submit_reset_request(raid_io);
-		break;
+static inline uint32_t
+raid_bdev_bitmap_region(struct raid_bdev_bitmap *bitmap, uint64_t offset_blocks)
+{
+	/* The last region also covers the blocks added by growing the raid bdev */
+	return spdk_min(offset_blocks / bitmap->region_size, bitmap->num_regions - 1);
+}
 
-	case SPDK_BDEV_IO_TYPE_FLUSH:
-	case SPDK_BDEV_IO_TYPE_UNMAP:
-		if (raid_io->raid_bdev->process != NULL) {
-			/* TODO: rebuild support */
-			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
-			return;
-		}
-		raid_io->raid_bdev->module->submit_null_payload_request(raid_io);
-		break;
+static void raid_bdev_bitmap_write(struct raid_bdev_bitmap *bitmap);
 
-	default:
-		SPDK_ERRLOG("submit request, invalid io type %u\n", bdev_io->type);
-		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
-		break;
-	}
+static void
+_raid_bdev_bitmap_write(void *ctx)
+{
+	raid_bdev_bitmap_write(ctx);
 }
 
 /*
- * brief:
- * _raid_bdev_io_type_supported checks whether io_type is supported in
- * all base bdev modules of raid bdev module. If anyone among the base_bdevs
- * doesn't support, the raid device doesn't supports.
- *
- * params:
- * raid_bdev - pointer to raid bdev context
- * io_type - io type
- * returns:
- * true - io_type is supported
- * false - io_type is not supported
+ * Mark the regions written by raid_io as dirty. Returns true if the I/O may be submitted
+ * immediately or false if it was queued until the regions are persisted as dirty.
  */
-inline static bool
-_raid_bdev_io_type_supported(struct raid_bdev *raid_bdev, enum spdk_bdev_io_type io_type)
+static bool
+raid_bdev_bitmap_mark(struct raid_bdev_io *raid_io)
 {
-	struct raid_base_bdev_info *base_info;
+	struct raid_bdev_bitmap *bitmap = raid_io->raid_bdev->bitmap;
+	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
+	uint32_t region_first = raid_bdev_bitmap_region(bitmap, raid_io->offset_blocks);
+	uint32_t region_last = raid_bdev_bitmap_region(bitmap,
+			       raid_io->offset_blocks + raid_io->num_blocks - 1);
+	uint32_t region;
+	bool changed = false, persisted = true, start_write = false;
 
-	if (io_type == SPDK_BDEV_IO_TYPE_FLUSH ||
-	    io_type == SPDK_BDEV_IO_TYPE_UNMAP) {
-		if (raid_bdev->module->submit_null_payload_request == NULL) {
-			return false;
-		}
+	raid_io->bitmap.ch = raid_ch;
+
+	for (region = region_first; region <= region_last; region++) {
+		__atomic_store_n(&raid_ch->bitmap.starts[region], raid_ch->bitmap.starts[region] + 1,
+				 __ATOMIC_RELAXED);
 	}
 
-	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
-		if (base_info->desc == NULL) {
-			continue;
-		}
+	/*
+	 * Pairs with the fence in raid_bdev_bitmap_clean_poller(). Either the clean poller sees
+	 * the started write and keeps the regions dirty, or the write sees a region cleared and
+	 * takes the slow path below.
+	 */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
 
-		if (spdk_bdev_io_type_supported(spdk_bdev_desc_get_bdev(base_info->desc), io_type) == false) {
-			return false;
+	for (region = region_first; region <= region_last; region++) {
+		if (!spdk_bit_array_get(bitmap->dirty, region) ||
+		    !spdk_bit_array_get(bitmap->persisted, region)) {
+			break;
 		}
 	}
+	if (spdk_likely(region > region_last)) {
+		return true;
+	}
 
-	return true;
-}
+	spdk_spin_lock(&bitmap->lock);
 
-/*
- * brief:
- * raid_bdev_io_type_supported is the io_supported function for bdev function
- * table which returns whether the particular io type is supported or not by
- * raid bdev module
- * params:
- * ctx - pointer to raid bdev context
- * type - io type
- * returns:
- * true - io_type is supported
- * false - io_type is not supported
- */
-static bool
-raid_bdev_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
-{
-	switch (io_type) {
-	case SPDK_BDEV_IO_TYPE_READ:
-	case SPDK_BDEV_IO_TYPE_WRITE:
-		return true;
+	for (region = region_first; region <= region_last; region++) {
+		if (!spdk_bit_array_get(bitmap->dirty, region)) {
+			spdk_bit_array_set(bitmap->dirty, region);
+			changed = true;
+		}
+		if (!spdk_bit_array_get(bitmap->persisted, region)) {
+			persisted = false;
+		}
+	}
 
-	case SPDK_BDEV_IO_TYPE_FLUSH:
-	case SPDK_BDEV_IO_TYPE_RESET:
-	case SPDK_BDEV_IO_TYPE_UNMAP:
-		return _raid_bdev_io_type_supported(ctx, io_type);
+	if (!persisted) {
+		if (changed) {
+			bitmap->gen++;
+			bitmap->write_needed = true;
+		}
+		raid_io->bitmap.gen = bitmap->gen;
+		TAILQ_INSERT_TAIL(&bitmap->waiters, raid_io, bitmap.link);
 
-	default:
-		return false;
+		if (!bitmap->writing) {
+			bitmap->writing = true;
+			start_write = true;
+		}
 	}
 
-	return false;
-}
+	spdk_spin_unlock(&bitmap->lock);
 
-/*
- * brief:
- * raid_bdev_get_io_channel is the get_io_channel function table pointer for
- * raid bdev. This is used to return the io channel for this raid bdev
- * params:
- * ctxt - pointer to raid_bdev
- * returns:
- * pointer to io channel for raid bdev
- */
-static struct spdk_io_channel *
-raid_bdev_get_io_channel(void *ctxt)
-{
-	struct raid_bdev *raid_bdev = ctxt;
+	if (start_write) {
+		spdk_thread_send_msg(spdk_thread_get_app_thread(), _raid_bdev_bitmap_write, bitmap);
+	}
 
-	return spdk_get_io_channel(raid_bdev);
+	return persisted;
 }
 
-void
-raid_bdev_write_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ctx *w)
+static void
+raid_bdev_bitmap_unmark(struct raid_bdev_io *raid_io)
 {
-	struct raid_base_bdev_info *base_info;
-
-	assert(raid_bdev != NULL);
-	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid_bdev_bitmap *bitmap = raid_io->raid_bdev->bitmap;
+	struct raid_bdev_io_channel *raid_ch = raid_io->bitmap.ch;
+	uint32_t region = raid_bdev_bitmap_region(bitmap, bdev_io->u.bdev.offset_blocks);
+	uint32_t region_last = raid_bdev_bitmap_region(bitmap, bdev_io->u.bdev.offset_blocks +
+			       bdev_io->u.bdev.num_blocks - 1);
 
-	spdk_json_write_named_uuid(w, "uuid", &raid_bdev->bdev.uuid);
-	spdk_json_write_named_uint32(w, "strip_size_kb", raid_bdev->strip_size_kb);
-	spdk_json_write_named_string(w, "state", raid_bdev_state_to_str(raid_bdev->state));
-	spdk_json_write_named_string(w, "raid_level", raid_bdev_level_to_str(raid_bdev->level));
-	spdk_json_write_named_bool(w, "superblock", raid_bdev->superblock_enabled);
-	spdk_json_write_named_uint32(w, "num_base_bdevs", raid_bdev->num_base_bdevs);
-	spdk_json_write_named_uint32(w, "num_base_bdevs_discovered", raid_bdev->num_base_bdevs_discovered);
-	spdk_json_write_named_uint32(w, "num_base_bdevs_operational",
-				     raid_bdev->num_base_bdevs_operational);
-	if (raid_bdev->process) {
-		struct raid_bdev_process *process = raid_bdev->process;
-		uint64_t offset = process->window_offset;
+	raid_io->bitmap.ch = NULL;
 
-		spdk_json_write_named_object_begin(w, "process");
-		spdk_json_write_name(w, "type");
-		spdk_json_write_string(w, raid_bdev_process_to_str(process->type));
-		spdk_json_write_named_string(w, "target", process->target->name);
-		spdk_json_write_named_object_begin(w, "progress");
-		spdk_json_write_named_uint64(w, "blocks", offset);
-		spdk_json_write_named_uint32(w, "percent", offset * 100.0 / raid_bdev->bdev.blockcnt);
-		spdk_json_write_object_end(w);
-		spdk_json_write_object_end(w);
-	}
-	spdk_json_write_name(w, "base_bdevs_list");
-	spdk_json_write_array_begin(w);
-	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
-		spdk_json_write_object_begin(w);
-		spdk_json_write_name(w, "name");
-		if (base_info->name) {
-			spdk_json_write_string(w, base_info->name);
-		} else {
-			spdk_json_write_null(w);
-		}
-		spdk_json_write_named_uuid(w, "uuid", &base_info->uuid);
-		spdk_json_write_named_bool(w, "is_configured", base_info->is_configured);
-		spdk_json_write_named_uint64(w, "data_offset", base_info->data_offset);
-		spdk_json_write_named_uint64(w, "data_size", base_info->data_size);
-		spdk_json_write_object_end(w);
+	for (; region <= region_last; region++) {
+		assert(raid_ch->bitmap.starts[region] != raid_ch->bitmap.completes[region]);
+		__atomic_store_n(&raid_ch->bitmap.completes[region],
+				 raid_ch->bitmap.completes[region] + 1, __ATOMIC_RELEASE);
 	}
-	spdk_json_write_array_end(w);
 }
 
-/*
- * brief:
- * raid_bdev_dump_info_json is the function table pointer for raid bdev
- * params:
- * ctx - pointer to raid_bdev
- * w - pointer to json context
- * returns:
- * 0 - success
- * non zero - failure
- */
 static int
-raid_bdev_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
+raid_bdev_bitmap_ch_setup(struct raid_bdev_io_channel *raid_ch, struct raid_bdev_bitmap *bitmap)
 {
-	struct raid_bdev *raid_bdev = ctx;
-
-	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_dump_config_json\n");
+	raid_ch->bitmap.starts = calloc(2 * (size_t)bitmap->num_regions,
+					sizeof(*raid_ch->bitmap.starts));
+	if (raid_ch->bitmap.starts == NULL) {
+		return -ENOMEM;
+	}
+	raid_ch->bitmap.completes = raid_ch->bitmap.starts + bitmap->num_regions;
 
-	/* Dump the raid bdev configuration related information */
-	spdk_json_write_named_object_begin(w, "raid");
-	raid_bdev_write_info_json(raid_bdev, w);
-	spdk_json_write_object_end(w);
+	spdk_spin_lock(&bitmap->lock);
+	TAILQ_INSERT_TAIL(&bitmap->channels, raid_ch, bitmap.link);
+	spdk_spin_unlock(&bitmap->lock);
 
 	return 0;
 }
 
-/*
- * brief:
- * raid_bdev_write_config_json is the function table pointer for raid bdev
- * params:
- * bdev - pointer to spdk_bdev
- * w - pointer to json context
- * returns:
- * none
- */
 static void
-raid_bdev_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+raid_bdev_bitmap_ch_cleanup(struct raid_bdev_io_channel *raid_ch, struct raid_bdev_bitmap *bitmap)
 {
-	struct raid_bdev *raid_bdev = bdev->ctxt;
-	struct raid_base_bdev_info *base_info;
-
-	assert(spdk_get_thread() == spdk_thread_get_app_thread());
-
-	if (raid_bdev->superblock_enabled) {
-		/* raid bdev configuration is stored in the superblock */
+	if (raid_ch->bitmap.starts == NULL) {
 		return;
 	}
 
-	spdk_json_write_object_begin(w);
+	/*
+	 * The writes counted by this channel disappear from the sums, which only makes the clean
+	 * poller give the regions one more period before clearing them.
+	 */
+	if (bitmap != NULL) {
+		spdk_spin_lock(&bitmap->lock);
+		TAILQ_REMOVE(&bitmap->channels, raid_ch, bitmap.link);
+		spdk_spin_unlock(&bitmap->lock);
+	}
 
-	spdk_json_write_named_string(w, "method", "bdev_raid_create");
+	free(raid_ch->bitmap.starts);
+	raid_ch->bitmap.starts = NULL;
+	raid_ch->bitmap.completes = NULL;
+}
 
-	spdk_json_write_named_object_begin(w, "params");
-	spdk_json_write_named_string(w, "name", bdev->name);
-	spdk_json_write_named_uuid(w, "uuid", &raid_bdev->bdev.uuid);
-	if (raid_bdev->strip_size_kb != 0) {
-		spdk_json_write_named_uint32(w, "strip_size_kb", raid_bdev->strip_size_kb);
+static void
+raid_bdev_bitmap_resume_io(void *ctx)
+{
+	struct raid_bdev_io *raid_io = ctx;
+
+	if (raid_io->type == SPDK_BDEV_IO_TYPE_WRITE) {
+		raid_bdev_submit_rw_request(raid_io);
+	} else {
+		raid_bdev_submit_null_payload_request(raid_io);
 	}
-	spdk_json_write_named_string(w, "raid_level", raid_bdev_level_to_str(raid_bdev->level));
+}
 
-	spdk_json_write_named_array_begin(w, "base_bdevs");
-	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
-		if (base_info->name) {
-			spdk_json_write_string(w, base_info->name);
-		} else {
-			char str[32];
+static void
+raid_bdev_bitmap_fail_io(void *ctx)
+{
+	struct raid_bdev_io *raid_io = ctx;
 
-			snprintf(str, sizeof(str), "removed_base_bdev_%u", raid_bdev_base_bdev_slot(base_info));
-			spdk_json_write_string(w, str);
-		}
-	}
-	spdk_json_write_array_end(w);
-	spdk_json_write_object_end(w);
+	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+}
 
-	spdk_json_write_object_end(w);
+static void
+raid_bdev_bitmap_stop_done(struct raid_bdev_bitmap *bitmap)
+{
+	struct raid_bdev *raid_bdev = bitmap->raid_bdev;
+	spdk_msg_fn cb = bitmap->stop_cb;
+	void *cb_ctx = bitmap->stop_cb_ctx;
+
+	raid_bdev_bitmap_free(raid_bdev);
+
+	cb(cb_ctx);
 }
 
-static int
-raid_bdev_get_memory_domains(void *ctx, struct spdk_memory_domain **domains, int array_size)
+static void
+raid_bdev_bitmap_write_done(int status, struct raid_bdev *raid_bdev, void *ctx)
 {
-	struct raid_bdev *raid_bdev = ctx;
-	struct raid_base_bdev_info *base_info;
-	int domains_count = 0, rc = 0;
+	struct raid_bdev_bitmap *bitmap = ctx;
+	struct raid_bdev_io *raid_io, *tmp;
+	TAILQ_HEAD(, raid_bdev_io) ios = TAILQ_HEAD_INITIALIZER(ios);
+	bool write_needed;
 
-	if (raid_bdev->module->memory_domains_supported == false) {
-		return 0;
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to write raid bdev '%s' write-intent bitmap: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
 	}
 
-	/* First loop to get the number of memory domains */
-	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
-		if (base_info->is_configured == false) {
-			continue;
-		}
-		rc = spdk_bdev_get_memory_domains(spdk_bdev_desc_get_bdev(base_info->desc), NULL, 0);
-		if (rc < 0) {
-			return rc;
-		}
-		domains_count += rc;
-	}
+	spdk_spin_lock(&bitmap->lock);
 
-	if (!domains || array_size < domains_count) {
-		return domains_count;
+	if (status == 0) {
+		spdk_bit_array_load_mask(bitmap->persisted, bitmap->buf);
 	}
 
-	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
-		if (base_info->is_configured == false) {
-			continue;
+	TAILQ_FOREACH_SAFE(raid_io, &bitmap->waiters, bitmap.link, tmp) {
+		if (raid_io->bitmap.gen <= bitmap->write_gen) {
+			TAILQ_REMOVE(&bitmap->waiters, raid_io, bitmap.link);
+			TAILQ_INSERT_TAIL(&ios, raid_io, bitmap.link);
 		}
-		rc = spdk_bdev_get_memory_domains(spdk_bdev_desc_get_bdev(base_info->desc), domains, array_size);
-		if (rc < 0) {
-			return rc;
-		}
-		domains += rc;
-		array_size -= rc;
 	}
 
-	return domains_count;
-}
+	write_needed = bitmap->write_needed;
+	bitmap->writing = write_needed;
 
-/* g_raid_bdev_fn_table is the function table for raid bdev */
-static const struct spdk_bdev_fn_table g_raid_bdev_fn_table = {
-	.destruct		= raid_bdev_destruct,
-	.submit_request		= raid_bdev_submit_request,
-	.io_type_supported	= raid_bdev_io_type_supported,
-	.get_io_channel		= raid_bdev_get_io_channel,
-	.dump_info_json		= raid_bdev_dump_info_json,
-	.write_config_json	= raid_bdev_write_config_json,
-	.get_memory_domains	= raid_bdev_get_memory_domains,
-};
+	spdk_spin_unlock(&bitmap->lock);
 
-struct raid_bdev *
-raid_bdev_find_by_name(const char *name)
+	TAILQ_FOREACH_SAFE(raid_io, &ios, bitmap.link, tmp) {
+		struct spdk_thread *thread;
+
+		thread = spdk_io_channel_get_thread(spdk_io_channel_from_ctx(raid_io->raid_ch));
+		spdk_thread_send_msg(thread, status == 0 ? raid_bdev_bitmap_resume_io :
+				     raid_bdev_bitmap_fail_io, raid_io);
+	}
+
+	if (write_needed) {
+		raid_bdev_bitmap_write(bitmap);
+	} else if (bitmap->stop_cb != NULL) {
+		raid_bdev_bitmap_stop_done(bitmap);
+	}
+}
+
+static void
+raid_bdev_bitmap_write(struct raid_bdev_bitmap *bitmap)
 {
-	struct raid_bdev *raid_bdev;
+	uint32_t i;
 
-	TAILQ_FOREACH(raid_bdev, &g_raid_bdev_list, global_link) {
-		if (strcmp(raid_bdev->bdev.name, name) == 0) {
-			return raid_bdev;
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(bitmap->writing);
+
+	spdk_spin_lock(&bitmap->lock);
+
+	spdk_bit_array_store_mask(bitmap->dirty, bitmap->buf);
+	bitmap->write_gen = bitmap->gen;
+	bitmap->write_needed = false;
+
+	/* Regions being cleared on disk can't be treated as persisted until the write completes */
+	for (i = spdk_bit_array_find_first_set(bitmap->persisted, 0); i != UINT32_MAX;
+	     i = spdk_bit_array_find_first_set(bitmap->persisted, i + 1)) {
+		if (!spdk_bit_array_get(bitmap->dirty, i)) {
+			spdk_bit_array_clear(bitmap->persisted, i);
 		}
 	}
 
-	return NULL;
+	spdk_spin_unlock(&bitmap->lock);
+
+	raid_bdev_write_bitmap(bitmap->raid_bdev, bitmap->buf, raid_bdev_bitmap_write_done, bitmap);
 }
 
-static struct raid_bdev *
-raid_bdev_find_by_uuid(const struct spdk_uuid *uuid)
+static void
+raid_bdev_bitmap_schedule_write(struct raid_bdev_bitmap *bitmap)
 {
-	struct raid_bdev *raid_bdev;
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
 
-	TAILQ_FOREACH(raid_bdev, &g_raid_bdev_list, global_link) {
-		if (spdk_uuid_compare(&raid_bdev->bdev.uuid, uuid) == 0) {
-			return raid_bdev;
-		}
+	spdk_spin_lock(&bitmap->lock);
+	bitmap->write_needed = true;
+	if (bitmap->writing) {
+		spdk_spin_unlock(&bitmap->lock);
+		return;
 	}
+	bitmap->writing = true;
+	spdk_spin_unlock(&bitmap->lock);
 
-	return NULL;
+	raid_bdev_bitmap_write(bitmap);
 }
 
-static struct {
-	const char *name;
-	enum raid_level value;
-} g_raid_level_names[] = {
-	{ "raid0", RAID0 },
-	{ "0", RAID0 },
-	{ "raid1", RAID1 },
-	{ "1", RAID1 },
-	{ "raid5f", RAID5F },
-	{ "5f", RAID5F },
-	{ "concat", CONCAT },
-	{ }
-};
+/*
+ * Returns the number of blocks from offset_blocks up to the end of the run of regions that are in
+ * the same state (dirty or clean) as the region containing offset_blocks.
+ */
+static uint64_t
+raid_bdev_bitmap_get_run(struct raid_bdev_bitmap *bitmap, uint64_t offset_blocks, bool *dirty)
+{
+	uint64_t blockcnt = bitmap->raid_bdev->bdev.blockcnt;
+	uint32_t region = raid_bdev_bitmap_region(bitmap, offset_blocks);
+	uint64_t offset_end;
 
-const char *g_raid_state_names[] = {
-	[RAID_BDEV_STATE_ONLINE]	= "online",
-	[RAID_BDEV_STATE_CONFIGURING]	= "configuring",
-	[RAID_BDEV_STATE_OFFLINE]	= "offline",
-	[RAID_BDEV_STATE_MAX]		= NULL
-};
+	spdk_spin_lock(&bitmap->lock);
+	*dirty = spdk_bit_array_get(bitmap->dirty, region);
+	if (*dirty) {
+		region = spdk_bit_array_find_first_clear(bitmap->dirty, region);
+	} else {
+		region = spdk_bit_array_find_first_set(bitmap->dirty, region);
+	}
+	spdk_spin_unlock(&bitmap->lock);
 
-static const char *g_raid_process_type_names[] = {
-	[RAID_PROCESS_NONE]	= "none",
-	[RAID_PROCESS_REBUILD]	= "rebuild",
-	[RAID_PROCESS_MAX]	= NULL
-};
+	if (region == UINT32_MAX) {
+		offset_end = blockcnt;
+	} else {
+		offset_end = spdk_min((uint64_t)region * bitmap->region_size, blockcnt);
+	}
 
-/* We have to use the typedef in the function declaration to appease astyle. */
-typedef enum raid_level raid_level_t;
-typedef enum raid_bdev_state raid_bdev_state_t;
+	assert(offset_end > offset_blocks);
+	return offset_end - offset_blocks;
+}
 
-raid_level_t
-raid_bdev_str_to_level(const char *str)
+static bool
+raid_bdev_base_bdevs_in_sync(struct raid_bdev *raid_bdev)
 {
-	unsigned int i;
-
-	assert(str != NULL);
+	struct raid_base_bdev_info *base_info;
 
-	for (i = 0; g_raid_level_names[i].name != NULL; i++) {
-		if (strcasecmp(g_raid_level_names[i].name, str) == 0) {
-			return g_raid_level_names[i].value;
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (!base_info->is_configured || base_info->is_process_target || base_info->is_failed ||
+		    (base_info->remove_scheduled && !raid_bdev->destroy_started)) {
+			return false;
 		}
 	}
 
-	return INVALID_RAID_LEVEL;
+	return true;
 }
 
-const char *
-raid_bdev_level_to_str(enum raid_level level)
+static int raid_bdev_start_resync(struct raid_bdev *raid_bdev);
+static int raid_bdev_start_reshape(struct raid_bdev *raid_bdev);
+
+/*
+ * Sum up the per-channel counters of a region. Returns the number of started writes and
+ * the number of writes in flight in in_flight. Must be called with the bitmap lock held.
+ */
+static uint32_t
+raid_bdev_bitmap_region_starts(struct raid_bdev_bitmap *bitmap, uint32_t region,
+			       uint32_t *in_flight)
 {
-	unsigned int i;
+	struct raid_bdev_io_channel *raid_ch;
+	uint32_t starts = 0, completes = 0;
 
-	for (i = 0; g_raid_level_names[i].name != NULL; i++) {
-		if (g_raid_level_names[i].value == level) {
-			return g_raid_level_names[i].name;
-		}
+	TAILQ_FOREACH(raid_ch, &bitmap->channels, bitmap.link) {
+		/* Load completes first, so that a write can't complete without being started */
+		completes += __atomic_load_n(&raid_ch->bitmap.completes[region], __ATOMIC_ACQUIRE);
+		starts += __atomic_load_n(&raid_ch->bitmap.starts[region], __ATOMIC_RELAXED);
 	}
 
-	return "";
+	*in_flight = starts - completes;
+
+	return starts;
 }
 
-raid_bdev_state_t
-raid_bdev_str_to_state(const char *str)
+static int
+raid_bdev_bitmap_clean_poller(void *ctx)
 {
-	unsigned int i;
+	struct raid_bdev_bitmap *bitmap = ctx;
+	struct raid_bdev *raid_bdev = bitmap->raid_bdev;
+	bool cleaned = false;
+	uint32_t i, starts, in_flight;
+	int rc;
 
-	assert(str != NULL);
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE || raid_bdev->process != NULL ||
+	    !raid_bdev_base_bdevs_in_sync(raid_bdev)) {
+		/* Dirty regions must be kept until all base bdevs are in sync */
+		return SPDK_POLLER_IDLE;
+	}
 
-	for (i = 0; i < RAID_BDEV_STATE_MAX; i++) {
-		if (strcasecmp(g_raid_state_names[i], str) == 0) {
-			break;
+	if (bitmap->needs_resync) {
+		rc = raid_bdev_start_resync(raid_bdev);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to start resync on raid bdev '%s': %s\n",
+				    raid_bdev->bdev.name, spdk_strerror(-rc));
+			return SPDK_POLLER_IDLE;
 		}
+		/* Resumed when the resync is finished */
+		spdk_poller_pause(bitmap->clean_poller);
+		return SPDK_POLLER_BUSY;
+	}
+
+	spdk_spin_lock(&bitmap->lock);
+	for (i = spdk_bit_array_find_first_set(bitmap->dirty, 0); i != UINT32_MAX;
+	     i = spdk_bit_array_find_first_set(bitmap->dirty, i + 1)) {
+		starts = raid_bdev_bitmap_region_starts(bitmap, i, &in_flight);
+		/* Give the region one more period without writes before clearing it */
+		if (in_flight != 0 || starts != bitmap->starts_seen[i]) {
+			bitmap->starts_seen[i] = starts;
+			continue;
+		}
+		spdk_bit_array_clear(bitmap->dirty, i);
+		spdk_bit_array_set(bitmap->cleared, i);
 	}
 
-	return i;
+	/*
+	 * Writes to dirty and persisted regions don't take the lock, recheck the cleared regions
+	 * for writes started concurrently. Pairs with the fence in raid_bdev_bitmap_mark().
+	 */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	for (i = spdk_bit_array_find_first_set(bitmap->cleared, 0); i != UINT32_MAX;
+	     i = spdk_bit_array_find_first_set(bitmap->cleared, i + 1)) {
+		spdk_bit_array_clear(bitmap->cleared, i);
+		starts = raid_bdev_bitmap_region_starts(bitmap, i, &in_flight);
+		if (starts != bitmap->starts_seen[i]) {
+			spdk_bit_array_set(bitmap->dirty, i);
+			bitmap->starts_seen[i] = starts;
+		} else {
+			cleaned = true;
+		}
+	}
+	spdk_spin_unlock(&bitmap->lock);
+
+	if (!cleaned) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	raid_bdev_bitmap_schedule_write(bitmap);
+
+	return SPDK_POLLER_BUSY;
 }
 
-const char *
-raid_bdev_state_to_str(enum raid_bdev_state state)
+static void
+raid_bdev_bitmap_free(struct raid_bdev *raid_bdev)
 {
-	if (state >= RAID_BDEV_STATE_MAX) {
-		return "";
+	struct raid_bdev_bitmap *bitmap = raid_bdev->bitmap;
+
+	if (bitmap == NULL) {
+		return;
 	}
 
-	return g_raid_state_names[state];
+	assert(TAILQ_EMPTY(&bitmap->waiters));
+	assert(bitmap->clean_poller == NULL);
+
+	spdk_spin_destroy(&bitmap->lock);
+	spdk_bit_array_free(&bitmap->dirty);
+	spdk_bit_array_free(&bitmap->persisted);
+	spdk_bit_array_free(&bitmap->cleared);
+	free(bitmap->starts_seen);
+	free(bitmap->buf);
+	free(bitmap);
+
+	raid_bdev->bitmap = NULL;
 }
 
-const char *
-raid_bdev_process_to_str(enum raid_process_type value)
+static int
+raid_bdev_bitmap_alloc(struct raid_bdev *raid_bdev)
 {
-	if (value >= RAID_PROCESS_MAX) {
-		return "";
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	struct raid_bdev_bitmap *bitmap;
+
+	assert(raid_bdev->bitmap == NULL);
+
+	bitmap = calloc(1, sizeof(*bitmap));
+	if (bitmap == NULL) {
+		return -ENOMEM;
 	}
 
-	return g_raid_process_type_names[value];
+	bitmap->raid_bdev = raid_bdev;
+	bitmap->region_size = sb->bitmap_region_size;
+	bitmap->num_regions = sb->bitmap_size * CHAR_BIT;
+	spdk_spin_init(&bitmap->lock);
+	TAILQ_INIT(&bitmap->waiters);
+	TAILQ_INIT(&bitmap->channels);
+	raid_bdev->bitmap = bitmap;
+
+	bitmap->dirty = spdk_bit_array_create(bitmap->num_regions);
+	bitmap->persisted = spdk_bit_array_create(bitmap->num_regions);
+	bitmap->cleared = spdk_bit_array_create(bitmap->num_regions);
+	bitmap->starts_seen = calloc(bitmap->num_regions, sizeof(*bitmap->starts_seen));
+	bitmap->buf = calloc(1, sb->bitmap_size);
+	if (bitmap->dirty == NULL || bitmap->persisted == NULL || bitmap->cleared == NULL ||
+	    bitmap->starts_seen == NULL || bitmap->buf == NULL) {
+		raid_bdev_bitmap_free(raid_bdev);
+		return -ENOMEM;
+	}
+
+	return 0;
 }
 
-/*
- * brief:
- * raid_bdev_fini_start is called when bdev layer is starting the
- * shutdown process
- * params:
- * none
- * returns:
- * none
- */
 static void
-raid_bdev_fini_start(void)
+raid_bdev_bitmap_start(struct raid_bdev *raid_bdev)
 {
-	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_fini_start\n");
-	g_shutdown_started = true;
+	struct raid_bdev_bitmap *bitmap = raid_bdev->bitmap;
+
+	bitmap->needs_resync = spdk_bit_array_count_set(bitmap->dirty) > 0;
+	if (bitmap->needs_resync) {
+		SPDK_NOTICELOG("Raid bdev '%s' has %u dirty regions to resync\n", raid_bdev->bdev.name,
+			       spdk_bit_array_count_set(bitmap->dirty));
+	}
+
+	bitmap->clean_poller = SPDK_POLLER_REGISTER(raid_bdev_bitmap_clean_poller, bitmap,
+			       RAID_BDEV_BITMAP_CLEAN_PERIOD_US);
 }
 
-/*
- * brief:
- * raid_bdev_exit is called on raid bdev module exit time by bdev layer
- * params:
- * none
- * returns:
- * none
- */
 static void
-raid_bdev_exit(void)
+raid_bdev_bitmap_stop(struct raid_bdev *raid_bdev, spdk_msg_fn cb, void *cb_ctx)
 {
-	struct raid_bdev *raid_bdev, *tmp;
+	struct raid_bdev_bitmap *bitmap = raid_bdev->bitmap;
 
-	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_exit\n");
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(raid_bdev->process == NULL);
+	assert(bitmap->stop_cb == NULL);
 
-	TAILQ_FOREACH_SAFE(raid_bdev, &g_raid_bdev_list, global_link, tmp) {
-		raid_bdev_cleanup_and_free(raid_bdev);
+	spdk_poller_unregister(&bitmap->clean_poller);
+
+	bitmap->stop_cb = cb;
+	bitmap->stop_cb_ctx = cb_ctx;
+
+	if (!bitmap->needs_resync && raid_bdev_base_bdevs_in_sync(raid_bdev)) {
+		/* There are no writes in progress, so the raid bdev is clean now */
+		spdk_spin_lock(&bitmap->lock);
+		spdk_bit_array_clear_mask(bitmap->dirty);
+		spdk_spin_unlock(&bitmap->lock);
+
+		raid_bdev_bitmap_schedule_write(bitmap);
+	} else if (!bitmap->writing) {
+		raid_bdev_bitmap_stop_done(bitmap);
 	}
 }
 
+/* Set up the write-intent bitmap geometry for a new raid bdev superblock */
 static void
-raid_bdev_opts_config_json(struct spdk_json_write_ctx *w)
+raid_bdev_bitmap_init_superblock(struct raid_bdev *raid_bdev)
 {
-	spdk_json_write_object_begin(w);
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	struct raid_base_bdev_info *base_info;
+	uint64_t region_size, num_regions, bitmap_offset, bitmap_blocks;
+	uint32_t region_align;
 
-	spdk_json_write_named_string(w, "method", "bdev_raid_set_options");
+	if (g_opts.bitmap_region_size_kb == 0 ||
+	    raid_bdev->min_base_bdevs_operational == raid_bdev->num_base_bdevs ||
+	    raid_bdev->module->submit_process_request == NULL ||
+	    RAID_BDEV_BITMAP_OFFSET_SIZE % sb->block_size != 0) {
+		return;
+	}
 
-	spdk_json_write_named_object_begin(w, "params");
-	spdk_json_write_named_uint32(w, "process_window_size_kb", g_opts.process_window_size_kb);
-	spdk_json_write_object_end(w);
+	region_size = spdk_max(g_opts.bitmap_region_size_kb * 1024UL / sb->block_size,
+			       spdk_divide_round_up(raid_bdev->bdev.blockcnt,
+						    RAID_BDEV_BITMAP_MAX_SIZE * CHAR_BIT));
 
-	spdk_json_write_object_end(w);
-}
+	/* Regions must not split the units which the raid module writes as a whole */
+	if (raid_bdev->bdev.write_unit_size > 1) {
+		region_align = raid_bdev->bdev.write_unit_size;
+	} else {
+		region_align = spdk_max(raid_bdev->strip_size, 1);
+	}
+	region_size = spdk_divide_round_up(region_size, region_align) * region_align;
 
-static int
-raid_bdev_config_json(struct spdk_json_write_ctx *w)
-{
-	raid_bdev_opts_config_json(w);
+	num_regions = spdk_divide_round_up(raid_bdev->bdev.blockcnt, region_size);
+	bitmap_offset = RAID_BDEV_BITMAP_OFFSET_SIZE / sb->block_size;
+	bitmap_blocks = spdk_divide_round_up(spdk_divide_round_up(num_regions, CHAR_BIT),
+					     sb->block_size);
 
-	return 0;
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (base_info->is_configured && base_info->data_offset < bitmap_offset + bitmap_blocks) {
+			SPDK_WARNLOG("Not enough space for write-intent bitmap on base bdev '%s'\n",
+				     base_info->name);
+			return;
+		}
+	}
+
+	sb->bitmap_size = spdk_divide_round_up(num_regions, CHAR_BIT);
+	sb->bitmap_offset = bitmap_offset;
+	sb->bitmap_region_size = region_size;
 }
 
-/*
- * brief:
- * raid_bdev_get_ctx_size is used to return the context size of bdev_io for raid
- * module
- * params:
- * none
- * returns:
- * size of spdk_bdev_io context for raid
- */
-static int
-raid_bdev_get_ctx_size(void)
+static bool
+raid_bdev_bitmap_superblock_valid(const struct raid_bdev_superblock *sb)
 {
-	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_get_ctx_size\n");
-	return sizeof(struct raid_bdev_io);
+	return sb->bitmap_region_size != 0 && sb->bitmap_offset != 0 &&
+	       sb->bitmap_size <= RAID_BDEV_BITMAP_MAX_SIZE;
 }
 
-static struct spdk_bdev_module g_raid_if = {
-	.name = "raid",
-	.module_init = raid_bdev_init,
-	.fini_start = raid_bdev_fini_start,
-	.module_fini = raid_bdev_exit,
-	.config_json = raid_bdev_config_json,
-	.get_ctx_size = raid_bdev_get_ctx_size,
-	.examine_disk = raid_bdev_examine,
-	.async_init = false,
-	.async_fini = false,
-};
-SPDK_BDEV_MODULE_REGISTER(raid, &g_raid_if)
-
 /*
  * brief:
- * raid_bdev_init is the initialization function for raid bdev module
+ * raid_bdev_submit_request function is the submit_request function pointer of
+ * raid bdev function table. This is used to submit the io on raid_bdev to below
+ * layers.
  * params:
- * none
+ * ch - pointer to raid bdev io channel
+ * bdev_io - pointer to parent bdev_io on raid bdev device
  * returns:
- * 0 - success
- * non zero - failure
+ * none
  */
-static int
-raid_bdev_init(void)
-{
-	return 0;
-}
-
-static int
-_raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
-		  enum raid_level level, bool superblock_enabled, const struct spdk_uuid *uuid,
-		  struct raid_bdev **raid_bdev_out)
+static void
+raid_bdev_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
 {
-	struct raid_bdev *raid_bdev;
-	struct spdk_bdev *raid_bdev_gen;
-	struct raid_bdev_module *module;
-	struct raid_base_bdev_info *base_info;
-	uint8_t min_operational;
-
-	if (strnlen(name, RAID_BDEV_SB_NAME_SIZE) == RAID_BDEV_SB_NAME_SIZE) {
-		SPDK_ERRLOG("Raid bdev name '%s' exceeds %d characters\n", name, RAID_BDEV_SB_NAME_SIZE - 1);
-		return -EINVAL;
-	}
+	struct raid_bdev_io *raid_io = (struct raid_bdev_io *)bdev_io->driver_ctx;
 
-	if (raid_bdev_find_by_name(name) != NULL) {
-		SPDK_ERRLOG("Duplicate raid bdev name found: %s\n", name);
-		return -EEXIST;
-	}
+	raid_bdev_io_init(raid_io, spdk_io_channel_get_ctx(ch), bdev_io->type,
+			  bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks,
+			  bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, bdev_io->u.bdev.md_buf,
+			  bdev_io->u.bdev.memory_domain, bdev_io->u.bdev.memory_domain_ctx);
 
-	if (level == RAID1) {
-		if (strip_size != 0) {
-			SPDK_ERRLOG("Strip size is not supported by raid1\n");
-			return -EINVAL;
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		spdk_bdev_io_get_buf(bdev_io, raid_bdev_get_buf_cb,
+				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		if (raid_io->raid_bdev->bitmap != NULL && !raid_bdev_bitmap_mark(raid_io)) {
+			break;
 		}
-	} else if (spdk_u32_is_pow2(strip_size) == false) {
-		SPDK_ERRLOG("Invalid strip size %" PRIu32 "\n", strip_size);
-		return -EINVAL;
-	}
-
-	module = raid_bdev_module_find(level);
-	if (module == NULL) {
-		SPDK_ERRLOG("Unsupported raid level '%d'\n", level);
-		return -EINVAL;
-	}
-
-	assert(module->base_bdevs_min != 0);
-	if (num_base_bdevs < module->base_bdevs_min) {
-		SPDK_ERRLOG("At least %u base devices required for %s\n",
-			    module->base_bdevs_min,
-			    raid_bdev_level_to_str(level));
-		return -EINVAL;
-	}
-
-	switch (module->base_bdevs_constraint.type) {
-	case CONSTRAINT_MAX_BASE_BDEVS_REMOVED:
-		min_operational = num_base_bdevs - module->base_bdevs_constraint.value;
+		raid_bdev_submit_rw_request(raid_io);
 		break;
-	case CONSTRAINT_MIN_BASE_BDEVS_OPERATIONAL:
-		min_operational = module->base_bdevs_constraint.value;
+
+	case SPDK_BDEV_IO_TYPE_RESET:
+		raid_bdev_submit_reset_request(raid_io);
 		break;
-	case CONSTRAINT_UNSET:
-		if (module->base_bdevs_constraint.value != 0) {
-			SPDK_ERRLOG("Unexpected constraint value '%u' provided for raid bdev '%s'.\n",
-				    (uint8_t)module->base_bdevs_constraint.value, name);
-			return -EINVAL;
+
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+		if (raid_io->raid_bdev->bitmap != NULL && !raid_bdev_bitmap_mark(raid_io)) {
+			break;
 		}
-		min_operational = num_base_bdevs;
+	/* fallthrough */
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+		raid_bdev_submit_null_payload_request(raid_io);
 		break;
-	default:
-		SPDK_ERRLOG("Unrecognised constraint type '%u' in module for raid level '%s'.\n",
-			    (uint8_t)module->base_bdevs_constraint.type,
-			    raid_bdev_level_to_str(module->level));
-		return -EINVAL;
-	};
 
-	if (min_operational == 0 || min_operational > num_base_bdevs) {
-		SPDK_ERRLOG("Wrong constraint value for raid level '%s'.\n",
-			    raid_bdev_level_to_str(module->level));
-		return -EINVAL;
+	default:
+		SPDK_ERRLOG("submit request, invalid io type %u\n", bdev_io->type);
+		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+		break;
 	}
+}
 
-	raid_bdev = calloc(1, sizeof(*raid_bdev));
-	if (!raid_bdev) {
-		SPDK_ERRLOG("Unable to allocate memory for raid bdev\n");
-		return -ENOMEM;
-	}
+/*
+ * brief:
+ * _raid_bdev_io_type_supported checks whether io_type is supported in
+ * all base bdev modules of raid bdev module. If anyone among the base_bdevs
+ * doesn't support, the raid device doesn't supports.
+ *
+ * params:
+ * raid_bdev - pointer to raid bdev context
+ * io_type - io type
+ * returns:
+ * true - io_type is supported
+ * false - io_type is not supported
+ */
+inline static bool
+_raid_bdev_io_type_supported(struct raid_bdev *raid_bdev, enum spdk_bdev_io_type io_type)
+{
+	struct raid_base_bdev_info *base_info;
 
-	raid_bdev->module = module;
-	raid_bdev->num_base_bdevs = num_base_bdevs;
-	raid_bdev->base_bdev_info = calloc(raid_bdev->num_base_bdevs,
-					   sizeof(struct raid_base_bdev_info));
-	if (!raid_bdev->base_bdev_info) {
-		SPDK_ERRLOG("Unable able to allocate base bdev info\n");
-		raid_bdev_free(raid_bdev);
-		return -ENOMEM;
+	if (io_type == SPDK_BDEV_IO_TYPE_FLUSH ||
+	    io_type == SPDK_BDEV_IO_TYPE_UNMAP) {
+		if (raid_bdev->module->submit_null_payload_request == NULL) {
+			return false;
+		}
 	}
 
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
-		base_info->raid_bdev = raid_bdev;
-	}
-
-	/* strip_size_kb is from the rpc param.  strip_size is in blocks and used
-	 * internally and set later.
-	 */
-	raid_bdev->strip_size = 0;
-	raid_bdev->strip_size_kb = strip_size;
-	raid_bdev->state = RAID_BDEV_STATE_CONFIGURING;
-	raid_bdev->level = level;
-	raid_bdev->min_base_bdevs_operational = min_operational;
-	raid_bdev->superblock_enabled = superblock_enabled;
-
-	raid_bdev_gen = &raid_bdev->bdev;
+		if (base_info->desc == NULL) {
+			continue;
+		}
 
-	raid_bdev_gen->name = strdup(name);
-	if (!raid_bdev_gen->name) {
-		SPDK_ERRLOG("Unable to allocate name for raid\n");
-		raid_bdev_free(raid_bdev);
-		return -ENOMEM;
+		if (spdk_bdev_io_type_supported(spdk_bdev_desc_get_bdev(base_info->desc), io_type) == false) {
+			return false;
+		}
 	}
 
-	raid_bdev_gen->product_name = "Raid Volume";
-	raid_bdev_gen->ctxt = raid_bdev;
-	raid_bdev_gen->fn_table = &g_raid_bdev_fn_table;
-	raid_bdev_gen->module = &g_raid_if;
-	raid_bdev_gen->write_cache = 0;
-	spdk_uuid_copy(&raid_bdev_gen->uuid, uuid);
-
-	TAILQ_INSERT_TAIL(&g_raid_bdev_list, raid_bdev, global_link);
-
-	*raid_bdev_out = raid_bdev;
-
-	return 0;
+	return true;
 }
 
 /*
  * brief:
- * raid_bdev_create allocates raid bdev based on passed configuration
+ * raid_bdev_io_type_supported is the io_supported function for bdev function
+ * table which returns whether the particular io type is supported or not by
+ * raid bdev module
  * params:
- * name - name for raid bdev
- * strip_size - strip size in KB
- * num_base_bdevs - number of base bdevs
- * level - raid level
- * superblock_enabled - true if raid should have superblock
- * uuid - uuid to set for the bdev
- * raid_bdev_out - the created raid bdev
+ * ctx - pointer to raid bdev context
+ * type - io type
  * returns:
- * 0 - success
- * non zero - failure
+ * true - io_type is supported
+ * false - io_type is not supported
  */
-int
-raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
-		 enum raid_level level, bool superblock_enabled, const struct spdk_uuid *uuid,
-		 struct raid_bdev **raid_bdev_out)
+static bool
+raid_bdev_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 {
-	struct raid_bdev *raid_bdev;
-	int rc;
-
-	assert(uuid != NULL);
+	switch (io_type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		return true;
 
-	rc = _raid_bdev_create(name, strip_size, num_base_bdevs, level, superblock_enabled, uuid,
-			       &raid_bdev);
-	if (rc != 0) {
-		return rc;
-	}
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+	case SPDK_BDEV_IO_TYPE_RESET:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+		return _raid_bdev_io_type_supported(ctx, io_type);
 
-	if (superblock_enabled && spdk_uuid_is_null(uuid)) {
-		/* we need to have the uuid to store in the superblock before the bdev is registered */
-		spdk_uuid_generate(&raid_bdev->bdev.uuid);
+	default:
+		return false;
 	}
 
-	raid_bdev->num_base_bdevs_operational = num_base_bdevs;
-
-	*raid_bdev_out = raid_bdev;
-
-	return 0;
+	return false;
 }
 
-static void
-_raid_bdev_unregistering_cont(void *ctx)
+/*
+ * brief:
+ * raid_bdev_get_io_channel is the get_io_channel function table pointer for
+ * raid bdev. This is used to return the io channel for this raid bdev
+ * params:
+ * ctxt - pointer to raid_bdev
+ * returns:
+ * pointer to io channel for raid bdev
+ */
+static struct spdk_io_channel *
+raid_bdev_get_io_channel(void *ctxt)
 {
-	struct raid_bdev *raid_bdev = ctx;
-
-	spdk_bdev_close(raid_bdev->self_desc);
-	raid_bdev->self_desc = NULL;
-}
+	struct raid_bdev *raid_bdev = ctxt;
 
-static void
-raid_bdev_unregistering_cont(void *ctx)
-{
-	spdk_thread_exec_msg(spdk_thread_get_app_thread(), _raid_bdev_unregistering_cont, ctx);
+	return spdk_get_io_channel(raid_bdev);
 }
 
-static int
-raid_bdev_process_add_finish_action(struct raid_bdev_process *process, spdk_msg_fn cb, void *cb_ctx)
+void
+raid_bdev_write_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ctx *w)
 {
-	struct raid_process_finish_action *finish_action;
+	struct raid_base_bdev_info *base_info;
 
-	assert(spdk_get_thread() == process->thread);
-	assert(process->state < RAID_PROCESS_STATE_STOPPED);
+	assert(raid_bdev != NULL);
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
 
-	finish_action = calloc(1, sizeof(*finish_action));
-	if (finish_action == NULL) {
-		return -ENOMEM;
+	spdk_json_write_named_uuid(w, "uuid", &raid_bdev->bdev.uuid);
+	spdk_json_write_named_uint32(w, "strip_size_kb", raid_bdev->strip_size_kb);
+	spdk_json_write_named_string(w, "state", raid_bdev_state_to_str(raid_bdev->state));
+	spdk_json_write_named_string(w, "raid_level", raid_bdev_level_to_str(raid_bdev->level));
+	spdk_json_write_named_bool(w, "superblock", raid_bdev->superblock_enabled);
+	spdk_json_write_named_uint32(w, "num_base_bdevs", raid_bdev->num_base_bdevs);
+	spdk_json_write_named_uint32(w, "num_base_bdevs_discovered", raid_bdev->num_base_bdevs_discovered);
+	spdk_json_write_named_uint32(w, "num_base_bdevs_operational",
+				     raid_bdev->num_base_bdevs_operational);
+	if (raid_bdev->module->read_policy_supported) {
+		spdk_json_write_named_string(w, "read_policy",
+					     raid_bdev_read_policy_to_str(raid_bdev->read_policy));
+		spdk_json_write_named_uint32(w, "read_hedge_percentile", raid_bdev->read_hedge_percentile);
 	}
+	if (raid_bdev->process) {
+		struct raid_bdev_process *process = raid_bdev->process;
+		uint64_t offset = process->window_offset;
 
-	finish_action->cb = cb;
-	finish_action->cb_ctx = cb_ctx;
-
-	TAILQ_INSERT_TAIL(&process->finish_actions, finish_action, link);
-
-	return 0;
-}
-
-static void
-raid_bdev_unregistering_stop_process(void *ctx)
-{
-	struct raid_bdev_process *process = ctx;
-	struct raid_bdev *raid_bdev = process->raid_bdev;
-	int rc;
-
-	process->state = RAID_PROCESS_STATE_STOPPING;
-	if (process->status == 0) {
-		process->status = -ECANCELED;
+		spdk_json_write_named_object_begin(w, "process");
+		spdk_json_write_name(w, "type");
+		spdk_json_write_string(w, raid_bdev_process_to_str(process->type));
+		if (process->target != NULL) {
+			spdk_json_write_named_string(w, "target", process->target->name);
+		}
+		spdk_json_write_named_object_begin(w, "progress");
+		spdk_json_write_named_uint64(w, "blocks", offset);
+		spdk_json_write_named_uint32(w, "percent", offset * 100.0 / raid_bdev->bdev.blockcnt);
+		spdk_json_write_object_end(w);
+		spdk_json_write_object_end(w);
 	}
-
-	rc = raid_bdev_process_add_finish_action(process, raid_bdev_unregistering_cont, raid_bdev);
-	if (rc != 0) {
-		SPDK_ERRLOG("Failed to add raid bdev '%s' process finish action: %s\n",
-			    raid_bdev->bdev.name, spdk_strerror(-rc));
+	if (raid_bdev->reshape.num_base_bdevs_old != 0) {
+		spdk_json_write_named_object_begin(w, "reshape");
+		spdk_json_write_named_uint32(w, "num_base_bdevs_old",
+				     raid_bdev->reshape.num_base_bdevs_old);
+		spdk_json_write_named_uint64(w, "offset_blocks", raid_bdev->reshape.offset);
+		spdk_json_write_object_end(w);
 	}
-}
+	if (raid_bdev->scrub.started) {
+		const char *state;
 
-static void
-raid_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev, void *event_ctx)
-{
-	struct raid_bdev *raid_bdev = event_ctx;
-
-	if (type == SPDK_BDEV_EVENT_REMOVE) {
-		if (raid_bdev->process != NULL) {
-			spdk_thread_send_msg(raid_bdev->process->thread, raid_bdev_unregistering_stop_process,
-					     raid_bdev->process);
+		if (raid_bdev->scrub.running) {
+			state = "running";
+		} else if (raid_bdev->scrub.status == 0) {
+			state = "completed";
+		} else if (raid_bdev->scrub.status == -ECANCELED) {
+			state = "stopped";
 		} else {
-			raid_bdev_unregistering_cont(raid_bdev);
+			state = "failed";
 		}
-	}
-}
-
-static void
-raid_bdev_configure_cont(struct raid_bdev *raid_bdev)
-{
-	struct spdk_bdev *raid_bdev_gen = &raid_bdev->bdev;
-	int rc;
 
-	raid_bdev->state = RAID_BDEV_STATE_ONLINE;
-	SPDK_DEBUGLOG(bdev_raid, "io device register %p\n", raid_bdev);
-	SPDK_DEBUGLOG(bdev_raid, "blockcnt %" PRIu64 ", blocklen %u\n",
-		      raid_bdev_gen->blockcnt, raid_bdev_gen->blocklen);
-	spdk_io_device_register(raid_bdev, raid_bdev_create_cb, raid_bdev_destroy_cb,
-				sizeof(struct raid_bdev_io_channel),
-				raid_bdev_gen->name);
-	rc = spdk_bdev_register(raid_bdev_gen);
-	if (rc != 0) {
-		SPDK_ERRLOG("Failed to register raid bdev '%s': %s\n",
-			    raid_bdev_gen->name, spdk_strerror(-rc));
-		goto err;
+		spdk_json_write_named_object_begin(w, "scrub");
+		spdk_json_write_named_string(w, "state", state);
+		spdk_json_write_named_bool(w, "repair", raid_bdev->scrub.repair);
+		spdk_json_write_named_uint64(w, "mismatched_blocks", raid_bdev->scrub.mismatched_blocks);
+		spdk_json_write_named_uint64(w, "read_error_blocks", raid_bdev->scrub.read_error_blocks);
+		spdk_json_write_named_uint64(w, "repaired_blocks", raid_bdev->scrub.repaired_blocks);
+		spdk_json_write_object_end(w);
 	}
+	if (raid_bdev->bitmap) {
+		struct raid_bdev_bitmap *bitmap = raid_bdev->bitmap;
+		uint32_t dirty_regions;
 
-	/*
-	 * Open the bdev internally to delay unregistering if we need to stop a background process
-	 * first. The process may still need to unquiesce a range but it will fail because the
-	 * bdev's internal.spinlock is destroyed by the time the destruct callback is reached.
-	 * During application shutdown, bdevs automatically get unregistered by the bdev layer
-	 * so this is the only way currently to do this correctly.
-	 * TODO: try to handle this correctly in bdev layer instead.
-	 */
-	rc = spdk_bdev_open_ext(raid_bdev_gen->name, false, raid_bdev_event_cb, raid_bdev,
-				&raid_bdev->self_desc);
-	if (rc != 0) {
-		SPDK_ERRLOG("Failed to open raid bdev '%s': %s\n",
-			    raid_bdev_gen->name, spdk_strerror(-rc));
-		spdk_bdev_unregister(raid_bdev_gen, NULL, NULL);
-		goto err;
-	}
+		spdk_spin_lock(&bitmap->lock);
+		dirty_regions = spdk_bit_array_count_set(bitmap->dirty);
+		spdk_spin_unlock(&bitmap->lock);
 
-	SPDK_DEBUGLOG(bdev_raid, "raid bdev generic %p\n", raid_bdev_gen);
-	SPDK_DEBUGLOG(bdev_raid, "raid bdev is created with name %s, raid_bdev %p\n",
-		      raid_bdev_gen->name, raid_bdev);
-	return;
-err:
-	if (raid_bdev->module->stop != NULL) {
-		raid_bdev->module->stop(raid_bdev);
+		spdk_json_write_named_object_begin(w, "write_intent_bitmap");
+		spdk_json_write_named_uint64(w, "region_size_kb",
+					     bitmap->region_size * raid_bdev->sb->block_size / 1024);
+		spdk_json_write_named_uint32(w, "num_regions", bitmap->num_regions);
+		spdk_json_write_named_uint32(w, "dirty_regions", dirty_regions);
+		spdk_json_write_object_end(w);
 	}
-	spdk_io_device_unregister(raid_bdev, NULL);
-	raid_bdev->state = RAID_BDEV_STATE_CONFIGURING;
-}
-
-static void
-raid_bdev_configure_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
-{
-	if (status == 0) {
-		raid_bdev_configure_cont(raid_bdev);
-	} else {
-		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock: %s\n",
-			    raid_bdev->bdev.name, spdk_strerror(-status));
-		if (raid_bdev->module->stop != NULL) {
-			raid_bdev->module->stop(raid_bdev);
+	if (raid_bdev->module->dump_info_json && raid_bdev->state == RAID_BDEV_STATE_ONLINE) {
+		raid_bdev->module->dump_info_json(raid_bdev, w);
+	}
+	spdk_json_write_name(w, "base_bdevs_list");
+	spdk_json_write_array_begin(w);
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_name(w, "name");
+		if (base_info->name) {
+			spdk_json_write_string(w, base_info->name);
+		} else {
+			spdk_json_write_null(w);
 		}
+		spdk_json_write_named_uuid(w, "uuid", &base_info->uuid);
+		spdk_json_write_named_bool(w, "is_configured", base_info->is_configured);
+		spdk_json_write_named_uint64(w, "data_offset", base_info->data_offset);
+		spdk_json_write_named_uint64(w, "data_size", base_info->data_size);
+		spdk_json_write_object_end(w);
 	}
+	spdk_json_write_array_end(w);
 }
 
 /*
  * brief:
- * If raid bdev config is complete, then only register the raid bdev to
- * bdev layer and remove this raid bdev from configuring list and
- * insert the raid bdev to configured list
+ * raid_bdev_dump_info_json is the function table pointer for raid bdev
  * params:
- * raid_bdev - pointer to raid bdev
+ * ctx - pointer to raid_bdev
+ * w - pointer to json context
  * returns:
  * 0 - success
  * non zero - failure
  */
 static int
-raid_bdev_configure(struct raid_bdev *raid_bdev)
+raid_bdev_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
 {
-	uint32_t data_block_size = spdk_bdev_get_data_block_size(&raid_bdev->bdev);
-	int rc;
+	struct raid_bdev *raid_bdev = ctx;
 
-	assert(raid_bdev->state == RAID_BDEV_STATE_CONFIGURING);
-	assert(raid_bdev->num_base_bdevs_discovered == raid_bdev->num_base_bdevs_operational);
-	assert(raid_bdev->bdev.blocklen > 0);
+	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_dump_config_json\n");
 
-	/* The strip_size_kb is read in from user in KB. Convert to blocks here for
-	 * internal use.
-	 */
-	raid_bdev->strip_size = (raid_bdev->strip_size_kb * 1024) / data_block_size;
-	if (raid_bdev->strip_size == 0 && raid_bdev->level != RAID1) {
-		SPDK_ERRLOG("Strip size cannot be smaller than the device block size\n");
-		return -EINVAL;
-	}
-	raid_bdev->strip_size_shift = spdk_u32log2(raid_bdev->strip_size);
+	/* Dump the raid bdev configuration related information */
+	spdk_json_write_named_object_begin(w, "raid");
+	raid_bdev_write_info_json(raid_bdev, w);
+	spdk_json_write_object_end(w);
 
-	rc = raid_bdev->module->start(raid_bdev);
-	if (rc != 0) {
-		SPDK_ERRLOG("raid module startup callback failed\n");
-		return rc;
-	}
-
-	if (raid_bdev->superblock_enabled) {
-		if (raid_bdev->sb == NULL) {
-			rc = raid_bdev_alloc_superblock(raid_bdev, data_block_size);
-			if (rc == 0) {
-				raid_bdev_init_superblock(raid_bdev);
-			}
-		} else {
-			assert(spdk_uuid_compare(&raid_bdev->sb->uuid, &raid_bdev->bdev.uuid) == 0);
-			if (raid_bdev->sb->block_size != data_block_size) {
-				SPDK_ERRLOG("blocklen does not match value in superblock\n");
-				rc = -EINVAL;
-			}
-			if (raid_bdev->sb->raid_size != raid_bdev->bdev.blockcnt) {
-				SPDK_ERRLOG("blockcnt does not match value in superblock\n");
-				rc = -EINVAL;
-			}
-		}
-
-		if (rc != 0) {
-			if (raid_bdev->module->stop != NULL) {
-				raid_bdev->module->stop(raid_bdev);
-			}
-			return rc;
-		}
-
-		raid_bdev_write_superblock(raid_bdev, raid_bdev_configure_write_sb_cb, NULL);
-	} else {
-		raid_bdev_configure_cont(raid_bdev);
-	}
-
-	return 0;
-}
+	return 0;
+}
 
 /*
  * brief:
- * If raid bdev is online and registered, change the bdev state to
- * configuring and unregister this raid device. Queue this raid device
- * in configuring list
+ * raid_bdev_write_config_json is the function table pointer for raid bdev
  * params:
- * raid_bdev - pointer to raid bdev
- * cb_fn - callback function
- * cb_arg - argument to callback function
+ * bdev - pointer to spdk_bdev
+ * w - pointer to json context
  * returns:
  * none
  */
 static void
-raid_bdev_deconfigure(struct raid_bdev *raid_bdev, raid_bdev_destruct_cb cb_fn,
-		      void *cb_arg)
+raid_bdev_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
 {
-	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
-		if (cb_fn) {
-			cb_fn(cb_arg, 0);
-		}
+	struct raid_bdev *raid_bdev = bdev->ctxt;
+	struct raid_base_bdev_info *base_info;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	if (raid_bdev->superblock_enabled) {
+		/* raid bdev configuration is stored in the superblock */
 		return;
 	}
 
-	raid_bdev->state = RAID_BDEV_STATE_OFFLINE;
-	SPDK_DEBUGLOG(bdev_raid, "raid bdev state changing from online to offline\n");
+	spdk_json_write_object_begin(w);
 
-	spdk_bdev_unregister(&raid_bdev->bdev, cb_fn, cb_arg);
-}
+	spdk_json_write_named_string(w, "method", "bdev_raid_create");
 
-/*
- * brief:
- * raid_bdev_find_base_info_by_bdev function finds the base bdev info by bdev.
- * params:
- * base_bdev - pointer to base bdev
- * returns:
- * base bdev info if found, otherwise NULL.
- */
-static struct raid_base_bdev_info *
-raid_bdev_find_base_info_by_bdev(struct spdk_bdev *base_bdev)
-{
-	struct raid_bdev *raid_bdev;
-	struct raid_base_bdev_info *base_info;
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "name", bdev->name);
+	spdk_json_write_named_uuid(w, "uuid", &raid_bdev->bdev.uuid);
+	if (raid_bdev->strip_size_kb != 0) {
+		spdk_json_write_named_uint32(w, "strip_size_kb", raid_bdev->strip_size_kb);
+	}
+	spdk_json_write_named_string(w, "raid_level", raid_bdev_level_to_str(raid_bdev->level));
 
-	TAILQ_FOREACH(raid_bdev, &g_raid_bdev_list, global_link) {
-		RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
-			if (base_info->desc != NULL &&
-			    spdk_bdev_desc_get_bdev(base_info->desc) == base_bdev) {
-				return base_info;
-			}
+	spdk_json_write_named_array_begin(w, "base_bdevs");
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (base_info->name) {
+			spdk_json_write_string(w, base_info->name);
+		} else {
+			char str[32];
+
+			snprintf(str, sizeof(str), "removed_base_bdev_%u", raid_bdev_base_bdev_slot(base_info));
+			spdk_json_write_string(w, str);
 		}
 	}
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
 
-	return NULL;
+	spdk_json_write_object_end(w);
+
+	if (raid_bdev->read_policy != RAID_READ_POLICY_LEAST_OUTSTANDING ||
+	    raid_bdev->read_hedge_percentile != 0) {
+		spdk_json_write_object_begin(w);
+
+		spdk_json_write_named_string(w, "method", "bdev_raid_set_read_policy");
+
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "name", bdev->name);
+		spdk_json_write_named_string(w, "read_policy",
+					     raid_bdev_read_policy_to_str(raid_bdev->read_policy));
+		spdk_json_write_named_uint32(w, "hedge_percentile", raid_bdev->read_hedge_percentile);
+		spdk_json_write_object_end(w);
+
+		spdk_json_write_object_end(w);
+	}
 }
 
-static void
-raid_bdev_remove_base_bdev_done(struct raid_base_bdev_info *base_info, int status)
+static int
+raid_bdev_get_memory_domains(void *ctx, struct spdk_memory_domain **domains, int array_size)
 {
-	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+	struct raid_bdev *raid_bdev = ctx;
+	struct raid_base_bdev_info *base_info;
+	int domains_count = 0, rc = 0;
 
-	assert(base_info->remove_scheduled);
-	base_info->remove_scheduled = false;
+	if (raid_bdev->module->memory_domains_supported == false) {
+		return 0;
+	}
 
-	if (status == 0) {
-		raid_bdev->num_base_bdevs_operational--;
-		if (raid_bdev->num_base_bdevs_operational < raid_bdev->min_base_bdevs_operational) {
-			/* There is not enough base bdevs to keep the raid bdev operational. */
-			raid_bdev_deconfigure(raid_bdev, base_info->remove_cb, base_info->remove_cb_ctx);
-			return;
+	/* First loop to get the number of memory domains */
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (base_info->is_configured == false) {
+			continue;
+		}
+		rc = spdk_bdev_get_memory_domains(spdk_bdev_desc_get_bdev(base_info->desc), NULL, 0);
+		if (rc < 0) {
+			return rc;
 		}
+		domains_count += rc;
 	}
 
-	if (base_info->remove_cb != NULL) {
-		base_info->remove_cb(base_info->remove_cb_ctx, status);
+	if (!domains || array_size < domains_count) {
+		return domains_count;
+	}
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (base_info->is_configured == false) {
+			continue;
+		}
+		rc = spdk_bdev_get_memory_domains(spdk_bdev_desc_get_bdev(base_info->desc), domains, array_size);
+		if (rc < 0) {
+			return rc;
+		}
+		domains += rc;
+		array_size -= rc;
 	}
+
+	return domains_count;
 }
 
-static void
-raid_bdev_remove_base_bdev_on_unquiesced(void *ctx, int status)
+/* g_raid_bdev_fn_table is the function table for raid bdev */
+static const struct spdk_bdev_fn_table g_raid_bdev_fn_table = {
+	.destruct		= raid_bdev_destruct,
+	.submit_request		= raid_bdev_submit_request,
+	.io_type_supported	= raid_bdev_io_type_supported,
+	.get_io_channel		= raid_bdev_get_io_channel,
+	.dump_info_json		= raid_bdev_dump_info_json,
+	.write_config_json	= raid_bdev_write_config_json,
+	.get_memory_domains	= raid_bdev_get_memory_domains,
+};
+
+struct raid_bdev *
+raid_bdev_find_by_name(const char *name)
 {
-	struct raid_base_bdev_info *base_info = ctx;
-	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+	struct raid_bdev *raid_bdev;
 
-	if (status != 0) {
-		SPDK_ERRLOG("Failed to unquiesce raid bdev %s: %s\n",
-			    raid_bdev->bdev.name, spdk_strerror(-status));
+	TAILQ_FOREACH(raid_bdev, &g_raid_bdev_list, global_link) {
+		if (strcmp(raid_bdev->bdev.name, name) == 0) {
+			return raid_bdev;
+		}
 	}
 
-	raid_bdev_remove_base_bdev_done(base_info, status);
+	return NULL;
 }
 
-static void
-raid_bdev_channel_remove_base_bdev(struct spdk_io_channel_iter *i)
+static struct raid_bdev *
+raid_bdev_find_by_uuid(const struct spdk_uuid *uuid)
 {
-	struct raid_base_bdev_info *base_info = spdk_io_channel_iter_get_ctx(i);
-	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
-	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
-	uint8_t idx = raid_bdev_base_bdev_slot(base_info);
-
-	SPDK_DEBUGLOG(bdev_raid, "slot: %u raid_ch: %p\n", idx, raid_ch);
-
-	if (raid_ch->base_channel[idx] != NULL) {
-		spdk_put_io_channel(raid_ch->base_channel[idx]);
-		raid_ch->base_channel[idx] = NULL;
-	}
+	struct raid_bdev *raid_bdev;
 
-	if (raid_ch->process.ch_processed != NULL) {
-		raid_ch->process.ch_processed->base_channel[idx] = NULL;
+	TAILQ_FOREACH(raid_bdev, &g_raid_bdev_list, global_link) {
+		if (spdk_uuid_compare(&raid_bdev->bdev.uuid, uuid) == 0) {
+			return raid_bdev;
+		}
 	}
 
-	spdk_for_each_channel_continue(i, 0);
+	return NULL;
 }
 
-static void
-raid_bdev_channels_remove_base_bdev_done(struct spdk_io_channel_iter *i, int status)
-{
-	struct raid_base_bdev_info *base_info = spdk_io_channel_iter_get_ctx(i);
-	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+static struct {
+	const char *name;
+	enum raid_level value;
+} g_raid_level_names[] = {
+	{ "raid0", RAID0 },
+	{ "0", RAID0 },
+	{ "raid1", RAID1 },
+	{ "1", RAID1 },
+	{ "raid10", RAID10 },
+	{ "10", RAID10 },
+	{ "raid5f", RAID5F },
+	{ "5f", RAID5F },
+	{ "raid6f", RAID6F },
+	{ "6f", RAID6F },
+	{ "concat", CONCAT },
+	{ }
+};
 
-	raid_bdev_free_base_bdev_resource(base_info);
+const char *g_raid_state_names[] = {
+	[RAID_BDEV_STATE_ONLINE]	= "online",
+	[RAID_BDEV_STATE_CONFIGURING]	= "configuring",
+	[RAID_BDEV_STATE_OFFLINE]	= "offline",
+	[RAID_BDEV_STATE_MAX]		= NULL
+};
 
-	spdk_bdev_unquiesce(&raid_bdev->bdev, &g_raid_if, raid_bdev_remove_base_bdev_on_unquiesced,
-			    base_info);
-}
+static const char *g_raid_process_type_names[] = {
+	[RAID_PROCESS_NONE]	= "none",
+	[RAID_PROCESS_REBUILD]	= "rebuild",
+	[RAID_PROCESS_RESYNC]	= "resync",
+	[RAID_PROCESS_RESHAPE]	= "reshape",
+	[RAID_PROCESS_SCRUB]	= "scrub",
+	[RAID_PROCESS_MAX]	= NULL
+};
 
-static void
-raid_bdev_remove_base_bdev_cont(struct raid_base_bdev_info *base_info)
-{
-	raid_bdev_deconfigure_base_bdev(base_info);
+static const char *g_raid_read_policy_names[] = {
+	[RAID_READ_POLICY_LEAST_OUTSTANDING]	= "least_outstanding",
+	[RAID_READ_POLICY_LATENCY]		= "latency",
+	[RAID_READ_POLICY_SEQUENTIAL]		= "sequential",
+	[RAID_READ_POLICY_MAX]			= NULL
+};
 
-	spdk_for_each_channel(base_info->raid_bdev, raid_bdev_channel_remove_base_bdev, base_info,
-			      raid_bdev_channels_remove_base_bdev_done);
-}
+/* We have to use the typedef in the function declaration to appease astyle. */
+typedef enum raid_level raid_level_t;
+typedef enum raid_bdev_state raid_bdev_state_t;
+typedef enum raid_read_policy raid_read_policy_t;
 
-static void
-raid_bdev_remove_base_bdev_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+raid_level_t
+raid_bdev_str_to_level(const char *str)
 {
-	struct raid_base_bdev_info *base_info = ctx;
+	unsigned int i;
 
-	if (status != 0) {
-		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock: %s\n",
-			    raid_bdev->bdev.name, spdk_strerror(-status));
-		raid_bdev_remove_base_bdev_done(base_info, status);
-		return;
+	assert(str != NULL);
+
+	for (i = 0; g_raid_level_names[i].name != NULL; i++) {
+		if (strcasecmp(g_raid_level_names[i].name, str) == 0) {
+			return g_raid_level_names[i].value;
+		}
 	}
 
-	raid_bdev_remove_base_bdev_cont(base_info);
+	return INVALID_RAID_LEVEL;
 }
 
-static void
-raid_bdev_remove_base_bdev_on_quiesced(void *ctx, int status)
+const char *
+raid_bdev_level_to_str(enum raid_level level)
 {
-	struct raid_base_bdev_info *base_info = ctx;
-	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+	unsigned int i;
 
-	if (status != 0) {
-		SPDK_ERRLOG("Failed to quiesce raid bdev %s: %s\n",
-			    raid_bdev->bdev.name, spdk_strerror(-status));
-		raid_bdev_remove_base_bdev_done(base_info, status);
-		return;
+	for (i = 0; g_raid_level_names[i].name != NULL; i++) {
+		if (g_raid_level_names[i].value == level) {
+			return g_raid_level_names[i].name;
+		}
 	}
 
-	if (raid_bdev->sb) {
-		struct raid_bdev_superblock *sb = raid_bdev->sb;
-		uint8_t slot = raid_bdev_base_bdev_slot(base_info);
-		uint8_t i;
+	return "";
+}
 
-		for (i = 0; i < sb->base_bdevs_size; i++) {
-			struct raid_bdev_sb_base_bdev *sb_base_bdev = &sb->base_bdevs[i];
+raid_bdev_state_t
+raid_bdev_str_to_state(const char *str)
+{
+	unsigned int i;
 
-			if (sb_base_bdev->state == RAID_SB_BASE_BDEV_CONFIGURED &&
-			    sb_base_bdev->slot == slot) {
-				if (base_info->is_failed) {
-					sb_base_bdev->state = RAID_SB_BASE_BDEV_FAILED;
-				} else {
-					sb_base_bdev->state = RAID_SB_BASE_BDEV_MISSING;
-				}
+	assert(str != NULL);
 
-				raid_bdev_write_superblock(raid_bdev, raid_bdev_remove_base_bdev_write_sb_cb, base_info);
-				return;
-			}
+	for (i = 0; i < RAID_BDEV_STATE_MAX; i++) {
+		if (strcasecmp(g_raid_state_names[i], str) == 0) {
+			break;
 		}
 	}
 
-	raid_bdev_remove_base_bdev_cont(base_info);
+	return i;
 }
 
-static int
-raid_bdev_remove_base_bdev_quiesce(struct raid_base_bdev_info *base_info)
+const char *
+raid_bdev_state_to_str(enum raid_bdev_state state)
 {
-	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	if (state >= RAID_BDEV_STATE_MAX) {
+		return "";
+	}
 
-	return spdk_bdev_quiesce(&base_info->raid_bdev->bdev, &g_raid_if,
-				 raid_bdev_remove_base_bdev_on_quiesced, base_info);
+	return g_raid_state_names[state];
 }
 
-struct raid_bdev_process_base_bdev_remove_ctx {
-	struct raid_bdev_process *process;
-	struct raid_base_bdev_info *base_info;
-	uint8_t num_base_bdevs_operational;
-};
-
-static void
-_raid_bdev_process_base_bdev_remove_cont(void *ctx)
+const char *
+raid_bdev_process_to_str(enum raid_process_type value)
 {
-	struct raid_base_bdev_info *base_info = ctx;
-	int ret;
-
-	ret = raid_bdev_remove_base_bdev_quiesce(base_info);
-	if (ret != 0) {
-		raid_bdev_remove_base_bdev_done(base_info, ret);
+	if (value >= RAID_PROCESS_MAX) {
+		return "";
 	}
-}
-
-static void
-raid_bdev_process_base_bdev_remove_cont(void *_ctx)
-{
-	struct raid_bdev_process_base_bdev_remove_ctx *ctx = _ctx;
-	struct raid_base_bdev_info *base_info = ctx->base_info;
-
-	free(ctx);
 
-	spdk_thread_send_msg(spdk_thread_get_app_thread(), _raid_bdev_process_base_bdev_remove_cont,
-			     base_info);
+	return g_raid_process_type_names[value];
 }
 
-static void
-_raid_bdev_process_base_bdev_remove(void *_ctx)
+raid_read_policy_t
+raid_bdev_str_to_read_policy(const char *str)
 {
-	struct raid_bdev_process_base_bdev_remove_ctx *ctx = _ctx;
-	struct raid_bdev_process *process = ctx->process;
-	int ret;
-
-	if (ctx->base_info != process->target &&
-	    ctx->num_base_bdevs_operational > process->raid_bdev->min_base_bdevs_operational) {
-		/* process doesn't need to be stopped */
-		raid_bdev_process_base_bdev_remove_cont(ctx);
-		return;
-	}
+	unsigned int i;
 
-	assert(process->state > RAID_PROCESS_STATE_INIT &&
-	       process->state < RAID_PROCESS_STATE_STOPPED);
+	assert(str != NULL);
 
-	ret = raid_bdev_process_add_finish_action(process, raid_bdev_process_base_bdev_remove_cont, ctx);
-	if (ret != 0) {
-		raid_bdev_remove_base_bdev_done(ctx->base_info, ret);
-		free(ctx);
-		return;
+	for (i = 0; i < RAID_READ_POLICY_MAX; i++) {
+		if (strcasecmp(g_raid_read_policy_names[i], str) == 0) {
+			break;
+		}
 	}
 
-	process->state = RAID_PROCESS_STATE_STOPPING;
-
-	if (process->status == 0) {
-		process->status = -ENODEV;
-	}
+	return i;
 }
 
-static int
-raid_bdev_process_base_bdev_remove(struct raid_bdev_process *process,
-				   struct raid_base_bdev_info *base_info)
+const char *
+raid_bdev_read_policy_to_str(enum raid_read_policy policy)
 {
-	struct raid_bdev_process_base_bdev_remove_ctx *ctx;
-
-	assert(spdk_get_thread() == spdk_thread_get_app_thread());
-
-	ctx = calloc(1, sizeof(*ctx));
-	if (ctx == NULL) {
-		return -ENOMEM;
-	}
-
-	/*
-	 * We have to send the process and num_base_bdevs_operational in the message ctx
-	 * because the process thread should not access raid_bdev's properties. Particularly,
-	 * raid_bdev->process may be cleared by the time the message is handled, but ctx->process
-	 * will still be valid until the process is fully stopped.
-	 */
-	ctx->base_info = base_info;
-	ctx->process = process;
-	/*
-	 * raid_bdev->num_base_bdevs_operational can't be used here because it is decremented
-	 * after the removal and more than one base bdev may be removed at the same time
-	 */
-	RAID_FOR_EACH_BASE_BDEV(process->raid_bdev, base_info) {
-		if (base_info->is_configured && !base_info->remove_scheduled) {
-			ctx->num_base_bdevs_operational++;
-		}
+	if (policy >= RAID_READ_POLICY_MAX) {
+		return "";
 	}
 
-	spdk_thread_send_msg(process->thread, _raid_bdev_process_base_bdev_remove, ctx);
-
-	return 0;
+	return g_raid_read_policy_names[policy];
 }
 
-static int
-_raid_bdev_remove_base_bdev(struct raid_base_bdev_info *base_info,
-			    raid_base_bdev_cb cb_fn, void *cb_ctx)
+int
+raid_bdev_set_read_policy(struct raid_bdev *raid_bdev, enum raid_read_policy policy,
+			  uint8_t hedge_percentile)
 {
-	struct raid_bdev *raid_bdev = base_info->raid_bdev;
-	int ret = 0;
-
-	SPDK_DEBUGLOG(bdev_raid, "%s\n", base_info->name);
-
 	assert(spdk_get_thread() == spdk_thread_get_app_thread());
 
-	if (base_info->remove_scheduled || !base_info->is_configured) {
-		return -ENODEV;
+	if (!raid_bdev->module->read_policy_supported) {
+		SPDK_ERRLOG("Raid bdev '%s' with level %s does not support read policies\n",
+			    raid_bdev->bdev.name, raid_bdev_level_to_str(raid_bdev->level));
+		return -ENOTSUP;
 	}
 
-	assert(base_info->desc);
-	base_info->remove_scheduled = true;
-
-	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
-		/*
-		 * As raid bdev is not registered yet or already unregistered,
-		 * so cleanup should be done here itself.
-		 *
-		 * Removing a base bdev at this stage does not change the number of operational
-		 * base bdevs, only the number of discovered base bdevs.
-		 */
-		raid_bdev_free_base_bdev_resource(base_info);
-		base_info->remove_scheduled = false;
-		if (raid_bdev->num_base_bdevs_discovered == 0 &&
-		    raid_bdev->state == RAID_BDEV_STATE_OFFLINE) {
-			/* There is no base bdev for this raid, so free the raid device. */
-			raid_bdev_cleanup_and_free(raid_bdev);
-		}
-		if (cb_fn != NULL) {
-			cb_fn(cb_ctx, 0);
-		}
-	} else if (raid_bdev->min_base_bdevs_operational == raid_bdev->num_base_bdevs) {
-		/* This raid bdev does not tolerate removing a base bdev. */
-		raid_bdev->num_base_bdevs_operational--;
-		raid_bdev_deconfigure(raid_bdev, cb_fn, cb_ctx);
-	} else {
-		base_info->remove_cb = cb_fn;
-		base_info->remove_cb_ctx = cb_ctx;
-
-		if (raid_bdev->process != NULL) {
-			ret = raid_bdev_process_base_bdev_remove(raid_bdev->process, base_info);
-		} else {
-			ret = raid_bdev_remove_base_bdev_quiesce(base_info);
-		}
-
-		if (ret != 0) {
-			base_info->remove_scheduled = false;
-		}
+	if (policy >= RAID_READ_POLICY_MAX || hedge_percentile >= 100) {
+		return -EINVAL;
 	}
 
-	return ret;
+	/* The I/O threads pick up the new values with the next read they submit */
+	raid_bdev->read_policy = policy;
+	raid_bdev->read_hedge_percentile = hedge_percentile;
+
+	return 0;
 }
 
 /*
  * brief:
- * raid_bdev_remove_base_bdev function is called by below layers when base_bdev
- * is removed. This function checks if this base bdev is part of any raid bdev
- * or not. If yes, it takes necessary action on that particular raid bdev.
+ * raid_bdev_fini_start is called when bdev layer is starting the
+ * shutdown process
  * params:
- * base_bdev - pointer to base bdev which got removed
- * cb_fn - callback function
- * cb_arg - argument to callback function
+ * none
  * returns:
- * 0 - success
- * non zero - failure
+ * none
  */
-int
-raid_bdev_remove_base_bdev(struct spdk_bdev *base_bdev, raid_base_bdev_cb cb_fn, void *cb_ctx)
+static void
+raid_bdev_fini_start(void)
 {
-	struct raid_base_bdev_info *base_info;
-
-	/* Find the raid_bdev which has claimed this base_bdev */
-	base_info = raid_bdev_find_base_info_by_bdev(base_bdev);
-	if (!base_info) {
-		SPDK_ERRLOG("bdev to remove '%s' not found\n", base_bdev->name);
-		return -ENODEV;
-	}
-
-	return _raid_bdev_remove_base_bdev(base_info, cb_fn, cb_ctx);
+	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_fini_start\n");
+	g_shutdown_started = true;
 }
 
+/*
+ * brief:
+ * raid_bdev_exit is called on raid bdev module exit time by bdev layer
+ * params:
+ * none
+ * returns:
+ * none
+ */
 static void
-raid_bdev_fail_base_remove_cb(void *ctx, int status)
+raid_bdev_exit(void)
 {
-	struct raid_base_bdev_info *base_info = ctx;
+	struct raid_bdev *raid_bdev, *tmp;
 
-	if (status != 0) {
-		SPDK_WARNLOG("Failed to remove base bdev %s\n", base_info->name);
-		base_info->is_failed = false;
+	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_exit\n");
+
+	TAILQ_FOREACH_SAFE(raid_bdev, &g_raid_bdev_list, global_link, tmp) {
+		raid_bdev_cleanup_and_free(raid_bdev);
 	}
 }
 
 static void
-_raid_bdev_fail_base_bdev(void *ctx)
+raid_bdev_opts_config_json(struct spdk_json_write_ctx *w)
 {
-	struct raid_base_bdev_info *base_info = ctx;
-	int rc;
+	spdk_json_write_object_begin(w);
 
-	if (base_info->is_failed) {
-		return;
-	}
-	base_info->is_failed = true;
+	spdk_json_write_named_string(w, "method", "bdev_raid_set_options");
 
-	SPDK_NOTICELOG("Failing base bdev in slot %d ('%s') of raid bdev '%s'\n",
-		       raid_bdev_base_bdev_slot(base_info), base_info->name, base_info->raid_bdev->bdev.name);
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_uint32(w, "process_window_size_kb", g_opts.process_window_size_kb);
+	spdk_json_write_named_uint32(w, "bitmap_region_size_kb", g_opts.bitmap_region_size_kb);
+	spdk_json_write_named_uint32(w, "process_max_mbytes_per_sec",
+				     g_opts.process_max_mbytes_per_sec);
+	spdk_json_write_named_uint32(w, "process_max_ios_per_sec", g_opts.process_max_ios_per_sec);
+	spdk_json_write_named_bool(w, "process_adaptive", g_opts.process_adaptive);
+	spdk_json_write_named_uint32(w, "raid5f_stripe_pool_max_kb", g_opts.raid5f_stripe_pool_max_kb);
+	spdk_json_write_object_end(w);
 
-	rc = _raid_bdev_remove_base_bdev(base_info, raid_bdev_fail_base_remove_cb, base_info);
-	if (rc != 0) {
-		raid_bdev_fail_base_remove_cb(base_info, rc);
-	}
+	spdk_json_write_object_end(w);
 }
 
-void
-raid_bdev_fail_base_bdev(struct raid_base_bdev_info *base_info)
+static int
+raid_bdev_config_json(struct spdk_json_write_ctx *w)
 {
-	spdk_thread_exec_msg(spdk_thread_get_app_thread(), _raid_bdev_fail_base_bdev, base_info);
+	raid_bdev_opts_config_json(w);
+
+	return 0;
 }
 
-static void
-raid_bdev_resize_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+/*
+ * brief:
+ * raid_bdev_get_ctx_size is used to return the context size of bdev_io for raid
+ * module
+ * params:
+ * none
+ * returns:
+ * size of spdk_bdev_io context for raid
+ */
+static int
+raid_bdev_get_ctx_size(void)
 {
-	if (status != 0) {
-		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock after resizing the bdev: %s\n",
-			    raid_bdev->bdev.name, spdk_strerror(-status));
-	}
+	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_get_ctx_size\n");
+	return sizeof(struct raid_bdev_io);
 }
 
+static struct spdk_bdev_module g_raid_if = {
+	.name = "raid",
+	.module_init = raid_bdev_init,
+	.fini_start = raid_bdev_fini_start,
+	.module_fini = raid_bdev_exit,
+	.config_json = raid_bdev_config_json,
+	.get_ctx_size = raid_bdev_get_ctx_size,
+	.examine_disk = raid_bdev_examine,
+	.async_init = false,
+	.async_fini = false,
+};
+SPDK_BDEV_MODULE_REGISTER(raid, &g_raid_if)
+
 /*
  * brief:
- * raid_bdev_resize_base_bdev function is called by below layers when base_bdev
- * is resized. This function checks if the smallest size of the base_bdevs is changed.
- * If yes, call module handler to resize the raid_bdev if implemented.
+ * raid_bdev_init is the initialization function for raid bdev module
  * params:
- * base_bdev - pointer to base bdev which got resized.
- * returns:
  * none
+ * returns:
+ * 0 - success
+ * non zero - failure
  */
-static void
-raid_bdev_resize_base_bdev(struct spdk_bdev *base_bdev)
+static int
+raid_bdev_init(void)
+{
+	return 0;
+}
+
+static int
+_raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
+		  enum raid_level level, bool superblock_enabled, const struct spdk_uuid *uuid,
+		  struct raid_bdev **raid_bdev_out)
 {
 	struct raid_bdev *raid_bdev;
+	struct spdk_bdev *raid_bdev_gen;
+	struct raid_bdev_module *module;
 	struct raid_base_bdev_info *base_info;
-	uint64_t blockcnt_old;
+	uint8_t min_operational;
 
-	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_resize_base_bdev\n");
+	if (strnlen(name, RAID_BDEV_SB_NAME_SIZE) == RAID_BDEV_SB_NAME_SIZE) {
+		SPDK_ERRLOG("Raid bdev name '%s' exceeds %d characters\n", name, RAID_BDEV_SB_NAME_SIZE - 1);
+		return -EINVAL;
+	}
 
-	base_info = raid_bdev_find_base_info_by_bdev(base_bdev);
+	if (raid_bdev_find_by_name(name) != NULL) {
+		SPDK_ERRLOG("Duplicate raid bdev name found: %s\n", name);
+		return -EEXIST;
+	}
 
-	/* Find the raid_bdev which has claimed this base_bdev */
-	if (!base_info) {
-		SPDK_ERRLOG("raid_bdev whose base_bdev '%s' not found\n", base_bdev->name);
-		return;
+	if (level == RAID1) {
+		if (strip_size != 0) {
+			SPDK_ERRLOG("Strip size is not supported by raid1\n");
+			return -EINVAL;
+		}
+	} else if (spdk_u32_is_pow2(strip_size) == false) {
+		SPDK_ERRLOG("Invalid strip size %" PRIu32 "\n", strip_size);
+		return -EINVAL;
 	}
-	raid_bdev = base_info->raid_bdev;
 
-	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	module = raid_bdev_module_find(level);
+	if (module == NULL) {
+		SPDK_ERRLOG("Unsupported raid level '%d'\n", level);
+		return -EINVAL;
+	}
 
-	SPDK_NOTICELOG("base_bdev '%s' was resized: old size %" PRIu64 ", new size %" PRIu64 "\n",
-		       base_bdev->name, base_info->blockcnt, base_bdev->blockcnt);
+	assert(module->base_bdevs_min != 0);
+	if (num_base_bdevs < module->base_bdevs_min) {
+		SPDK_ERRLOG("At least %u base devices required for %s\n",
+			    module->base_bdevs_min,
+			    raid_bdev_level_to_str(level));
+		return -EINVAL;
+	}
 
-	base_info->blockcnt = base_bdev->blockcnt;
+	if (level == RAID10 && num_base_bdevs % 2 != 0) {
+		SPDK_ERRLOG("An even number of base devices is required for %s\n",
+			    raid_bdev_level_to_str(level));
+		return -EINVAL;
+	}
 
-	if (!raid_bdev->module->resize) {
-		return;
+	switch (module->base_bdevs_constraint.type) {
+	case CONSTRAINT_MAX_BASE_BDEVS_REMOVED:
+		min_operational = num_base_bdevs - module->base_bdevs_constraint.value;
+		break;
+	case CONSTRAINT_MIN_BASE_BDEVS_OPERATIONAL:
+		min_operational = module->base_bdevs_constraint.value;
+		break;
+	case CONSTRAINT_UNSET:
+		if (module->base_bdevs_constraint.value != 0) {
+			SPDK_ERRLOG("Unexpected constraint value '%u' provided for raid bdev '%s'.\n",
+				    (uint8_t)module->base_bdevs_constraint.value, name);
+			return -EINVAL;
+		}
+		min_operational = num_base_bdevs;
+		break;
+	default:
+		SPDK_ERRLOG("Unrecognised constraint type '%u' in module for raid level '%s'.\n",
+			    (uint8_t)module->base_bdevs_constraint.type,
+			    raid_bdev_level_to_str(module->level));
+		return -EINVAL;
+	};
+
+	if (min_operational == 0 || min_operational > num_base_bdevs) {
+		SPDK_ERRLOG("Wrong constraint value for raid level '%s'.\n",
+			    raid_bdev_level_to_str(module->level));
+		return -EINVAL;
 	}
 
-	blockcnt_old = raid_bdev->bdev.blockcnt;
-	if (raid_bdev->module->resize(raid_bdev) == false) {
-		return;
+	raid_bdev = calloc(1, sizeof(*raid_bdev));
+	if (!raid_bdev) {
+		SPDK_ERRLOG("Unable to allocate memory for raid bdev\n");
+		return -ENOMEM;
 	}
 
-	SPDK_NOTICELOG("raid bdev '%s': block count was changed from %" PRIu64 " to %" PRIu64 "\n",
-		       raid_bdev->bdev.name, blockcnt_old, raid_bdev->bdev.blockcnt);
+	raid_bdev->module = module;
+	raid_bdev->num_base_bdevs = num_base_bdevs;
+	raid_bdev->base_bdev_info = calloc(raid_bdev->num_base_bdevs,
+					   sizeof(struct raid_base_bdev_info));
+	if (!raid_bdev->base_bdev_info) {
+		SPDK_ERRLOG("Unable able to allocate base bdev info\n");
+		raid_bdev_free(raid_bdev);
+		return -ENOMEM;
+	}
 
-	if (raid_bdev->superblock_enabled) {
-		struct raid_bdev_superblock *sb = raid_bdev->sb;
-		uint8_t i;
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		base_info->raid_bdev = raid_bdev;
+	}
 
-		for (i = 0; i < sb->base_bdevs_size; i++) {
-			struct raid_bdev_sb_base_bdev *sb_base_bdev = &sb->base_bdevs[i];
+	/* strip_size_kb is from the rpc param.  strip_size is in blocks and used
+	 * internally and set later.
+	 */
+	raid_bdev->strip_size = 0;
+	raid_bdev->strip_size_kb = strip_size;
+	raid_bdev->state = RAID_BDEV_STATE_CONFIGURING;
+	raid_bdev->level = level;
+	raid_bdev->min_base_bdevs_operational = min_operational;
+	raid_bdev->superblock_enabled = superblock_enabled;
 
-			if (sb_base_bdev->state == RAID_SB_BASE_BDEV_CONFIGURED) {
-				base_info = &raid_bdev->base_bdev_info[sb_base_bdev->slot];
-				sb_base_bdev->data_size = base_info->data_size;
-			}
-		}
-		sb->raid_size = raid_bdev->bdev.blockcnt;
-		raid_bdev_write_superblock(raid_bdev, raid_bdev_resize_write_sb_cb, NULL);
+	raid_bdev_gen = &raid_bdev->bdev;
+
+	raid_bdev_gen->name = strdup(name);
+	if (!raid_bdev_gen->name) {
+		SPDK_ERRLOG("Unable to allocate name for raid\n");
+		raid_bdev_free(raid_bdev);
+		return -ENOMEM;
 	}
+
+	raid_bdev_gen->product_name = "Raid Volume";
+	raid_bdev_gen->ctxt = raid_bdev;
+	raid_bdev_gen->fn_table = &g_raid_bdev_fn_table;
+	raid_bdev_gen->module = &g_raid_if;
+	raid_bdev_gen->write_cache = 0;
+	spdk_uuid_copy(&raid_bdev_gen->uuid, uuid);
+
+	TAILQ_INSERT_TAIL(&g_raid_bdev_list, raid_bdev, global_link);
+
+	*raid_bdev_out = raid_bdev;
+
+	return 0;
 }
 
 /*
  * brief:
- * raid_bdev_event_base_bdev function is called by below layers when base_bdev
- * triggers asynchronous event.
+ * raid_bdev_create allocates raid bdev based on passed configuration
  * params:
- * type - event details.
- * bdev - bdev that triggered event.
- * event_ctx - context for event.
+ * name - name for raid bdev
+ * strip_size - strip size in KB
+ * num_base_bdevs - number of base bdevs
+ * level - raid level
+ * superblock_enabled - true if raid should have superblock
+ * uuid - uuid to set for the bdev
+ * raid_bdev_out - the created raid bdev
  * returns:
- * none
+ * 0 - success
+ * non zero - failure
  */
-static void
-raid_bdev_event_base_bdev(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
-			  void *event_ctx)
+int
+raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
+		 enum raid_level level, bool superblock_enabled, const struct spdk_uuid *uuid,
+		 struct raid_bdev **raid_bdev_out)
 {
+	struct raid_bdev *raid_bdev;
 	int rc;
 
-	switch (type) {
-	case SPDK_BDEV_EVENT_REMOVE:
-		rc = raid_bdev_remove_base_bdev(bdev, NULL, NULL);
-		if (rc != 0) {
-			SPDK_ERRLOG("Failed to remove base bdev %s: %s\n",
-				    spdk_bdev_get_name(bdev), spdk_strerror(-rc));
-		}
-		break;
-	case SPDK_BDEV_EVENT_RESIZE:
-		raid_bdev_resize_base_bdev(bdev);
-		break;
-	default:
-		SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
-		break;
+	assert(uuid != NULL);
+
+	rc = _raid_bdev_create(name, strip_size, num_base_bdevs, level, superblock_enabled, uuid,
+			       &raid_bdev);
+	if (rc != 0) {
+		return rc;
 	}
-}
 
-/*
- * brief:
- * Deletes the specified raid bdev
- * params:
- * raid_bdev - pointer to raid bdev
- * cb_fn - callback function
- * cb_arg - argument to callback function
- */
-void
-raid_bdev_delete(struct raid_bdev *raid_bdev, raid_bdev_destruct_cb cb_fn, void *cb_arg)
-{
-	struct raid_base_bdev_info *base_info;
-
-	SPDK_DEBUGLOG(bdev_raid, "delete raid bdev: %s\n", raid_bdev->bdev.name);
-
-	if (raid_bdev->destroy_started) {
-		SPDK_DEBUGLOG(bdev_raid, "destroying raid bdev %s is already started\n",
-			      raid_bdev->bdev.name);
-		if (cb_fn) {
-			cb_fn(cb_arg, -EALREADY);
-		}
-		return;
+	if (superblock_enabled && spdk_uuid_is_null(uuid)) {
+		/* we need to have the uuid to store in the superblock before the bdev is registered */
+		spdk_uuid_generate(&raid_bdev->bdev.uuid);
 	}
 
-	raid_bdev->destroy_started = true;
-
-	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
-		base_info->remove_scheduled = true;
+	raid_bdev->num_base_bdevs_operational = num_base_bdevs;
 
-		if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
-			/*
-			 * As raid bdev is not registered yet or already unregistered,
-			 * so cleanup should be done here itself.
-			 */
-			raid_bdev_free_base_bdev_resource(base_info);
-		}
-	}
+	*raid_bdev_out = raid_bdev;
 
-	if (raid_bdev->num_base_bdevs_discovered == 0) {
-		/* There is no base bdev for this raid, so free the raid device. */
-		raid_bdev_cleanup_and_free(raid_bdev);
-		if (cb_fn) {
-			cb_fn(cb_arg, 0);
-		}
-	} else {
-		raid_bdev_deconfigure(raid_bdev, cb_fn, cb_arg);
-	}
+	return 0;
 }
 
 static void
-raid_bdev_process_finish_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+_raid_bdev_unregistering_cont(void *ctx)
 {
-	if (status != 0) {
-		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock after background process finished: %s\n",
-			    raid_bdev->bdev.name, spdk_strerror(-status));
-	}
+	struct raid_bdev *raid_bdev = ctx;
+
+	spdk_bdev_close(raid_bdev->self_desc);
+	raid_bdev->self_desc = NULL;
 }
 
 static void
-raid_bdev_process_finish_write_sb(void *ctx)
+raid_bdev_unregistering_cont(void *ctx)
 {
-	struct raid_bdev *raid_bdev = ctx;
-	struct raid_bdev_superblock *sb = raid_bdev->sb;
-	struct raid_bdev_sb_base_bdev *sb_base_bdev;
-	struct raid_base_bdev_info *base_info;
-	uint8_t i;
-
-	for (i = 0; i < sb->base_bdevs_size; i++) {
-		sb_base_bdev = &sb->base_bdevs[i];
-
-		if (sb_base_bdev->state != RAID_SB_BASE_BDEV_CONFIGURED &&
-		    sb_base_bdev->slot < raid_bdev->num_base_bdevs) {
-			base_info = &raid_bdev->base_bdev_info[sb_base_bdev->slot];
-			if (base_info->is_configured) {
-				sb_base_bdev->state = RAID_SB_BASE_BDEV_CONFIGURED;
-				spdk_uuid_copy(&sb_base_bdev->uuid, &base_info->uuid);
-			}
-		}
-	}
-
-	raid_bdev_write_superblock(raid_bdev, raid_bdev_process_finish_write_sb_cb, NULL);
+	spdk_thread_exec_msg(spdk_thread_get_app_thread(), _raid_bdev_unregistering_cont, ctx);
 }
 
-static void raid_bdev_process_free(struct raid_bdev_process *process);
-
-static void
-_raid_bdev_process_finish_done(void *ctx)
+static int
+raid_bdev_process_add_finish_action(struct raid_bdev_process *process, spdk_msg_fn cb, void *cb_ctx)
 {
-	struct raid_bdev_process *process = ctx;
 	struct raid_process_finish_action *finish_action;
 
-	while ((finish_action = TAILQ_FIRST(&process->finish_actions)) != NULL) {
-		TAILQ_REMOVE(&process->finish_actions, finish_action, link);
-		finish_action->cb(finish_action->cb_ctx);
-		free(finish_action);
+	assert(spdk_get_thread() == process->thread);
+	assert(process->state < RAID_PROCESS_STATE_STOPPED);
+
+	finish_action = calloc(1, sizeof(*finish_action));
+	if (finish_action == NULL) {
+		return -ENOMEM;
 	}
 
-	raid_bdev_process_free(process);
+	finish_action->cb = cb;
+	finish_action->cb_ctx = cb_ctx;
 
-	spdk_thread_exit(spdk_get_thread());
+	TAILQ_INSERT_TAIL(&process->finish_actions, finish_action, link);
+
+	return 0;
 }
 
+static void raid_bdev_process_thread_run(struct raid_bdev_process *process);
+
+/* Don't wait for the end of the throttling period of a process being stopped */
 static void
-raid_bdev_process_finish_target_removed(void *ctx, int status)
+raid_bdev_process_stop_throttled(struct raid_bdev_process *process)
 {
-	struct raid_bdev_process *process = ctx;
+	assert(process->state == RAID_PROCESS_STATE_STOPPING);
 
-	if (status != 0) {
-		SPDK_ERRLOG("Failed to remove target bdev: %s\n", spdk_strerror(-status));
+	if (process->throttle_poller != NULL) {
+		spdk_poller_unregister(&process->throttle_poller);
+		raid_bdev_process_thread_run(process);
 	}
-
-	spdk_thread_send_msg(process->thread, _raid_bdev_process_finish_done, process);
 }
 
 static void
-raid_bdev_process_finish_unquiesced(void *ctx, int status)
+raid_bdev_unregistering_stop_process(void *ctx)
 {
 	struct raid_bdev_process *process = ctx;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	int rc;
 
-	if (status != 0) {
-		SPDK_ERRLOG("Failed to unquiesce bdev: %s\n", spdk_strerror(-status));
+	process->state = RAID_PROCESS_STATE_STOPPING;
+	if (process->status == 0) {
+		process->status = -ECANCELED;
 	}
 
-	if (process->status != 0) {
-		status = _raid_bdev_remove_base_bdev(process->target, raid_bdev_process_finish_target_removed,
-						     process);
-		if (status != 0) {
-			raid_bdev_process_finish_target_removed(process, status);
-		}
-		return;
+	rc = raid_bdev_process_add_finish_action(process, raid_bdev_unregistering_cont, raid_bdev);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to add raid bdev '%s' process finish action: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-rc));
 	}
 
-	spdk_thread_send_msg(process->thread, _raid_bdev_process_finish_done, process);
+	raid_bdev_process_stop_throttled(process);
 }
 
 static void
-raid_bdev_process_finish_unquiesce(void *ctx)
+raid_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev, void *event_ctx)
 {
-	struct raid_bdev_process *process = ctx;
-	int rc;
+	struct raid_bdev *raid_bdev = event_ctx;
 
-	rc = spdk_bdev_unquiesce(&process->raid_bdev->bdev, &g_raid_if,
-				 raid_bdev_process_finish_unquiesced, process);
-	if (rc != 0) {
-		raid_bdev_process_finish_unquiesced(process, rc);
+	if (type == SPDK_BDEV_EVENT_REMOVE) {
+		if (raid_bdev->process != NULL) {
+			spdk_thread_send_msg(raid_bdev->process->thread, raid_bdev_unregistering_stop_process,
+					     raid_bdev->process);
+		} else {
+			raid_bdev_unregistering_cont(raid_bdev);
+		}
 	}
 }
 
 static void
-raid_bdev_process_finish_done(void *ctx)
+raid_bdev_configure_cont(struct raid_bdev *raid_bdev)
 {
-	struct raid_bdev_process *process = ctx;
-	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct spdk_bdev *raid_bdev_gen = &raid_bdev->bdev;
+	int rc;
 
-	if (process->raid_ch != NULL) {
-		spdk_put_io_channel(spdk_io_channel_from_ctx(process->raid_ch));
+	raid_bdev->state = RAID_BDEV_STATE_ONLINE;
+	SPDK_DEBUGLOG(bdev_raid, "io device register %p\n", raid_bdev);
+	SPDK_DEBUGLOG(bdev_raid, "blockcnt %" PRIu64 ", blocklen %u\n",
+		      raid_bdev_gen->blockcnt, raid_bdev_gen->blocklen);
+	spdk_io_device_register(raid_bdev, raid_bdev_create_cb, raid_bdev_destroy_cb,
+				sizeof(struct raid_bdev_io_channel),
+				raid_bdev_gen->name);
+	rc = spdk_bdev_register(raid_bdev_gen);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to register raid bdev '%s': %s\n",
+			    raid_bdev_gen->name, spdk_strerror(-rc));
+		goto err;
 	}
 
-	process->state = RAID_PROCESS_STATE_STOPPED;
+	/*
+	 * Open the bdev internally to delay unregistering if we need to stop a background process
+	 * first. The process may still need to unquiesce a range but it will fail because the
+	 * bdev's internal.spinlock is destroyed by the time the destruct callback is reached.
+	 * During application shutdown, bdevs automatically get unregistered by the bdev layer
+	 * so this is the only way currently to do this correctly.
+	 * TODO: try to handle this correctly in bdev layer instead.
+	 */
+	rc = spdk_bdev_open_ext(raid_bdev_gen->name, false, raid_bdev_event_cb, raid_bdev,
+				&raid_bdev->self_desc);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to open raid bdev '%s': %s\n",
+			    raid_bdev_gen->name, spdk_strerror(-rc));
+		spdk_bdev_unregister(raid_bdev_gen, NULL, NULL);
+		goto err;
+	}
 
-	if (process->status == 0) {
-		SPDK_NOTICELOG("Finished %s on raid bdev %s\n",
-			       raid_bdev_process_to_str(process->type),
-			       raid_bdev->bdev.name);
-		if (raid_bdev->superblock_enabled) {
-			spdk_thread_send_msg(spdk_thread_get_app_thread(),
-					     raid_bdev_process_finish_write_sb,
-					     raid_bdev);
+	if (raid_bdev->bitmap != NULL) {
+		raid_bdev_bitmap_start(raid_bdev);
+	}
+
+	if (raid_bdev->reshape.restriping) {
+		rc = raid_bdev_start_reshape(raid_bdev);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to resume reshape of raid bdev '%s': %s\n",
+				    raid_bdev_gen->name, spdk_strerror(-rc));
 		}
-	} else {
-		SPDK_WARNLOG("Finished %s on raid bdev %s: %s\n",
-			     raid_bdev_process_to_str(process->type),
-			     raid_bdev->bdev.name,
-			     spdk_strerror(-process->status));
 	}
 
-	spdk_thread_send_msg(spdk_thread_get_app_thread(), raid_bdev_process_finish_unquiesce,
-			     process);
+	SPDK_DEBUGLOG(bdev_raid, "raid bdev generic %p\n", raid_bdev_gen);
+	SPDK_DEBUGLOG(bdev_raid, "raid bdev is created with name %s, raid_bdev %p\n",
+		      raid_bdev_gen->name, raid_bdev);
+	return;
+err:
+	raid_bdev_bitmap_free(raid_bdev);
+	if (raid_bdev->module->stop != NULL) {
+		raid_bdev->module->stop(raid_bdev);
+	}
+	spdk_io_device_unregister(raid_bdev, NULL);
+	raid_bdev->state = RAID_BDEV_STATE_CONFIGURING;
 }
 
 static void
-__raid_bdev_process_finish(struct spdk_io_channel_iter *i, int status)
+raid_bdev_configure_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
 {
-	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
-
-	spdk_thread_send_msg(process->thread, raid_bdev_process_finish_done, process);
+	if (status == 0) {
+		raid_bdev_configure_cont(raid_bdev);
+	} else {
+		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+		raid_bdev_bitmap_free(raid_bdev);
+		if (raid_bdev->module->stop != NULL) {
+			raid_bdev->module->stop(raid_bdev);
+		}
+	}
 }
 
 static void
-raid_bdev_channel_process_finish(struct spdk_io_channel_iter *i)
+raid_bdev_configure_write_bitmap_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
 {
-	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
-	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
-	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	struct raid_bdev_bitmap *bitmap = raid_bdev->bitmap;
 
-	if (process->status == 0) {
-		uint8_t slot = raid_bdev_base_bdev_slot(process->target);
-
-		raid_ch->base_channel[slot] = raid_ch->process.target_ch;
-		raid_ch->process.target_ch = NULL;
+	if (status == 0) {
+		spdk_bit_array_load_mask(bitmap->persisted, bitmap->buf);
+		raid_bdev_write_superblock(raid_bdev, raid_bdev_configure_write_sb_cb, NULL);
+	} else {
+		SPDK_ERRLOG("Failed to write raid bdev '%s' write-intent bitmap: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+		raid_bdev_bitmap_free(raid_bdev);
+		if (raid_bdev->module->stop != NULL) {
+			raid_bdev->module->stop(raid_bdev);
+		}
 	}
-
-	raid_bdev_ch_process_cleanup(raid_ch);
-
-	spdk_for_each_channel_continue(i, 0);
 }
 
 static void
-raid_bdev_process_finish_quiesced(void *ctx, int status)
+raid_bdev_configure_load_bitmap_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
 {
-	struct raid_bdev_process *process = ctx;
-	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_bdev_bitmap *bitmap = raid_bdev->bitmap;
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
 
-	if (status != 0) {
-		SPDK_ERRLOG("Failed to quiesce bdev: %s\n", spdk_strerror(-status));
-		return;
+	if (status != 0 || sb->bitmap_seq_number != sb->seq_number) {
+		/*
+		 * The bitmap could not be read or was not maintained by the last user of the raid
+		 * bdev, so any region may be inconsistent.
+		 */
+		SPDK_WARNLOG("Write-intent bitmap of raid bdev '%s' is not valid, "
+			     "marking all regions dirty\n", raid_bdev->bdev.name);
+		memset(bitmap->buf, 0xff, sb->bitmap_size);
 	}
 
-	raid_bdev->process = NULL;
-	process->target->is_process_target = false;
+	spdk_bit_array_load_mask(bitmap->dirty, bitmap->buf);
 
-	spdk_for_each_channel(process->raid_bdev, raid_bdev_channel_process_finish, process,
-			      __raid_bdev_process_finish);
+	raid_bdev_write_bitmap(raid_bdev, bitmap->buf, raid_bdev_configure_write_bitmap_cb, NULL);
 }
 
-static void
-_raid_bdev_process_finish(void *ctx)
+/*
+ * brief:
+ * If raid bdev config is complete, then only register the raid bdev to
+ * bdev layer and remove this raid bdev from configuring list and
+ * insert the raid bdev to configured list
+ * params:
+ * raid_bdev - pointer to raid bdev
+ * returns:
+ * 0 - success
+ * non zero - failure
+ */
+static int
+raid_bdev_configure(struct raid_bdev *raid_bdev)
 {
-	struct raid_bdev_process *process = ctx;
+	uint32_t data_block_size = spdk_bdev_get_data_block_size(&raid_bdev->bdev);
 	int rc;
 
-	rc = spdk_bdev_quiesce(&process->raid_bdev->bdev, &g_raid_if,
-			       raid_bdev_process_finish_quiesced, process);
+	assert(raid_bdev->state == RAID_BDEV_STATE_CONFIGURING);
+	assert(raid_bdev->num_base_bdevs_discovered == raid_bdev->num_base_bdevs_operational);
+	assert(raid_bdev->bdev.blocklen > 0);
+
+	/* The strip_size_kb is read in from user in KB. Convert to blocks here for
+	 * internal use.
+	 */
+	raid_bdev->strip_size = (raid_bdev->strip_size_kb * 1024) / data_block_size;
+	if (raid_bdev->strip_size == 0 && raid_bdev->level != RAID1) {
+		SPDK_ERRLOG("Strip size cannot be smaller than the device block size\n");
+		return -EINVAL;
+	}
+	raid_bdev->strip_size_shift = spdk_u32log2(raid_bdev->strip_size);
+
+	rc = raid_bdev->module->start(raid_bdev);
 	if (rc != 0) {
-		raid_bdev_process_finish_quiesced(ctx, rc);
+		SPDK_ERRLOG("raid module startup callback failed\n");
+		return rc;
+	}
+
+	if (raid_bdev->superblock_enabled) {
+		bool new_sb = false;
+
+		if (raid_bdev->sb == NULL) {
+			rc = raid_bdev_alloc_superblock(raid_bdev, data_block_size);
+			if (rc == 0) {
+				raid_bdev_init_superblock(raid_bdev);
+				raid_bdev_bitmap_init_superblock(raid_bdev);
+				new_sb = true;
+			}
+		} else {
+			assert(spdk_uuid_compare(&raid_bdev->sb->uuid, &raid_bdev->bdev.uuid) == 0);
+			if (raid_bdev->sb->block_size != data_block_size) {
+				SPDK_ERRLOG("blocklen does not match value in superblock\n");
+				rc = -EINVAL;
+			}
+			if (raid_bdev->sb->raid_size != raid_bdev->bdev.blockcnt) {
+				SPDK_ERRLOG("blockcnt does not match value in superblock\n");
+				rc = -EINVAL;
+			}
+			if (raid_bdev->sb->bitmap_size != 0 &&
+			    !raid_bdev_bitmap_superblock_valid(raid_bdev->sb)) {
+				SPDK_ERRLOG("Invalid write-intent bitmap parameters in superblock\n");
+				rc = -EINVAL;
+			}
+		}
+
+		if (rc == 0 && raid_bdev->sb->bitmap_size != 0) {
+			rc = raid_bdev_bitmap_alloc(raid_bdev);
+		}
+
+		if (rc != 0) {
+			if (raid_bdev->module->stop != NULL) {
+				raid_bdev->module->stop(raid_bdev);
+			}
+			return rc;
+		}
+
+		if (raid_bdev->bitmap == NULL) {
+			raid_bdev_write_superblock(raid_bdev, raid_bdev_configure_write_sb_cb, NULL);
+		} else if (new_sb) {
+			raid_bdev_write_bitmap(raid_bdev, raid_bdev->bitmap->buf,
+					       raid_bdev_configure_write_bitmap_cb, NULL);
+		} else {
+			raid_bdev_load_bitmap(raid_bdev, raid_bdev->bitmap->buf,
+					      raid_bdev_configure_load_bitmap_cb, NULL);
+		}
+	} else {
+		raid_bdev_configure_cont(raid_bdev);
 	}
+
+	return 0;
 }
 
+/*
+ * brief:
+ * If raid bdev is online and registered, change the bdev state to
+ * configuring and unregister this raid device. Queue this raid device
+ * in configuring list
+ * params:
+ * raid_bdev - pointer to raid bdev
+ * cb_fn - callback function
+ * cb_arg - argument to callback function
+ * returns:
+ * none
+ */
 static void
-raid_bdev_process_do_finish(struct raid_bdev_process *process)
+raid_bdev_deconfigure(struct raid_bdev *raid_bdev, raid_bdev_destruct_cb cb_fn,
+		      void *cb_arg)
 {
-	spdk_thread_send_msg(spdk_thread_get_app_thread(), _raid_bdev_process_finish, process);
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
+		if (cb_fn) {
+			cb_fn(cb_arg, 0);
+		}
+		return;
+	}
+
+	raid_bdev->state = RAID_BDEV_STATE_OFFLINE;
+	SPDK_DEBUGLOG(bdev_raid, "raid bdev state changing from online to offline\n");
+
+	spdk_bdev_unregister(&raid_bdev->bdev, cb_fn, cb_arg);
 }
 
-static void raid_bdev_process_unlock_window_range(struct raid_bdev_process *process);
-static void raid_bdev_process_thread_run(struct raid_bdev_process *process);
+/*
+ * brief:
+ * raid_bdev_find_base_info_by_bdev function finds the base bdev info by bdev.
+ * params:
+ * base_bdev - pointer to base bdev
+ * returns:
+ * base bdev info if found, otherwise NULL.
+ */
+static struct raid_base_bdev_info *
+raid_bdev_find_base_info_by_bdev(struct spdk_bdev *base_bdev)
+{
+	struct raid_bdev *raid_bdev;
+	struct raid_base_bdev_info *base_info;
+
+	TAILQ_FOREACH(raid_bdev, &g_raid_bdev_list, global_link) {
+		RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+			if (base_info->desc != NULL &&
+			    spdk_bdev_desc_get_bdev(base_info->desc) == base_bdev) {
+				return base_info;
+			}
+		}
+	}
+
+	return NULL;
+}
 
 static void
-raid_bdev_process_finish(struct raid_bdev_process *process, int status)
+raid_bdev_remove_base_bdev_done(struct raid_base_bdev_info *base_info, int status)
 {
-	assert(spdk_get_thread() == process->thread);
+	struct raid_bdev *raid_bdev = base_info->raid_bdev;
 
-	if (process->status == 0) {
-		process->status = status;
+	assert(base_info->remove_scheduled);
+	base_info->remove_scheduled = false;
+
+	if (status == 0) {
+		raid_bdev->num_base_bdevs_operational--;
+		if (raid_bdev->num_base_bdevs_operational < raid_bdev->min_base_bdevs_operational) {
+			/* There is not enough base bdevs to keep the raid bdev operational. */
+			raid_bdev_deconfigure(raid_bdev, base_info->remove_cb, base_info->remove_cb_ctx);
+			return;
+		}
 	}
 
-	if (process->state >= RAID_PROCESS_STATE_STOPPING) {
-		return;
+	if (base_info->remove_cb != NULL) {
+		base_info->remove_cb(base_info->remove_cb_ctx, status);
 	}
+}
 
-	assert(process->state == RAID_PROCESS_STATE_RUNNING);
-	process->state = RAID_PROCESS_STATE_STOPPING;
+static void
+raid_bdev_remove_base_bdev_on_unquiesced(void *ctx, int status)
+{
+	struct raid_base_bdev_info *base_info = ctx;
+	struct raid_bdev *raid_bdev = base_info->raid_bdev;
 
-	if (process->window_range_locked) {
-		raid_bdev_process_unlock_window_range(process);
-	} else {
-		raid_bdev_process_thread_run(process);
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to unquiesce raid bdev %s: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
 	}
+
+	raid_bdev_remove_base_bdev_done(base_info, status);
 }
 
 static void
-raid_bdev_process_window_range_unlocked(void *ctx, int status)
+raid_bdev_channel_remove_base_bdev(struct spdk_io_channel_iter *i)
 {
-	struct raid_bdev_process *process = ctx;
+	struct raid_base_bdev_info *base_info = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	uint8_t idx = raid_bdev_base_bdev_slot(base_info);
+
+	SPDK_DEBUGLOG(bdev_raid, "slot: %u raid_ch: %p\n", idx, raid_ch);
+
+	if (raid_ch->base_channel[idx] != NULL) {
+		spdk_put_io_channel(raid_ch->base_channel[idx]);
+		raid_ch->base_channel[idx] = NULL;
+	}
+
+	if (raid_ch->process.ch_processed != NULL) {
+		raid_ch->process.ch_processed->base_channel[idx] = NULL;
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+raid_bdev_channels_remove_base_bdev_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_base_bdev_info *base_info = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+
+	raid_bdev_free_base_bdev_resource(base_info);
+
+	spdk_bdev_unquiesce(&raid_bdev->bdev, &g_raid_if, raid_bdev_remove_base_bdev_on_unquiesced,
+			    base_info);
+}
+
+static void
+raid_bdev_remove_base_bdev_cont(struct raid_base_bdev_info *base_info)
+{
+	raid_bdev_deconfigure_base_bdev(base_info);
+
+	spdk_for_each_channel(base_info->raid_bdev, raid_bdev_channel_remove_base_bdev, base_info,
+			      raid_bdev_channels_remove_base_bdev_done);
+}
+
+static void
+raid_bdev_remove_base_bdev_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+{
+	struct raid_base_bdev_info *base_info = ctx;
 
 	if (status != 0) {
-		SPDK_ERRLOG("Failed to unlock LBA range: %s\n", spdk_strerror(-status));
-		raid_bdev_process_finish(process, status);
+		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+		raid_bdev_remove_base_bdev_done(base_info, status);
 		return;
 	}
 
-	process->window_range_locked = false;
-	process->window_offset += process->window_size;
-
-	raid_bdev_process_thread_run(process);
+	raid_bdev_remove_base_bdev_cont(base_info);
 }
 
 static void
-raid_bdev_process_unlock_window_range(struct raid_bdev_process *process)
+raid_bdev_remove_base_bdev_on_quiesced(void *ctx, int status)
 {
-	int rc;
+	struct raid_base_bdev_info *base_info = ctx;
+	struct raid_bdev *raid_bdev = base_info->raid_bdev;
 
-	assert(process->window_range_locked == true);
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to quiesce raid bdev %s: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+		raid_bdev_remove_base_bdev_done(base_info, status);
+		return;
+	}
 
-	rc = spdk_bdev_unquiesce_range(&process->raid_bdev->bdev, &g_raid_if,
-				       process->window_offset, process->max_window_size,
-				       raid_bdev_process_window_range_unlocked, process);
+	if (raid_bdev->sb) {
+		struct raid_bdev_superblock *sb = raid_bdev->sb;
+		uint8_t slot = raid_bdev_base_bdev_slot(base_info);
+		uint8_t i;
+
+		for (i = 0; i < sb->base_bdevs_size; i++) {
+			struct raid_bdev_sb_base_bdev *sb_base_bdev = &sb->base_bdevs[i];
+
+			if (sb_base_bdev->state == RAID_SB_BASE_BDEV_CONFIGURED &&
+			    sb_base_bdev->slot == slot) {
+				if (base_info->is_failed) {
+					sb_base_bdev->state = RAID_SB_BASE_BDEV_FAILED;
+				} else {
+					sb_base_bdev->state = RAID_SB_BASE_BDEV_MISSING;
+				}
+
+				raid_bdev_write_superblock(raid_bdev, raid_bdev_remove_base_bdev_write_sb_cb, base_info);
+				return;
+			}
+		}
+	}
+
+	raid_bdev_remove_base_bdev_cont(base_info);
+}
+
+static int
+raid_bdev_remove_base_bdev_quiesce(struct raid_base_bdev_info *base_info)
+{
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	return spdk_bdev_quiesce(&base_info->raid_bdev->bdev, &g_raid_if,
+				 raid_bdev_remove_base_bdev_on_quiesced, base_info);
+}
+
+struct raid_bdev_process_base_bdev_remove_ctx {
+	struct raid_bdev_process *process;
+	struct raid_base_bdev_info *base_info;
+	uint8_t num_base_bdevs_operational;
+};
+
+static void
+_raid_bdev_process_base_bdev_remove_cont(void *ctx)
+{
+	struct raid_base_bdev_info *base_info = ctx;
+	int ret;
+
+	ret = raid_bdev_remove_base_bdev_quiesce(base_info);
+	if (ret != 0) {
+		raid_bdev_remove_base_bdev_done(base_info, ret);
+	}
+}
+
+static void
+raid_bdev_process_base_bdev_remove_cont(void *_ctx)
+{
+	struct raid_bdev_process_base_bdev_remove_ctx *ctx = _ctx;
+	struct raid_base_bdev_info *base_info = ctx->base_info;
+
+	free(ctx);
+
+	spdk_thread_send_msg(spdk_thread_get_app_thread(), _raid_bdev_process_base_bdev_remove_cont,
+			     base_info);
+}
+
+static void
+_raid_bdev_process_base_bdev_remove(void *_ctx)
+{
+	struct raid_bdev_process_base_bdev_remove_ctx *ctx = _ctx;
+	struct raid_bdev_process *process = ctx->process;
+	int ret;
+
+	/* Resync, reshape and scrub can only run when all base bdevs are present */
+	if (process->type != RAID_PROCESS_RESYNC && process->type != RAID_PROCESS_RESHAPE &&
+	    process->type != RAID_PROCESS_SCRUB &&
+	    ctx->base_info != process->target &&
+	    ctx->num_base_bdevs_operational > process->raid_bdev->min_base_bdevs_operational) {
+		/* process doesn't need to be stopped */
+		raid_bdev_process_base_bdev_remove_cont(ctx);
+		return;
+	}
+
+	assert(process->state > RAID_PROCESS_STATE_INIT &&
+	       process->state < RAID_PROCESS_STATE_STOPPED);
+
+	ret = raid_bdev_process_add_finish_action(process, raid_bdev_process_base_bdev_remove_cont, ctx);
+	if (ret != 0) {
+		raid_bdev_remove_base_bdev_done(ctx->base_info, ret);
+		free(ctx);
+		return;
+	}
+
+	process->state = RAID_PROCESS_STATE_STOPPING;
+
+	if (process->status == 0) {
+		process->status = -ENODEV;
+	}
+
+	raid_bdev_process_stop_throttled(process);
+}
+
+static int
+raid_bdev_process_base_bdev_remove(struct raid_bdev_process *process,
+				   struct raid_base_bdev_info *base_info)
+{
+	struct raid_bdev_process_base_bdev_remove_ctx *ctx;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	/*
+	 * We have to send the process and num_base_bdevs_operational in the message ctx
+	 * because the process thread should not access raid_bdev's properties. Particularly,
+	 * raid_bdev->process may be cleared by the time the message is handled, but ctx->process
+	 * will still be valid until the process is fully stopped.
+	 */
+	ctx->base_info = base_info;
+	ctx->process = process;
+	/*
+	 * raid_bdev->num_base_bdevs_operational can't be used here because it is decremented
+	 * after the removal and more than one base bdev may be removed at the same time
+	 */
+	RAID_FOR_EACH_BASE_BDEV(process->raid_bdev, base_info) {
+		if (base_info->is_configured && !base_info->remove_scheduled) {
+			ctx->num_base_bdevs_operational++;
+		}
+	}
+
+	spdk_thread_send_msg(process->thread, _raid_bdev_process_base_bdev_remove, ctx);
+
+	return 0;
+}
+
+static int
+_raid_bdev_remove_base_bdev(struct raid_base_bdev_info *base_info,
+			    raid_base_bdev_cb cb_fn, void *cb_ctx)
+{
+	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+	int ret = 0;
+
+	SPDK_DEBUGLOG(bdev_raid, "%s\n", base_info->name);
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	if (base_info->remove_scheduled || !base_info->is_configured) {
+		return -ENODEV;
+	}
+
+	assert(base_info->desc);
+	base_info->remove_scheduled = true;
+
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
+		/*
+		 * As raid bdev is not registered yet or already unregistered,
+		 * so cleanup should be done here itself.
+		 *
+		 * Removing a base bdev at this stage does not change the number of operational
+		 * base bdevs, only the number of discovered base bdevs.
+		 */
+		raid_bdev_free_base_bdev_resource(base_info);
+		base_info->remove_scheduled = false;
+		if (raid_bdev->num_base_bdevs_discovered == 0 &&
+		    raid_bdev->state == RAID_BDEV_STATE_OFFLINE) {
+			/* There is no base bdev for this raid, so free the raid device. */
+			raid_bdev_cleanup_and_free(raid_bdev);
+		}
+		if (cb_fn != NULL) {
+			cb_fn(cb_ctx, 0);
+		}
+	} else if (raid_bdev->min_base_bdevs_operational == raid_bdev->num_base_bdevs) {
+		/* This raid bdev does not tolerate removing a base bdev. */
+		raid_bdev->num_base_bdevs_operational--;
+		raid_bdev_deconfigure(raid_bdev, cb_fn, cb_ctx);
+	} else {
+		base_info->remove_cb = cb_fn;
+		base_info->remove_cb_ctx = cb_ctx;
+
+		if (raid_bdev->process != NULL) {
+			ret = raid_bdev_process_base_bdev_remove(raid_bdev->process, base_info);
+		} else {
+			ret = raid_bdev_remove_base_bdev_quiesce(base_info);
+		}
+
+		if (ret != 0) {
+			base_info->remove_scheduled = false;
+		}
+	}
+
+	return ret;
+}
+
+/*
+ * brief:
+ * raid_bdev_remove_base_bdev function is called by below layers when base_bdev
+ * is removed. This function checks if this base bdev is part of any raid bdev
+ * or not. If yes, it takes necessary action on that particular raid bdev.
+ * params:
+ * base_bdev - pointer to base bdev which got removed
+ * cb_fn - callback function
+ * cb_arg - argument to callback function
+ * returns:
+ * 0 - success
+ * non zero - failure
+ */
+int
+raid_bdev_remove_base_bdev(struct spdk_bdev *base_bdev, raid_base_bdev_cb cb_fn, void *cb_ctx)
+{
+	struct raid_base_bdev_info *base_info;
+
+	/* Find the raid_bdev which has claimed this base_bdev */
+	base_info = raid_bdev_find_base_info_by_bdev(base_bdev);
+	if (!base_info) {
+		SPDK_ERRLOG("bdev to remove '%s' not found\n", base_bdev->name);
+		return -ENODEV;
+	}
+
+	return _raid_bdev_remove_base_bdev(base_info, cb_fn, cb_ctx);
+}
+
+static void
+raid_bdev_fail_base_remove_cb(void *ctx, int status)
+{
+	struct raid_base_bdev_info *base_info = ctx;
+
+	if (status != 0) {
+		SPDK_WARNLOG("Failed to remove base bdev %s\n", base_info->name);
+		base_info->is_failed = false;
+	}
+}
+
+static void
+_raid_bdev_fail_base_bdev(void *ctx)
+{
+	struct raid_base_bdev_info *base_info = ctx;
+	int rc;
+
+	if (base_info->is_failed) {
+		return;
+	}
+	base_info->is_failed = true;
+
+	SPDK_NOTICELOG("Failing base bdev in slot %d ('%s') of raid bdev '%s'\n",
+		       raid_bdev_base_bdev_slot(base_info), base_info->name, base_info->raid_bdev->bdev.name);
+
+	rc = _raid_bdev_remove_base_bdev(base_info, raid_bdev_fail_base_remove_cb, base_info);
+	if (rc != 0) {
+		raid_bdev_fail_base_remove_cb(base_info, rc);
+	}
+}
+
+void
+raid_bdev_fail_base_bdev(struct raid_base_bdev_info *base_info)
+{
+	spdk_thread_exec_msg(spdk_thread_get_app_thread(), _raid_bdev_fail_base_bdev, base_info);
+}
+
+static void
+raid_bdev_resize_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+{
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock after resizing the bdev: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+	}
+}
+
+/*
+ * brief:
+ * raid_bdev_resize_base_bdev function is called by below layers when base_bdev
+ * is resized. This function checks if the smallest size of the base_bdevs is changed.
+ * If yes, call module handler to resize the raid_bdev if implemented.
+ * params:
+ * base_bdev - pointer to base bdev which got resized.
+ * returns:
+ * none
+ */
+static void
+raid_bdev_resize_base_bdev(struct spdk_bdev *base_bdev)
+{
+	struct raid_bdev *raid_bdev;
+	struct raid_base_bdev_info *base_info;
+	uint64_t blockcnt_old;
+
+	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_resize_base_bdev\n");
+
+	base_info = raid_bdev_find_base_info_by_bdev(base_bdev);
+
+	/* Find the raid_bdev which has claimed this base_bdev */
+	if (!base_info) {
+		SPDK_ERRLOG("raid_bdev whose base_bdev '%s' not found\n", base_bdev->name);
+		return;
+	}
+	raid_bdev = base_info->raid_bdev;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	SPDK_NOTICELOG("base_bdev '%s' was resized: old size %" PRIu64 ", new size %" PRIu64 "\n",
+		       base_bdev->name, base_info->blockcnt, base_bdev->blockcnt);
+
+	base_info->blockcnt = base_bdev->blockcnt;
+
+	if (!raid_bdev->module->resize) {
+		return;
+	}
+
+	if (raid_bdev->reshape.num_base_bdevs_old != 0) {
+		SPDK_NOTICELOG("raid bdev '%s' is being reshaped, not resizing\n", raid_bdev->bdev.name);
+		return;
+	}
+
+	blockcnt_old = raid_bdev->bdev.blockcnt;
+	if (raid_bdev->module->resize(raid_bdev) == false) {
+		return;
+	}
+
+	SPDK_NOTICELOG("raid bdev '%s': block count was changed from %" PRIu64 " to %" PRIu64 "\n",
+		       raid_bdev->bdev.name, blockcnt_old, raid_bdev->bdev.blockcnt);
+
+	if (raid_bdev->superblock_enabled) {
+		struct raid_bdev_superblock *sb = raid_bdev->sb;
+		uint8_t i;
+
+		for (i = 0; i < sb->base_bdevs_size; i++) {
+			struct raid_bdev_sb_base_bdev *sb_base_bdev = &sb->base_bdevs[i];
+
+			if (sb_base_bdev->state == RAID_SB_BASE_BDEV_CONFIGURED) {
+				base_info = &raid_bdev->base_bdev_info[sb_base_bdev->slot];
+				sb_base_bdev->data_size = base_info->data_size;
+			}
+		}
+		sb->raid_size = raid_bdev->bdev.blockcnt;
+		raid_bdev_write_superblock(raid_bdev, raid_bdev_resize_write_sb_cb, NULL);
+	}
+}
+
+/*
+ * brief:
+ * raid_bdev_event_base_bdev function is called by below layers when base_bdev
+ * triggers asynchronous event.
+ * params:
+ * type - event details.
+ * bdev - bdev that triggered event.
+ * event_ctx - context for event.
+ * returns:
+ * none
+ */
+static void
+raid_bdev_event_base_bdev(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+			  void *event_ctx)
+{
+	int rc;
+
+	switch (type) {
+	case SPDK_BDEV_EVENT_REMOVE:
+		rc = raid_bdev_remove_base_bdev(bdev, NULL, NULL);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to remove base bdev %s: %s\n",
+				    spdk_bdev_get_name(bdev), spdk_strerror(-rc));
+		}
+		break;
+	case SPDK_BDEV_EVENT_RESIZE:
+		raid_bdev_resize_base_bdev(bdev);
+		break;
+	default:
+		SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
+		break;
+	}
+}
+
+/*
+ * brief:
+ * Deletes the specified raid bdev
+ * params:
+ * raid_bdev - pointer to raid bdev
+ * cb_fn - callback function
+ * cb_arg - argument to callback function
+ */
+void
+raid_bdev_delete(struct raid_bdev *raid_bdev, raid_bdev_destruct_cb cb_fn, void *cb_arg)
+{
+	struct raid_base_bdev_info *base_info;
+
+	SPDK_DEBUGLOG(bdev_raid, "delete raid bdev: %s\n", raid_bdev->bdev.name);
+
+	if (raid_bdev->destroy_started) {
+		SPDK_DEBUGLOG(bdev_raid, "destroying raid bdev %s is already started\n",
+			      raid_bdev->bdev.name);
+		if (cb_fn) {
+			cb_fn(cb_arg, -EALREADY);
+		}
+		return;
+	}
+
+	raid_bdev->destroy_started = true;
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		base_info->remove_scheduled = true;
+
+		if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
+			/*
+			 * As raid bdev is not registered yet or already unregistered,
+			 * so cleanup should be done here itself.
+			 */
+			raid_bdev_free_base_bdev_resource(base_info);
+		}
+	}
+
+	if (raid_bdev->num_base_bdevs_discovered == 0) {
+		/* There is no base bdev for this raid, so free the raid device. */
+		raid_bdev_cleanup_and_free(raid_bdev);
+		if (cb_fn) {
+			cb_fn(cb_arg, 0);
+		}
+	} else {
+		raid_bdev_deconfigure(raid_bdev, cb_fn, cb_arg);
+	}
+}
+
+static void
+raid_bdev_process_finish_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+{
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock after background process finished: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+	}
+}
+
+static void
+raid_bdev_process_finish_write_sb(void *ctx)
+{
+	struct raid_bdev *raid_bdev = ctx;
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	struct raid_bdev_sb_base_bdev *sb_base_bdev;
+	struct raid_base_bdev_info *base_info;
+	uint8_t i;
+
+	for (i = 0; i < sb->base_bdevs_size; i++) {
+		sb_base_bdev = &sb->base_bdevs[i];
+
+		if (sb_base_bdev->state != RAID_SB_BASE_BDEV_CONFIGURED &&
+		    sb_base_bdev->slot < raid_bdev->num_base_bdevs) {
+			base_info = &raid_bdev->base_bdev_info[sb_base_bdev->slot];
+			if (base_info->is_configured) {
+				sb_base_bdev->state = RAID_SB_BASE_BDEV_CONFIGURED;
+				spdk_uuid_copy(&sb_base_bdev->uuid, &base_info->uuid);
+			}
+		}
+	}
+
+	raid_bdev_write_superblock(raid_bdev, raid_bdev_process_finish_write_sb_cb, NULL);
+
+	if (raid_bdev->bitmap != NULL) {
+		/* Make sure the bitmap is also stored on the base bdevs which were just added */
+		raid_bdev_bitmap_schedule_write(raid_bdev->bitmap);
+	}
+}
+
+static void raid_bdev_process_free(struct raid_bdev_process *process);
+
+static void
+_raid_bdev_process_finish_done(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+	struct raid_process_finish_action *finish_action;
+
+	while ((finish_action = TAILQ_FIRST(&process->finish_actions)) != NULL) {
+		TAILQ_REMOVE(&process->finish_actions, finish_action, link);
+		finish_action->cb(finish_action->cb_ctx);
+		free(finish_action);
+	}
+
+	raid_bdev_process_free(process);
+
+	spdk_thread_exit(spdk_get_thread());
+}
+
+static void
+raid_bdev_process_finish_target_removed(void *ctx, int status)
+{
+	struct raid_bdev_process *process = ctx;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to remove target bdev: %s\n", spdk_strerror(-status));
+	}
+
+	spdk_thread_send_msg(process->thread, _raid_bdev_process_finish_done, process);
+}
+
+static void
+raid_bdev_process_finish_unquiesced(void *ctx, int status)
+{
+	struct raid_bdev_process *process = ctx;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to unquiesce bdev: %s\n", spdk_strerror(-status));
+	}
+
+	if (process->status != 0 && process->target != NULL) {
+		status = _raid_bdev_remove_base_bdev(process->target, raid_bdev_process_finish_target_removed,
+						     process);
+		if (status != 0) {
+			raid_bdev_process_finish_target_removed(process, status);
+		}
+		return;
+	}
+
+	spdk_thread_send_msg(process->thread, _raid_bdev_process_finish_done, process);
+}
+
+static void
+raid_bdev_process_finish_unquiesce(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+	int rc;
+
+	rc = spdk_bdev_unquiesce(&process->raid_bdev->bdev, &g_raid_if,
+				 raid_bdev_process_finish_unquiesced, process);
+	if (rc != 0) {
+		raid_bdev_process_finish_unquiesced(process, rc);
+	}
+}
+
+static void
+raid_bdev_process_finish_done(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+
+	if (process->raid_ch != NULL) {
+		spdk_put_io_channel(spdk_io_channel_from_ctx(process->raid_ch));
+	}
+
+	process->state = RAID_PROCESS_STATE_STOPPED;
+
+	if (process->status == 0) {
+		SPDK_NOTICELOG("Finished %s on raid bdev %s\n",
+			       raid_bdev_process_to_str(process->type),
+			       raid_bdev->bdev.name);
+		if (raid_bdev->superblock_enabled) {
+			spdk_thread_send_msg(spdk_thread_get_app_thread(),
+					     raid_bdev_process_finish_write_sb,
+					     raid_bdev);
+		}
+	} else {
+		SPDK_WARNLOG("Finished %s on raid bdev %s: %s\n",
+			     raid_bdev_process_to_str(process->type),
+			     raid_bdev->bdev.name,
+			     spdk_strerror(-process->status));
+	}
+
+	spdk_thread_send_msg(spdk_thread_get_app_thread(), raid_bdev_process_finish_unquiesce,
+			     process);
+}
+
+static void
+__raid_bdev_process_finish(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+
+	spdk_thread_send_msg(process->thread, raid_bdev_process_finish_done, process);
+}
+
+static void
+raid_bdev_channel_process_finish(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+
+	if (process->status == 0 && process->target != NULL) {
+		uint8_t slot = raid_bdev_base_bdev_slot(process->target);
+
+		raid_ch->base_channel[slot] = raid_ch->process.target_ch;
+		raid_ch->process.target_ch = NULL;
+	}
+
+	if (process->type == RAID_PROCESS_RESHAPE) {
+		if (process->status != 0) {
+			/* Keep using the new layout for the data that was already moved */
+			spdk_for_each_channel_continue(i, 0);
+			return;
+		}
+		raid_ch->num_base_bdevs = process->raid_bdev->num_base_bdevs;
+	}
+
+	raid_bdev_ch_process_cleanup(raid_ch);
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+/*
+ * Makes the base bdevs added by a reshape part of the raid bdev data layout and grows the raid
+ * bdev. Must be called with the raid bdev quiesced.
+ */
+static int
+raid_bdev_reshape_complete(struct raid_bdev *raid_bdev)
+{
+	uint64_t blockcnt_old = raid_bdev->bdev.blockcnt;
+	uint64_t blockcnt;
+	int rc;
+
+	rc = raid_bdev->module->reshape(raid_bdev, &blockcnt);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to reshape raid bdev '%s': %s\n", raid_bdev->bdev.name,
+			    spdk_strerror(-rc));
+		return rc;
+	}
+
+	rc = spdk_bdev_notify_blockcnt_change(&raid_bdev->bdev, blockcnt);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to notify blockcount change\n");
+	} else {
+		SPDK_NOTICELOG("raid bdev '%s': block count was changed from %" PRIu64 " to %" PRIu64 "\n",
+			       raid_bdev->bdev.name, blockcnt_old, raid_bdev->bdev.blockcnt);
+	}
+
+	raid_bdev->reshape.num_base_bdevs_old = 0;
+	raid_bdev->reshape.restriping = false;
+	raid_bdev->reshape.offset = 0;
+
+	if (raid_bdev->superblock_enabled) {
+		raid_bdev->sb->raid_size = raid_bdev->bdev.blockcnt;
+		raid_bdev->sb->reshape_num_base_bdevs = 0;
+		raid_bdev->sb->reshape_offset = 0;
+	}
+
+	return 0;
+}
+
+static void
+raid_bdev_process_finish_quiesced(void *ctx, int status)
+{
+	struct raid_bdev_process *process = ctx;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to quiesce bdev: %s\n", spdk_strerror(-status));
+		return;
+	}
+
+	raid_bdev->process = NULL;
+	if (process->target != NULL) {
+		process->target->is_process_target = false;
+	}
+	if (process->type == RAID_PROCESS_RESYNC) {
+		if (process->status == 0) {
+			raid_bdev->bitmap->needs_resync = false;
+		}
+		spdk_poller_resume(raid_bdev->bitmap->clean_poller);
+	} else if (process->type == RAID_PROCESS_RESHAPE && process->status == 0) {
+		process->status = raid_bdev_reshape_complete(raid_bdev);
+	} else if (process->type == RAID_PROCESS_SCRUB) {
+		raid_bdev->scrub.running = false;
+		raid_bdev->scrub.status = process->status;
+	}
+
+	spdk_for_each_channel(process->raid_bdev, raid_bdev_channel_process_finish, process,
+			      __raid_bdev_process_finish);
+}
+
+static void
+_raid_bdev_process_finish(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+	int rc;
+
+	rc = spdk_bdev_quiesce(&process->raid_bdev->bdev, &g_raid_if,
+			       raid_bdev_process_finish_quiesced, process);
+	if (rc != 0) {
+		raid_bdev_process_finish_quiesced(ctx, rc);
+	}
+}
+
+static void
+raid_bdev_process_do_finish(struct raid_bdev_process *process)
+{
+	spdk_thread_send_msg(spdk_thread_get_app_thread(), _raid_bdev_process_finish, process);
+}
+
+static void raid_bdev_process_unlock_window_range(struct raid_bdev_process *process);
+
+static void
+raid_bdev_process_finish(struct raid_bdev_process *process, int status)
+{
+	assert(spdk_get_thread() == process->thread);
+
+	if (process->status == 0) {
+		process->status = status;
+	}
+
+	if (process->state >= RAID_PROCESS_STATE_STOPPING) {
+		return;
+	}
+
+	assert(process->state == RAID_PROCESS_STATE_RUNNING);
+	process->state = RAID_PROCESS_STATE_STOPPING;
+
+	if (process->window_range_locked) {
+		raid_bdev_process_unlock_window_range(process);
+	} else {
+		raid_bdev_process_thread_run(process);
+	}
+}
+
+static void
+raid_bdev_process_window_range_unlocked(void *ctx, int status)
+{
+	struct raid_bdev_process *process = ctx;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to unlock LBA range: %s\n", spdk_strerror(-status));
+		raid_bdev_process_finish(process, status);
+		return;
+	}
+
+	process->window_range_locked = false;
+	process->window_offset += process->window_size;
+
+	raid_bdev_process_thread_run(process);
+}
+
+static void
+raid_bdev_process_unlock_window_range(struct raid_bdev_process *process)
+{
+	int rc;
+
+	assert(process->window_range_locked == true);
+
+	rc = spdk_bdev_unquiesce_range(&process->raid_bdev->bdev, &g_raid_if,
+				       process->window_offset, process->window_range_size,
+				       raid_bdev_process_window_range_unlocked, process);
+	if (rc != 0) {
+		raid_bdev_process_window_range_unlocked(process, rc);
+	}
+}
+
+static void
+raid_bdev_process_channels_update_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+
+	raid_bdev_process_unlock_window_range(process);
+}
+
+static void
+raid_bdev_process_channel_update(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+
+	if (process->target != NULL || process->type == RAID_PROCESS_RESHAPE) {
+		raid_ch->process.offset = process->window_offset + process->window_size;
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+raid_bdev_process_update_channels(struct raid_bdev_process *process)
+{
+	spdk_for_each_channel(process->raid_bdev, raid_bdev_process_channel_update, process,
+			      raid_bdev_process_channels_update_done);
+}
+
+static void
+raid_bdev_reshape_progress_saved(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+
+	if (process->window_status != 0) {
+		raid_bdev_process_finish(process, process->window_status);
+		return;
+	}
+
+	raid_bdev_process_update_channels(process);
+}
+
+static void
+raid_bdev_reshape_save_progress_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock with reshape progress: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+		process->window_status = status;
+	}
+
+	spdk_thread_send_msg(process->thread, raid_bdev_reshape_progress_saved, process);
+}
+
+static void
+raid_bdev_reshape_save_progress(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+
+	raid_bdev->reshape.offset = process->window_offset + process->window_size;
+	raid_bdev->sb->reshape_offset = raid_bdev->reshape.offset;
+
+	raid_bdev_write_superblock(raid_bdev, raid_bdev_reshape_save_progress_cb, process);
+}
+
+/*
+ * Adjusts the window size to the load of the base bdevs. The latency of the process requests is
+ * compared to the latency observed when the base bdevs were idle. While it stays close to it, the
+ * window grows to get more requests in flight. When it gets much higher, other I/O is competing
+ * for the base bdevs, so the window shrinks and eventually the process pauses between windows.
+ */
+static void
+raid_bdev_process_window_adapt(struct raid_bdev_process *process)
+{
+	uint64_t now = spdk_get_ticks();
+	uint64_t latency, baseline;
+
+	if (!process->adaptive) {
+		process->window_scale = 1;
+		return;
+	}
+
+	assert(process->window_num_requests > 0);
+	latency = process->window_latency_ticks / process->window_num_requests;
+	baseline = process->baseline_latency_ticks;
+
+	if (baseline == 0 || latency < baseline) {
+		baseline = latency;
+	} else {
+		/* Slowly follow a lasting change of the base bdevs' performance */
+		baseline += spdk_max(baseline / 256, 1);
+	}
+	process->baseline_latency_ticks = baseline;
+
+	if (latency <= baseline + baseline / 4) {
+		process->window_scale = spdk_min(process->window_scale + 1,
+						 RAID_BDEV_PROCESS_MAX_WINDOW_SCALE);
+	} else if (latency > baseline * 2) {
+		if (process->window_scale > 1) {
+			process->window_scale /= 2;
+		} else {
+			/* Leave the base bdevs to the other I/O for as long as the window took */
+			process->throttle_tsc = spdk_max(process->throttle_tsc,
+							 now + (now - process->window_start_tsc));
+		}
+	}
+}
+
+static void raid_bdev_process_request_resubmit(void *ctx);
+
+void
+raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	struct raid_bdev_process *process = process_req->process;
+
+	assert(spdk_get_thread() == process->thread);
+	assert(process->window_remaining >= process_req->num_blocks);
+
+	if (status == -ENOMEM) {
+		/* The module ran out of resources, retry when another request releases them */
+		TAILQ_INSERT_TAIL(&process->nomem_requests, process_req, link);
+		process->nomem_blocks += process_req->num_blocks;
+		if (process->nomem_blocks == process->window_remaining) {
+			/* No request is in flight to do it */
+			spdk_thread_send_msg(process->thread, raid_bdev_process_request_resubmit, process);
+		}
+		return;
+	}
+
+	TAILQ_INSERT_TAIL(&process->requests, process_req, link);
+
+	if (status != 0) {
+		process->window_status = status;
+	}
+
+	if (process->type == RAID_PROCESS_SCRUB) {
+		struct raid_bdev *raid_bdev = process->raid_bdev;
+
+		raid_bdev->scrub.mismatched_blocks += process_req->scrub.mismatched_blocks;
+		raid_bdev->scrub.read_error_blocks += process_req->scrub.read_error_blocks;
+		raid_bdev->scrub.repaired_blocks += process_req->scrub.repaired_blocks;
+	}
+
+	process->window_latency_ticks += (spdk_get_ticks() - process->window_start_tsc) /
+					 process_req->num_blocks;
+	process->window_remaining -= process_req->num_blocks;
+	if (process->window_remaining == 0) {
+		if (process->window_status != 0) {
+			raid_bdev_process_finish(process, process->window_status);
+			return;
+		}
+
+		raid_bdev_process_window_adapt(process);
+
+		if (process->type == RAID_PROCESS_RESHAPE) {
+			/*
+			 * The next window may overwrite the old location of the data just moved, so
+			 * the progress must be persisted first to be able to resume after a crash.
+			 */
+			spdk_thread_send_msg(spdk_thread_get_app_thread(), raid_bdev_reshape_save_progress,
+					     process);
+			return;
+		}
+
+		raid_bdev_process_update_channels(process);
+	} else if (!TAILQ_EMPTY(&process->nomem_requests)) {
+		raid_bdev_process_request_resubmit(process);
+	}
+}
+
+static uint32_t
+raid_bdev_io_boundary(struct raid_bdev *raid_bdev, enum spdk_bdev_io_type type)
+{
+	/* Same rules as used by the bdev layer for splitting I/O submitted to the raid bdev */
+	if (type == SPDK_BDEV_IO_TYPE_WRITE && raid_bdev->bdev.split_on_write_unit) {
+		return raid_bdev->bdev.write_unit_size;
+	} else if (raid_bdev->bdev.split_on_optimal_io_boundary) {
+		return raid_bdev->bdev.optimal_io_boundary;
+	}
+
+	return 0;
+}
+
+static void raid_bdev_resync_submit(struct raid_bdev_process_request *process_req);
+
+static void
+raid_bdev_resync_completed(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
+{
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+
+	if (status != SPDK_BDEV_IO_STATUS_SUCCESS) {
+		raid_bdev_process_request_complete(process_req,
+						   status == SPDK_BDEV_IO_STATUS_NOMEM ? -ENOMEM : -EIO);
+		return;
+	}
+
+	process_req->resync.offset_blocks += process_req->resync.num_blocks;
+	if (process_req->resync.offset_blocks == process_req->offset_blocks + process_req->num_blocks) {
+		if (process_req->resync.type == SPDK_BDEV_IO_TYPE_WRITE) {
+			raid_bdev_process_request_complete(process_req, 0);
+			return;
+		}
+
+		/* Write the data back through the raid module to make all base bdevs consistent */
+		process_req->resync.type = SPDK_BDEV_IO_TYPE_WRITE;
+		process_req->resync.offset_blocks = process_req->offset_blocks;
+	}
+
+	raid_bdev_resync_submit(process_req);
+}
+
+static void
+raid_bdev_resync_submit(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev_process *process = process_req->process;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	struct raid_bdev_io_channel *raid_ch = process->raid_ch;
+	uint64_t offset_blocks = process_req->resync.offset_blocks;
+	uint64_t buf_offset = offset_blocks - process_req->offset_blocks;
+	uint64_t num_blocks = process_req->num_blocks - buf_offset;
+	uint32_t io_boundary = raid_bdev_io_boundary(raid_bdev, process_req->resync.type);
+	void *md_buf = NULL;
+
+	if (io_boundary != 0) {
+		num_blocks = spdk_min(num_blocks, io_boundary - offset_blocks % io_boundary);
+	}
+
+	process_req->resync.num_blocks = num_blocks;
+	process_req->resync.iov.iov_base = process_req->iov.iov_base +
+					   buf_offset * raid_bdev->bdev.blocklen;
+	process_req->resync.iov.iov_len = num_blocks * raid_bdev->bdev.blocklen;
+	if (process_req->md_buf != NULL) {
+		md_buf = process_req->md_buf + buf_offset * raid_bdev->bdev.md_len;
+	}
+
+	raid_bdev_io_init(raid_io, raid_ch, process_req->resync.type, offset_blocks,
+			  num_blocks, &process_req->resync.iov, 1, md_buf, NULL, NULL);
+	raid_io->completion_cb = raid_bdev_resync_completed;
+
+	if (process->type == RAID_PROCESS_RESHAPE &&
+	    process_req->resync.type == SPDK_BDEV_IO_TYPE_WRITE) {
+		/* Write the data to its location in the new layout */
+		raid_io->raid_ch = raid_ch->process.ch_processed;
+	}
+
+	raid_bdev->module->submit_rw_request(raid_io);
+}
+
+static void
+_raid_bdev_resync_submit(void *ctx)
+{
+	raid_bdev_resync_submit(ctx);
+}
+
+/*
+ * Resync a range by reading it and writing it back through the raid module, which
+ * updates all mirrors or parity. This works for any raid module with redundancy.
+ * Reshape moves the data the same way, reading it in the old layout and writing it in
+ * the new one.
+ */
+static int
+raid_bdev_submit_resync_request(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev *raid_bdev = process_req->process->raid_bdev;
+	uint32_t io_boundary = raid_bdev_io_boundary(raid_bdev, SPDK_BDEV_IO_TYPE_WRITE);
+	uint64_t num_blocks = process_req->num_blocks;
+
+	/* Submit one write unit per request to have several of them in flight */
+	if (io_boundary != 0) {
+		num_blocks = spdk_min(num_blocks, io_boundary - process_req->offset_blocks % io_boundary);
+	}
+
+	if (raid_bdev->bdev.split_on_write_unit && num_blocks < raid_bdev->bdev.write_unit_size) {
+		return 0;
+	}
+
+	process_req->num_blocks = num_blocks;
+	process_req->resync.type = SPDK_BDEV_IO_TYPE_READ;
+	process_req->resync.offset_blocks = process_req->offset_blocks;
+
+	/* The process request must not complete before this function returns */
+	spdk_thread_send_msg(spdk_get_thread(), _raid_bdev_resync_submit, process_req);
+
+	return num_blocks;
+}
+
+static int
+raid_bdev_process_request_submit(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev_process *process = process_req->process;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+
+	process_req->iov.iov_len = process_req->num_blocks * raid_bdev->bdev.blocklen;
+
+	if (process->type == RAID_PROCESS_RESYNC || process->type == RAID_PROCESS_RESHAPE) {
+		return raid_bdev_submit_resync_request(process_req);
+	} else if (process->type == RAID_PROCESS_SCRUB) {
+		process_req->scrub.repair = raid_bdev->scrub.repair;
+		process_req->scrub.iov.iov_len = process_req->iov.iov_len;
+		process_req->scrub.mismatched_blocks = 0;
+		process_req->scrub.read_error_blocks = 0;
+		process_req->scrub.repaired_blocks = 0;
+		return raid_bdev->module->submit_scrub_request(process_req, process->raid_ch);
+	} else {
+		return raid_bdev->module->submit_process_request(process_req, process->raid_ch);
+	}
+}
+
+static void
+raid_bdev_process_request_resubmit(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+	struct raid_bdev_process_request *process_req;
+	uint32_t num_blocks;
+	int ret;
+
+	process_req = TAILQ_FIRST(&process->nomem_requests);
+	assert(process_req != NULL);
+	TAILQ_REMOVE(&process->nomem_requests, process_req, link);
+	process->nomem_blocks -= process_req->num_blocks;
+
+	/* The request is submitted again from the start, with the same range */
+	num_blocks = process_req->num_blocks;
+	ret = raid_bdev_process_request_submit(process_req);
+	if (spdk_unlikely(ret != (int)num_blocks)) {
+		SPDK_ERRLOG("Failed to resubmit process request on %s: %s\n",
+			    process->raid_bdev->bdev.name, spdk_strerror(ret < 0 ? -ret : EIO));
+		process_req->num_blocks = num_blocks;
+		raid_bdev_process_request_complete(process_req,
+						   ret < 0 && ret != -ENOMEM ? ret : -EIO);
+	}
+}
+
+static int
+raid_bdev_submit_process_request(struct raid_bdev_process *process, uint64_t offset_blocks,
+				 uint32_t num_blocks)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_bdev_process_request *process_req;
+	int ret;
+
+	process_req = TAILQ_FIRST(&process->requests);
+	if (process_req == NULL) {
+		assert(process->window_remaining > 0);
+		return 0;
+	}
+
+	process_req->target = process->target;
+	process_req->target_ch = process->raid_ch->process.target_ch;
+	process_req->offset_blocks = offset_blocks;
+	process_req->num_blocks = num_blocks;
+
+	ret = raid_bdev_process_request_submit(process_req);
+	if (ret == -ENOMEM && process->window_remaining > 0) {
+		/* The window ends here, the module gets its resources back as the requests complete */
+		return 0;
+	}
+	if (ret <= 0) {
+		if (ret < 0) {
+			SPDK_ERRLOG("Failed to submit process request on %s: %s\n",
+				    raid_bdev->bdev.name, spdk_strerror(-ret));
+			process->window_status = ret;
+		}
+		return ret;
+	}
+
+	process_req->num_blocks = ret;
+	TAILQ_REMOVE(&process->requests, process_req, link);
+
+	return ret;
+}
+
+static void
+raid_bdev_process_throttle(struct raid_bdev_process *process)
+{
+	uint64_t ticks_hz = spdk_get_ticks_hz();
+	uint64_t bytes = process->window_size * process->raid_bdev->bdev.blocklen;
+	uint64_t ticks = 0;
+
+	if (process->max_mbytes_per_sec != 0) {
+		ticks = bytes * ticks_hz / ((uint64_t)process->max_mbytes_per_sec * 1024 * 1024);
+	}
+
+	if (process->max_ios_per_sec != 0) {
+		ticks = spdk_max(ticks, process->window_num_requests * ticks_hz /
+				 process->max_ios_per_sec);
+	}
+
+	if (ticks != 0) {
+		process->throttle_tsc = spdk_max(process->throttle_tsc, process->window_start_tsc) + ticks;
+	}
+}
+
+static void
+_raid_bdev_process_thread_run(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	uint64_t offset = process->window_offset;
+	uint64_t offset_end;
+	int ret;
+
+	offset_end = offset + spdk_min(process->window_range_size,
+				       process->max_window_size * process->window_scale);
+
+	if (process->use_bitmap) {
+		bool dirty;
+		/* Check again now that no writes can mark regions in the window dirty */
+		uint64_t run_blocks = raid_bdev_bitmap_get_run(raid_bdev->bitmap, offset, &dirty);
+
+		if (!dirty) {
+			/* Skip the clean regions */
+			process->window_size = spdk_min(run_blocks, process->window_range_size);
+			raid_bdev_process_update_channels(process);
+			return;
+		}
+		offset_end = spdk_min(offset_end, offset + run_blocks);
+	}
+
+	process->window_start_tsc = spdk_get_ticks();
+	process->window_latency_ticks = 0;
+	process->window_num_requests = 0;
+
+	while (offset < offset_end) {
+		ret = raid_bdev_submit_process_request(process, offset,
+						       spdk_min(offset_end - offset, process->max_window_size));
+		if (ret <= 0) {
+			break;
+		}
+
+		process->window_remaining += ret;
+		process->window_num_requests++;
+		offset += ret;
+	}
+
+	if (process->window_remaining > 0) {
+		process->window_size = process->window_remaining;
+		raid_bdev_process_throttle(process);
+	} else {
+		raid_bdev_process_finish(process, process->window_status);
+	}
+}
+
+static void
+raid_bdev_process_window_range_locked(void *ctx, int status)
+{
+	struct raid_bdev_process *process = ctx;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to lock LBA range: %s\n", spdk_strerror(-status));
+		raid_bdev_process_finish(process, status);
+		return;
+	}
+
+	process->window_range_locked = true;
+
+	if (process->state == RAID_PROCESS_STATE_STOPPING) {
+		raid_bdev_process_unlock_window_range(process);
+		return;
+	}
+
+	_raid_bdev_process_thread_run(process);
+}
+
+static int
+raid_bdev_process_throttle_poller(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+
+	raid_bdev_process_thread_run(process);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+raid_bdev_process_thread_run(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	uint64_t now;
+	int rc;
+
+	assert(spdk_get_thread() == process->thread);
+	assert(process->window_remaining == 0);
+	assert(process->window_range_locked == false);
+
+	spdk_poller_unregister(&process->throttle_poller);
+
+	if (process->state == RAID_PROCESS_STATE_STOPPING) {
+		raid_bdev_process_do_finish(process);
+		return;
+	}
+
+	if (process->window_offset == raid_bdev->bdev.blockcnt) {
+		SPDK_DEBUGLOG(bdev_raid, "process completed on %s\n", raid_bdev->bdev.name);
+		raid_bdev_process_finish(process, 0);
+		return;
+	}
+
+	now = spdk_get_ticks();
+	if (now < process->throttle_tsc) {
+		process->throttle_poller = SPDK_POLLER_REGISTER(raid_bdev_process_throttle_poller, process,
+					   (process->throttle_tsc - now) * SPDK_SEC_TO_USEC / spdk_get_ticks_hz());
+		if (process->throttle_poller != NULL) {
+			return;
+		}
+	}
+
+	process->window_range_size = spdk_min(raid_bdev->bdev.blockcnt - process->window_offset,
+					      process->max_window_size * process->window_scale);
+	if (process->type == RAID_PROCESS_RESHAPE) {
+		process->window_range_size = raid_bdev->module->reshape_window_size(raid_bdev,
+					     process->window_offset, process->window_range_size);
+	}
+	if (process->use_bitmap) {
+		bool dirty;
+		uint64_t run_blocks = raid_bdev_bitmap_get_run(raid_bdev->bitmap, process->window_offset,
+				      &dirty);
+
+		if (dirty) {
+			process->window_range_size = spdk_min(process->window_range_size, run_blocks);
+		} else {
+			/* The whole clean run is quiesced at once and skipped */
+			process->window_range_size = run_blocks;
+		}
+	}
+
+	rc = spdk_bdev_quiesce_range(&raid_bdev->bdev, &g_raid_if,
+				     process->window_offset, process->window_range_size,
+				     raid_bdev_process_window_range_locked, process);
+	if (rc != 0) {
+		raid_bdev_process_window_range_locked(process, rc);
+	}
+}
+
+static void
+raid_bdev_process_thread_init(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct spdk_io_channel *ch;
+
+	process->thread = spdk_get_thread();
+
+	ch = spdk_get_io_channel(raid_bdev);
+	if (ch == NULL) {
+		process->status = -ENOMEM;
+		raid_bdev_process_do_finish(process);
+		return;
+	}
+
+	process->raid_ch = spdk_io_channel_get_ctx(ch);
+	process->state = RAID_PROCESS_STATE_RUNNING;
+
+	SPDK_NOTICELOG("Started %s on raid bdev %s\n",
+		       raid_bdev_process_to_str(process->type), raid_bdev->bdev.name);
+
+	raid_bdev_process_thread_run(process);
+}
+
+static void
+raid_bdev_channels_abort_start_process_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+
+	if (process->target != NULL) {
+		_raid_bdev_remove_base_bdev(process->target, NULL, NULL);
+	} else if (process->type == RAID_PROCESS_RESYNC) {
+		spdk_poller_resume(process->raid_bdev->bitmap->clean_poller);
+	} else if (process->type == RAID_PROCESS_RESHAPE) {
+		SPDK_WARNLOG("Reshape of raid bdev '%s' stopped at offset %" PRIu64 "\n",
+			     process->raid_bdev->bdev.name, process->raid_bdev->reshape.offset);
+	}
+	raid_bdev_process_free(process);
+
+	/* TODO: update sb */
+}
+
+static void
+raid_bdev_channel_abort_start_process(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+
+	if (process->type != RAID_PROCESS_RESHAPE) {
+		/* The reshape setup of the channels remains valid at the current offset */
+		raid_bdev_ch_process_cleanup(raid_ch);
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+raid_bdev_channels_start_process_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct spdk_thread *thread;
+	char thread_name[RAID_BDEV_SB_NAME_SIZE + 16];
+
+	if (status == 0 && process->target != NULL &&
+	    (process->target->remove_scheduled || !process->target->is_configured ||
+	     raid_bdev->num_base_bdevs_operational <= raid_bdev->min_base_bdevs_operational)) {
+		/* a base bdev was removed before we got here */
+		status = -ENODEV;
+	}
+
+	if (status == 0 && process->target == NULL && !raid_bdev_base_bdevs_in_sync(raid_bdev)) {
+		/* Resync and reshape need all base bdevs */
+		status = -ENODEV;
+	}
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to start %s on %s: %s\n",
+			    raid_bdev_process_to_str(process->type), raid_bdev->bdev.name,
+			    spdk_strerror(-status));
+		goto err;
+	}
+
+	snprintf(thread_name, sizeof(thread_name), "%s_%s",
+		 raid_bdev->bdev.name, raid_bdev_process_to_str(process->type));
+
+	thread = spdk_thread_create(thread_name, NULL);
+	if (thread == NULL) {
+		SPDK_ERRLOG("Failed to create %s thread for %s\n",
+			    raid_bdev_process_to_str(process->type), raid_bdev->bdev.name);
+		status = -ENOMEM;
+		goto err;
+	}
+
+	/* Set before the process is visible, so that messages can be sent to its thread */
+	process->thread = thread;
+	raid_bdev->process = process;
+
+	spdk_thread_send_msg(thread, raid_bdev_process_thread_init, process);
+
+	return;
+err:
+	if (process->type == RAID_PROCESS_SCRUB) {
+		raid_bdev->scrub.running = false;
+		raid_bdev->scrub.status = status;
+	}
+	spdk_for_each_channel(process->raid_bdev, raid_bdev_channel_abort_start_process, process,
+			      raid_bdev_channels_abort_start_process_done);
+}
+
+static void
+raid_bdev_channel_start_process(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	int rc;
+
+	rc = raid_bdev_ch_process_setup(raid_ch, process);
+
+	spdk_for_each_channel_continue(i, rc);
+}
+
+static void
+raid_bdev_process_start(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+
+	assert(raid_bdev->module->submit_process_request != NULL ||
+	       process->type == RAID_PROCESS_RESHAPE || process->type == RAID_PROCESS_SCRUB);
+	assert(raid_bdev->module->submit_scrub_request != NULL ||
+	       process->type != RAID_PROCESS_SCRUB);
+
+	spdk_for_each_channel(raid_bdev, raid_bdev_channel_start_process, process,
+			      raid_bdev_channels_start_process_done);
+}
+
+static void
+raid_bdev_process_request_free(struct raid_bdev_process_request *process_req)
+{
+	spdk_dma_free(process_req->iov.iov_base);
+	spdk_dma_free(process_req->md_buf);
+	free(process_req);
+}
+
+static struct raid_bdev_process_request *
+raid_bdev_process_alloc_request(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_bdev_process_request *process_req;
+	/* Scrub requests get a second buffer for comparing the data */
+	uint32_t num_bufs = process->type == RAID_PROCESS_SCRUB ? 2 : 1;
+
+	process_req = calloc(1, sizeof(*process_req));
+	if (process_req == NULL) {
+		return NULL;
+	}
+
+	process_req->process = process;
+	process_req->iov.iov_len = process->max_window_size * raid_bdev->bdev.blocklen;
+	process_req->iov.iov_base = spdk_dma_malloc(process_req->iov.iov_len * num_bufs, 4096, 0);
+	if (process_req->iov.iov_base == NULL) {
+		free(process_req);
+		return NULL;
+	}
+	if (spdk_bdev_is_md_separate(&raid_bdev->bdev)) {
+		process_req->md_buf = spdk_dma_malloc(process->max_window_size * raid_bdev->bdev.md_len *
+						      num_bufs, 4096, 0);
+		if (process_req->md_buf == NULL) {
+			raid_bdev_process_request_free(process_req);
+			return NULL;
+		}
+	}
+	if (num_bufs > 1) {
+		process_req->scrub.iov.iov_base = process_req->iov.iov_base + process_req->iov.iov_len;
+		if (process_req->md_buf != NULL) {
+			process_req->scrub.md_buf = process_req->md_buf +
+						    process->max_window_size * raid_bdev->bdev.md_len;
+		}
+	}
+
+	return process_req;
+}
+
+static void
+raid_bdev_process_free(struct raid_bdev_process *process)
+{
+	struct raid_bdev_process_request *process_req;
+
+	while ((process_req = TAILQ_FIRST(&process->requests)) != NULL) {
+		TAILQ_REMOVE(&process->requests, process_req, link);
+		raid_bdev_process_request_free(process_req);
+	}
+
+	free(process);
+}
+
+static struct raid_bdev_process *
+raid_bdev_process_alloc(struct raid_bdev *raid_bdev, enum raid_process_type type,
+			struct raid_base_bdev_info *target)
+{
+	struct raid_bdev_process *process;
+	struct raid_bdev_process_request *process_req;
+	int i;
+
+	process = calloc(1, sizeof(*process));
+	if (process == NULL) {
+		return NULL;
+	}
+
+	process->raid_bdev = raid_bdev;
+	process->type = type;
+	process->target = target;
+	process->window_scale = 1;
+	process->max_window_size = spdk_max(spdk_divide_round_up(g_opts.process_window_size_kb * 1024UL,
+					    spdk_bdev_get_data_block_size(&raid_bdev->bdev)),
+					    raid_bdev->bdev.write_unit_size);
+	process->max_mbytes_per_sec = g_opts.process_max_mbytes_per_sec;
+	process->max_ios_per_sec = g_opts.process_max_ios_per_sec;
+	process->adaptive = g_opts.process_adaptive;
+	TAILQ_INIT(&process->requests);
+	TAILQ_INIT(&process->nomem_requests);
+	TAILQ_INIT(&process->finish_actions);
+
+	for (i = 0; i < RAID_BDEV_PROCESS_MAX_QD; i++) {
+		process_req = raid_bdev_process_alloc_request(process);
+		if (process_req == NULL) {
+			raid_bdev_process_free(process);
+			return NULL;
+		}
+
+		TAILQ_INSERT_TAIL(&process->requests, process_req, link);
+	}
+
+	return process;
+}
+
+static int
+raid_bdev_start_rebuild(struct raid_base_bdev_info *target)
+{
+	struct raid_bdev_process *process;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	process = raid_bdev_process_alloc(target->raid_bdev, RAID_PROCESS_REBUILD, target);
+	if (process == NULL) {
+		return -ENOMEM;
+	}
+
+	/* Only the regions written since the base bdev was removed need to be rebuilt */
+	process->use_bitmap = target->partial_rebuild;
+	target->partial_rebuild = false;
+
+	raid_bdev_process_start(process);
+
+	return 0;
+}
+
+static int
+raid_bdev_start_resync(struct raid_bdev *raid_bdev)
+{
+	struct raid_bdev_process *process;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(raid_bdev->bitmap != NULL);
+
+	process = raid_bdev_process_alloc(raid_bdev, RAID_PROCESS_RESYNC, NULL);
+	if (process == NULL) {
+		return -ENOMEM;
+	}
+
+	process->use_bitmap = true;
+
+	raid_bdev_process_start(process);
+
+	return 0;
+}
+
+static int
+raid_bdev_start_reshape(struct raid_bdev *raid_bdev)
+{
+	struct raid_bdev_process *process;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(raid_bdev->reshape.restriping);
+
+	process = raid_bdev_process_alloc(raid_bdev, RAID_PROCESS_RESHAPE, NULL);
+	if (process == NULL) {
+		return -ENOMEM;
+	}
+
+	/* Continue from the last position stored in the superblock */
+	process->window_offset = raid_bdev->reshape.offset;
+
+	raid_bdev_process_start(process);
+
+	return 0;
+}
+
+static int
+raid_bdev_start_scrub_process(struct raid_bdev *raid_bdev, bool repair)
+{
+	struct raid_bdev_process *process;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	process = raid_bdev_process_alloc(raid_bdev, RAID_PROCESS_SCRUB, NULL);
+	if (process == NULL) {
+		return -ENOMEM;
+	}
+
+	raid_bdev->scrub.started = true;
+	raid_bdev->scrub.running = true;
+	raid_bdev->scrub.repair = repair;
+	raid_bdev->scrub.status = 0;
+	raid_bdev->scrub.mismatched_blocks = 0;
+	raid_bdev->scrub.read_error_blocks = 0;
+	raid_bdev->scrub.repaired_blocks = 0;
+
+	raid_bdev_process_start(process);
+
+	return 0;
+}
+
+static void raid_bdev_configure_base_bdev_cont(struct raid_base_bdev_info *base_info);
+
+static void
+_raid_bdev_configure_base_bdev_cont(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_base_bdev_info *base_info = spdk_io_channel_iter_get_ctx(i);
+
+	raid_bdev_configure_base_bdev_cont(base_info);
+}
+
+static void
+raid_bdev_ch_sync(struct spdk_io_channel_iter *i)
+{
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+raid_bdev_configure_base_bdev_cont(struct raid_base_bdev_info *base_info)
+{
+	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+	int rc;
+
+	if (raid_bdev->num_base_bdevs_discovered == raid_bdev->num_base_bdevs_operational &&
+	    base_info->is_process_target == false) {
+		/* TODO: defer if rebuild in progress on another base bdev */
+		assert(raid_bdev->process == NULL);
+		assert(raid_bdev->state == RAID_BDEV_STATE_ONLINE);
+		base_info->is_process_target = true;
+		/* To assure is_process_target is set before is_configured when checked in raid_bdev_create_cb() */
+		spdk_for_each_channel(raid_bdev, raid_bdev_ch_sync, base_info, _raid_bdev_configure_base_bdev_cont);
+		return;
+	}
+
+	base_info->is_configured = true;
+
+	raid_bdev->num_base_bdevs_discovered++;
+	assert(raid_bdev->num_base_bdevs_discovered <= raid_bdev->num_base_bdevs);
+	assert(raid_bdev->num_base_bdevs_operational <= raid_bdev->num_base_bdevs);
+	assert(raid_bdev->num_base_bdevs_operational >= raid_bdev->min_base_bdevs_operational);
+
+	/*
+	 * Configure the raid bdev when the number of discovered base bdevs reaches the number
+	 * of base bdevs we know to be operational members of the array. Usually this is equal
+	 * to the total number of base bdevs (num_base_bdevs) but can be less - when the array is
+	 * degraded.
+	 */
+	if (raid_bdev->state == RAID_BDEV_STATE_ONLINE && raid_bdev->reshape.num_base_bdevs_old != 0) {
+		/* Added by a reshape, which continues when all the new base bdevs are configured */
+		rc = 0;
+	} else if (raid_bdev->num_base_bdevs_discovered == raid_bdev->num_base_bdevs_operational) {
+		rc = raid_bdev_configure(raid_bdev);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to configure raid bdev: %s\n", spdk_strerror(-rc));
+		}
+	} else if (base_info->is_process_target) {
+		raid_bdev->num_base_bdevs_operational++;
+		rc = raid_bdev_start_rebuild(base_info);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to start rebuild: %s\n", spdk_strerror(-rc));
+			_raid_bdev_remove_base_bdev(base_info, NULL, NULL);
+		}
+	} else {
+		rc = 0;
+	}
+
+	if (base_info->configure_cb != NULL) {
+		base_info->configure_cb(base_info->configure_cb_ctx, rc);
+	}
+}
+
+static void raid_bdev_examine_sb(const struct raid_bdev_superblock *sb, struct spdk_bdev *bdev,
+				 raid_base_bdev_cb cb_fn, void *cb_ctx);
+
+static void
+raid_bdev_configure_base_bdev_check_sb_cb(const struct raid_bdev_superblock *sb, int status,
+		void *ctx)
+{
+	struct raid_base_bdev_info *base_info = ctx;
+
+	switch (status) {
+	case 0:
+		/* valid superblock found */
+		if (spdk_uuid_compare(&base_info->raid_bdev->bdev.uuid, &sb->uuid) == 0) {
+			struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(base_info->desc);
+
+			raid_bdev_free_base_bdev_resource(base_info);
+			raid_bdev_examine_sb(sb, bdev, base_info->configure_cb, base_info->configure_cb_ctx);
+			return;
+		}
+		SPDK_ERRLOG("Superblock of a different raid bdev found on bdev %s\n", base_info->name);
+		status = -EEXIST;
+		raid_bdev_free_base_bdev_resource(base_info);
+		break;
+	case -EINVAL:
+		/* no valid superblock */
+		raid_bdev_configure_base_bdev_cont(base_info);
+		return;
+	default:
+		SPDK_ERRLOG("Failed to examine bdev %s: %s\n",
+			    base_info->name, spdk_strerror(-status));
+		break;
+	}
+
+	if (base_info->configure_cb != NULL) {
+		base_info->configure_cb(base_info->configure_cb_ctx, status);
+	}
+}
+
+static int
+raid_bdev_configure_base_bdev(struct raid_base_bdev_info *base_info, bool existing,
+			      raid_base_bdev_cb cb_fn, void *cb_ctx)
+{
+	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+	struct spdk_bdev_desc *desc;
+	struct spdk_bdev *bdev;
+	const struct spdk_uuid *bdev_uuid;
+	int rc;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(base_info->desc == NULL);
+
+	/*
+	 * Base bdev can be added by name or uuid. Here we assure both properties are set and valid
+	 * before claiming the bdev.
+	 */
+
+	if (!spdk_uuid_is_null(&base_info->uuid)) {
+		char uuid_str[SPDK_UUID_STRING_LEN];
+		const char *bdev_name;
+
+		spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &base_info->uuid);
+
+		/* UUID of a bdev is registered as its alias */
+		bdev = spdk_bdev_get_by_name(uuid_str);
+		if (bdev == NULL) {
+			return -ENODEV;
+		}
+
+		bdev_name = spdk_bdev_get_name(bdev);
+
+		if (base_info->name == NULL) {
+			assert(existing == true);
+			base_info->name = strdup(bdev_name);
+			if (base_info->name == NULL) {
+				return -ENOMEM;
+			}
+		} else if (strcmp(base_info->name, bdev_name) != 0) {
+			SPDK_ERRLOG("Name mismatch for base bdev '%s' - expected '%s'\n",
+				    bdev_name, base_info->name);
+			return -EINVAL;
+		}
+	}
+
+	assert(base_info->name != NULL);
+
+	rc = spdk_bdev_open_ext(base_info->name, true, raid_bdev_event_base_bdev, NULL, &desc);
+	if (rc != 0) {
+		if (rc != -ENODEV) {
+			SPDK_ERRLOG("Unable to create desc on bdev '%s'\n", base_info->name);
+		}
+		return rc;
+	}
+
+	bdev = spdk_bdev_desc_get_bdev(desc);
+	bdev_uuid = spdk_bdev_get_uuid(bdev);
+
+	if (spdk_uuid_is_null(&base_info->uuid)) {
+		spdk_uuid_copy(&base_info->uuid, bdev_uuid);
+	} else if (spdk_uuid_compare(&base_info->uuid, bdev_uuid) != 0) {
+		SPDK_ERRLOG("UUID mismatch for base bdev '%s'\n", base_info->name);
+		spdk_bdev_close(desc);
+		return -EINVAL;
+	}
+
+	rc = spdk_bdev_module_claim_bdev(bdev, NULL, &g_raid_if);
+	if (rc != 0) {
+		SPDK_ERRLOG("Unable to claim this bdev as it is already claimed\n");
+		spdk_bdev_close(desc);
+		return rc;
+	}
+
+	SPDK_DEBUGLOG(bdev_raid, "bdev %s is claimed\n", bdev->name);
+
+	base_info->app_thread_ch = spdk_bdev_get_io_channel(desc);
+	if (base_info->app_thread_ch == NULL) {
+		SPDK_ERRLOG("Failed to get io channel\n");
+		spdk_bdev_module_release_bdev(bdev);
+		spdk_bdev_close(desc);
+		return -ENOMEM;
+	}
+
+	base_info->desc = desc;
+	base_info->blockcnt = bdev->blockcnt;
+
+	if (raid_bdev->superblock_enabled) {
+		uint64_t data_offset;
+
+		if (base_info->data_offset == 0) {
+			assert((RAID_BDEV_MIN_DATA_OFFSET_SIZE % spdk_bdev_get_data_block_size(bdev)) == 0);
+			data_offset = RAID_BDEV_MIN_DATA_OFFSET_SIZE / spdk_bdev_get_data_block_size(bdev);
+		} else {
+			data_offset = base_info->data_offset;
+		}
+
+		if (bdev->optimal_io_boundary != 0) {
+			data_offset = spdk_divide_round_up(data_offset,
+							   bdev->optimal_io_boundary) * bdev->optimal_io_boundary;
+			if (base_info->data_offset != 0 && base_info->data_offset != data_offset) {
+				SPDK_WARNLOG("Data offset %lu on bdev '%s' is different than optimal value %lu\n",
+					     base_info->data_offset, base_info->name, data_offset);
+				data_offset = base_info->data_offset;
+			}
+		}
+
+		base_info->data_offset = data_offset;
+	}
+
+	if (base_info->data_offset >= bdev->blockcnt) {
+		SPDK_ERRLOG("Data offset %lu exceeds base bdev capacity %lu on bdev '%s'\n",
+			    base_info->data_offset, bdev->blockcnt, base_info->name);
+		rc = -EINVAL;
+		goto out;
+	}
+
+	if (base_info->data_size == 0) {
+		base_info->data_size = bdev->blockcnt - base_info->data_offset;
+	} else if (base_info->data_offset + base_info->data_size > bdev->blockcnt) {
+		SPDK_ERRLOG("Data offset and size exceeds base bdev capacity %lu on bdev '%s'\n",
+			    bdev->blockcnt, base_info->name);
+		rc = -EINVAL;
+		goto out;
+	}
+
+	if (!raid_bdev->module->dif_supported && spdk_bdev_get_dif_type(bdev) != SPDK_DIF_DISABLE) {
+		SPDK_ERRLOG("Base bdev '%s' has DIF or DIX enabled - unsupported RAID configuration\n",
+			    bdev->name);
+		rc = -EINVAL;
+		goto out;
+	}
+
+	/*
+	 * Set the raid bdev properties if this is the first base bdev configured,
+	 * otherwise - verify. Assumption is that all the base bdevs for any raid bdev should
+	 * have the same blocklen and metadata format.
+	 */
+	if (raid_bdev->bdev.blocklen == 0) {
+		raid_bdev->bdev.blocklen = bdev->blocklen;
+		raid_bdev->bdev.md_len = spdk_bdev_get_md_size(bdev);
+		raid_bdev->bdev.md_interleave = spdk_bdev_is_md_interleaved(bdev);
+		raid_bdev->bdev.dif_type = spdk_bdev_get_dif_type(bdev);
+		raid_bdev->bdev.dif_check_flags = bdev->dif_check_flags;
+		raid_bdev->bdev.dif_is_head_of_md = spdk_bdev_is_dif_head_of_md(bdev);
+	} else {
+		if (raid_bdev->bdev.blocklen != bdev->blocklen) {
+			SPDK_ERRLOG("Raid bdev '%s' blocklen %u differs from base bdev '%s' blocklen %u\n",
+				    raid_bdev->bdev.name, raid_bdev->bdev.blocklen, bdev->name, bdev->blocklen);
+			rc = -EINVAL;
+			goto out;
+		}
+
+		if (raid_bdev->bdev.md_len != spdk_bdev_get_md_size(bdev) ||
+		    raid_bdev->bdev.md_interleave != spdk_bdev_is_md_interleaved(bdev) ||
+		    raid_bdev->bdev.dif_type != spdk_bdev_get_dif_type(bdev) ||
+		    raid_bdev->bdev.dif_check_flags != bdev->dif_check_flags ||
+		    raid_bdev->bdev.dif_is_head_of_md != spdk_bdev_is_dif_head_of_md(bdev)) {
+			SPDK_ERRLOG("Raid bdev '%s' has different metadata format than base bdev '%s'\n",
+				    raid_bdev->bdev.name, bdev->name);
+			rc = -EINVAL;
+			goto out;
+		}
+	}
+
+	base_info->configure_cb = cb_fn;
+	base_info->configure_cb_ctx = cb_ctx;
+
+	if (existing) {
+		raid_bdev_configure_base_bdev_cont(base_info);
+	} else {
+		/* check for existing superblock when using a new bdev */
+		rc = raid_bdev_load_base_bdev_superblock(desc, base_info->app_thread_ch,
+				raid_bdev_configure_base_bdev_check_sb_cb, base_info);
+		if (rc) {
+			SPDK_ERRLOG("Failed to read bdev %s superblock: %s\n",
+				    bdev->name, spdk_strerror(-rc));
+		}
+	}
+out:
 	if (rc != 0) {
-		raid_bdev_process_window_range_unlocked(process, rc);
+		raid_bdev_free_base_bdev_resource(base_info);
 	}
+	return rc;
 }
 
-static void
-raid_bdev_process_channels_update_done(struct spdk_io_channel_iter *i, int status)
-{
-	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
-
-	raid_bdev_process_unlock_window_range(process);
-}
-
-static void
-raid_bdev_process_channel_update(struct spdk_io_channel_iter *i)
+int
+raid_bdev_add_base_bdev(struct raid_bdev *raid_bdev, const char *name,
+			raid_base_bdev_cb cb_fn, void *cb_ctx)
 {
-	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
-	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
-	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
-
-	raid_ch->process.offset = process->window_offset + process->window_size;
-
-	spdk_for_each_channel_continue(i, 0);
-}
+	struct raid_base_bdev_info *base_info = NULL, *iter;
+	int rc;
 
-void
-raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
-{
-	struct raid_bdev_process *process = process_req->process;
+	assert(name != NULL);
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
 
-	TAILQ_INSERT_TAIL(&process->requests, process_req, link);
+	if (raid_bdev->process != NULL) {
+		SPDK_ERRLOG("raid bdev '%s' is in process\n",
+			    raid_bdev->bdev.name);
+		return -EPERM;
+	}
 
-	assert(spdk_get_thread() == process->thread);
-	assert(process->window_remaining >= process_req->num_blocks);
+	if (raid_bdev->state == RAID_BDEV_STATE_CONFIGURING) {
+		struct spdk_bdev *bdev = spdk_bdev_get_by_name(name);
 
-	if (status != 0) {
-		process->window_status = status;
+		if (bdev != NULL) {
+			RAID_FOR_EACH_BASE_BDEV(raid_bdev, iter) {
+				if (iter->name == NULL &&
+				    spdk_uuid_compare(&bdev->uuid, &iter->uuid) == 0) {
+					base_info = iter;
+					break;
+				}
+			}
+		}
 	}
 
-	process->window_remaining -= process_req->num_blocks;
-	if (process->window_remaining == 0) {
-		if (process->window_status != 0) {
-			raid_bdev_process_finish(process, process->window_status);
-			return;
+	if (base_info == NULL || raid_bdev->state == RAID_BDEV_STATE_ONLINE) {
+		RAID_FOR_EACH_BASE_BDEV(raid_bdev, iter) {
+			if (iter->name == NULL && spdk_uuid_is_null(&iter->uuid)) {
+				base_info = iter;
+				break;
+			}
 		}
+	}
 
-		spdk_for_each_channel(process->raid_bdev, raid_bdev_process_channel_update, process,
-				      raid_bdev_process_channels_update_done);
+	if (base_info == NULL) {
+		SPDK_ERRLOG("no empty slot found in raid bdev '%s' for new base bdev '%s'\n",
+			    raid_bdev->bdev.name, name);
+		return -EINVAL;
 	}
-}
 
-static int
-raid_bdev_submit_process_request(struct raid_bdev_process *process, uint64_t offset_blocks,
-				 uint32_t num_blocks)
-{
-	struct raid_bdev *raid_bdev = process->raid_bdev;
-	struct raid_bdev_process_request *process_req;
-	int ret;
+	assert(base_info->is_configured == false);
 
-	process_req = TAILQ_FIRST(&process->requests);
-	if (process_req == NULL) {
-		assert(process->window_remaining > 0);
-		return 0;
+	if (raid_bdev->state == RAID_BDEV_STATE_ONLINE) {
+		assert(base_info->data_size != 0);
+		assert(base_info->desc == NULL);
 	}
 
-	process_req->target = process->target;
-	process_req->target_ch = process->raid_ch->process.target_ch;
-	process_req->offset_blocks = offset_blocks;
-	process_req->num_blocks = num_blocks;
-	process_req->iov.iov_len = num_blocks * raid_bdev->bdev.blocklen;
-
-	ret = raid_bdev->module->submit_process_request(process_req, process->raid_ch);
-	if (ret <= 0) {
-		if (ret < 0) {
-			SPDK_ERRLOG("Failed to submit process request on %s: %s\n",
-				    raid_bdev->bdev.name, spdk_strerror(-ret));
-			process->window_status = ret;
-		}
-		return ret;
+	base_info->name = strdup(name);
+	if (base_info->name == NULL) {
+		return -ENOMEM;
 	}
 
-	process_req->num_blocks = ret;
-	TAILQ_REMOVE(&process->requests, process_req, link);
+	rc = raid_bdev_configure_base_bdev(base_info, false, cb_fn, cb_ctx);
+	if (rc != 0 && (rc != -ENODEV || raid_bdev->state != RAID_BDEV_STATE_CONFIGURING)) {
+		SPDK_ERRLOG("base bdev '%s' configure failed: %s\n", name, spdk_strerror(-rc));
+		free(base_info->name);
+		base_info->name = NULL;
+	}
 
-	return ret;
+	return rc;
 }
 
+struct raid_bdev_reshape_ctx {
+	struct raid_bdev *raid_bdev;
+	/* Names of the base bdevs to add, moved to the base bdev info when the slots are added */
+	char **names;
+	/* Number of base bdevs to add */
+	uint8_t num_base_bdevs;
+	uint8_t num_base_bdevs_old;
+	uint8_t remaining;
+	int status;
+	bool slots_added;
+	bool sb_updated;
+	bool quiesced;
+	raid_base_bdev_cb cb_fn;
+	void *cb_ctx;
+};
+
 static void
-_raid_bdev_process_thread_run(struct raid_bdev_process *process)
+raid_bdev_reshape_ctx_free(struct raid_bdev_reshape_ctx *ctx)
 {
-	struct raid_bdev *raid_bdev = process->raid_bdev;
-	uint64_t offset = process->window_offset;
-	const uint64_t offset_end = spdk_min(offset + process->max_window_size, raid_bdev->bdev.blockcnt);
-	int ret;
-
-	while (offset < offset_end) {
-		ret = raid_bdev_submit_process_request(process, offset, offset_end - offset);
-		if (ret <= 0) {
-			break;
-		}
+	uint8_t i;
 
-		process->window_remaining += ret;
-		offset += ret;
+	for (i = 0; i < ctx->num_base_bdevs; i++) {
+		free(ctx->names[i]);
 	}
+	free(ctx->names);
+	free(ctx);
+}
 
-	if (process->window_remaining > 0) {
-		process->window_size = process->window_remaining;
-	} else {
-		raid_bdev_process_finish(process, process->window_status);
+static void
+raid_bdev_reshape_done(struct raid_bdev_reshape_ctx *ctx)
+{
+	if (ctx->cb_fn != NULL) {
+		ctx->cb_fn(ctx->cb_ctx, ctx->status);
 	}
+
+	raid_bdev_reshape_ctx_free(ctx);
 }
 
 static void
-raid_bdev_process_window_range_locked(void *ctx, int status)
+raid_bdev_reshape_unquiesced(void *_ctx, int status)
 {
-	struct raid_bdev_process *process = ctx;
+	struct raid_bdev_reshape_ctx *ctx = _ctx;
 
 	if (status != 0) {
-		SPDK_ERRLOG("Failed to lock LBA range: %s\n", spdk_strerror(-status));
-		raid_bdev_process_finish(process, status);
-		return;
-	}
-
-	process->window_range_locked = true;
-
-	if (process->state == RAID_PROCESS_STATE_STOPPING) {
-		raid_bdev_process_unlock_window_range(process);
-		return;
+		SPDK_ERRLOG("Failed to unquiesce raid bdev %s: %s\n",
+			    ctx->raid_bdev->bdev.name, spdk_strerror(-status));
 	}
 
-	_raid_bdev_process_thread_run(process);
+	raid_bdev_reshape_done(ctx);
 }
 
 static void
-raid_bdev_process_thread_run(struct raid_bdev_process *process)
+raid_bdev_reshape_unquiesce(struct raid_bdev_reshape_ctx *ctx)
 {
-	struct raid_bdev *raid_bdev = process->raid_bdev;
 	int rc;
 
-	assert(spdk_get_thread() == process->thread);
-	assert(process->window_remaining == 0);
-	assert(process->window_range_locked == false);
-
-	if (process->state == RAID_PROCESS_STATE_STOPPING) {
-		raid_bdev_process_do_finish(process);
-		return;
-	}
-
-	if (process->window_offset == raid_bdev->bdev.blockcnt) {
-		SPDK_DEBUGLOG(bdev_raid, "process completed on %s\n", raid_bdev->bdev.name);
-		raid_bdev_process_finish(process, 0);
+	if (!ctx->quiesced) {
+		raid_bdev_reshape_done(ctx);
 		return;
 	}
 
-	process->max_window_size = spdk_min(raid_bdev->bdev.blockcnt - process->window_offset,
-					    process->max_window_size);
-
-	rc = spdk_bdev_quiesce_range(&raid_bdev->bdev, &g_raid_if,
-				     process->window_offset, process->max_window_size,
-				     raid_bdev_process_window_range_locked, process);
+	ctx->quiesced = false;
+	rc = spdk_bdev_unquiesce(&ctx->raid_bdev->bdev, &g_raid_if, raid_bdev_reshape_unquiesced, ctx);
 	if (rc != 0) {
-		raid_bdev_process_window_range_locked(process, rc);
+		raid_bdev_reshape_unquiesced(ctx, rc);
 	}
 }
 
+/* Removes the base bdevs added by a reshape that could not be started */
 static void
-raid_bdev_process_thread_init(void *ctx)
+raid_bdev_reshape_rollback(struct raid_bdev_reshape_ctx *ctx)
 {
-	struct raid_bdev_process *process = ctx;
-	struct raid_bdev *raid_bdev = process->raid_bdev;
-	struct spdk_io_channel *ch;
-
-	process->thread = spdk_get_thread();
-
-	ch = spdk_get_io_channel(raid_bdev);
-	if (ch == NULL) {
-		process->status = -ENOMEM;
-		raid_bdev_process_do_finish(process);
-		return;
-	}
-
-	process->raid_ch = spdk_io_channel_get_ctx(ch);
-	process->state = RAID_PROCESS_STATE_RUNNING;
-
-	SPDK_NOTICELOG("Started %s on raid bdev %s\n",
-		       raid_bdev_process_to_str(process->type), raid_bdev->bdev.name);
-
-	raid_bdev_process_thread_run(process);
-}
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	uint8_t i;
 
-static void
-raid_bdev_channels_abort_start_process_done(struct spdk_io_channel_iter *i, int status)
-{
-	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	assert(ctx->status != 0);
 
-	_raid_bdev_remove_base_bdev(process->target, NULL, NULL);
-	raid_bdev_process_free(process);
+	SPDK_ERRLOG("Failed to add base bdevs to raid bdev '%s': %s\n", raid_bdev->bdev.name,
+		    spdk_strerror(-ctx->status));
 
-	/* TODO: update sb */
-}
+	if (ctx->sb_updated) {
+		sb->base_bdevs_size -= ctx->num_base_bdevs;
+		sb->num_base_bdevs = ctx->num_base_bdevs_old;
+		sb->length = sizeof(*sb) + sizeof(sb->base_bdevs[0]) * sb->base_bdevs_size;
+		sb->reshape_num_base_bdevs = 0;
+		sb->reshape_offset = 0;
+	}
 
-static void
-raid_bdev_channel_abort_start_process(struct spdk_io_channel_iter *i)
-{
-	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
-	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	if (ctx->slots_added) {
+		for (i = ctx->num_base_bdevs_old; i < raid_bdev->num_base_bdevs; i++) {
+			raid_bdev_free_base_bdev_resource(&raid_bdev->base_bdev_info[i]);
+		}
+		raid_bdev->num_base_bdevs = ctx->num_base_bdevs_old;
+		raid_bdev->num_base_bdevs_operational -= ctx->num_base_bdevs;
+		raid_bdev->min_base_bdevs_operational -= ctx->num_base_bdevs;
+	}
 
-	raid_bdev_ch_process_cleanup(raid_ch);
+	raid_bdev->reshape.num_base_bdevs_old = 0;
 
-	spdk_for_each_channel_continue(i, 0);
+	raid_bdev_reshape_unquiesce(ctx);
 }
 
 static void
-raid_bdev_channels_start_process_done(struct spdk_io_channel_iter *i, int status)
+raid_bdev_reshape_sb_updated(int status, struct raid_bdev *raid_bdev, void *_ctx)
 {
-	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
-	struct raid_bdev *raid_bdev = process->raid_bdev;
-	struct spdk_thread *thread;
-	char thread_name[RAID_BDEV_SB_NAME_SIZE + 16];
-
-	if (status == 0 &&
-	    (process->target->remove_scheduled || !process->target->is_configured ||
-	     raid_bdev->num_base_bdevs_operational <= raid_bdev->min_base_bdevs_operational)) {
-		/* a base bdev was removed before we got here */
-		status = -ENODEV;
-	}
+	struct raid_bdev_reshape_ctx *ctx = _ctx;
 
 	if (status != 0) {
-		SPDK_ERRLOG("Failed to start %s on %s: %s\n",
-			    raid_bdev_process_to_str(process->type), raid_bdev->bdev.name,
-			    spdk_strerror(-status));
-		goto err;
+		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
 	}
 
-	snprintf(thread_name, sizeof(thread_name), "%s_%s",
-		 raid_bdev->bdev.name, raid_bdev_process_to_str(process->type));
-
-	thread = spdk_thread_create(thread_name, NULL);
-	if (thread == NULL) {
-		SPDK_ERRLOG("Failed to create %s thread for %s\n",
-			    raid_bdev_process_to_str(process->type), raid_bdev->bdev.name);
-		goto err;
+	if (ctx->status != 0) {
+		raid_bdev_reshape_rollback(ctx);
+	} else {
+		raid_bdev_reshape_unquiesce(ctx);
 	}
-
-	raid_bdev->process = process;
-
-	spdk_thread_send_msg(thread, raid_bdev_process_thread_init, process);
-
-	return;
-err:
-	spdk_for_each_channel(process->raid_bdev, raid_bdev_channel_abort_start_process, process,
-			      raid_bdev_channels_abort_start_process_done);
 }
 
 static void
-raid_bdev_channel_start_process(struct spdk_io_channel_iter *i)
+raid_bdev_reshape_update_superblock(struct raid_bdev_reshape_ctx *ctx)
 {
-	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
-	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
-	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
-	int rc;
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	struct raid_bdev_sb_base_bdev *sb_base_bdev;
+	struct raid_base_bdev_info *base_info;
+	uint8_t i;
+
+	for (i = ctx->num_base_bdevs_old; i < raid_bdev->num_base_bdevs; i++) {
+		base_info = &raid_bdev->base_bdev_info[i];
+		sb_base_bdev = &sb->base_bdevs[sb->base_bdevs_size++];
 
-	rc = raid_bdev_ch_process_setup(raid_ch, process);
+		memset(sb_base_bdev, 0, sizeof(*sb_base_bdev));
+		spdk_uuid_copy(&sb_base_bdev->uuid, &base_info->uuid);
+		sb_base_bdev->data_offset = base_info->data_offset;
+		sb_base_bdev->data_size = base_info->data_size;
+		sb_base_bdev->state = RAID_SB_BASE_BDEV_CONFIGURED;
+		sb_base_bdev->slot = i;
+	}
+	sb->num_base_bdevs = raid_bdev->num_base_bdevs;
+	sb->length = sizeof(*sb) + sizeof(*sb_base_bdev) * sb->base_bdevs_size;
 
-	spdk_for_each_channel_continue(i, rc);
+	ctx->sb_updated = true;
 }
 
 static void
-raid_bdev_process_start(struct raid_bdev_process *process)
+raid_bdev_channel_reshape_switch(struct spdk_io_channel_iter *i)
 {
-	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_bdev_reshape_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
 
-	assert(raid_bdev->module->submit_process_request != NULL);
+	raid_ch->num_base_bdevs = ctx->raid_bdev->num_base_bdevs;
 
-	spdk_for_each_channel(raid_bdev, raid_bdev_channel_start_process, process,
-			      raid_bdev_channels_start_process_done);
+	spdk_for_each_channel_continue(i, 0);
 }
 
 static void
-raid_bdev_process_request_free(struct raid_bdev_process_request *process_req)
+raid_bdev_channels_reshape_switch_done(struct spdk_io_channel_iter *i, int status)
 {
-	spdk_dma_free(process_req->iov.iov_base);
-	spdk_dma_free(process_req->md_buf);
-	free(process_req);
+	struct raid_bdev_reshape_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+
+	if (raid_bdev->superblock_enabled) {
+		raid_bdev_reshape_update_superblock(ctx);
+		raid_bdev_write_superblock(raid_bdev, raid_bdev_reshape_sb_updated, ctx);
+	} else {
+		raid_bdev_reshape_unquiesce(ctx);
+	}
 }
 
-static struct raid_bdev_process_request *
-raid_bdev_process_alloc_request(struct raid_bdev_process *process)
+static void
+raid_bdev_channel_reshape_put(struct spdk_io_channel_iter *i)
 {
-	struct raid_bdev *raid_bdev = process->raid_bdev;
-	struct raid_bdev_process_request *process_req;
-
-	process_req = calloc(1, sizeof(*process_req));
-	if (process_req == NULL) {
-		return NULL;
-	}
+	struct raid_bdev_reshape_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	uint8_t idx;
 
-	process_req->process = process;
-	process_req->iov.iov_len = process->max_window_size * raid_bdev->bdev.blocklen;
-	process_req->iov.iov_base = spdk_dma_malloc(process_req->iov.iov_len, 4096, 0);
-	if (process_req->iov.iov_base == NULL) {
-		free(process_req);
-		return NULL;
-	}
-	if (spdk_bdev_is_md_separate(&raid_bdev->bdev)) {
-		process_req->md_buf = spdk_dma_malloc(process->max_window_size * raid_bdev->bdev.md_len, 4096, 0);
-		if (process_req->md_buf == NULL) {
-			raid_bdev_process_request_free(process_req);
-			return NULL;
+	for (idx = ctx->num_base_bdevs_old; idx < ctx->raid_bdev->num_base_bdevs; idx++) {
+		if (raid_ch->base_channel[idx] != NULL) {
+			spdk_put_io_channel(raid_ch->base_channel[idx]);
+			raid_ch->base_channel[idx] = NULL;
 		}
 	}
 
-	return process_req;
+	spdk_for_each_channel_continue(i, 0);
 }
 
 static void
-raid_bdev_process_free(struct raid_bdev_process *process)
+raid_bdev_channels_reshape_put_done(struct spdk_io_channel_iter *i, int status)
 {
-	struct raid_bdev_process_request *process_req;
+	struct raid_bdev_reshape_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
 
-	while ((process_req = TAILQ_FIRST(&process->requests)) != NULL) {
-		TAILQ_REMOVE(&process->requests, process_req, link);
-		raid_bdev_process_request_free(process_req);
+	raid_bdev_reshape_rollback(ctx);
+}
+
+static void
+raid_bdev_channel_reshape_get(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_reshape_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	uint8_t idx;
+	int rc = 0;
+
+	for (idx = ctx->num_base_bdevs_old; idx < raid_bdev->num_base_bdevs; idx++) {
+		if (raid_ch->base_channel[idx] == NULL) {
+			raid_ch->base_channel[idx] = spdk_bdev_get_io_channel(
+							     raid_bdev->base_bdev_info[idx].desc);
+			if (raid_ch->base_channel[idx] == NULL) {
+				rc = -ENOMEM;
+				break;
+			}
+		}
 	}
 
-	free(process);
+	spdk_for_each_channel_continue(i, rc);
 }
 
-static struct raid_bdev_process *
-raid_bdev_process_alloc(struct raid_bdev *raid_bdev, enum raid_process_type type,
-			struct raid_base_bdev_info *target)
+static void
+raid_bdev_channels_reshape_get_done(struct spdk_io_channel_iter *i, int status)
 {
-	struct raid_bdev_process *process;
-	struct raid_bdev_process_request *process_req;
-	int i;
+	struct raid_bdev_reshape_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
 
-	process = calloc(1, sizeof(*process));
-	if (process == NULL) {
-		return NULL;
+	if (status == 0) {
+		status = raid_bdev_reshape_complete(raid_bdev);
 	}
 
-	process->raid_bdev = raid_bdev;
-	process->type = type;
-	process->target = target;
-	process->max_window_size = spdk_max(spdk_divide_round_up(g_opts.process_window_size_kb * 1024UL,
-					    spdk_bdev_get_data_block_size(&raid_bdev->bdev)),
-					    raid_bdev->bdev.write_unit_size);
-	TAILQ_INIT(&process->requests);
-	TAILQ_INIT(&process->finish_actions);
-
-	for (i = 0; i < RAID_BDEV_PROCESS_MAX_QD; i++) {
-		process_req = raid_bdev_process_alloc_request(process);
-		if (process_req == NULL) {
-			raid_bdev_process_free(process);
-			return NULL;
-		}
-
-		TAILQ_INSERT_TAIL(&process->requests, process_req, link);
+	if (status != 0) {
+		ctx->status = status;
+		spdk_for_each_channel(raid_bdev, raid_bdev_channel_reshape_put, ctx,
+				      raid_bdev_channels_reshape_put_done);
+		return;
 	}
 
-	return process;
+	spdk_for_each_channel(raid_bdev, raid_bdev_channel_reshape_switch, ctx,
+			      raid_bdev_channels_reshape_switch_done);
 }
 
-static int
-raid_bdev_start_rebuild(struct raid_base_bdev_info *target)
+static void
+raid_bdev_reshape_apply_quiesced(void *_ctx, int status)
 {
-	struct raid_bdev_process *process;
-
-	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	struct raid_bdev_reshape_ctx *ctx = _ctx;
 
-	process = raid_bdev_process_alloc(target->raid_bdev, RAID_PROCESS_REBUILD, target);
-	if (process == NULL) {
-		return -ENOMEM;
+	if (status != 0) {
+		ctx->status = status;
+		raid_bdev_reshape_rollback(ctx);
+		return;
 	}
 
-	raid_bdev_process_start(process);
+	ctx->quiesced = true;
 
-	return 0;
+	spdk_for_each_channel(ctx->raid_bdev, raid_bdev_channel_reshape_get, ctx,
+			      raid_bdev_channels_reshape_get_done);
 }
 
-static void raid_bdev_configure_base_bdev_cont(struct raid_base_bdev_info *base_info);
-
 static void
-_raid_bdev_configure_base_bdev_cont(struct spdk_io_channel_iter *i, int status)
+raid_bdev_reshape_restripe_sb_written(int status, struct raid_bdev *raid_bdev, void *_ctx)
 {
-	struct raid_base_bdev_info *base_info = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev_reshape_ctx *ctx = _ctx;
 
-	raid_bdev_configure_base_bdev_cont(base_info);
-}
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+		ctx->status = status;
+		raid_bdev_reshape_rollback(ctx);
+		return;
+	}
 
-static void
-raid_bdev_ch_sync(struct spdk_io_channel_iter *i)
-{
-	spdk_for_each_channel_continue(i, 0);
+	raid_bdev->reshape.restriping = true;
+	raid_bdev->reshape.offset = 0;
+
+	ctx->status = raid_bdev_start_reshape(raid_bdev);
+	if (ctx->status != 0) {
+		SPDK_ERRLOG("Failed to start reshape of raid bdev '%s': %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-ctx->status));
+	}
+
+	raid_bdev_reshape_done(ctx);
 }
 
+/*
+ * All added base bdevs are configured. Modules that keep the existing data in place, like
+ * concat, switch to the new layout right away. Otherwise, the reshape is recorded in the
+ * superblock and the data is moved to the new layout by a background process.
+ */
 static void
-raid_bdev_configure_base_bdev_cont(struct raid_base_bdev_info *base_info)
+raid_bdev_reshape_commit(struct raid_bdev_reshape_ctx *ctx)
 {
-	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct raid_base_bdev_info *base_info;
+	uint64_t data_size = raid_bdev->base_bdev_info[0].data_size;
+	uint8_t i;
 	int rc;
 
-	if (raid_bdev->num_base_bdevs_discovered == raid_bdev->num_base_bdevs_operational &&
-	    base_info->is_process_target == false) {
-		/* TODO: defer if rebuild in progress on another base bdev */
-		assert(raid_bdev->process == NULL);
-		assert(raid_bdev->state == RAID_BDEV_STATE_ONLINE);
-		base_info->is_process_target = true;
-		/* To assure is_process_target is set before is_configured when checked in raid_bdev_create_cb() */
-		spdk_for_each_channel(raid_bdev, raid_bdev_ch_sync, base_info, _raid_bdev_configure_base_bdev_cont);
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
+		ctx->status = -ENODEV;
+		raid_bdev_reshape_rollback(ctx);
 		return;
 	}
 
-	base_info->is_configured = true;
-
-	raid_bdev->num_base_bdevs_discovered++;
-	assert(raid_bdev->num_base_bdevs_discovered <= raid_bdev->num_base_bdevs);
-	assert(raid_bdev->num_base_bdevs_operational <= raid_bdev->num_base_bdevs);
-	assert(raid_bdev->num_base_bdevs_operational >= raid_bdev->min_base_bdevs_operational);
-
-	/*
-	 * Configure the raid bdev when the number of discovered base bdevs reaches the number
-	 * of base bdevs we know to be operational members of the array. Usually this is equal
-	 * to the total number of base bdevs (num_base_bdevs) but can be less - when the array is
-	 * degraded.
-	 */
-	if (raid_bdev->num_base_bdevs_discovered == raid_bdev->num_base_bdevs_operational) {
-		rc = raid_bdev_configure(raid_bdev);
-		if (rc != 0) {
-			SPDK_ERRLOG("Failed to configure raid bdev: %s\n", spdk_strerror(-rc));
-		}
-	} else if (base_info->is_process_target) {
-		raid_bdev->num_base_bdevs_operational++;
-		rc = raid_bdev_start_rebuild(base_info);
+	if (raid_bdev->module->reshape_window_size == NULL) {
+		rc = spdk_bdev_quiesce(&raid_bdev->bdev, &g_raid_if, raid_bdev_reshape_apply_quiesced, ctx);
 		if (rc != 0) {
-			SPDK_ERRLOG("Failed to start rebuild: %s\n", spdk_strerror(-rc));
-			_raid_bdev_remove_base_bdev(base_info, NULL, NULL);
+			raid_bdev_reshape_apply_quiesced(ctx, rc);
 		}
-	} else {
-		rc = 0;
+		return;
 	}
 
-	if (base_info->configure_cb != NULL) {
-		base_info->configure_cb(base_info->configure_cb_ctx, rc);
+	/* The data is striped, so all base bdevs must provide the same data size */
+	for (i = ctx->num_base_bdevs_old; i < raid_bdev->num_base_bdevs; i++) {
+		base_info = &raid_bdev->base_bdev_info[i];
+
+		if (base_info->data_size < data_size) {
+			SPDK_ERRLOG("Base bdev '%s' is too small for raid bdev '%s'\n",
+				    base_info->name, raid_bdev->bdev.name);
+			ctx->status = -EINVAL;
+			raid_bdev_reshape_rollback(ctx);
+			return;
+		}
+		base_info->data_size = data_size;
 	}
-}
 
-static void raid_bdev_examine_sb(const struct raid_bdev_superblock *sb, struct spdk_bdev *bdev,
-				 raid_base_bdev_cb cb_fn, void *cb_ctx);
+	raid_bdev_reshape_update_superblock(ctx);
+	raid_bdev->sb->reshape_num_base_bdevs = ctx->num_base_bdevs_old;
+	raid_bdev->sb->reshape_offset = 0;
+
+	raid_bdev_write_superblock(raid_bdev, raid_bdev_reshape_restripe_sb_written, ctx);
+}
 
 static void
-raid_bdev_configure_base_bdev_check_sb_cb(const struct raid_bdev_superblock *sb, int status,
-		void *ctx)
+raid_bdev_reshape_base_bdev_configured(void *_ctx, int status)
 {
-	struct raid_base_bdev_info *base_info = ctx;
+	struct raid_bdev_reshape_ctx *ctx = _ctx;
 
-	switch (status) {
-	case 0:
-		/* valid superblock found */
-		if (spdk_uuid_compare(&base_info->raid_bdev->bdev.uuid, &sb->uuid) == 0) {
-			struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(base_info->desc);
+	if (status != 0) {
+		ctx->status = status;
+	}
 
-			raid_bdev_free_base_bdev_resource(base_info);
-			raid_bdev_examine_sb(sb, bdev, base_info->configure_cb, base_info->configure_cb_ctx);
-			return;
-		}
-		SPDK_ERRLOG("Superblock of a different raid bdev found on bdev %s\n", base_info->name);
-		status = -EEXIST;
-		raid_bdev_free_base_bdev_resource(base_info);
-		break;
-	case -EINVAL:
-		/* no valid superblock */
-		raid_bdev_configure_base_bdev_cont(base_info);
+	assert(ctx->remaining > 0);
+	if (--ctx->remaining > 0) {
 		return;
-	default:
-		SPDK_ERRLOG("Failed to examine bdev %s: %s\n",
-			    base_info->name, spdk_strerror(-status));
-		break;
 	}
 
-	if (base_info->configure_cb != NULL) {
-		base_info->configure_cb(base_info->configure_cb_ctx, status);
+	if (ctx->status != 0) {
+		raid_bdev_reshape_rollback(ctx);
+	} else {
+		raid_bdev_reshape_commit(ctx);
 	}
 }
 
-static int
-raid_bdev_configure_base_bdev(struct raid_base_bdev_info *base_info, bool existing,
-			      raid_base_bdev_cb cb_fn, void *cb_ctx)
+static void
+raid_bdev_reshape_slots_added(void *_ctx, int status)
 {
-	struct raid_bdev *raid_bdev = base_info->raid_bdev;
-	struct spdk_bdev_desc *desc;
-	struct spdk_bdev *bdev;
-	const struct spdk_uuid *bdev_uuid;
+	struct raid_bdev_reshape_ctx *ctx = _ctx;
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	uint8_t i;
 	int rc;
 
-	assert(spdk_get_thread() == spdk_thread_get_app_thread());
-	assert(base_info->desc == NULL);
-
-	/*
-	 * Base bdev can be added by name or uuid. Here we assure both properties are set and valid
-	 * before claiming the bdev.
-	 */
-
-	if (!spdk_uuid_is_null(&base_info->uuid)) {
-		char uuid_str[SPDK_UUID_STRING_LEN];
-		const char *bdev_name;
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to unquiesce raid bdev %s: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+	}
 
-		spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &base_info->uuid);
+	if (ctx->status != 0) {
+		raid_bdev_reshape_rollback(ctx);
+		return;
+	}
 
-		/* UUID of a bdev is registered as its alias */
-		bdev = spdk_bdev_get_by_name(uuid_str);
-		if (bdev == NULL) {
-			return -ENODEV;
+	ctx->remaining = 1;
+	for (i = ctx->num_base_bdevs_old; i < raid_bdev->num_base_bdevs; i++) {
+		ctx->remaining++;
+		rc = raid_bdev_configure_base_bdev(&raid_bdev->base_bdev_info[i], false,
+						   raid_bdev_reshape_base_bdev_configured, ctx);
+		if (rc != 0) {
+			SPDK_ERRLOG("base bdev '%s' configure failed: %s\n",
+				    raid_bdev->base_bdev_info[i].name, spdk_strerror(-rc));
+			raid_bdev_reshape_base_bdev_configured(ctx, rc);
 		}
+	}
 
-		bdev_name = spdk_bdev_get_name(bdev);
+	raid_bdev_reshape_base_bdev_configured(ctx, 0);
+}
 
-		if (base_info->name == NULL) {
-			assert(existing == true);
-			base_info->name = strdup(bdev_name);
-			if (base_info->name == NULL) {
-				return -ENOMEM;
-			}
-		} else if (strcmp(base_info->name, bdev_name) != 0) {
-			SPDK_ERRLOG("Name mismatch for base bdev '%s' - expected '%s'\n",
-				    bdev_name, base_info->name);
-			return -EINVAL;
-		}
+static void
+raid_bdev_channel_reshape_add_slots(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_reshape_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_io_channel **base_channel;
+
+	base_channel = realloc(raid_ch->base_channel,
+			       raid_bdev->num_base_bdevs * sizeof(*raid_ch->base_channel));
+	if (base_channel == NULL) {
+		spdk_for_each_channel_continue(i, -ENOMEM);
+		return;
 	}
 
-	assert(base_info->name != NULL);
+	memset(&base_channel[ctx->num_base_bdevs_old], 0,
+	       ctx->num_base_bdevs * sizeof(*raid_ch->base_channel));
+	raid_ch->base_channel = base_channel;
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+raid_bdev_channels_reshape_add_slots_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_reshape_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	int rc;
+
+	ctx->status = status;
+	ctx->quiesced = false;
 
-	rc = spdk_bdev_open_ext(base_info->name, true, raid_bdev_event_base_bdev, NULL, &desc);
+	rc = spdk_bdev_unquiesce(&ctx->raid_bdev->bdev, &g_raid_if, raid_bdev_reshape_slots_added, ctx);
 	if (rc != 0) {
-		if (rc != -ENODEV) {
-			SPDK_ERRLOG("Unable to create desc on bdev '%s'\n", base_info->name);
-		}
-		return rc;
+		raid_bdev_reshape_slots_added(ctx, rc);
 	}
+}
 
-	bdev = spdk_bdev_desc_get_bdev(desc);
-	bdev_uuid = spdk_bdev_get_uuid(bdev);
+static void
+raid_bdev_reshape_add_slots_quiesced(void *_ctx, int status)
+{
+	struct raid_bdev_reshape_ctx *ctx = _ctx;
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct raid_base_bdev_info *base_bdev_info, *base_info;
+	uint8_t num_base_bdevs = ctx->num_base_bdevs_old + ctx->num_base_bdevs;
+	uint8_t i;
 
-	if (spdk_uuid_is_null(&base_info->uuid)) {
-		spdk_uuid_copy(&base_info->uuid, bdev_uuid);
-	} else if (spdk_uuid_compare(&base_info->uuid, bdev_uuid) != 0) {
-		SPDK_ERRLOG("UUID mismatch for base bdev '%s'\n", base_info->name);
-		spdk_bdev_close(desc);
-		return -EINVAL;
+	if (status != 0) {
+		ctx->status = status;
+		raid_bdev_reshape_rollback(ctx);
+		return;
 	}
 
-	rc = spdk_bdev_module_claim_bdev(bdev, NULL, &g_raid_if);
-	if (rc != 0) {
-		SPDK_ERRLOG("Unable to claim this bdev as it is already claimed\n");
-		spdk_bdev_close(desc);
-		return rc;
+	ctx->quiesced = true;
+
+	/* No I/O can reference the base bdev info while the raid bdev is quiesced */
+	base_bdev_info = realloc(raid_bdev->base_bdev_info, num_base_bdevs * sizeof(*base_info));
+	if (base_bdev_info == NULL) {
+		ctx->status = -ENOMEM;
+		raid_bdev_reshape_rollback(ctx);
+		return;
 	}
+	raid_bdev->base_bdev_info = base_bdev_info;
 
-	SPDK_DEBUGLOG(bdev_raid, "bdev %s is claimed\n", bdev->name);
+	for (i = ctx->num_base_bdevs_old; i < num_base_bdevs; i++) {
+		base_info = &base_bdev_info[i];
 
-	base_info->app_thread_ch = spdk_bdev_get_io_channel(desc);
-	if (base_info->app_thread_ch == NULL) {
-		SPDK_ERRLOG("Failed to get io channel\n");
-		spdk_bdev_module_release_bdev(bdev);
-		spdk_bdev_close(desc);
-		return -ENOMEM;
+		memset(base_info, 0, sizeof(*base_info));
+		base_info->raid_bdev = raid_bdev;
+		base_info->name = ctx->names[i - ctx->num_base_bdevs_old];
+		ctx->names[i - ctx->num_base_bdevs_old] = NULL;
 	}
 
-	base_info->desc = desc;
-	base_info->blockcnt = bdev->blockcnt;
+	raid_bdev->num_base_bdevs = num_base_bdevs;
+	raid_bdev->num_base_bdevs_operational += ctx->num_base_bdevs;
+	raid_bdev->min_base_bdevs_operational += ctx->num_base_bdevs;
+	ctx->slots_added = true;
 
-	if (raid_bdev->superblock_enabled) {
-		uint64_t data_offset;
+	spdk_for_each_channel(raid_bdev, raid_bdev_channel_reshape_add_slots, ctx,
+			      raid_bdev_channels_reshape_add_slots_done);
+}
 
-		if (base_info->data_offset == 0) {
-			assert((RAID_BDEV_MIN_DATA_OFFSET_SIZE % spdk_bdev_get_data_block_size(bdev)) == 0);
-			data_offset = RAID_BDEV_MIN_DATA_OFFSET_SIZE / spdk_bdev_get_data_block_size(bdev);
-		} else {
-			data_offset = base_info->data_offset;
-		}
+/*
+ * brief:
+ * raid_bdev_reshape adds base bdevs to an online raid bdev and grows it. If the module
+ * places the existing data differently with more base bdevs, the data is moved in the
+ * background and I/O is served from the old or new layout depending on the offset. The
+ * progress is stored in the superblock, so the reshape continues after the raid bdev is
+ * assembled again. Calling this without base bdevs resumes a stopped reshape.
+ * params:
+ * raid_bdev - pointer to raid bdev
+ * base_bdev_names - names of the base bdevs to add
+ * num_base_bdevs - number of base bdevs to add
+ * cb_fn - callback function, called when the base bdevs are added and the reshape is started
+ * cb_ctx - argument to callback function
+ * returns:
+ * 0 - success
+ * non zero - failure
+ */
+int
+raid_bdev_reshape(struct raid_bdev *raid_bdev, const char **base_bdev_names,
+		  uint8_t num_base_bdevs, raid_base_bdev_cb cb_fn, void *cb_ctx)
+{
+	struct raid_bdev_reshape_ctx *ctx;
+	struct raid_base_bdev_info *base_info;
+	uint8_t i;
+	int rc;
 
-		if (bdev->optimal_io_boundary != 0) {
-			data_offset = spdk_divide_round_up(data_offset,
-							   bdev->optimal_io_boundary) * bdev->optimal_io_boundary;
-			if (base_info->data_offset != 0 && base_info->data_offset != data_offset) {
-				SPDK_WARNLOG("Data offset %lu on bdev '%s' is different than optimal value %lu\n",
-					     base_info->data_offset, base_info->name, data_offset);
-				data_offset = base_info->data_offset;
-			}
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	if (raid_bdev->module->reshape == NULL) {
+		SPDK_ERRLOG("Adding base bdevs is not supported by raid level '%s'\n",
+			    raid_bdev_level_to_str(raid_bdev->level));
+		return -ENOTSUP;
+	}
+
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE || raid_bdev->destroy_started) {
+		SPDK_ERRLOG("raid bdev '%s' is not online\n", raid_bdev->bdev.name);
+		return -ENODEV;
+	}
+
+	if (raid_bdev->process != NULL) {
+		SPDK_ERRLOG("raid bdev '%s' is in process\n", raid_bdev->bdev.name);
+		return -EBUSY;
+	}
+
+	if (num_base_bdevs == 0) {
+		if (!raid_bdev->reshape.restriping) {
+			SPDK_ERRLOG("No base bdevs to add to raid bdev '%s'\n", raid_bdev->bdev.name);
+			return -EINVAL;
 		}
 
-		base_info->data_offset = data_offset;
+		rc = raid_bdev_start_reshape(raid_bdev);
+		if (rc == 0 && cb_fn != NULL) {
+			cb_fn(cb_ctx, 0);
+		}
+		return rc;
 	}
 
-	if (base_info->data_offset >= bdev->blockcnt) {
-		SPDK_ERRLOG("Data offset %lu exceeds base bdev capacity %lu on bdev '%s'\n",
-			    base_info->data_offset, bdev->blockcnt, base_info->name);
-		rc = -EINVAL;
-		goto out;
+	if (raid_bdev->reshape.num_base_bdevs_old != 0) {
+		SPDK_ERRLOG("raid bdev '%s' is already being reshaped\n", raid_bdev->bdev.name);
+		return -EBUSY;
 	}
 
-	if (base_info->data_size == 0) {
-		base_info->data_size = bdev->blockcnt - base_info->data_offset;
-	} else if (base_info->data_offset + base_info->data_size > bdev->blockcnt) {
-		SPDK_ERRLOG("Data offset and size exceeds base bdev capacity %lu on bdev '%s'\n",
-			    bdev->blockcnt, base_info->name);
-		rc = -EINVAL;
-		goto out;
+	if (raid_bdev->num_base_bdevs + num_base_bdevs > UINT8_MAX ||
+	    (raid_bdev->sb != NULL && raid_bdev->sb->base_bdevs_size + num_base_bdevs > UINT8_MAX)) {
+		SPDK_ERRLOG("Too many base bdevs for raid bdev '%s'\n", raid_bdev->bdev.name);
+		return -EINVAL;
 	}
 
-	if (!raid_bdev->module->dif_supported && spdk_bdev_get_dif_type(bdev) != SPDK_DIF_DISABLE) {
-		SPDK_ERRLOG("Base bdev '%s' has DIF or DIX enabled - unsupported RAID configuration\n",
-			    bdev->name);
-		rc = -EINVAL;
-		goto out;
+	if (raid_bdev->module->reshape_window_size != NULL && !raid_bdev->superblock_enabled) {
+		SPDK_ERRLOG("raid bdev '%s' needs a superblock to move the data to the new layout\n",
+			    raid_bdev->bdev.name);
+		return -EINVAL;
 	}
 
-	/*
-	 * Set the raid bdev properties if this is the first base bdev configured,
-	 * otherwise - verify. Assumption is that all the base bdevs for any raid bdev should
-	 * have the same blocklen and metadata format.
-	 */
-	if (raid_bdev->bdev.blocklen == 0) {
-		raid_bdev->bdev.blocklen = bdev->blocklen;
-		raid_bdev->bdev.md_len = spdk_bdev_get_md_size(bdev);
-		raid_bdev->bdev.md_interleave = spdk_bdev_is_md_interleaved(bdev);
-		raid_bdev->bdev.dif_type = spdk_bdev_get_dif_type(bdev);
-		raid_bdev->bdev.dif_check_flags = bdev->dif_check_flags;
-		raid_bdev->bdev.dif_is_head_of_md = spdk_bdev_is_dif_head_of_md(bdev);
-	} else {
-		if (raid_bdev->bdev.blocklen != bdev->blocklen) {
-			SPDK_ERRLOG("Raid bdev '%s' blocklen %u differs from base bdev '%s' blocklen %u\n",
-				    raid_bdev->bdev.name, raid_bdev->bdev.blocklen, bdev->name, bdev->blocklen);
-			rc = -EINVAL;
-			goto out;
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (!base_info->is_configured || base_info->remove_scheduled) {
+			SPDK_ERRLOG("raid bdev '%s' is missing base bdevs\n", raid_bdev->bdev.name);
+			return -ENODEV;
 		}
+	}
 
-		if (raid_bdev->bdev.md_len != spdk_bdev_get_md_size(bdev) ||
-		    raid_bdev->bdev.md_interleave != spdk_bdev_is_md_interleaved(bdev) ||
-		    raid_bdev->bdev.dif_type != spdk_bdev_get_dif_type(bdev) ||
-		    raid_bdev->bdev.dif_check_flags != bdev->dif_check_flags ||
-		    raid_bdev->bdev.dif_is_head_of_md != spdk_bdev_is_dif_head_of_md(bdev)) {
-			SPDK_ERRLOG("Raid bdev '%s' has different metadata format than base bdev '%s'\n",
-				    raid_bdev->bdev.name, bdev->name);
-			rc = -EINVAL;
-			goto out;
-		}
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
 	}
 
-	base_info->configure_cb = cb_fn;
-	base_info->configure_cb_ctx = cb_ctx;
+	ctx->names = calloc(num_base_bdevs, sizeof(*ctx->names));
+	if (ctx->names == NULL) {
+		free(ctx);
+		return -ENOMEM;
+	}
 
-	if (existing) {
-		raid_bdev_configure_base_bdev_cont(base_info);
-	} else {
-		/* check for existing superblock when using a new bdev */
-		rc = raid_bdev_load_base_bdev_superblock(desc, base_info->app_thread_ch,
-				raid_bdev_configure_base_bdev_check_sb_cb, base_info);
-		if (rc) {
-			SPDK_ERRLOG("Failed to read bdev %s superblock: %s\n",
-				    bdev->name, spdk_strerror(-rc));
+	ctx->raid_bdev = raid_bdev;
+	ctx->num_base_bdevs = num_base_bdevs;
+	ctx->num_base_bdevs_old = raid_bdev->num_base_bdevs;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_ctx = cb_ctx;
+
+	for (i = 0; i < num_base_bdevs; i++) {
+		ctx->names[i] = strdup(base_bdev_names[i]);
+		if (ctx->names[i] == NULL) {
+			raid_bdev_reshape_ctx_free(ctx);
+			return -ENOMEM;
 		}
 	}
-out:
+
+	/* Also prevents starting another reshape */
+	raid_bdev->reshape.num_base_bdevs_old = ctx->num_base_bdevs_old;
+
+	rc = spdk_bdev_quiesce(&raid_bdev->bdev, &g_raid_if, raid_bdev_reshape_add_slots_quiesced, ctx);
 	if (rc != 0) {
-		raid_bdev_free_base_bdev_resource(base_info);
+		raid_bdev->reshape.num_base_bdevs_old = 0;
+		raid_bdev_reshape_ctx_free(ctx);
+		return rc;
 	}
-	return rc;
+
+	return 0;
 }
 
+/*
+ * brief:
+ * raid_bdev_start_scrub starts a background process reading the whole raid bdev and
+ * verifying that the mirrors or parity are consistent with the data, to find latent errors
+ * of the base bdevs before they are needed to recover data. The results are reported in
+ * the raid bdev info.
+ * params:
+ * raid_bdev - pointer to raid bdev
+ * repair - rewrite the blocks that don't match or couldn't be read from the redundant data
+ * returns:
+ * 0 - success
+ * non zero - failure
+ */
 int
-raid_bdev_add_base_bdev(struct raid_bdev *raid_bdev, const char *name,
-			raid_base_bdev_cb cb_fn, void *cb_ctx)
+raid_bdev_start_scrub(struct raid_bdev *raid_bdev, bool repair)
 {
-	struct raid_base_bdev_info *base_info = NULL, *iter;
-	int rc;
-
-	assert(name != NULL);
 	assert(spdk_get_thread() == spdk_thread_get_app_thread());
 
-	if (raid_bdev->process != NULL) {
-		SPDK_ERRLOG("raid bdev '%s' is in process\n",
-			    raid_bdev->bdev.name);
-		return -EPERM;
+	if (raid_bdev->module->submit_scrub_request == NULL) {
+		SPDK_ERRLOG("Scrub is not supported by raid level '%s'\n",
+			    raid_bdev_level_to_str(raid_bdev->level));
+		return -ENOTSUP;
 	}
 
-	if (raid_bdev->state == RAID_BDEV_STATE_CONFIGURING) {
-		struct spdk_bdev *bdev = spdk_bdev_get_by_name(name);
-
-		if (bdev != NULL) {
-			RAID_FOR_EACH_BASE_BDEV(raid_bdev, iter) {
-				if (iter->name == NULL &&
-				    spdk_uuid_compare(&bdev->uuid, &iter->uuid) == 0) {
-					base_info = iter;
-					break;
-				}
-			}
-		}
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE || raid_bdev->destroy_started) {
+		SPDK_ERRLOG("raid bdev '%s' is not online\n", raid_bdev->bdev.name);
+		return -ENODEV;
 	}
 
-	if (base_info == NULL || raid_bdev->state == RAID_BDEV_STATE_ONLINE) {
-		RAID_FOR_EACH_BASE_BDEV(raid_bdev, iter) {
-			if (iter->name == NULL && spdk_uuid_is_null(&iter->uuid)) {
-				base_info = iter;
-				break;
-			}
-		}
+	if (raid_bdev->process != NULL || raid_bdev->scrub.running ||
+	    (raid_bdev->bitmap != NULL && raid_bdev->bitmap->needs_resync)) {
+		SPDK_ERRLOG("raid bdev '%s' is in process\n", raid_bdev->bdev.name);
+		return -EBUSY;
 	}
 
-	if (base_info == NULL) {
-		SPDK_ERRLOG("no empty slot found in raid bdev '%s' for new base bdev '%s'\n",
-			    raid_bdev->bdev.name, name);
-		return -EINVAL;
+	if (!raid_bdev_base_bdevs_in_sync(raid_bdev)) {
+		SPDK_ERRLOG("raid bdev '%s' is degraded\n", raid_bdev->bdev.name);
+		return -ENODEV;
 	}
 
-	assert(base_info->is_configured == false);
+	return raid_bdev_start_scrub_process(raid_bdev, repair);
+}
 
-	if (raid_bdev->state == RAID_BDEV_STATE_ONLINE) {
-		assert(base_info->data_size != 0);
-		assert(base_info->desc == NULL);
+static void
+raid_bdev_process_stop(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+
+	if (process->state != RAID_PROCESS_STATE_RUNNING) {
+		return;
 	}
 
-	base_info->name = strdup(name);
-	if (base_info->name == NULL) {
-		return -ENOMEM;
+	/* The process is stopped after the current window is completed */
+	process->state = RAID_PROCESS_STATE_STOPPING;
+
+	if (process->status == 0) {
+		process->status = -ECANCELED;
 	}
 
-	rc = raid_bdev_configure_base_bdev(base_info, false, cb_fn, cb_ctx);
-	if (rc != 0 && (rc != -ENODEV || raid_bdev->state != RAID_BDEV_STATE_CONFIGURING)) {
-		SPDK_ERRLOG("base bdev '%s' configure failed: %s\n", name, spdk_strerror(-rc));
-		free(base_info->name);
-		base_info->name = NULL;
+	raid_bdev_process_stop_throttled(process);
+}
+
+/*
+ * brief:
+ * raid_bdev_stop_scrub stops the scrub running on a raid bdev. The results collected so far
+ * remain in the raid bdev info.
+ * params:
+ * raid_bdev - pointer to raid bdev
+ * returns:
+ * 0 - success
+ * non zero - failure
+ */
+int
+raid_bdev_stop_scrub(struct raid_bdev *raid_bdev)
+{
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	if (raid_bdev->process == NULL || raid_bdev->process->type != RAID_PROCESS_SCRUB) {
+		SPDK_ERRLOG("No scrub is running on raid bdev '%s'\n", raid_bdev->bdev.name);
+		return -ENOENT;
 	}
 
-	return rc;
+	spdk_thread_send_msg(raid_bdev->process->thread, raid_bdev_process_stop, raid_bdev->process);
+
+	return 0;
 }
 
 static int
@@ -3409,6 +5635,19 @@ raid_bdev_create_from_sb(const struct raid_bdev_superblock *sb, struct raid_bdev
 		base_info->data_size = sb_base_bdev->data_size;
 	}
 
+	if (sb->reshape_num_base_bdevs != 0) {
+		if (sb->reshape_num_base_bdevs >= sb->num_base_bdevs ||
+		    sb->reshape_offset > sb->raid_size ||
+		    raid_bdev->module->reshape_window_size == NULL) {
+			SPDK_ERRLOG("Invalid reshape state in raid bdev '%s' superblock\n", sb->name);
+			raid_bdev_cleanup_and_free(raid_bdev);
+			return -EINVAL;
+		}
+		raid_bdev->reshape.num_base_bdevs_old = sb->reshape_num_base_bdevs;
+		raid_bdev->reshape.offset = sb->reshape_offset;
+		raid_bdev->reshape.restriping = true;
+	}
+
 	*raid_bdev_out = raid_bdev;
 	return 0;
 }
@@ -3524,6 +5763,7 @@ raid_bdev_examine_sb(const struct raid_bdev_superblock *sb, struct spdk_bdev *bd
 	const struct raid_bdev_sb_base_bdev *sb_base_bdev = NULL;
 	struct raid_bdev *raid_bdev;
 	struct raid_base_bdev_info *iter, *base_info;
+	bool in_sync = false;
 	uint8_t i;
 	int rc;
 
@@ -3562,6 +5802,16 @@ raid_bdev_examine_sb(const struct raid_bdev_superblock *sb, struct spdk_bdev *bd
 			SPDK_DEBUGLOG(bdev_raid,
 				      "raid superblock seq_number on bdev %s (%lu) smaller than existing raid bdev %s (%lu)\n",
 				      bdev->name, sb->seq_number, raid_bdev->bdev.name, raid_bdev->sb->seq_number);
+			/*
+			 * The bdev's data was in sync when it was last part of the raid bdev if its
+			 * own superblock lists it as configured.
+			 */
+			for (i = 0; i < sb->base_bdevs_size; i++) {
+				if (spdk_uuid_compare(&sb->base_bdevs[i].uuid, spdk_bdev_get_uuid(bdev)) == 0) {
+					in_sync = sb->base_bdevs[i].state == RAID_SB_BASE_BDEV_CONFIGURED;
+					break;
+				}
+			}
 			/* use the current raid bdev superblock */
 			sb = raid_bdev->sb;
 		}
@@ -3617,7 +5867,10 @@ raid_bdev_examine_sb(const struct raid_bdev_superblock *sb, struct spdk_bdev *bd
 		       sb_base_bdev->state == RAID_SB_BASE_BDEV_FAILED);
 		assert(spdk_uuid_is_null(&base_info->uuid));
 		spdk_uuid_copy(&base_info->uuid, &sb_base_bdev->uuid);
-		SPDK_NOTICELOG("Re-adding bdev %s to raid bdev %s.\n", bdev->name, raid_bdev->bdev.name);
+		/* The write-intent bitmap tracks all writes made while the bdev was missing */
+		base_info->partial_rebuild = in_sync && raid_bdev->bitmap != NULL;
+		SPDK_NOTICELOG("Re-adding bdev %s to raid bdev %s%s.\n", bdev->name, raid_bdev->bdev.name,
+			       base_info->partial_rebuild ? " (partial rebuild)" : "");
 		rc = raid_bdev_configure_base_bdev(base_info, true, cb_fn, cb_ctx);
 		if (rc != 0) {
 			SPDK_ERRLOG("Failed to configure bdev %s as base bdev of raid %s: %s\n",
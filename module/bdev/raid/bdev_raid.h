@@ -15,7 +15,9 @@ enum raid_level {
 	INVALID_RAID_LEVEL	= -1,
 	RAID0			= 0,
 	RAID1			= 1,
+	RAID10			= 10,
 	RAID5F			= 95, /* 0x5f */
+	RAID6F			= 111, /* 0x6f */
 	CONCAT			= 99,
 };
 
@@ -46,9 +48,23 @@ enum raid_bdev_state {
 enum raid_process_type {
 	RAID_PROCESS_NONE,
 	RAID_PROCESS_REBUILD,
+	RAID_PROCESS_RESYNC,
+	RAID_PROCESS_RESHAPE,
+	RAID_PROCESS_SCRUB,
 	RAID_PROCESS_MAX
 };
 
+/* Selection of the base bdev that serves a read, for modules with redundant copies of data */
+enum raid_read_policy {
+	/* read from the base bdev with the fewest outstanding read blocks on the channel */
+	RAID_READ_POLICY_LEAST_OUTSTANDING,
+	/* weight the outstanding read blocks with the measured read latency of base bdevs */
+	RAID_READ_POLICY_LATENCY,
+	/* keep sequential read streams on the same base bdev */
+	RAID_READ_POLICY_SEQUENTIAL,
+	RAID_READ_POLICY_MAX
+};
+
 typedef void (*raid_base_bdev_cb)(void *ctx, int status);
 
 /*
@@ -106,6 +122,12 @@ struct raid_base_bdev_info {
 	/* Set to true to indicate that the base bdev is being removed because of a failure */
 	bool			is_failed;
 
+	/*
+	 * Set to true when the base bdev was re-added to the raid and only needs to catch up
+	 * on the regions marked dirty in the write-intent bitmap.
+	 */
+	bool			partial_rebuild;
+
 	/* callback for base bdev configuration */
 	raid_base_bdev_cb	configure_cb;
 
@@ -158,6 +180,14 @@ struct raid_bdev_io {
 		struct iovec		*iov;
 		struct iovec		iov_copy;
 	} split;
+
+	/* Write-intent bitmap state of this IO */
+	struct {
+		/* Channel which counted this IO as started, NULL if not marked */
+		struct raid_bdev_io_channel *ch;
+		uint64_t		gen;
+		TAILQ_ENTRY(raid_bdev_io) link;
+	} bitmap;
 };
 
 struct raid_bdev_process_request {
@@ -172,6 +202,25 @@ struct raid_bdev_process_request {
 	 * These are needed for re-using raid module I/O functions for process I/O. */
 	struct spdk_bdev_io bdev_io;
 	struct raid_bdev_io raid_io;
+	/* Resync request state */
+	struct {
+		enum spdk_bdev_io_type type;
+		uint64_t offset_blocks;
+		uint64_t num_blocks;
+		struct iovec iov;
+	} resync;
+	/* Scrub request state */
+	struct {
+		/* Rewrite the data that doesn't match its redundancy or couldn't be read */
+		bool repair;
+		/* Buffer of the same size as iov and md_buf, to read another copy for comparing */
+		struct iovec iov;
+		void *md_buf;
+		/* Results of the request, set by the module before completing it */
+		uint64_t mismatched_blocks;
+		uint64_t read_error_blocks;
+		uint64_t repaired_blocks;
+	} scrub;
 	TAILQ_ENTRY(raid_bdev_process_request) link;
 };
 
@@ -242,6 +291,45 @@ struct raid_bdev {
 
 	/* Raid bdev background process, e.g. rebuild */
 	struct raid_bdev_process	*process;
+
+	/* Write-intent bitmap, NULL if not used by this raid bdev */
+	struct raid_bdev_bitmap		*bitmap;
+
+	/* Read policy, used if supported by the module */
+	enum raid_read_policy		read_policy;
+
+	/*
+	 * Latency percentile of a base bdev after which a read is also sent to another
+	 * base bdev, 0 if reads are not hedged
+	 */
+	uint8_t				read_hedge_percentile;
+
+	/* State of adding base bdevs to the raid bdev */
+	struct {
+		/*
+		 * Number of base bdevs in the data layout before the reshape, 0 if no reshape
+		 * is in progress
+		 */
+		uint8_t			num_base_bdevs_old;
+		/* Set while the data is moved to the new layout */
+		bool			restriping;
+		/* The data up to this offset is already stored in the new layout */
+		uint64_t		offset;
+	} reshape;
+
+	/* Results of the current or last scrub */
+	struct {
+		/* Set once a scrub was started on this raid bdev */
+		bool			started;
+		/* Set from the start of a scrub until it is finished */
+		bool			running;
+		bool			repair;
+		/* 0 if the scrub is running or completed, otherwise the error that stopped it */
+		int			status;
+		uint64_t		mismatched_blocks;
+		uint64_t		read_error_blocks;
+		uint64_t		repaired_blocks;
+	} scrub;
 };
 
 #define RAID_FOR_EACH_BASE_BDEV(r, i) \
@@ -268,8 +356,16 @@ const char *raid_bdev_level_to_str(enum raid_level level);
 enum raid_bdev_state raid_bdev_str_to_state(const char *str);
 const char *raid_bdev_state_to_str(enum raid_bdev_state state);
 const char *raid_bdev_process_to_str(enum raid_process_type value);
+enum raid_read_policy raid_bdev_str_to_read_policy(const char *str);
+const char *raid_bdev_read_policy_to_str(enum raid_read_policy policy);
+int raid_bdev_set_read_policy(struct raid_bdev *raid_bdev, enum raid_read_policy policy,
+			      uint8_t hedge_percentile);
 void raid_bdev_write_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ctx *w);
 int raid_bdev_remove_base_bdev(struct spdk_bdev *base_bdev, raid_base_bdev_cb cb_fn, void *cb_ctx);
+int raid_bdev_reshape(struct raid_bdev *raid_bdev, const char **base_bdev_names,
+		      uint8_t num_base_bdevs, raid_base_bdev_cb cb_fn, void *cb_ctx);
+int raid_bdev_start_scrub(struct raid_bdev *raid_bdev, bool repair);
+int raid_bdev_stop_scrub(struct raid_bdev *raid_bdev);
 
 /*
  * RAID module descriptor
@@ -300,6 +396,9 @@ struct raid_bdev_module {
 	/* Set to true if this module supports DIF/DIX */
 	bool dif_supported;
 
+	/* Set to true if this module supports read policies and hedged reads */
+	bool read_policy_supported;
+
 	/*
 	 * Called when the raid is starting, right before changing the state to
 	 * online and registering the bdev. Parameters of the bdev like blockcnt
@@ -343,6 +442,36 @@ struct raid_bdev_module {
 	int (*submit_process_request)(struct raid_bdev_process_request *process_req,
 				      struct raid_bdev_io_channel *raid_ch);
 
+	/*
+	 * Handler for scrub requests. The module should verify that the redundant copies of the
+	 * data of the request's range are consistent and fill in the results of the request.
+	 * Returns the number of blocks the request covers, 0 if it can't be submitted now or a
+	 * negative errno. The request must not complete before this returns. Optional, scrub
+	 * is not supported without it.
+	 */
+	int (*submit_scrub_request)(struct raid_bdev_process_request *process_req,
+				    struct raid_bdev_io_channel *raid_ch);
+
+	/*
+	 * Called with the raid bdev quiesced when the base bdevs added by a reshape become part
+	 * of the data layout. The module should update its private data and return the new
+	 * block count of the raid bdev in blockcnt. Optional, adding base bdevs is not supported
+	 * without it.
+	 */
+	int (*reshape)(struct raid_bdev *raid_bdev, uint64_t *blockcnt);
+
+	/*
+	 * Returns how much of the range starting at offset can be moved to the new layout at
+	 * once, without overwriting data that is not moved yet. The result must not be greater
+	 * than max_size and not be 0. Required if the reshape changes the location of existing
+	 * data, which is then moved by a background process.
+	 */
+	uint64_t (*reshape_window_size)(struct raid_bdev *raid_bdev, uint64_t offset,
+					uint64_t max_size);
+
+	/* Called to add module specific information of an online raid bdev to JSON. Optional. */
+	void (*dump_info_json)(struct raid_bdev *raid_bdev, struct spdk_json_write_ctx *w);
+
 	TAILQ_ENTRY(raid_bdev_module) link;
 };
 
@@ -367,6 +496,7 @@ void raid_bdev_module_stop_done(struct raid_bdev *raid_bdev);
 struct spdk_io_channel *raid_bdev_channel_get_base_channel(struct raid_bdev_io_channel *raid_ch,
 		uint8_t idx);
 void *raid_bdev_channel_get_module_ctx(struct raid_bdev_io_channel *raid_ch);
+uint8_t raid_bdev_channel_get_num_base_bdevs(struct raid_bdev_io_channel *raid_ch);
 struct raid_base_bdev_info *raid_bdev_channel_get_base_info(struct raid_bdev_io_channel *raid_ch,
 		struct spdk_bdev *base_bdev);
 void raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status);
@@ -382,6 +512,17 @@ raid_bdev_base_bdev_slot(struct raid_base_bdev_info *base_info)
 	return base_info - base_info->raid_bdev->base_bdev_info;
 }
 
+/*
+ * Number of base bdevs the raid bdev data is laid out on. While base bdevs are being added,
+ * I/O channels use either this or num_base_bdevs, see raid_bdev_channel_get_num_base_bdevs().
+ */
+static inline uint8_t
+raid_bdev_layout_num_base_bdevs(struct raid_bdev *raid_bdev)
+{
+	return raid_bdev->reshape.num_base_bdevs_old != 0 ? raid_bdev->reshape.num_base_bdevs_old :
+	       raid_bdev->num_base_bdevs;
+}
+
 static inline void
 raid_bdev_io_set_default_status(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
 {
@@ -462,7 +603,7 @@ raid_bdev_flush_blocks(struct raid_base_bdev_info *base_info, struct spdk_io_cha
  */
 
 #define RAID_BDEV_SB_VERSION_MAJOR	1
-#define RAID_BDEV_SB_VERSION_MINOR	0
+#define RAID_BDEV_SB_VERSION_MINOR	2
 
 #define RAID_BDEV_SB_NAME_SIZE		64
 
@@ -525,7 +666,22 @@ struct raid_bdev_superblock {
 	/* number of raid base devices */
 	uint8_t			num_base_bdevs;
 
-	uint8_t			reserved[118];
+	uint8_t			reserved1[3];
+
+	/* size in bytes of the write-intent bitmap, 0 if the raid bdev doesn't have one */
+	uint32_t		bitmap_size;
+	/* offset in blocks from base device start to the start of the write-intent bitmap */
+	uint64_t		bitmap_offset;
+	/* number of raid bdev blocks represented by one bit of the write-intent bitmap */
+	uint64_t		bitmap_region_size;
+	/* seq_number of the superblock written along with the last valid write-intent bitmap */
+	uint64_t		bitmap_seq_number;
+	/* offset in blocks up to which the data is moved to the layout with all base bdevs */
+	uint64_t		reshape_offset;
+	/* number of base bdevs in the layout being reshaped, 0 if no reshape is in progress */
+	uint8_t			reshape_num_base_bdevs;
+
+	uint8_t			reserved[78];
 
 	/* size of the base bdevs array */
 	uint8_t			base_bdevs_size;
@@ -539,6 +695,15 @@ SPDK_STATIC_ASSERT(sizeof(struct raid_bdev_superblock) == 256, "incorrect size")
 SPDK_STATIC_ASSERT(RAID_BDEV_SB_MAX_LENGTH < RAID_BDEV_MIN_DATA_OFFSET_SIZE,
 		   "Incorrect min data offset");
 
+/* The write-intent bitmap is stored on every base bdev between the superblock and the data */
+#define RAID_BDEV_BITMAP_OFFSET_SIZE	(64*1024) /* 64 KiB */
+#define RAID_BDEV_BITMAP_MAX_SIZE	(32*1024) /* 32 KiB */
+
+SPDK_STATIC_ASSERT(RAID_BDEV_SB_MAX_LENGTH <= RAID_BDEV_BITMAP_OFFSET_SIZE,
+		   "Incorrect bitmap offset");
+SPDK_STATIC_ASSERT(RAID_BDEV_BITMAP_OFFSET_SIZE + RAID_BDEV_BITMAP_MAX_SIZE <=
+		   RAID_BDEV_MIN_DATA_OFFSET_SIZE, "Incorrect min data offset");
+
 typedef void (*raid_bdev_write_sb_cb)(int status, struct raid_bdev *raid_bdev, void *ctx);
 typedef void (*raid_bdev_load_sb_cb)(const struct raid_bdev_superblock *sb, int status, void *ctx);
 
@@ -550,9 +715,34 @@ void raid_bdev_write_superblock(struct raid_bdev *raid_bdev, raid_bdev_write_sb_
 int raid_bdev_load_base_bdev_superblock(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 					raid_bdev_load_sb_cb cb, void *cb_ctx);
 
+typedef void (*raid_bdev_bitmap_io_cb)(int status, struct raid_bdev *raid_bdev, void *ctx);
+
+void raid_bdev_write_bitmap(struct raid_bdev *raid_bdev, const uint8_t *bitmap,
+			    raid_bdev_bitmap_io_cb cb, void *cb_ctx);
+void raid_bdev_load_bitmap(struct raid_bdev *raid_bdev, uint8_t *bitmap,
+			   raid_bdev_bitmap_io_cb cb, void *cb_ctx);
+
 struct spdk_raid_bdev_opts {
 	/* Size of the background process window in KiB */
 	uint32_t process_window_size_kb;
+
+	/* Size of the region tracked by one bit of the write-intent bitmap in KiB, 0 - disabled */
+	uint32_t bitmap_region_size_kb;
+
+	/* Background process bandwidth limit in MiB/s, 0 - unlimited */
+	uint32_t process_max_mbytes_per_sec;
+
+	/* Background process request rate limit, 0 - unlimited */
+	uint32_t process_max_ios_per_sec;
+
+	/* Adjust the background process speed to the load of the base bdevs */
+	bool process_adaptive;
+
+	/*
+	 * Memory limit for the full stripe write and reconstruct requests of a raid5f io channel
+	 * in KiB, 0 - no limit. The stripe request pools don't shrink below their initial size.
+	 */
+	uint32_t raid5f_stripe_pool_max_kb;
 };
 
 void raid_bdev_get_opts(struct spdk_raid_bdev_opts *opts);
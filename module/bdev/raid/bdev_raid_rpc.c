@@ -607,6 +607,11 @@ SPDK_RPC_REGISTER("bdev_raid_remove_base_bdev", rpc_bdev_raid_remove_base_bdev,
 
 static const struct spdk_json_object_decoder rpc_bdev_raid_options_decoders[] = {
 	{"process_window_size_kb", offsetof(struct spdk_raid_bdev_opts, process_window_size_kb), spdk_json_decode_uint32, true},
+	{"bitmap_region_size_kb", offsetof(struct spdk_raid_bdev_opts, bitmap_region_size_kb), spdk_json_decode_uint32, true},
+	{"process_max_mbytes_per_sec", offsetof(struct spdk_raid_bdev_opts, process_max_mbytes_per_sec), spdk_json_decode_uint32, true},
+	{"process_max_ios_per_sec", offsetof(struct spdk_raid_bdev_opts, process_max_ios_per_sec), spdk_json_decode_uint32, true},
+	{"process_adaptive", offsetof(struct spdk_raid_bdev_opts, process_adaptive), spdk_json_decode_bool, true},
+	{"raid5f_stripe_pool_max_kb", offsetof(struct spdk_raid_bdev_opts, raid5f_stripe_pool_max_kb), spdk_json_decode_uint32, true},
 };
 
 static void
@@ -635,3 +640,318 @@ rpc_bdev_raid_set_options(struct spdk_jsonrpc_request *request, const struct spd
 }
 SPDK_RPC_REGISTER("bdev_raid_set_options", rpc_bdev_raid_set_options,
 		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
+/*
+ * Input structure for RPC bdev_raid_set_read_policy
+ */
+struct rpc_bdev_raid_set_read_policy {
+	/* Raid bdev name */
+	char			*name;
+
+	/* Read policy */
+	enum raid_read_policy	read_policy;
+
+	/* Latency percentile after which reads are hedged, 0 to disable */
+	uint8_t			hedge_percentile;
+};
+
+static int
+decode_read_policy(const struct spdk_json_val *val, void *out)
+{
+	int ret;
+	char *str = NULL;
+	enum raid_read_policy policy;
+
+	ret = spdk_json_decode_string(val, &str);
+	if (ret == 0 && str != NULL) {
+		policy = raid_bdev_str_to_read_policy(str);
+		if (policy == RAID_READ_POLICY_MAX) {
+			ret = -EINVAL;
+		} else {
+			*(enum raid_read_policy *)out = policy;
+		}
+	}
+
+	free(str);
+	return ret;
+}
+
+/*
+ * Decoder object for RPC bdev_raid_set_read_policy
+ */
+static const struct spdk_json_object_decoder rpc_bdev_raid_set_read_policy_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_raid_set_read_policy, name), spdk_json_decode_string},
+	{"read_policy", offsetof(struct rpc_bdev_raid_set_read_policy, read_policy), decode_read_policy, true},
+	{"hedge_percentile", offsetof(struct rpc_bdev_raid_set_read_policy, hedge_percentile), spdk_json_decode_uint8, true},
+};
+
+/*
+ * brief:
+ * bdev_raid_set_read_policy function is the RPC for changing the read policy of a raid bdev.
+ * It takes raid bdev name, read policy and hedge percentile as input.
+ * params:
+ * request - pointer to json rpc request
+ * params - pointer to request parameters
+ * returns:
+ * none
+ */
+static void
+rpc_bdev_raid_set_read_policy(struct spdk_jsonrpc_request *request,
+			      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_raid_set_read_policy req = {
+		.read_policy = RAID_READ_POLICY_LEAST_OUTSTANDING,
+	};
+	struct raid_bdev *raid_bdev;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_raid_set_read_policy_decoders,
+				    SPDK_COUNTOF(rpc_bdev_raid_set_read_policy_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	raid_bdev = raid_bdev_find_by_name(req.name);
+	if (raid_bdev == NULL) {
+		spdk_jsonrpc_send_error_response_fmt(request, -ENODEV, "raid bdev %s is not found in config",
+						     req.name);
+		goto cleanup;
+	}
+
+	rc = raid_bdev_set_read_policy(raid_bdev, req.read_policy, req.hedge_percentile);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response_fmt(request, rc,
+						     "Failed to set read policy of raid bdev %s: %s",
+						     req.name, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free(req.name);
+}
+SPDK_RPC_REGISTER("bdev_raid_set_read_policy", rpc_bdev_raid_set_read_policy, SPDK_RPC_RUNTIME)
+
+/*
+ * Input structure for RPC bdev_raid_reshape
+ */
+struct rpc_bdev_raid_reshape {
+	/* Raid bdev name */
+	char					*name;
+
+	/* Base bdevs to add */
+	struct rpc_bdev_raid_create_base_bdevs	base_bdevs;
+};
+
+/*
+ * Decoder object for RPC bdev_raid_reshape
+ */
+static const struct spdk_json_object_decoder rpc_bdev_raid_reshape_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_raid_reshape, name), spdk_json_decode_string},
+	{"base_bdevs", offsetof(struct rpc_bdev_raid_reshape, base_bdevs), decode_base_bdevs, true},
+};
+
+static void
+free_rpc_bdev_raid_reshape(struct rpc_bdev_raid_reshape *req)
+{
+	size_t i;
+
+	free(req->name);
+	for (i = 0; i < req->base_bdevs.num_base_bdevs; i++) {
+		free(req->base_bdevs.base_bdevs[i]);
+	}
+}
+
+static void
+rpc_bdev_raid_reshape_done(void *ctx, int status)
+{
+	struct spdk_jsonrpc_request *request = ctx;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response_fmt(request, status, "Failed to reshape RAID bdev: %s",
+						     spdk_strerror(-status));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+
+/*
+ * brief:
+ * bdev_raid_reshape function is the RPC for adding base bdevs to an online raid bdev.
+ * It takes raid bdev name and a list of base bdev names as input. Without base bdevs,
+ * it resumes a stopped reshape.
+ * params:
+ * request - pointer to json rpc request
+ * params - pointer to request parameters
+ * returns:
+ * none
+ */
+static void
+rpc_bdev_raid_reshape(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_raid_reshape req = {};
+	struct raid_bdev *raid_bdev;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_raid_reshape_decoders,
+				    SPDK_COUNTOF(rpc_bdev_raid_reshape_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	raid_bdev = raid_bdev_find_by_name(req.name);
+	if (raid_bdev == NULL) {
+		spdk_jsonrpc_send_error_response_fmt(request, -ENODEV, "raid bdev %s is not found in config",
+						     req.name);
+		goto cleanup;
+	}
+
+	rc = raid_bdev_reshape(raid_bdev, (const char **)req.base_bdevs.base_bdevs,
+			       req.base_bdevs.num_base_bdevs, rpc_bdev_raid_reshape_done, request);
+	if (rc != 0) {
+		rpc_bdev_raid_reshape_done(request, rc);
+	}
+
+cleanup:
+	free_rpc_bdev_raid_reshape(&req);
+}
+SPDK_RPC_REGISTER("bdev_raid_reshape", rpc_bdev_raid_reshape, SPDK_RPC_RUNTIME)
+
+/*
+ * Input structure for RPC bdev_raid_start_scrub
+ */
+struct rpc_bdev_raid_start_scrub {
+	/* Raid bdev name */
+	char	*name;
+
+	/* Rewrite the blocks that are found inconsistent */
+	bool	repair;
+};
+
+/*
+ * Decoder object for RPC bdev_raid_start_scrub
+ */
+static const struct spdk_json_object_decoder rpc_bdev_raid_start_scrub_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_raid_start_scrub, name), spdk_json_decode_string},
+	{"repair", offsetof(struct rpc_bdev_raid_start_scrub, repair), spdk_json_decode_bool, true},
+};
+
+/*
+ * brief:
+ * bdev_raid_start_scrub function is the RPC for verifying the consistency of the mirrors or
+ * parity of a raid bdev in the background. It takes raid bdev name and the repair flag as input.
+ * params:
+ * request - pointer to json rpc request
+ * params - pointer to request parameters
+ * returns:
+ * none
+ */
+static void
+rpc_bdev_raid_start_scrub(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct rpc_bdev_raid_start_scrub req = {
+		.repair = true,
+	};
+	struct raid_bdev *raid_bdev;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_raid_start_scrub_decoders,
+				    SPDK_COUNTOF(rpc_bdev_raid_start_scrub_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	raid_bdev = raid_bdev_find_by_name(req.name);
+	if (raid_bdev == NULL) {
+		spdk_jsonrpc_send_error_response_fmt(request, -ENODEV, "raid bdev %s is not found in config",
+						     req.name);
+		goto cleanup;
+	}
+
+	rc = raid_bdev_start_scrub(raid_bdev, req.repair);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response_fmt(request, rc,
+						     "Failed to start scrub of raid bdev %s: %s",
+						     req.name, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free(req.name);
+}
+SPDK_RPC_REGISTER("bdev_raid_start_scrub", rpc_bdev_raid_start_scrub, SPDK_RPC_RUNTIME)
+
+/*
+ * Input structure for RPC bdev_raid_stop_scrub
+ */
+struct rpc_bdev_raid_stop_scrub {
+	/* Raid bdev name */
+	char	*name;
+};
+
+/*
+ * Decoder object for RPC bdev_raid_stop_scrub
+ */
+static const struct spdk_json_object_decoder rpc_bdev_raid_stop_scrub_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_raid_stop_scrub, name), spdk_json_decode_string},
+};
+
+/*
+ * brief:
+ * bdev_raid_stop_scrub function is the RPC for stopping the scrub of a raid bdev.
+ * It takes raid bdev name as input.
+ * params:
+ * request - pointer to json rpc request
+ * params - pointer to request parameters
+ * returns:
+ * none
+ */
+static void
+rpc_bdev_raid_stop_scrub(struct spdk_jsonrpc_request *request,
+			 const struct spdk_json_val *params)
+{
+	struct rpc_bdev_raid_stop_scrub req = {};
+	struct raid_bdev *raid_bdev;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_raid_stop_scrub_decoders,
+				    SPDK_COUNTOF(rpc_bdev_raid_stop_scrub_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	raid_bdev = raid_bdev_find_by_name(req.name);
+	if (raid_bdev == NULL) {
+		spdk_jsonrpc_send_error_response_fmt(request, -ENODEV, "raid bdev %s is not found in config",
+						     req.name);
+		goto cleanup;
+	}
+
+	rc = raid_bdev_stop_scrub(raid_bdev);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response_fmt(request, rc,
+						     "Failed to stop scrub of raid bdev %s: %s",
+						     req.name, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free(req.name);
+}
+SPDK_RPC_REGISTER("bdev_raid_stop_scrub", rpc_bdev_raid_stop_scrub, SPDK_RPC_RUNTIME)
@@ -22,6 +22,20 @@ struct raid_bdev_write_sb_ctx {
 	struct spdk_bdev_io_wait_entry wait_entry;
 };
 
+struct raid_bdev_bitmap_io_ctx {
+	struct raid_bdev *raid_bdev;
+	int status;
+	uint8_t submitted;
+	uint32_t remaining;
+	uint8_t num_completed;
+	uint8_t *bitmap;
+	uint8_t *buf;
+	uint64_t num_blocks;
+	raid_bdev_bitmap_io_cb cb;
+	void *cb_ctx;
+	struct spdk_bdev_io_wait_entry wait_entry;
+};
+
 struct raid_bdev_read_sb_ctx {
 	struct spdk_bdev_desc *desc;
 	struct spdk_io_channel *ch;
@@ -49,14 +63,21 @@ raid_bdev_alloc_superblock(struct raid_bdev *raid_bdev, uint32_t block_size)
 	return 0;
 }
 
-void
-raid_bdev_free_superblock(struct raid_bdev *raid_bdev)
+static void
+raid_bdev_free_sb_io_buf(struct raid_bdev *raid_bdev)
 {
 	if (raid_bdev->sb_io_buf != NULL && raid_bdev->sb_io_buf != raid_bdev->sb) {
 		assert(spdk_bdev_is_md_interleaved(&raid_bdev->bdev));
 		spdk_dma_free(raid_bdev->sb_io_buf);
-		raid_bdev->sb_io_buf = NULL;
 	}
+	raid_bdev->sb_io_buf = NULL;
+	raid_bdev->sb_io_buf_size = 0;
+}
+
+void
+raid_bdev_free_superblock(struct raid_bdev *raid_bdev)
+{
+	raid_bdev_free_sb_io_buf(raid_bdev);
 	spdk_dma_free(raid_bdev->sb);
 	raid_bdev->sb = NULL;
 }
@@ -390,6 +411,12 @@ raid_bdev_write_superblock(struct raid_bdev *raid_bdev, raid_bdev_write_sb_cb cb
 	assert(sb != NULL);
 	assert(cb != NULL);
 
+	/* The superblock grows when base bdevs are added to the raid bdev */
+	if (raid_bdev->sb_io_buf_size < spdk_divide_round_up(sb->length,
+			sb->block_size) * raid_bdev->bdev.blocklen) {
+		raid_bdev_free_sb_io_buf(raid_bdev);
+	}
+
 	if (raid_bdev->sb_io_buf == NULL) {
 		rc = raid_bdev_alloc_sb_io_buf(raid_bdev);
 		if (rc != 0) {
@@ -409,6 +436,9 @@ raid_bdev_write_superblock(struct raid_bdev *raid_bdev, raid_bdev_write_sb_cb cb
 	ctx->cb_ctx = cb_ctx;
 
 	sb->seq_number++;
+	if (sb->bitmap_size != 0) {
+		sb->bitmap_seq_number = sb->seq_number;
+	}
 	raid_bdev_sb_update_crc(sb);
 
 	if (spdk_bdev_is_md_interleaved(&raid_bdev->bdev)) {
@@ -427,4 +457,231 @@ err:
 	cb(rc, raid_bdev, cb_ctx);
 }
 
+static struct raid_bdev_bitmap_io_ctx *
+raid_bdev_bitmap_io_ctx_alloc(struct raid_bdev *raid_bdev, raid_bdev_bitmap_io_cb cb, void *cb_ctx)
+{
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	struct raid_bdev_bitmap_io_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		return NULL;
+	}
+
+	ctx->raid_bdev = raid_bdev;
+	ctx->status = -ENODEV;
+	ctx->remaining = 1;
+	ctx->cb = cb;
+	ctx->cb_ctx = cb_ctx;
+	ctx->num_blocks = spdk_divide_round_up(sb->bitmap_size, sb->block_size);
+	ctx->buf = spdk_dma_zmalloc(ctx->num_blocks * raid_bdev->bdev.blocklen, 0x1000, NULL);
+	if (!ctx->buf) {
+		free(ctx);
+		return NULL;
+	}
+
+	return ctx;
+}
+
+static void
+raid_bdev_bitmap_io_ctx_free(struct raid_bdev_bitmap_io_ctx *ctx)
+{
+	spdk_dma_free(ctx->buf);
+	free(ctx);
+}
+
+static void
+raid_bdev_write_bitmap_base_bdev_done(struct raid_bdev_bitmap_io_ctx *ctx)
+{
+	if (--ctx->remaining == 0) {
+		/* The bitmap is valid if it was stored on at least one base bdev */
+		ctx->cb(ctx->num_completed > 0 ? 0 : ctx->status, ctx->raid_bdev, ctx->cb_ctx);
+		raid_bdev_bitmap_io_ctx_free(ctx);
+	}
+}
+
+static void
+raid_bdev_write_bitmap_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_bitmap_io_ctx *ctx = cb_arg;
+
+	if (success) {
+		ctx->num_completed++;
+	} else {
+		SPDK_ERRLOG("Failed to save write-intent bitmap on bdev %s\n", bdev_io->bdev->name);
+		ctx->status = -EIO;
+	}
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_write_bitmap_base_bdev_done(ctx);
+}
+
+static bool
+raid_bdev_bitmap_skip_base_bdev(struct raid_base_bdev_info *base_info)
+{
+	/*
+	 * raid_bdev_delete() sets remove_scheduled on all base bdevs, but the bitmap still has to
+	 * be stored on them when the raid bdev is stopping.
+	 */
+	return !base_info->is_configured ||
+	       (base_info->remove_scheduled && !base_info->raid_bdev->destroy_started);
+}
+
+static void
+_raid_bdev_write_bitmap(void *_ctx)
+{
+	struct raid_bdev_bitmap_io_ctx *ctx = _ctx;
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct raid_base_bdev_info *base_info;
+	uint8_t i;
+	int rc;
+
+	for (i = ctx->submitted; i < raid_bdev->num_base_bdevs; i++) {
+		base_info = &raid_bdev->base_bdev_info[i];
+
+		if (raid_bdev_bitmap_skip_base_bdev(base_info)) {
+			ctx->submitted++;
+			continue;
+		}
+
+		rc = spdk_bdev_write_blocks(base_info->desc, base_info->app_thread_ch, ctx->buf,
+					    raid_bdev->sb->bitmap_offset, ctx->num_blocks,
+					    raid_bdev_write_bitmap_cb, ctx);
+		if (rc == 0) {
+			ctx->remaining++;
+		} else if (rc == -ENOMEM) {
+			struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(base_info->desc);
+
+			ctx->wait_entry.bdev = bdev;
+			ctx->wait_entry.cb_fn = _raid_bdev_write_bitmap;
+			ctx->wait_entry.cb_arg = ctx;
+			spdk_bdev_queue_io_wait(bdev, base_info->app_thread_ch, &ctx->wait_entry);
+			return;
+		} else {
+			ctx->status = rc;
+		}
+
+		ctx->submitted++;
+	}
+
+	raid_bdev_write_bitmap_base_bdev_done(ctx);
+}
+
+void
+raid_bdev_write_bitmap(struct raid_bdev *raid_bdev, const uint8_t *bitmap,
+		       raid_bdev_bitmap_io_cb cb, void *cb_ctx)
+{
+	struct raid_bdev_bitmap_io_ctx *ctx;
+	uint32_t data_block_size = raid_bdev->sb->block_size;
+	uint32_t bitmap_size = raid_bdev->sb->bitmap_size;
+	uint64_t i;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(bitmap_size != 0);
+	assert(cb != NULL);
+
+	ctx = raid_bdev_bitmap_io_ctx_alloc(raid_bdev, cb, cb_ctx);
+	if (!ctx) {
+		cb(-ENOMEM, raid_bdev, cb_ctx);
+		return;
+	}
+
+	for (i = 0; i < ctx->num_blocks; i++) {
+		memcpy(ctx->buf + (i * raid_bdev->bdev.blocklen), bitmap + (i * data_block_size),
+		       spdk_min(data_block_size, bitmap_size - (i * data_block_size)));
+	}
+
+	_raid_bdev_write_bitmap(ctx);
+}
+
+static void _raid_bdev_load_bitmap(void *_ctx);
+
+static void
+raid_bdev_load_bitmap_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_bitmap_io_ctx *ctx = cb_arg;
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	uint32_t data_block_size = raid_bdev->sb->block_size;
+	uint32_t i;
+
+	if (success) {
+		/* Merge the bitmaps from all base bdevs - a region dirty on any of them is dirty */
+		for (i = 0; i < raid_bdev->sb->bitmap_size; i++) {
+			ctx->bitmap[i] |= ctx->buf[(i / data_block_size) * raid_bdev->bdev.blocklen +
+								 (i % data_block_size)];
+		}
+		ctx->num_completed++;
+	} else {
+		SPDK_ERRLOG("Failed to load write-intent bitmap from bdev %s\n", bdev_io->bdev->name);
+		ctx->status = -EIO;
+	}
+
+	spdk_bdev_free_io(bdev_io);
+
+	ctx->submitted++;
+	_raid_bdev_load_bitmap(ctx);
+}
+
+static void
+_raid_bdev_load_bitmap(void *_ctx)
+{
+	struct raid_bdev_bitmap_io_ctx *ctx = _ctx;
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct raid_base_bdev_info *base_info;
+	uint8_t i;
+	int rc;
+
+	for (i = ctx->submitted; i < raid_bdev->num_base_bdevs; i++) {
+		base_info = &raid_bdev->base_bdev_info[i];
+
+		if (raid_bdev_bitmap_skip_base_bdev(base_info)) {
+			ctx->submitted++;
+			continue;
+		}
+
+		rc = spdk_bdev_read_blocks(base_info->desc, base_info->app_thread_ch, ctx->buf,
+					   raid_bdev->sb->bitmap_offset, ctx->num_blocks,
+					   raid_bdev_load_bitmap_cb, ctx);
+		if (rc == 0) {
+			return;
+		} else if (rc == -ENOMEM) {
+			struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(base_info->desc);
+
+			ctx->wait_entry.bdev = bdev;
+			ctx->wait_entry.cb_fn = _raid_bdev_load_bitmap;
+			ctx->wait_entry.cb_arg = ctx;
+			spdk_bdev_queue_io_wait(bdev, base_info->app_thread_ch, &ctx->wait_entry);
+			return;
+		}
+
+		ctx->status = rc;
+		ctx->submitted++;
+	}
+
+	ctx->cb(ctx->num_completed > 0 ? 0 : ctx->status, raid_bdev, ctx->cb_ctx);
+	raid_bdev_bitmap_io_ctx_free(ctx);
+}
+
+void
+raid_bdev_load_bitmap(struct raid_bdev *raid_bdev, uint8_t *bitmap,
+		      raid_bdev_bitmap_io_cb cb, void *cb_ctx)
+{
+	struct raid_bdev_bitmap_io_ctx *ctx;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(raid_bdev->sb->bitmap_size != 0);
+	assert(cb != NULL);
+
+	ctx = raid_bdev_bitmap_io_ctx_alloc(raid_bdev, cb, cb_ctx);
+	if (!ctx) {
+		cb(-ENOMEM, raid_bdev, cb_ctx);
+		return;
+	}
+
+	ctx->bitmap = bitmap;
+
+	_raid_bdev_load_bitmap(ctx);
+}
+
 SPDK_LOG_REGISTER_COMPONENT(bdev_raid_sb)
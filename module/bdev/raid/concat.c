@@ -75,10 +75,14 @@ concat_submit_rw_request(struct raid_bdev_io *raid_io)
 	struct raid_base_bdev_info	*base_info;
 	struct spdk_io_channel		*base_ch;
 	struct spdk_bdev_ext_io_opts	io_opts = {};
+	uint8_t				num_base_bdevs;
 	int i;
 
+	/* Base bdevs being added by a reshape are not mapped yet */
+	num_base_bdevs = raid_bdev_channel_get_num_base_bdevs(raid_ch);
+
 	pd_idx = -1;
-	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+	for (i = 0; i < num_base_bdevs; i++) {
 		if (block_range[i].start > raid_io->offset_blocks) {
 			break;
 		}
@@ -177,10 +181,12 @@ concat_submit_null_payload_request(struct raid_bdev_io *raid_io)
 	uint64_t			offset_blocks;
 	uint64_t			num_blocks;
 	struct concat_block_range	*block_range;
+	uint8_t				num_base_bdevs;
 	int				i, start_idx, stop_idx;
 
 	raid_bdev = raid_io->raid_bdev;
 	block_range = raid_bdev->module_private;
+	num_base_bdevs = raid_bdev_channel_get_num_base_bdevs(raid_io->raid_ch);
 
 	offset_blocks = raid_io->offset_blocks;
 	num_blocks = raid_io->num_blocks;
@@ -189,7 +195,7 @@ concat_submit_null_payload_request(struct raid_bdev_io *raid_io)
 	/*
 	 * Go through all base bdevs, find the first bdev and the last bdev
 	 */
-	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+	for (i = 0; i < num_base_bdevs; i++) {
 		/* skip the bdevs before the offset_blocks */
 		if (offset_blocks >= block_range[i].start + block_range[i].length) {
 			continue;
@@ -316,6 +322,43 @@ concat_stop(struct raid_bdev *raid_bdev)
 	return true;
 }
 
+static int
+concat_reshape(struct raid_bdev *raid_bdev, uint64_t *blockcnt)
+{
+	uint8_t num_base_bdevs_old = raid_bdev->reshape.num_base_bdevs_old;
+	struct concat_block_range *block_range;
+	struct raid_base_bdev_info *base_info;
+	uint64_t total_blockcnt;
+	uint8_t i;
+
+	block_range = realloc(raid_bdev->module_private,
+			      raid_bdev->num_base_bdevs * sizeof(struct concat_block_range));
+	if (!block_range) {
+		SPDK_ERRLOG("Can not allocate block_range, num_base_bdevs: %u",
+			    raid_bdev->num_base_bdevs);
+		return -ENOMEM;
+	}
+	raid_bdev->module_private = block_range;
+
+	/* The added base bdevs are appended, the existing data stays in place */
+	total_blockcnt = block_range[num_base_bdevs_old - 1].start +
+			 block_range[num_base_bdevs_old - 1].length;
+
+	for (i = num_base_bdevs_old; i < raid_bdev->num_base_bdevs; i++) {
+		base_info = &raid_bdev->base_bdev_info[i];
+		base_info->data_size = (base_info->data_size >> raid_bdev->strip_size_shift) <<
+				       raid_bdev->strip_size_shift;
+
+		block_range[i].start = total_blockcnt;
+		block_range[i].length = base_info->data_size;
+		total_blockcnt += base_info->data_size;
+	}
+
+	*blockcnt = total_blockcnt;
+
+	return 0;
+}
+
 static struct raid_bdev_module g_concat_module = {
 	.level = CONCAT,
 	.base_bdevs_min = 1,
@@ -324,6 +367,7 @@ static struct raid_bdev_module g_concat_module = {
 	.stop = concat_stop,
 	.submit_rw_request = concat_submit_rw_request,
 	.submit_null_payload_request = concat_submit_null_payload_request,
+	.reshape = concat_reshape,
 };
 RAID_MODULE_REGISTER(&g_concat_module)
 
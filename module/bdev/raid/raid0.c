@@ -13,6 +13,58 @@
 
 #include "spdk/log.h"
 
+struct raid0_info {
+	/* The parent raid bdev */
+	struct raid_bdev *raid_bdev;
+};
+
+/*
+ * Context of a request spanning multiple strips. The request is submitted to the base bdevs
+ * directly, one base bdev request per strip, instead of being split by the bdev layer.
+ */
+struct raid0_split_io {
+	/* The iovecs of the request, cut at the strip boundaries */
+	struct iovec			*iovs;
+	int				iovcnt_max;
+
+	/* Index in iovs of the first iovec of the next base bdev request */
+	int				iov_idx;
+
+	TAILQ_ENTRY(raid0_split_io)	link;
+};
+
+struct raid0_io_channel {
+	/* Split I/O contexts not in use, they are kept to reuse their iovec arrays */
+	TAILQ_HEAD(, raid0_split_io)	split_ios;
+};
+
+static int
+raid0_verify_read(struct spdk_bdev_io *bdev_io)
+{
+	if (spdk_unlikely(spdk_bdev_get_dif_type(bdev_io->bdev) != SPDK_DIF_DISABLE &&
+			  bdev_io->bdev->dif_check_flags & SPDK_DIF_FLAGS_REFTAG_CHECK)) {
+		return raid_bdev_verify_dix_reftag(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+						   bdev_io->u.bdev.md_buf, bdev_io->u.bdev.num_blocks,
+						   bdev_io->bdev, bdev_io->u.bdev.offset_blocks);
+	}
+
+	return 0;
+}
+
+static int
+raid0_verify_write(struct raid_bdev_io *raid_io)
+{
+	struct spdk_bdev *bdev = &raid_io->raid_bdev->bdev;
+
+	if (spdk_unlikely(spdk_bdev_get_dif_type(bdev) != SPDK_DIF_DISABLE &&
+			  bdev->dif_check_flags & SPDK_DIF_FLAGS_REFTAG_CHECK)) {
+		return raid_bdev_verify_dix_reftag(raid_io->iovs, raid_io->iovcnt, raid_io->md_buf,
+						   raid_io->num_blocks, bdev, raid_io->offset_blocks);
+	}
+
+	return 0;
+}
+
 /*
  * brief:
  * raid0_bdev_io_completion function is called by lower layers to notify raid
@@ -28,21 +80,12 @@ static void
 raid0_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
 	struct raid_bdev_io *raid_io = cb_arg;
-	int rc;
 
 	if (success) {
-		if (spdk_unlikely(bdev_io->type == SPDK_BDEV_IO_TYPE_READ &&
-				  spdk_bdev_get_dif_type(bdev_io->bdev) != SPDK_DIF_DISABLE &&
-				  bdev_io->bdev->dif_check_flags & SPDK_DIF_FLAGS_REFTAG_CHECK)) {
-
-			rc = raid_bdev_verify_dix_reftag(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
-							 bdev_io->u.bdev.md_buf, bdev_io->u.bdev.num_blocks, bdev_io->bdev,
-							 bdev_io->u.bdev.offset_blocks);
-			if (rc != 0) {
-				SPDK_ERRLOG("Reftag verify failed.\n");
-				raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
-				return;
-			}
+		if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ && raid0_verify_read(bdev_io) != 0) {
+			SPDK_ERRLOG("Reftag verify failed.\n");
+			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+			return;
 		}
 
 		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
@@ -63,10 +106,212 @@ _raid0_submit_rw_request(void *_raid_io)
 	raid0_submit_rw_request(raid_io);
 }
 
+static struct raid0_split_io *
+raid0_get_split_io(struct raid_bdev_io *raid_io, uint64_t num_strips)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid0_io_channel *raid0_ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	uint64_t strip_len = (uint64_t)raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	uint64_t boundary;
+	struct raid0_split_io *split_io;
+	struct iovec *iov;
+	size_t iov_offset = 0;
+	int iovcnt_max, i, n = 0;
+
+	split_io = TAILQ_FIRST(&raid0_ch->split_ios);
+	if (split_io == NULL) {
+		split_io = calloc(1, sizeof(*split_io));
+		if (split_io == NULL) {
+			return NULL;
+		}
+		TAILQ_INSERT_HEAD(&raid0_ch->split_ios, split_io, link);
+	}
+
+	/* Each strip boundary cuts at most one iovec in two */
+	iovcnt_max = raid_io->iovcnt + num_strips - 1;
+	if (split_io->iovcnt_max < iovcnt_max) {
+		iov = realloc(split_io->iovs, iovcnt_max * sizeof(*iov));
+		if (iov == NULL) {
+			return NULL;
+		}
+		split_io->iovs = iov;
+		split_io->iovcnt_max = iovcnt_max;
+	}
+
+	boundary = (raid_bdev->strip_size - (raid_io->offset_blocks & (raid_bdev->strip_size - 1))) *
+		   raid_bdev->bdev.blocklen;
+	for (i = 0; i < raid_io->iovcnt;) {
+		iov = &split_io->iovs[n++];
+		iov->iov_base = (char *)raid_io->iovs[i].iov_base + iov_offset;
+		iov->iov_len = spdk_min(raid_io->iovs[i].iov_len - iov_offset, boundary);
+
+		iov_offset += iov->iov_len;
+		if (iov_offset == raid_io->iovs[i].iov_len) {
+			iov_offset = 0;
+			i++;
+		}
+
+		boundary -= iov->iov_len;
+		if (boundary == 0) {
+			boundary = strip_len;
+		}
+	}
+	assert(n <= split_io->iovcnt_max);
+
+	split_io->iov_idx = 0;
+	TAILQ_REMOVE(&raid0_ch->split_ios, split_io, link);
+
+	return split_io;
+}
+
+static void
+raid0_put_split_io(struct raid_bdev_io *raid_io)
+{
+	struct raid0_io_channel *raid0_ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	struct raid0_split_io *split_io = raid_io->module_private;
+
+	raid_io->module_private = NULL;
+	TAILQ_INSERT_HEAD(&raid0_ch->split_ios, split_io, link);
+}
+
+static bool
+raid0_split_io_complete_part(struct raid_bdev_io *raid_io, uint64_t completed,
+			     enum spdk_bdev_io_status status)
+{
+	if (raid_io->base_bdev_io_remaining == completed) {
+		raid0_put_split_io(raid_io);
+	}
+
+	return raid_bdev_io_complete_part(raid_io, completed, status);
+}
+
+static void
+raid0_split_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	if (success && bdev_io->type == SPDK_BDEV_IO_TYPE_READ && raid0_verify_read(bdev_io) != 0) {
+		SPDK_ERRLOG("Reftag verify failed.\n");
+		success = false;
+	}
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid0_split_io_complete_part(raid_io, 1, success ?
+				     SPDK_BDEV_IO_STATUS_SUCCESS :
+				     SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+/*
+ * brief:
+ * raid0_submit_split_request function submits a read or write spanning multiple strips
+ * to the member disks, one request per strip, in a single pass. If a request fails with
+ * -ENOMEM, it queues itself and continues with the next strip later.
+ * params:
+ * raid_io
+ * returns:
+ * none
+ */
+static void
+raid0_submit_split_request(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev		*raid_bdev = raid_io->raid_bdev;
+	struct spdk_bdev_ext_io_opts	io_opts = {};
+	struct raid0_split_io		*split_io;
+	struct raid_base_bdev_info	*base_info;
+	struct spdk_io_channel		*base_ch;
+	uint64_t			start_strip, end_strip, strip;
+	uint64_t			offset_blocks, num_blocks;
+	uint64_t			pd_lba;
+	uint64_t			len;
+	uint8_t				num_base_bdevs;
+	uint8_t				pd_idx;
+	int				iovcnt;
+	int				ret;
+
+	num_base_bdevs = raid_bdev_channel_get_num_base_bdevs(raid_io->raid_ch);
+	start_strip = raid_io->offset_blocks >> raid_bdev->strip_size_shift;
+	end_strip = (raid_io->offset_blocks + raid_io->num_blocks - 1) >> raid_bdev->strip_size_shift;
+
+	if (raid_io->base_bdev_io_remaining == 0) {
+		if (raid_io->type == SPDK_BDEV_IO_TYPE_WRITE && raid0_verify_write(raid_io) != 0) {
+			SPDK_ERRLOG("bdev io submit error due to DIX verify failure\n");
+			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+			return;
+		}
+
+		split_io = raid0_get_split_io(raid_io, end_strip - start_strip + 1);
+		if (spdk_unlikely(split_io == NULL)) {
+			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_NOMEM);
+			return;
+		}
+
+		raid_io->module_private = split_io;
+		raid_io->base_bdev_io_remaining = end_strip - start_strip + 1;
+	}
+
+	split_io = raid_io->module_private;
+
+	io_opts.size = sizeof(io_opts);
+	io_opts.memory_domain = raid_io->memory_domain;
+	io_opts.memory_domain_ctx = raid_io->memory_domain_ctx;
+
+	for (strip = start_strip + raid_io->base_bdev_io_submitted; strip <= end_strip; strip++) {
+		offset_blocks = spdk_max(strip << raid_bdev->strip_size_shift, raid_io->offset_blocks);
+		num_blocks = spdk_min((strip + 1) << raid_bdev->strip_size_shift,
+				      raid_io->offset_blocks + raid_io->num_blocks) - offset_blocks;
+
+		pd_idx = strip % num_base_bdevs;
+		pd_lba = ((strip / num_base_bdevs) << raid_bdev->strip_size_shift) +
+			 (offset_blocks & (raid_bdev->strip_size - 1));
+		base_info = &raid_bdev->base_bdev_info[pd_idx];
+		base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, pd_idx);
+
+		/* The strip's iovecs follow the previous strip's in the cut iovec array */
+		len = 0;
+		for (iovcnt = 0; len < num_blocks * raid_bdev->bdev.blocklen; iovcnt++) {
+			assert(split_io->iov_idx + iovcnt < split_io->iovcnt_max);
+			len += split_io->iovs[split_io->iov_idx + iovcnt].iov_len;
+		}
+		assert(len == num_blocks * raid_bdev->bdev.blocklen);
+
+		io_opts.metadata = raid_io->md_buf == NULL ? NULL : (char *)raid_io->md_buf +
+				   (offset_blocks - raid_io->offset_blocks) * raid_bdev->bdev.md_len;
+
+		if (raid_io->type == SPDK_BDEV_IO_TYPE_READ) {
+			ret = raid_bdev_readv_blocks_ext(base_info, base_ch,
+							 &split_io->iovs[split_io->iov_idx], iovcnt,
+							 pd_lba, num_blocks, raid0_split_io_completion,
+							 raid_io, &io_opts);
+		} else {
+			ret = raid_bdev_writev_blocks_ext(base_info, base_ch,
+							  &split_io->iovs[split_io->iov_idx], iovcnt,
+							  pd_lba, num_blocks, raid0_split_io_completion,
+							  raid_io, &io_opts);
+		}
+
+		if (spdk_likely(ret == 0)) {
+			raid_io->base_bdev_io_submitted++;
+			split_io->iov_idx += iovcnt;
+		} else if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+						base_ch, _raid0_submit_rw_request);
+			return;
+		} else {
+			SPDK_ERRLOG("bdev io submit error not due to ENOMEM, it should not happen\n");
+			assert(false);
+			raid0_split_io_complete_part(raid_io, end_strip - strip + 1,
+						     SPDK_BDEV_IO_STATUS_FAILED);
+			return;
+		}
+	}
+}
+
 /*
  * brief:
  * raid0_submit_rw_request function is used to submit I/O to the correct
- * member disk for raid0 bdevs.
+ * member disk for raid0 bdevs. I/O within a single strip is passed to the
+ * member disk as is, with the iovecs and metadata of the raid bdev I/O.
  * params:
  * raid_io
  * returns:
@@ -82,6 +327,7 @@ raid0_submit_rw_request(struct raid_bdev_io *raid_io)
 	uint32_t			offset_in_strip;
 	uint64_t			pd_lba;
 	uint64_t			pd_blocks;
+	uint8_t				num_base_bdevs;
 	uint8_t				pd_idx;
 	int				ret = 0;
 	uint64_t			start_strip;
@@ -89,18 +335,19 @@ raid0_submit_rw_request(struct raid_bdev_io *raid_io)
 	struct raid_base_bdev_info	*base_info;
 	struct spdk_io_channel		*base_ch;
 
+	/* Differs from the raid bdev's number of base bdevs while a reshape is in progress */
+	num_base_bdevs = raid_bdev_channel_get_num_base_bdevs(raid_ch);
+
 	start_strip = raid_io->offset_blocks >> raid_bdev->strip_size_shift;
 	end_strip = (raid_io->offset_blocks + raid_io->num_blocks - 1) >>
 		    raid_bdev->strip_size_shift;
-	if (start_strip != end_strip && raid_bdev->num_base_bdevs > 1) {
-		assert(false);
-		SPDK_ERRLOG("I/O spans strip boundary!\n");
-		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+	if (start_strip != end_strip && num_base_bdevs > 1) {
+		raid0_submit_split_request(raid_io);
 		return;
 	}
 
-	pd_strip = start_strip / raid_bdev->num_base_bdevs;
-	pd_idx = start_strip % raid_bdev->num_base_bdevs;
+	pd_strip = start_strip / num_base_bdevs;
+	pd_idx = start_strip % num_base_bdevs;
 	offset_in_strip = raid_io->offset_blocks & (raid_bdev->strip_size - 1);
 	pd_lba = (pd_strip << raid_bdev->strip_size_shift) + offset_in_strip;
 	pd_blocks = raid_io->num_blocks;
@@ -129,17 +376,10 @@ raid0_submit_rw_request(struct raid_bdev_io *raid_io)
 						 pd_lba, pd_blocks, raid0_bdev_io_completion,
 						 raid_io, &io_opts);
 	} else if (raid_io->type == SPDK_BDEV_IO_TYPE_WRITE) {
-		struct spdk_bdev *bdev = &base_info->raid_bdev->bdev;
-
-		if (spdk_unlikely(spdk_bdev_get_dif_type(bdev) != SPDK_DIF_DISABLE &&
-				  bdev->dif_check_flags & SPDK_DIF_FLAGS_REFTAG_CHECK)) {
-			ret = raid_bdev_verify_dix_reftag(raid_io->iovs, raid_io->iovcnt, io_opts.metadata,
-							  pd_blocks, bdev, raid_io->offset_blocks);
-			if (ret != 0) {
-				SPDK_ERRLOG("bdev io submit error due to DIX verify failure\n");
-				raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
-				return;
-			}
+		if (raid0_verify_write(raid_io) != 0) {
+			SPDK_ERRLOG("bdev io submit error due to DIX verify failure\n");
+			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+			return;
 		}
 
 		ret = raid_bdev_writev_blocks_ext(base_info, base_ch,
@@ -300,10 +540,12 @@ raid0_submit_null_payload_request(struct raid_bdev_io *raid_io)
 	int				ret;
 	struct raid_base_bdev_info	*base_info;
 	struct spdk_io_channel		*base_ch;
+	uint8_t				num_base_bdevs;
 
 	raid_bdev = raid_io->raid_bdev;
+	num_base_bdevs = raid_bdev_channel_get_num_base_bdevs(raid_io->raid_ch);
 
-	_raid0_get_io_range(&io_range, raid_bdev->num_base_bdevs,
+	_raid0_get_io_range(&io_range, num_base_bdevs,
 			    raid_bdev->strip_size, raid_bdev->strip_size_shift,
 			    raid_io->offset_blocks, raid_io->num_blocks);
 
@@ -319,7 +561,7 @@ raid0_submit_null_payload_request(struct raid_bdev_io *raid_io)
 		/* base_bdev is started from start_disk to end_disk.
 		 * It is possible that index of start_disk is larger than end_disk's.
 		 */
-		disk_idx = (io_range.start_disk + raid_io->base_bdev_io_submitted) % raid_bdev->num_base_bdevs;
+		disk_idx = (io_range.start_disk + raid_io->base_bdev_io_submitted) % num_base_bdevs;
 		base_info = &raid_bdev->base_bdev_info[disk_idx];
 		base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, disk_idx);
 
@@ -359,12 +601,54 @@ raid0_submit_null_payload_request(struct raid_bdev_io *raid_io)
 	}
 }
 
+static int
+raid0_ioch_create(void *io_device, void *ctx_buf)
+{
+	struct raid0_io_channel *raid0_ch = ctx_buf;
+
+	TAILQ_INIT(&raid0_ch->split_ios);
+
+	return 0;
+}
+
+static void
+raid0_ioch_destroy(void *io_device, void *ctx_buf)
+{
+	struct raid0_io_channel *raid0_ch = ctx_buf;
+	struct raid0_split_io *split_io;
+
+	while ((split_io = TAILQ_FIRST(&raid0_ch->split_ios))) {
+		TAILQ_REMOVE(&raid0_ch->split_ios, split_io, link);
+		free(split_io->iovs);
+		free(split_io);
+	}
+}
+
+static void
+raid0_io_device_unregister_done(void *io_device)
+{
+	struct raid0_info *r0info = io_device;
+
+	raid_bdev_module_stop_done(r0info->raid_bdev);
+
+	free(r0info);
+}
+
 static int
 raid0_start(struct raid_bdev *raid_bdev)
 {
 	uint64_t min_blockcnt = UINT64_MAX;
 	uint64_t base_bdev_data_size;
 	struct raid_base_bdev_info *base_info;
+	struct raid0_info *r0info;
+	char name[256];
+
+	r0info = calloc(1, sizeof(*r0info));
+	if (!r0info) {
+		SPDK_ERRLOG("Failed to allocate RAID0 info device structure\n");
+		return -ENOMEM;
+	}
+	r0info->raid_bdev = raid_bdev;
 
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
 		/* Calculate minimum block count from all base bdevs */
@@ -385,20 +669,46 @@ raid0_start(struct raid_bdev *raid_bdev)
 	SPDK_DEBUGLOG(bdev_raid0, "min blockcount %" PRIu64 ",  numbasedev %u, strip size shift %u\n",
 		      min_blockcnt, raid_bdev->num_base_bdevs, raid_bdev->strip_size_shift);
 
-	raid_bdev->bdev.blockcnt = base_bdev_data_size * raid_bdev->num_base_bdevs;
+	raid_bdev->bdev.blockcnt = base_bdev_data_size * raid_bdev_layout_num_base_bdevs(raid_bdev);
 
+	/*
+	 * Reads/writes spanning multiple strips are split by the module itself, the strip
+	 * size is only reported as a hint for the upper layers.
+	 */
 	if (raid_bdev->num_base_bdevs > 1) {
 		raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
-		raid_bdev->bdev.split_on_optimal_io_boundary = true;
 	} else {
-		/* Do not need to split reads/writes on single bdev RAID modules. */
 		raid_bdev->bdev.optimal_io_boundary = 0;
-		raid_bdev->bdev.split_on_optimal_io_boundary = false;
 	}
+	raid_bdev->bdev.split_on_optimal_io_boundary = false;
+
+	raid_bdev->module_private = r0info;
+
+	snprintf(name, sizeof(name), "raid0_%s", raid_bdev->bdev.name);
+	spdk_io_device_register(r0info, raid0_ioch_create, raid0_ioch_destroy,
+				sizeof(struct raid0_io_channel), name);
 
 	return 0;
 }
 
+static bool
+raid0_stop(struct raid_bdev *raid_bdev)
+{
+	struct raid0_info *r0info = raid_bdev->module_private;
+
+	spdk_io_device_unregister(r0info, raid0_io_device_unregister_done);
+
+	return false;
+}
+
+static struct spdk_io_channel *
+raid0_get_io_channel(struct raid_bdev *raid_bdev)
+{
+	struct raid0_info *r0info = raid_bdev->module_private;
+
+	return spdk_get_io_channel(r0info);
+}
+
 static bool
 raid0_resize(struct raid_bdev *raid_bdev)
 {
@@ -434,15 +744,62 @@ raid0_resize(struct raid_bdev *raid_bdev)
 	return true;
 }
 
+static int
+raid0_reshape(struct raid_bdev *raid_bdev, uint64_t *blockcnt)
+{
+	/* All base bdevs, including the added ones, have the same data size */
+	*blockcnt = raid_bdev->base_bdev_info[0].data_size * raid_bdev->num_base_bdevs;
+
+	if (raid_bdev->num_base_bdevs > 1) {
+		raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
+	}
+
+	return 0;
+}
+
+/*
+ * Strip X of the new layout is stored where strip (X / N') * N + X % N' of the old layout was,
+ * or on an added base bdev. It can be written only if that old strip was already moved, so the
+ * window ends before the first strip that would overwrite data not yet read.
+ */
+static uint64_t
+raid0_reshape_window_size(struct raid_bdev *raid_bdev, uint64_t offset, uint64_t max_size)
+{
+	uint8_t num_base_bdevs_old = raid_bdev->reshape.num_base_bdevs_old;
+	uint8_t num_base_bdevs = raid_bdev->num_base_bdevs;
+	uint64_t done_strips = offset >> raid_bdev->strip_size_shift;
+	uint64_t end = offset + max_size;
+	uint64_t strip, strip_old;
+
+	assert(num_base_bdevs_old != 0 && num_base_bdevs_old < num_base_bdevs);
+
+	for (strip = done_strips; (strip << raid_bdev->strip_size_shift) < end; strip++) {
+		if (strip % num_base_bdevs >= num_base_bdevs_old) {
+			continue;
+		}
+
+		strip_old = (strip / num_base_bdevs) * num_base_bdevs_old + strip % num_base_bdevs;
+		if (strip_old != strip && strip_old >= done_strips) {
+			break;
+		}
+	}
+
+	return spdk_min(end, strip << raid_bdev->strip_size_shift) - offset;
+}
+
 static struct raid_bdev_module g_raid0_module = {
 	.level = RAID0,
 	.base_bdevs_min = 1,
 	.memory_domains_supported = true,
 	.dif_supported = true,
 	.start = raid0_start,
+	.stop = raid0_stop,
+	.get_io_channel = raid0_get_io_channel,
 	.submit_rw_request = raid0_submit_rw_request,
 	.submit_null_payload_request = raid0_submit_null_payload_request,
 	.resize = raid0_resize,
+	.reshape = raid0_reshape,
+	.reshape_window_size = raid0_reshape_window_size,
 };
 RAID_MODULE_REGISTER(&g_raid0_module)
 
@@ -5,15 +5,97 @@
 
 #include "bdev_raid.h"
 
+#include "spdk/env.h"
 #include "spdk/likely.h"
 #include "spdk/log.h"
+#include "spdk/util.h"
+
+/* Weight of a new sample in the read latency average is 1/2^RAID1_LATENCY_EWMA_SHIFT */
+#define RAID1_LATENCY_EWMA_SHIFT	4
+/* A base bdev without reads for this long is probed again by the latency policy */
+#define RAID1_LATENCY_PROBE_US		(100 * 1000)
+/* Reads sampled on a base bdev before its latency percentile is used for hedging */
+#define RAID1_HEDGE_MIN_SAMPLES		128
+/* Largest read that can be hedged */
+#define RAID1_HEDGE_MAX_SIZE		(64 * 1024)
+/* Maximum number of hedged reads in flight on a channel */
+#define RAID1_HEDGE_MAX_READS		32
+#define RAID1_HEDGE_POLL_PERIOD_US	10
 
 struct raid1_info {
 	/* The parent raid bdev */
 	struct raid_bdev *raid_bdev;
 };
 
+/* Per-base_bdev read statistics of a channel */
+struct raid1_read_stats {
+	/* Average read latency per block, in ticks scaled by 2^RAID1_LATENCY_EWMA_SHIFT */
+	uint64_t latency_ewma;
+
+	/* Estimate of the hedge percentile of read latency, in ticks scaled by 100 */
+	uint64_t latency_quantile;
+
+	/* Number of reads that contributed to the estimates */
+	uint64_t num_samples;
+
+	/* Completion time of the last read */
+	uint64_t last_read_tsc;
+
+	/* The block following the last read submitted to the base bdev */
+	uint64_t next_offset_blocks;
+};
+
+/*
+ * A read that may be sent to two base bdevs. Both reads go to bounce buffers so that the
+ * one that completes later can't overwrite the data of the raid_io, which is completed
+ * with the data of the first successful read.
+ */
+struct raid1_hedged_read {
+	struct raid_bdev_io		*raid_io;
+	struct raid1_io_channel		*raid1_ch;
+
+	/* Primary and hedge read buffers, allocated with the first use of this context */
+	void				*buf[2];
+	struct iovec			iov[2];
+	uint8_t				idx[2];
+
+	/* Time after which the hedge read is sent */
+	uint64_t			deadline_tsc;
+
+	/* Number of reads in flight */
+	uint8_t				reads_outstanding;
+
+	/* Set to true while waiting for the deadline */
+	bool				pending;
+
+	/* Set to true when the raid_io has been completed */
+	bool				completed;
+
+	/*
+	 * References to the base bdev channels and to the raid1 channel, taken with the hedge
+	 * read. The read that loses can complete after the raid_io and its channel are gone.
+	 */
+	struct spdk_io_channel		*base_ch[2];
+	struct spdk_io_channel		*module_ch;
+
+	TAILQ_ENTRY(raid1_hedged_read)	link;
+};
+
 struct raid1_io_channel {
+	struct raid_bdev		*raid_bdev;
+
+	/* Array of per-base_bdev read statistics on this channel */
+	struct raid1_read_stats		*read_stats;
+
+	/* Hedged read contexts, allocated when reads are hedged on this channel for the first time */
+	struct raid1_hedged_read	*hedged_reads;
+	TAILQ_HEAD(, raid1_hedged_read)	hedged_reads_free;
+
+	/* Hedged reads waiting for their deadline, in submission order */
+	TAILQ_HEAD(, raid1_hedged_read)	hedged_reads_pending;
+
+	struct spdk_poller		*hedge_poller;
+
 	/* Array of per-base_bdev counters of outstanding read blocks on this channel */
 	uint64_t read_blocks_outstanding[0];
 };
@@ -38,6 +120,53 @@ raid1_channel_dec_read_counters(struct raid_bdev_io_channel *raid_ch, uint8_t id
 	raid1_ch->read_blocks_outstanding[idx] -= num_blocks;
 }
 
+static bool
+raid1_read_stats_enabled(struct raid_bdev *raid_bdev)
+{
+	return raid_bdev->read_policy == RAID_READ_POLICY_LATENCY ||
+	       raid_bdev->read_hedge_percentile != 0;
+}
+
+static void
+raid1_channel_update_read_stats(struct raid1_io_channel *raid1_ch, uint8_t idx,
+				struct spdk_bdev_io *bdev_io, uint64_t num_blocks)
+{
+	struct raid1_read_stats *stats = &raid1_ch->read_stats[idx];
+	uint8_t percentile = raid1_ch->raid_bdev->read_hedge_percentile;
+	uint64_t now = spdk_get_ticks();
+	uint64_t latency = now - spdk_bdev_io_get_submit_tsc(bdev_io);
+	uint64_t step;
+
+	stats->last_read_tsc = now;
+
+	if (stats->num_samples == 0) {
+		stats->latency_ewma = (latency / num_blocks) << RAID1_LATENCY_EWMA_SHIFT;
+		stats->latency_quantile = latency * 100;
+	} else {
+		stats->latency_ewma -= stats->latency_ewma >> RAID1_LATENCY_EWMA_SHIFT;
+		stats->latency_ewma += latency / num_blocks;
+	}
+	stats->num_samples++;
+
+	if (percentile == 0) {
+		return;
+	}
+
+	/*
+	 * Track the percentile with a stochastic approximation: the estimate moves up by
+	 * percentile steps for each sample above it and down by (100 - percentile) steps
+	 * for each sample below it, so it settles where the ratio of the samples below and
+	 * above it is percentile : (100 - percentile). The steps are relative to the
+	 * estimate, which makes it follow both fast and slow devices.
+	 */
+	step = stats->latency_quantile / (100 * 64) + 1;
+	if (latency * 100 > stats->latency_quantile) {
+		stats->latency_quantile += step * percentile;
+	} else {
+		stats->latency_quantile -= spdk_min(stats->latency_quantile, step * (100 - percentile));
+	}
+}
+
 static void
 raid1_init_ext_io_opts(struct spdk_bdev_ext_io_opts *opts, struct raid_bdev_io *raid_io)
 {
@@ -192,6 +321,11 @@ raid1_read_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *
 {
 	struct raid_bdev_io *raid_io = cb_arg;
 
+	if (success && raid1_read_stats_enabled(raid_io->raid_bdev)) {
+		raid1_channel_update_read_stats(raid_bdev_channel_get_module_ctx(raid_io->raid_ch),
+						raid_io->base_bdev_io_submitted, bdev_io, raid_io->num_blocks);
+	}
+
 	spdk_bdev_free_io(bdev_io);
 
 	raid1_channel_dec_read_counters(raid_io->raid_ch, raid_io->base_bdev_io_submitted,
@@ -217,17 +351,54 @@ _raid1_submit_rw_request(void *_raid_io)
 }
 
 static uint8_t
-raid1_channel_next_read_base_bdev(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+raid1_channel_next_read_base_bdev(struct raid_bdev_io *raid_io, uint8_t skip_idx)
 {
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
 	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_ch);
-	uint64_t read_blocks_min = UINT64_MAX;
+	enum raid_read_policy policy = raid_bdev->read_policy;
+	struct raid1_read_stats *stats;
+	uint64_t now = 0, probe_ticks = 0;
+	uint64_t score, score_min = UINT64_MAX;
 	uint8_t idx = UINT8_MAX;
 	uint8_t i;
 
+	if (policy == RAID_READ_POLICY_LATENCY) {
+		now = spdk_get_ticks();
+		probe_ticks = RAID1_LATENCY_PROBE_US * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+	}
+
 	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
-		if (raid_bdev_channel_get_base_channel(raid_ch, i) != NULL &&
-		    raid1_ch->read_blocks_outstanding[i] < read_blocks_min) {
-			read_blocks_min = raid1_ch->read_blocks_outstanding[i];
+		if (i == skip_idx || raid_bdev_channel_get_base_channel(raid_ch, i) == NULL) {
+			continue;
+		}
+
+		stats = &raid1_ch->read_stats[i];
+
+		switch (policy) {
+		case RAID_READ_POLICY_LATENCY:
+			if (raid1_ch->read_blocks_outstanding[i] == 0 &&
+			    now - stats->last_read_tsc > probe_ticks) {
+				/* measure again a base bdev that was avoided for a while */
+				return i;
+			}
+			/* the expected time to complete the outstanding reads and this one */
+			score = ((stats->latency_ewma >> RAID1_LATENCY_EWMA_SHIFT) + 1) *
+				(raid1_ch->read_blocks_outstanding[i] + raid_io->num_blocks);
+			break;
+		case RAID_READ_POLICY_SEQUENTIAL:
+			if (stats->next_offset_blocks == raid_io->offset_blocks) {
+				/* continue the stream on the same base bdev to benefit from its readahead */
+				return i;
+			}
+		/* fallthrough */
+		default:
+			score = raid1_ch->read_blocks_outstanding[i];
+			break;
+		}
+
+		if (score < score_min) {
+			score_min = score;
 			idx = i;
 		}
 	}
@@ -235,18 +406,260 @@ raid1_channel_next_read_base_bdev(struct raid_bdev *raid_bdev, struct raid_bdev_
 	return idx;
 }
 
+static void
+raid1_channel_put_hedged_read(struct raid1_hedged_read *hedged_read)
+{
+	struct raid1_io_channel *raid1_ch = hedged_read->raid1_ch;
+	struct spdk_io_channel *refs[] = {
+		hedged_read->base_ch[0], hedged_read->base_ch[1], hedged_read->module_ch
+	};
+	uint8_t i;
+
+	assert(hedged_read->reads_outstanding == 0);
+	assert(!hedged_read->pending);
+
+	hedged_read->raid_io = NULL;
+	hedged_read->base_ch[0] = hedged_read->base_ch[1] = hedged_read->module_ch = NULL;
+	TAILQ_INSERT_HEAD(&raid1_ch->hedged_reads_free, hedged_read, link);
+
+	/* The raid1 channel may be released here, so do it last */
+	for (i = 0; i < SPDK_COUNTOF(refs); i++) {
+		if (refs[i] != NULL) {
+			spdk_put_io_channel(refs[i]);
+		}
+	}
+}
+
+static void
+raid1_hedged_read_complete(struct raid1_hedged_read *hedged_read, uint8_t n,
+			   struct spdk_bdev_io *bdev_io, bool success)
+{
+	struct raid1_io_channel *raid1_ch = hedged_read->raid1_ch;
+	struct raid_bdev_io *raid_io = hedged_read->raid_io;
+	uint64_t num_blocks = hedged_read->iov[n].iov_len / raid1_ch->raid_bdev->bdev.blocklen;
+	uint8_t idx = hedged_read->idx[n];
+
+	/* Don't touch the raid_io here, it is already completed if this read lost */
+	if (success) {
+		raid1_channel_update_read_stats(raid1_ch, idx, bdev_io, num_blocks);
+	}
+
+	spdk_bdev_free_io(bdev_io);
+
+	assert(raid1_ch->read_blocks_outstanding[idx] >= num_blocks);
+	raid1_ch->read_blocks_outstanding[idx] -= num_blocks;
+
+	assert(hedged_read->reads_outstanding > 0);
+	hedged_read->reads_outstanding--;
+
+	if (hedged_read->pending) {
+		TAILQ_REMOVE(&raid1_ch->hedged_reads_pending, hedged_read, link);
+		hedged_read->pending = false;
+	}
+
+	if (success && !hedged_read->completed) {
+		hedged_read->completed = true;
+		spdk_copy_buf_to_iovs(raid_io->iovs, raid_io->iovcnt, hedged_read->buf[n],
+				      hedged_read->iov[n].iov_len);
+		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+
+	if (hedged_read->reads_outstanding > 0) {
+		return;
+	}
+
+	success = hedged_read->completed;
+	raid1_channel_put_hedged_read(hedged_read);
+
+	if (!success) {
+		/* All reads failed, recover like a failed regular read of the primary base bdev */
+		raid_io->base_bdev_io_remaining = raid_io->raid_bdev->num_base_bdevs;
+		raid1_read_other_base_bdev(raid_io);
+	}
+}
+
+static void
+raid1_hedged_read_primary_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	raid1_hedged_read_complete(cb_arg, 0, bdev_io, success);
+}
+
+static void
+raid1_hedged_read_hedge_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	raid1_hedged_read_complete(cb_arg, 1, bdev_io, success);
+}
+
+static struct spdk_io_channel *
+raid1_get_channel_ref(struct spdk_io_channel *ch)
+{
+	return spdk_get_io_channel(spdk_io_channel_get_io_device(ch));
+}
+
+static void
+raid1_submit_hedge_read(struct raid1_hedged_read *hedged_read)
+{
+	struct raid_bdev_io *raid_io = hedged_read->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid1_io_channel *raid1_ch = hedged_read->raid1_ch;
+	struct spdk_bdev_ext_io_opts io_opts;
+	struct spdk_io_channel *base_ch;
+	uint8_t i, idx;
+	int ret;
+
+	idx = raid1_channel_next_read_base_bdev(raid_io, hedged_read->idx[0]);
+	if (idx == UINT8_MAX) {
+		return;
+	}
+	hedged_read->idx[1] = idx;
+
+	hedged_read->module_ch = raid1_get_channel_ref(spdk_io_channel_from_ctx(raid1_ch));
+	for (i = 0; i < 2; i++) {
+		base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, hedged_read->idx[i]);
+		assert(base_ch != NULL);
+		hedged_read->base_ch[i] = raid1_get_channel_ref(base_ch);
+	}
+
+	if (hedged_read->module_ch == NULL || hedged_read->base_ch[0] == NULL ||
+	    hedged_read->base_ch[1] == NULL) {
+		ret = -ENOMEM;
+	} else {
+		hedged_read->iov[1].iov_base = hedged_read->buf[1];
+		hedged_read->iov[1].iov_len = hedged_read->iov[0].iov_len;
+
+		raid1_init_ext_io_opts(&io_opts, raid_io);
+		ret = raid_bdev_readv_blocks_ext(&raid_bdev->base_bdev_info[idx], hedged_read->base_ch[1],
+						 &hedged_read->iov[1], 1,
+						 raid_io->offset_blocks, raid_io->num_blocks,
+						 raid1_hedged_read_hedge_completion, hedged_read, &io_opts);
+	}
+
+	if (spdk_unlikely(ret != 0)) {
+		/* Not hedging a read is not an error, just drop the references */
+		for (i = 0; i < 2; i++) {
+			if (hedged_read->base_ch[i] != NULL) {
+				spdk_put_io_channel(hedged_read->base_ch[i]);
+				hedged_read->base_ch[i] = NULL;
+			}
+		}
+		if (hedged_read->module_ch != NULL) {
+			spdk_put_io_channel(hedged_read->module_ch);
+			hedged_read->module_ch = NULL;
+		}
+		return;
+	}
+
+	hedged_read->reads_outstanding++;
+	raid1_ch->read_blocks_outstanding[idx] += raid_io->num_blocks;
+}
+
+static int
+raid1_channel_hedge_poll(void *arg)
+{
+	struct raid1_io_channel *raid1_ch = arg;
+	struct raid1_hedged_read *hedged_read, *tmp;
+	uint64_t now = spdk_get_ticks();
+	int count = 0;
+
+	TAILQ_FOREACH_SAFE(hedged_read, &raid1_ch->hedged_reads_pending, link, tmp) {
+		if (hedged_read->deadline_tsc > now) {
+			continue;
+		}
+
+		TAILQ_REMOVE(&raid1_ch->hedged_reads_pending, hedged_read, link);
+		hedged_read->pending = false;
+
+		raid1_submit_hedge_read(hedged_read);
+		count++;
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static struct raid1_hedged_read *
+raid1_channel_get_hedged_read(struct raid_bdev_io *raid_io, uint8_t idx)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	struct raid1_read_stats *stats = &raid1_ch->read_stats[idx];
+	uint64_t len = raid_io->num_blocks * raid_bdev->bdev.blocklen;
+	struct raid1_hedged_read *hedged_read;
+	uint32_t i;
+
+	/* Only plain reads small enough to be cheaply bounced are hedged */
+	if (raid_bdev->read_hedge_percentile == 0 || len > RAID1_HEDGE_MAX_SIZE ||
+	    raid_io->memory_domain != NULL || raid_io->md_buf != NULL ||
+	    raid_io->completion_cb != NULL || stats->num_samples < RAID1_HEDGE_MIN_SAMPLES) {
+		return NULL;
+	}
+
+	/* Don't bounce a read which has no other base bdev to send the hedge read to */
+	if (raid1_channel_next_read_base_bdev(raid_io, idx) == UINT8_MAX) {
+		return NULL;
+	}
+
+	if (raid1_ch->hedged_reads == NULL) {
+		raid1_ch->hedged_reads = calloc(RAID1_HEDGE_MAX_READS, sizeof(*raid1_ch->hedged_reads));
+		if (raid1_ch->hedged_reads == NULL) {
+			return NULL;
+		}
+
+		for (i = 0; i < RAID1_HEDGE_MAX_READS; i++) {
+			hedged_read = &raid1_ch->hedged_reads[i];
+			hedged_read->raid1_ch = raid1_ch;
+			TAILQ_INSERT_TAIL(&raid1_ch->hedged_reads_free, hedged_read, link);
+		}
+	}
+
+	if (raid1_ch->hedge_poller == NULL) {
+		raid1_ch->hedge_poller = SPDK_POLLER_REGISTER(raid1_channel_hedge_poll, raid1_ch,
+					 RAID1_HEDGE_POLL_PERIOD_US);
+		if (raid1_ch->hedge_poller == NULL) {
+			return NULL;
+		}
+	}
+
+	hedged_read = TAILQ_FIRST(&raid1_ch->hedged_reads_free);
+	if (hedged_read == NULL) {
+		return NULL;
+	}
+
+	for (i = 0; i < 2; i++) {
+		if (hedged_read->buf[i] == NULL) {
+			hedged_read->buf[i] = spdk_dma_malloc(RAID1_HEDGE_MAX_SIZE, 4096, NULL);
+			if (hedged_read->buf[i] == NULL) {
+				return NULL;
+			}
+		}
+	}
+
+	TAILQ_REMOVE(&raid1_ch->hedged_reads_free, hedged_read, link);
+	hedged_read->raid_io = raid_io;
+	hedged_read->idx[0] = idx;
+	hedged_read->idx[1] = UINT8_MAX;
+	hedged_read->iov[0].iov_base = hedged_read->buf[0];
+	hedged_read->iov[0].iov_len = len;
+	hedged_read->reads_outstanding = 0;
+	hedged_read->completed = false;
+	hedged_read->deadline_tsc = spdk_get_ticks() + stats->latency_quantile / 100;
+
+	return hedged_read;
+}
+
 static int
 raid1_submit_read_request(struct raid_bdev_io *raid_io)
 {
 	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
 	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
+	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	struct raid1_hedged_read *hedged_read;
 	struct spdk_bdev_ext_io_opts io_opts;
 	struct raid_base_bdev_info *base_info;
 	struct spdk_io_channel *base_ch;
 	uint8_t idx;
 	int ret;
 
-	idx = raid1_channel_next_read_base_bdev(raid_bdev, raid_ch);
+	idx = raid1_channel_next_read_base_bdev(raid_io, UINT8_MAX);
 	if (spdk_unlikely(idx == UINT8_MAX)) {
 		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
 		return 0;
@@ -256,12 +669,27 @@ raid1_submit_read_request(struct raid_bdev_io *raid_io)
 	base_ch = raid_bdev_channel_get_base_channel(raid_ch, idx);
 
 	raid1_init_ext_io_opts(&io_opts, raid_io);
-	ret = raid_bdev_readv_blocks_ext(base_info, base_ch, raid_io->iovs, raid_io->iovcnt,
-					 raid_io->offset_blocks, raid_io->num_blocks,
-					 raid1_read_bdev_io_completion, raid_io, &io_opts);
+	hedged_read = raid1_channel_get_hedged_read(raid_io, idx);
+	if (hedged_read != NULL) {
+		ret = raid_bdev_readv_blocks_ext(base_info, base_ch, &hedged_read->iov[0], 1,
+						 raid_io->offset_blocks, raid_io->num_blocks,
+						 raid1_hedged_read_primary_completion, hedged_read, &io_opts);
+		if (spdk_likely(ret == 0)) {
+			hedged_read->reads_outstanding = 1;
+			hedged_read->pending = true;
+			TAILQ_INSERT_TAIL(&raid1_ch->hedged_reads_pending, hedged_read, link);
+		} else {
+			raid1_channel_put_hedged_read(hedged_read);
+		}
+	} else {
+		ret = raid_bdev_readv_blocks_ext(base_info, base_ch, raid_io->iovs, raid_io->iovcnt,
+						 raid_io->offset_blocks, raid_io->num_blocks,
+						 raid1_read_bdev_io_completion, raid_io, &io_opts);
+	}
 
 	if (spdk_likely(ret == 0)) {
 		raid1_channel_inc_read_counters(raid_ch, idx, raid_io->num_blocks);
+		raid1_ch->read_stats[idx].next_offset_blocks = raid_io->offset_blocks + raid_io->num_blocks;
 		raid_io->base_bdev_io_submitted = idx;
 	} else if (spdk_unlikely(ret == -ENOMEM)) {
 		raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
@@ -352,11 +780,33 @@ raid1_submit_rw_request(struct raid_bdev_io *raid_io)
 static void
 raid1_ioch_destroy(void *io_device, void *ctx_buf)
 {
+	struct raid1_io_channel *raid1_ch = ctx_buf;
+	uint32_t i;
+
+	spdk_poller_unregister(&raid1_ch->hedge_poller);
+
+	if (raid1_ch->hedged_reads != NULL) {
+		for (i = 0; i < RAID1_HEDGE_MAX_READS; i++) {
+			assert(raid1_ch->hedged_reads[i].raid_io == NULL);
+			spdk_dma_free(raid1_ch->hedged_reads[i].buf[0]);
+			spdk_dma_free(raid1_ch->hedged_reads[i].buf[1]);
+		}
+		free(raid1_ch->hedged_reads);
+	}
 }
 
 static int
 raid1_ioch_create(void *io_device, void *ctx_buf)
 {
+	struct raid1_info *r1info = io_device;
+	struct raid1_io_channel *raid1_ch = ctx_buf;
+
+	raid1_ch->raid_bdev = r1info->raid_bdev;
+	raid1_ch->read_stats = (struct raid1_read_stats *)
+			       &raid1_ch->read_blocks_outstanding[r1info->raid_bdev->num_base_bdevs];
+	TAILQ_INIT(&raid1_ch->hedged_reads_free);
+	TAILQ_INIT(&raid1_ch->hedged_reads_pending);
+
 	return 0;
 }
 
@@ -398,7 +848,8 @@ raid1_start(struct raid_bdev *raid_bdev)
 
 	snprintf(name, sizeof(name), "raid1_%s", raid_bdev->bdev.name);
 	spdk_io_device_register(r1info, raid1_ioch_create, raid1_ioch_destroy,
-				sizeof(struct raid1_io_channel) + raid_bdev->num_base_bdevs * sizeof(uint64_t),
+				sizeof(struct raid1_io_channel) + raid_bdev->num_base_bdevs *
+				(sizeof(uint64_t) + sizeof(struct raid1_read_stats)),
 				name);
 
 	return 0;
@@ -500,16 +951,188 @@ raid1_submit_process_request(struct raid_bdev_process_request *process_req,
 	}
 }
 
+/*
+ * Scrub reads the range from the base bdevs one by one. The first copy that can be read is the
+ * reference, the copies read after it are compared to it and the base bdevs that don't match or
+ * failed to read are rewritten with it. raid_io->base_bdev_io_submitted is the index of the
+ * current base bdev, raid_io->module_private the reference base bdev and raid_io->type tells
+ * whether the current base bdev is read or repaired.
+ */
+static void raid1_scrub_next(void *_raid_io);
+
+static bool
+raid1_scrub_copies_match(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev *raid_bdev = process_req->raid_io.raid_bdev;
+
+	if (memcmp(process_req->iov.iov_base, process_req->scrub.iov.iov_base,
+		   process_req->num_blocks * raid_bdev->bdev.blocklen) != 0) {
+		return false;
+	}
+
+	return process_req->md_buf == NULL ||
+	       memcmp(process_req->md_buf, process_req->scrub.md_buf,
+		      process_req->num_blocks * raid_bdev->bdev.md_len) == 0;
+}
+
+static void
+raid1_scrub_base_bdev_done(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+
+	raid_io->type = SPDK_BDEV_IO_TYPE_READ;
+	raid_io->base_bdev_io_submitted++;
+	raid1_scrub_next(raid_io);
+}
+
+static void
+raid1_scrub_repair_needed(struct raid_bdev_process_request *process_req)
+{
+	if (process_req->scrub.repair) {
+		process_req->raid_io.type = SPDK_BDEV_IO_TYPE_WRITE;
+		raid1_scrub_next(&process_req->raid_io);
+	} else {
+		raid1_scrub_base_bdev_done(process_req);
+	}
+}
+
+static void
+raid1_scrub_write_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (success) {
+		process_req->scrub.repaired_blocks += process_req->num_blocks;
+	} else {
+		raid_bdev_fail_base_bdev(&raid_bdev->base_bdev_info[raid_io->base_bdev_io_submitted]);
+	}
+
+	raid1_scrub_base_bdev_done(process_req);
+}
+
+static void
+raid1_scrub_read_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		process_req->scrub.read_error_blocks += process_req->num_blocks;
+		if (raid_io->module_private == NULL) {
+			/* Repaired once a readable copy is found */
+			raid1_scrub_base_bdev_done(process_req);
+		} else {
+			raid1_scrub_repair_needed(process_req);
+		}
+		return;
+	}
+
+	if (raid_io->module_private == NULL) {
+		raid_io->module_private = &raid_bdev->base_bdev_info[raid_io->base_bdev_io_submitted];
+		/* Go back to the base bdevs that failed to read */
+		raid_io->base_bdev_io_submitted = 0;
+		raid1_scrub_next(raid_io);
+	} else if (!raid1_scrub_copies_match(process_req)) {
+		process_req->scrub.mismatched_blocks += process_req->num_blocks;
+		raid1_scrub_repair_needed(process_req);
+	} else {
+		raid1_scrub_base_bdev_done(process_req);
+	}
+}
+
+static void
+raid1_scrub_next(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_base_bdev_info *ref_info = raid_io->module_private;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_bdev_ext_io_opts io_opts;
+	struct spdk_io_channel *base_ch;
+	uint8_t idx;
+	int ret;
+
+	for (; raid_io->base_bdev_io_submitted < raid_bdev->num_base_bdevs;
+	     raid_io->base_bdev_io_submitted++) {
+		idx = raid_io->base_bdev_io_submitted;
+		base_info = &raid_bdev->base_bdev_info[idx];
+		base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, idx);
+		if (base_ch == NULL || base_info == ref_info) {
+			continue;
+		}
+
+		raid1_init_ext_io_opts(&io_opts, raid_io);
+		if (ref_info == NULL) {
+			/* Looking for the reference copy */
+			ret = raid_bdev_readv_blocks_ext(base_info, base_ch, &process_req->iov, 1,
+							 raid_io->offset_blocks, raid_io->num_blocks,
+							 raid1_scrub_read_completed, process_req, &io_opts);
+		} else if (base_info < ref_info || raid_io->type == SPDK_BDEV_IO_TYPE_WRITE) {
+			if (!process_req->scrub.repair) {
+				continue;
+			}
+			ret = raid_bdev_writev_blocks_ext(base_info, base_ch, &process_req->iov, 1,
+							  raid_io->offset_blocks, raid_io->num_blocks,
+							  raid1_scrub_write_completed, process_req, &io_opts);
+		} else {
+			io_opts.metadata = process_req->scrub.md_buf;
+			ret = raid_bdev_readv_blocks_ext(base_info, base_ch, &process_req->scrub.iov, 1,
+							 raid_io->offset_blocks, raid_io->num_blocks,
+							 raid1_scrub_read_completed, process_req, &io_opts);
+		}
+
+		if (spdk_unlikely(ret != 0)) {
+			if (ret == -ENOMEM) {
+				raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+							base_ch, raid1_scrub_next);
+			} else {
+				raid_bdev_process_request_complete(process_req, ret);
+			}
+		}
+		return;
+	}
+
+	raid_bdev_process_request_complete(process_req, 0);
+}
+
+static int
+raid1_submit_scrub_request(struct raid_bdev_process_request *process_req,
+			   struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+
+	raid_bdev_io_init(raid_io, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+			  process_req->offset_blocks, process_req->num_blocks,
+			  &process_req->iov, 1, process_req->md_buf, NULL, NULL);
+	raid_io->module_private = NULL;
+
+	/* The process request must not complete before this function returns */
+	spdk_thread_send_msg(spdk_get_thread(), raid1_scrub_next, raid_io);
+
+	return process_req->num_blocks;
+}
+
 static struct raid_bdev_module g_raid1_module = {
 	.level = RAID1,
 	.base_bdevs_min = 2,
 	.base_bdevs_constraint = {CONSTRAINT_MIN_BASE_BDEVS_OPERATIONAL, 1},
 	.memory_domains_supported = true,
+	.read_policy_supported = true,
 	.start = raid1_start,
 	.stop = raid1_stop,
 	.submit_rw_request = raid1_submit_rw_request,
 	.get_io_channel = raid1_get_io_channel,
 	.submit_process_request = raid1_submit_process_request,
+	.submit_scrub_request = raid1_submit_scrub_request,
 };
 RAID_MODULE_REGISTER(&g_raid1_module)
 
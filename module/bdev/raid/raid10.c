@@ -0,0 +1,766 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "bdev_raid.h"
+
+#include "spdk/likely.h"
+#include "spdk/log.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+/*
+ * RAID10 stripes data across mirrored pairs of base bdevs. Base bdevs 2n and 2n+1 form the
+ * n-th mirror and strips are distributed over the mirrors round-robin, like in raid0. Each raid
+ * I/O is split on strip boundaries, so it always targets a single mirror and maps to the same
+ * range on both of its base bdevs.
+ */
+#define RAID10_MIRROR_WIDTH 2
+
+struct raid10_info {
+	/* The parent raid bdev */
+	struct raid_bdev *raid_bdev;
+
+	/* Number of mirrors the data is striped over */
+	uint8_t num_mirrors;
+};
+
+struct raid10_io_channel {
+	/* Array of per-base_bdev counters of outstanding read blocks on this channel */
+	uint64_t read_blocks_outstanding[0];
+};
+
+static inline uint8_t
+raid10_io_mirror(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid10_info *r10info = raid_bdev->module_private;
+
+	return (raid_io->offset_blocks >> raid_bdev->strip_size_shift) % r10info->num_mirrors;
+}
+
+static inline uint64_t
+raid10_io_base_offset(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid10_info *r10info = raid_bdev->module_private;
+	uint64_t strip = raid_io->offset_blocks >> raid_bdev->strip_size_shift;
+
+	return ((strip / r10info->num_mirrors) << raid_bdev->strip_size_shift) +
+	       (raid_io->offset_blocks & (raid_bdev->strip_size - 1));
+}
+
+/* Returns the other base bdev of the mirror */
+static inline uint8_t
+raid10_mirror_peer(uint8_t idx)
+{
+	return idx ^ 1;
+}
+
+static void
+raid10_channel_inc_read_counters(struct raid_bdev_io_channel *raid_ch, uint8_t idx,
+				 uint64_t num_blocks)
+{
+	struct raid10_io_channel *raid10_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+
+	assert(raid10_ch->read_blocks_outstanding[idx] <= UINT64_MAX - num_blocks);
+	raid10_ch->read_blocks_outstanding[idx] += num_blocks;
+}
+
+static void
+raid10_channel_dec_read_counters(struct raid_bdev_io_channel *raid_ch, uint8_t idx,
+				 uint64_t num_blocks)
+{
+	struct raid10_io_channel *raid10_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+
+	assert(raid10_ch->read_blocks_outstanding[idx] >= num_blocks);
+	raid10_ch->read_blocks_outstanding[idx] -= num_blocks;
+}
+
+static void
+raid10_init_ext_io_opts(struct spdk_bdev_ext_io_opts *opts, struct raid_bdev_io *raid_io)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->size = sizeof(*opts);
+	opts->memory_domain = raid_io->memory_domain;
+	opts->memory_domain_ctx = raid_io->memory_domain_ctx;
+	opts->metadata = raid_io->md_buf;
+}
+
+static void
+raid10_write_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	if (!success) {
+		struct raid_base_bdev_info *base_info;
+
+		base_info = raid_bdev_channel_get_base_info(raid_io->raid_ch, bdev_io->bdev);
+		if (base_info) {
+			raid_bdev_fail_base_bdev(base_info);
+		}
+	}
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_io_complete_part(raid_io, 1, success ?
+				   SPDK_BDEV_IO_STATUS_SUCCESS :
+				   SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static struct raid_base_bdev_info *
+raid10_get_read_io_base_bdev(struct raid_bdev_io *raid_io)
+{
+	assert(raid_io->type == SPDK_BDEV_IO_TYPE_READ);
+	return &raid_io->raid_bdev->base_bdev_info[raid_io->base_bdev_io_submitted];
+}
+
+static void
+raid10_correct_read_error_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		struct raid_base_bdev_info *base_info = raid10_get_read_io_base_bdev(raid_io);
+
+		/* Writing to the bdev that had the read error failed so fail the base bdev
+		 * but complete the raid_io successfully. */
+		raid_bdev_fail_base_bdev(base_info);
+	}
+
+	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+static void
+raid10_correct_read_error(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+	struct spdk_bdev_ext_io_opts io_opts;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	int ret;
+
+	base_info = raid10_get_read_io_base_bdev(raid_io);
+	base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch,
+			raid_io->base_bdev_io_submitted);
+	assert(base_ch != NULL);
+
+	raid10_init_ext_io_opts(&io_opts, raid_io);
+	ret = raid_bdev_writev_blocks_ext(base_info, base_ch, raid_io->iovs, raid_io->iovcnt,
+					  raid10_io_base_offset(raid_io), raid_io->num_blocks,
+					  raid10_correct_read_error_completion, raid_io, &io_opts);
+	if (spdk_unlikely(ret != 0)) {
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+						base_ch, raid10_correct_read_error);
+		} else {
+			raid_bdev_fail_base_bdev(base_info);
+			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		}
+	}
+}
+
+static void
+raid10_read_other_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		raid_bdev_fail_base_bdev(raid10_get_read_io_base_bdev(raid_io));
+		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	/* try to correct the read error by writing data read from the other base bdev */
+	raid10_correct_read_error(raid_io);
+}
+
+static void
+raid10_read_other_base_bdev(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+	struct spdk_bdev_ext_io_opts io_opts;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	uint8_t idx;
+	int ret;
+
+	idx = raid10_mirror_peer(raid_io->base_bdev_io_submitted);
+	base_info = &raid_io->raid_bdev->base_bdev_info[idx];
+	base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, idx);
+	if (base_ch != NULL) {
+		raid10_init_ext_io_opts(&io_opts, raid_io);
+		ret = raid_bdev_readv_blocks_ext(base_info, base_ch, raid_io->iovs, raid_io->iovcnt,
+						 raid10_io_base_offset(raid_io), raid_io->num_blocks,
+						 raid10_read_other_completion, raid_io, &io_opts);
+		if (spdk_likely(ret == 0)) {
+			return;
+		} else if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+						base_ch, raid10_read_other_base_bdev);
+			return;
+		}
+	}
+
+	raid_bdev_fail_base_bdev(raid10_get_read_io_base_bdev(raid_io));
+	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void
+raid10_read_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid10_channel_dec_read_counters(raid_io->raid_ch, raid_io->base_bdev_io_submitted,
+					 raid_io->num_blocks);
+
+	if (!success) {
+		raid10_read_other_base_bdev(raid_io);
+		return;
+	}
+
+	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+static void raid10_submit_rw_request(struct raid_bdev_io *raid_io);
+
+static void
+_raid10_submit_rw_request(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid10_submit_rw_request(raid_io);
+}
+
+static uint8_t
+raid10_channel_next_read_base_bdev(struct raid_bdev_io_channel *raid_ch, uint8_t mirror)
+{
+	struct raid10_io_channel *raid10_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	uint64_t read_blocks_min = UINT64_MAX;
+	uint8_t idx = UINT8_MAX;
+	uint8_t i;
+
+	for (i = mirror * RAID10_MIRROR_WIDTH; i < (mirror + 1) * RAID10_MIRROR_WIDTH; i++) {
+		if (raid_bdev_channel_get_base_channel(raid_ch, i) != NULL &&
+		    raid10_ch->read_blocks_outstanding[i] < read_blocks_min) {
+			read_blocks_min = raid10_ch->read_blocks_outstanding[i];
+			idx = i;
+		}
+	}
+
+	return idx;
+}
+
+static int
+raid10_submit_read_request(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
+	struct spdk_bdev_ext_io_opts io_opts;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	uint8_t idx;
+	int ret;
+
+	idx = raid10_channel_next_read_base_bdev(raid_ch, raid10_io_mirror(raid_io));
+	if (spdk_unlikely(idx == UINT8_MAX)) {
+		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return 0;
+	}
+
+	base_info = &raid_bdev->base_bdev_info[idx];
+	base_ch = raid_bdev_channel_get_base_channel(raid_ch, idx);
+
+	raid10_init_ext_io_opts(&io_opts, raid_io);
+	ret = raid_bdev_readv_blocks_ext(base_info, base_ch, raid_io->iovs, raid_io->iovcnt,
+					 raid10_io_base_offset(raid_io), raid_io->num_blocks,
+					 raid10_read_bdev_io_completion, raid_io, &io_opts);
+
+	if (spdk_likely(ret == 0)) {
+		raid10_channel_inc_read_counters(raid_ch, idx, raid_io->num_blocks);
+		raid_io->base_bdev_io_submitted = idx;
+	} else if (spdk_unlikely(ret == -ENOMEM)) {
+		raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+					base_ch, _raid10_submit_rw_request);
+		return 0;
+	}
+
+	return ret;
+}
+
+static int
+raid10_submit_write_request(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct spdk_bdev_ext_io_opts io_opts;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	uint64_t base_offset;
+	uint8_t mirror_start;
+	uint8_t i;
+	int ret;
+
+	if (raid_io->base_bdev_io_submitted == 0) {
+		raid_io->base_bdev_io_remaining = RAID10_MIRROR_WIDTH;
+		raid_bdev_io_set_default_status(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+
+	mirror_start = raid10_io_mirror(raid_io) * RAID10_MIRROR_WIDTH;
+	base_offset = raid10_io_base_offset(raid_io);
+
+	raid10_init_ext_io_opts(&io_opts, raid_io);
+	for (i = raid_io->base_bdev_io_submitted; i < RAID10_MIRROR_WIDTH; i++) {
+		base_info = &raid_bdev->base_bdev_info[mirror_start + i];
+		base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, mirror_start + i);
+
+		if (base_ch == NULL) {
+			/* skip a missing base bdev's slot */
+			raid_io->base_bdev_io_submitted++;
+			raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_FAILED);
+			continue;
+		}
+
+		ret = raid_bdev_writev_blocks_ext(base_info, base_ch, raid_io->iovs, raid_io->iovcnt,
+						  base_offset, raid_io->num_blocks,
+						  raid10_write_bdev_io_completion, raid_io, &io_opts);
+		if (spdk_unlikely(ret != 0)) {
+			if (spdk_unlikely(ret == -ENOMEM)) {
+				raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+							base_ch, _raid10_submit_rw_request);
+				return 0;
+			}
+
+			raid_bdev_io_complete_part(raid_io, RAID10_MIRROR_WIDTH - i,
+						   SPDK_BDEV_IO_STATUS_FAILED);
+			return 0;
+		}
+
+		raid_io->base_bdev_io_submitted++;
+	}
+
+	return 0;
+}
+
+static void
+raid10_submit_rw_request(struct raid_bdev_io *raid_io)
+{
+	int ret;
+
+	switch (raid_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		ret = raid10_submit_read_request(raid_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		ret = raid10_submit_write_request(raid_io);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	if (spdk_unlikely(ret != 0)) {
+		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+/*
+ * Get the range of the base bdevs of a mirror that is covered by the raid range. Returns false
+ * if the range doesn't include any strip of the mirror.
+ */
+static bool
+raid10_get_mirror_range(struct raid_bdev *raid_bdev, uint8_t mirror, uint64_t offset_blocks,
+			uint64_t num_blocks, uint64_t *base_offset, uint64_t *base_blocks)
+{
+	struct raid10_info *r10info = raid_bdev->module_private;
+	uint64_t last_block = offset_blocks + num_blocks - 1;
+	uint64_t start_strip = offset_blocks >> raid_bdev->strip_size_shift;
+	uint64_t end_strip = last_block >> raid_bdev->strip_size_shift;
+	uint64_t first, last, base_end;
+
+	/* The first and the last strip of the mirror within the range */
+	first = start_strip + (mirror + r10info->num_mirrors - start_strip % r10info->num_mirrors) %
+		r10info->num_mirrors;
+	if (first > end_strip) {
+		return false;
+	}
+	last = end_strip - (end_strip % r10info->num_mirrors + r10info->num_mirrors - mirror) %
+	       r10info->num_mirrors;
+
+	*base_offset = (first / r10info->num_mirrors) << raid_bdev->strip_size_shift;
+	if (first == start_strip) {
+		*base_offset += offset_blocks & (raid_bdev->strip_size - 1);
+	}
+
+	base_end = (last / r10info->num_mirrors) << raid_bdev->strip_size_shift;
+	if (last == end_strip) {
+		base_end += last_block & (raid_bdev->strip_size - 1);
+	} else {
+		base_end += raid_bdev->strip_size - 1;
+	}
+
+	*base_blocks = base_end - *base_offset + 1;
+
+	return true;
+}
+
+static void
+raid10_base_io_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	raid_bdev_io_complete_part(raid_io, 1, success ?
+				   SPDK_BDEV_IO_STATUS_SUCCESS :
+				   SPDK_BDEV_IO_STATUS_FAILED);
+
+	spdk_bdev_free_io(bdev_io);
+}
+
+static void raid10_submit_null_payload_request(struct raid_bdev_io *raid_io);
+
+static void
+_raid10_submit_null_payload_request(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid10_submit_null_payload_request(raid_io);
+}
+
+/*
+ * Submits requests without payload (flush, unmap) to all available base bdevs of the mirrors
+ * covered by the range. raid_io->base_bdev_io_submitted is the slot of the next base bdev to
+ * submit to, which allows resuming after -ENOMEM.
+ */
+static void
+raid10_submit_null_payload_request(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	uint64_t base_offset, base_blocks;
+	uint8_t i;
+	int ret;
+
+	if (raid_io->base_bdev_io_remaining == 0) {
+		for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+			if (raid_bdev_channel_get_base_channel(raid_io->raid_ch, i) != NULL &&
+			    raid10_get_mirror_range(raid_bdev, i / RAID10_MIRROR_WIDTH,
+						    raid_io->offset_blocks, raid_io->num_blocks,
+						    &base_offset, &base_blocks)) {
+				raid_io->base_bdev_io_remaining++;
+			}
+		}
+
+		if (spdk_unlikely(raid_io->base_bdev_io_remaining == 0)) {
+			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+			return;
+		}
+	}
+
+	for (i = raid_io->base_bdev_io_submitted; i < raid_bdev->num_base_bdevs; i++) {
+		base_info = &raid_bdev->base_bdev_info[i];
+		base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, i);
+
+		if (base_ch == NULL ||
+		    !raid10_get_mirror_range(raid_bdev, i / RAID10_MIRROR_WIDTH,
+					     raid_io->offset_blocks, raid_io->num_blocks,
+					     &base_offset, &base_blocks)) {
+			raid_io->base_bdev_io_submitted++;
+			continue;
+		}
+
+		switch (raid_io->type) {
+		case SPDK_BDEV_IO_TYPE_UNMAP:
+			ret = raid_bdev_unmap_blocks(base_info, base_ch, base_offset, base_blocks,
+						     raid10_base_io_complete, raid_io);
+			break;
+
+		case SPDK_BDEV_IO_TYPE_FLUSH:
+			ret = raid_bdev_flush_blocks(base_info, base_ch, base_offset, base_blocks,
+						     raid10_base_io_complete, raid_io);
+			break;
+
+		default:
+			SPDK_ERRLOG("submit request, invalid io type with null payload %u\n", raid_io->type);
+			assert(false);
+			ret = -EIO;
+		}
+
+		if (ret == 0) {
+			raid_io->base_bdev_io_submitted++;
+		} else if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+						base_ch, _raid10_submit_null_payload_request);
+			return;
+		} else {
+			SPDK_ERRLOG("bdev io submit error not due to ENOMEM, it should not happen\n");
+			assert(false);
+			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+			return;
+		}
+	}
+}
+
+static void
+raid10_ioch_destroy(void *io_device, void *ctx_buf)
+{
+}
+
+static int
+raid10_ioch_create(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+raid10_io_device_unregister_done(void *io_device)
+{
+	struct raid10_info *r10info = io_device;
+
+	raid_bdev_module_stop_done(r10info->raid_bdev);
+
+	free(r10info);
+}
+
+static uint64_t
+raid10_base_bdev_data_size(struct raid_bdev *raid_bdev, uint64_t min_blockcnt)
+{
+	return (min_blockcnt >> raid_bdev->strip_size_shift) << raid_bdev->strip_size_shift;
+}
+
+static int
+raid10_start(struct raid_bdev *raid_bdev)
+{
+	uint64_t min_blockcnt = UINT64_MAX;
+	uint64_t base_bdev_data_size;
+	struct raid_base_bdev_info *base_info;
+	struct raid10_info *r10info;
+	char name[256];
+
+	assert(raid_bdev->num_base_bdevs % RAID10_MIRROR_WIDTH == 0);
+
+	r10info = calloc(1, sizeof(*r10info));
+	if (!r10info) {
+		SPDK_ERRLOG("Failed to allocate RAID10 info device structure\n");
+		return -ENOMEM;
+	}
+	r10info->raid_bdev = raid_bdev;
+	r10info->num_mirrors = raid_bdev->num_base_bdevs / RAID10_MIRROR_WIDTH;
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		min_blockcnt = spdk_min(min_blockcnt, base_info->data_size);
+	}
+
+	base_bdev_data_size = raid10_base_bdev_data_size(raid_bdev, min_blockcnt);
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		base_info->data_size = base_bdev_data_size;
+	}
+
+	raid_bdev->bdev.blockcnt = base_bdev_data_size * r10info->num_mirrors;
+	raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
+	raid_bdev->bdev.split_on_optimal_io_boundary = true;
+	raid_bdev->module_private = r10info;
+
+	snprintf(name, sizeof(name), "raid10_%s", raid_bdev->bdev.name);
+	spdk_io_device_register(r10info, raid10_ioch_create, raid10_ioch_destroy,
+				sizeof(struct raid10_io_channel) + raid_bdev->num_base_bdevs * sizeof(uint64_t),
+				name);
+
+	return 0;
+}
+
+static bool
+raid10_stop(struct raid_bdev *raid_bdev)
+{
+	struct raid10_info *r10info = raid_bdev->module_private;
+
+	spdk_io_device_unregister(r10info, raid10_io_device_unregister_done);
+
+	return false;
+}
+
+static struct spdk_io_channel *
+raid10_get_io_channel(struct raid_bdev *raid_bdev)
+{
+	struct raid10_info *r10info = raid_bdev->module_private;
+
+	return spdk_get_io_channel(r10info);
+}
+
+static bool
+raid10_resize(struct raid_bdev *raid_bdev)
+{
+	struct raid10_info *r10info = raid_bdev->module_private;
+	uint64_t min_blockcnt = UINT64_MAX;
+	uint64_t base_bdev_data_size;
+	struct raid_base_bdev_info *base_info;
+	uint64_t blockcnt;
+	int rc;
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		struct spdk_bdev *base_bdev;
+
+		if (base_info->desc == NULL) {
+			continue;
+		}
+		base_bdev = spdk_bdev_desc_get_bdev(base_info->desc);
+		min_blockcnt = spdk_min(min_blockcnt, base_bdev->blockcnt - base_info->data_offset);
+	}
+
+	base_bdev_data_size = raid10_base_bdev_data_size(raid_bdev, min_blockcnt);
+	blockcnt = base_bdev_data_size * r10info->num_mirrors;
+
+	if (blockcnt == raid_bdev->bdev.blockcnt) {
+		return false;
+	}
+
+	rc = spdk_bdev_notify_blockcnt_change(&raid_bdev->bdev, blockcnt);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to notify blockcount change\n");
+		return false;
+	}
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		base_info->data_size = base_bdev_data_size;
+	}
+
+	return true;
+}
+
+static void
+raid10_process_write_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_process_request_complete(process_req, success ? 0 : -EIO);
+}
+
+static void raid10_process_submit_write(struct raid_bdev_process_request *process_req);
+
+static void
+_raid10_process_submit_write(void *ctx)
+{
+	struct raid_bdev_process_request *process_req = ctx;
+
+	raid10_process_submit_write(process_req);
+}
+
+static void
+raid10_process_submit_write(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	raid10_init_ext_io_opts(&io_opts, raid_io);
+	ret = raid_bdev_writev_blocks_ext(process_req->target, process_req->target_ch,
+					  raid_io->iovs, raid_io->iovcnt,
+					  raid10_io_base_offset(raid_io), raid_io->num_blocks,
+					  raid10_process_write_completed, process_req, &io_opts);
+	if (spdk_unlikely(ret != 0)) {
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(process_req->target->desc),
+						process_req->target_ch, _raid10_process_submit_write);
+		} else {
+			raid_bdev_process_request_complete(process_req, ret);
+		}
+	}
+}
+
+static void
+raid10_process_read_completed(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
+{
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+
+	if (status != SPDK_BDEV_IO_STATUS_SUCCESS) {
+		raid_bdev_process_request_complete(process_req, -EIO);
+		return;
+	}
+
+	raid10_process_submit_write(process_req);
+}
+
+static void
+raid10_process_skip_done(void *ctx)
+{
+	struct raid_bdev_process_request *process_req = ctx;
+
+	raid_bdev_process_request_complete(process_req, 0);
+}
+
+/*
+ * Only the strips of the target's mirror need to be rebuilt. The request is extended over the
+ * strips of other mirrors preceding the first strip of the target's mirror in the range and
+ * covers up to the end of that strip.
+ */
+static int
+raid10_submit_process_request(struct raid_bdev_process_request *process_req,
+			      struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+	struct raid10_info *r10info = raid_bdev->module_private;
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	uint8_t mirror = raid_bdev_base_bdev_slot(process_req->target) / RAID10_MIRROR_WIDTH;
+	uint64_t offset = process_req->offset_blocks;
+	uint64_t offset_end = offset + process_req->num_blocks;
+	uint64_t strip, start, num_blocks;
+	int ret;
+
+	strip = offset >> raid_bdev->strip_size_shift;
+	start = offset;
+	if (strip % r10info->num_mirrors != mirror) {
+		strip += (mirror + r10info->num_mirrors - strip % r10info->num_mirrors) %
+			 r10info->num_mirrors;
+		start = strip << raid_bdev->strip_size_shift;
+	}
+
+	if (start >= offset_end) {
+		/* Nothing to rebuild in this range. Complete the request asynchronously, as the
+		 * process expects. */
+		spdk_thread_send_msg(spdk_get_thread(), raid10_process_skip_done, process_req);
+		return process_req->num_blocks;
+	}
+
+	num_blocks = spdk_min(((strip + 1) << raid_bdev->strip_size_shift), offset_end) - start;
+	process_req->iov.iov_len = num_blocks * raid_bdev->bdev.blocklen;
+
+	raid_bdev_io_init(raid_io, raid_ch, SPDK_BDEV_IO_TYPE_READ, start, num_blocks,
+			  &process_req->iov, 1, process_req->md_buf, NULL, NULL);
+	raid_io->completion_cb = raid10_process_read_completed;
+
+	ret = raid10_submit_read_request(raid_io);
+	if (spdk_likely(ret == 0)) {
+		return start + num_blocks - offset;
+	} else if (ret < 0) {
+		return ret;
+	} else {
+		return -EINVAL;
+	}
+}
+
+static struct raid_bdev_module g_raid10_module = {
+	.level = RAID10,
+	.base_bdevs_min = 4,
+	.base_bdevs_constraint = {CONSTRAINT_MAX_BASE_BDEVS_REMOVED, 1},
+	.memory_domains_supported = true,
+	.start = raid10_start,
+	.stop = raid10_stop,
+	.submit_rw_request = raid10_submit_rw_request,
+	.submit_null_payload_request = raid10_submit_null_payload_request,
+	.get_io_channel = raid10_get_io_channel,
+	.resize = raid10_resize,
+	.submit_process_request = raid10_submit_process_request,
+};
+RAID_MODULE_REGISTER(&g_raid10_module)
+
+SPDK_LOG_REGISTER_COMPONENT(bdev_raid10)
@@ -12,9 +12,33 @@
 #include "spdk/likely.h"
 #include "spdk/log.h"
 #include "spdk/accel.h"
+#include "spdk/json.h"
 
-/* Maximum concurrent full stripe writes per io channel */
-#define RAID5F_MAX_STRIPES 32
+/* Initial number of full stripe write and reconstruct requests per io channel */
+#define RAID5F_MIN_STRIPES 8
+
+/* Maximum concurrent full stripe writes (and reconstruct reads) per io channel */
+#define RAID5F_MAX_STRIPES 256
+
+/* Period of checking if the stripe request pools of an io channel need to grow */
+#define RAID5F_STRIPE_POOL_POLL_PERIOD_US (10 * 1000)
+
+/* Period of checking if the stripe request pools of an io channel can be shrunk */
+#define RAID5F_STRIPE_POOL_SHRINK_PERIOD_US (1000 * 1000)
+#define RAID5F_STRIPE_POOL_SHRINK_POLLS \
+	(RAID5F_STRIPE_POOL_SHRINK_PERIOD_US / RAID5F_STRIPE_POOL_POLL_PERIOD_US)
+
+/* Number of cached stripes (and concurrent partial stripe writes) per io channel */
+#define RAID5F_STRIPE_CACHE_SIZE 8
+
+/* Number of buckets for the stripe lock table */
+#define RAID5F_STRIPE_LOCK_BUCKETS 256
+
+/* Range of blocks within a strip, end is exclusive */
+struct raid5f_range {
+	uint64_t start;
+	uint64_t end;
+};
 
 struct chunk {
 	/* Corresponds to base_bdev index */
@@ -31,15 +55,53 @@ struct chunk {
 
 	/* Pointer to buffer with I/O metadata */
 	void *md_buf;
+
+	/* Blocks of this chunk modified by a partial stripe write */
+	struct raid5f_range write_range;
+
+	/* Blocks of this chunk read or written in the current partial stripe write phase */
+	struct raid5f_range io_range;
 };
 
 struct stripe_request;
 typedef void (*stripe_req_xor_cb)(struct stripe_request *stripe_req, int status);
+typedef void (*stripe_req_lock_cb)(struct stripe_request *stripe_req);
+
+enum raid5f_partial_write_mode {
+	/* Parity is missing, only the data chunks are written */
+	RAID5F_PARTIAL_WRITE_DATA_ONLY,
+	/* Parity is calculated from all data chunks (reconstruct-write) */
+	RAID5F_PARTIAL_WRITE_RCW,
+	/* Parity is updated with the difference of old and new data (read-modify-write) */
+	RAID5F_PARTIAL_WRITE_RMW,
+	/* The missing data chunk is reconstructed first, followed by RCW */
+	RAID5F_PARTIAL_WRITE_REC,
+};
+
+struct raid5f_stripe_cache_entry {
+	/* Stripe held in this entry */
+	uint64_t stripe_index;
+
+	/* Stripe lock generation for which the cached data is valid */
+	uint64_t gen;
+
+	/* Array of buffers for each chunk (including parity), indexed by base bdev */
+	void **chunk_buffers;
+
+	/* Array of buffers for each chunk metadata */
+	void **chunk_md_buffers;
+
+	/* Array of valid block ranges for each chunk */
+	struct raid5f_range *valid;
+
+	TAILQ_ENTRY(raid5f_stripe_cache_entry) link;
+};
 
 struct stripe_request {
 	enum stripe_request_type {
 		STRIPE_REQ_WRITE,
 		STRIPE_REQ_RECONSTRUCT,
+		STRIPE_REQ_PARTIAL_WRITE,
 	} type;
 
 	struct raid5f_io_channel *r5ch;
@@ -75,6 +137,39 @@ struct stripe_request {
 			/* Offset from chunk start */
 			uint64_t chunk_offset;
 		} reconstruct;
+
+		struct {
+			/* Stripe cache entry used as the working buffer */
+			struct raid5f_stripe_cache_entry *entry;
+
+			/* Scratch buffer for read-modify-write parity calculation */
+			void *tmp_buf;
+
+			/* Scratch buffer for read-modify-write parity calculation of io metadata */
+			void *tmp_md_buf;
+
+			/* Union of the chunk write ranges */
+			struct raid5f_range range;
+
+			/* Offset of the write from stripe start */
+			uint64_t stripe_offset;
+
+			enum raid5f_partial_write_mode mode;
+
+			/* Index of the chunk with a missing base bdev or UINT8_MAX */
+			uint8_t missing;
+
+			/* Whether the chunks are being read or written */
+			bool reading;
+
+			/* Arguments of the current xor operation, saved for retry */
+			struct raid5f_partial_write_xor_args {
+				void *dst;
+				void *md_dst;
+				uint8_t nsrcs;
+				bool md_submitted;
+			} xor_args;
+		} partial;
 	};
 
 	/* Array of iovec iterators for each chunk */
@@ -94,12 +189,32 @@ struct stripe_request {
 		stripe_req_xor_cb cb;
 	} xor;
 
+	struct {
+		/* Requests waiting for this request to unlock the stripe */
+		TAILQ_HEAD(, stripe_request) waiters;
+		TAILQ_ENTRY(stripe_request) link;
+		stripe_req_lock_cb cb;
+		/* Bucket generation at the time of locking, or after unlocking a write */
+		uint64_t gen;
+		bool held;
+	} lock;
+
 	TAILQ_ENTRY(stripe_request) link;
 
 	/* Array of chunks corresponding to base_bdevs */
 	struct chunk chunks[0];
 };
 
+struct raid5f_stripe_lock_bucket {
+	struct spdk_spinlock lock;
+
+	/* Stripe requests holding a lock on a stripe from this bucket */
+	TAILQ_HEAD(, stripe_request) holders;
+
+	/* Incremented on every write to a stripe from this bucket */
+	uint64_t gen;
+};
+
 struct raid5f_info {
 	/* The parent raid bdev */
 	struct raid_bdev *raid_bdev;
@@ -115,14 +230,65 @@ struct raid5f_info {
 
 	/* block length bit shift for optimized calculation, only valid when no interleaved md */
 	uint32_t blocklen_shift;
+
+	/* Stripe locks serializing writes and reconstruct reads of a stripe */
+	struct raid5f_stripe_lock_bucket stripe_locks[RAID5F_STRIPE_LOCK_BUCKETS];
+
+	/* Statistics of the stripe request pools of all io channels, updated atomically */
+	struct {
+		/* Allocated stripe requests and the memory used by their buffers */
+		uint64_t stripe_requests;
+		uint64_t stripe_request_bytes;
+
+		/* Stripe requests added to and removed from the pools as they were resized */
+		uint64_t grown;
+		uint64_t shrunk;
+
+		/* Requests returned as NOMEM because no stripe request was available */
+		uint64_t starved;
+
+		/* Chunk submissions queued because a base bdev ran out of resources */
+		uint64_t chunk_submit_retries;
+	} stats;
+};
+
+/* Full stripe write or reconstruct requests of an io channel, resized with its load */
+struct raid5f_stripe_pool {
+	/* Stripe requests not in use */
+	TAILQ_HEAD(, stripe_request) free;
+
+	/* Number of allocated stripe requests */
+	uint32_t size;
+
+	/* Number of stripe requests in use */
+	uint32_t in_use;
+
+	/* Most stripe requests in use at once since the last shrink check */
+	uint32_t peak;
+
+	/* Most stripe requests in use at once since the last poll */
+	uint32_t poll_peak;
 };
 
 struct raid5f_io_channel {
-	/* All available stripe requests on this channel */
-	struct {
-		TAILQ_HEAD(, stripe_request) write;
-		TAILQ_HEAD(, stripe_request) reconstruct;
-	} free_stripe_requests;
+	/* Stripe request pools growing with the queue depth of this channel */
+	struct raid5f_stripe_pool write_pool;
+	struct raid5f_stripe_pool reconstruct_pool;
+
+	/* Memory used by the buffers of the stripe requests in the pools */
+	uint64_t stripe_pool_bytes;
+
+	/* Resizes the stripe request pools to the load of the channel */
+	struct spdk_poller *stripe_pool_poller;
+
+	/* Polls of the stripe pool poller since the last shrink check */
+	uint32_t stripe_pool_polls;
+
+	/* Available partial stripe write requests, one for each stripe cache entry */
+	TAILQ_HEAD(, stripe_request) free_partial_write_requests;
+
+	/* Stripe cache entries not used by a request, most recently used first */
+	TAILQ_HEAD(raid5f_stripe_cache_head, raid5f_stripe_cache_entry) stripe_cache;
 
 	/* accel_fw channel */
 	struct spdk_io_channel *accel_ch;
@@ -176,18 +342,220 @@ raid5f_stripe_parity_chunk_index(const struct raid_bdev *raid_bdev, uint64_t str
 	return raid5f_stripe_data_chunks_num(raid_bdev) - stripe_index % raid_bdev->num_base_bdevs;
 }
 
+static inline bool
+raid5f_range_empty(struct raid5f_range range)
+{
+	return range.start >= range.end;
+}
+
+static inline uint64_t
+raid5f_range_len(struct raid5f_range range)
+{
+	return raid5f_range_empty(range) ? 0 : range.end - range.start;
+}
+
+static struct raid5f_range
+raid5f_range_hull(struct raid5f_range a, struct raid5f_range b)
+{
+	if (raid5f_range_empty(a)) {
+		return b;
+	} else if (raid5f_range_empty(b)) {
+		return a;
+	}
+
+	return (struct raid5f_range) {
+		.start = spdk_min(a.start, b.start),
+		.end = spdk_max(a.end, b.end),
+	};
+}
+
+/* Returns the smallest range containing the part of 'need' not covered by 'valid' */
+static struct raid5f_range
+raid5f_range_uncovered(struct raid5f_range need, struct raid5f_range valid)
+{
+	struct raid5f_range range = {};
+
+	if (raid5f_range_empty(need) || raid5f_range_empty(valid) ||
+	    valid.end <= need.start || valid.start >= need.end) {
+		return need;
+	}
+
+	if (valid.start > need.start) {
+		range = (struct raid5f_range) { need.start, valid.start };
+	}
+
+	if (valid.end < need.end) {
+		range = raid5f_range_hull(range, (struct raid5f_range) { valid.end, need.end });
+	}
+
+	return range;
+}
+
+/* Adds 'range' to 'valid' if they are contiguous, otherwise replaces 'valid' with 'range' */
+static void
+raid5f_range_merge(struct raid5f_range *valid, struct raid5f_range range)
+{
+	if (raid5f_range_empty(range)) {
+		return;
+	}
+
+	if (!raid5f_range_empty(*valid) && range.start <= valid->end && valid->start <= range.end) {
+		*valid = raid5f_range_hull(*valid, range);
+	} else {
+		*valid = range;
+	}
+}
+
+static void
+raid5f_stripe_lock_acquired(void *_stripe_req)
+{
+	struct stripe_request *stripe_req = _stripe_req;
+
+	stripe_req->lock.cb(stripe_req);
+}
+
+/*
+ * Lock the stripe and call cb once the lock is held. Requests locking the same stripe are
+ * queued on the current lock holder and granted the lock in order, on their own threads.
+ */
+static void
+raid5f_stripe_lock(struct stripe_request *stripe_req, stripe_req_lock_cb cb)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
+	struct raid5f_stripe_lock_bucket *bucket;
+	struct stripe_request *holder;
+
+	bucket = &r5f_info->stripe_locks[stripe_req->stripe_index % RAID5F_STRIPE_LOCK_BUCKETS];
+	stripe_req->lock.cb = cb;
+
+	spdk_spin_lock(&bucket->lock);
+	TAILQ_FOREACH(holder, &bucket->holders, lock.link) {
+		if (holder->stripe_index == stripe_req->stripe_index) {
+			TAILQ_INSERT_TAIL(&holder->lock.waiters, stripe_req, lock.link);
+			spdk_spin_unlock(&bucket->lock);
+			return;
+		}
+	}
+
+	TAILQ_INIT(&stripe_req->lock.waiters);
+	TAILQ_INSERT_TAIL(&bucket->holders, stripe_req, lock.link);
+	stripe_req->lock.gen = bucket->gen;
+	stripe_req->lock.held = true;
+	spdk_spin_unlock(&bucket->lock);
+
+	cb(stripe_req);
+}
+
+static void
+raid5f_stripe_unlock(struct stripe_request *stripe_req)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
+	struct raid5f_stripe_lock_bucket *bucket;
+	struct stripe_request *next;
+	int rc;
+
+	assert(stripe_req->lock.held);
+
+	bucket = &r5f_info->stripe_locks[stripe_req->stripe_index % RAID5F_STRIPE_LOCK_BUCKETS];
+
+	spdk_spin_lock(&bucket->lock);
+	TAILQ_REMOVE(&bucket->holders, stripe_req, lock.link);
+	stripe_req->lock.held = false;
+
+	if (stripe_req->type != STRIPE_REQ_RECONSTRUCT) {
+		stripe_req->lock.gen = ++bucket->gen;
+	}
+
+	next = TAILQ_FIRST(&stripe_req->lock.waiters);
+	if (next != NULL) {
+		TAILQ_REMOVE(&stripe_req->lock.waiters, next, lock.link);
+		TAILQ_INIT(&next->lock.waiters);
+		TAILQ_CONCAT(&next->lock.waiters, &stripe_req->lock.waiters, lock.link);
+		TAILQ_INSERT_TAIL(&bucket->holders, next, lock.link);
+		next->lock.gen = bucket->gen;
+		next->lock.held = true;
+	}
+	spdk_spin_unlock(&bucket->lock);
+
+	if (next != NULL) {
+		rc = spdk_thread_send_msg(spdk_io_channel_get_thread(spdk_io_channel_from_ctx(next->r5ch)),
+					  raid5f_stripe_lock_acquired, next);
+		assert(rc == 0);
+		(void)rc;
+	}
+}
+
+/*
+ * Invalidate the cached copies of a stripe written without holding its lock. This is only
+ * done by the scrub, which runs in a quiesced range, so no lock holder can race with it.
+ */
+static void
+raid5f_stripe_cache_invalidate(struct raid5f_info *r5f_info, uint64_t stripe_index)
+{
+	struct raid5f_stripe_lock_bucket *bucket;
+
+	bucket = &r5f_info->stripe_locks[stripe_index % RAID5F_STRIPE_LOCK_BUCKETS];
+
+	spdk_spin_lock(&bucket->lock);
+	bucket->gen++;
+	spdk_spin_unlock(&bucket->lock);
+}
+
+static inline struct raid5f_stripe_pool *
+raid5f_stripe_pool(struct raid5f_io_channel *r5ch, enum stripe_request_type type)
+{
+	assert(type == STRIPE_REQ_WRITE || type == STRIPE_REQ_RECONSTRUCT);
+
+	return type == STRIPE_REQ_WRITE ? &r5ch->write_pool : &r5ch->reconstruct_pool;
+}
+
 static inline void
 raid5f_stripe_request_release(struct stripe_request *stripe_req)
 {
-	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
-		TAILQ_INSERT_HEAD(&stripe_req->r5ch->free_stripe_requests.write, stripe_req, link);
-	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
-		TAILQ_INSERT_HEAD(&stripe_req->r5ch->free_stripe_requests.reconstruct, stripe_req, link);
+	struct raid5f_stripe_pool *pool;
+
+	if (stripe_req->lock.held) {
+		raid5f_stripe_unlock(stripe_req);
+	}
+
+	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE ||
+			stripe_req->type == STRIPE_REQ_RECONSTRUCT)) {
+		pool = raid5f_stripe_pool(stripe_req->r5ch, stripe_req->type);
+		assert(pool->in_use > 0);
+		pool->in_use--;
+		TAILQ_INSERT_HEAD(&pool->free, stripe_req, link);
+	} else if (stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
+		TAILQ_INSERT_HEAD(&stripe_req->r5ch->free_partial_write_requests, stripe_req, link);
 	} else {
 		assert(false);
 	}
 }
 
+/*
+ * Get a stripe request from the pool. The pool is never grown here, to not allocate memory in
+ * the I/O path. If it runs out, the request is retried later and the pool poller grows it.
+ */
+static struct stripe_request *
+raid5f_stripe_request_get(struct raid5f_io_channel *r5ch, enum stripe_request_type type)
+{
+	struct raid5f_stripe_pool *pool = raid5f_stripe_pool(r5ch, type);
+	struct stripe_request *stripe_req;
+
+	stripe_req = TAILQ_FIRST(&pool->free);
+	if (spdk_unlikely(stripe_req == NULL)) {
+		__atomic_fetch_add(&raid5f_ch_to_r5f_info(r5ch)->stats.starved, 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+
+	TAILQ_REMOVE(&pool->free, stripe_req, link);
+
+	pool->in_use++;
+	pool->peak = spdk_max(pool->peak, pool->in_use);
+	pool->poll_peak = spdk_max(pool->poll_peak, pool->in_use);
+
+	return stripe_req;
+}
+
 static void raid5f_xor_stripe_retry(struct stripe_request *stripe_req);
 
 static void
@@ -353,10 +721,14 @@ raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 	raid5f_xor_stripe_continue(stripe_req);
 }
 
+static void raid5f_partial_write_xor_submit(struct stripe_request *stripe_req);
+
 static void
 raid5f_xor_stripe_retry(struct stripe_request *stripe_req)
 {
-	if (stripe_req->xor.remaining_md) {
+	if (stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
+		raid5f_partial_write_xor_submit(stripe_req);
+	} else if (stripe_req->xor.remaining_md) {
 		raid5f_xor_stripe(stripe_req, stripe_req->xor.cb);
 	} else {
 		raid5f_xor_stripe_continue(stripe_req);
@@ -393,7 +765,8 @@ raid5f_chunk_complete_bdev_io(struct spdk_bdev_io *bdev_io, bool success, void *
 
 	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
 		raid5f_stripe_request_chunk_write_complete(stripe_req, status);
-	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT ||
+		   stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
 		raid5f_stripe_request_chunk_read_complete(stripe_req, status);
 	} else {
 		assert(false);
@@ -462,6 +835,24 @@ raid5f_chunk_submit(struct chunk *chunk)
 						 base_offset_blocks, raid_io->num_blocks,
 						 raid5f_chunk_complete_bdev_io, chunk, &io_opts);
 		break;
+	case STRIPE_REQ_PARTIAL_WRITE:
+		if (base_ch == NULL || raid5f_range_empty(chunk->io_range)) {
+			raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+			return 0;
+		}
+
+		base_offset_blocks += chunk->io_range.start;
+
+		if (stripe_req->partial.reading) {
+			ret = raid_bdev_readv_blocks_ext(base_info, base_ch, chunk->iovs, chunk->iovcnt,
+							 base_offset_blocks, raid5f_range_len(chunk->io_range),
+							 raid5f_chunk_complete_bdev_io, chunk, &io_opts);
+		} else {
+			ret = raid_bdev_writev_blocks_ext(base_info, base_ch, chunk->iovs, chunk->iovcnt,
+							  base_offset_blocks, raid5f_range_len(chunk->io_range),
+							  raid5f_chunk_complete_bdev_io, chunk, &io_opts);
+		}
+		break;
 	default:
 		assert(false);
 		ret = -EINVAL;
@@ -471,6 +862,8 @@ raid5f_chunk_submit(struct chunk *chunk)
 	if (spdk_unlikely(ret)) {
 		raid_io->base_bdev_io_submitted--;
 		if (ret == -ENOMEM) {
+			__atomic_fetch_add(&raid5f_ch_to_r5f_info(stripe_req->r5ch)->stats.chunk_submit_retries,
+					   1, __ATOMIC_RELAXED);
 			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
 						base_ch, raid5f_chunk_submit_retry);
 		} else {
@@ -481,16 +874,18 @@ raid5f_chunk_submit(struct chunk *chunk)
 			 */
 			uint64_t base_bdev_io_not_submitted;
 
-			if (stripe_req->type == STRIPE_REQ_WRITE) {
-				base_bdev_io_not_submitted = raid_bdev->num_base_bdevs -
+			if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+				base_bdev_io_not_submitted = raid5f_stripe_data_chunks_num(raid_bdev) -
 							     raid_io->base_bdev_io_submitted;
 			} else {
-				base_bdev_io_not_submitted = raid5f_stripe_data_chunks_num(raid_bdev) -
+				base_bdev_io_not_submitted = raid_bdev->num_base_bdevs -
 							     raid_io->base_bdev_io_submitted;
 			}
 
+			/* Other request types are released by their completion_cb */
 			if (raid_bdev_io_complete_part(raid_io, base_bdev_io_not_submitted,
-						       SPDK_BDEV_IO_STATUS_FAILED)) {
+						       SPDK_BDEV_IO_STATUS_FAILED) &&
+			    stripe_req->type == STRIPE_REQ_WRITE) {
 				raid5f_stripe_request_release(stripe_req);
 			}
 		}
@@ -621,6 +1016,18 @@ raid5f_stripe_write_request_xor_done(struct stripe_request *stripe_req, int stat
 	}
 }
 
+static void
+raid5f_stripe_write_request_locked(struct stripe_request *stripe_req)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	if (raid_bdev_channel_get_base_channel(raid_io->raid_ch, stripe_req->parity_chunk->index) != NULL) {
+		raid5f_xor_stripe(stripe_req, raid5f_stripe_write_request_xor_done);
+	} else {
+		raid5f_stripe_write_request_xor_done(stripe_req, 0);
+	}
+}
+
 static int
 raid5f_submit_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index)
 {
@@ -629,7 +1036,7 @@ raid5f_submit_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index)
 	struct stripe_request *stripe_req;
 	int ret;
 
-	stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.write);
+	stripe_req = raid5f_stripe_request_get(r5ch, STRIPE_REQ_WRITE);
 	if (!stripe_req) {
 		return -ENOMEM;
 	}
@@ -638,84 +1045,656 @@ raid5f_submit_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index)
 
 	ret = raid5f_stripe_request_map_iovecs(stripe_req);
 	if (spdk_unlikely(ret)) {
+		raid5f_stripe_request_release(stripe_req);
 		return ret;
 	}
 
-	TAILQ_REMOVE(&r5ch->free_stripe_requests.write, stripe_req, link);
-
 	raid_io->module_private = stripe_req;
 	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
 
-	if (raid_bdev_channel_get_base_channel(raid_io->raid_ch, stripe_req->parity_chunk->index) != NULL) {
-		raid5f_xor_stripe(stripe_req, raid5f_stripe_write_request_xor_done);
-	} else {
-		raid5f_stripe_write_request_xor_done(stripe_req, 0);
-	}
+	raid5f_stripe_lock(stripe_req, raid5f_stripe_write_request_locked);
 
 	return 0;
 }
 
-static void
-raid5f_chunk_read_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+static inline void *
+raid5f_partial_write_buf(struct stripe_request *stripe_req, struct chunk *chunk, uint64_t offset)
 {
-	struct raid_bdev_io *raid_io = cb_arg;
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
 
-	spdk_bdev_free_io(bdev_io);
+	return stripe_req->partial.entry->chunk_buffers[chunk->index] +
+	       offset * raid_bdev->bdev.blocklen;
+}
 
-	raid_bdev_io_complete(raid_io, success ? SPDK_BDEV_IO_STATUS_SUCCESS :
-			      SPDK_BDEV_IO_STATUS_FAILED);
+static inline void *
+raid5f_partial_write_md_buf(struct stripe_request *stripe_req, struct chunk *chunk, uint64_t offset)
+{
+	struct raid5f_stripe_cache_entry *entry = stripe_req->partial.entry;
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+
+	if (entry->chunk_md_buffers == NULL) {
+		return NULL;
+	}
+
+	return entry->chunk_md_buffers[chunk->index] + offset * raid_bdev->bdev.md_len;
 }
 
-static void raid5f_submit_rw_request(struct raid_bdev_io *raid_io);
+static void
+raid5f_partial_write_xor_submit(struct stripe_request *stripe_req)
+{
+	struct raid5f_io_channel *r5ch = stripe_req->r5ch;
+	struct raid5f_partial_write_xor_args *args = &stripe_req->partial.xor_args;
+	int ret;
+
+	if (args->md_dst != NULL && !args->md_submitted) {
+		ret = spdk_accel_submit_xor(r5ch->accel_ch, args->md_dst, stripe_req->chunk_xor_md_buffers,
+					    args->nsrcs, stripe_req->xor.remaining_md, raid5f_xor_stripe_md_cb,
+					    stripe_req);
+		if (spdk_unlikely(ret)) {
+			if (ret == -ENOMEM) {
+				TAILQ_INSERT_HEAD(&r5ch->xor_retry_queue, stripe_req, link);
+			} else {
+				stripe_req->xor.status = ret;
+				raid5f_xor_stripe_done(stripe_req);
+			}
+			return;
+		}
+		args->md_submitted = true;
+	}
+
+	ret = spdk_accel_submit_xor(r5ch->accel_ch, args->dst, stripe_req->chunk_xor_buffers, args->nsrcs,
+				    stripe_req->xor.len, raid5f_xor_stripe_cb, stripe_req);
+	if (spdk_unlikely(ret)) {
+		if (ret == -ENOMEM) {
+			TAILQ_INSERT_HEAD(&r5ch->xor_retry_queue, stripe_req, link);
+		} else {
+			stripe_req->xor.remaining = 0;
+			_raid5f_xor_stripe_cb(stripe_req, ret);
+		}
+	}
+}
 
+/*
+ * Calculate dst = src[0] ^ ... ^ src[nsrcs - 1] over the partial write range. The sources
+ * must be set in stripe_req->chunk_xor_buffers and chunk_xor_md_buffers by the caller.
+ */
 static void
-_raid5f_submit_rw_request(void *_raid_io)
+raid5f_partial_write_xor(struct stripe_request *stripe_req, void *dst, void *md_dst,
+			 uint8_t nsrcs, stripe_req_xor_cb cb)
 {
-	struct raid_bdev_io *raid_io = _raid_io;
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	uint64_t num_blocks = raid5f_range_len(stripe_req->partial.range);
+
+	stripe_req->partial.xor_args.dst = dst;
+	stripe_req->partial.xor_args.md_dst = md_dst;
+	stripe_req->partial.xor_args.nsrcs = nsrcs;
+	stripe_req->partial.xor_args.md_submitted = false;
+
+	/* The whole range is xored at once, so raid5f_xor_stripe_cb() doesn't iterate further */
+	stripe_req->xor.len = num_blocks * raid_bdev->bdev.blocklen;
+	stripe_req->xor.remaining = stripe_req->xor.len;
+	stripe_req->xor.remaining_md = md_dst != NULL ? num_blocks * raid_bdev->bdev.md_len : 0;
+	stripe_req->xor.status = 0;
+	stripe_req->xor.cb = cb;
 
-	raid5f_submit_rw_request(raid_io);
+	raid5f_partial_write_xor_submit(stripe_req);
 }
 
 static void
-raid5f_stripe_request_reconstruct_xor_done(struct stripe_request *stripe_req, int status)
+raid5f_partial_write_finish(struct stripe_request *stripe_req, int status)
 {
 	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid5f_stripe_cache_entry *entry = stripe_req->partial.entry;
+	struct raid5f_range range = stripe_req->partial.range;
+	struct chunk *chunk;
+
+	raid_io->completion_cb = NULL;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		struct raid5f_range *valid = &entry->valid[chunk->index];
+
+		if (status != 0) {
+			*valid = (struct raid5f_range) {};
+			continue;
+		}
+
+		switch (stripe_req->partial.mode) {
+		case RAID5F_PARTIAL_WRITE_DATA_ONLY:
+			if (chunk == stripe_req->parity_chunk) {
+				*valid = (struct raid5f_range) {};
+			} else {
+				raid5f_range_merge(valid, chunk->write_range);
+			}
+			break;
+		case RAID5F_PARTIAL_WRITE_RMW:
+			raid5f_range_merge(valid, chunk == stripe_req->parity_chunk ? range : chunk->write_range);
+			break;
+		default:
+			raid5f_range_merge(valid, range);
+			break;
+		}
+	}
+
+	raid5f_stripe_unlock(stripe_req);
+	entry->gen = stripe_req->lock.gen;
 
+	TAILQ_INSERT_HEAD(&stripe_req->r5ch->stripe_cache, entry, link);
 	raid5f_stripe_request_release(stripe_req);
 
-	raid_bdev_io_complete(raid_io,
-			      status == 0 ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED);
+	raid_bdev_io_complete(raid_io, status == 0 ? SPDK_BDEV_IO_STATUS_SUCCESS :
+			      SPDK_BDEV_IO_STATUS_FAILED);
 }
 
 static void
-raid5f_reconstruct_reads_completed_cb(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
+raid5f_partial_write_writes_completed_cb(struct raid_bdev_io *raid_io,
+		enum spdk_bdev_io_status status)
 {
 	struct stripe_request *stripe_req = raid_io->module_private;
 
-	raid_io->completion_cb = NULL;
-
-	if (status != SPDK_BDEV_IO_STATUS_SUCCESS) {
-		stripe_req->xor.cb(stripe_req, -EIO);
-		return;
-	}
-
-	raid5f_xor_stripe(stripe_req, stripe_req->xor.cb);
+	raid5f_partial_write_finish(stripe_req, status == SPDK_BDEV_IO_STATUS_SUCCESS ? 0 : -EIO);
 }
 
-static int
-raid5f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_index,
-			       uint8_t chunk_idx, uint64_t chunk_offset, stripe_req_xor_cb cb)
+static void
+raid5f_partial_write_submit_chunks(struct stripe_request *stripe_req, bool reading,
+				   raid_bdev_io_completion_cb cb)
 {
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
 	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
-	struct raid5f_io_channel *r5ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
-	void *raid_io_md = raid_io->md_buf;
-	struct stripe_request *stripe_req;
 	struct chunk *chunk;
-	int buf_idx;
-
-	assert(cb != NULL);
 
-	stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.reconstruct);
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		if (raid5f_range_empty(chunk->io_range)) {
+			continue;
+		}
+
+		chunk->iovs[0].iov_base = raid5f_partial_write_buf(stripe_req, chunk, chunk->io_range.start);
+		chunk->iovs[0].iov_len = raid5f_range_len(chunk->io_range) * raid_bdev->bdev.blocklen;
+		chunk->iovcnt = 1;
+		chunk->md_buf = raid5f_partial_write_md_buf(stripe_req, chunk, chunk->io_range.start);
+	}
+
+	stripe_req->partial.reading = reading;
+	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
+	raid_io->base_bdev_io_submitted = 0;
+	raid_io->completion_cb = cb;
+
+	raid5f_stripe_request_submit_chunks(stripe_req);
+}
+
+static void
+raid5f_partial_write_submit_writes(struct stripe_request *stripe_req, int status)
+{
+	struct chunk *chunk;
+
+	if (status != 0) {
+		raid5f_partial_write_finish(stripe_req, status);
+		return;
+	}
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		if (chunk == stripe_req->parity_chunk) {
+			if (stripe_req->partial.mode == RAID5F_PARTIAL_WRITE_DATA_ONLY) {
+				chunk->io_range = (struct raid5f_range) {};
+			} else {
+				chunk->io_range = stripe_req->partial.range;
+			}
+		} else {
+			chunk->io_range = chunk->write_range;
+		}
+	}
+
+	raid5f_partial_write_submit_chunks(stripe_req, false, raid5f_partial_write_writes_completed_cb);
+}
+
+/* Copy the data of the raid_io to the stripe cache entry buffers */
+static void
+raid5f_partial_write_copy_data(struct stripe_request *stripe_req)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct spdk_iov_xfer ix;
+	struct chunk *chunk;
+	void *md_buf = raid_io->md_buf;
+
+	spdk_iov_xfer_init(&ix, raid_io->iovs, raid_io->iovcnt);
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		uint64_t num_blocks = raid5f_range_len(chunk->write_range);
+
+		if (num_blocks == 0) {
+			continue;
+		}
+
+		spdk_iov_xfer_to_buf(&ix, raid5f_partial_write_buf(stripe_req, chunk, chunk->write_range.start),
+				     num_blocks * raid_bdev->bdev.blocklen);
+
+		if (md_buf != NULL) {
+			memcpy(raid5f_partial_write_md_buf(stripe_req, chunk, chunk->write_range.start), md_buf,
+			       num_blocks * raid_bdev->bdev.md_len);
+			md_buf += num_blocks * raid_bdev->bdev.md_len;
+		}
+	}
+}
+
+static void
+raid5f_partial_write_rmw_xor_done(struct stripe_request *stripe_req, int status)
+{
+	struct chunk *parity_chunk = stripe_req->parity_chunk;
+	uint64_t offset = stripe_req->partial.range.start;
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	struct chunk *chunk;
+	uint8_t c = 0;
+
+	if (status != 0) {
+		raid5f_partial_write_finish(stripe_req, status);
+		return;
+	}
+
+	raid5f_partial_write_copy_data(stripe_req);
+
+	/* new parity = (old parity ^ old data) ^ new data */
+	stripe_req->chunk_xor_buffers[c] = stripe_req->partial.tmp_buf + offset * raid_bdev->bdev.blocklen;
+	stripe_req->chunk_xor_md_buffers[c] = stripe_req->partial.tmp_md_buf == NULL ? NULL :
+					      stripe_req->partial.tmp_md_buf + offset * raid_bdev->bdev.md_len;
+	c++;
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		if (raid5f_range_empty(chunk->write_range)) {
+			continue;
+		}
+		stripe_req->chunk_xor_buffers[c] = raid5f_partial_write_buf(stripe_req, chunk, offset);
+		stripe_req->chunk_xor_md_buffers[c] = raid5f_partial_write_md_buf(stripe_req, chunk, offset);
+		c++;
+	}
+
+	raid5f_partial_write_xor(stripe_req, raid5f_partial_write_buf(stripe_req, parity_chunk, offset),
+				 raid5f_partial_write_md_buf(stripe_req, parity_chunk, offset), c,
+				 raid5f_partial_write_submit_writes);
+}
+
+static void
+raid5f_partial_write_update_parity(struct stripe_request *stripe_req)
+{
+	struct chunk *parity_chunk = stripe_req->parity_chunk;
+	uint64_t offset = stripe_req->partial.range.start;
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	struct chunk *chunk;
+	uint8_t c = 0;
+
+	switch (stripe_req->partial.mode) {
+	case RAID5F_PARTIAL_WRITE_DATA_ONLY:
+		raid5f_partial_write_copy_data(stripe_req);
+		raid5f_partial_write_submit_writes(stripe_req, 0);
+		break;
+	case RAID5F_PARTIAL_WRITE_RCW:
+		raid5f_partial_write_copy_data(stripe_req);
+
+		FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+			stripe_req->chunk_xor_buffers[c] = raid5f_partial_write_buf(stripe_req, chunk, offset);
+			stripe_req->chunk_xor_md_buffers[c] = raid5f_partial_write_md_buf(stripe_req, chunk, offset);
+			c++;
+		}
+
+		raid5f_partial_write_xor(stripe_req,
+					 raid5f_partial_write_buf(stripe_req, parity_chunk, offset),
+					 raid5f_partial_write_md_buf(stripe_req, parity_chunk, offset), c,
+					 raid5f_partial_write_submit_writes);
+		break;
+	case RAID5F_PARTIAL_WRITE_RMW:
+		/* Remove the old data from the parity, the new data is added once copied */
+		stripe_req->chunk_xor_buffers[c] = raid5f_partial_write_buf(stripe_req, parity_chunk, offset);
+		stripe_req->chunk_xor_md_buffers[c] = raid5f_partial_write_md_buf(stripe_req, parity_chunk,
+						      offset);
+		c++;
+
+		FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+			if (raid5f_range_empty(chunk->write_range)) {
+				continue;
+			}
+			stripe_req->chunk_xor_buffers[c] = raid5f_partial_write_buf(stripe_req, chunk, offset);
+			stripe_req->chunk_xor_md_buffers[c] = raid5f_partial_write_md_buf(stripe_req, chunk, offset);
+			c++;
+		}
+
+		raid5f_partial_write_xor(stripe_req,
+					 stripe_req->partial.tmp_buf + offset * raid_bdev->bdev.blocklen,
+					 stripe_req->partial.tmp_md_buf == NULL ? NULL :
+					 stripe_req->partial.tmp_md_buf + offset * raid_bdev->bdev.md_len, c,
+					 raid5f_partial_write_rmw_xor_done);
+		break;
+	default:
+		assert(false);
+		raid5f_partial_write_finish(stripe_req, -EINVAL);
+		break;
+	}
+}
+
+static void
+raid5f_partial_write_reconstruct_done(struct stripe_request *stripe_req, int status)
+{
+	if (status != 0) {
+		raid5f_partial_write_finish(stripe_req, status);
+		return;
+	}
+
+	/* All chunks are now valid in the written range */
+	stripe_req->partial.mode = RAID5F_PARTIAL_WRITE_RCW;
+	raid5f_partial_write_update_parity(stripe_req);
+}
+
+static void
+raid5f_partial_write_reads_done(struct stripe_request *stripe_req)
+{
+	struct raid5f_stripe_cache_entry *entry = stripe_req->partial.entry;
+	uint64_t offset = stripe_req->partial.range.start;
+	struct chunk *missing_chunk;
+	struct chunk *chunk;
+	uint8_t c = 0;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		raid5f_range_merge(&entry->valid[chunk->index], chunk->io_range);
+	}
+
+	if (stripe_req->partial.mode != RAID5F_PARTIAL_WRITE_REC) {
+		raid5f_partial_write_update_parity(stripe_req);
+		return;
+	}
+
+	missing_chunk = &stripe_req->chunks[stripe_req->partial.missing];
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		if (chunk == missing_chunk) {
+			continue;
+		}
+		stripe_req->chunk_xor_buffers[c] = raid5f_partial_write_buf(stripe_req, chunk, offset);
+		stripe_req->chunk_xor_md_buffers[c] = raid5f_partial_write_md_buf(stripe_req, chunk, offset);
+		c++;
+	}
+
+	raid5f_partial_write_xor(stripe_req, raid5f_partial_write_buf(stripe_req, missing_chunk, offset),
+				 raid5f_partial_write_md_buf(stripe_req, missing_chunk, offset), c,
+				 raid5f_partial_write_reconstruct_done);
+}
+
+static void
+raid5f_partial_write_reads_completed_cb(struct raid_bdev_io *raid_io,
+					enum spdk_bdev_io_status status)
+{
+	struct stripe_request *stripe_req = raid_io->module_private;
+
+	raid_io->completion_cb = NULL;
+
+	if (status != SPDK_BDEV_IO_STATUS_SUCCESS) {
+		raid5f_partial_write_finish(stripe_req, -EIO);
+		return;
+	}
+
+	raid5f_partial_write_reads_done(stripe_req);
+}
+
+/*
+ * Set the io_range of each chunk to the blocks that need to be read for the given mode,
+ * considering what's already in the stripe cache. Returns the total number of blocks to read
+ * or UINT64_MAX if the mode would require reading the missing chunk.
+ */
+static uint64_t
+raid5f_partial_write_plan_reads(struct stripe_request *stripe_req,
+				enum raid5f_partial_write_mode mode)
+{
+	struct raid5f_stripe_cache_entry *entry = stripe_req->partial.entry;
+	struct raid5f_range range = stripe_req->partial.range;
+	struct raid5f_range write_range;
+	struct raid5f_range valid;
+	struct raid5f_range before, after;
+	struct raid5f_range r;
+	struct chunk *chunk;
+	uint64_t num_blocks = 0;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		valid = entry->valid[chunk->index];
+		write_range = chunk->write_range;
+		r = (struct raid5f_range) {};
+
+		switch (mode) {
+		case RAID5F_PARTIAL_WRITE_RCW:
+			/* Data chunks are needed in the whole range, except for the written blocks */
+			if (chunk == stripe_req->parity_chunk) {
+				break;
+			} else if (raid5f_range_empty(write_range)) {
+				r = raid5f_range_uncovered(range, valid);
+			} else {
+				before = (struct raid5f_range) { range.start, write_range.start };
+				after = (struct raid5f_range) { write_range.end, range.end };
+				r = raid5f_range_hull(raid5f_range_uncovered(before, valid),
+						      raid5f_range_uncovered(after, valid));
+			}
+			break;
+		case RAID5F_PARTIAL_WRITE_RMW:
+			/* Old parity is needed in the whole range and old data in the written blocks */
+			if (chunk == stripe_req->parity_chunk) {
+				r = raid5f_range_uncovered(range, valid);
+			} else {
+				r = raid5f_range_uncovered(write_range, valid);
+			}
+			break;
+		case RAID5F_PARTIAL_WRITE_REC:
+			if (chunk->index != stripe_req->partial.missing) {
+				r = raid5f_range_uncovered(range, valid);
+			}
+			break;
+		default:
+			break;
+		}
+
+		if (!raid5f_range_empty(r) && chunk->index == stripe_req->partial.missing) {
+			return UINT64_MAX;
+		}
+
+		chunk->io_range = r;
+		num_blocks += raid5f_range_len(r);
+	}
+
+	return num_blocks;
+}
+
+static struct raid5f_stripe_cache_entry *
+raid5f_stripe_cache_get(struct stripe_request *stripe_req, bool *hit)
+{
+	struct raid5f_io_channel *r5ch = stripe_req->r5ch;
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	struct raid5f_stripe_cache_entry *entry;
+	uint8_t i;
+
+	TAILQ_FOREACH(entry, &r5ch->stripe_cache, link) {
+		if (entry->stripe_index == stripe_req->stripe_index) {
+			break;
+		}
+	}
+
+	/* There are as many entries as partial write requests so one is always available */
+	if (entry == NULL) {
+		entry = TAILQ_LAST(&r5ch->stripe_cache, raid5f_stripe_cache_head);
+		assert(entry != NULL);
+		entry->stripe_index = stripe_req->stripe_index;
+		*hit = false;
+	} else {
+		/* The stripe could have been written since on another channel */
+		*hit = entry->gen == stripe_req->lock.gen;
+	}
+
+	if (!*hit) {
+		for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+			entry->valid[i] = (struct raid5f_range) {};
+		}
+	}
+
+	TAILQ_REMOVE(&r5ch->stripe_cache, entry, link);
+
+	return entry;
+}
+
+static void
+raid5f_partial_write_locked(struct stripe_request *stripe_req)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct chunk *chunk;
+	uint64_t rcw_blocks, rmw_blocks;
+	bool read_ahead;
+	bool hit;
+
+	stripe_req->partial.entry = raid5f_stripe_cache_get(stripe_req, &hit);
+
+	if (stripe_req->partial.missing == stripe_req->parity_chunk->index) {
+		stripe_req->partial.mode = RAID5F_PARTIAL_WRITE_DATA_ONLY;
+	} else {
+		rcw_blocks = raid5f_partial_write_plan_reads(stripe_req, RAID5F_PARTIAL_WRITE_RCW);
+		rmw_blocks = raid5f_partial_write_plan_reads(stripe_req, RAID5F_PARTIAL_WRITE_RMW);
+
+		if (rcw_blocks == UINT64_MAX && rmw_blocks == UINT64_MAX) {
+			stripe_req->partial.mode = RAID5F_PARTIAL_WRITE_REC;
+		} else if (rmw_blocks < rcw_blocks) {
+			stripe_req->partial.mode = RAID5F_PARTIAL_WRITE_RMW;
+		} else {
+			stripe_req->partial.mode = RAID5F_PARTIAL_WRITE_RCW;
+		}
+	}
+
+	if (raid5f_partial_write_plan_reads(stripe_req, stripe_req->partial.mode) == 0) {
+		raid5f_partial_write_reads_done(stripe_req);
+		return;
+	}
+
+	/*
+	 * Sequential writes are likely to continue in this stripe, so read the chunks up to the
+	 * end of the strip to let the following writes find the data in the stripe cache.
+	 */
+	read_ahead = hit || stripe_req->partial.stripe_offset == 0;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		if (read_ahead && !raid5f_range_empty(chunk->io_range)) {
+			chunk->io_range.end = raid_bdev->strip_size;
+		}
+	}
+
+	raid5f_partial_write_submit_chunks(stripe_req, true, raid5f_partial_write_reads_completed_cb);
+}
+
+static int
+raid5f_submit_partial_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+				    uint64_t stripe_offset)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid5f_io_channel *r5ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	struct stripe_request *stripe_req;
+	struct chunk *chunk;
+	uint64_t chunk_start = 0;
+	uint64_t write_start = stripe_offset;
+	uint64_t write_end = stripe_offset + raid_io->num_blocks;
+
+	stripe_req = TAILQ_FIRST(&r5ch->free_partial_write_requests);
+	if (!stripe_req) {
+		__atomic_fetch_add(&raid5f_ch_to_r5f_info(r5ch)->stats.starved, 1, __ATOMIC_RELAXED);
+		return -ENOMEM;
+	}
+
+	raid5f_stripe_request_init(stripe_req, raid_io, stripe_index);
+
+	stripe_req->partial.stripe_offset = stripe_offset;
+	stripe_req->partial.range = (struct raid5f_range) {};
+	stripe_req->partial.missing = UINT8_MAX;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		chunk->write_range = (struct raid5f_range) {};
+
+		if (raid_bdev_channel_get_base_channel(raid_io->raid_ch, chunk->index) == NULL) {
+			stripe_req->partial.missing = chunk->index;
+		}
+	}
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		uint64_t chunk_end = chunk_start + raid_bdev->strip_size;
+
+		if (write_start < chunk_end && write_end > chunk_start) {
+			chunk->write_range.start = spdk_max(write_start, chunk_start) - chunk_start;
+			chunk->write_range.end = spdk_min(write_end, chunk_end) - chunk_start;
+			stripe_req->partial.range = raid5f_range_hull(stripe_req->partial.range,
+						    chunk->write_range);
+		}
+
+		chunk_start = chunk_end;
+	}
+
+	TAILQ_REMOVE(&r5ch->free_partial_write_requests, stripe_req, link);
+
+	raid_io->module_private = stripe_req;
+
+	raid5f_stripe_lock(stripe_req, raid5f_partial_write_locked);
+
+	return 0;
+}
+
+static void
+raid5f_chunk_read_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_io_complete(raid_io, success ? SPDK_BDEV_IO_STATUS_SUCCESS :
+			      SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void raid5f_submit_rw_request(struct raid_bdev_io *raid_io);
+
+static void
+_raid5f_submit_rw_request(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid5f_submit_rw_request(raid_io);
+}
+
+static void
+raid5f_stripe_request_reconstruct_xor_done(struct stripe_request *stripe_req, int status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	raid5f_stripe_request_release(stripe_req);
+
+	raid_bdev_io_complete(raid_io,
+			      status == 0 ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void
+raid5f_reconstruct_reads_completed_cb(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
+{
+	struct stripe_request *stripe_req = raid_io->module_private;
+
+	raid_io->completion_cb = NULL;
+
+	if (status != SPDK_BDEV_IO_STATUS_SUCCESS) {
+		stripe_req->xor.cb(stripe_req, -EIO);
+		return;
+	}
+
+	raid5f_xor_stripe(stripe_req, stripe_req->xor.cb);
+}
+
+static int
+raid5f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+			       uint8_t chunk_idx, uint64_t chunk_offset, stripe_req_xor_cb cb)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid5f_io_channel *r5ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	void *raid_io_md = raid_io->md_buf;
+	struct stripe_request *stripe_req;
+	struct chunk *chunk;
+	int buf_idx;
+
+	assert(cb != NULL);
+
+	stripe_req = raid5f_stripe_request_get(r5ch, STRIPE_REQ_RECONSTRUCT);
 	if (!stripe_req) {
 		return -ENOMEM;
 	}
@@ -734,6 +1713,7 @@ raid5f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_ind
 
 			ret = raid5f_chunk_set_iovcnt(chunk, raid_io->iovcnt);
 			if (ret) {
+				raid5f_stripe_request_release(stripe_req);
 				return ret;
 			}
 
@@ -761,9 +1741,8 @@ raid5f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_ind
 	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
 	raid_io->completion_cb = raid5f_reconstruct_reads_completed_cb;
 
-	TAILQ_REMOVE(&r5ch->free_stripe_requests.reconstruct, stripe_req, link);
-
-	raid5f_stripe_request_submit_chunks(stripe_req);
+	/* Prevent partial stripe writes from changing the stripe while it's being read */
+	raid5f_stripe_lock(stripe_req, raid5f_stripe_request_submit_chunks);
 
 	return 0;
 }
@@ -816,9 +1795,12 @@ raid5f_submit_rw_request(struct raid_bdev_io *raid_io)
 		ret = raid5f_submit_read_request(raid_io, stripe_index, stripe_offset);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
-		assert(stripe_offset == 0);
-		assert(raid_io->num_blocks == r5f_info->stripe_blocks);
-		ret = raid5f_submit_write_request(raid_io, stripe_index);
+		assert(stripe_offset + raid_io->num_blocks <= r5f_info->stripe_blocks);
+		if (stripe_offset == 0 && raid_io->num_blocks == r5f_info->stripe_blocks) {
+			ret = raid5f_submit_write_request(raid_io, stripe_index);
+		} else {
+			ret = raid5f_submit_partial_write_request(raid_io, stripe_index, stripe_offset);
+		}
 		break;
 	default:
 		ret = -EINVAL;
@@ -861,6 +1843,9 @@ raid5f_stripe_request_free(struct stripe_request *stripe_req)
 			}
 			free(stripe_req->reconstruct.chunk_md_buffers);
 		}
+	} else if (stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
+		spdk_dma_free(stripe_req->partial.tmp_buf);
+		spdk_dma_free(stripe_req->partial.tmp_md_buf);
 	} else {
 		assert(false);
 	}
@@ -919,58 +1904,316 @@ raid5f_stripe_request_alloc(struct raid5f_io_channel *r5ch, enum stripe_request_
 		void *buf;
 		uint8_t i;
 
-		stripe_req->reconstruct.chunk_buffers = calloc(n, sizeof(void *));
-		if (!stripe_req->reconstruct.chunk_buffers) {
-			goto err;
+		stripe_req->reconstruct.chunk_buffers = calloc(n, sizeof(void *));
+		if (!stripe_req->reconstruct.chunk_buffers) {
+			goto err;
+		}
+
+		for (i = 0; i < n; i++) {
+			buf = spdk_dma_malloc(chunk_len, r5f_info->buf_alignment, NULL);
+			if (!buf) {
+				goto err;
+			}
+			stripe_req->reconstruct.chunk_buffers[i] = buf;
+		}
+
+		if (raid_io_md_size != 0) {
+			stripe_req->reconstruct.chunk_md_buffers = calloc(n, sizeof(void *));
+			if (!stripe_req->reconstruct.chunk_md_buffers) {
+				goto err;
+			}
+
+			for (i = 0; i < n; i++) {
+				buf = spdk_dma_malloc(raid_bdev->strip_size * raid_io_md_size, r5f_info->buf_alignment, NULL);
+				if (!buf) {
+					goto err;
+				}
+				stripe_req->reconstruct.chunk_md_buffers[i] = buf;
+			}
+		}
+	} else if (type == STRIPE_REQ_PARTIAL_WRITE) {
+		stripe_req->partial.tmp_buf = spdk_dma_malloc(chunk_len, r5f_info->buf_alignment, NULL);
+		if (!stripe_req->partial.tmp_buf) {
+			goto err;
+		}
+
+		if (raid_io_md_size != 0) {
+			stripe_req->partial.tmp_md_buf = spdk_dma_malloc(raid_bdev->strip_size * raid_io_md_size,
+							 r5f_info->buf_alignment, NULL);
+			if (!stripe_req->partial.tmp_md_buf) {
+				goto err;
+			}
+		}
+	} else {
+		assert(false);
+		return NULL;
+	}
+
+	stripe_req->chunk_iov_iters = malloc(SPDK_IOVITER_SIZE(raid_bdev->num_base_bdevs));
+	if (!stripe_req->chunk_iov_iters) {
+		goto err;
+	}
+
+	/* Read-modify-write may xor the parity and all data chunks */
+	stripe_req->chunk_xor_buffers = calloc(raid_bdev->num_base_bdevs,
+					       sizeof(stripe_req->chunk_xor_buffers[0]));
+	if (!stripe_req->chunk_xor_buffers) {
+		goto err;
+	}
+
+	stripe_req->chunk_xor_md_buffers = calloc(raid_bdev->num_base_bdevs,
+					   sizeof(stripe_req->chunk_xor_md_buffers[0]));
+	if (!stripe_req->chunk_xor_md_buffers) {
+		goto err;
+	}
+
+	return stripe_req;
+err:
+	raid5f_stripe_request_free(stripe_req);
+	return NULL;
+}
+
+static uint64_t
+raid5f_stripe_request_buf_size(struct raid5f_info *r5f_info, enum stripe_request_type type)
+{
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	uint32_t raid_io_md_size = raid_bdev->bdev.md_interleave ? 0 : raid_bdev->bdev.md_len;
+	uint64_t chunk_size = raid_bdev->strip_size * (raid_bdev->bdev.blocklen + raid_io_md_size);
+
+	if (type == STRIPE_REQ_RECONSTRUCT) {
+		return chunk_size * raid5f_stripe_data_chunks_num(raid_bdev);
+	}
+
+	return chunk_size;
+}
+
+static struct stripe_request *
+raid5f_stripe_pool_alloc(struct raid5f_io_channel *r5ch, enum stripe_request_type type)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(r5ch);
+	uint64_t buf_size = raid5f_stripe_request_buf_size(r5f_info, type);
+	struct stripe_request *stripe_req;
+
+	stripe_req = raid5f_stripe_request_alloc(r5ch, type);
+	if (!stripe_req) {
+		return NULL;
+	}
+
+	raid5f_stripe_pool(r5ch, type)->size++;
+	r5ch->stripe_pool_bytes += buf_size;
+
+	__atomic_fetch_add(&r5f_info->stats.stripe_requests, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&r5f_info->stats.stripe_request_bytes, buf_size, __ATOMIC_RELAXED);
+
+	return stripe_req;
+}
+
+static void
+raid5f_stripe_pool_free(struct raid5f_io_channel *r5ch, struct stripe_request *stripe_req)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(r5ch);
+	uint64_t buf_size = raid5f_stripe_request_buf_size(r5f_info, stripe_req->type);
+
+	raid5f_stripe_pool(r5ch, stripe_req->type)->size--;
+	r5ch->stripe_pool_bytes -= buf_size;
+
+	__atomic_fetch_sub(&r5f_info->stats.stripe_requests, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_sub(&r5f_info->stats.stripe_request_bytes, buf_size, __ATOMIC_RELAXED);
+
+	raid5f_stripe_request_free(stripe_req);
+}
+
+static bool
+raid5f_stripe_pool_grow(struct raid5f_io_channel *r5ch, enum stripe_request_type type,
+			uint64_t max_bytes)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(r5ch);
+	struct raid5f_stripe_pool *pool = raid5f_stripe_pool(r5ch, type);
+	uint64_t buf_size = raid5f_stripe_request_buf_size(r5f_info, type);
+	struct stripe_request *stripe_req;
+	uint32_t low_watermark = pool->size / 4;
+	uint32_t target;
+	uint32_t grown = 0;
+
+	/*
+	 * A pool of which less than a quarter was left free since the last poll grows by half,
+	 * before the I/O runs out of it. Using half of the grown pool doesn't shrink it again.
+	 */
+	if (pool->size - pool->poll_peak >= low_watermark) {
+		return false;
+	}
+
+	target = spdk_min(pool->size + pool->size / 2, RAID5F_MAX_STRIPES);
+
+	while (pool->size < target) {
+		if (max_bytes != 0 && r5ch->stripe_pool_bytes + buf_size > max_bytes) {
+			break;
+		}
+
+		stripe_req = raid5f_stripe_pool_alloc(r5ch, type);
+		if (!stripe_req) {
+			break;
+		}
+
+		TAILQ_INSERT_HEAD(&pool->free, stripe_req, link);
+		grown++;
+	}
+
+	if (grown == 0) {
+		return false;
+	}
+
+	__atomic_fetch_add(&r5f_info->stats.grown, grown, __ATOMIC_RELAXED);
+
+	return true;
+}
+
+static bool
+raid5f_stripe_pool_shrink(struct raid5f_io_channel *r5ch, struct raid5f_stripe_pool *pool,
+			  uint64_t max_bytes, bool period_end)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(r5ch);
+	struct stripe_request *stripe_req;
+	uint32_t target = pool->size;
+	uint32_t shrunk = 0;
+
+	/*
+	 * A pool is halved only if less than half of it was used during a whole period. This
+	 * keeps a steady load from resizing it back and forth. Above the memory limit, it is
+	 * shrunk right away.
+	 */
+	if (period_end) {
+		if (pool->peak < pool->size / 2) {
+			target = spdk_max(pool->size / 2, RAID5F_MIN_STRIPES);
+		}
+		pool->peak = pool->in_use;
+	}
+
+	while (pool->size > RAID5F_MIN_STRIPES &&
+	       (pool->size > target || (max_bytes != 0 && r5ch->stripe_pool_bytes > max_bytes))) {
+		stripe_req = TAILQ_FIRST(&pool->free);
+		if (!stripe_req) {
+			break;
+		}
+
+		TAILQ_REMOVE(&pool->free, stripe_req, link);
+		raid5f_stripe_pool_free(r5ch, stripe_req);
+		shrunk++;
+	}
+
+	if (shrunk == 0) {
+		return false;
+	}
+
+	__atomic_fetch_add(&r5f_info->stats.shrunk, shrunk, __ATOMIC_RELAXED);
+
+	return true;
+}
+
+static int
+raid5f_stripe_pool_poller(void *ctx)
+{
+	struct raid5f_io_channel *r5ch = ctx;
+	struct spdk_raid_bdev_opts opts;
+	uint64_t max_bytes;
+	bool period_end;
+	bool resized;
+
+	raid_bdev_get_opts(&opts);
+	max_bytes = opts.raid5f_stripe_pool_max_kb * 1024ULL;
+
+	period_end = ++r5ch->stripe_pool_polls == RAID5F_STRIPE_POOL_SHRINK_POLLS;
+	if (period_end) {
+		r5ch->stripe_pool_polls = 0;
+	}
+
+	/* Write requests are grown first, they are needed by more I/O */
+	resized = raid5f_stripe_pool_grow(r5ch, STRIPE_REQ_WRITE, max_bytes);
+	resized |= raid5f_stripe_pool_grow(r5ch, STRIPE_REQ_RECONSTRUCT, max_bytes);
+	r5ch->write_pool.poll_peak = r5ch->write_pool.in_use;
+	r5ch->reconstruct_pool.poll_peak = r5ch->reconstruct_pool.in_use;
+
+	/* Reconstruct requests are shrunk first, they use more memory */
+	resized |= raid5f_stripe_pool_shrink(r5ch, &r5ch->reconstruct_pool, max_bytes, period_end);
+	resized |= raid5f_stripe_pool_shrink(r5ch, &r5ch->write_pool, max_bytes, period_end);
+
+	return resized ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static void
+raid5f_stripe_cache_entry_free(struct raid5f_stripe_cache_entry *entry, uint8_t num_chunks)
+{
+	uint8_t i;
+
+	if (entry->chunk_buffers) {
+		for (i = 0; i < num_chunks; i++) {
+			spdk_dma_free(entry->chunk_buffers[i]);
 		}
+		free(entry->chunk_buffers);
+	}
 
-		for (i = 0; i < n; i++) {
-			buf = spdk_dma_malloc(chunk_len, r5f_info->buf_alignment, NULL);
-			if (!buf) {
-				goto err;
-			}
-			stripe_req->reconstruct.chunk_buffers[i] = buf;
+	if (entry->chunk_md_buffers) {
+		for (i = 0; i < num_chunks; i++) {
+			spdk_dma_free(entry->chunk_md_buffers[i]);
 		}
+		free(entry->chunk_md_buffers);
+	}
 
-		if (raid_io_md_size != 0) {
-			stripe_req->reconstruct.chunk_md_buffers = calloc(n, sizeof(void *));
-			if (!stripe_req->reconstruct.chunk_md_buffers) {
-				goto err;
-			}
+	free(entry->valid);
+	free(entry);
+}
 
-			for (i = 0; i < n; i++) {
-				buf = spdk_dma_malloc(raid_bdev->strip_size * raid_io_md_size, r5f_info->buf_alignment, NULL);
-				if (!buf) {
-					goto err;
-				}
-				stripe_req->reconstruct.chunk_md_buffers[i] = buf;
-			}
-		}
-	} else {
-		assert(false);
+static struct raid5f_stripe_cache_entry *
+raid5f_stripe_cache_entry_alloc(struct raid5f_info *r5f_info)
+{
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	uint32_t raid_io_md_size = raid_bdev->bdev.md_interleave ? 0 : raid_bdev->bdev.md_len;
+	struct raid5f_stripe_cache_entry *entry;
+	uint8_t i;
+
+	entry = calloc(1, sizeof(*entry));
+	if (!entry) {
 		return NULL;
 	}
 
-	stripe_req->chunk_iov_iters = malloc(SPDK_IOVITER_SIZE(raid_bdev->num_base_bdevs));
-	if (!stripe_req->chunk_iov_iters) {
+	entry->stripe_index = UINT64_MAX;
+
+	entry->valid = calloc(raid_bdev->num_base_bdevs, sizeof(*entry->valid));
+	if (!entry->valid) {
 		goto err;
 	}
 
-	stripe_req->chunk_xor_buffers = calloc(raid5f_stripe_data_chunks_num(raid_bdev),
-					       sizeof(stripe_req->chunk_xor_buffers[0]));
-	if (!stripe_req->chunk_xor_buffers) {
+	entry->chunk_buffers = calloc(raid_bdev->num_base_bdevs, sizeof(void *));
+	if (!entry->chunk_buffers) {
 		goto err;
 	}
 
-	stripe_req->chunk_xor_md_buffers = calloc(raid5f_stripe_data_chunks_num(raid_bdev),
-					   sizeof(stripe_req->chunk_xor_md_buffers[0]));
-	if (!stripe_req->chunk_xor_md_buffers) {
-		goto err;
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		entry->chunk_buffers[i] = spdk_dma_malloc(raid_bdev->strip_size * raid_bdev->bdev.blocklen,
+					  r5f_info->buf_alignment, NULL);
+		if (!entry->chunk_buffers[i]) {
+			goto err;
+		}
 	}
 
-	return stripe_req;
+	if (raid_io_md_size != 0) {
+		entry->chunk_md_buffers = calloc(raid_bdev->num_base_bdevs, sizeof(void *));
+		if (!entry->chunk_md_buffers) {
+			goto err;
+		}
+
+		for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+			entry->chunk_md_buffers[i] = spdk_dma_malloc(raid_bdev->strip_size * raid_io_md_size,
+						     r5f_info->buf_alignment, NULL);
+			if (!entry->chunk_md_buffers[i]) {
+				goto err;
+			}
+		}
+	}
+
+	return entry;
 err:
-	raid5f_stripe_request_free(stripe_req);
+	raid5f_stripe_cache_entry_free(entry, raid_bdev->num_base_bdevs);
 	return NULL;
 }
 
@@ -978,20 +2221,36 @@ static void
 raid5f_ioch_destroy(void *io_device, void *ctx_buf)
 {
 	struct raid5f_io_channel *r5ch = ctx_buf;
+	struct raid5f_info *r5f_info = io_device;
+	struct raid5f_stripe_cache_entry *entry;
 	struct stripe_request *stripe_req;
 
 	assert(TAILQ_EMPTY(&r5ch->xor_retry_queue));
+	assert(r5ch->write_pool.in_use == 0);
+	assert(r5ch->reconstruct_pool.in_use == 0);
 
-	while ((stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.write))) {
-		TAILQ_REMOVE(&r5ch->free_stripe_requests.write, stripe_req, link);
-		raid5f_stripe_request_free(stripe_req);
+	spdk_poller_unregister(&r5ch->stripe_pool_poller);
+
+	while ((stripe_req = TAILQ_FIRST(&r5ch->write_pool.free))) {
+		TAILQ_REMOVE(&r5ch->write_pool.free, stripe_req, link);
+		raid5f_stripe_pool_free(r5ch, stripe_req);
+	}
+
+	while ((stripe_req = TAILQ_FIRST(&r5ch->reconstruct_pool.free))) {
+		TAILQ_REMOVE(&r5ch->reconstruct_pool.free, stripe_req, link);
+		raid5f_stripe_pool_free(r5ch, stripe_req);
 	}
 
-	while ((stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.reconstruct))) {
-		TAILQ_REMOVE(&r5ch->free_stripe_requests.reconstruct, stripe_req, link);
+	while ((stripe_req = TAILQ_FIRST(&r5ch->free_partial_write_requests))) {
+		TAILQ_REMOVE(&r5ch->free_partial_write_requests, stripe_req, link);
 		raid5f_stripe_request_free(stripe_req);
 	}
 
+	while ((entry = TAILQ_FIRST(&r5ch->stripe_cache))) {
+		TAILQ_REMOVE(&r5ch->stripe_cache, entry, link);
+		raid5f_stripe_cache_entry_free(entry, r5f_info->raid_bdev->num_base_bdevs);
+	}
+
 	if (r5ch->accel_ch) {
 		spdk_put_io_channel(r5ch->accel_ch);
 	}
@@ -1007,29 +2266,48 @@ raid5f_ioch_create(void *io_device, void *ctx_buf)
 	struct raid5f_io_channel *r5ch = ctx_buf;
 	struct raid5f_info *r5f_info = io_device;
 	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	struct raid5f_stripe_cache_entry *entry;
 	struct stripe_request *stripe_req;
 	int i;
 
-	TAILQ_INIT(&r5ch->free_stripe_requests.write);
-	TAILQ_INIT(&r5ch->free_stripe_requests.reconstruct);
+	TAILQ_INIT(&r5ch->write_pool.free);
+	TAILQ_INIT(&r5ch->reconstruct_pool.free);
+	TAILQ_INIT(&r5ch->free_partial_write_requests);
+	TAILQ_INIT(&r5ch->stripe_cache);
 	TAILQ_INIT(&r5ch->xor_retry_queue);
 
-	for (i = 0; i < RAID5F_MAX_STRIPES; i++) {
-		stripe_req = raid5f_stripe_request_alloc(r5ch, STRIPE_REQ_WRITE);
+	for (i = 0; i < RAID5F_MIN_STRIPES; i++) {
+		stripe_req = raid5f_stripe_pool_alloc(r5ch, STRIPE_REQ_WRITE);
+		if (!stripe_req) {
+			goto err;
+		}
+
+		TAILQ_INSERT_HEAD(&r5ch->write_pool.free, stripe_req, link);
+	}
+
+	for (i = 0; i < RAID5F_MIN_STRIPES; i++) {
+		stripe_req = raid5f_stripe_pool_alloc(r5ch, STRIPE_REQ_RECONSTRUCT);
 		if (!stripe_req) {
 			goto err;
 		}
 
-		TAILQ_INSERT_HEAD(&r5ch->free_stripe_requests.write, stripe_req, link);
+		TAILQ_INSERT_HEAD(&r5ch->reconstruct_pool.free, stripe_req, link);
 	}
 
-	for (i = 0; i < RAID5F_MAX_STRIPES; i++) {
-		stripe_req = raid5f_stripe_request_alloc(r5ch, STRIPE_REQ_RECONSTRUCT);
+	for (i = 0; i < RAID5F_STRIPE_CACHE_SIZE; i++) {
+		stripe_req = raid5f_stripe_request_alloc(r5ch, STRIPE_REQ_PARTIAL_WRITE);
 		if (!stripe_req) {
 			goto err;
 		}
 
-		TAILQ_INSERT_HEAD(&r5ch->free_stripe_requests.reconstruct, stripe_req, link);
+		TAILQ_INSERT_HEAD(&r5ch->free_partial_write_requests, stripe_req, link);
+
+		entry = raid5f_stripe_cache_entry_alloc(r5f_info);
+		if (!entry) {
+			goto err;
+		}
+
+		TAILQ_INSERT_TAIL(&r5ch->stripe_cache, entry, link);
 	}
 
 	r5ch->accel_ch = spdk_accel_get_io_channel();
@@ -1053,6 +2331,12 @@ raid5f_ioch_create(void *io_device, void *ctx_buf)
 		goto err;
 	}
 
+	r5ch->stripe_pool_poller = SPDK_POLLER_REGISTER(raid5f_stripe_pool_poller, r5ch,
+				   RAID5F_STRIPE_POOL_POLL_PERIOD_US);
+	if (!r5ch->stripe_pool_poller) {
+		goto err;
+	}
+
 	return 0;
 err:
 	SPDK_ERRLOG("Failed to initialize io channel\n");
@@ -1069,6 +2353,7 @@ raid5f_start(struct raid_bdev *raid_bdev)
 	struct spdk_bdev *base_bdev;
 	struct raid5f_info *r5f_info;
 	size_t alignment = 0;
+	int i;
 
 	r5f_info = calloc(1, sizeof(*r5f_info));
 	if (!r5f_info) {
@@ -1077,6 +2362,11 @@ raid5f_start(struct raid_bdev *raid_bdev)
 	}
 	r5f_info->raid_bdev = raid_bdev;
 
+	for (i = 0; i < RAID5F_STRIPE_LOCK_BUCKETS; i++) {
+		spdk_spin_init(&r5f_info->stripe_locks[i].lock);
+		TAILQ_INIT(&r5f_info->stripe_locks[i].holders);
+	}
+
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
 		min_blockcnt = spdk_min(min_blockcnt, base_info->data_size);
 		if (base_info->desc) {
@@ -1103,6 +2393,7 @@ raid5f_start(struct raid_bdev *raid_bdev)
 	raid_bdev->bdev.split_on_optimal_io_boundary = true;
 	raid_bdev->bdev.write_unit_size = r5f_info->stripe_blocks;
 	raid_bdev->bdev.split_on_write_unit = true;
+	raid_bdev->bdev.allow_partial_write_unit = true;
 
 	raid_bdev->module_private = r5f_info;
 
@@ -1116,9 +2407,15 @@ static void
 raid5f_io_device_unregister_done(void *io_device)
 {
 	struct raid5f_info *r5f_info = io_device;
+	int i;
 
 	raid_bdev_module_stop_done(r5f_info->raid_bdev);
 
+	for (i = 0; i < RAID5F_STRIPE_LOCK_BUCKETS; i++) {
+		assert(TAILQ_EMPTY(&r5f_info->stripe_locks[i].holders));
+		spdk_spin_destroy(&r5f_info->stripe_locks[i].lock);
+	}
+
 	free(r5f_info);
 }
 
@@ -1140,6 +2437,28 @@ raid5f_get_io_channel(struct raid_bdev *raid_bdev)
 	return spdk_get_io_channel(r5f_info);
 }
 
+static void
+raid5f_dump_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ctx *w)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+
+	spdk_json_write_named_object_begin(w, "stripe_requests");
+	spdk_json_write_named_uint64(w, "allocated",
+				     __atomic_load_n(&r5f_info->stats.stripe_requests, __ATOMIC_RELAXED));
+	spdk_json_write_named_uint64(w, "memory_kb",
+				     __atomic_load_n(&r5f_info->stats.stripe_request_bytes,
+						     __ATOMIC_RELAXED) / 1024);
+	spdk_json_write_named_uint64(w, "grown",
+				     __atomic_load_n(&r5f_info->stats.grown, __ATOMIC_RELAXED));
+	spdk_json_write_named_uint64(w, "shrunk",
+				     __atomic_load_n(&r5f_info->stats.shrunk, __ATOMIC_RELAXED));
+	spdk_json_write_named_uint64(w, "starved",
+				     __atomic_load_n(&r5f_info->stats.starved, __ATOMIC_RELAXED));
+	spdk_json_write_named_uint64(w, "chunk_submit_retries",
+				     __atomic_load_n(&r5f_info->stats.chunk_submit_retries, __ATOMIC_RELAXED));
+	spdk_json_write_object_end(w);
+}
+
 static void
 raid5f_process_write_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
@@ -1235,6 +2554,280 @@ raid5f_submit_process_request(struct raid_bdev_process_request *process_req,
 	}
 }
 
+/*
+ * Scrub reconstructs the parity of a stripe from its data chunks and compares it to the parity
+ * chunk, which is rewritten if it doesn't match or can't be read. If a data chunk can't be
+ * read, the data chunks are read one by one to find it and it is reconstructed from the other
+ * chunks and the parity. raid_io->base_bdev_io_submitted is the index of the chunk that is
+ * read or written.
+ */
+static void raid5f_scrub_read_chunk(void *_raid_io);
+static void raid5f_scrub_write_chunk(void *_raid_io);
+
+static inline uint64_t
+raid5f_scrub_stripe_index(struct raid_bdev_process_request *process_req)
+{
+	struct raid5f_info *r5f_info = process_req->raid_io.raid_bdev->module_private;
+
+	return process_req->offset_blocks / r5f_info->stripe_blocks;
+}
+
+static bool
+raid5f_scrub_parity_matches(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev *raid_bdev = process_req->raid_io.raid_bdev;
+
+	if (memcmp(process_req->iov.iov_base, process_req->scrub.iov.iov_base,
+		   raid_bdev->strip_size * raid_bdev->bdev.blocklen) != 0) {
+		return false;
+	}
+
+	return process_req->md_buf == NULL ||
+	       memcmp(process_req->md_buf, process_req->scrub.md_buf,
+		      raid_bdev->strip_size * raid_bdev->bdev.md_len) == 0;
+}
+
+static void
+raid5f_scrub_reconstruct(struct raid_bdev_process_request *process_req, uint8_t chunk_idx,
+			 stripe_req_xor_cb cb)
+{
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	int ret;
+
+	/* Reset the raid_io, it may still have the status of the previous reconstruction */
+	raid_bdev_io_init(raid_io, raid_io->raid_ch, SPDK_BDEV_IO_TYPE_READ,
+			  process_req->offset_blocks, raid_io->raid_bdev->strip_size,
+			  &process_req->iov, 1, process_req->md_buf, NULL, NULL);
+
+	ret = raid5f_submit_reconstruct_read(raid_io, raid5f_scrub_stripe_index(process_req),
+					     chunk_idx, 0, cb);
+	if (spdk_unlikely(ret != 0)) {
+		raid_bdev_process_request_complete(process_req, ret);
+	}
+}
+
+static void
+raid5f_scrub_find_data_chunk(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev,
+			raid5f_scrub_stripe_index(process_req));
+
+	if (raid_io->base_bdev_io_submitted == p_idx) {
+		raid_io->base_bdev_io_submitted++;
+	}
+
+	if (raid_io->base_bdev_io_submitted == raid_bdev->num_base_bdevs) {
+		/* The read error didn't occur again */
+		process_req->scrub.read_error_blocks += raid_bdev->strip_size;
+		raid_bdev_process_request_complete(process_req, 0);
+		return;
+	}
+
+	raid5f_scrub_read_chunk(raid_io);
+}
+
+static void
+raid5f_scrub_data_reconstructed(struct stripe_request *stripe_req, int status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+	uint8_t chunk_idx = stripe_req->reconstruct.chunk->index;
+
+	raid5f_stripe_request_release(stripe_req);
+
+	if (status != 0) {
+		/* Another chunk of the stripe can't be read either */
+		raid_bdev_process_request_complete(process_req, 0);
+		return;
+	}
+
+	raid_io->base_bdev_io_submitted = chunk_idx;
+	raid5f_scrub_write_chunk(raid_io);
+}
+
+static void
+raid5f_scrub_parity_reconstructed(struct stripe_request *stripe_req, int status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+	uint8_t p_idx = stripe_req->reconstruct.chunk->index;
+	bool parity_readable = process_req->scrub.read_error_blocks == 0;
+
+	raid5f_stripe_request_release(stripe_req);
+
+	if (status != 0) {
+		if (parity_readable) {
+			raid_io->base_bdev_io_submitted = 0;
+			raid5f_scrub_find_data_chunk(process_req);
+		} else {
+			raid_bdev_process_request_complete(process_req, 0);
+		}
+		return;
+	}
+
+	if (parity_readable) {
+		if (raid5f_scrub_parity_matches(process_req)) {
+			raid_bdev_process_request_complete(process_req, 0);
+			return;
+		}
+		process_req->scrub.mismatched_blocks += raid_io->raid_bdev->strip_size;
+	}
+
+	if (!process_req->scrub.repair) {
+		raid_bdev_process_request_complete(process_req, 0);
+		return;
+	}
+
+	raid_io->base_bdev_io_submitted = p_idx;
+	raid5f_scrub_write_chunk(raid_io);
+}
+
+static void
+raid5f_scrub_read_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint8_t chunk_idx = raid_io->base_bdev_io_submitted;
+	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev,
+			raid5f_scrub_stripe_index(process_req));
+	bool parity_readable = process_req->scrub.read_error_blocks == 0;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		process_req->scrub.read_error_blocks += raid_bdev->strip_size;
+	}
+
+	if (chunk_idx == p_idx) {
+		raid5f_scrub_reconstruct(process_req, p_idx, raid5f_scrub_parity_reconstructed);
+	} else if (success) {
+		raid_io->base_bdev_io_submitted++;
+		raid5f_scrub_find_data_chunk(process_req);
+	} else if (parity_readable && process_req->scrub.repair) {
+		raid5f_scrub_reconstruct(process_req, chunk_idx, raid5f_scrub_data_reconstructed);
+	} else {
+		raid_bdev_process_request_complete(process_req, 0);
+	}
+}
+
+static void
+raid5f_scrub_read_chunk(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint8_t chunk_idx = raid_io->base_bdev_io_submitted;
+	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[chunk_idx];
+	struct spdk_io_channel *base_ch;
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, chunk_idx);
+
+	raid5f_init_ext_io_opts(&io_opts, raid_io);
+	io_opts.metadata = process_req->scrub.md_buf;
+
+	ret = raid_bdev_readv_blocks_ext(base_info, base_ch, &process_req->scrub.iov, 1,
+					 raid5f_scrub_stripe_index(process_req) << raid_bdev->strip_size_shift,
+					 raid_bdev->strip_size, raid5f_scrub_read_completed, process_req,
+					 &io_opts);
+	if (spdk_unlikely(ret != 0)) {
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+						base_ch, raid5f_scrub_read_chunk);
+		} else {
+			raid_bdev_process_request_complete(process_req, ret);
+		}
+	}
+}
+
+static void
+raid5f_scrub_write_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	/* Even a failed write may have changed the chunk */
+	raid5f_stripe_cache_invalidate(process_req->raid_io.raid_bdev->module_private,
+				       raid5f_scrub_stripe_index(process_req));
+
+	if (success) {
+		process_req->scrub.repaired_blocks += process_req->raid_io.raid_bdev->strip_size;
+	}
+
+	raid_bdev_process_request_complete(process_req, success ? 0 : -EIO);
+}
+
+static void
+raid5f_scrub_write_chunk(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint8_t chunk_idx = raid_io->base_bdev_io_submitted;
+	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[chunk_idx];
+	struct spdk_io_channel *base_ch;
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, chunk_idx);
+
+	raid5f_init_ext_io_opts(&io_opts, raid_io);
+	io_opts.metadata = process_req->md_buf;
+
+	ret = raid_bdev_writev_blocks_ext(base_info, base_ch, &process_req->iov, 1,
+					  raid5f_scrub_stripe_index(process_req) << raid_bdev->strip_size_shift,
+					  raid_bdev->strip_size, raid5f_scrub_write_completed, process_req,
+					  &io_opts);
+	if (spdk_unlikely(ret != 0)) {
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+						base_ch, raid5f_scrub_write_chunk);
+		} else {
+			raid_bdev_process_request_complete(process_req, ret);
+		}
+	}
+}
+
+static int
+raid5f_submit_scrub_request(struct raid_bdev_process_request *process_req,
+			    struct raid_bdev_io_channel *raid_ch)
+{
+	struct spdk_io_channel *ch = spdk_io_channel_from_ctx(raid_ch);
+	struct raid_bdev *raid_bdev = spdk_io_channel_get_io_device(ch);
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	uint64_t stripe_index = process_req->offset_blocks / r5f_info->stripe_blocks;
+
+	assert((process_req->offset_blocks % r5f_info->stripe_blocks) == 0);
+
+	if (process_req->num_blocks < r5f_info->stripe_blocks) {
+		return 0;
+	}
+
+	/* One strip of each buffer is used, for the reconstructed and the read parity */
+	process_req->iov.iov_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	process_req->scrub.iov.iov_len = process_req->iov.iov_len;
+
+	raid_bdev_io_init(raid_io, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+			  process_req->offset_blocks, raid_bdev->strip_size,
+			  &process_req->iov, 1, process_req->md_buf, NULL, NULL);
+	raid_io->base_bdev_io_submitted = raid5f_stripe_parity_chunk_index(raid_bdev, stripe_index);
+
+	/* The process request must not complete before this function returns */
+	spdk_thread_send_msg(spdk_get_thread(), raid5f_scrub_read_chunk, raid_io);
+
+	return r5f_info->stripe_blocks;
+}
+
 static struct raid_bdev_module g_raid5f_module = {
 	.level = RAID5F,
 	.base_bdevs_min = 3,
@@ -1244,6 +2837,8 @@ static struct raid_bdev_module g_raid5f_module = {
 	.submit_rw_request = raid5f_submit_rw_request,
 	.get_io_channel = raid5f_get_io_channel,
 	.submit_process_request = raid5f_submit_process_request,
+	.submit_scrub_request = raid5f_submit_scrub_request,
+	.dump_info_json = raid5f_dump_info_json,
 };
 RAID_MODULE_REGISTER(&g_raid5f_module)
 
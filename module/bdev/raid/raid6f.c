@@ -0,0 +1,1430 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "bdev_raid.h"
+
+#include "spdk/env.h"
+#include "spdk/thread.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+#include "spdk/likely.h"
+#include "spdk/log.h"
+#include "spdk/accel.h"
+#include "spdk/xor.h"
+
+/* Maximum concurrent full stripe writes per io channel */
+#define RAID6F_MAX_STRIPES 32
+
+/* Number of parity chunks in a stripe */
+#define RAID6F_PARITY_CHUNKS 2
+
+struct chunk {
+	/* Corresponds to base_bdev index */
+	uint8_t index;
+
+	/* Set if the chunk is read by a reconstruct request */
+	bool read;
+
+	/* Array of iovecs */
+	struct iovec *iovs;
+
+	/* Number of used iovecs */
+	int iovcnt;
+
+	/* Total number of available iovecs in the array */
+	int iovcnt_max;
+
+	/* Pointer to buffer with I/O metadata */
+	void *md_buf;
+};
+
+struct stripe_request;
+typedef void (*stripe_req_pq_cb)(struct stripe_request *stripe_req, int status);
+
+struct stripe_request {
+	enum stripe_request_type {
+		STRIPE_REQ_WRITE,
+		STRIPE_REQ_RECONSTRUCT,
+	} type;
+
+	struct raid6f_io_channel *r6ch;
+
+	/* The associated raid_bdev_io */
+	struct raid_bdev_io *raid_io;
+
+	/* The stripe's index in the raid array. */
+	uint64_t stripe_index;
+
+	/* The stripe's P (xor) parity chunk */
+	struct chunk *p_chunk;
+
+	/* The stripe's Q (Reed-Solomon syndrome) parity chunk */
+	struct chunk *q_chunk;
+
+	union {
+		struct {
+			/* Buffers for stripe parity */
+			void *p_buf;
+			void *q_buf;
+
+			/* Buffers for stripe io metadata parity */
+			void *p_md_buf;
+			void *q_md_buf;
+		} write;
+
+		struct {
+			/* Array of buffers for reading chunk data */
+			void **chunk_buffers;
+
+			/* Array of buffers for reading chunk metadata */
+			void **chunk_md_buffers;
+
+			/* Chunk to reconstruct */
+			struct chunk *chunk;
+
+			/* Offset from chunk start */
+			uint64_t chunk_offset;
+
+			/* Indexes of the missing data chunks among the stripe's data chunks */
+			uint32_t missing[RAID6F_PARITY_CHUNKS];
+
+			/* Number of missing data chunks */
+			uint32_t nmissing;
+		} reconstruct;
+	};
+
+	/* Array of iovec iterators for each chunk */
+	struct spdk_ioviter *chunk_iov_iters;
+
+	/* Array of source buffer pointers for parity calculation */
+	void **chunk_pq_buffers;
+
+	/* Array of source buffer pointers for parity calculation of io metadata */
+	void **chunk_pq_md_buffers;
+
+	struct {
+		size_t len;
+		size_t remaining;
+		size_t remaining_md;
+		int status;
+		stripe_req_pq_cb cb;
+	} pq;
+
+	TAILQ_ENTRY(stripe_request) link;
+
+	/* Array of chunks corresponding to base_bdevs */
+	struct chunk chunks[0];
+};
+
+struct raid6f_info {
+	/* The parent raid bdev */
+	struct raid_bdev *raid_bdev;
+
+	/* Number of data blocks in a stripe (without parity) */
+	uint64_t stripe_blocks;
+
+	/* Number of stripes on this array */
+	uint64_t total_stripes;
+
+	/* Alignment for buffer allocation */
+	size_t buf_alignment;
+
+	/* block length bit shift for optimized calculation, only valid when no interleaved md */
+	uint32_t blocklen_shift;
+};
+
+struct raid6f_io_channel {
+	/* All available stripe requests on this channel */
+	struct {
+		TAILQ_HEAD(, stripe_request) write;
+		TAILQ_HEAD(, stripe_request) reconstruct;
+	} free_stripe_requests;
+
+	/* accel_fw channel */
+	struct spdk_io_channel *accel_ch;
+
+	/* For retrying parity calculation if accel_ch runs out of resources */
+	TAILQ_HEAD(, stripe_request) pq_retry_queue;
+
+	/* For iterating over chunk iovecs during parity calculation */
+	void **chunk_pq_buffers;
+	struct iovec **chunk_pq_iovs;
+	size_t *chunk_pq_iovcnt;
+};
+
+#define __CHUNK_IN_RANGE(req, c) \
+	c < req->chunks + raid6f_ch_to_r6f_info(req->r6ch)->raid_bdev->num_base_bdevs
+
+#define FOR_EACH_CHUNK_FROM(req, c, from) \
+	for (c = from; __CHUNK_IN_RANGE(req, c); c++)
+
+#define FOR_EACH_CHUNK(req, c) \
+	FOR_EACH_CHUNK_FROM(req, c, req->chunks)
+
+#define FOR_EACH_DATA_CHUNK(req, c) \
+	for (c = raid6f_next_data_chunk(req, req->chunks); __CHUNK_IN_RANGE(req, c); \
+	     c = raid6f_next_data_chunk(req, c+1))
+
+static inline struct raid6f_info *
+raid6f_ch_to_r6f_info(struct raid6f_io_channel *r6ch)
+{
+	return spdk_io_channel_get_io_device(spdk_io_channel_from_ctx(r6ch));
+}
+
+static inline struct chunk *
+raid6f_next_data_chunk(struct stripe_request *stripe_req, struct chunk *chunk)
+{
+	while (__CHUNK_IN_RANGE(stripe_req, chunk) &&
+	       (chunk == stripe_req->p_chunk || chunk == stripe_req->q_chunk)) {
+		chunk++;
+	}
+
+	return chunk;
+}
+
+static inline struct stripe_request *
+raid6f_chunk_stripe_req(struct chunk *chunk)
+{
+	return SPDK_CONTAINEROF((chunk - chunk->index), struct stripe_request, chunks);
+}
+
+static inline uint8_t
+raid6f_stripe_data_chunks_num(const struct raid_bdev *raid_bdev)
+{
+	return raid_bdev->num_base_bdevs - RAID6F_PARITY_CHUNKS;
+}
+
+static inline uint8_t
+raid6f_stripe_p_chunk_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index)
+{
+	return raid_bdev->num_base_bdevs - 1 - stripe_index % raid_bdev->num_base_bdevs;
+}
+
+static inline uint8_t
+raid6f_stripe_q_chunk_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index)
+{
+	return (raid6f_stripe_p_chunk_index(raid_bdev, stripe_index) + 1) % raid_bdev->num_base_bdevs;
+}
+
+/* Data chunks occupy the remaining base bdevs in order, skipping over P and Q */
+static inline uint8_t
+raid6f_stripe_data_chunk_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index,
+			       uint8_t data_idx)
+{
+	uint8_t p_idx = raid6f_stripe_p_chunk_index(raid_bdev, stripe_index);
+	uint8_t q_idx = raid6f_stripe_q_chunk_index(raid_bdev, stripe_index);
+	uint8_t chunk_idx = data_idx;
+
+	if (chunk_idx >= spdk_min(p_idx, q_idx)) {
+		chunk_idx++;
+	}
+	if (chunk_idx >= spdk_max(p_idx, q_idx)) {
+		chunk_idx++;
+	}
+
+	return chunk_idx;
+}
+
+static inline void
+raid6f_stripe_request_release(struct stripe_request *stripe_req)
+{
+	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
+		TAILQ_INSERT_HEAD(&stripe_req->r6ch->free_stripe_requests.write, stripe_req, link);
+	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+		TAILQ_INSERT_HEAD(&stripe_req->r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+	} else {
+		assert(false);
+	}
+}
+
+static void raid6f_pq_stripe_retry(struct stripe_request *stripe_req);
+
+static void
+raid6f_pq_stripe_done(struct stripe_request *stripe_req)
+{
+	struct raid6f_io_channel *r6ch = stripe_req->r6ch;
+
+	if (stripe_req->pq.status != 0) {
+		SPDK_ERRLOG("stripe parity calculation failed: %s\n",
+			    spdk_strerror(-stripe_req->pq.status));
+	}
+
+	stripe_req->pq.cb(stripe_req, stripe_req->pq.status);
+
+	if (!TAILQ_EMPTY(&r6ch->pq_retry_queue)) {
+		stripe_req = TAILQ_FIRST(&r6ch->pq_retry_queue);
+		TAILQ_REMOVE(&r6ch->pq_retry_queue, stripe_req, link);
+		raid6f_pq_stripe_retry(stripe_req);
+	}
+}
+
+static void raid6f_pq_stripe_continue(struct stripe_request *stripe_req);
+
+static void
+_raid6f_pq_stripe_cb(struct stripe_request *stripe_req, int status)
+{
+	if (status != 0) {
+		stripe_req->pq.status = status;
+	}
+
+	if (stripe_req->pq.remaining + stripe_req->pq.remaining_md == 0) {
+		raid6f_pq_stripe_done(stripe_req);
+	}
+}
+
+static void
+raid6f_pq_stripe_cb(void *_stripe_req, int status)
+{
+	struct stripe_request *stripe_req = _stripe_req;
+
+	stripe_req->pq.remaining -= stripe_req->pq.len;
+
+	if (stripe_req->pq.remaining > 0) {
+		stripe_req->pq.len = spdk_ioviter_nextv(stripe_req->chunk_iov_iters,
+							stripe_req->r6ch->chunk_pq_buffers);
+		raid6f_pq_stripe_continue(stripe_req);
+	}
+
+	_raid6f_pq_stripe_cb(stripe_req, status);
+}
+
+static void
+raid6f_pq_stripe_md_cb(void *_stripe_req, int status)
+{
+	struct stripe_request *stripe_req = _stripe_req;
+
+	stripe_req->pq.remaining_md = 0;
+
+	_raid6f_pq_stripe_cb(stripe_req, status);
+}
+
+static void
+raid6f_pq_stripe_continue(struct stripe_request *stripe_req)
+{
+	struct raid6f_io_channel *r6ch = stripe_req->r6ch;
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint8_t n_src = raid6f_stripe_data_chunks_num(raid_bdev);
+	uint8_t i;
+	int ret;
+
+	assert(stripe_req->pq.len > 0);
+
+	stripe_req->pq.len = spdk_min(stripe_req->pq.len, stripe_req->pq.remaining);
+
+	for (i = 0; i < n_src; i++) {
+		stripe_req->chunk_pq_buffers[i] = r6ch->chunk_pq_buffers[i];
+	}
+
+	ret = spdk_accel_submit_pq_gen(r6ch->accel_ch, r6ch->chunk_pq_buffers[n_src],
+				       r6ch->chunk_pq_buffers[n_src + 1], stripe_req->chunk_pq_buffers,
+				       n_src, stripe_req->pq.len, raid6f_pq_stripe_cb, stripe_req);
+	if (spdk_unlikely(ret)) {
+		if (ret == -ENOMEM) {
+			TAILQ_INSERT_HEAD(&r6ch->pq_retry_queue, stripe_req, link);
+		} else {
+			stripe_req->pq.status = ret;
+			raid6f_pq_stripe_done(stripe_req);
+		}
+	}
+}
+
+/* Point the channel's iteration arrays at the data chunks followed by P and Q */
+static void
+raid6f_stripe_request_iovs_prep(struct stripe_request *stripe_req)
+{
+	struct raid6f_io_channel *r6ch = stripe_req->r6ch;
+	struct chunk *chunk;
+	uint8_t c = 0;
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		r6ch->chunk_pq_iovs[c] = chunk->iovs;
+		r6ch->chunk_pq_iovcnt[c] = chunk->iovcnt;
+		c++;
+	}
+	r6ch->chunk_pq_iovs[c] = stripe_req->p_chunk->iovs;
+	r6ch->chunk_pq_iovcnt[c] = stripe_req->p_chunk->iovcnt;
+	c++;
+	r6ch->chunk_pq_iovs[c] = stripe_req->q_chunk->iovs;
+	r6ch->chunk_pq_iovcnt[c] = stripe_req->q_chunk->iovcnt;
+}
+
+/* Calculate the P and Q chunks from the data chunks */
+static void
+raid6f_pq_stripe(struct stripe_request *stripe_req, stripe_req_pq_cb cb)
+{
+	struct raid6f_io_channel *r6ch = stripe_req->r6ch;
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct chunk *chunk;
+	uint64_t num_blocks = 0;
+	uint8_t c;
+
+	assert(cb != NULL);
+
+	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
+		num_blocks = raid_bdev->strip_size;
+	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+		num_blocks = raid_io->num_blocks;
+	} else {
+		assert(false);
+	}
+
+	raid6f_stripe_request_iovs_prep(stripe_req);
+
+	stripe_req->pq.len = spdk_ioviter_firstv(stripe_req->chunk_iov_iters,
+			     raid_bdev->num_base_bdevs,
+			     r6ch->chunk_pq_iovs,
+			     r6ch->chunk_pq_iovcnt,
+			     r6ch->chunk_pq_buffers);
+	stripe_req->pq.remaining = num_blocks * raid_bdev->bdev.blocklen;
+	stripe_req->pq.status = 0;
+	stripe_req->pq.cb = cb;
+
+	if (raid_io->md_buf != NULL) {
+		uint8_t n_src = raid6f_stripe_data_chunks_num(raid_bdev);
+		uint64_t len = num_blocks * raid_bdev->bdev.md_len;
+		int ret;
+
+		stripe_req->pq.remaining_md = len;
+
+		c = 0;
+		FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+			stripe_req->chunk_pq_md_buffers[c] = chunk->md_buf;
+			c++;
+		}
+
+		ret = spdk_accel_submit_pq_gen(r6ch->accel_ch, stripe_req->p_chunk->md_buf,
+					       stripe_req->q_chunk->md_buf,
+					       stripe_req->chunk_pq_md_buffers, n_src, len,
+					       raid6f_pq_stripe_md_cb, stripe_req);
+		if (spdk_unlikely(ret)) {
+			if (ret == -ENOMEM) {
+				TAILQ_INSERT_HEAD(&r6ch->pq_retry_queue, stripe_req, link);
+			} else {
+				stripe_req->pq.status = ret;
+				raid6f_pq_stripe_done(stripe_req);
+			}
+			return;
+		}
+	}
+
+	raid6f_pq_stripe_continue(stripe_req);
+}
+
+static void
+raid6f_pq_stripe_retry(struct stripe_request *stripe_req)
+{
+	if (stripe_req->pq.remaining_md) {
+		raid6f_pq_stripe(stripe_req, stripe_req->pq.cb);
+	} else {
+		raid6f_pq_stripe_continue(stripe_req);
+	}
+}
+
+/*
+ * Reconstruct the missing data chunks of a reconstruct request from the chunks that were read.
+ * This is only needed on degraded arrays, so it is done in place by the CPU instead of going
+ * through accel.
+ */
+static int
+raid6f_rec_stripe(struct stripe_request *stripe_req)
+{
+	struct raid6f_io_channel *r6ch = stripe_req->r6ch;
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint8_t n_src = raid6f_stripe_data_chunks_num(raid_bdev);
+	bool p_read = stripe_req->p_chunk->read;
+	bool q_read = stripe_req->q_chunk->read;
+	struct chunk *chunk;
+	size_t len, remaining;
+	uint8_t c;
+	int ret;
+
+	raid6f_stripe_request_iovs_prep(stripe_req);
+
+	remaining = raid_io->num_blocks * raid_bdev->bdev.blocklen;
+	len = spdk_ioviter_firstv(stripe_req->chunk_iov_iters, raid_bdev->num_base_bdevs,
+				  r6ch->chunk_pq_iovs, r6ch->chunk_pq_iovcnt, r6ch->chunk_pq_buffers);
+	while (len > 0 && remaining > 0) {
+		len = spdk_min(len, remaining);
+		ret = spdk_xor_rec_pq(p_read ? r6ch->chunk_pq_buffers[n_src] : NULL,
+				      q_read ? r6ch->chunk_pq_buffers[n_src + 1] : NULL,
+				      r6ch->chunk_pq_buffers, n_src, stripe_req->reconstruct.missing,
+				      stripe_req->reconstruct.nmissing, len);
+		if (spdk_unlikely(ret)) {
+			return ret;
+		}
+		remaining -= len;
+		len = spdk_ioviter_nextv(stripe_req->chunk_iov_iters, r6ch->chunk_pq_buffers);
+	}
+
+	if (raid_io->md_buf != NULL) {
+		c = 0;
+		FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+			stripe_req->chunk_pq_md_buffers[c] = chunk->md_buf;
+			c++;
+		}
+
+		ret = spdk_xor_rec_pq(p_read ? stripe_req->p_chunk->md_buf : NULL,
+				      q_read ? stripe_req->q_chunk->md_buf : NULL,
+				      stripe_req->chunk_pq_md_buffers, n_src,
+				      stripe_req->reconstruct.missing, stripe_req->reconstruct.nmissing,
+				      raid_io->num_blocks * raid_bdev->bdev.md_len);
+		if (spdk_unlikely(ret)) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static void
+raid6f_stripe_request_chunk_write_complete(struct stripe_request *stripe_req,
+		enum spdk_bdev_io_status status)
+{
+	if (raid_bdev_io_complete_part(stripe_req->raid_io, 1, status)) {
+		raid6f_stripe_request_release(stripe_req);
+	}
+}
+
+static void
+raid6f_stripe_request_chunk_read_complete(struct stripe_request *stripe_req,
+		enum spdk_bdev_io_status status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	raid_bdev_io_complete_part(raid_io, 1, status);
+}
+
+static void
+raid6f_chunk_complete_bdev_io(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct chunk *chunk = cb_arg;
+	struct stripe_request *stripe_req = raid6f_chunk_stripe_req(chunk);
+	enum spdk_bdev_io_status status = success ? SPDK_BDEV_IO_STATUS_SUCCESS :
+					  SPDK_BDEV_IO_STATUS_FAILED;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
+		raid6f_stripe_request_chunk_write_complete(stripe_req, status);
+	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+		raid6f_stripe_request_chunk_read_complete(stripe_req, status);
+	} else {
+		assert(false);
+	}
+}
+
+static void raid6f_stripe_request_submit_chunks(struct stripe_request *stripe_req);
+
+static void
+raid6f_chunk_submit_retry(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+	struct stripe_request *stripe_req = raid_io->module_private;
+
+	raid6f_stripe_request_submit_chunks(stripe_req);
+}
+
+static inline void
+raid6f_init_ext_io_opts(struct spdk_bdev_ext_io_opts *opts, struct raid_bdev_io *raid_io)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->size = sizeof(*opts);
+	opts->memory_domain = raid_io->memory_domain;
+	opts->memory_domain_ctx = raid_io->memory_domain_ctx;
+	opts->metadata = raid_io->md_buf;
+}
+
+static int
+raid6f_chunk_submit(struct chunk *chunk)
+{
+	struct stripe_request *stripe_req = raid6f_chunk_stripe_req(chunk);
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[chunk->index];
+	struct spdk_io_channel *base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch,
+					  chunk->index);
+	uint64_t base_offset_blocks = (stripe_req->stripe_index << raid_bdev->strip_size_shift);
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	raid6f_init_ext_io_opts(&io_opts, raid_io);
+	io_opts.metadata = chunk->md_buf;
+
+	raid_io->base_bdev_io_submitted++;
+
+	switch (stripe_req->type) {
+	case STRIPE_REQ_WRITE:
+		if (base_ch == NULL) {
+			raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+			return 0;
+		}
+
+		ret = raid_bdev_writev_blocks_ext(base_info, base_ch, chunk->iovs, chunk->iovcnt,
+						  base_offset_blocks, raid_bdev->strip_size,
+						  raid6f_chunk_complete_bdev_io, chunk, &io_opts);
+		break;
+	case STRIPE_REQ_RECONSTRUCT:
+		if (!chunk->read) {
+			raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+			return 0;
+		}
+
+		base_offset_blocks += stripe_req->reconstruct.chunk_offset;
+
+		ret = raid_bdev_readv_blocks_ext(base_info, base_ch, chunk->iovs, chunk->iovcnt,
+						 base_offset_blocks, raid_io->num_blocks,
+						 raid6f_chunk_complete_bdev_io, chunk, &io_opts);
+		break;
+	default:
+		assert(false);
+		ret = -EINVAL;
+		break;
+	}
+
+	if (spdk_unlikely(ret)) {
+		raid_io->base_bdev_io_submitted--;
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+						base_ch, raid6f_chunk_submit_retry);
+		} else {
+			/*
+			 * Implicitly complete any I/Os not yet submitted as FAILED. If completing
+			 * these means there are no more to complete for the stripe request, we can
+			 * release the stripe request as well.
+			 */
+			uint64_t base_bdev_io_not_submitted = raid_bdev->num_base_bdevs -
+							      raid_io->base_bdev_io_submitted;
+
+			if (raid_bdev_io_complete_part(raid_io, base_bdev_io_not_submitted,
+						       SPDK_BDEV_IO_STATUS_FAILED) &&
+			    stripe_req->type == STRIPE_REQ_WRITE) {
+				raid6f_stripe_request_release(stripe_req);
+			}
+		}
+	}
+
+	return ret;
+}
+
+static int
+raid6f_chunk_set_iovcnt(struct chunk *chunk, int iovcnt)
+{
+	if (iovcnt > chunk->iovcnt_max) {
+		struct iovec *iovs = chunk->iovs;
+
+		iovs = realloc(iovs, iovcnt * sizeof(*iovs));
+		if (!iovs) {
+			return -ENOMEM;
+		}
+		chunk->iovs = iovs;
+		chunk->iovcnt_max = iovcnt;
+	}
+	chunk->iovcnt = iovcnt;
+
+	return 0;
+}
+
+static int
+raid6f_stripe_request_map_iovecs(struct stripe_request *stripe_req)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+	uint64_t chunk_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	struct chunk *chunk;
+	int raid_io_iov_idx = 0;
+	size_t raid_io_offset = 0;
+	size_t raid_io_iov_offset = 0;
+	int i;
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		int chunk_iovcnt = 0;
+		uint64_t len = chunk_len;
+		size_t off = raid_io_iov_offset;
+		int ret;
+
+		for (i = raid_io_iov_idx; i < raid_io->iovcnt; i++) {
+			chunk_iovcnt++;
+			off += raid_io->iovs[i].iov_len;
+			if (off >= raid_io_offset + len) {
+				break;
+			}
+		}
+
+		assert(raid_io_iov_idx + chunk_iovcnt <= raid_io->iovcnt);
+
+		ret = raid6f_chunk_set_iovcnt(chunk, chunk_iovcnt);
+		if (ret) {
+			return ret;
+		}
+
+		if (raid_io->md_buf != NULL) {
+			chunk->md_buf = raid_io->md_buf +
+					(raid_io_offset >> r6f_info->blocklen_shift) * raid_bdev->bdev.md_len;
+		}
+
+		for (i = 0; i < chunk_iovcnt; i++) {
+			struct iovec *chunk_iov = &chunk->iovs[i];
+			const struct iovec *raid_io_iov = &raid_io->iovs[raid_io_iov_idx];
+			size_t chunk_iov_offset = raid_io_offset - raid_io_iov_offset;
+
+			chunk_iov->iov_base = raid_io_iov->iov_base + chunk_iov_offset;
+			chunk_iov->iov_len = spdk_min(len, raid_io_iov->iov_len - chunk_iov_offset);
+			raid_io_offset += chunk_iov->iov_len;
+			len -= chunk_iov->iov_len;
+
+			if (raid_io_offset >= raid_io_iov_offset + raid_io_iov->iov_len) {
+				raid_io_iov_idx++;
+				raid_io_iov_offset += raid_io_iov->iov_len;
+			}
+		}
+
+		if (spdk_unlikely(len > 0)) {
+			return -EINVAL;
+		}
+	}
+
+	stripe_req->p_chunk->iovs[0].iov_base = stripe_req->write.p_buf;
+	stripe_req->p_chunk->iovs[0].iov_len = chunk_len;
+	stripe_req->p_chunk->iovcnt = 1;
+	stripe_req->p_chunk->md_buf = stripe_req->write.p_md_buf;
+
+	stripe_req->q_chunk->iovs[0].iov_base = stripe_req->write.q_buf;
+	stripe_req->q_chunk->iovs[0].iov_len = chunk_len;
+	stripe_req->q_chunk->iovcnt = 1;
+	stripe_req->q_chunk->md_buf = stripe_req->write.q_md_buf;
+
+	return 0;
+}
+
+static void
+raid6f_stripe_request_submit_chunks(struct stripe_request *stripe_req)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct chunk *start = &stripe_req->chunks[raid_io->base_bdev_io_submitted];
+	struct chunk *chunk;
+
+	FOR_EACH_CHUNK_FROM(stripe_req, chunk, start) {
+		if (spdk_unlikely(raid6f_chunk_submit(chunk) != 0)) {
+			break;
+		}
+	}
+}
+
+static inline void
+raid6f_stripe_request_init(struct stripe_request *stripe_req, struct raid_bdev_io *raid_io,
+			   uint64_t stripe_index)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+
+	stripe_req->raid_io = raid_io;
+	stripe_req->stripe_index = stripe_index;
+	stripe_req->p_chunk = &stripe_req->chunks[raid6f_stripe_p_chunk_index(raid_bdev, stripe_index)];
+	stripe_req->q_chunk = &stripe_req->chunks[raid6f_stripe_q_chunk_index(raid_bdev, stripe_index)];
+}
+
+static void
+raid6f_stripe_write_request_pq_done(struct stripe_request *stripe_req, int status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	if (status != 0) {
+		raid6f_stripe_request_release(stripe_req);
+		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+	} else {
+		raid6f_stripe_request_submit_chunks(stripe_req);
+	}
+}
+
+static int
+raid6f_submit_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6f_io_channel *r6ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	struct stripe_request *stripe_req;
+	int ret;
+
+	stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.write);
+	if (!stripe_req) {
+		return -ENOMEM;
+	}
+
+	raid6f_stripe_request_init(stripe_req, raid_io, stripe_index);
+
+	ret = raid6f_stripe_request_map_iovecs(stripe_req);
+	if (spdk_unlikely(ret)) {
+		return ret;
+	}
+
+	TAILQ_REMOVE(&r6ch->free_stripe_requests.write, stripe_req, link);
+
+	raid_io->module_private = stripe_req;
+	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
+
+	if (raid_bdev_channel_get_base_channel(raid_io->raid_ch, stripe_req->p_chunk->index) != NULL ||
+	    raid_bdev_channel_get_base_channel(raid_io->raid_ch, stripe_req->q_chunk->index) != NULL) {
+		raid6f_pq_stripe(stripe_req, raid6f_stripe_write_request_pq_done);
+	} else {
+		raid6f_stripe_write_request_pq_done(stripe_req, 0);
+	}
+
+	return 0;
+}
+
+static void
+raid6f_chunk_read_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_io_complete(raid_io, success ? SPDK_BDEV_IO_STATUS_SUCCESS :
+			      SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void raid6f_submit_rw_request(struct raid_bdev_io *raid_io);
+
+static void
+_raid6f_submit_rw_request(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid6f_submit_rw_request(raid_io);
+}
+
+static void
+raid6f_stripe_request_reconstruct_done(struct stripe_request *stripe_req, int status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	raid6f_stripe_request_release(stripe_req);
+
+	raid_bdev_io_complete(raid_io,
+			      status == 0 ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void
+raid6f_reconstruct_reads_completed_cb(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
+{
+	struct stripe_request *stripe_req = raid_io->module_private;
+	struct chunk *chunk = stripe_req->reconstruct.chunk;
+	int ret;
+
+	raid_io->completion_cb = NULL;
+
+	if (status != SPDK_BDEV_IO_STATUS_SUCCESS) {
+		stripe_req->pq.cb(stripe_req, -EIO);
+		return;
+	}
+
+	if (stripe_req->reconstruct.nmissing > 0) {
+		ret = raid6f_rec_stripe(stripe_req);
+		if (spdk_unlikely(ret != 0)) {
+			SPDK_ERRLOG("stripe reconstruction failed: %s\n", spdk_strerror(-ret));
+			stripe_req->pq.cb(stripe_req, ret);
+			return;
+		}
+	}
+
+	if (chunk == stripe_req->p_chunk || chunk == stripe_req->q_chunk) {
+		raid6f_pq_stripe(stripe_req, stripe_req->pq.cb);
+	} else {
+		stripe_req->pq.cb(stripe_req, 0);
+	}
+}
+
+/*
+ * Reconstruct a range of a chunk that can't be read.  Up to two chunks of a stripe can be
+ * missing: the requested chunk and any chunk whose base bdev is gone.  Missing data chunks are
+ * recovered from the remaining data chunks and P, or Q if P is also missing or two data chunks
+ * are missing.  A missing P or Q chunk is then recalculated from the data chunks.
+ */
+static int
+raid6f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+			       uint8_t chunk_idx, uint64_t chunk_offset, stripe_req_pq_cb cb)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6f_io_channel *r6ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	void *raid_io_md = raid_io->md_buf;
+	struct stripe_request *stripe_req;
+	struct chunk *chunk;
+	uint32_t missing = 0;
+	uint32_t data_idx;
+	int buf_idx;
+
+	assert(cb != NULL);
+
+	stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.reconstruct);
+	if (!stripe_req) {
+		return -ENOMEM;
+	}
+
+	raid6f_stripe_request_init(stripe_req, raid_io, stripe_index);
+
+	stripe_req->reconstruct.chunk = &stripe_req->chunks[chunk_idx];
+	stripe_req->reconstruct.chunk_offset = chunk_offset;
+	stripe_req->reconstruct.nmissing = 0;
+	stripe_req->pq.cb = cb;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		chunk->read = chunk != stripe_req->reconstruct.chunk &&
+			      raid_bdev_channel_get_base_channel(raid_io->raid_ch, chunk->index) != NULL;
+		if (!chunk->read) {
+			missing++;
+		}
+	}
+
+	if (missing > RAID6F_PARITY_CHUNKS) {
+		return -EIO;
+	}
+
+	data_idx = 0;
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		if (!chunk->read) {
+			stripe_req->reconstruct.missing[stripe_req->reconstruct.nmissing++] = data_idx;
+		}
+		data_idx++;
+	}
+
+	/* Read only the parity that is needed to recover the missing data chunks */
+	if (stripe_req->reconstruct.nmissing == 0) {
+		stripe_req->p_chunk->read = false;
+		stripe_req->q_chunk->read = false;
+	} else if (stripe_req->reconstruct.nmissing == 1 && stripe_req->p_chunk->read) {
+		stripe_req->q_chunk->read = false;
+	}
+
+	buf_idx = 0;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		if (chunk == stripe_req->reconstruct.chunk) {
+			int i;
+			int ret;
+
+			ret = raid6f_chunk_set_iovcnt(chunk, raid_io->iovcnt);
+			if (ret) {
+				return ret;
+			}
+
+			for (i = 0; i < raid_io->iovcnt; i++) {
+				chunk->iovs[i] = raid_io->iovs[i];
+			}
+
+			chunk->md_buf = raid_io_md;
+		} else {
+			struct iovec *iov = &chunk->iovs[0];
+
+			iov->iov_base = stripe_req->reconstruct.chunk_buffers[buf_idx];
+			iov->iov_len = raid_io->num_blocks * raid_bdev->bdev.blocklen;
+			chunk->iovcnt = 1;
+
+			if (raid_io_md) {
+				chunk->md_buf = stripe_req->reconstruct.chunk_md_buffers[buf_idx];
+			}
+
+			buf_idx++;
+		}
+	}
+
+	raid_io->module_private = stripe_req;
+	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
+	raid_io->completion_cb = raid6f_reconstruct_reads_completed_cb;
+
+	TAILQ_REMOVE(&r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+
+	raid6f_stripe_request_submit_chunks(stripe_req);
+
+	return 0;
+}
+
+static int
+raid6f_submit_read_request(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+			   uint64_t stripe_offset)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint8_t chunk_data_idx = stripe_offset >> raid_bdev->strip_size_shift;
+	uint8_t chunk_idx = raid6f_stripe_data_chunk_index(raid_bdev, stripe_index, chunk_data_idx);
+	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[chunk_idx];
+	struct spdk_io_channel *base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, chunk_idx);
+	uint64_t chunk_offset = stripe_offset - (chunk_data_idx << raid_bdev->strip_size_shift);
+	uint64_t base_offset_blocks = (stripe_index << raid_bdev->strip_size_shift) + chunk_offset;
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	raid6f_init_ext_io_opts(&io_opts, raid_io);
+	if (base_ch == NULL) {
+		return raid6f_submit_reconstruct_read(raid_io, stripe_index, chunk_idx, chunk_offset,
+						      raid6f_stripe_request_reconstruct_done);
+	}
+
+	ret = raid_bdev_readv_blocks_ext(base_info, base_ch, raid_io->iovs, raid_io->iovcnt,
+					 base_offset_blocks, raid_io->num_blocks,
+					 raid6f_chunk_read_complete, raid_io, &io_opts);
+	if (spdk_unlikely(ret == -ENOMEM)) {
+		raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+					base_ch, _raid6f_submit_rw_request);
+		return 0;
+	}
+
+	return ret;
+}
+
+static void
+raid6f_submit_rw_request(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+	uint64_t stripe_index = raid_io->offset_blocks / r6f_info->stripe_blocks;
+	uint64_t stripe_offset = raid_io->offset_blocks % r6f_info->stripe_blocks;
+	int ret;
+
+	switch (raid_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		assert(raid_io->num_blocks <= raid_bdev->strip_size);
+		ret = raid6f_submit_read_request(raid_io, stripe_index, stripe_offset);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		assert(stripe_offset == 0);
+		assert(raid_io->num_blocks == r6f_info->stripe_blocks);
+		ret = raid6f_submit_write_request(raid_io, stripe_index);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	if (spdk_unlikely(ret)) {
+		raid_bdev_io_complete(raid_io, ret == -ENOMEM ? SPDK_BDEV_IO_STATUS_NOMEM :
+				      SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+raid6f_stripe_request_free(struct stripe_request *stripe_req)
+{
+	struct chunk *chunk;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		free(chunk->iovs);
+	}
+
+	if (stripe_req->type == STRIPE_REQ_WRITE) {
+		spdk_dma_free(stripe_req->write.p_buf);
+		spdk_dma_free(stripe_req->write.q_buf);
+		spdk_dma_free(stripe_req->write.p_md_buf);
+		spdk_dma_free(stripe_req->write.q_md_buf);
+	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+		struct raid6f_info *r6f_info = raid6f_ch_to_r6f_info(stripe_req->r6ch);
+		struct raid_bdev *raid_bdev = r6f_info->raid_bdev;
+		uint8_t i;
+
+		if (stripe_req->reconstruct.chunk_buffers) {
+			for (i = 0; i < raid_bdev->num_base_bdevs - 1; i++) {
+				spdk_dma_free(stripe_req->reconstruct.chunk_buffers[i]);
+			}
+			free(stripe_req->reconstruct.chunk_buffers);
+		}
+
+		if (stripe_req->reconstruct.chunk_md_buffers) {
+			for (i = 0; i < raid_bdev->num_base_bdevs - 1; i++) {
+				spdk_dma_free(stripe_req->reconstruct.chunk_md_buffers[i]);
+			}
+			free(stripe_req->reconstruct.chunk_md_buffers);
+		}
+	} else {
+		assert(false);
+	}
+
+	free(stripe_req->chunk_pq_buffers);
+	free(stripe_req->chunk_pq_md_buffers);
+	free(stripe_req->chunk_iov_iters);
+
+	free(stripe_req);
+}
+
+static struct stripe_request *
+raid6f_stripe_request_alloc(struct raid6f_io_channel *r6ch, enum stripe_request_type type)
+{
+	struct raid6f_info *r6f_info = raid6f_ch_to_r6f_info(r6ch);
+	struct raid_bdev *raid_bdev = r6f_info->raid_bdev;
+	uint32_t raid_io_md_size = raid_bdev->bdev.md_interleave ? 0 : raid_bdev->bdev.md_len;
+	size_t chunk_md_len = raid_bdev->strip_size * raid_io_md_size;
+	struct stripe_request *stripe_req;
+	struct chunk *chunk;
+	size_t chunk_len;
+
+	stripe_req = calloc(1, sizeof(*stripe_req) + sizeof(*chunk) * raid_bdev->num_base_bdevs);
+	if (!stripe_req) {
+		return NULL;
+	}
+
+	stripe_req->r6ch = r6ch;
+	stripe_req->type = type;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		chunk->index = chunk - stripe_req->chunks;
+		chunk->iovcnt_max = 4;
+		chunk->iovs = calloc(chunk->iovcnt_max, sizeof(chunk->iovs[0]));
+		if (!chunk->iovs) {
+			goto err;
+		}
+	}
+
+	chunk_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+
+	if (type == STRIPE_REQ_WRITE) {
+		stripe_req->write.p_buf = spdk_dma_malloc(chunk_len, r6f_info->buf_alignment, NULL);
+		stripe_req->write.q_buf = spdk_dma_malloc(chunk_len, r6f_info->buf_alignment, NULL);
+		if (!stripe_req->write.p_buf || !stripe_req->write.q_buf) {
+			goto err;
+		}
+
+		if (raid_io_md_size != 0) {
+			stripe_req->write.p_md_buf = spdk_dma_malloc(chunk_md_len, r6f_info->buf_alignment,
+						     NULL);
+			stripe_req->write.q_md_buf = spdk_dma_malloc(chunk_md_len, r6f_info->buf_alignment,
+						     NULL);
+			if (!stripe_req->write.p_md_buf || !stripe_req->write.q_md_buf) {
+				goto err;
+			}
+		}
+	} else if (type == STRIPE_REQ_RECONSTRUCT) {
+		/* All chunks but the one being reconstructed are read into these buffers */
+		uint8_t n = raid_bdev->num_base_bdevs - 1;
+		void *buf;
+		uint8_t i;
+
+		stripe_req->reconstruct.chunk_buffers = calloc(n, sizeof(void *));
+		if (!stripe_req->reconstruct.chunk_buffers) {
+			goto err;
+		}
+
+		for (i = 0; i < n; i++) {
+			buf = spdk_dma_malloc(chunk_len, r6f_info->buf_alignment, NULL);
+			if (!buf) {
+				goto err;
+			}
+			stripe_req->reconstruct.chunk_buffers[i] = buf;
+		}
+
+		if (raid_io_md_size != 0) {
+			stripe_req->reconstruct.chunk_md_buffers = calloc(n, sizeof(void *));
+			if (!stripe_req->reconstruct.chunk_md_buffers) {
+				goto err;
+			}
+
+			for (i = 0; i < n; i++) {
+				buf = spdk_dma_malloc(chunk_md_len, r6f_info->buf_alignment, NULL);
+				if (!buf) {
+					goto err;
+				}
+				stripe_req->reconstruct.chunk_md_buffers[i] = buf;
+			}
+		}
+	} else {
+		assert(false);
+		return NULL;
+	}
+
+	stripe_req->chunk_iov_iters = malloc(SPDK_IOVITER_SIZE(raid_bdev->num_base_bdevs));
+	if (!stripe_req->chunk_iov_iters) {
+		goto err;
+	}
+
+	stripe_req->chunk_pq_buffers = calloc(raid6f_stripe_data_chunks_num(raid_bdev),
+					      sizeof(stripe_req->chunk_pq_buffers[0]));
+	if (!stripe_req->chunk_pq_buffers) {
+		goto err;
+	}
+
+	stripe_req->chunk_pq_md_buffers = calloc(raid6f_stripe_data_chunks_num(raid_bdev),
+					  sizeof(stripe_req->chunk_pq_md_buffers[0]));
+	if (!stripe_req->chunk_pq_md_buffers) {
+		goto err;
+	}
+
+	return stripe_req;
+err:
+	raid6f_stripe_request_free(stripe_req);
+	return NULL;
+}
+
+static void
+raid6f_ioch_destroy(void *io_device, void *ctx_buf)
+{
+	struct raid6f_io_channel *r6ch = ctx_buf;
+	struct stripe_request *stripe_req;
+
+	assert(TAILQ_EMPTY(&r6ch->pq_retry_queue));
+
+	while ((stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.write))) {
+		TAILQ_REMOVE(&r6ch->free_stripe_requests.write, stripe_req, link);
+		raid6f_stripe_request_free(stripe_req);
+	}
+
+	while ((stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.reconstruct))) {
+		TAILQ_REMOVE(&r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+		raid6f_stripe_request_free(stripe_req);
+	}
+
+	if (r6ch->accel_ch) {
+		spdk_put_io_channel(r6ch->accel_ch);
+	}
+
+	free(r6ch->chunk_pq_buffers);
+	free(r6ch->chunk_pq_iovs);
+	free(r6ch->chunk_pq_iovcnt);
+}
+
+static int
+raid6f_ioch_create(void *io_device, void *ctx_buf)
+{
+	struct raid6f_io_channel *r6ch = ctx_buf;
+	struct raid6f_info *r6f_info = io_device;
+	struct raid_bdev *raid_bdev = r6f_info->raid_bdev;
+	struct stripe_request *stripe_req;
+	int i;
+
+	TAILQ_INIT(&r6ch->free_stripe_requests.write);
+	TAILQ_INIT(&r6ch->free_stripe_requests.reconstruct);
+	TAILQ_INIT(&r6ch->pq_retry_queue);
+
+	for (i = 0; i < RAID6F_MAX_STRIPES; i++) {
+		stripe_req = raid6f_stripe_request_alloc(r6ch, STRIPE_REQ_WRITE);
+		if (!stripe_req) {
+			goto err;
+		}
+
+		TAILQ_INSERT_HEAD(&r6ch->free_stripe_requests.write, stripe_req, link);
+	}
+
+	for (i = 0; i < RAID6F_MAX_STRIPES; i++) {
+		stripe_req = raid6f_stripe_request_alloc(r6ch, STRIPE_REQ_RECONSTRUCT);
+		if (!stripe_req) {
+			goto err;
+		}
+
+		TAILQ_INSERT_HEAD(&r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+	}
+
+	r6ch->accel_ch = spdk_accel_get_io_channel();
+	if (!r6ch->accel_ch) {
+		SPDK_ERRLOG("Failed to get accel framework's IO channel\n");
+		goto err;
+	}
+
+	r6ch->chunk_pq_buffers = calloc(raid_bdev->num_base_bdevs, sizeof(*r6ch->chunk_pq_buffers));
+	if (!r6ch->chunk_pq_buffers) {
+		goto err;
+	}
+
+	r6ch->chunk_pq_iovs = calloc(raid_bdev->num_base_bdevs, sizeof(*r6ch->chunk_pq_iovs));
+	if (!r6ch->chunk_pq_iovs) {
+		goto err;
+	}
+
+	r6ch->chunk_pq_iovcnt = calloc(raid_bdev->num_base_bdevs, sizeof(*r6ch->chunk_pq_iovcnt));
+	if (!r6ch->chunk_pq_iovcnt) {
+		goto err;
+	}
+
+	return 0;
+err:
+	SPDK_ERRLOG("Failed to initialize io channel\n");
+	raid6f_ioch_destroy(r6f_info, r6ch);
+	return -ENOMEM;
+}
+
+static int
+raid6f_start(struct raid_bdev *raid_bdev)
+{
+	uint64_t min_blockcnt = UINT64_MAX;
+	uint64_t base_bdev_data_size;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_bdev *base_bdev;
+	struct raid6f_info *r6f_info;
+	size_t alignment = 0;
+
+	r6f_info = calloc(1, sizeof(*r6f_info));
+	if (!r6f_info) {
+		SPDK_ERRLOG("Failed to allocate r6f_info\n");
+		return -ENOMEM;
+	}
+	r6f_info->raid_bdev = raid_bdev;
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		min_blockcnt = spdk_min(min_blockcnt, base_info->data_size);
+		if (base_info->desc) {
+			base_bdev = spdk_bdev_desc_get_bdev(base_info->desc);
+			alignment = spdk_max(alignment, spdk_bdev_get_buf_align(base_bdev));
+		}
+	}
+
+	base_bdev_data_size = (min_blockcnt / raid_bdev->strip_size) * raid_bdev->strip_size;
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		base_info->data_size = base_bdev_data_size;
+	}
+
+	r6f_info->total_stripes = min_blockcnt / raid_bdev->strip_size;
+	r6f_info->stripe_blocks = raid_bdev->strip_size * raid6f_stripe_data_chunks_num(raid_bdev);
+	r6f_info->buf_alignment = alignment;
+	if (!raid_bdev->bdev.md_interleave) {
+		r6f_info->blocklen_shift = spdk_u32log2(raid_bdev->bdev.blocklen);
+	}
+
+	raid_bdev->bdev.blockcnt = r6f_info->stripe_blocks * r6f_info->total_stripes;
+	raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
+	raid_bdev->bdev.split_on_optimal_io_boundary = true;
+	raid_bdev->bdev.write_unit_size = r6f_info->stripe_blocks;
+	raid_bdev->bdev.split_on_write_unit = true;
+
+	raid_bdev->module_private = r6f_info;
+
+	spdk_io_device_register(r6f_info, raid6f_ioch_create, raid6f_ioch_destroy,
+				sizeof(struct raid6f_io_channel), NULL);
+
+	return 0;
+}
+
+static void
+raid6f_io_device_unregister_done(void *io_device)
+{
+	struct raid6f_info *r6f_info = io_device;
+
+	raid_bdev_module_stop_done(r6f_info->raid_bdev);
+
+	free(r6f_info);
+}
+
+static bool
+raid6f_stop(struct raid_bdev *raid_bdev)
+{
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+
+	spdk_io_device_unregister(r6f_info, raid6f_io_device_unregister_done);
+
+	return false;
+}
+
+static struct spdk_io_channel *
+raid6f_get_io_channel(struct raid_bdev *raid_bdev)
+{
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+
+	return spdk_get_io_channel(r6f_info);
+}
+
+static void
+raid6f_process_write_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_process_request_complete(process_req, success ? 0 : -EIO);
+}
+
+static void raid6f_process_submit_write(struct raid_bdev_process_request *process_req);
+
+static void
+_raid6f_process_submit_write(void *ctx)
+{
+	struct raid_bdev_process_request *process_req = ctx;
+
+	raid6f_process_submit_write(process_req);
+}
+
+static void
+raid6f_process_submit_write(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+	uint64_t stripe_index = process_req->offset_blocks / r6f_info->stripe_blocks;
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	raid6f_init_ext_io_opts(&io_opts, raid_io);
+	ret = raid_bdev_writev_blocks_ext(process_req->target, process_req->target_ch,
+					  raid_io->iovs, raid_io->iovcnt,
+					  stripe_index << raid_bdev->strip_size_shift, raid_bdev->strip_size,
+					  raid6f_process_write_completed, process_req, &io_opts);
+	if (spdk_unlikely(ret != 0)) {
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(process_req->target->desc),
+						process_req->target_ch, _raid6f_process_submit_write);
+		} else {
+			raid_bdev_process_request_complete(process_req, ret);
+		}
+	}
+}
+
+static void
+raid6f_process_stripe_request_reconstruct_done(struct stripe_request *stripe_req, int status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+
+	raid6f_stripe_request_release(stripe_req);
+
+	if (status != 0) {
+		raid_bdev_process_request_complete(process_req, status);
+		return;
+	}
+
+	raid6f_process_submit_write(process_req);
+}
+
+static int
+raid6f_submit_process_request(struct raid_bdev_process_request *process_req,
+			      struct raid_bdev_io_channel *raid_ch)
+{
+	struct spdk_io_channel *ch = spdk_io_channel_from_ctx(raid_ch);
+	struct raid_bdev *raid_bdev = spdk_io_channel_get_io_device(ch);
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	uint8_t chunk_idx = raid_bdev_base_bdev_slot(process_req->target);
+	uint64_t stripe_index = process_req->offset_blocks / r6f_info->stripe_blocks;
+	int ret;
+
+	assert((process_req->offset_blocks % r6f_info->stripe_blocks) == 0);
+
+	if (process_req->num_blocks < r6f_info->stripe_blocks) {
+		return 0;
+	}
+
+	raid_bdev_io_init(raid_io, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+			  process_req->offset_blocks, raid_bdev->strip_size,
+			  &process_req->iov, 1, process_req->md_buf, NULL, NULL);
+
+	ret = raid6f_submit_reconstruct_read(raid_io, stripe_index, chunk_idx, 0,
+					     raid6f_process_stripe_request_reconstruct_done);
+	if (spdk_likely(ret == 0)) {
+		return r6f_info->stripe_blocks;
+	} else if (ret < 0) {
+		return ret;
+	} else {
+		return -EINVAL;
+	}
+}
+
+static struct raid_bdev_module g_raid6f_module = {
+	.level = RAID6F,
+	.base_bdevs_min = 4,
+	.base_bdevs_constraint = {CONSTRAINT_MAX_BASE_BDEVS_REMOVED, RAID6F_PARITY_CHUNKS},
+	.start = raid6f_start,
+	.stop = raid6f_stop,
+	.submit_rw_request = raid6f_submit_rw_request,
+	.get_io_channel = raid6f_get_io_channel,
+	.submit_process_request = raid6f_submit_process_request,
+};
+RAID_MODULE_REGISTER(&g_raid6f_module)
+
+SPDK_LOG_REGISTER_COMPONENT(bdev_raid6f)
@@ -9,29 +9,94 @@
 #include "spdk/string.h"
 #include "spdk_internal/init.h"
 
+/* Per-channel cache size of a medium size class if the RPC doesn't specify it */
+#define RPC_IOBUF_MEDIUM_CACHE_SIZE_DEFAULT 16
+
+struct rpc_iobuf_medium_class {
+	uint32_t	bufsize;
+	uint64_t	pool_count;
+	uint32_t	cache_size;
+};
+
+struct rpc_iobuf_medium_classes {
+	struct rpc_iobuf_medium_class	classes[SPDK_IOBUF_MAX_MEDIUM_CLASSES];
+	size_t				num_classes;
+	bool				present;
+};
+
+struct rpc_iobuf_set_options {
+	struct spdk_iobuf_opts		opts;
+	struct rpc_iobuf_medium_classes	medium;
+};
+
+static const struct spdk_json_object_decoder rpc_iobuf_medium_class_decoders[] = {
+	{"bufsize", offsetof(struct rpc_iobuf_medium_class, bufsize), spdk_json_decode_uint32},
+	{"pool_count", offsetof(struct rpc_iobuf_medium_class, pool_count), spdk_json_decode_uint64},
+	{"cache_size", offsetof(struct rpc_iobuf_medium_class, cache_size), spdk_json_decode_uint32, true},
+};
+
+static int
+rpc_decode_iobuf_medium_class(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object(val, rpc_iobuf_medium_class_decoders,
+				       SPDK_COUNTOF(rpc_iobuf_medium_class_decoders), out);
+}
+
+static int
+rpc_decode_iobuf_medium_classes(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_iobuf_medium_classes *medium = out;
+	size_t i;
+
+	medium->present = true;
+	for (i = 0; i < SPDK_IOBUF_MAX_MEDIUM_CLASSES; i++) {
+		medium->classes[i].cache_size = RPC_IOBUF_MEDIUM_CACHE_SIZE_DEFAULT;
+	}
+
+	return spdk_json_decode_array(val, rpc_decode_iobuf_medium_class, medium->classes,
+				      SPDK_IOBUF_MAX_MEDIUM_CLASSES, &medium->num_classes,
+				      sizeof(struct rpc_iobuf_medium_class));
+}
+
 static const struct spdk_json_object_decoder rpc_iobuf_set_options_decoders[] = {
-	{"small_pool_count", offsetof(struct spdk_iobuf_opts, small_pool_count), spdk_json_decode_uint64, true},
-	{"large_pool_count", offsetof(struct spdk_iobuf_opts, large_pool_count), spdk_json_decode_uint64, true},
-	{"small_bufsize", offsetof(struct spdk_iobuf_opts, small_bufsize), spdk_json_decode_uint32, true},
-	{"large_bufsize", offsetof(struct spdk_iobuf_opts, large_bufsize), spdk_json_decode_uint32, true},
+	{"small_pool_count", offsetof(struct rpc_iobuf_set_options, opts.small_pool_count), spdk_json_decode_uint64, true},
+	{"large_pool_count", offsetof(struct rpc_iobuf_set_options, opts.large_pool_count), spdk_json_decode_uint64, true},
+	{"small_bufsize", offsetof(struct rpc_iobuf_set_options, opts.small_bufsize), spdk_json_decode_uint32, true},
+	{"large_bufsize", offsetof(struct rpc_iobuf_set_options, opts.large_bufsize), spdk_json_decode_uint32, true},
+	{"medium_classes", offsetof(struct rpc_iobuf_set_options, medium), rpc_decode_iobuf_medium_classes, true},
 };
 
 static void
 rpc_iobuf_set_options(struct spdk_jsonrpc_request *request, const struct spdk_json_val *params)
 {
-	struct spdk_iobuf_opts opts;
+	struct rpc_iobuf_set_options req = {};
+	size_t i;
 	int rc;
 
-	spdk_iobuf_get_opts(&opts, sizeof(opts));
+	spdk_iobuf_get_opts(&req.opts, sizeof(req.opts));
 	rc = spdk_json_decode_object(params, rpc_iobuf_set_options_decoders,
-				     SPDK_COUNTOF(rpc_iobuf_set_options_decoders), &opts);
+				     SPDK_COUNTOF(rpc_iobuf_set_options_decoders), &req);
 	if (rc != 0) {
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
 						 "spdk_json_decode_object failed");
 		return;
 	}
 
-	rc = spdk_iobuf_set_opts(&opts);
+	if (req.medium.present) {
+		for (i = 0; i < SPDK_IOBUF_MAX_MEDIUM_CLASSES; i++) {
+			if (i < req.medium.num_classes) {
+				req.opts.medium_bufsize[i] = req.medium.classes[i].bufsize;
+				req.opts.medium_pool_count[i] = req.medium.classes[i].pool_count;
+				req.opts.medium_cache_size[i] = req.medium.classes[i].cache_size;
+			} else {
+				req.opts.medium_bufsize[i] = 0;
+				req.opts.medium_pool_count[i] = 0;
+				req.opts.medium_cache_size[i] = 0;
+			}
+		}
+	}
+
+	rc = spdk_iobuf_set_opts(&req.opts);
 	if (rc != 0) {
 		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
 		return;
@@ -48,7 +113,10 @@ rpc_iobuf_get_stats_done(struct spdk_iobuf_module_stats *modules, uint32_t num_m
 	struct spdk_jsonrpc_request *request = cb_arg;
 	struct spdk_json_write_ctx *w;
 	struct spdk_iobuf_module_stats *it;
-	uint32_t i;
+	struct spdk_iobuf_opts opts;
+	uint32_t i, j;
+
+	spdk_iobuf_get_opts(&opts, sizeof(opts));
 
 	w = spdk_jsonrpc_begin_result(request);
 	spdk_json_write_array_begin(w);
@@ -71,6 +139,19 @@ rpc_iobuf_get_stats_done(struct spdk_iobuf_module_stats *modules, uint32_t num_m
 		spdk_json_write_named_uint64(w, "retry", it->large_pool.retry);
 		spdk_json_write_object_end(w);
 
+		if (it->num_medium_pools > 0) {
+			spdk_json_write_named_array_begin(w, "medium_pools");
+			for (j = 0; j < it->num_medium_pools; ++j) {
+				spdk_json_write_object_begin(w);
+				spdk_json_write_named_uint32(w, "bufsize", opts.medium_bufsize[j]);
+				spdk_json_write_named_uint64(w, "cache", it->medium_pool[j].cache);
+				spdk_json_write_named_uint64(w, "main", it->medium_pool[j].main);
+				spdk_json_write_named_uint64(w, "retry", it->medium_pool[j].retry);
+				spdk_json_write_object_end(w);
+			}
+			spdk_json_write_array_end(w);
+		}
+
 		spdk_json_write_object_end(w);
 	}
 
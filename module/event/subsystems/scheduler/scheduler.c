@@ -36,7 +36,8 @@ static void
 scheduler_write_config_json(struct spdk_json_write_ctx *w)
 {
 	struct spdk_scheduler *scheduler;
-	uint64_t scheduler_period;
+	struct spdk_reactor_hybrid_opts hybrid_opts;
+	uint64_t scheduler_period, watchdog_budget_us;
 
 	assert(w != NULL);
 
@@ -60,6 +61,29 @@ scheduler_write_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_object_end(w);
 	spdk_json_write_object_end(w);
 
+	spdk_reactors_get_hybrid_opts(&hybrid_opts);
+	if (hybrid_opts.enabled) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "framework_set_hybrid_polling");
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_bool(w, "enabled", hybrid_opts.enabled);
+		spdk_json_write_named_uint32(w, "idle_iterations", hybrid_opts.idle_iterations);
+		spdk_json_write_named_uint32(w, "min_sleep_us", hybrid_opts.min_sleep_us);
+		spdk_json_write_named_uint32(w, "max_sleep_us", hybrid_opts.max_sleep_us);
+		spdk_json_write_object_end(w);
+		spdk_json_write_object_end(w);
+	}
+
+	watchdog_budget_us = spdk_reactors_get_watchdog_budget();
+	if (watchdog_budget_us != 0) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "framework_set_watchdog");
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_uint64(w, "budget_us", watchdog_budget_us);
+		spdk_json_write_object_end(w);
+		spdk_json_write_object_end(w);
+	}
+
 	spdk_json_write_array_end(w);
 }
 
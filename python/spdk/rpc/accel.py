@@ -94,7 +94,7 @@ def accel_set_driver(client, name):
 
 
 def accel_set_options(client, small_cache_size, large_cache_size,
-                      task_count, sequence_count, buf_count):
+                      task_count, sequence_count, buf_count, batch_count=None):
     """Set accel framework's options."""
     params = {}
 
@@ -108,16 +108,69 @@ def accel_set_options(client, small_cache_size, large_cache_size,
         params['sequence_count'] = sequence_count
     if buf_count is not None:
         params['buf_count'] = buf_count
+    if batch_count is not None:
+        params['batch_count'] = batch_count
 
     return client.call('accel_set_options', params)
 
 
+def accel_sw_set_options(client, helper_threads=None, offload_threshold=None, helper_cpumask=None):
+    """Set software accel module's options.
+
+    Args:
+        helper_threads: number of helper threads executing large tasks, 0 to disable (optional)
+        offload_threshold: size in bytes from which tasks are executed by the helper threads (optional)
+        helper_cpumask: cpumask of the helper threads (optional)
+    """
+    params = {}
+
+    if helper_threads is not None:
+        params['helper_threads'] = helper_threads
+    if offload_threshold is not None:
+        params['offload_threshold'] = offload_threshold
+    if helper_cpumask is not None:
+        params['helper_cpumask'] = helper_cpumask
+
+    return client.call('accel_sw_set_options', params)
+
+
 def accel_get_stats(client):
     """Get accel framework's statistics"""
 
     return client.call('accel_get_stats')
 
 
+def accel_set_route_policy(client, telemetry=None, routing=None, sw_max_size=None,
+                           max_queue_depth=None):
+    """Configure accel framework's telemetry and routing engine.
+
+    Args:
+        telemetry: measure the latency of the operations (optional)
+        routing: enable routing operations to the software module (optional)
+        sw_max_size: operations of at most this many bytes are executed in software, 0 to disable (optional)
+        max_queue_depth: queue depth of the assigned module from which operations are executed in software,
+                         0 to disable (optional)
+    """
+    params = {}
+
+    if telemetry is not None:
+        params['telemetry'] = telemetry
+    if routing is not None:
+        params['routing'] = routing
+    if sw_max_size is not None:
+        params['sw_max_size'] = sw_max_size
+    if max_queue_depth is not None:
+        params['max_queue_depth'] = max_queue_depth
+
+    return client.call('accel_set_route_policy', params)
+
+
+def accel_get_route_stats(client):
+    """Get accel framework's routing statistics"""
+
+    return client.call('accel_get_route_stats')
+
+
 def accel_error_inject_error(client, opcode, type, count=None, interval=None, errcode=None):
     """Inject an error to processing accel operation"""
     params = {}
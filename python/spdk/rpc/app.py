@@ -37,6 +37,49 @@ def framework_get_reactors(client):
     return client.call('framework_get_reactors')
 
 
+def framework_set_hybrid_polling(client, enabled, idle_iterations=None, min_sleep_us=None,
+                                 max_sleep_us=None):
+    """Configure hybrid polling of reactors.
+
+    Args:
+        enabled: True to let idle reactors sleep between iterations; False to always busy poll
+        idle_iterations: number of consecutive idle iterations before a reactor starts sleeping (optional)
+        min_sleep_us: length of the first sleep in microseconds (optional)
+        max_sleep_us: maximum length of a single sleep in microseconds (optional)
+    Returns:
+        True or False
+    """
+    params = {'enabled': enabled}
+    if idle_iterations is not None:
+        params['idle_iterations'] = idle_iterations
+    if min_sleep_us is not None:
+        params['min_sleep_us'] = min_sleep_us
+    if max_sleep_us is not None:
+        params['max_sleep_us'] = max_sleep_us
+    return client.call('framework_set_hybrid_polling', params)
+
+
+def framework_set_watchdog(client, budget_us):
+    """Configure the reactor stall watchdog.
+
+    Args:
+        budget_us: maximum time in microseconds a single reactor iteration may take before it's reported as a stall; 0 disables the watchdog
+    Returns:
+        True or False
+    """
+    params = {'budget_us': budget_us}
+    return client.call('framework_set_watchdog', params)
+
+
+def framework_get_reactor_stalls(client):
+    """Query stalls recently detected by the reactor watchdog.
+
+    Returns:
+        List of reactors with their most recent stalls.
+    """
+    return client.call('framework_get_reactor_stalls')
+
+
 def framework_set_scheduler(client, name, period=None, load_limit=None, core_limit=None,
                             core_busy=None):
     """Select threads scheduler that will be activated and its period.
@@ -51,13 +51,15 @@ def bdev_wait_for_examine(client):
     return client.call('bdev_wait_for_examine')
 
 
-def bdev_compress_create(client, base_bdev_name, pm_path, lb_size=None):
+def bdev_compress_create(client, base_bdev_name, pm_path, lb_size=None, comp_algo=None, comp_level=None):
     """Construct a compress virtual block device.
 
     Args:
         base_bdev_name: name of the underlying base bdev
         pm_path: path to persistent memory
         lb_size: logical block size for the compressed vol in bytes.  Must be 4K or 512.
+        comp_algo: compression algorithm: deflate, lz4 or zstd (optional)
+        comp_level: compression level, 0 selects the fastest level of the algorithm (optional)
 
     Returns:
         Name of created virtual block device.
@@ -66,6 +68,10 @@ def bdev_compress_create(client, base_bdev_name, pm_path, lb_size=None):
 
     if lb_size:
         params['lb_size'] = lb_size
+    if comp_algo is not None:
+        params['comp_algo'] = comp_algo
+    if comp_level is not None:
+        params['comp_level'] = comp_level
 
     return client.call('bdev_compress_create', params)
 
@@ -390,17 +396,40 @@ def bdev_null_resize(client, name, new_size):
     return client.call('bdev_null_resize', params)
 
 
-def bdev_raid_set_options(client, process_window_size_kb=None):
+def bdev_raid_set_options(client, process_window_size_kb=None, bitmap_region_size_kb=None,
+                          process_max_mbytes_per_sec=None, process_max_ios_per_sec=None,
+                          process_adaptive=None, raid5f_stripe_pool_max_kb=None):
     """Set options for bdev raid.
 
     Args:
         process_window_size_kb: Background process (e.g. rebuild) window size in KiB
+        bitmap_region_size_kb: Write-intent bitmap region size in KiB, 0 to disable the bitmap
+        process_max_mbytes_per_sec: Background process bandwidth limit in MiB/s, 0 for unlimited
+        process_max_ios_per_sec: Background process request rate limit, 0 for unlimited
+        process_adaptive: Adjust background processes to the load of the base bdevs
+        raid5f_stripe_pool_max_kb: Memory limit for the stripe requests of a raid5f channel in KiB,
+        0 for unlimited
     """
     params = {}
 
     if process_window_size_kb is not None:
         params['process_window_size_kb'] = process_window_size_kb
 
+    if bitmap_region_size_kb is not None:
+        params['bitmap_region_size_kb'] = bitmap_region_size_kb
+
+    if process_max_mbytes_per_sec is not None:
+        params['process_max_mbytes_per_sec'] = process_max_mbytes_per_sec
+
+    if process_max_ios_per_sec is not None:
+        params['process_max_ios_per_sec'] = process_max_ios_per_sec
+
+    if process_adaptive is not None:
+        params['process_adaptive'] = process_adaptive
+
+    if raid5f_stripe_pool_max_kb is not None:
+        params['raid5f_stripe_pool_max_kb'] = raid5f_stripe_pool_max_kb
+
     return client.call('bdev_raid_set_options', params)
 
 
@@ -483,6 +512,79 @@ def bdev_raid_remove_base_bdev(client, name):
     return client.call('bdev_raid_remove_base_bdev', params)
 
 
+def bdev_raid_set_read_policy(client, name, read_policy=None, hedge_percentile=None):
+    """Set read policy of a raid bdev
+
+    Args:
+        name: raid bdev name
+        read_policy: read policy: least_outstanding, latency or sequential (default: least_outstanding)
+        hedge_percentile: base bdev latency percentile after which a read is also sent to another
+        base bdev, 0 to disable hedged reads (default: 0)
+
+    Returns:
+        None
+    """
+    params = {'name': name}
+
+    if read_policy is not None:
+        params['read_policy'] = read_policy
+
+    if hedge_percentile is not None:
+        params['hedge_percentile'] = hedge_percentile
+
+    return client.call('bdev_raid_set_read_policy', params)
+
+
+def bdev_raid_reshape(client, name, base_bdevs=None):
+    """Add base bdevs to an online raid bdev
+
+    Args:
+        name: raid bdev name
+        base_bdevs: list of base bdev names to add; if omitted, a stopped reshape is resumed
+
+    Returns:
+        None
+    """
+    params = {'name': name}
+
+    if base_bdevs is not None:
+        params['base_bdevs'] = base_bdevs
+
+    return client.call('bdev_raid_reshape', params)
+
+
+def bdev_raid_start_scrub(client, name, repair=None):
+    """Start verifying the consistency of the mirrors or parity of a raid bdev
+
+    Args:
+        name: raid bdev name
+        repair: rewrite the blocks that don't match or can't be read (optional, default true)
+
+    Returns:
+        None
+    """
+    params = {'name': name}
+
+    if repair is not None:
+        params['repair'] = repair
+
+    return client.call('bdev_raid_start_scrub', params)
+
+
+def bdev_raid_stop_scrub(client, name):
+    """Stop the scrub of a raid bdev
+
+    Args:
+        name: raid bdev name
+
+    Returns:
+        None
+    """
+    params = {'name': name}
+
+    return client.call('bdev_raid_stop_scrub', params)
+
+
 def bdev_aio_create(client, filename, name, block_size=None, readonly=False, fallocate=False):
     """Construct a Linux AIO block device.
 
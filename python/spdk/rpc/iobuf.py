@@ -3,7 +3,8 @@
 #  All rights reserved.
 
 
-def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize, large_bufsize):
+def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize, large_bufsize,
+                      medium_classes=None):
     """Set iobuf pool options.
 
     Args:
@@ -11,6 +12,9 @@ def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize,
         large_pool_count: number of large buffers in the global pool
         small_bufsize: size of a small buffer
         large_bufsize: size of a large buffer
+        medium_classes: list of {'bufsize': size, 'pool_count': count, 'cache_size': count} dicts
+                        describing the size classes between small and large buffers, cache_size
+                        is optional (optional)
     """
     params = {}
 
@@ -22,6 +26,8 @@ def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize,
         params['small_bufsize'] = small_bufsize
     if large_bufsize is not None:
         params['large_bufsize'] = large_bufsize
+    if medium_classes is not None:
+        params['medium_classes'] = medium_classes
 
     return client.call('iobuf_set_options', params)
 
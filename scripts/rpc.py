@@ -163,6 +163,38 @@ if __name__ == "__main__":
         'framework_get_reactors', help='Display list of all reactors')
     p.set_defaults(func=framework_get_reactors)
 
+    def framework_set_hybrid_polling(args):
+        rpc.app.framework_set_hybrid_polling(args.client,
+                                             enabled=not args.disable,
+                                             idle_iterations=args.idle_iterations,
+                                             min_sleep_us=args.min_sleep_us,
+                                             max_sleep_us=args.max_sleep_us)
+
+    p = subparsers.add_parser('framework_set_hybrid_polling',
+                              help='Let idle reactors sleep between polling iterations')
+    p.add_argument('-d', '--disable', action='store_true', help='Disable hybrid polling')
+    p.add_argument('-i', '--idle-iterations', type=int,
+                   help='Number of consecutive idle iterations before a reactor starts sleeping')
+    p.add_argument('--min-sleep-us', type=int, help='Length of the first sleep in microseconds')
+    p.add_argument('--max-sleep-us', type=int, help='Maximum length of a single sleep in microseconds')
+    p.set_defaults(func=framework_set_hybrid_polling)
+
+    def framework_set_watchdog(args):
+        rpc.app.framework_set_watchdog(args.client, budget_us=args.budget_us)
+
+    p = subparsers.add_parser('framework_set_watchdog',
+                              help='Report reactor iterations taking longer than the given budget')
+    p.add_argument('budget_us', type=int,
+                   help='Maximum length of a single reactor iteration in microseconds, 0 to disable')
+    p.set_defaults(func=framework_set_watchdog)
+
+    def framework_get_reactor_stalls(args):
+        print_dict(rpc.app.framework_get_reactor_stalls(args.client))
+
+    p = subparsers.add_parser('framework_get_reactor_stalls',
+                              help='Display stalls recently detected by the reactor watchdog')
+    p.set_defaults(func=framework_get_reactor_stalls)
+
     def framework_set_scheduler(args):
         rpc.app.framework_set_scheduler(args.client,
                                         name=args.name,
@@ -242,12 +274,18 @@ if __name__ == "__main__":
         print_json(rpc.bdev.bdev_compress_create(args.client,
                                                  base_bdev_name=args.base_bdev_name,
                                                  pm_path=args.pm_path,
-                                                 lb_size=args.lb_size))
+                                                 lb_size=args.lb_size,
+                                                 comp_algo=args.comp_algo,
+                                                 comp_level=args.comp_level))
 
     p = subparsers.add_parser('bdev_compress_create', help='Add a compress vbdev')
     p.add_argument('-b', '--base-bdev-name', help="Name of the base bdev")
     p.add_argument('-p', '--pm-path', help="Path to persistent memory")
     p.add_argument('-l', '--lb-size', help="Compressed vol logical block size (optional, if used must be 512 or 4096)", type=int)
+    p.add_argument('-c', '--comp-algo', help="Compression algorithm (optional, default: deflate)",
+                   choices=['deflate', 'lz4', 'zstd'])
+    p.add_argument('-L', '--comp-level', help="Compression level (optional, default: 0, the fastest level of the algorithm)",
+                   type=int)
     p.set_defaults(func=bdev_compress_create)
 
     def bdev_compress_delete(args):
@@ -2247,12 +2285,29 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
 
     def bdev_raid_set_options(args):
         rpc.bdev.bdev_raid_set_options(args.client,
-                                       process_window_size_kb=args.process_window_size_kb)
+                                       process_window_size_kb=args.process_window_size_kb,
+                                       bitmap_region_size_kb=args.bitmap_region_size_kb,
+                                       process_max_mbytes_per_sec=args.process_max_mbytes_per_sec,
+                                       process_max_ios_per_sec=args.process_max_ios_per_sec,
+                                       process_adaptive=args.process_adaptive,
+                                       raid5f_stripe_pool_max_kb=args.raid5f_stripe_pool_max_kb)
 
     p = subparsers.add_parser('bdev_raid_set_options',
                               help='Set options for bdev raid.')
     p.add_argument('-w', '--process-window-size-kb', type=int,
                    help="Background process (e.g. rebuild) window size in KiB")
+    p.add_argument('-b', '--bitmap-region-size-kb', type=int,
+                   help="Write-intent bitmap region size in KiB, 0 to disable the bitmap")
+    p.add_argument('-m', '--process-max-mbytes-per-sec', type=int,
+                   help="Background process bandwidth limit in MiB/s, 0 for unlimited")
+    p.add_argument('-i', '--process-max-ios-per-sec', type=int,
+                   help="Background process request rate limit, 0 for unlimited")
+    p.add_argument('-a', '--process-adaptive', action='store_true', default=None,
+                   help="Adjust background processes to the load of the base bdevs")
+    p.add_argument('-A', '--no-process-adaptive', dest='process_adaptive', action='store_false',
+                   help="Disable the adaptive background process mode")
+    p.add_argument('-s', '--raid5f-stripe-pool-max-kb', type=int,
+                   help="Memory limit for the stripe requests of a raid5f channel in KiB, 0 for unlimited")
 
     p.set_defaults(func=bdev_raid_set_options)
 
@@ -2284,7 +2339,7 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p = subparsers.add_parser('bdev_raid_create', help='Create new raid bdev')
     p.add_argument('-n', '--name', help='raid bdev name', required=True)
     p.add_argument('-z', '--strip-size-kb', help='strip size in KB', type=int)
-    p.add_argument('-r', '--raid-level', help='raid level, raid0, raid1 and a special level concat are supported', required=True)
+    p.add_argument('-r', '--raid-level', help='raid level, raid0, raid1, raid10 and a special level concat are supported', required=True)
     p.add_argument('-b', '--base-bdevs', help='base bdevs name, whitespace separated list in quotes', required=True)
     p.add_argument('--uuid', help='UUID for this raid bdev')
     p.add_argument('-s', '--superblock', help='information about raid bdev will be stored in superblock on each base bdev, '
@@ -2314,6 +2369,50 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('name', help='base bdev name')
     p.set_defaults(func=bdev_raid_remove_base_bdev)
 
+    def bdev_raid_set_read_policy(args):
+        rpc.bdev.bdev_raid_set_read_policy(args.client,
+                                           name=args.name,
+                                           read_policy=args.read_policy,
+                                           hedge_percentile=args.hedge_percentile)
+    p = subparsers.add_parser('bdev_raid_set_read_policy', help='Set read policy of a raid bdev')
+    p.add_argument('name', help='raid bdev name')
+    p.add_argument('-p', '--read-policy', help='read policy',
+                   choices=['least_outstanding', 'latency', 'sequential'])
+    p.add_argument('-H', '--hedge-percentile', type=int,
+                   help='base bdev latency percentile after which a read is hedged, 0 to disable')
+    p.set_defaults(func=bdev_raid_set_read_policy)
+
+    def bdev_raid_reshape(args):
+        base_bdevs = None
+        if args.base_bdevs is not None:
+            base_bdevs = args.base_bdevs.strip().split()
+        rpc.bdev.bdev_raid_reshape(args.client,
+                                   name=args.name,
+                                   base_bdevs=base_bdevs)
+    p = subparsers.add_parser('bdev_raid_reshape', help='Add base bdevs to an online raid bdev')
+    p.add_argument('name', help='raid bdev name')
+    p.add_argument('-b', '--base-bdevs',
+                   help='base bdevs name, whitespace separated list in quotes; omit to resume a stopped reshape')
+    p.set_defaults(func=bdev_raid_reshape)
+
+    def bdev_raid_start_scrub(args):
+        rpc.bdev.bdev_raid_start_scrub(args.client,
+                                       name=args.name,
+                                       repair=args.repair)
+    p = subparsers.add_parser('bdev_raid_start_scrub',
+                              help='Verify the consistency of the mirrors or parity of a raid bdev in the background')
+    p.add_argument('name', help='raid bdev name')
+    p.add_argument('-n', '--no-repair', dest='repair', action='store_false',
+                   help="Only report the blocks that don't match or can't be read, don't rewrite them")
+    p.set_defaults(func=bdev_raid_start_scrub)
+
+    def bdev_raid_stop_scrub(args):
+        rpc.bdev.bdev_raid_stop_scrub(args.client,
+                                      name=args.name)
+    p = subparsers.add_parser('bdev_raid_stop_scrub', help='Stop the scrub of a raid bdev')
+    p.add_argument('name', help='raid bdev name')
+    p.set_defaults(func=bdev_raid_stop_scrub)
+
     # split
     def bdev_split_create(args):
         print_array(rpc.bdev.bdev_split_create(args.client,
@@ -3252,7 +3351,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
 
     def accel_set_options(args):
         rpc.accel.accel_set_options(args.client, args.small_cache_size, args.large_cache_size,
-                                    args.task_count, args.sequence_count, args.buf_count)
+                                    args.task_count, args.sequence_count, args.buf_count,
+                                    args.batch_count)
 
     p = subparsers.add_parser('accel_set_options', help='Set accel framework\'s options')
     p.add_argument('--small-cache-size', type=int, help='Size of the small iobuf cache')
@@ -3260,14 +3360,61 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('--task-count', type=int, help='Maximum number of tasks per IO channel')
     p.add_argument('--sequence-count', type=int, help='Maximum number of sequences per IO channel')
     p.add_argument('--buf-count', type=int, help='Maximum number of buffers per IO channel')
+    p.add_argument('--batch-count', type=int, help='Maximum number of batches per IO channel')
     p.set_defaults(func=accel_set_options)
 
+    def accel_sw_set_options(args):
+        rpc.accel.accel_sw_set_options(args.client, helper_threads=args.helper_threads,
+                                       offload_threshold=args.offload_threshold,
+                                       helper_cpumask=args.helper_cpumask)
+
+    p = subparsers.add_parser('accel_sw_set_options', help='Set software accel module\'s options')
+    p.add_argument('-t', '--helper-threads', type=int,
+                   help='Number of helper threads executing large tasks, 0 to disable')
+    p.add_argument('-s', '--offload-threshold', type=int,
+                   help='Size in bytes from which tasks are executed by the helper threads')
+    p.add_argument('-m', '--helper-cpumask', help='Cpumask of the helper threads')
+    p.set_defaults(func=accel_sw_set_options)
+
     def accel_get_stats(args):
         print_dict(rpc.accel.accel_get_stats(args.client))
 
     p = subparsers.add_parser('accel_get_stats', help='Display accel framework\'s statistics')
     p.set_defaults(func=accel_get_stats)
 
+    def accel_set_route_policy(args):
+        rpc.accel.accel_set_route_policy(args.client, telemetry=args.telemetry,
+                                         routing=args.routing, sw_max_size=args.sw_max_size,
+                                         max_queue_depth=args.max_queue_depth)
+
+    p = subparsers.add_parser('accel_set_route_policy',
+                              help='Configure accel framework\'s telemetry and routing engine')
+    p.set_defaults(telemetry=None, routing=None)
+    group = p.add_mutually_exclusive_group()
+    group.add_argument('-t', '--enable-telemetry', dest='telemetry', action='store_true',
+                       help='Measure the latency of the operations')
+    group.add_argument('-T', '--disable-telemetry', dest='telemetry', action='store_false',
+                       help='Stop measuring the latency of the operations')
+    group = p.add_mutually_exclusive_group()
+    group.add_argument('-r', '--enable-routing', dest='routing', action='store_true',
+                       help='Route operations to the software module based on their size and the '
+                       'queue depth of the assigned module')
+    group.add_argument('-R', '--disable-routing', dest='routing', action='store_false',
+                       help='Execute all operations by the module assigned to their opcode')
+    p.add_argument('-s', '--sw-max-size', type=int,
+                   help='Operations of at most this many bytes are executed in software, 0 to disable')
+    p.add_argument('-q', '--max-queue-depth', type=int,
+                   help='Queue depth of the assigned module from which operations are executed in '
+                   'software, 0 to disable')
+    p.set_defaults(func=accel_set_route_policy)
+
+    def accel_get_route_stats(args):
+        print_dict(rpc.accel.accel_get_route_stats(args.client))
+
+    p = subparsers.add_parser('accel_get_route_stats',
+                              help='Display accel framework\'s routing statistics')
+    p.set_defaults(func=accel_get_route_stats)
+
     # ioat
     def ioat_scan_accel_module(args):
         rpc.ioat.ioat_scan_accel_module(args.client)
@@ -3737,16 +3884,28 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.set_defaults(func=bdev_daos_resize)
 
     def iobuf_set_options(args):
+        medium_classes = None
+        if args.medium_classes is not None:
+            medium_classes = []
+            for medium_class in filter(None, args.medium_classes.split(',')):
+                fields = [int(field) for field in medium_class.split(':')]
+                medium_classes.append({'bufsize': fields[0], 'pool_count': fields[1]})
+                if len(fields) > 2:
+                    medium_classes[-1]['cache_size'] = fields[2]
         rpc.iobuf.iobuf_set_options(args.client,
                                     small_pool_count=args.small_pool_count,
                                     large_pool_count=args.large_pool_count,
                                     small_bufsize=args.small_bufsize,
-                                    large_bufsize=args.large_bufsize)
+                                    large_bufsize=args.large_bufsize,
+                                    medium_classes=medium_classes)
     p = subparsers.add_parser('iobuf_set_options', help='Set iobuf pool options')
     p.add_argument('--small-pool-count', help='number of small buffers in the global pool', type=int)
     p.add_argument('--large-pool-count', help='number of large buffers in the global pool', type=int)
     p.add_argument('--small-bufsize', help='size of a small buffer', type=int)
     p.add_argument('--large-bufsize', help='size of a large buffer', type=int)
+    p.add_argument('--medium-classes', help="""comma-separated list of bufsize:pool_count[:cache_size]
+    entries describing medium size classes between small and large buffers, in ascending order, e.g.
+    16384:4096:32,65536:1024. An empty string removes all medium size classes""")
     p.set_defaults(func=iobuf_set_options)
 
     def iobuf_get_stats(args):
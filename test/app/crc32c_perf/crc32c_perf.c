@@ -0,0 +1,176 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/crc32.h"
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+#if defined(__x86_64__) && defined(__SSE4_2__)
+#include <x86intrin.h>
+#define CRC32C_PERF_HAVE_SERIAL
+#define crc32c_serial_u64(crc, data) _mm_crc32_u64(crc, data)
+#define crc32c_serial_u8(crc, data) _mm_crc32_u8(crc, data)
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_PERF_HAVE_SERIAL
+#define crc32c_serial_u64(crc, data) __crc32cd(crc, data)
+#define crc32c_serial_u8(crc, data) __crc32cb(crc, data)
+#endif
+
+/*
+ * This application measures the throughput of spdk_crc32c_update() and spdk_crc32c_iov_update()
+ *  for a range of buffer sizes.  If the CPU has CRC32 instructions, it also reports the
+ *  throughput of a serial implementation executing them in a single dependency chain, as a
+ *  baseline for the interleaved implementation used by spdk_crc32c_update().
+ *
+ * Each buffer size is run for the specified amount of time and the throughput is reported in
+ *  MiB/s.
+ */
+
+#define CRC32C_PERF_IOV_SIZE 4096
+
+static const uint32_t g_sizes[] = { 512, 4096, 8192, 65536, 1024 * 1024 };
+static volatile uint32_t g_crc;
+
+typedef uint32_t (*crc32c_perf_fn)(void *buf, struct iovec *iovs, int iovcnt, uint32_t len,
+				   uint32_t crc);
+
+static void
+usage(const char *prog)
+{
+	printf("usage: %s [options]\n", prog);
+	printf("Options:\n");
+	printf("\t-t <sec>\ttime to run each buffer size for (default: 1)\n");
+	printf("\t-u <bytes>\tmisalign the buffer by this many bytes (default: 0)\n");
+}
+
+#ifdef CRC32C_PERF_HAVE_SERIAL
+static uint32_t
+crc32c_perf_serial(void *buf, struct iovec *iovs, int iovcnt, uint32_t len, uint32_t crc)
+{
+	const uint8_t *ptr = buf;
+	uint64_t crc64 = crc, data;
+
+	for (; len >= sizeof(data); len -= sizeof(data), ptr += sizeof(data)) {
+		memcpy(&data, ptr, sizeof(data));
+		crc64 = crc32c_serial_u64(crc64, data);
+	}
+
+	crc = (uint32_t)crc64;
+	for (; len > 0; len--, ptr++) {
+		crc = crc32c_serial_u8(crc, *ptr);
+	}
+
+	return crc;
+}
+#endif
+
+static uint32_t
+crc32c_perf_update(void *buf, struct iovec *iovs, int iovcnt, uint32_t len, uint32_t crc)
+{
+	return spdk_crc32c_update(buf, len, crc);
+}
+
+static uint32_t
+crc32c_perf_iov_update(void *buf, struct iovec *iovs, int iovcnt, uint32_t len, uint32_t crc)
+{
+	return spdk_crc32c_iov_update(iovs, iovcnt, crc);
+}
+
+static double
+run_test(crc32c_perf_fn fn, void *buf, uint32_t len, uint64_t run_ticks)
+{
+	struct iovec iovs[1024 * 1024 / CRC32C_PERF_IOV_SIZE];
+	uint64_t start, end, count = 0;
+	uint32_t crc = ~0u, i;
+	int iovcnt;
+
+	for (i = 0, iovcnt = 0; i < len; i += CRC32C_PERF_IOV_SIZE, iovcnt++) {
+		iovs[iovcnt].iov_base = (uint8_t *)buf + i;
+		iovs[iovcnt].iov_len = spdk_min(len - i, CRC32C_PERF_IOV_SIZE);
+	}
+
+	start = spdk_get_ticks();
+	do {
+		crc = fn(buf, iovs, iovcnt, len, crc);
+		count++;
+		end = spdk_get_ticks();
+	} while (end - start < run_ticks);
+
+	/* Make sure the calculation isn't optimized out */
+	g_crc = crc;
+
+	return (double)count * len / (1024 * 1024) / ((double)(end - start) / spdk_get_ticks_hz());
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_env_opts opts;
+	void *buf;
+	uint8_t *data;
+	uint32_t i;
+	long misalign = 0, run_time = 1;
+	uint64_t run_ticks;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "t:u:")) != -1) {
+		switch (ch) {
+		case 't':
+			run_time = spdk_strtol(optarg, 10);
+			break;
+		case 'u':
+			misalign = spdk_strtol(optarg, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (run_time <= 0 || misalign < 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	spdk_env_opts_init(&opts);
+	opts.name = "crc32c_perf";
+	if (spdk_env_init(&opts)) {
+		printf("Err: Unable to initialize SPDK env\n");
+		return 1;
+	}
+
+	buf = malloc(g_sizes[SPDK_COUNTOF(g_sizes) - 1] + misalign);
+	if (buf == NULL) {
+		printf("Err: Unable to allocate buffer\n");
+		spdk_env_fini();
+		return 1;
+	}
+
+	data = (uint8_t *)buf + misalign;
+	for (i = 0; i < g_sizes[SPDK_COUNTOF(g_sizes) - 1]; i++) {
+		data[i] = rand();
+	}
+
+	run_ticks = run_time * spdk_get_ticks_hz();
+	printf("%10s %14s %14s %14s\n", "size", "serial (MiB/s)", "update (MiB/s)", "iov (MiB/s)");
+	for (i = 0; i < SPDK_COUNTOF(g_sizes); i++) {
+		printf("%10" PRIu32, g_sizes[i]);
+#ifdef CRC32C_PERF_HAVE_SERIAL
+		printf(" %14.2f", run_test(crc32c_perf_serial, data, g_sizes[i], run_ticks));
+#else
+		printf(" %14s", "n/a");
+#endif
+		printf(" %14.2f", run_test(crc32c_perf_update, data, g_sizes[i], run_ticks));
+		printf(" %14.2f\n", run_test(crc32c_perf_iov_update, data, g_sizes[i], run_ticks));
+	}
+
+	free(buf);
+	spdk_env_fini();
+	return 0;
+}
@@ -0,0 +1,185 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/dif.h"
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+/*
+ * This application measures the throughput of generating and verifying DIF (interleaved
+ *  metadata) and DIX (separate metadata) for a set of common formats.  Each operation is run for
+ *  the specified amount of time and the throughput of the data portion is reported in MiB/s.
+ */
+
+#define DIF_PERF_DATA_SIZE (1024 * 1024)
+
+struct dif_perf_format {
+	const char			*name;
+	uint32_t			data_block_size;
+	uint32_t			md_size;
+	enum spdk_dif_pi_format		pi_format;
+};
+
+static const struct dif_perf_format g_formats[] = {
+	{ "512+8 PI16", 512, 8, SPDK_DIF_PI_FORMAT_16 },
+	{ "4096+8 PI16", 4096, 8, SPDK_DIF_PI_FORMAT_16 },
+	{ "4096+16 PI32", 4096, 16, SPDK_DIF_PI_FORMAT_32 },
+	{ "4096+16 PI64", 4096, 16, SPDK_DIF_PI_FORMAT_64 },
+};
+
+enum dif_perf_op {
+	DIF_PERF_OP_DIF_GENERATE,
+	DIF_PERF_OP_DIF_VERIFY,
+	DIF_PERF_OP_DIX_GENERATE,
+	DIF_PERF_OP_DIX_VERIFY,
+	DIF_PERF_OP_COUNT,
+};
+
+static void
+usage(const char *prog)
+{
+	printf("usage: %s [options]\n", prog);
+	printf("Options:\n");
+	printf("\t-t <sec>\ttime to run each operation for (default: 1)\n");
+}
+
+static int
+run_op(enum dif_perf_op op, struct iovec *iov, struct iovec *md_iov, uint32_t num_blocks,
+       const struct spdk_dif_ctx *ctx)
+{
+	struct spdk_dif_error err_blk;
+
+	switch (op) {
+	case DIF_PERF_OP_DIF_GENERATE:
+		return spdk_dif_generate(iov, 1, num_blocks, ctx);
+	case DIF_PERF_OP_DIF_VERIFY:
+		return spdk_dif_verify(iov, 1, num_blocks, ctx, &err_blk);
+	case DIF_PERF_OP_DIX_GENERATE:
+		return spdk_dix_generate(iov, 1, md_iov, num_blocks, ctx);
+	case DIF_PERF_OP_DIX_VERIFY:
+		return spdk_dix_verify(iov, 1, md_iov, num_blocks, ctx, &err_blk);
+	default:
+		assert(0);
+		return -EINVAL;
+	}
+}
+
+static double
+run_test(const struct dif_perf_format *fmt, enum dif_perf_op op, uint8_t *buf, uint8_t *md_buf,
+	 uint64_t run_ticks)
+{
+	struct spdk_dif_ctx_init_ext_opts dif_opts;
+	struct spdk_dif_ctx ctx;
+	struct iovec iov, md_iov;
+	uint32_t num_blocks = DIF_PERF_DATA_SIZE / fmt->data_block_size;
+	uint64_t start, end, count = 0;
+	bool dix = op == DIF_PERF_OP_DIX_GENERATE || op == DIF_PERF_OP_DIX_VERIFY;
+	int rc;
+
+	dif_opts.size = SPDK_SIZEOF(&dif_opts, dif_pi_format);
+	dif_opts.dif_pi_format = fmt->pi_format;
+	rc = spdk_dif_ctx_init(&ctx, dix ? fmt->data_block_size : fmt->data_block_size + fmt->md_size,
+			       fmt->md_size, !dix, false, SPDK_DIF_TYPE1,
+			       SPDK_DIF_FLAGS_GUARD_CHECK | SPDK_DIF_FLAGS_APPTAG_CHECK |
+			       SPDK_DIF_FLAGS_REFTAG_CHECK, 0x12345678, 0xffff, 0x1234, 0, 0, &dif_opts);
+	if (rc != 0) {
+		return -1.0;
+	}
+
+	iov.iov_base = buf;
+	iov.iov_len = dix ? DIF_PERF_DATA_SIZE : (uint64_t)num_blocks * ctx.block_size;
+	md_iov.iov_base = md_buf;
+	md_iov.iov_len = (uint64_t)num_blocks * fmt->md_size;
+
+	/* Verification needs valid PI */
+	if (op == DIF_PERF_OP_DIF_VERIFY || op == DIF_PERF_OP_DIX_VERIFY) {
+		rc = run_op(op - 1, &iov, &md_iov, num_blocks, &ctx);
+		if (rc != 0) {
+			return -1.0;
+		}
+	}
+
+	start = spdk_get_ticks();
+	do {
+		rc = run_op(op, &iov, &md_iov, num_blocks, &ctx);
+		if (rc != 0) {
+			return -1.0;
+		}
+		count++;
+		end = spdk_get_ticks();
+	} while (end - start < run_ticks);
+
+	return (double)count * DIF_PERF_DATA_SIZE / (1024 * 1024) /
+	       ((double)(end - start) / spdk_get_ticks_hz());
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_env_opts opts;
+	uint8_t *buf, *md_buf;
+	uint32_t i, op;
+	long run_time = 1;
+	uint64_t run_ticks;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "t:")) != -1) {
+		switch (ch) {
+		case 't':
+			run_time = spdk_strtol(optarg, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (run_time <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	spdk_env_opts_init(&opts);
+	opts.name = "dif_perf";
+	if (spdk_env_init(&opts)) {
+		printf("Err: Unable to initialize SPDK env\n");
+		return 1;
+	}
+
+	/* Large enough for the data with interleaved metadata of any of the formats */
+	buf = malloc(DIF_PERF_DATA_SIZE * 2);
+	md_buf = malloc(DIF_PERF_DATA_SIZE);
+	if (buf == NULL || md_buf == NULL) {
+		printf("Err: Unable to allocate buffers\n");
+		free(buf);
+		free(md_buf);
+		spdk_env_fini();
+		return 1;
+	}
+
+	for (i = 0; i < DIF_PERF_DATA_SIZE * 2; i++) {
+		buf[i] = rand();
+	}
+
+	run_ticks = run_time * spdk_get_ticks_hz();
+	printf("%14s %14s %14s %14s %14s\n", "format", "DIF gen", "DIF verify", "DIX gen",
+	       "DIX verify");
+	for (i = 0; i < SPDK_COUNTOF(g_formats); i++) {
+		printf("%14s", g_formats[i].name);
+		for (op = 0; op < DIF_PERF_OP_COUNT; op++) {
+			printf(" %14.2f", run_test(&g_formats[i], op, buf, md_buf, run_ticks));
+		}
+		printf("\n");
+	}
+	printf("(MiB/s of data, negative values indicate an error)\n");
+
+	free(buf);
+	free(md_buf);
+	spdk_env_fini();
+	return 0;
+}
@@ -0,0 +1,289 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+/*
+ * This application compares regular (spdk_iovcpy()) and non-temporal (spdk_iovcpy_nt()) copies
+ *  for a range of copy sizes.  The copies stream through a pool of memory much larger than the
+ *  last level cache, similarly to bounce buffers being filled for many outstanding I/Os.
+ *
+ * While each copy runs, a second thread chases pointers through a working set sized to fit in
+ *  the last level cache, standing in for a co-running workload.  The average latency of its
+ *  accesses is reported next to the copy throughput: regular stores pull the copied data into
+ *  the cache and evict the working set, increasing the latency, while non-temporal stores
+ *  should leave it mostly untouched.
+ */
+
+#define IOVCPY_PERF_IOV_SIZE		4096
+#define IOVCPY_PERF_CACHE_LINE		64
+
+static const uint32_t g_sizes[] = { 4096, 65536, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+
+struct victim_node {
+	uint64_t	next;
+	uint8_t		pad[IOVCPY_PERF_CACHE_LINE - sizeof(uint64_t)];
+};
+
+static struct victim_node *g_victim_nodes;
+static uint64_t g_victim_count;
+static volatile uint64_t g_victim_accesses;
+static volatile bool g_victim_stop;
+static volatile uint64_t g_victim_sink;
+
+typedef size_t (*iovcpy_perf_fn)(struct iovec *siov, size_t siovcnt,
+				 struct iovec *diov, size_t diovcnt);
+
+static void
+usage(const char *prog)
+{
+	printf("usage: %s [options]\n", prog);
+	printf("Options:\n");
+	printf("\t-t <sec>\ttime to run each copy size for (default: 1)\n");
+	printf("\t-p <MiB>\tsize of the source and destination pools (default: 256)\n");
+	printf("\t-w <KiB>\tco-running workload's working set, 0 disables it (default: 4096)\n");
+}
+
+static void *
+victim_thread(void *arg)
+{
+	uint64_t idx = 0, i;
+
+	while (!g_victim_stop) {
+		for (i = 0; i < 1024; i++) {
+			idx = g_victim_nodes[idx].next;
+		}
+		__atomic_fetch_add(&g_victim_accesses, 1024, __ATOMIC_RELAXED);
+	}
+
+	/* Make sure the loads aren't optimized out */
+	g_victim_sink = idx;
+
+	return NULL;
+}
+
+static int
+victim_init(uint64_t working_set)
+{
+	uint64_t i, j, tmp;
+
+	g_victim_count = working_set / sizeof(struct victim_node);
+	if (g_victim_count < 2) {
+		return -EINVAL;
+	}
+
+	g_victim_nodes = calloc(g_victim_count, sizeof(struct victim_node));
+	if (g_victim_nodes == NULL) {
+		return -ENOMEM;
+	}
+
+	/* Build a single random cycle (Sattolo's algorithm) to defeat the hardware prefetchers */
+	for (i = 0; i < g_victim_count; i++) {
+		g_victim_nodes[i].next = i;
+	}
+	for (i = g_victim_count - 1; i > 0; i--) {
+		j = (uint64_t)rand() % i;
+		tmp = g_victim_nodes[i].next;
+		g_victim_nodes[i].next = g_victim_nodes[j].next;
+		g_victim_nodes[j].next = tmp;
+	}
+
+	return 0;
+}
+
+static size_t
+iovcpy_perf_regular(struct iovec *siov, size_t siovcnt, struct iovec *diov, size_t diovcnt)
+{
+	return spdk_iovcpy(siov, siovcnt, diov, diovcnt);
+}
+
+static size_t
+iovcpy_perf_nt(struct iovec *siov, size_t siovcnt, struct iovec *diov, size_t diovcnt)
+{
+	return spdk_iovcpy_nt(siov, siovcnt, diov, diovcnt);
+}
+
+static void
+fill_iovs(struct iovec *iovs, int *iovcnt, uint8_t *buf, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0, *iovcnt = 0; i < len; i += IOVCPY_PERF_IOV_SIZE, (*iovcnt)++) {
+		iovs[*iovcnt].iov_base = buf + i;
+		iovs[*iovcnt].iov_len = spdk_min(len - i, IOVCPY_PERF_IOV_SIZE);
+	}
+}
+
+static double
+run_test(iovcpy_perf_fn fn, uint8_t *src, uint8_t *dst, uint64_t pool_size, uint32_t len,
+	 uint64_t run_ticks, double *victim_ns)
+{
+	struct iovec siovs[4 * 1024 * 1024 / IOVCPY_PERF_IOV_SIZE];
+	struct iovec diovs[4 * 1024 * 1024 / IOVCPY_PERF_IOV_SIZE];
+	uint64_t start, end, count = 0, offset = 0, accesses;
+	int siovcnt, diovcnt;
+
+	accesses = g_victim_accesses;
+	start = spdk_get_ticks();
+	do {
+		/* Walk through the whole pool so that each copy touches memory outside the cache */
+		if (offset + len > pool_size) {
+			offset = 0;
+		}
+		fill_iovs(siovs, &siovcnt, src + offset, len);
+		fill_iovs(diovs, &diovcnt, dst + offset, len);
+		fn(siovs, siovcnt, diovs, diovcnt);
+		offset += len;
+		count++;
+		end = spdk_get_ticks();
+	} while (end - start < run_ticks);
+	accesses = g_victim_accesses - accesses;
+
+	if (accesses > 0) {
+		*victim_ns = (double)(end - start) * 1000 * 1000 * 1000 / spdk_get_ticks_hz() / accesses;
+	} else {
+		*victim_ns = 0;
+	}
+
+	return (double)count * len / (1024 * 1024) / ((double)(end - start) / spdk_get_ticks_hz());
+}
+
+static double
+run_idle(uint64_t run_ticks)
+{
+	uint64_t start, end, accesses;
+
+	accesses = g_victim_accesses;
+	start = spdk_get_ticks();
+	do {
+		usleep(1000);
+		end = spdk_get_ticks();
+	} while (end - start < run_ticks);
+	accesses = g_victim_accesses - accesses;
+
+	if (accesses == 0) {
+		return 0;
+	}
+
+	return (double)(end - start) * 1000 * 1000 * 1000 / spdk_get_ticks_hz() / accesses;
+}
+
+static void
+print_result(double mibs, double victim_ns, bool victim)
+{
+	printf(" %18.2f", mibs);
+	if (victim) {
+		printf(" %18.2f", victim_ns);
+	} else {
+		printf(" %18s", "n/a");
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_env_opts opts;
+	pthread_t victim;
+	uint8_t *src, *dst;
+	uint64_t run_ticks, pool_size, i;
+	long run_time = 1, pool_mib = 256, working_set_kib = 4096;
+	double mibs, victim_ns;
+	int ch, rc = 0;
+
+	while ((ch = getopt(argc, argv, "t:p:w:")) != -1) {
+		switch (ch) {
+		case 't':
+			run_time = spdk_strtol(optarg, 10);
+			break;
+		case 'p':
+			pool_mib = spdk_strtol(optarg, 10);
+			break;
+		case 'w':
+			working_set_kib = spdk_strtol(optarg, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	pool_size = (uint64_t)pool_mib * 1024 * 1024;
+	if (run_time <= 0 || working_set_kib < 0 || pool_mib <= 0 ||
+	    pool_size < g_sizes[SPDK_COUNTOF(g_sizes) - 1]) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	spdk_env_opts_init(&opts);
+	opts.name = "iovcpy_perf";
+	if (spdk_env_init(&opts)) {
+		printf("Err: Unable to initialize SPDK env\n");
+		return 1;
+	}
+
+	src = malloc(pool_size);
+	dst = malloc(pool_size);
+	if (src == NULL || dst == NULL) {
+		printf("Err: Unable to allocate buffers\n");
+		rc = 1;
+		goto exit;
+	}
+
+	for (i = 0; i < pool_size; i++) {
+		src[i] = rand();
+	}
+	memset(dst, 0, pool_size);
+
+	if (working_set_kib > 0) {
+		if (victim_init((uint64_t)working_set_kib * 1024) != 0) {
+			printf("Err: Unable to set up the co-running workload\n");
+			rc = 1;
+			goto exit;
+		}
+		if (pthread_create(&victim, NULL, victim_thread, NULL) != 0) {
+			printf("Err: Unable to start the co-running workload\n");
+			rc = 1;
+			goto exit;
+		}
+	}
+
+	/* Use the non-temporal path for every size, the threshold is what is being evaluated */
+	spdk_iov_set_nt_threshold(1);
+	run_ticks = run_time * spdk_get_ticks_hz();
+
+	if (working_set_kib > 0) {
+		printf("co-running workload: %ld KiB working set, %.2f ns/access when idle\n",
+		       working_set_kib, run_idle(run_ticks));
+	}
+	printf("%10s %18s %18s %18s %18s\n", "size", "iovcpy (MiB/s)", "ns/access",
+	       "iovcpy_nt (MiB/s)", "ns/access");
+	for (i = 0; i < SPDK_COUNTOF(g_sizes); i++) {
+		printf("%10" PRIu32, g_sizes[i]);
+		mibs = run_test(iovcpy_perf_regular, src, dst, pool_size, g_sizes[i], run_ticks,
+				&victim_ns);
+		print_result(mibs, victim_ns, working_set_kib > 0);
+		mibs = run_test(iovcpy_perf_nt, src, dst, pool_size, g_sizes[i], run_ticks,
+				&victim_ns);
+		print_result(mibs, victim_ns, working_set_kib > 0);
+		printf("\n");
+	}
+
+	if (working_set_kib > 0) {
+		g_victim_stop = true;
+		pthread_join(victim, NULL);
+	}
+
+exit:
+	spdk_iov_set_nt_threshold(SPDK_IOV_NT_THRESHOLD_DEFAULT);
+	free(g_victim_nodes);
+	free(dst);
+	free(src);
+	spdk_env_fini();
+	return rc;
+}
@@ -0,0 +1,134 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+#include "spdk/xor.h"
+
+/*
+ * This application measures the throughput of spdk_xor_gen() and spdk_xor_gen_pq() for a range of
+ *  source buffer counts and buffer sizes.  It can be used to measure the effect of changes to
+ *  the XOR implementation.
+ *
+ * Each combination is run for the specified amount of time and the throughput is reported in
+ *  MiB/s of source data processed.
+ */
+
+#define XOR_PERF_MAX_SRC 32
+
+static const uint32_t g_src_counts[] = { 2, 4, 8, 16, 32 };
+static const uint32_t g_sizes[] = { 4096, 65536, 1024 * 1024 };
+
+static void
+usage(const char *prog)
+{
+	printf("usage: %s [options]\n", prog);
+	printf("Options:\n");
+	printf("\t-t <sec>\ttime to run each combination for (default: 1)\n");
+	printf("\t-u <bytes>\tmisalign the buffers by this many bytes (default: 0)\n");
+}
+
+static double
+run_test(void **sources, uint32_t n, uint32_t size, void *p, void *q, uint64_t run_ticks)
+{
+	uint64_t start, end, count = 0;
+	int rc;
+
+	start = spdk_get_ticks();
+	do {
+		if (q != NULL) {
+			rc = spdk_xor_gen_pq(p, q, sources, n, size);
+		} else {
+			rc = spdk_xor_gen(p, sources, n, size);
+		}
+		if (rc != 0) {
+			fprintf(stderr, "XOR failed: %s\n", spdk_strerror(-rc));
+			return 0;
+		}
+		count++;
+		end = spdk_get_ticks();
+	} while (end - start < run_ticks);
+
+	return (double)count * n * size / (1024 * 1024) /
+	       ((double)(end - start) / spdk_get_ticks_hz());
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_env_opts opts;
+	void *bufs[XOR_PERF_MAX_SRC + 2], *sources[XOR_PERF_MAX_SRC];
+	uint32_t i, j, k;
+	long misalign = 0, run_time = 1;
+	uint64_t run_ticks;
+	size_t align, buf_size;
+	int ch;
+	int rc = 0;
+
+	while ((ch = getopt(argc, argv, "t:u:")) != -1) {
+		switch (ch) {
+		case 't':
+			run_time = spdk_strtol(optarg, 10);
+			break;
+		case 'u':
+			misalign = spdk_strtol(optarg, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (run_time <= 0 || misalign < 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	spdk_env_opts_init(&opts);
+	opts.name = "xor_perf";
+	if (spdk_env_init(&opts)) {
+		printf("Err: Unable to initialize SPDK env\n");
+		return 1;
+	}
+
+	align = spdk_xor_get_optimal_alignment();
+	buf_size = g_sizes[SPDK_COUNTOF(g_sizes) - 1] + misalign;
+	memset(bufs, 0, sizeof(bufs));
+	for (i = 0; i < SPDK_COUNTOF(bufs); i++) {
+		if (posix_memalign(&bufs[i], align, buf_size)) {
+			printf("Err: Unable to allocate buffers\n");
+			rc = 1;
+			goto out;
+		}
+		memset(bufs[i], i, buf_size);
+	}
+
+	for (i = 0; i < XOR_PERF_MAX_SRC; i++) {
+		sources[i] = (uint8_t *)bufs[i] + misalign;
+	}
+
+	run_ticks = run_time * spdk_get_ticks_hz();
+	printf("%8s %10s %14s %14s\n", "sources", "size", "xor (MiB/s)", "pq (MiB/s)");
+	for (j = 0; j < SPDK_COUNTOF(g_src_counts); j++) {
+		for (k = 0; k < SPDK_COUNTOF(g_sizes); k++) {
+			printf("%8" PRIu32 " %10" PRIu32 " %14.2f %14.2f\n", g_src_counts[j], g_sizes[k],
+			       run_test(sources, g_src_counts[j], g_sizes[k],
+					(uint8_t *)bufs[XOR_PERF_MAX_SRC] + misalign, NULL, run_ticks),
+			       run_test(sources, g_src_counts[j], g_sizes[k],
+					(uint8_t *)bufs[XOR_PERF_MAX_SRC] + misalign,
+					(uint8_t *)bufs[XOR_PERF_MAX_SRC + 1] + misalign, run_ticks));
+		}
+	}
+out:
+	for (i = 0; i < SPDK_COUNTOF(bufs); i++) {
+		free(bufs[i]);
+	}
+
+	spdk_env_fini();
+	return rc;
+}
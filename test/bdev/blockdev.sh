@@ -285,6 +285,16 @@ function setup_raid5f_conf() {
 	RPC
 }
 
+function setup_raid6f_conf() {
+	"$rpc_py" <<- RPC
+		bdev_malloc_create -b Malloc0 32 512
+		bdev_malloc_create -b Malloc1 32 512
+		bdev_malloc_create -b Malloc2 32 512
+		bdev_malloc_create -b Malloc3 32 512
+		bdev_raid_create -n raid6f -z 2 -r 6f -b "Malloc0 Malloc1 Malloc2 Malloc3"
+	RPC
+}
+
 function bdev_bounds() {
 	$testdir/bdevio/bdevio -w -s $PRE_RESERVED_MEM --json "$conf_file" "$env_ctx" &
 	bdevio_pid=$!
@@ -725,6 +735,9 @@ case "$test_type" in
 	raid5f)
 		setup_raid5f_conf
 		;;
+	raid6f)
+		setup_raid6f_conf
+		;;
 	xnvme)
 		setup_xnvme_conf
 		;;
@@ -23,6 +23,7 @@ DEFINE_STUB_V(spdk_memory_domain_set_invalidate, (struct spdk_memory_domain *dom
 		spdk_memory_domain_invalidate_data_cb invalidate_cb));
 DEFINE_STUB_V(spdk_memory_domain_set_translation, (struct spdk_memory_domain *domain,
 		spdk_memory_domain_translate_memory_cb translate_cb));
+DEFINE_STUB_V(spdk_pause, (void));
 
 int
 spdk_memory_domain_create(struct spdk_memory_domain **domain, enum spdk_dma_device_type type,
@@ -558,6 +559,48 @@ test_spdk_accel_submit_xor(void)
 	CU_ASSERT(expected_accel_task == &task);
 }
 
+static void
+test_spdk_accel_submit_pq_gen(void)
+{
+	const uint64_t nbytes = TEST_SUBMIT_SIZE;
+	uint8_t p[TEST_SUBMIT_SIZE] = {0};
+	uint8_t q[TEST_SUBMIT_SIZE] = {0};
+	uint8_t src1[TEST_SUBMIT_SIZE] = {0};
+	uint8_t src2[TEST_SUBMIT_SIZE] = {0};
+	void *sources[] = { src1, src2 };
+	uint32_t nsrcs = SPDK_COUNTOF(sources);
+	int rc;
+	struct spdk_accel_task task;
+	struct spdk_accel_task_aux_data task_aux;
+	struct spdk_accel_task *expected_accel_task = NULL;
+
+	STAILQ_INIT(&g_accel_ch->task_pool);
+	SLIST_INIT(&g_accel_ch->task_aux_data_pool);
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_pq_gen(g_ch, p, q, sources, nsrcs, nbytes, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+
+	STAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	SLIST_INSERT_HEAD(&g_accel_ch->task_aux_data_pool, &task_aux, link);
+
+	/* submission OK. */
+	rc = spdk_accel_submit_pq_gen(g_ch, p, q, sources, nsrcs, nbytes, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.nsrcs.srcs == sources);
+	CU_ASSERT(task.nsrcs.cnt == nsrcs);
+	CU_ASSERT(task.d.iovcnt == 1);
+	CU_ASSERT(task.d.iovs[0].iov_base == p);
+	CU_ASSERT(task.d.iovs[0].iov_len == nbytes);
+	CU_ASSERT(task.d2.iovcnt == 1);
+	CU_ASSERT(task.d2.iovs[0].iov_base == q);
+	CU_ASSERT(task.d2.iovs[0].iov_len == nbytes);
+	CU_ASSERT(task.op_code == SPDK_ACCEL_OPC_PQ_GEN);
+	expected_accel_task = STAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	STAILQ_REMOVE_HEAD(&g_sw_ch->tasks_to_complete, link);
+	CU_ASSERT(expected_accel_task == &task);
+}
+
 static void
 test_spdk_accel_module_find_by_name(void)
 {
@@ -1525,6 +1568,544 @@ test_sequence_reverse(void)
 }
 #endif
 
+static void
+ut_comp_algo_cb(void *cb_arg, int status)
+{
+	int *result = cb_arg;
+
+	*result = status;
+}
+
+static bool
+ut_comp_algo_supported(enum spdk_accel_comp_algo algo)
+{
+	switch (algo) {
+	case SPDK_ACCEL_COMP_ALGO_DEFLATE:
+#ifdef SPDK_CONFIG_ISAL
+		return true;
+#else
+		return false;
+#endif
+	case SPDK_ACCEL_COMP_ALGO_LZ4:
+#ifdef SPDK_CONFIG_LZ4
+		return true;
+#else
+		return false;
+#endif
+	case SPDK_ACCEL_COMP_ALGO_ZSTD:
+#ifdef SPDK_CONFIG_ZSTD
+		return true;
+#else
+		return false;
+#endif
+	default:
+		return false;
+	}
+}
+
+static void
+test_compress_algos(void)
+{
+	struct spdk_accel_module_if deflate_only = {}, *sw_module;
+	struct spdk_io_channel *ioch;
+	enum spdk_accel_comp_algo algo, found;
+	char data[8192], comp[8192 + 1024], decomp[8192];
+	struct iovec src_iovs[3], dst_iovs[2];
+	uint32_t min_level, max_level, level, comp_size, decomp_size, i;
+	int rc, result;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	for (i = 0; i < sizeof(data); i++) {
+		data[i] = (i / 64) % 7;
+	}
+
+	for (algo = 0; algo < SPDK_ACCEL_COMP_ALGO_LAST; algo++) {
+		SPDK_CU_ASSERT_FATAL(spdk_accel_get_comp_algo_name(algo) != NULL);
+		rc = spdk_accel_get_comp_algo_by_name(spdk_accel_get_comp_algo_name(algo), &found);
+		CU_ASSERT_EQUAL(rc, 0);
+		CU_ASSERT_EQUAL(found, algo);
+
+		rc = spdk_accel_get_compress_level_range(algo, &min_level, &max_level);
+		if (!ut_comp_algo_supported(algo)) {
+			CU_ASSERT_EQUAL(rc, -EINVAL);
+			rc = spdk_accel_submit_compress_ext(ioch, comp, sizeof(comp), src_iovs, 1, algo, 0,
+							    &comp_size, ut_comp_algo_cb, &result);
+			CU_ASSERT_EQUAL(rc, -EINVAL);
+			rc = spdk_accel_submit_decompress_ext(ioch, dst_iovs, 1, src_iovs, 1, algo,
+							      &decomp_size, ut_comp_algo_cb, &result);
+			CU_ASSERT_EQUAL(rc, -EINVAL);
+			continue;
+		}
+
+		CU_ASSERT_EQUAL(rc, 0);
+		CU_ASSERT(min_level <= max_level);
+
+		/* Levels out of range are rejected */
+		rc = spdk_accel_submit_compress_ext(ioch, comp, sizeof(comp), src_iovs, 1, algo,
+						    max_level + 1, &comp_size, ut_comp_algo_cb, &result);
+		CU_ASSERT_EQUAL(rc, -EINVAL);
+
+		for (level = min_level; level <= max_level; level = level < max_level ? max_level : level + 1) {
+			/* Scattered source: 1000 + 3000 + 4192 bytes */
+			src_iovs[0].iov_base = data;
+			src_iovs[0].iov_len = 1000;
+			src_iovs[1].iov_base = data + 1000;
+			src_iovs[1].iov_len = 3000;
+			src_iovs[2].iov_base = data + 4000;
+			src_iovs[2].iov_len = sizeof(data) - 4000;
+			result = 1;
+			comp_size = 0;
+			rc = spdk_accel_submit_compress_ext(ioch, comp, sizeof(comp), src_iovs, 3, algo, level,
+							    &comp_size, ut_comp_algo_cb, &result);
+			CU_ASSERT_EQUAL(rc, 0);
+			poll_threads();
+			CU_ASSERT_EQUAL(result, 0);
+			CU_ASSERT(comp_size > 0 && comp_size < sizeof(data));
+
+			/* Scattered compressed data and destination */
+			src_iovs[0].iov_base = comp;
+			src_iovs[0].iov_len = comp_size / 2;
+			src_iovs[1].iov_base = comp + comp_size / 2;
+			src_iovs[1].iov_len = comp_size - comp_size / 2;
+			dst_iovs[0].iov_base = decomp;
+			dst_iovs[0].iov_len = 100;
+			dst_iovs[1].iov_base = decomp + 100;
+			dst_iovs[1].iov_len = sizeof(decomp) - 100;
+			memset(decomp, 0, sizeof(decomp));
+			result = 1;
+			decomp_size = 0;
+			rc = spdk_accel_submit_decompress_ext(ioch, dst_iovs, 2, src_iovs, 2, algo,
+							      &decomp_size, ut_comp_algo_cb, &result);
+			CU_ASSERT_EQUAL(rc, 0);
+			poll_threads();
+			CU_ASSERT_EQUAL(result, 0);
+			CU_ASSERT_EQUAL(decomp_size, sizeof(data));
+			CU_ASSERT_EQUAL(memcmp(decomp, data, sizeof(data)), 0);
+		}
+
+		/* Not enough space for the compressed data */
+		src_iovs[0].iov_base = data;
+		src_iovs[0].iov_len = sizeof(data);
+		result = 0;
+		rc = spdk_accel_submit_compress_ext(ioch, comp, 16, src_iovs, 1, algo, min_level,
+						    &comp_size, ut_comp_algo_cb, &result);
+		CU_ASSERT_EQUAL(rc, 0);
+		poll_threads();
+		CU_ASSERT_NOT_EQUAL(result, 0);
+	}
+
+	rc = spdk_accel_get_comp_algo_by_name("lzma", &found);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	CU_ASSERT_PTR_NULL(spdk_accel_get_comp_algo_name(SPDK_ACCEL_COMP_ALGO_LAST));
+
+	/* A module that doesn't report its algorithms only supports DEFLATE at level 0 */
+	sw_module = g_modules_opc[SPDK_ACCEL_OPC_COMPRESS].module;
+	g_modules_opc[SPDK_ACCEL_OPC_COMPRESS].module = &deflate_only;
+	rc = spdk_accel_get_compress_level_range(SPDK_ACCEL_COMP_ALGO_DEFLATE, &min_level, &max_level);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(min_level, 0);
+	CU_ASSERT_EQUAL(max_level, 0);
+	rc = spdk_accel_get_compress_level_range(SPDK_ACCEL_COMP_ALGO_LZ4, &min_level, &max_level);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	g_modules_opc[SPDK_ACCEL_OPC_COMPRESS].module = sw_module;
+
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
+static void
+ut_hash_digest(enum spdk_accel_hash_algo algo, const void *buf, size_t len, uint8_t *digest)
+{
+	switch (algo) {
+	case SPDK_ACCEL_HASH_ALGO_XXH64:
+		to_be64(digest, spdk_xxh64(buf, len, 0));
+		break;
+	case SPDK_ACCEL_HASH_ALGO_SHA256:
+		spdk_sha256(buf, len, digest);
+		break;
+	default:
+		CU_ASSERT(0);
+		break;
+	}
+}
+
+static void
+test_hash(void)
+{
+	struct spdk_accel_sequence *seq;
+	struct spdk_io_channel *ioch;
+	struct ut_sequence ut_seq;
+	enum spdk_accel_hash_algo algo, found;
+	uint8_t data[8192], tmp[8192], dst[8192];
+	uint8_t digest[SPDK_ACCEL_HASH_MAX_DIGEST_LEN], expected[SPDK_ACCEL_HASH_MAX_DIGEST_LEN];
+	struct iovec src_iovs[3], dst_iovs[1];
+	uint32_t i;
+	int rc, result, completed;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	for (i = 0; i < sizeof(data); i++) {
+		data[i] = (uint8_t)(i * 13);
+	}
+
+	CU_ASSERT_EQUAL(spdk_accel_get_hash_digest_len(SPDK_ACCEL_HASH_ALGO_XXH64), 8);
+	CU_ASSERT_EQUAL(spdk_accel_get_hash_digest_len(SPDK_ACCEL_HASH_ALGO_SHA256), 32);
+	CU_ASSERT_EQUAL(spdk_accel_get_hash_digest_len(SPDK_ACCEL_HASH_ALGO_LAST), 0);
+	CU_ASSERT_PTR_NULL(spdk_accel_get_hash_algo_name(SPDK_ACCEL_HASH_ALGO_LAST));
+	CU_ASSERT_EQUAL(spdk_accel_get_hash_algo_by_name("md5", &found), -EINVAL);
+
+	for (algo = 0; algo < SPDK_ACCEL_HASH_ALGO_LAST; algo++) {
+		SPDK_CU_ASSERT_FATAL(spdk_accel_get_hash_algo_name(algo) != NULL);
+		rc = spdk_accel_get_hash_algo_by_name(spdk_accel_get_hash_algo_name(algo), &found);
+		CU_ASSERT_EQUAL(rc, 0);
+		CU_ASSERT_EQUAL(found, algo);
+		ut_hash_digest(algo, data, sizeof(data), expected);
+
+		/* Scattered source: 1 + 4000 + 4191 bytes */
+		src_iovs[0].iov_base = data;
+		src_iovs[0].iov_len = 1;
+		src_iovs[1].iov_base = data + 1;
+		src_iovs[1].iov_len = 4000;
+		src_iovs[2].iov_base = data + 4001;
+		src_iovs[2].iov_len = sizeof(data) - 4001;
+		memset(digest, 0, sizeof(digest));
+		result = 1;
+		rc = spdk_accel_submit_hash(ioch, digest, src_iovs, 3, algo, ut_comp_algo_cb, &result);
+		CU_ASSERT_EQUAL(rc, 0);
+		poll_threads();
+		CU_ASSERT_EQUAL(result, 0);
+		CU_ASSERT_EQUAL(memcmp(digest, expected, spdk_accel_get_hash_digest_len(algo)), 0);
+
+		/* fill + hash + copy: the fill should be redirected to the copy's destination and
+		 * the hash calculated over it */
+		seq = NULL;
+		completed = 0;
+		memset(digest, 0, sizeof(digest));
+		memset(dst, 0, sizeof(dst));
+		memset(tmp, 0, sizeof(tmp));
+		memset(data, 0xa5, sizeof(data));
+		ut_hash_digest(algo, data, sizeof(data), expected);
+		rc = spdk_accel_append_fill(&seq, ioch, tmp, sizeof(tmp), NULL, NULL, 0xa5,
+					    ut_sequence_step_cb, &completed);
+		CU_ASSERT_EQUAL(rc, 0);
+		src_iovs[0].iov_base = tmp;
+		src_iovs[0].iov_len = sizeof(tmp);
+		rc = spdk_accel_append_hash(&seq, ioch, digest, &src_iovs[0], 1, NULL, NULL, algo,
+					    ut_sequence_step_cb, &completed);
+		CU_ASSERT_EQUAL(rc, 0);
+		src_iovs[1].iov_base = tmp;
+		src_iovs[1].iov_len = sizeof(tmp);
+		dst_iovs[0].iov_base = dst;
+		dst_iovs[0].iov_len = sizeof(dst);
+		rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+					    &src_iovs[1], 1, NULL, NULL, ut_sequence_step_cb, &completed);
+		CU_ASSERT_EQUAL(rc, 0);
+
+		ut_seq.complete = false;
+		spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+		poll_threads();
+		CU_ASSERT_EQUAL(completed, 3);
+		CU_ASSERT(ut_seq.complete);
+		CU_ASSERT_EQUAL(ut_seq.status, 0);
+		CU_ASSERT_EQUAL(memcmp(digest, expected, spdk_accel_get_hash_digest_len(algo)), 0);
+		CU_ASSERT_EQUAL(memcmp(dst, data, sizeof(dst)), 0);
+		/* The copy was elided, so the intermediate buffer wasn't touched */
+		CU_ASSERT(spdk_mem_all_zero(tmp, sizeof(tmp)));
+	}
+
+	/* Invalid algorithm */
+	rc = spdk_accel_submit_hash(ioch, digest, src_iovs, 1, SPDK_ACCEL_HASH_ALGO_LAST,
+				    ut_comp_algo_cb, &result);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	seq = NULL;
+	rc = spdk_accel_append_hash(&seq, ioch, digest, src_iovs, 1, NULL, NULL,
+				    SPDK_ACCEL_HASH_ALGO_LAST, ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	CU_ASSERT_PTR_NULL(seq);
+
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
+static void
+ut_batch_task_cb(void *cb_arg, int status)
+{
+	struct ut_sequence *task = cb_arg;
+
+	task->complete = true;
+	task->status = status;
+}
+
+static void
+test_batch(void)
+{
+	struct spdk_accel_batch *batch;
+	struct spdk_io_channel *ioch;
+	struct ut_sequence ut_batch, ut_tasks[4];
+	char src[4][4096], dst[4][4096], fill[4096];
+	uint32_t crc = 0;
+	int i, rc;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	for (i = 0; i < 4; i++) {
+		memset(src[i], 0xa0 + i, sizeof(src[i]));
+	}
+	memset(dst, 0, sizeof(dst));
+	memset(fill, 0, sizeof(fill));
+	memset(ut_tasks, 0, sizeof(ut_tasks));
+
+	/* Mix of copies, a fill without a completion callback and a crc32c */
+	batch = spdk_accel_batch_create(ioch);
+	SPDK_CU_ASSERT_FATAL(batch != NULL);
+	CU_ASSERT_PTR_NULL(spdk_accel_batch_create(ioch));
+	for (i = 0; i < 3; i++) {
+		rc = spdk_accel_submit_copy(ioch, dst[i], src[i], sizeof(src[i]), ut_batch_task_cb,
+					    &ut_tasks[i]);
+		CU_ASSERT_EQUAL(rc, 0);
+	}
+	rc = spdk_accel_submit_fill(ioch, fill, 0x5a, sizeof(fill), NULL, NULL);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_accel_submit_crc32c(ioch, &crc, src[3], 0, sizeof(src[3]), ut_batch_task_cb,
+				      &ut_tasks[3]);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* Nothing is executed until the batch is submitted */
+	poll_threads();
+	for (i = 0; i < 4; i++) {
+		CU_ASSERT(!ut_tasks[i].complete);
+	}
+	CU_ASSERT(spdk_mem_all_zero(dst, sizeof(dst)));
+	CU_ASSERT(spdk_mem_all_zero(fill, sizeof(fill)));
+
+	ut_batch.complete = false;
+	ut_batch.status = 1;
+	rc = spdk_accel_batch_submit(batch, ut_sequence_complete_cb, &ut_batch);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT(ut_batch.complete);
+	CU_ASSERT_EQUAL(ut_batch.status, 0);
+	for (i = 0; i < 4; i++) {
+		CU_ASSERT(ut_tasks[i].complete);
+		CU_ASSERT_EQUAL(ut_tasks[i].status, 0);
+	}
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT_EQUAL(memcmp(dst[i], src[i], sizeof(src[i])), 0);
+	}
+	memset(src[0], 0x5a, sizeof(src[0]));
+	CU_ASSERT_EQUAL(memcmp(fill, src[0], sizeof(fill)), 0);
+	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(src[3], sizeof(src[3]), ~0u));
+
+	/* Once a batch is submitted, operations are executed right away again */
+	memset(ut_tasks, 0, sizeof(ut_tasks));
+	memset(dst[0], 0, sizeof(dst[0]));
+	rc = spdk_accel_submit_copy(ioch, dst[0], src[1], sizeof(src[1]), ut_batch_task_cb,
+				    &ut_tasks[0]);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT(ut_tasks[0].complete);
+	CU_ASSERT_EQUAL(memcmp(dst[0], src[1], sizeof(src[1])), 0);
+
+	/* A failed operation fails the whole batch, but doesn't affect the other operations */
+	memset(ut_tasks, 0, sizeof(ut_tasks));
+	memset(dst[2], 0, sizeof(dst[2]));
+	batch = spdk_accel_batch_create(ioch);
+	SPDK_CU_ASSERT_FATAL(batch != NULL);
+	rc = spdk_accel_submit_compare(ioch, src[1], src[2], sizeof(src[1]), ut_batch_task_cb,
+				       &ut_tasks[0]);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_accel_submit_copy(ioch, dst[2], src[2], sizeof(src[2]), ut_batch_task_cb,
+				    &ut_tasks[1]);
+	CU_ASSERT_EQUAL(rc, 0);
+	ut_batch.complete = false;
+	rc = spdk_accel_batch_submit(batch, ut_sequence_complete_cb, &ut_batch);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT(ut_batch.complete);
+	CU_ASSERT(ut_tasks[0].complete);
+	CU_ASSERT_NOT_EQUAL(ut_tasks[0].status, 0);
+	CU_ASSERT_EQUAL(ut_batch.status, ut_tasks[0].status);
+	CU_ASSERT(ut_tasks[1].complete);
+	CU_ASSERT_EQUAL(ut_tasks[1].status, 0);
+	CU_ASSERT_EQUAL(memcmp(dst[2], src[2], sizeof(src[2])), 0);
+
+	/* An empty batch cannot be submitted, but can be aborted */
+	batch = spdk_accel_batch_create(ioch);
+	SPDK_CU_ASSERT_FATAL(batch != NULL);
+	rc = spdk_accel_batch_submit(batch, ut_sequence_complete_cb, &ut_batch);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	spdk_accel_batch_abort(batch);
+
+	/* Abort a batch with operations, none of them should be executed */
+	memset(ut_tasks, 0, sizeof(ut_tasks));
+	memset(dst, 0, sizeof(dst));
+	batch = spdk_accel_batch_create(ioch);
+	SPDK_CU_ASSERT_FATAL(batch != NULL);
+	for (i = 0; i < 2; i++) {
+		rc = spdk_accel_submit_copy(ioch, dst[i], src[i], sizeof(src[i]), ut_batch_task_cb,
+					    &ut_tasks[i]);
+		CU_ASSERT_EQUAL(rc, 0);
+	}
+	rc = spdk_accel_submit_copy(ioch, dst[2], src[2], sizeof(src[2]), NULL, NULL);
+	CU_ASSERT_EQUAL(rc, 0);
+	ut_batch.complete = false;
+	spdk_accel_batch_abort(batch);
+	poll_threads();
+	for (i = 0; i < 2; i++) {
+		CU_ASSERT(ut_tasks[i].complete);
+		CU_ASSERT_EQUAL(ut_tasks[i].status, -ECANCELED);
+	}
+	CU_ASSERT(!ut_batch.complete);
+	CU_ASSERT(spdk_mem_all_zero(dst, sizeof(dst)));
+
+	/* The channel's batch objects are all returned to the pool */
+	batch = spdk_accel_batch_create(ioch);
+	SPDK_CU_ASSERT_FATAL(batch != NULL);
+	spdk_accel_batch_abort(batch);
+
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
+static struct spdk_accel_task *g_route_pending_task;
+
+static int
+ut_route_submit_pending(struct spdk_io_channel *ch, struct spdk_accel_task *task)
+{
+	CU_ASSERT_PTR_NULL(g_route_pending_task);
+	g_route_pending_task = task;
+
+	return 0;
+}
+
+static void
+test_route_policy(void)
+{
+	struct spdk_io_channel *ioch;
+	struct accel_io_channel *accel_ch;
+	struct accel_opcode_route_stats *stats;
+	struct accel_route_opts opts = {}, orig_opts;
+	struct accel_module modules[SPDK_ACCEL_OPC_LAST];
+	char src[8192], dst[8192];
+	uint64_t histogram_total;
+	int i, rc, result;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+	accel_ch = spdk_io_channel_get_ctx(ioch);
+	SPDK_CU_ASSERT_FATAL(accel_ch->sw_ch != NULL);
+	stats = &accel_ch->stats.routing[SPDK_ACCEL_OPC_COPY];
+	memset(stats, 0, sizeof(*stats));
+	accel_get_route_opts(&orig_opts);
+
+	/* Assign a "hardware" module to all opcodes */
+	g_module_if.submit_tasks = ut_sequnce_submit_tasks;
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		modules[i] = g_modules_opc[i];
+		g_modules_opc[i] = g_module;
+	}
+	ut_clear_operations();
+	memset(src, 0xa5, sizeof(src));
+
+	/* Routing requires at least one of the thresholds */
+	opts.routing = true;
+	rc = accel_set_route_opts(&opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+
+	/* Telemetry only: everything goes to the assigned module */
+	opts.telemetry = true;
+	opts.routing = false;
+	rc = accel_set_route_opts(&opts);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_accel_submit_copy(ioch, dst, src, 512, ut_comp_algo_cb, &result);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 1);
+	CU_ASSERT_EQUAL(stats->decisions.module, 1);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_MODULE].executed, 1);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_MODULE].queue_depth, 0);
+
+	/* Small operations are executed in software */
+	opts.routing = true;
+	opts.sw_max_size = 4096;
+	rc = accel_set_route_opts(&opts);
+	CU_ASSERT_EQUAL(rc, 0);
+	memset(dst, 0, sizeof(dst));
+	result = 1;
+	rc = spdk_accel_submit_copy(ioch, dst, src, 4096, ut_comp_algo_cb, &result);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT_EQUAL(result, 0);
+	CU_ASSERT_EQUAL(memcmp(dst, src, 4096), 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 1);
+	CU_ASSERT_EQUAL(stats->decisions.size, 1);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_SW].executed, 1);
+
+	/* Large ones are still executed by the module */
+	rc = spdk_accel_submit_copy(ioch, dst, src, 8192, ut_comp_algo_cb, &result);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 2);
+	CU_ASSERT_EQUAL(stats->decisions.module, 2);
+
+	/* Once the module's queue depth reaches the limit, operations are executed in software */
+	opts.sw_max_size = 0;
+	opts.max_queue_depth = 1;
+	rc = accel_set_route_opts(&opts);
+	CU_ASSERT_EQUAL(rc, 0);
+	g_seq_operations[SPDK_ACCEL_OPC_COPY].submit = ut_route_submit_pending;
+	rc = spdk_accel_submit_copy(ioch, dst, src, 8192, ut_comp_algo_cb, &result);
+	CU_ASSERT_EQUAL(rc, 0);
+	SPDK_CU_ASSERT_FATAL(g_route_pending_task != NULL);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_MODULE].queue_depth, 1);
+	memset(dst, 0, sizeof(dst));
+	result = 1;
+	rc = spdk_accel_submit_copy(ioch, dst, src, 8192, ut_comp_algo_cb, &result);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_SW].queue_depth, 1);
+	poll_threads();
+	CU_ASSERT_EQUAL(result, 0);
+	CU_ASSERT_EQUAL(memcmp(dst, src, sizeof(dst)), 0);
+	CU_ASSERT_EQUAL(stats->decisions.backlog, 1);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_SW].queue_depth, 0);
+	spdk_accel_task_complete(g_route_pending_task, 0);
+	g_route_pending_task = NULL;
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_MODULE].queue_depth, 0);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_MODULE].max_queue_depth, 1);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_MODULE].executed, 3);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_SW].executed, 2);
+
+	/* Each executed operation was accounted in the latency histogram */
+	for (i = 0; i < ACCEL_ROUTE_COUNT; ++i) {
+		histogram_total = 0;
+		for (rc = 0; rc < ACCEL_ROUTE_LATENCY_BUCKETS; ++rc) {
+			histogram_total += stats->routes[i].latency_histogram[rc];
+		}
+		CU_ASSERT_EQUAL(histogram_total, stats->routes[i].executed);
+	}
+
+	/* Operations submitted while tracking is disabled aren't accounted */
+	g_seq_operations[SPDK_ACCEL_OPC_COPY].submit = NULL;
+	rc = accel_set_route_opts(&orig_opts);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_accel_submit_copy(ioch, dst, src, 512, ut_comp_algo_cb, &result);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 4);
+	CU_ASSERT_EQUAL(stats->decisions.module, 3);
+
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		g_modules_opc[i] = modules[i];
+	}
+	ut_clear_operations();
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
 static void
 test_sequence_copy_elision(void)
 {
@@ -3875,6 +4456,8 @@ test_sequence_crc32(void)
 	struct spdk_io_channel *ioch;
 	struct ut_sequence ut_seq;
 	struct accel_module modules[SPDK_ACCEL_OPC_LAST];
+	struct spdk_accel_module_if fused_module = {};
+	struct accel_io_channel *accel_ch;
 	char buf[4096], tmp[3][4096];
 	struct iovec src_iovs[4], dst_iovs[4];
 	uint32_t crc, crc2;
@@ -3882,6 +4465,7 @@ test_sequence_crc32(void)
 
 	ioch = spdk_accel_get_io_channel();
 	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+	accel_ch = spdk_io_channel_get_ctx(ioch);
 
 	/* Override the submit_tasks function */
 	g_module_if.submit_tasks = ut_sequnce_submit_tasks;
@@ -3916,7 +4500,8 @@ test_sequence_crc32(void)
 	g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count = 0;
 
 	/* Now check copy+crc - This should not remove the copy. Otherwise the data does not
-	 * end up where the user expected it to be. */
+	 * end up where the user expected it to be.  Instead, both operations should be fused into
+	 * a single copy+crc operation. */
 	seq = NULL;
 	completed = 0;
 	crc = 0;
@@ -3945,14 +4530,15 @@ test_sequence_crc32(void)
 	CU_ASSERT_EQUAL(completed, 2);
 	CU_ASSERT(ut_seq.complete);
 	CU_ASSERT_EQUAL(ut_seq.status, 0);
-	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count, 1);
-	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY_CRC32C].count, 1);
 	CU_ASSERT_EQUAL(memcmp(buf, tmp[0], sizeof(buf)), 0);
 	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(buf, sizeof(buf), ~0u));
-	g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count = 0;
-	g_seq_operations[SPDK_ACCEL_OPC_COPY].count = 0;
+	CU_ASSERT_EQUAL(accel_ch->stats.sequence_fused, 1);
+	g_seq_operations[SPDK_ACCEL_OPC_COPY_CRC32C].count = 0;
 
-	/* Check crc+copy - Again, the copy cannot be removed. */
+	/* Check crc+copy - Again, the copy cannot be removed, but it can be fused with the crc. */
 	seq = NULL;
 	completed = 0;
 	crc = 0;
@@ -3977,16 +4563,92 @@ test_sequence_crc32(void)
 	ut_seq.complete = false;
 	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
 
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY_CRC32C].count, 1);
+	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(tmp[0], sizeof(tmp[0]), ~0u));
+	CU_ASSERT_EQUAL(memcmp(buf, tmp[0], sizeof(buf)), 0);
+	CU_ASSERT_EQUAL(accel_ch->stats.sequence_fused, 2);
+	g_seq_operations[SPDK_ACCEL_OPC_COPY_CRC32C].count = 0;
+
+	/* Operations shouldn't be fused if the fused operation is executed by a different module
+	 * than the crc */
+	g_modules_opc[SPDK_ACCEL_OPC_COPY_CRC32C].module = &fused_module;
+	seq = NULL;
+	completed = 0;
+	crc = 0;
+	memset(buf, 0, sizeof(buf));
+	memset(&tmp[0], 0x5a, sizeof(tmp[0]));
+
+	dst_iovs[0].iov_base = buf;
+	dst_iovs[0].iov_len = sizeof(buf);
+	src_iovs[0].iov_base = tmp[0];
+	src_iovs[0].iov_len = sizeof(tmp[0]);
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+				    &src_iovs[0], 1, NULL, NULL,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	src_iovs[1].iov_base = buf;
+	src_iovs[1].iov_len = sizeof(buf);
+	rc = spdk_accel_append_crc32c(&seq, ioch, &crc, &src_iovs[1], 1, NULL, NULL, 0,
+				      ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
 	poll_threads();
 	CU_ASSERT_EQUAL(completed, 2);
 	CU_ASSERT(ut_seq.complete);
 	CU_ASSERT_EQUAL(ut_seq.status, 0);
 	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count, 1);
 	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY_CRC32C].count, 0);
 	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(tmp[0], sizeof(tmp[0]), ~0u));
 	CU_ASSERT_EQUAL(memcmp(buf, tmp[0], sizeof(buf)), 0);
+	CU_ASSERT_EQUAL(accel_ch->stats.sequence_fused, 2);
 	g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count = 0;
 	g_seq_operations[SPDK_ACCEL_OPC_COPY].count = 0;
+	g_modules_opc[SPDK_ACCEL_OPC_COPY_CRC32C].module = &g_module_if;
+
+	/* Nor if the copy is executed by a different module */
+	fused_module.submit_tasks = g_module_if.submit_tasks;
+	g_modules_opc[SPDK_ACCEL_OPC_COPY].module = &fused_module;
+	seq = NULL;
+	completed = 0;
+	crc = 0;
+	memset(buf, 0, sizeof(buf));
+	memset(&tmp[0], 0x5a, sizeof(tmp[0]));
+
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+				    &src_iovs[0], 1, NULL, NULL,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_accel_append_crc32c(&seq, ioch, &crc, &src_iovs[1], 1, NULL, NULL, 0,
+				      ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY_CRC32C].count, 0);
+	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(tmp[0], sizeof(tmp[0]), ~0u));
+	CU_ASSERT_EQUAL(memcmp(buf, tmp[0], sizeof(buf)), 0);
+	CU_ASSERT_EQUAL(accel_ch->stats.sequence_fused, 2);
+	g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count = 0;
+	g_seq_operations[SPDK_ACCEL_OPC_COPY].count = 0;
+	g_modules_opc[SPDK_ACCEL_OPC_COPY].module = &g_module_if;
 
 	/* Check a sequence with an operation at the beginning that can have its buffer changed, two
 	 * crc operations and a copy at the end.  The copy should be removed and the dst buffer of
@@ -4101,6 +4763,147 @@ test_sequence_crc32(void)
 	poll_threads();
 }
 
+void *
+spdk_call_unaffinitized(void *cb(void *arg), void *arg)
+{
+	return cb(arg);
+}
+
+static void
+ut_sw_helper_done(void *cb_arg, int status)
+{
+	int *completed = cb_arg;
+
+	CU_ASSERT_EQUAL(status, 0);
+	__atomic_fetch_add(completed, 1, __ATOMIC_RELAXED);
+}
+
+static void
+test_sw_helper_offload(void)
+{
+	struct accel_sw_opts opts, orig_opts;
+	struct spdk_io_channel *ioch;
+	char src[8192], dst[8192], small_src[512], small_dst[512];
+	uint64_t tasks_executed;
+	uint32_t i;
+	int rc, completed = 0;
+
+	accel_sw_get_opts(&orig_opts);
+	opts = orig_opts;
+	opts.helper_threads = SW_ACCEL_MAX_HELPER_THREADS + 1;
+	rc = accel_sw_set_opts(&opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+
+	opts.helper_threads = 2;
+	opts.offload_threshold = 4096;
+	rc = accel_sw_set_opts(&opts);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = sw_accel_helpers_start();
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_sw_helpers.num_helpers, 2);
+
+	/* Options can't be changed once the helpers are running */
+	rc = accel_sw_set_opts(&orig_opts);
+	CU_ASSERT_EQUAL(rc, -EBUSY);
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	/* Large tasks are executed by the helpers, small ones inline */
+	memset(src, 0x5a, sizeof(src));
+	memset(dst, 0, sizeof(dst));
+	memset(small_src, 0xa5, sizeof(small_src));
+	memset(small_dst, 0, sizeof(small_dst));
+	rc = spdk_accel_submit_copy(ioch, dst, src, sizeof(dst), ut_sw_helper_done, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_accel_submit_copy(ioch, small_dst, small_src, sizeof(small_dst),
+				    ut_sw_helper_done, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	while (__atomic_load_n(&completed, __ATOMIC_RELAXED) != 2) {
+		poll_threads();
+	}
+
+	CU_ASSERT_EQUAL(memcmp(dst, src, sizeof(src)), 0);
+	CU_ASSERT_EQUAL(memcmp(small_dst, small_src, sizeof(small_src)), 0);
+
+	tasks_executed = 0;
+	for (i = 0; i < g_sw_helpers.num_helpers; i++) {
+		tasks_executed += g_sw_helpers.helpers[i].tasks_executed;
+	}
+	CU_ASSERT_EQUAL(tasks_executed, 1);
+
+	spdk_put_io_channel(ioch);
+	poll_threads();
+
+	sw_accel_helpers_stop();
+	CU_ASSERT_EQUAL(g_sw_helpers.num_helpers, 0);
+
+	rc = accel_sw_set_opts(&orig_opts);
+	CU_ASSERT_EQUAL(rc, 0);
+}
+
+static void
+test_sw_helper_drain(void)
+{
+	struct accel_sw_opts opts, orig_opts;
+	struct spdk_io_channel *ioch;
+	struct accel_io_channel *accel_ch;
+	struct sw_accel_io_channel *sw_ch;
+	struct sw_accel_helper_completions *completions;
+	struct spdk_accel_task *task;
+	struct sw_accel_task *sw_task;
+	int rc, completed = 0;
+
+	accel_sw_get_opts(&orig_opts);
+	opts = orig_opts;
+	opts.helper_threads = 1;
+	rc = accel_sw_set_opts(&opts);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = sw_accel_helpers_start();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+	accel_ch = spdk_io_channel_get_ctx(ioch);
+	task = STAILQ_FIRST(&accel_ch->task_pool);
+	SPDK_CU_ASSERT_FATAL(task != NULL);
+	STAILQ_REMOVE_HEAD(&accel_ch->task_pool, link);
+
+	sw_ch = calloc(1, sizeof(*sw_ch));
+	SPDK_CU_ASSERT_FATAL(sw_ch != NULL);
+	rc = sw_accel_create_cb(NULL, sw_ch);
+	CU_ASSERT_EQUAL(rc, 0);
+	completions = sw_ch->helper_completions;
+	SPDK_CU_ASSERT_FATAL(completions != NULL);
+
+	/* Destroy the channel while a helper thread still executes one of its tasks */
+	completions->outstanding = 1;
+	sw_accel_destroy_cb(NULL, sw_ch);
+	free(sw_ch);
+	CU_ASSERT(completions->drain_poller != NULL);
+	poll_threads();
+
+	/* The completion is still delivered, after which the completions are freed */
+	sw_task = SPDK_CONTAINEROF(task, struct sw_accel_task, task);
+	sw_task->completions = completions;
+	task->accel_ch = accel_ch;
+	task->cb_fn = ut_sw_helper_done;
+	task->cb_arg = &completed;
+	task->status = 0;
+	sw_accel_helper_complete(&sw_task, 1);
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 1);
+
+	spdk_put_io_channel(ioch);
+	poll_threads();
+
+	sw_accel_helpers_stop();
+	rc = accel_sw_set_opts(&orig_opts);
+	CU_ASSERT_EQUAL(rc, 0);
+}
+
 static int
 test_sequence_setup(void)
 {
@@ -4187,6 +4990,12 @@ main(int argc, char **argv)
 	CU_ADD_TEST(seq_suite, test_sequence_driver);
 	CU_ADD_TEST(seq_suite, test_sequence_same_iovs);
 	CU_ADD_TEST(seq_suite, test_sequence_crc32);
+	CU_ADD_TEST(seq_suite, test_sw_helper_offload);
+	CU_ADD_TEST(seq_suite, test_sw_helper_drain);
+	CU_ADD_TEST(seq_suite, test_compress_algos);
+	CU_ADD_TEST(seq_suite, test_hash);
+	CU_ADD_TEST(seq_suite, test_batch);
+	CU_ADD_TEST(seq_suite, test_route_policy);
 
 	suite = CU_add_suite("accel", test_setup, test_cleanup);
 	CU_ADD_TEST(suite, test_spdk_accel_task_complete);
@@ -4199,6 +5008,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_spdk_accel_submit_crc32cv);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_copy_crc32c);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_xor);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_pq_gen);
 	CU_ADD_TEST(suite, test_spdk_accel_module_find_by_name);
 	CU_ADD_TEST(suite, test_spdk_accel_module_register);
 
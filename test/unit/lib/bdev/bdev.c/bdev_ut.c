@@ -1222,6 +1222,7 @@ bdev_io_wait_test(void)
 	struct spdk_bdev_opts bdev_opts = {};
 	struct bdev_ut_io_wait_entry io_wait_entry;
 	struct bdev_ut_io_wait_entry io_wait_entry2;
+	struct spdk_obj_cache_stats cache_stats;
 	int rc;
 
 	spdk_bdev_get_opts(&bdev_opts, sizeof(bdev_opts));
@@ -1282,6 +1283,14 @@ bdev_io_wait_test(void)
 	stub_complete_io(4);
 	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
 
+	/* The cache keeps up to a batch on top of its size, so all 4 bdev_ios are cached now */
+	CU_ASSERT(spdk_bdev_get_io_cache_stats(io_ch, &cache_stats) == 4);
+	CU_ASSERT(cache_stats.gets == 6);
+	CU_ASSERT(cache_stats.puts == 6);
+	CU_ASSERT(cache_stats.refills == 1);
+	CU_ASSERT(cache_stats.returns == 0);
+	CU_ASSERT(cache_stats.starved == 1);
+
 	spdk_put_io_channel(io_ch);
 	spdk_bdev_close(desc);
 	free_bdev(bdev);
@@ -3198,6 +3207,47 @@ bdev_io_write_unit_split_test(void)
 	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
 	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_FAILED);
 
+	/* Partial write units are passed down if the bdev allows them, but unaligned I/O are
+	 * still split on write_unit_size boundaries */
+	bdev->allow_partial_write_unit = true;
+	g_io_done = false;
+
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 0, 31, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xF000, 31 * 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xF000, 0, 31, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_io_done == false);
+
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	stub_complete_io(1);
+	CU_ASSERT(g_io_done == true);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	g_io_done = false;
+
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 1, 31, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xF000, 31 * 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 32, 1, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)(0xF000 + 31 * 512), 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xF000, 1, 32, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_io_done == false);
+
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+	stub_complete_io(2);
+	CU_ASSERT(g_io_done == true);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	bdev->allow_partial_write_unit = false;
+
 	/* Write should fail if it needs to be split but there are not enough iovs to submit
 	 * an entire write unit */
 	bdev->write_unit_size = SPDK_COUNTOF(iov) / 2;
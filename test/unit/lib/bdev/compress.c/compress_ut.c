@@ -53,6 +53,10 @@ spdk_reduce_vol_readv(struct spdk_reduce_vol *vol, struct iovec *iov, int iovcnt
 DEFINE_STUB(spdk_accel_get_opc_module_name, int, (enum spdk_accel_opcode opcode,
 		const char **module_name), 0);
 DEFINE_STUB(spdk_accel_get_io_channel, struct spdk_io_channel *, (void), (void *)0xfeedbeef);
+DEFINE_STUB(spdk_accel_get_compress_level_range, int, (enum spdk_accel_comp_algo algo,
+		uint32_t *min_level, uint32_t *max_level), 0);
+DEFINE_STUB(spdk_accel_get_comp_algo_name, const char *, (enum spdk_accel_comp_algo algo),
+	    "deflate");
 DEFINE_STUB(spdk_bdev_get_aliases, const struct spdk_bdev_aliases_list *,
 	    (const struct spdk_bdev *bdev), NULL);
 DEFINE_STUB_V(spdk_bdev_module_list_add, (struct spdk_bdev_module *bdev_module));
@@ -177,18 +181,20 @@ spdk_bdev_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status sta
 }
 
 int
-spdk_accel_submit_compress(struct spdk_io_channel *ch, void *dst, uint64_t nbytes,
-			   struct iovec *src_iovs, size_t src_iovcnt, uint32_t *output_size,
-			   spdk_accel_completion_cb cb_fn, void *cb_arg)
+spdk_accel_submit_compress_ext(struct spdk_io_channel *ch, void *dst, uint64_t nbytes,
+			       struct iovec *src_iovs, size_t src_iovcnt,
+			       enum spdk_accel_comp_algo comp_algo, uint32_t comp_level,
+			       uint32_t *output_size, spdk_accel_completion_cb cb_fn, void *cb_arg)
 {
 
 	return 0;
 }
 
 int
-spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_iovs, size_t dst_iovcnt,
-			     struct iovec *src_iovs, size_t src_iovcnt, uint32_t *output_size,
-			     spdk_accel_completion_cb cb_fn, void *cb_arg)
+spdk_accel_submit_decompress_ext(struct spdk_io_channel *ch, struct iovec *dst_iovs,
+				 size_t dst_iovcnt, struct iovec *src_iovs, size_t src_iovcnt,
+				 enum spdk_accel_comp_algo decomp_algo, uint32_t *output_size,
+				 spdk_accel_completion_cb cb_fn, void *cb_arg)
 {
 
 	return 0;
@@ -58,6 +58,12 @@ bool g_bdev_io_defer_completion;
 TAILQ_HEAD(, spdk_bdev_io) g_deferred_ios = TAILQ_HEAD_INITIALIZER(g_deferred_ios);
 struct spdk_thread *g_app_thread;
 struct spdk_thread *g_latest_thread;
+uint8_t g_bitmap[RAID_BDEV_BITMAP_MAX_SIZE];
+uint32_t g_bitmap_writes;
+bool g_bitmap_io_defer_completion;
+uint64_t g_blocks_written;
+raid_bdev_bitmap_io_cb g_bitmap_io_cb;
+void *g_bitmap_io_cb_ctx;
 
 static int
 ut_raid_start(struct raid_bdev *raid_bdev)
@@ -84,6 +90,10 @@ ut_raid_submit_rw_request_defered_cb(struct spdk_bdev_io *bdev_io, bool success,
 static void
 ut_raid_submit_rw_request(struct raid_bdev_io *raid_io)
 {
+	if (raid_io->type == SPDK_BDEV_IO_TYPE_WRITE) {
+		g_blocks_written += raid_io->num_blocks;
+	}
+
 	if (g_bdev_io_defer_completion) {
 		struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
 
@@ -103,11 +113,20 @@ ut_raid_submit_null_payload_request(struct raid_bdev_io *raid_io)
 			      g_child_io_status_flag ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED);
 }
 
+/* Number of the following process requests completed as out of resources */
+static int g_ut_process_nomem;
+
 static void
 ut_raid_complete_process_request(void *ctx)
 {
 	struct raid_bdev_process_request *process_req = ctx;
 
+	if (g_ut_process_nomem > 0) {
+		g_ut_process_nomem--;
+		raid_bdev_process_request_complete(process_req, -ENOMEM);
+		return;
+	}
+
 	raid_bdev_process_request_complete(process_req, 0);
 }
 
@@ -124,6 +143,35 @@ ut_raid_submit_process_request(struct raid_bdev_process_request *process_req,
 	return process_req->num_blocks;
 }
 
+static int
+ut_raid_submit_scrub_request(struct raid_bdev_process_request *process_req,
+			     struct raid_bdev_io_channel *raid_ch)
+{
+	CU_ASSERT(process_req->scrub.iov.iov_base != NULL);
+	CU_ASSERT(process_req->scrub.iov.iov_len == process_req->iov.iov_len);
+
+	/* Report one inconsistent block per request */
+	process_req->scrub.mismatched_blocks = 1;
+	process_req->scrub.repaired_blocks = process_req->scrub.repair ? 1 : 0;
+
+	return ut_raid_submit_process_request(process_req, raid_ch);
+}
+
+static int
+ut_raid_reshape(struct raid_bdev *raid_bdev, uint64_t *blockcnt)
+{
+	*blockcnt = raid_bdev->bdev.blockcnt / raid_bdev->reshape.num_base_bdevs_old *
+		    raid_bdev->num_base_bdevs;
+
+	return 0;
+}
+
+static uint64_t
+ut_raid_reshape_window_size(struct raid_bdev *raid_bdev, uint64_t offset, uint64_t max_size)
+{
+	return spdk_min(max_size, raid_bdev->strip_size);
+}
+
 static struct raid_bdev_module g_ut_raid_module = {
 	.level = 123,
 	.base_bdevs_min = 1,
@@ -149,6 +197,7 @@ DEFINE_STUB_V(spdk_jsonrpc_end_result, (struct spdk_jsonrpc_request *request,
 DEFINE_STUB_V(spdk_jsonrpc_send_bool_response, (struct spdk_jsonrpc_request *request,
 		bool value));
 DEFINE_STUB(spdk_json_decode_string, int, (const struct spdk_json_val *val, void *out), 0);
+DEFINE_STUB(spdk_json_decode_uint8, int, (const struct spdk_json_val *val, void *out), 0);
 DEFINE_STUB(spdk_json_decode_uint32, int, (const struct spdk_json_val *val, void *out), 0);
 DEFINE_STUB(spdk_json_decode_uuid, int, (const struct spdk_json_val *val, void *out), 0);
 DEFINE_STUB(spdk_json_decode_array, int, (const struct spdk_json_val *values,
@@ -180,12 +229,9 @@ DEFINE_STUB(spdk_bdev_is_md_separate, bool, (const struct spdk_bdev *bdev), true
 DEFINE_STUB(spdk_bdev_get_dif_type, enum spdk_dif_type, (const struct spdk_bdev *bdev),
 	    SPDK_DIF_DISABLE);
 DEFINE_STUB(spdk_bdev_is_dif_head_of_md, bool, (const struct spdk_bdev *bdev), false);
-DEFINE_STUB(spdk_bdev_notify_blockcnt_change, int, (struct spdk_bdev *bdev, uint64_t size), 0);
 DEFINE_STUB(spdk_json_write_named_uuid, int, (struct spdk_json_write_ctx *w, const char *name,
 		const struct spdk_uuid *val), 0);
 DEFINE_STUB_V(raid_bdev_init_superblock, (struct raid_bdev *raid_bdev));
-DEFINE_STUB(raid_bdev_alloc_superblock, int, (struct raid_bdev *raid_bdev, uint32_t block_size), 0);
-DEFINE_STUB_V(raid_bdev_free_superblock, (struct raid_bdev *raid_bdev));
 DEFINE_STUB(spdk_bdev_readv_blocks_ext, int, (struct spdk_bdev_desc *desc,
 		struct spdk_io_channel *ch, struct iovec *iov, int iovcnt, uint64_t offset_blocks,
 		uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
@@ -216,6 +262,54 @@ raid_bdev_write_superblock(struct raid_bdev *raid_bdev, raid_bdev_write_sb_cb cb
 	cb(0, raid_bdev, cb_ctx);
 }
 
+int
+raid_bdev_alloc_superblock(struct raid_bdev *raid_bdev, uint32_t block_size)
+{
+	raid_bdev->sb = calloc(1, RAID_BDEV_SB_MAX_LENGTH);
+	if (raid_bdev->sb == NULL) {
+		return -ENOMEM;
+	}
+	raid_bdev->sb->block_size = block_size;
+
+	return 0;
+}
+
+void
+raid_bdev_free_superblock(struct raid_bdev *raid_bdev)
+{
+	free(raid_bdev->sb);
+	raid_bdev->sb = NULL;
+}
+
+void
+raid_bdev_write_bitmap(struct raid_bdev *raid_bdev, const uint8_t *bitmap,
+		       raid_bdev_bitmap_io_cb cb, void *cb_ctx)
+{
+	SPDK_CU_ASSERT_FATAL(raid_bdev->sb->bitmap_size <= sizeof(g_bitmap));
+	memcpy(g_bitmap, bitmap, raid_bdev->sb->bitmap_size);
+	g_bitmap_writes++;
+
+	if (g_bitmap_io_defer_completion) {
+		g_bitmap_io_cb = cb;
+		g_bitmap_io_cb_ctx = cb_ctx;
+		return;
+	}
+	cb(0, raid_bdev, cb_ctx);
+}
+
+void
+raid_bdev_load_bitmap(struct raid_bdev *raid_bdev, uint8_t *bitmap,
+		      raid_bdev_bitmap_io_cb cb, void *cb_ctx)
+{
+	uint32_t i;
+
+	SPDK_CU_ASSERT_FATAL(raid_bdev->sb->bitmap_size <= sizeof(g_bitmap));
+	for (i = 0; i < raid_bdev->sb->bitmap_size; i++) {
+		bitmap[i] |= g_bitmap[i];
+	}
+	cb(0, raid_bdev, cb_ctx);
+}
+
 const struct spdk_uuid *
 spdk_bdev_get_uuid(const struct spdk_bdev *bdev)
 {
@@ -576,6 +670,14 @@ spdk_bdev_get_by_name(const char *bdev_name)
 	return NULL;
 }
 
+int
+spdk_bdev_notify_blockcnt_change(struct spdk_bdev *bdev, uint64_t size)
+{
+	bdev->blockcnt = size;
+
+	return 0;
+}
+
 int
 spdk_bdev_quiesce(struct spdk_bdev *bdev, struct spdk_bdev_module *module,
 		  spdk_bdev_quiesce_cb cb_fn, void *cb_arg)
@@ -1321,6 +1423,8 @@ test_raid_level_conversions(void)
 	CU_ASSERT(raid_bdev_str_to_level("0") == RAID0);
 	CU_ASSERT(raid_bdev_str_to_level("raid0") == RAID0);
 	CU_ASSERT(raid_bdev_str_to_level("RAID0") == RAID0);
+	CU_ASSERT(raid_bdev_str_to_level("10") == RAID10);
+	CU_ASSERT(raid_bdev_str_to_level("raid10") == RAID10);
 
 	raid_str = raid_bdev_level_to_str(INVALID_RAID_LEVEL);
 	CU_ASSERT(raid_str != NULL && strlen(raid_str) == 0);
@@ -1328,6 +1432,54 @@ test_raid_level_conversions(void)
 	CU_ASSERT(raid_str != NULL && strlen(raid_str) == 0);
 	raid_str = raid_bdev_level_to_str(RAID0);
 	CU_ASSERT(raid_str != NULL && strcmp(raid_str, "raid0") == 0);
+	raid_str = raid_bdev_level_to_str(RAID10);
+	CU_ASSERT(raid_str != NULL && strcmp(raid_str, "raid10") == 0);
+}
+
+static void
+test_raid_read_policy(void)
+{
+	struct rpc_bdev_raid_create req;
+	struct rpc_bdev_raid_delete delete_req;
+	struct raid_bdev *raid_bdev;
+	const char *str;
+
+	CU_ASSERT(raid_bdev_str_to_read_policy("abcd123") == RAID_READ_POLICY_MAX);
+	CU_ASSERT(raid_bdev_str_to_read_policy("latency") == RAID_READ_POLICY_LATENCY);
+	CU_ASSERT(raid_bdev_str_to_read_policy("SEQUENTIAL") == RAID_READ_POLICY_SEQUENTIAL);
+	str = raid_bdev_read_policy_to_str(RAID_READ_POLICY_MAX);
+	CU_ASSERT(str != NULL && strlen(str) == 0);
+	str = raid_bdev_read_policy_to_str(RAID_READ_POLICY_LEAST_OUTSTANDING);
+	CU_ASSERT(str != NULL && strcmp(str, "least_outstanding") == 0);
+
+	set_globals();
+	CU_ASSERT(raid_bdev_init() == 0);
+
+	create_raid_bdev_create_req(&req, "raid1", 0, true, 0, false);
+	rpc_bdev_raid_create(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	free_test_req(&req);
+	raid_bdev = raid_bdev_find_by_name("raid1");
+	SPDK_CU_ASSERT_FATAL(raid_bdev != NULL);
+
+	/* The module doesn't support read policies */
+	CU_ASSERT(raid_bdev_set_read_policy(raid_bdev, RAID_READ_POLICY_LATENCY, 0) == -ENOTSUP);
+	CU_ASSERT(raid_bdev->read_policy == RAID_READ_POLICY_LEAST_OUTSTANDING);
+
+	g_ut_raid_module.read_policy_supported = true;
+	CU_ASSERT(raid_bdev_set_read_policy(raid_bdev, RAID_READ_POLICY_MAX, 0) == -EINVAL);
+	CU_ASSERT(raid_bdev_set_read_policy(raid_bdev, RAID_READ_POLICY_LATENCY, 100) == -EINVAL);
+	CU_ASSERT(raid_bdev_set_read_policy(raid_bdev, RAID_READ_POLICY_LATENCY, 99) == 0);
+	CU_ASSERT(raid_bdev->read_policy == RAID_READ_POLICY_LATENCY);
+	CU_ASSERT(raid_bdev->read_hedge_percentile == 99);
+	g_ut_raid_module.read_policy_supported = false;
+
+	create_raid_bdev_delete_req(&delete_req, "raid1", 0);
+	rpc_bdev_raid_delete(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	raid_bdev_exit();
+	base_bdevs_cleanup();
+	reset_globals();
 }
 
 static void
@@ -1415,6 +1567,531 @@ test_raid_process(void)
 	reset_globals();
 }
 
+static struct spdk_bdev_io *
+_submit_bitmap_write(struct spdk_io_channel *ch, struct raid_bdev *raid_bdev, uint64_t lba,
+		     uint64_t blocks)
+{
+	struct spdk_bdev_io *bdev_io;
+
+	bdev_io = calloc(1, sizeof(struct spdk_bdev_io) + sizeof(struct raid_bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	_bdev_io_initialize(bdev_io, ch, &raid_bdev->bdev, lba, blocks, SPDK_BDEV_IO_TYPE_WRITE, 1,
+			    blocks * g_block_len);
+	g_io_comp_status = false;
+	raid_bdev_submit_request(ch, bdev_io);
+	poll_app_thread();
+
+	return bdev_io;
+}
+
+static void
+submit_bitmap_write(struct spdk_io_channel *ch, struct raid_bdev *raid_bdev, uint64_t lba,
+		    uint64_t blocks)
+{
+	bdev_io_cleanup(_submit_bitmap_write(ch, raid_bdev, lba, blocks));
+}
+
+static void
+poll_process_thread(struct spdk_thread *process_thread)
+{
+	while (spdk_thread_poll(process_thread, 0, 0) + spdk_thread_poll(g_app_thread, 0, 0) > 0) {
+	}
+}
+
+static void
+run_raid_process(struct raid_bdev *raid_bdev, enum raid_process_type type)
+{
+	struct spdk_thread *process_thread;
+
+	poll_app_thread();
+	SPDK_CU_ASSERT_FATAL(raid_bdev->process != NULL);
+	CU_ASSERT(raid_bdev->process->type == type);
+
+	process_thread = g_latest_thread;
+	spdk_thread_poll(process_thread, 0, 0);
+	SPDK_CU_ASSERT_FATAL(raid_bdev->process->thread == process_thread);
+
+	poll_process_thread(process_thread);
+
+	CU_ASSERT(raid_bdev->process == NULL);
+}
+
+static void
+test_raid_bitmap(void)
+{
+	struct rpc_bdev_raid_create req;
+	struct rpc_bdev_raid_delete destroy_req;
+	struct spdk_raid_bdev_opts opts, opts_orig;
+	struct raid_bdev *pbdev;
+	struct spdk_bdev *base_bdev;
+	struct spdk_io_channel *ch;
+	struct spdk_bdev_io *bdev_io;
+	struct raid_bdev_bitmap *bitmap;
+	uint64_t num_blocks_processed = 0;
+	uint32_t bitmap_writes;
+
+	set_globals();
+	CU_ASSERT(raid_bdev_init() == 0);
+
+	/* The bitmap is only used by levels with redundancy */
+	g_ut_raid_module.base_bdevs_constraint.type = CONSTRAINT_MAX_BASE_BDEVS_REMOVED;
+	g_ut_raid_module.base_bdevs_constraint.value = 1;
+	raid_bdev_get_opts(&opts_orig);
+	opts = opts_orig;
+	opts.bitmap_region_size_kb = g_strip_size * g_block_len / 1024;
+	CU_ASSERT(raid_bdev_set_opts(&opts) == 0);
+	memset(g_bitmap, 0xff, sizeof(g_bitmap));
+	g_bitmap_writes = 0;
+
+	create_raid_bdev_create_req(&req, "raid1", 0, true, 0, true);
+	verify_raid_bdev_present("raid1", false);
+	TAILQ_FOREACH(base_bdev, &g_bdev_list, internal.link) {
+		base_bdev->blockcnt = RAID_BDEV_MIN_DATA_OFFSET_SIZE / g_block_len + 16 * g_strip_size;
+	}
+	rpc_bdev_raid_create(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev(&req, true, RAID_BDEV_STATE_ONLINE);
+	free_test_req(&req);
+
+	TAILQ_FOREACH(pbdev, &g_raid_bdev_list, global_link) {
+		if (strcmp(pbdev->bdev.name, "raid1") == 0) {
+			break;
+		}
+	}
+	SPDK_CU_ASSERT_FATAL(pbdev != NULL);
+	bitmap = pbdev->bitmap;
+	SPDK_CU_ASSERT_FATAL(bitmap != NULL);
+	CU_ASSERT(pbdev->sb->bitmap_size == 2);
+	CU_ASSERT(pbdev->sb->bitmap_region_size == g_strip_size);
+	CU_ASSERT(bitmap->num_regions == 16);
+	CU_ASSERT(bitmap->needs_resync == false);
+	/* A clean bitmap is written when the raid bdev is created */
+	CU_ASSERT(g_bitmap_writes == 1);
+	CU_ASSERT(g_bitmap[0] == 0 && g_bitmap[1] == 0);
+
+	ch = spdk_get_io_channel(pbdev);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/* A write to a clean region must wait until the region is persisted as dirty */
+	g_bitmap_io_defer_completion = true;
+	bdev_io = _submit_bitmap_write(ch, pbdev, 0, 1);
+	CU_ASSERT(g_io_comp_status == false);
+	CU_ASSERT(g_bitmap_writes == 2);
+	CU_ASSERT(g_bitmap[0] == 0x01 && g_bitmap[1] == 0);
+	SPDK_CU_ASSERT_FATAL(g_bitmap_io_cb != NULL);
+	g_bitmap_io_cb(0, pbdev, g_bitmap_io_cb_ctx);
+	g_bitmap_io_cb = NULL;
+	poll_app_thread();
+	CU_ASSERT(g_io_comp_status == true);
+	bdev_io_cleanup(bdev_io);
+	g_bitmap_io_defer_completion = false;
+
+	/* Another write to the same region does not update the bitmap */
+	submit_bitmap_write(ch, pbdev, g_strip_size - 1, 1);
+	CU_ASSERT(g_io_comp_status == true);
+	CU_ASSERT(g_bitmap_writes == 2);
+
+	/* A write spanning two regions marks both */
+	submit_bitmap_write(ch, pbdev, 3 * g_strip_size - 1, 2);
+	CU_ASSERT(g_io_comp_status == true);
+	CU_ASSERT(g_bitmap_writes == 3);
+	CU_ASSERT(g_bitmap[0] == 0x0d && g_bitmap[1] == 0);
+
+	/* Regions are cleaned lazily, after a period without writes */
+	spdk_delay_us(RAID_BDEV_BITMAP_CLEAN_PERIOD_US);
+	poll_app_thread();
+	CU_ASSERT(g_bitmap_writes == 3);
+	CU_ASSERT(spdk_bit_array_count_set(bitmap->dirty) == 3);
+	submit_bitmap_write(ch, pbdev, 2 * g_strip_size, 1);
+	spdk_delay_us(RAID_BDEV_BITMAP_CLEAN_PERIOD_US);
+	poll_app_thread();
+	CU_ASSERT(g_bitmap_writes == 4);
+	CU_ASSERT(g_bitmap[0] == 0x04 && g_bitmap[1] == 0);
+	spdk_delay_us(RAID_BDEV_BITMAP_CLEAN_PERIOD_US);
+	poll_app_thread();
+	CU_ASSERT(g_bitmap_writes == 5);
+	CU_ASSERT(g_bitmap[0] == 0 && g_bitmap[1] == 0);
+
+	/* A partial rebuild only processes the dirty regions */
+	submit_bitmap_write(ch, pbdev, 5 * g_strip_size, g_strip_size + 1);
+	submit_bitmap_write(ch, pbdev, 15 * g_strip_size + 1, 1);
+	CU_ASSERT(g_bitmap[0] == 0x60 && g_bitmap[1] == 0x80);
+	/* The rebuild target is already open in the channels, don't let the rebuild replace it */
+	spdk_put_io_channel(ch);
+	poll_app_thread();
+	pbdev->module_private = &num_blocks_processed;
+	pbdev->min_base_bdevs_operational = 0;
+	pbdev->base_bdev_info[0].partial_rebuild = true;
+	CU_ASSERT(raid_bdev_start_rebuild(&pbdev->base_bdev_info[0]) == 0);
+	CU_ASSERT(pbdev->base_bdev_info[0].partial_rebuild == false);
+	run_raid_process(pbdev, RAID_PROCESS_REBUILD);
+	CU_ASSERT(num_blocks_processed == 3 * g_strip_size);
+	ch = spdk_get_io_channel(pbdev);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/* Dirty regions left after an unclean shutdown are resynchronized */
+	num_blocks_processed = 0;
+	g_blocks_written = 0;
+	bitmap->needs_resync = true;
+	spdk_delay_us(RAID_BDEV_BITMAP_CLEAN_PERIOD_US);
+	poll_app_thread();
+	run_raid_process(pbdev, RAID_PROCESS_RESYNC);
+	CU_ASSERT(bitmap->needs_resync == false);
+	CU_ASSERT(num_blocks_processed == 0);
+	CU_ASSERT(g_blocks_written == 3 * g_strip_size);
+
+	spdk_put_io_channel(ch);
+	poll_app_thread();
+
+	/* The bitmap is left clean after a clean shutdown */
+	bitmap_writes = g_bitmap_writes;
+	create_raid_bdev_delete_req(&destroy_req, "raid1", 0);
+	rpc_bdev_raid_delete(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev_present("raid1", false);
+	CU_ASSERT(g_bitmap_writes == bitmap_writes + 1);
+	CU_ASSERT(g_bitmap[0] == 0 && g_bitmap[1] == 0);
+
+	CU_ASSERT(raid_bdev_set_opts(&opts_orig) == 0);
+	g_ut_raid_module.base_bdevs_constraint.type = CONSTRAINT_UNSET;
+	g_ut_raid_module.base_bdevs_constraint.value = 0;
+
+	raid_bdev_exit();
+	base_bdevs_cleanup();
+	reset_globals();
+}
+
+static void
+ut_reshape_cb(void *ctx, int status)
+{
+	*(int *)ctx = status;
+}
+
+static void
+test_raid_reshape(void)
+{
+	struct rpc_bdev_raid_create req;
+	struct rpc_bdev_raid_delete destroy_req;
+	struct raid_bdev *pbdev;
+	struct spdk_bdev *base_bdev;
+	char names[2][16];
+	const char *base_bdev_names[] = { names[0], names[1] };
+	uint64_t blockcnt;
+	uint8_t sb_base_bdevs_size;
+	int status;
+
+	set_globals();
+	CU_ASSERT(raid_bdev_init() == 0);
+
+	create_raid_bdev_create_req(&req, "raid1", 0, true, 0, true);
+	verify_raid_bdev_present("raid1", false);
+	create_base_bdevs(g_max_base_drives);
+	TAILQ_FOREACH(base_bdev, &g_bdev_list, internal.link) {
+		base_bdev->blockcnt = RAID_BDEV_MIN_DATA_OFFSET_SIZE / g_block_len + 16 * g_strip_size;
+	}
+	rpc_bdev_raid_create(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev(&req, true, RAID_BDEV_STATE_ONLINE);
+	free_test_req(&req);
+
+	TAILQ_FOREACH(pbdev, &g_raid_bdev_list, global_link) {
+		if (strcmp(pbdev->bdev.name, "raid1") == 0) {
+			break;
+		}
+	}
+	SPDK_CU_ASSERT_FATAL(pbdev != NULL);
+	sb_base_bdevs_size = pbdev->sb->base_bdevs_size;
+
+	snprintf(names[0], sizeof(names[0]), "Nvme%un1", g_max_base_drives);
+	snprintf(names[1], sizeof(names[1]), "Nvme%un1", g_max_base_drives + 1);
+
+	/* Only modules that implement it support adding base bdevs */
+	CU_ASSERT(raid_bdev_reshape(pbdev, base_bdev_names, 2, NULL, NULL) == -ENOTSUP);
+
+	g_ut_raid_module.reshape = ut_raid_reshape;
+	g_ut_raid_module.reshape_window_size = ut_raid_reshape_window_size;
+
+	/* There is no stopped reshape to resume */
+	CU_ASSERT(raid_bdev_reshape(pbdev, base_bdev_names, 0, NULL, NULL) == -EINVAL);
+
+	/* The added base bdevs must not be smaller than the existing ones */
+	base_bdev = spdk_bdev_get_by_name(names[1]);
+	SPDK_CU_ASSERT_FATAL(base_bdev != NULL);
+	base_bdev->blockcnt--;
+	status = 1;
+	CU_ASSERT(raid_bdev_reshape(pbdev, base_bdev_names, 2, ut_reshape_cb, &status) == 0);
+	poll_app_thread();
+	CU_ASSERT(status == -EINVAL);
+	CU_ASSERT(pbdev->num_base_bdevs == g_max_base_drives);
+	CU_ASSERT(pbdev->num_base_bdevs_discovered == g_max_base_drives);
+	CU_ASSERT(pbdev->reshape.num_base_bdevs_old == 0);
+	CU_ASSERT(pbdev->sb->base_bdevs_size == sb_base_bdevs_size);
+	base_bdev->blockcnt++;
+
+	/* The base bdevs are added and the data is moved to the new layout in the background */
+	blockcnt = pbdev->bdev.blockcnt;
+	g_blocks_written = 0;
+	status = 1;
+	CU_ASSERT(raid_bdev_reshape(pbdev, base_bdev_names, 2, ut_reshape_cb, &status) == 0);
+	CU_ASSERT(raid_bdev_reshape(pbdev, base_bdev_names, 2, NULL, NULL) == -EBUSY);
+	poll_app_thread();
+	CU_ASSERT(status == 0);
+	CU_ASSERT(pbdev->num_base_bdevs == g_max_base_drives + 2);
+	CU_ASSERT(pbdev->num_base_bdevs_discovered == g_max_base_drives + 2);
+	CU_ASSERT(pbdev->reshape.num_base_bdevs_old == g_max_base_drives);
+	CU_ASSERT(pbdev->reshape.restriping == true);
+	CU_ASSERT(pbdev->sb->num_base_bdevs == g_max_base_drives + 2);
+	CU_ASSERT(pbdev->sb->base_bdevs_size == sb_base_bdevs_size + 2);
+	CU_ASSERT(pbdev->sb->base_bdevs[sb_base_bdevs_size + 1].slot == g_max_base_drives + 1);
+	CU_ASSERT(pbdev->sb->reshape_num_base_bdevs == g_max_base_drives);
+	CU_ASSERT(pbdev->bdev.blockcnt == blockcnt);
+
+	run_raid_process(pbdev, RAID_PROCESS_RESHAPE);
+	CU_ASSERT(g_blocks_written == blockcnt);
+	CU_ASSERT(pbdev->bdev.blockcnt == blockcnt / g_max_base_drives * (g_max_base_drives + 2));
+	CU_ASSERT(pbdev->reshape.num_base_bdevs_old == 0);
+	CU_ASSERT(pbdev->reshape.restriping == false);
+	CU_ASSERT(pbdev->sb->raid_size == pbdev->bdev.blockcnt);
+	CU_ASSERT(pbdev->sb->reshape_num_base_bdevs == 0);
+	CU_ASSERT(pbdev->sb->reshape_offset == 0);
+
+	/* Without moving the data, the raid bdev is grown right away */
+	g_ut_raid_module.reshape_window_size = NULL;
+	snprintf(names[0], sizeof(names[0]), "Nvme%un1", g_max_base_drives + 2);
+	blockcnt = pbdev->bdev.blockcnt;
+	status = 1;
+	CU_ASSERT(raid_bdev_reshape(pbdev, base_bdev_names, 1, ut_reshape_cb, &status) == 0);
+	poll_app_thread();
+	CU_ASSERT(status == 0);
+	CU_ASSERT(pbdev->process == NULL);
+	CU_ASSERT(pbdev->num_base_bdevs == g_max_base_drives + 3);
+	CU_ASSERT(pbdev->reshape.num_base_bdevs_old == 0);
+	CU_ASSERT(pbdev->bdev.blockcnt == blockcnt / (g_max_base_drives + 2) * (g_max_base_drives + 3));
+	CU_ASSERT(pbdev->sb->num_base_bdevs == g_max_base_drives + 3);
+	CU_ASSERT(pbdev->sb->base_bdevs_size == sb_base_bdevs_size + 3);
+	CU_ASSERT(pbdev->sb->raid_size == pbdev->bdev.blockcnt);
+
+	g_ut_raid_module.reshape = NULL;
+
+	create_raid_bdev_delete_req(&destroy_req, "raid1", 0);
+	rpc_bdev_raid_delete(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev_present("raid1", false);
+
+	raid_bdev_exit();
+	base_bdevs_cleanup();
+	reset_globals();
+}
+
+static void
+test_raid_process_throttle(void)
+{
+	struct rpc_bdev_raid_create req;
+	struct rpc_bdev_raid_delete destroy_req;
+	struct spdk_raid_bdev_opts opts, opts_orig;
+	struct raid_bdev *pbdev;
+	struct spdk_bdev *base_bdev;
+	struct spdk_thread *process_thread;
+	uint64_t num_blocks_processed = 0;
+	uint64_t window_size;
+
+	set_globals();
+	CU_ASSERT(raid_bdev_init() == 0);
+
+	raid_bdev_get_opts(&opts_orig);
+	opts = opts_orig;
+	opts.process_max_mbytes_per_sec = 1;
+	opts.process_adaptive = true;
+	CU_ASSERT(raid_bdev_set_opts(&opts) == 0);
+	window_size = opts.process_window_size_kb * 1024 / g_block_len;
+
+	create_raid_bdev_create_req(&req, "raid1", 0, true, 0, false);
+	verify_raid_bdev_present("raid1", false);
+	TAILQ_FOREACH(base_bdev, &g_bdev_list, internal.link) {
+		base_bdev->blockcnt = 5 * window_size;
+	}
+	rpc_bdev_raid_create(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev(&req, true, RAID_BDEV_STATE_ONLINE);
+	free_test_req(&req);
+
+	TAILQ_FOREACH(pbdev, &g_raid_bdev_list, global_link) {
+		if (strcmp(pbdev->bdev.name, "raid1") == 0) {
+			break;
+		}
+	}
+	SPDK_CU_ASSERT_FATAL(pbdev != NULL);
+
+	pbdev->module_private = &num_blocks_processed;
+	pbdev->min_base_bdevs_operational = 0;
+
+	CU_ASSERT(raid_bdev_start_rebuild(&pbdev->base_bdev_info[0]) == 0);
+	poll_app_thread();
+	SPDK_CU_ASSERT_FATAL(pbdev->process != NULL);
+	process_thread = g_latest_thread;
+
+	/* The first window takes 1 MiB of the 1 MiB/s budget */
+	poll_process_thread(process_thread);
+	SPDK_CU_ASSERT_FATAL(pbdev->process != NULL);
+	CU_ASSERT(num_blocks_processed == window_size);
+	spdk_delay_us(500 * 1000);
+	poll_process_thread(process_thread);
+	CU_ASSERT(num_blocks_processed == window_size);
+
+	/* The window grows because the base bdevs' latency doesn't increase */
+	spdk_delay_us(500 * 1000);
+	poll_process_thread(process_thread);
+	SPDK_CU_ASSERT_FATAL(pbdev->process != NULL);
+	CU_ASSERT(pbdev->process->window_scale == 3);
+	CU_ASSERT(num_blocks_processed == 3 * window_size);
+
+	/* Changing the options doesn't affect the running process */
+	opts.process_max_mbytes_per_sec = 0;
+	CU_ASSERT(raid_bdev_set_opts(&opts) == 0);
+	CU_ASSERT(pbdev->process->max_mbytes_per_sec == 1);
+	spdk_delay_us(1000 * 1000);
+	poll_process_thread(process_thread);
+	CU_ASSERT(num_blocks_processed == 3 * window_size);
+	spdk_delay_us(1000 * 1000);
+	poll_process_thread(process_thread);
+	CU_ASSERT(pbdev->process == NULL);
+	CU_ASSERT(num_blocks_processed == pbdev->bdev.blockcnt);
+
+	/* A throttled process is stopped without waiting for the end of the throttling period */
+	opts.process_max_mbytes_per_sec = 1;
+	CU_ASSERT(raid_bdev_set_opts(&opts) == 0);
+	g_ut_raid_module.submit_scrub_request = ut_raid_submit_scrub_request;
+	num_blocks_processed = 0;
+	CU_ASSERT(raid_bdev_start_scrub(pbdev, false) == 0);
+	poll_app_thread();
+	SPDK_CU_ASSERT_FATAL(pbdev->process != NULL);
+	process_thread = g_latest_thread;
+	poll_process_thread(process_thread);
+	SPDK_CU_ASSERT_FATAL(pbdev->process != NULL);
+	CU_ASSERT(num_blocks_processed == window_size);
+	CU_ASSERT(raid_bdev_stop_scrub(pbdev) == 0);
+	poll_process_thread(process_thread);
+	CU_ASSERT(pbdev->process == NULL);
+	CU_ASSERT(num_blocks_processed == window_size);
+	CU_ASSERT(pbdev->scrub.status == -ECANCELED);
+	g_ut_raid_module.submit_scrub_request = NULL;
+
+	CU_ASSERT(raid_bdev_set_opts(&opts_orig) == 0);
+
+	create_raid_bdev_delete_req(&destroy_req, "raid1", 0);
+	rpc_bdev_raid_delete(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev_present("raid1", false);
+
+	raid_bdev_exit();
+	base_bdevs_cleanup();
+	reset_globals();
+}
+
+static void
+test_raid_scrub(void)
+{
+	struct rpc_bdev_raid_create req;
+	struct rpc_bdev_raid_delete destroy_req;
+	struct spdk_raid_bdev_opts opts;
+	struct raid_bdev *pbdev;
+	struct spdk_bdev *base_bdev;
+	uint64_t num_blocks_processed = 0;
+	uint64_t window_size;
+
+	set_globals();
+	CU_ASSERT(raid_bdev_init() == 0);
+
+	raid_bdev_get_opts(&opts);
+	window_size = opts.process_window_size_kb * 1024 / g_block_len;
+
+	create_raid_bdev_create_req(&req, "raid1", 0, true, 0, false);
+	verify_raid_bdev_present("raid1", false);
+	TAILQ_FOREACH(base_bdev, &g_bdev_list, internal.link) {
+		base_bdev->blockcnt = 5 * window_size;
+	}
+	rpc_bdev_raid_create(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev(&req, true, RAID_BDEV_STATE_ONLINE);
+	free_test_req(&req);
+
+	TAILQ_FOREACH(pbdev, &g_raid_bdev_list, global_link) {
+		if (strcmp(pbdev->bdev.name, "raid1") == 0) {
+			break;
+		}
+	}
+	SPDK_CU_ASSERT_FATAL(pbdev != NULL);
+	pbdev->module_private = &num_blocks_processed;
+
+	/* Not supported by the module */
+	CU_ASSERT(raid_bdev_start_scrub(pbdev, true) == -ENOTSUP);
+	CU_ASSERT(pbdev->scrub.started == false);
+
+	g_ut_raid_module.submit_scrub_request = ut_raid_submit_scrub_request;
+
+	/* Nothing to stop */
+	CU_ASSERT(raid_bdev_stop_scrub(pbdev) == -ENOENT);
+
+	/* Check only */
+	CU_ASSERT(raid_bdev_start_scrub(pbdev, false) == 0);
+	CU_ASSERT(raid_bdev_start_scrub(pbdev, false) == -EBUSY);
+	run_raid_process(pbdev, RAID_PROCESS_SCRUB);
+	CU_ASSERT(num_blocks_processed == pbdev->bdev.blockcnt);
+	CU_ASSERT(pbdev->scrub.started == true);
+	CU_ASSERT(pbdev->scrub.repair == false);
+	CU_ASSERT(pbdev->scrub.status == 0);
+	CU_ASSERT(pbdev->scrub.mismatched_blocks == 5);
+	CU_ASSERT(pbdev->scrub.read_error_blocks == 0);
+	CU_ASSERT(pbdev->scrub.repaired_blocks == 0);
+
+	/* The results are reset when a scrub is started again */
+	num_blocks_processed = 0;
+	CU_ASSERT(raid_bdev_start_scrub(pbdev, true) == 0);
+	run_raid_process(pbdev, RAID_PROCESS_SCRUB);
+	CU_ASSERT(num_blocks_processed == pbdev->bdev.blockcnt);
+	CU_ASSERT(pbdev->scrub.status == 0);
+	CU_ASSERT(pbdev->scrub.mismatched_blocks == 5);
+	CU_ASSERT(pbdev->scrub.repaired_blocks == 5);
+
+	/* Requests that run out of module resources are submitted again */
+	num_blocks_processed = 0;
+	g_ut_process_nomem = 3;
+	CU_ASSERT(raid_bdev_start_scrub(pbdev, true) == 0);
+	run_raid_process(pbdev, RAID_PROCESS_SCRUB);
+	CU_ASSERT(g_ut_process_nomem == 0);
+	CU_ASSERT(num_blocks_processed == pbdev->bdev.blockcnt + 3 * window_size);
+	CU_ASSERT(pbdev->scrub.status == 0);
+	CU_ASSERT(pbdev->scrub.mismatched_blocks == 5);
+	CU_ASSERT(pbdev->scrub.repaired_blocks == 5);
+
+	/* Stopped after the current window */
+	num_blocks_processed = 0;
+	CU_ASSERT(raid_bdev_start_scrub(pbdev, true) == 0);
+	poll_app_thread();
+	SPDK_CU_ASSERT_FATAL(pbdev->process != NULL);
+	CU_ASSERT(raid_bdev_stop_scrub(pbdev) == 0);
+	run_raid_process(pbdev, RAID_PROCESS_SCRUB);
+	CU_ASSERT(num_blocks_processed == window_size);
+	CU_ASSERT(pbdev->scrub.status == -ECANCELED);
+	CU_ASSERT(pbdev->scrub.mismatched_blocks == 1);
+
+	/* A degraded raid bdev can't be scrubbed */
+	pbdev->base_bdev_info[0].is_failed = true;
+	CU_ASSERT(raid_bdev_start_scrub(pbdev, true) == -ENODEV);
+	pbdev->base_bdev_info[0].is_failed = false;
+
+	g_ut_raid_module.submit_scrub_request = NULL;
+
+	create_raid_bdev_delete_req(&destroy_req, "raid1", 0);
+	rpc_bdev_raid_delete(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev_present("raid1", false);
+
+	raid_bdev_exit();
+	base_bdevs_cleanup();
+	reset_globals();
+}
+
 static void
 test_raid_io_split(void)
 {
@@ -1720,8 +2397,13 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_raid_json_dump_info);
 	CU_ADD_TEST(suite, test_context_size);
 	CU_ADD_TEST(suite, test_raid_level_conversions);
+	CU_ADD_TEST(suite, test_raid_read_policy);
 	CU_ADD_TEST(suite, test_raid_io_split);
 	CU_ADD_TEST(suite, test_raid_process);
+	CU_ADD_TEST(suite, test_raid_bitmap);
+	CU_ADD_TEST(suite, test_raid_process_throttle);
+	CU_ADD_TEST(suite, test_raid_reshape);
+	CU_ADD_TEST(suite, test_raid_scrub);
 
 	spdk_thread_lib_init(test_new_thread_fn, 0);
 	g_app_thread = spdk_thread_create("app_thread", NULL);
@@ -18,10 +18,15 @@ DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_i
 DEFINE_STUB(spdk_bdev_get_name, const char *, (const struct spdk_bdev *bdev), "test_bdev");
 DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), TEST_BUF_ALIGN);
 
+struct spdk_bdev_desc {
+	void *bitmap_buf;
+};
+
 void *g_buf;
 TAILQ_HEAD(, spdk_bdev_io) g_bdev_io_queue = TAILQ_HEAD_INITIALIZER(g_bdev_io_queue);
 int g_read_counter;
 int g_write_counter;
+uint64_t g_bitmap_offset;
 struct spdk_bdev g_bdev;
 struct spdk_bdev_io g_bdev_io = {
 	.bdev = &g_bdev,
@@ -159,6 +164,46 @@ spdk_bdev_write(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 	return 0;
 }
 
+int
+spdk_bdev_write_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
+		       uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
+	struct spdk_bdev_io *bdev_io;
+
+	g_write_counter++;
+	SPDK_CU_ASSERT_FATAL(desc != NULL && desc->bitmap_buf != NULL);
+	CU_ASSERT(offset_blocks == g_bitmap_offset);
+	memcpy(desc->bitmap_buf, buf, num_blocks * bdev->blocklen);
+
+	bdev_io = calloc(1, sizeof(*bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->internal.cb = cb;
+	bdev_io->internal.caller_ctx = cb_arg;
+	bdev_io->bdev = bdev;
+
+	TAILQ_INSERT_TAIL(&g_bdev_io_queue, bdev_io, internal.link);
+
+	return 0;
+}
+
+int
+spdk_bdev_read_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
+		      uint64_t offset_blocks, uint64_t num_blocks,
+		      spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
+
+	g_read_counter++;
+	SPDK_CU_ASSERT_FATAL(desc != NULL && desc->bitmap_buf != NULL);
+	CU_ASSERT(offset_blocks == g_bitmap_offset);
+	memcpy(buf, desc->bitmap_buf, num_blocks * bdev->blocklen);
+
+	cb(&g_bdev_io, true, cb_arg);
+	return 0;
+}
+
 static void
 process_io_completions(void)
 {
@@ -245,6 +290,116 @@ test_raid_bdev_write_superblock(void)
 	raid_bdev_free_superblock(&raid_bdev);
 }
 
+static void
+bitmap_io_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+{
+	int *status_out = ctx;
+
+	*status_out = status;
+}
+
+static void
+test_raid_bdev_write_load_bitmap(void)
+{
+	struct raid_base_bdev_info base_info[3] = {{0}};
+	struct spdk_bdev_desc desc[SPDK_COUNTOF(base_info)] = {{0}};
+	struct raid_bdev raid_bdev = {
+		.num_base_bdevs = SPDK_COUNTOF(base_info),
+		.base_bdev_info = base_info,
+		.bdev = g_bdev,
+	};
+	const uint32_t data_block_size = spdk_bdev_get_data_block_size(&g_bdev);
+	const uint32_t num_blocks = 3;
+	uint32_t bitmap_size, i, j;
+	uint8_t *bitmap, *bitmap_read;
+	int status;
+
+	for (i = 0; i < SPDK_COUNTOF(base_info); i++) {
+		base_info[i].raid_bdev = &raid_bdev;
+		base_info[i].desc = &desc[i];
+		/* The first base bdev is missing */
+		if (i > 0) {
+			base_info[i].is_configured = true;
+			desc[i].bitmap_buf = calloc(num_blocks, g_bdev.blocklen);
+			SPDK_CU_ASSERT_FATAL(desc[i].bitmap_buf != NULL);
+		}
+	}
+
+	status = raid_bdev_alloc_superblock(&raid_bdev, data_block_size);
+	CU_ASSERT(status == 0);
+	raid_bdev_init_superblock(&raid_bdev);
+
+	/* The bitmap does not fill the last block */
+	bitmap_size = data_block_size * (num_blocks - 1) + 3;
+	g_bitmap_offset = 8;
+	raid_bdev.sb->bitmap_size = bitmap_size;
+	raid_bdev.sb->bitmap_offset = g_bitmap_offset;
+
+	bitmap = calloc(1, bitmap_size);
+	bitmap_read = calloc(1, bitmap_size);
+	SPDK_CU_ASSERT_FATAL(bitmap != NULL && bitmap_read != NULL);
+	for (i = 0; i < bitmap_size; i++) {
+		bitmap[i] = i % 251;
+	}
+
+	/* The bitmap is written to all configured base bdevs, at data_block_size per block */
+	status = INT_MAX;
+	g_write_counter = 0;
+	raid_bdev_write_bitmap(&raid_bdev, bitmap, bitmap_io_cb, &status);
+	CU_ASSERT(g_write_counter == raid_bdev.num_base_bdevs - 1);
+	CU_ASSERT(status == INT_MAX);
+	process_io_completions();
+	CU_ASSERT(status == 0);
+	for (i = 1; i < SPDK_COUNTOF(base_info); i++) {
+		for (j = 0; j < num_blocks; j++) {
+			CU_ASSERT(memcmp(desc[i].bitmap_buf + j * g_bdev.blocklen, bitmap + j * data_block_size,
+					 spdk_min(data_block_size, bitmap_size - j * data_block_size)) == 0);
+		}
+	}
+
+	/* The bitmaps read from the base bdevs are merged */
+	((uint8_t *)desc[2].bitmap_buf)[0] = 0x80;
+	((uint8_t *)desc[2].bitmap_buf)[(num_blocks - 1) * g_bdev.blocklen + 2] = 0xff;
+	bitmap[0] |= 0x80;
+	bitmap[bitmap_size - 1] = 0xff;
+
+	status = INT_MAX;
+	g_read_counter = 0;
+	raid_bdev_load_bitmap(&raid_bdev, bitmap_read, bitmap_io_cb, &status);
+	CU_ASSERT(g_read_counter == raid_bdev.num_base_bdevs - 1);
+	CU_ASSERT(status == 0);
+	CU_ASSERT(memcmp(bitmap, bitmap_read, bitmap_size) == 0);
+
+	/* Base bdevs which are being removed are skipped */
+	base_info[2].remove_scheduled = true;
+	memset(bitmap_read, 0, bitmap_size);
+	for (i = 0; i < bitmap_size; i++) {
+		bitmap[i] = i % 251;
+	}
+
+	status = INT_MAX;
+	g_read_counter = 0;
+	raid_bdev_load_bitmap(&raid_bdev, bitmap_read, bitmap_io_cb, &status);
+	CU_ASSERT(g_read_counter == 1);
+	CU_ASSERT(status == 0);
+	CU_ASSERT(memcmp(bitmap, bitmap_read, bitmap_size) == 0);
+
+	/* No base bdevs to load the bitmap from */
+	base_info[1].is_configured = false;
+	status = INT_MAX;
+	g_read_counter = 0;
+	raid_bdev_load_bitmap(&raid_bdev, bitmap_read, bitmap_io_cb, &status);
+	CU_ASSERT(g_read_counter == 0);
+	CU_ASSERT(status == -ENODEV);
+
+	for (i = 1; i < SPDK_COUNTOF(base_info); i++) {
+		free(desc[i].bitmap_buf);
+	}
+	free(bitmap);
+	free(bitmap_read);
+	raid_bdev_free_superblock(&raid_bdev);
+}
+
 static void
 load_sb_cb(const struct raid_bdev_superblock *sb, int status, void *ctx)
 {
@@ -385,6 +540,7 @@ main(int argc, char **argv)
 		{ "test_raid_bdev_write_superblock", test_raid_bdev_write_superblock },
 		{ "test_raid_bdev_load_base_bdev_superblock", test_raid_bdev_load_base_bdev_superblock },
 		{ "test_raid_bdev_parse_superblock", test_raid_bdev_parse_superblock },
+		{ "test_raid_bdev_write_load_bitmap", test_raid_bdev_write_load_bitmap },
 		CU_TEST_INFO_NULL,
 	};
 	CU_SuiteInfo suites[] = {
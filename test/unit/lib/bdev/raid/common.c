@@ -184,6 +184,7 @@ raid_test_delete_raid_bdev(struct raid_bdev *raid_bdev)
 struct raid_bdev_io_channel {
 	struct spdk_io_channel **_base_channels;
 	struct spdk_io_channel *_module_channel;
+	uint8_t _num_base_bdevs;
 };
 
 struct spdk_io_channel *
@@ -192,6 +193,12 @@ raid_bdev_channel_get_base_channel(struct raid_bdev_io_channel *raid_ch, uint8_t
 	return raid_ch->_base_channels[idx];
 }
 
+uint8_t
+raid_bdev_channel_get_num_base_bdevs(struct raid_bdev_io_channel *raid_ch)
+{
+	return raid_ch->_num_base_bdevs;
+}
+
 void *
 raid_bdev_channel_get_module_ctx(struct raid_bdev_io_channel *raid_ch)
 {
@@ -213,6 +220,7 @@ raid_test_create_io_channel(struct raid_bdev *raid_bdev)
 	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
 		raid_ch->_base_channels[i] = (void *)1;
 	}
+	raid_ch->_num_base_bdevs = raid_bdev_layout_num_base_bdevs(raid_bdev);
 
 	if (raid_bdev->module->get_io_channel) {
 		raid_ch->_module_channel = raid_bdev->module->get_io_channel(raid_bdev);
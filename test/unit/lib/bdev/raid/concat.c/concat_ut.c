@@ -454,6 +454,49 @@ test_concat_null_payload(void)
 	}
 }
 
+static void
+test_concat_reshape(void)
+{
+	struct raid_bdev *raid_bdev;
+	struct raid_params *params;
+	struct concat_block_range *block_range;
+	struct raid_base_bdev_info *base_info;
+	uint64_t blockcnt, total_blockcnt;
+	int i;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		if (params->num_base_bdevs < 2) {
+			continue;
+		}
+
+		/* Start with all but the last base bdev, which is added by the reshape */
+		raid_bdev = raid_test_create_raid_bdev(params, &g_concat_module);
+		raid_bdev->num_base_bdevs--;
+		CU_ASSERT(concat_start(raid_bdev) == 0);
+		raid_bdev->reshape.num_base_bdevs_old = raid_bdev->num_base_bdevs;
+		raid_bdev->num_base_bdevs++;
+
+		/* The size of the added base bdev is rounded down to the strip size */
+		base_info = &raid_bdev->base_bdev_info[raid_bdev->num_base_bdevs - 1];
+		base_info->data_size += raid_bdev->strip_size - 1;
+
+		CU_ASSERT(concat_reshape(raid_bdev, &blockcnt) == 0);
+		CU_ASSERT(blockcnt == params->base_bdev_blockcnt * params->num_base_bdevs);
+		CU_ASSERT(base_info->data_size == params->base_bdev_blockcnt);
+
+		block_range = raid_bdev->module_private;
+		total_blockcnt = 0;
+		for (i = 0; i < params->num_base_bdevs; i++) {
+			CU_ASSERT(block_range[i].start == total_blockcnt);
+			CU_ASSERT(block_range[i].length == params->base_bdev_blockcnt);
+			total_blockcnt += params->base_bdev_blockcnt;
+		}
+
+		raid_bdev->reshape.num_base_bdevs_old = 0;
+		delete_concat(raid_bdev);
+	}
+}
+
 int
 main(int argc, char **argv)
 {
@@ -466,6 +509,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_concat_start);
 	CU_ADD_TEST(suite, test_concat_rw);
 	CU_ADD_TEST(suite, test_concat_null_payload);
+	CU_ADD_TEST(suite, test_concat_reshape);
 
 	allocate_threads(1);
 	set_thread(0);
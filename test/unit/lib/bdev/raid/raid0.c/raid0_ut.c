@@ -50,6 +50,7 @@ uint32_t g_io_range_idx;
 bool g_enable_dif;
 
 DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
+DEFINE_STUB_V(raid_bdev_module_stop_done, (struct raid_bdev *raid_bdev));
 DEFINE_STUB_V(raid_bdev_queue_io_wait, (struct raid_bdev_io *raid_io, struct spdk_bdev *bdev,
 					struct spdk_io_channel *ch, spdk_bdev_io_wait_cb cb_fn));
 DEFINE_STUB(spdk_bdev_flush_blocks, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
@@ -425,20 +426,30 @@ raid_io_cleanup(struct raid_bdev_io *raid_io)
 }
 
 static void
-raid_io_initialize(struct raid_bdev_io *raid_io, struct raid_bdev_io_channel *raid_ch,
-		   struct raid_bdev *raid_bdev, uint64_t lba, uint64_t blocks, int16_t iotype)
+raid_io_initialize_iovcnt(struct raid_bdev_io *raid_io, struct raid_bdev_io_channel *raid_ch,
+			  struct raid_bdev *raid_bdev, uint64_t lba, uint64_t blocks, int16_t iotype,
+			  int iovcnt)
 {
 	struct iovec *iovs = NULL;
-	int iovcnt = 0;
 	void *md_buf = NULL;
+	size_t len, iov_len;
+	int i;
 
 	if (iotype != SPDK_BDEV_IO_TYPE_UNMAP && iotype != SPDK_BDEV_IO_TYPE_FLUSH) {
-		iovcnt = 1;
 		iovs = calloc(iovcnt, sizeof(struct iovec));
 		SPDK_CU_ASSERT_FATAL(iovs != NULL);
-		iovs->iov_len = blocks * g_block_len;
-		iovs->iov_base = calloc(1, iovs->iov_len);
-		SPDK_CU_ASSERT_FATAL(iovs->iov_base != NULL);
+
+		/* Make the iovecs unaligned to the block size, except for the last one */
+		len = blocks * g_block_len;
+		for (i = 0; i < iovcnt; i++) {
+			iov_len = (i == iovcnt - 1) ? len : len / (iovcnt - i) + 512;
+			iov_len = spdk_min(iov_len, len);
+			iovs[i].iov_len = iov_len;
+			iovs[i].iov_base = calloc(1, iov_len);
+			SPDK_CU_ASSERT_FATAL(iovs[i].iov_base != NULL);
+			len -= iov_len;
+		}
+		SPDK_CU_ASSERT_FATAL(len == 0);
 
 		if (spdk_bdev_is_md_separate(&raid_bdev->bdev)) {
 			md_buf = calloc(1, blocks * spdk_bdev_get_md_size(&raid_bdev->bdev));
@@ -446,14 +457,22 @@ raid_io_initialize(struct raid_bdev_io *raid_io, struct raid_bdev_io_channel *ra
 		}
 	}
 
-	raid_test_bdev_io_init(raid_io, raid_bdev, raid_ch, iotype, lba, blocks, iovs, iovcnt, md_buf);
+	raid_test_bdev_io_init(raid_io, raid_bdev, raid_ch, iotype, lba, blocks, iovs,
+			       iovs != NULL ? iovcnt : 0, md_buf);
+}
+
+static void
+raid_io_initialize(struct raid_bdev_io *raid_io, struct raid_bdev_io_channel *raid_ch,
+		   struct raid_bdev *raid_bdev, uint64_t lba, uint64_t blocks, int16_t iotype)
+{
+	raid_io_initialize_iovcnt(raid_io, raid_ch, raid_bdev, lba, blocks, iotype, 1);
 }
 
 static void
 verify_io(struct raid_bdev_io *raid_io, uint32_t io_status)
 {
 	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
-	uint8_t num_base_drives = raid_bdev->num_base_bdevs;
+	uint8_t num_base_drives = raid_bdev_channel_get_num_base_bdevs(raid_io->raid_ch);
 	uint32_t strip_shift = spdk_u32log2(g_strip_size);
 	uint64_t start_strip = raid_io->offset_blocks >> strip_shift;
 	uint64_t end_strip = (raid_io->offset_blocks + raid_io->num_blocks - 1) >>
@@ -510,7 +529,7 @@ static void
 verify_io_without_payload(struct raid_bdev_io *raid_io, uint32_t io_status)
 {
 	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
-	uint8_t num_base_drives = raid_bdev->num_base_bdevs;
+	uint8_t num_base_drives = raid_bdev_channel_get_num_base_bdevs(raid_io->raid_ch);
 	uint32_t strip_shift = spdk_u32log2(g_strip_size);
 	uint64_t start_offset_in_strip = raid_io->offset_blocks % g_strip_size;
 	uint64_t end_offset_in_strip = (raid_io->offset_blocks + raid_io->num_blocks - 1) %
@@ -652,6 +671,8 @@ create_raid0(void)
 static void
 delete_raid0(struct raid_bdev *raid_bdev)
 {
+	raid0_stop(raid_bdev);
+	poll_threads();
 	raid_test_delete_raid_bdev(raid_bdev);
 }
 
@@ -728,6 +749,65 @@ test_read_io(void)
 	reset_globals();
 }
 
+static void
+test_multi_strip_io(void)
+{
+	struct raid_bdev *raid_bdev;
+	struct raid_bdev_io *raid_io;
+	struct raid_bdev_io_channel *raid_ch;
+	struct raid0_io_channel *raid0_ch;
+	uint64_t n_strips[] = {2, 3, g_max_io_size / g_strip_size};
+	uint64_t offsets_in_strip[] = {0, g_strip_size >> 1, g_strip_size - 1};
+	uint64_t start_strips[] = {0, g_max_base_drives - 1};
+	int16_t iotypes[] = {SPDK_BDEV_IO_TYPE_WRITE, SPDK_BDEV_IO_TYPE_READ};
+	int iovcnts[] = {1, 3};
+	uint64_t lba, io_len;
+	size_t i, j, k, l, m;
+
+	set_globals();
+
+	raid_bdev = create_raid0();
+	CU_ASSERT(raid_bdev->bdev.split_on_optimal_io_boundary == false);
+	raid_ch = raid_test_create_io_channel(raid_bdev);
+	raid0_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+
+	for (i = 0; i < SPDK_COUNTOF(iotypes); i++) {
+		for (j = 0; j < SPDK_COUNTOF(n_strips); j++) {
+			for (k = 0; k < SPDK_COUNTOF(offsets_in_strip); k++) {
+				for (l = 0; l < SPDK_COUNTOF(start_strips); l++) {
+					for (m = 0; m < SPDK_COUNTOF(iovcnts); m++) {
+						raid_io = calloc(1, sizeof(*raid_io));
+						SPDK_CU_ASSERT_FATAL(raid_io != NULL);
+						lba = start_strips[l] * g_strip_size + offsets_in_strip[k];
+						io_len = (n_strips[j] - 1) * g_strip_size + 1;
+						raid_io_initialize_iovcnt(raid_io, raid_ch, raid_bdev, lba, io_len,
+									  iotypes[i], iovcnts[m]);
+						memset(g_io_output, 0,
+						       ((g_max_io_size / g_strip_size) + 1) * sizeof(struct io_output));
+						g_io_output_index = 0;
+						g_io_comp_status = false;
+						generate_dif(raid_io->iovs, raid_io->iovcnt, raid_io->md_buf,
+							     raid_io->offset_blocks, raid_io->num_blocks, &raid_bdev->bdev);
+						raid0_submit_rw_request(raid_io);
+						verify_io(raid_io, g_child_io_status_flag);
+
+						/* The split context is returned to the channel for reuse */
+						CU_ASSERT(raid_io->module_private == NULL);
+						CU_ASSERT(!TAILQ_EMPTY(&raid0_ch->split_ios));
+						CU_ASSERT(TAILQ_NEXT(TAILQ_FIRST(&raid0_ch->split_ios), link) == NULL);
+						raid_io_cleanup(raid_io);
+					}
+				}
+			}
+		}
+	}
+
+	raid_test_destroy_io_channel(raid_ch);
+	delete_raid0(raid_bdev);
+
+	reset_globals();
+}
+
 static void
 raid_bdev_io_generate_by_strips(uint64_t n_strips)
 {
@@ -877,6 +957,113 @@ test_io_failure(void)
 	reset_globals();
 }
 
+static void
+test_reshape(void)
+{
+	struct raid_bdev *raid_bdev;
+	struct raid_bdev_io *raid_io;
+	struct raid_bdev_io_channel *raid_ch;
+	uint8_t num_base_bdevs_old = 3;
+	uint64_t strips_per_disk = 8;
+	uint64_t data_size = strips_per_disk * g_strip_size;
+	uint64_t max_sizes[] = {1, g_strip_size / 2 + 1, g_strip_size * 4, UINT64_MAX};
+	uint64_t *disks[5];
+	uint64_t blockcnt, offset, size, lba, block, strip, idx, data;
+	uint8_t num_base_bdevs, i;
+	size_t j;
+
+	struct raid_params params = {
+		.num_base_bdevs = 5,
+		.base_bdev_blockcnt = data_size,
+		.base_bdev_blocklen = g_block_len,
+		.strip_size = g_strip_size,
+		.md_type = RAID_PARAMS_MD_NONE,
+	};
+
+	set_globals();
+
+	/* The added base bdevs are not used until the data is moved to the new layout */
+	raid_bdev = raid_test_create_raid_bdev(&params, &g_raid0_module);
+	num_base_bdevs = raid_bdev->num_base_bdevs;
+	raid_bdev->reshape.num_base_bdevs_old = num_base_bdevs_old;
+	SPDK_CU_ASSERT_FATAL(raid0_start(raid_bdev) == 0);
+	CU_ASSERT(raid_bdev->bdev.blockcnt == data_size * num_base_bdevs_old);
+
+	raid_ch = raid_test_create_io_channel(raid_bdev);
+	CU_ASSERT(raid_bdev_channel_get_num_base_bdevs(raid_ch) == num_base_bdevs_old);
+
+	for (strip = 0; strip < num_base_bdevs_old * 2; strip++) {
+		raid_io = calloc(1, sizeof(*raid_io));
+		SPDK_CU_ASSERT_FATAL(raid_io != NULL);
+		raid_io_initialize(raid_io, raid_ch, raid_bdev, strip * g_strip_size, g_strip_size,
+				   SPDK_BDEV_IO_TYPE_READ);
+		memset(g_io_output, 0, ((g_max_io_size / g_strip_size) + 1) * sizeof(struct io_output));
+		g_io_output_index = 0;
+		raid0_submit_rw_request(raid_io);
+		verify_io(raid_io, g_child_io_status_flag);
+		raid_io_cleanup(raid_io);
+	}
+
+	raid_test_destroy_io_channel(raid_ch);
+
+	/* Move the data in windows and check that no block is overwritten before it is moved */
+	for (j = 0; j < SPDK_COUNTOF(max_sizes); j++) {
+		for (i = 0; i < num_base_bdevs; i++) {
+			disks[i] = calloc(data_size, sizeof(uint64_t));
+			SPDK_CU_ASSERT_FATAL(disks[i] != NULL);
+		}
+		for (block = 0; block < data_size * num_base_bdevs_old; block++) {
+			strip = block >> raid_bdev->strip_size_shift;
+			lba = (strip / num_base_bdevs_old) * g_strip_size + block % g_strip_size;
+			disks[strip % num_base_bdevs_old][lba] = block + 1;
+		}
+
+		for (offset = 0; offset < data_size * num_base_bdevs_old; offset += size) {
+			size = spdk_min(max_sizes[j], data_size * num_base_bdevs_old - offset);
+			size = raid0_reshape_window_size(raid_bdev, offset, size);
+			CU_ASSERT(size > 0);
+			CU_ASSERT(size <= max_sizes[j]);
+
+			/*
+			 * The parts of a window are moved concurrently, so move the blocks in reverse
+			 * order to catch a block overwritten by another one from the same window
+			 */
+			for (idx = size; idx > 0; idx--) {
+				block = offset + idx - 1;
+				strip = block >> raid_bdev->strip_size_shift;
+				lba = (strip / num_base_bdevs_old) * g_strip_size + block % g_strip_size;
+				data = disks[strip % num_base_bdevs_old][lba];
+				CU_ASSERT(data == block + 1);
+
+				lba = (strip / num_base_bdevs) * g_strip_size + block % g_strip_size;
+				disks[strip % num_base_bdevs][lba] = data;
+			}
+		}
+
+		for (block = 0; block < data_size * num_base_bdevs_old; block++) {
+			strip = block >> raid_bdev->strip_size_shift;
+			lba = (strip / num_base_bdevs) * g_strip_size + block % g_strip_size;
+			CU_ASSERT(disks[strip % num_base_bdevs][lba] == block + 1);
+		}
+
+		for (i = 0; i < num_base_bdevs; i++) {
+			free(disks[i]);
+		}
+	}
+
+	SPDK_CU_ASSERT_FATAL(raid0_reshape(raid_bdev, &blockcnt) == 0);
+	CU_ASSERT(blockcnt == data_size * num_base_bdevs);
+	raid_bdev->reshape.num_base_bdevs_old = 0;
+
+	raid_ch = raid_test_create_io_channel(raid_bdev);
+	CU_ASSERT(raid_bdev_channel_get_num_base_bdevs(raid_ch) == num_base_bdevs);
+	raid_test_destroy_io_channel(raid_ch);
+
+	delete_raid0(raid_bdev);
+
+	reset_globals();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -885,8 +1072,10 @@ main(int argc, char **argv)
 	CU_TestInfo tests[] = {
 		{ "test_write_io", test_write_io },
 		{ "test_read_io", test_read_io },
+		{ "test_multi_strip_io", test_multi_strip_io },
 		{ "test_unmap_io", test_unmap_io },
 		{ "test_io_failure", test_io_failure },
+		{ "test_reshape", test_reshape },
 		CU_TEST_INFO_NULL,
 	};
 	CU_SuiteInfo suites[] = {
@@ -15,14 +15,13 @@
 static enum spdk_bdev_io_status g_io_status;
 static struct spdk_bdev_desc *g_last_io_desc;
 static spdk_bdev_io_completion_cb g_last_io_cb;
+static void *g_last_io_cb_arg;
 
 DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
 DEFINE_STUB_V(raid_bdev_module_stop_done, (struct raid_bdev *raid_bdev));
 DEFINE_STUB_V(spdk_bdev_free_io, (struct spdk_bdev_io *bdev_io));
 DEFINE_STUB_V(raid_bdev_queue_io_wait, (struct raid_bdev_io *raid_io, struct spdk_bdev *bdev,
 					struct spdk_io_channel *ch, spdk_bdev_io_wait_cb cb_fn));
-DEFINE_STUB_V(raid_bdev_process_request_complete, (struct raid_bdev_process_request *process_req,
-		int status));
 DEFINE_STUB_V(raid_bdev_io_init, (struct raid_bdev_io *raid_io,
 				  struct raid_bdev_io_channel *raid_ch,
 				  enum spdk_bdev_io_type type, uint64_t offset_blocks,
@@ -31,6 +30,12 @@ DEFINE_STUB_V(raid_bdev_io_init, (struct raid_bdev_io *raid_io,
 DEFINE_STUB(raid_bdev_remap_dix_reftag, int, (void *md_buf, uint64_t num_blocks,
 		struct spdk_bdev *bdev, uint32_t remapped_offset), -1);
 
+uint64_t
+spdk_bdev_io_get_submit_tsc(struct spdk_bdev_io *bdev_io)
+{
+	return bdev_io->internal.submit_tsc;
+}
+
 int
 spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc,
 			   struct spdk_io_channel *ch,
@@ -39,6 +44,7 @@ spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc,
 {
 	g_last_io_desc = desc;
 	g_last_io_cb = cb;
+	g_last_io_cb_arg = cb_arg;
 
 	return 0;
 }
@@ -51,6 +57,7 @@ spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc,
 {
 	g_last_io_desc = desc;
 	g_last_io_cb = cb;
+	g_last_io_cb_arg = cb_arg;
 
 	return 0;
 }
@@ -61,6 +68,16 @@ raid_bdev_fail_base_bdev(struct raid_base_bdev_info *base_info)
 	base_info->is_failed = true;
 }
 
+static int g_process_req_status;
+static bool g_process_req_completed;
+
+void
+raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	g_process_req_status = status;
+	g_process_req_completed = true;
+}
+
 static int
 test_setup(void)
 {
@@ -501,6 +518,463 @@ test_raid1_read_error(void)
 	run_for_each_raid1_config(_test_raid1_read_error);
 }
 
+static void
+_test_raid1_read_policy_latency(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid1_info *r1_info = raid_bdev->module_private;
+	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	struct raid_bdev_io *raid_io[3];
+	struct spdk_bdev_io bdev_io = {};
+	const uint64_t io_blocks = 8;
+	uint8_t slow_idx = raid_bdev->num_base_bdevs - 1;
+	uint8_t i;
+	int n;
+
+	raid_bdev->read_policy = RAID_READ_POLICY_LATENCY;
+
+	/* Without latency samples, reads are spread like with the default policy */
+	bdev_io.internal.submit_tsc = spdk_get_ticks();
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		raid_io[i] = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, io_blocks);
+		raid1_submit_read_request(raid_io[i]);
+		CU_ASSERT(raid_io[i]->base_bdev_io_submitted == i);
+	}
+
+	/* The last base bdev is 10 times slower than the others */
+	spdk_delay_us(100);
+	for (i = 0; i < slow_idx; i++) {
+		raid1_read_bdev_io_completion(&bdev_io, true, raid_io[i]);
+		CU_ASSERT(raid1_ch->read_stats[i].latency_ewma >> RAID1_LATENCY_EWMA_SHIFT ==
+			  100 / io_blocks);
+	}
+	spdk_delay_us(900);
+	raid1_read_bdev_io_completion(&bdev_io, true, raid_io[slow_idx]);
+	CU_ASSERT(raid1_ch->read_stats[slow_idx].latency_ewma >> RAID1_LATENCY_EWMA_SHIFT ==
+		  1000 / io_blocks);
+
+	/* The fast base bdevs take several times more outstanding reads than the slow one */
+	for (n = 0; n < 9 * (raid_bdev->num_base_bdevs - 1); n++) {
+		raid_io[0] = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, io_blocks);
+		raid1_submit_read_request(raid_io[0]);
+		CU_ASSERT(raid_io[0]->base_bdev_io_submitted != slow_idx);
+		put_raid_io(raid_io[0]);
+	}
+
+	raid_io[0] = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, io_blocks);
+	raid1_submit_read_request(raid_io[0]);
+	CU_ASSERT(raid_io[0]->base_bdev_io_submitted == slow_idx);
+	put_raid_io(raid_io[0]);
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		raid1_ch->read_blocks_outstanding[i] = 0;
+	}
+
+	/* A base bdev that wasn't read from for a while is probed again */
+	spdk_delay_us(RAID1_LATENCY_PROBE_US + 1);
+	for (i = 0; i < slow_idx; i++) {
+		raid1_ch->read_stats[i].last_read_tsc = spdk_get_ticks();
+	}
+
+	raid_io[0] = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, io_blocks);
+	raid1_submit_read_request(raid_io[0]);
+	CU_ASSERT(raid_io[0]->base_bdev_io_submitted == slow_idx);
+	raid1_read_bdev_io_completion(&bdev_io, true, raid_io[0]);
+	CU_ASSERT(raid1_ch->read_blocks_outstanding[slow_idx] == 0);
+}
+
+static void
+test_raid1_read_policy_latency(void)
+{
+	run_for_each_raid1_config(_test_raid1_read_policy_latency);
+}
+
+static void
+_test_raid1_read_policy_sequential(struct raid_bdev *raid_bdev,
+				   struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid1_info *r1_info = raid_bdev->module_private;
+	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	const uint64_t io_blocks = 8;
+	const uint64_t offsets[] = { 0, 8, 1024, 16, 1032, 24, 1040, 32 };
+	struct raid_bdev_io *raid_io;
+	uint8_t i;
+
+	raid_bdev->read_policy = RAID_READ_POLICY_SEQUENTIAL;
+
+	/*
+	 * Two interleaved sequential streams stay on the base bdevs they started on, although
+	 * the first one gets more outstanding reads than the others.
+	 */
+	for (i = 0; i < SPDK_COUNTOF(offsets); i++) {
+		raid_io = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, io_blocks);
+		raid_io->offset_blocks = offsets[i];
+		raid1_submit_read_request(raid_io);
+		CU_ASSERT(raid_io->base_bdev_io_submitted == (offsets[i] < 1024 ? 0 : 1));
+		put_raid_io(raid_io);
+	}
+
+	/* A random read goes to the base bdev with the fewest outstanding read blocks */
+	raid_io = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, io_blocks);
+	raid_io->offset_blocks = 4096;
+	raid1_submit_read_request(raid_io);
+	CU_ASSERT(raid_io->base_bdev_io_submitted == (raid_bdev->num_base_bdevs > 2 ? 2 : 1));
+	put_raid_io(raid_io);
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		raid1_ch->read_blocks_outstanding[i] = 0;
+	}
+}
+
+static void
+test_raid1_read_policy_sequential(void)
+{
+	run_for_each_raid1_config(_test_raid1_read_policy_sequential);
+}
+
+static int
+ut_base_ch_create(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+ut_base_ch_destroy(void *io_device, void *ctx_buf)
+{
+}
+
+static struct raid1_hedged_read *
+submit_hedged_read(struct raid1_info *r1_info, struct raid_bdev_io_channel *raid_ch,
+		   struct iovec *iov, struct spdk_bdev_io *bdev_io)
+{
+	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	struct raid_bdev_io *raid_io;
+	struct raid1_hedged_read *hedged_read;
+
+	raid_io = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+			      iov->iov_len / r1_info->raid_bdev->bdev.blocklen);
+	raid_io->iovs = iov;
+	raid_io->iovcnt = 1;
+
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+	bdev_io->internal.submit_tsc = spdk_get_ticks();
+	raid1_submit_read_request(raid_io);
+	CU_ASSERT(raid_io->base_bdev_io_submitted == 0);
+	CU_ASSERT(g_last_io_cb == raid1_hedged_read_primary_completion);
+	hedged_read = g_last_io_cb_arg;
+	SPDK_CU_ASSERT_FATAL(hedged_read != NULL);
+	CU_ASSERT(hedged_read->raid_io == raid_io);
+	CU_ASSERT(TAILQ_FIRST(&raid1_ch->hedged_reads_pending) == hedged_read);
+
+	return hedged_read;
+}
+
+static void
+_test_raid1_read_hedging(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid1_info *r1_info = raid_bdev->module_private;
+	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	struct spdk_io_channel **base_channels, **hedge_channels;
+	struct raid1_hedged_read *hedged_read;
+	struct raid_bdev_io *raid_io;
+	struct spdk_bdev_io bdev_io = {};
+	const uint64_t io_blocks = 8;
+	uint64_t len = io_blocks * raid_bdev->bdev.blocklen;
+	struct iovec iov;
+	uint8_t i;
+	int n;
+
+	/* The references taken by hedged reads need real base bdev channels */
+	spdk_io_device_register(&g_io_status, ut_base_ch_create, ut_base_ch_destroy, 0, "ut_base");
+	base_channels = raid_ch->_base_channels;
+	raid_ch->_base_channels = calloc(raid_bdev->num_base_bdevs, sizeof(struct spdk_io_channel *));
+	SPDK_CU_ASSERT_FATAL(raid_ch->_base_channels != NULL);
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		raid_ch->_base_channels[i] = spdk_get_io_channel(&g_io_status);
+		SPDK_CU_ASSERT_FATAL(raid_ch->_base_channels[i] != NULL);
+	}
+
+	iov.iov_len = len;
+	iov.iov_base = calloc(1, len);
+	SPDK_CU_ASSERT_FATAL(iov.iov_base != NULL);
+
+	raid_bdev->read_hedge_percentile = 90;
+
+	/* Reads are not hedged until the latency percentile is known */
+	for (n = 0; n < RAID1_HEDGE_MIN_SAMPLES; n++) {
+		raid_io = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, io_blocks);
+		bdev_io.internal.submit_tsc = spdk_get_ticks();
+		raid1_submit_read_request(raid_io);
+		CU_ASSERT(g_last_io_cb == raid1_read_bdev_io_completion);
+		CU_ASSERT(raid_io->base_bdev_io_submitted == 0);
+		spdk_delay_us(100);
+		raid1_read_bdev_io_completion(&bdev_io, true, raid_io);
+	}
+	CU_ASSERT(raid1_ch->read_stats[0].latency_quantile / 100 >= 95);
+	CU_ASSERT(raid1_ch->read_stats[0].latency_quantile / 100 <= 105);
+	CU_ASSERT(raid1_ch->hedged_reads == NULL);
+
+	/* The primary read completes in time, no hedge read is sent */
+	hedged_read = submit_hedged_read(r1_info, raid_ch, &iov, &bdev_io);
+	spdk_delay_us(50);
+	poll_threads();
+	CU_ASSERT(hedged_read->reads_outstanding == 1);
+	memset(hedged_read->buf[0], 0xa5, len);
+	raid1_hedged_read_primary_completion(&bdev_io, true, hedged_read);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(((uint8_t *)iov.iov_base)[len - 1] == 0xa5);
+	CU_ASSERT(TAILQ_EMPTY(&raid1_ch->hedged_reads_pending));
+	CU_ASSERT(hedged_read->raid_io == NULL);
+	CU_ASSERT(raid1_ch->read_blocks_outstanding[0] == 0);
+
+	/* The primary read is late, the hedge read completes first */
+	hedged_read = submit_hedged_read(r1_info, raid_ch, &iov, &bdev_io);
+	spdk_delay_us(200);
+	poll_threads();
+	CU_ASSERT(hedged_read->reads_outstanding == 2);
+	CU_ASSERT(g_last_io_cb == raid1_hedged_read_hedge_completion);
+	CU_ASSERT(g_last_io_desc == raid_bdev->base_bdev_info[1].desc);
+	CU_ASSERT(raid1_ch->read_blocks_outstanding[1] == io_blocks);
+	memset(hedged_read->buf[1], 0x5a, len);
+	raid1_hedged_read_hedge_completion(&bdev_io, true, hedged_read);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(((uint8_t *)iov.iov_base)[len - 1] == 0x5a);
+
+	/* The late primary read completes after the raid_io */
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+	memset(hedged_read->buf[0], 0xa5, len);
+	raid1_hedged_read_primary_completion(&bdev_io, true, hedged_read);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_PENDING);
+	CU_ASSERT(((uint8_t *)iov.iov_base)[len - 1] == 0x5a);
+	CU_ASSERT(hedged_read->raid_io == NULL);
+	CU_ASSERT(hedged_read->module_ch == NULL);
+	CU_ASSERT(raid1_ch->read_blocks_outstanding[0] == 0);
+	CU_ASSERT(raid1_ch->read_blocks_outstanding[1] == 0);
+
+	/* The hedge read fails, the primary read succeeds */
+	hedged_read = submit_hedged_read(r1_info, raid_ch, &iov, &bdev_io);
+	spdk_delay_us(200);
+	poll_threads();
+	CU_ASSERT(hedged_read->reads_outstanding == 2);
+	raid1_hedged_read_hedge_completion(&bdev_io, false, hedged_read);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_PENDING);
+	memset(hedged_read->buf[0], 0xa5, len);
+	raid1_hedged_read_primary_completion(&bdev_io, true, hedged_read);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(((uint8_t *)iov.iov_base)[len - 1] == 0xa5);
+	CU_ASSERT(hedged_read->raid_io == NULL);
+
+	/* Both reads fail, the regular read error handling takes over */
+	hedged_read = submit_hedged_read(r1_info, raid_ch, &iov, &bdev_io);
+	raid_io = hedged_read->raid_io;
+	spdk_delay_us(200);
+	poll_threads();
+	CU_ASSERT(hedged_read->reads_outstanding == 2);
+	raid1_hedged_read_primary_completion(&bdev_io, false, hedged_read);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_PENDING);
+	raid1_hedged_read_hedge_completion(&bdev_io, false, hedged_read);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_PENDING);
+	CU_ASSERT(hedged_read->raid_io == NULL);
+	CU_ASSERT(g_last_io_desc == raid_bdev->base_bdev_info[1].desc);
+	CU_ASSERT(g_last_io_cb == raid1_read_other_completion);
+	raid1_read_other_completion(&bdev_io, true, raid_io);
+	CU_ASSERT(g_last_io_desc == raid_bdev->base_bdev_info[0].desc);
+	CU_ASSERT(g_last_io_cb == raid1_correct_read_error_completion);
+	raid1_correct_read_error_completion(&bdev_io, true, raid_io);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* Reads are not bounced if there is no base bdev to hedge them to */
+	hedge_channels = calloc(raid_bdev->num_base_bdevs, sizeof(struct spdk_io_channel *));
+	SPDK_CU_ASSERT_FATAL(hedge_channels != NULL);
+	for (i = 1; i < raid_bdev->num_base_bdevs; i++) {
+		hedge_channels[i] = raid_ch->_base_channels[i];
+		raid_ch->_base_channels[i] = NULL;
+	}
+	raid_io = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, io_blocks);
+	raid1_submit_read_request(raid_io);
+	CU_ASSERT(g_last_io_cb == raid1_read_bdev_io_completion);
+	CU_ASSERT(raid_io->base_bdev_io_submitted == 0);
+	raid1_read_bdev_io_completion(&bdev_io, true, raid_io);
+	for (i = 1; i < raid_bdev->num_base_bdevs; i++) {
+		raid_ch->_base_channels[i] = hedge_channels[i];
+	}
+	free(hedge_channels);
+
+	/* Large reads are not hedged */
+	raid_io = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+			      RAID1_HEDGE_MAX_SIZE / raid_bdev->bdev.blocklen + 1);
+	raid1_submit_read_request(raid_io);
+	CU_ASSERT(g_last_io_cb == raid1_read_bdev_io_completion);
+	raid1_read_bdev_io_completion(&bdev_io, true, raid_io);
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		CU_ASSERT(raid1_ch->read_blocks_outstanding[i] == 0);
+		spdk_put_io_channel(raid_ch->_base_channels[i]);
+	}
+	free(raid_ch->_base_channels);
+	raid_ch->_base_channels = base_channels;
+	poll_threads();
+	spdk_io_device_unregister(&g_io_status, NULL);
+	poll_threads();
+
+	free(iov.iov_base);
+}
+
+static void
+test_raid1_read_hedging(void)
+{
+	run_for_each_raid1_config(_test_raid1_read_hedging);
+}
+
+static struct raid_bdev_process_request *
+scrub_start(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch, bool repair)
+{
+	struct raid_bdev_process_request *process_req;
+	uint32_t len = raid_bdev->bdev.blocklen;
+
+	process_req = calloc(1, sizeof(*process_req));
+	SPDK_CU_ASSERT_FATAL(process_req != NULL);
+	process_req->num_blocks = 1;
+	process_req->iov.iov_len = len;
+	process_req->iov.iov_base = calloc(2, len);
+	SPDK_CU_ASSERT_FATAL(process_req->iov.iov_base != NULL);
+	process_req->scrub.iov.iov_len = len;
+	process_req->scrub.iov.iov_base = process_req->iov.iov_base + len;
+	process_req->scrub.repair = repair;
+
+	raid_test_bdev_io_init(&process_req->raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ, 0, 1,
+			       &process_req->iov, 1, NULL);
+	process_req->raid_io.module_private = NULL;
+	g_process_req_completed = false;
+	g_process_req_status = -1;
+
+	raid1_scrub_next(&process_req->raid_io);
+
+	return process_req;
+}
+
+static void
+scrub_free(struct raid_bdev_process_request *process_req)
+{
+	free(process_req->iov.iov_base);
+	free(process_req);
+}
+
+static void
+scrub_complete_read(struct raid_bdev_process_request *process_req, uint8_t idx, bool success,
+		    bool match)
+{
+	struct spdk_bdev_io bdev_io = {};
+
+	CU_ASSERT(g_process_req_completed == false);
+	CU_ASSERT(g_last_io_desc == process_req->raid_io.raid_bdev->base_bdev_info[idx].desc);
+	CU_ASSERT(g_last_io_cb == raid1_scrub_read_completed);
+	memset(process_req->scrub.iov.iov_base, match ? 0 : 0xff, process_req->scrub.iov.iov_len);
+	raid1_scrub_read_completed(&bdev_io, success, process_req);
+}
+
+static void
+scrub_complete_write(struct raid_bdev_process_request *process_req, uint8_t idx, bool success)
+{
+	struct spdk_bdev_io bdev_io = {};
+
+	CU_ASSERT(g_process_req_completed == false);
+	CU_ASSERT(g_last_io_desc == process_req->raid_io.raid_bdev->base_bdev_info[idx].desc);
+	CU_ASSERT(g_last_io_cb == raid1_scrub_write_completed);
+	raid1_scrub_write_completed(&bdev_io, success, process_req);
+}
+
+static void
+_test_raid1_scrub(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid_bdev_process_request *process_req;
+	uint8_t n = raid_bdev->num_base_bdevs;
+	uint8_t i;
+
+	/* all copies match */
+	process_req = scrub_start(raid_bdev, raid_ch, true);
+	for (i = 0; i < n; i++) {
+		scrub_complete_read(process_req, i, true, true);
+	}
+	CU_ASSERT(g_process_req_completed == true);
+	CU_ASSERT(g_process_req_status == 0);
+	CU_ASSERT(process_req->scrub.mismatched_blocks == 0);
+	CU_ASSERT(process_req->scrub.read_error_blocks == 0);
+	CU_ASSERT(process_req->scrub.repaired_blocks == 0);
+	scrub_free(process_req);
+
+	/* the last copy doesn't match and is rewritten with the first one */
+	process_req = scrub_start(raid_bdev, raid_ch, true);
+	for (i = 0; i < n - 1; i++) {
+		scrub_complete_read(process_req, i, true, true);
+	}
+	scrub_complete_read(process_req, n - 1, true, false);
+	scrub_complete_write(process_req, n - 1, true);
+	CU_ASSERT(g_process_req_completed == true);
+	CU_ASSERT(g_process_req_status == 0);
+	CU_ASSERT(process_req->scrub.mismatched_blocks == 1);
+	CU_ASSERT(process_req->scrub.repaired_blocks == 1);
+	scrub_free(process_req);
+
+	/* the same without repair */
+	process_req = scrub_start(raid_bdev, raid_ch, false);
+	for (i = 0; i < n - 1; i++) {
+		scrub_complete_read(process_req, i, true, true);
+	}
+	scrub_complete_read(process_req, n - 1, true, false);
+	CU_ASSERT(g_process_req_completed == true);
+	CU_ASSERT(g_process_req_status == 0);
+	CU_ASSERT(process_req->scrub.mismatched_blocks == 1);
+	CU_ASSERT(process_req->scrub.repaired_blocks == 0);
+	scrub_free(process_req);
+
+	/* the first copy can't be read, it is rewritten once the second one is read */
+	process_req = scrub_start(raid_bdev, raid_ch, true);
+	scrub_complete_read(process_req, 0, false, true);
+	scrub_complete_read(process_req, 1, true, true);
+	scrub_complete_write(process_req, 0, true);
+	for (i = 2; i < n; i++) {
+		scrub_complete_read(process_req, i, true, true);
+	}
+	CU_ASSERT(g_process_req_completed == true);
+	CU_ASSERT(g_process_req_status == 0);
+	CU_ASSERT(process_req->scrub.mismatched_blocks == 0);
+	CU_ASSERT(process_req->scrub.read_error_blocks == 1);
+	CU_ASSERT(process_req->scrub.repaired_blocks == 1);
+	scrub_free(process_req);
+
+	/* no copy can be read */
+	process_req = scrub_start(raid_bdev, raid_ch, true);
+	for (i = 0; i < n; i++) {
+		scrub_complete_read(process_req, i, false, true);
+	}
+	CU_ASSERT(g_process_req_completed == true);
+	CU_ASSERT(g_process_req_status == 0);
+	CU_ASSERT(process_req->scrub.read_error_blocks == n);
+	CU_ASSERT(process_req->scrub.repaired_blocks == 0);
+	scrub_free(process_req);
+
+	/* the repair fails, the base bdev is failed */
+	process_req = scrub_start(raid_bdev, raid_ch, true);
+	scrub_complete_read(process_req, 0, true, true);
+	scrub_complete_read(process_req, 1, false, true);
+	scrub_complete_write(process_req, 1, false);
+	for (i = 2; i < n; i++) {
+		scrub_complete_read(process_req, i, true, true);
+	}
+	CU_ASSERT(g_process_req_completed == true);
+	CU_ASSERT(process_req->scrub.read_error_blocks == 1);
+	CU_ASSERT(process_req->scrub.repaired_blocks == 0);
+	CU_ASSERT(raid_bdev->base_bdev_info[1].is_failed == true);
+	raid_bdev->base_bdev_info[1].is_failed = false;
+	scrub_free(process_req);
+}
+
+static void
+test_raid1_scrub(void)
+{
+	run_for_each_raid1_config(_test_raid1_scrub);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -514,6 +988,10 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_raid1_read_balancing);
 	CU_ADD_TEST(suite, test_raid1_write_error);
 	CU_ADD_TEST(suite, test_raid1_read_error);
+	CU_ADD_TEST(suite, test_raid1_read_policy_latency);
+	CU_ADD_TEST(suite, test_raid1_read_policy_sequential);
+	CU_ADD_TEST(suite, test_raid1_read_hedging);
+	CU_ADD_TEST(suite, test_raid1_scrub);
 
 	allocate_threads(1);
 	set_thread(0);
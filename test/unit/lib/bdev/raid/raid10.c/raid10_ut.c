@@ -0,0 +1,663 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "spdk/env.h"
+
+#include "common/lib/ut_multithread.c"
+
+#include "bdev/raid/raid10.c"
+#include "../common.c"
+
+#define MAX_IO_OUTPUT 64
+
+struct io_output {
+	struct spdk_bdev_desc		*desc;
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+	spdk_bdev_io_completion_cb	cb;
+	void				*cb_arg;
+	enum spdk_bdev_io_type		type;
+};
+
+static struct io_output g_io_output[MAX_IO_OUTPUT];
+static uint32_t g_io_output_count;
+static enum spdk_bdev_io_status g_io_status;
+static struct raid_bdev *g_raid_bdev;
+static int g_process_status;
+static int g_process_completed;
+
+DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
+DEFINE_STUB_V(raid_bdev_module_stop_done, (struct raid_bdev *raid_bdev));
+DEFINE_STUB_V(spdk_bdev_free_io, (struct spdk_bdev_io *bdev_io));
+DEFINE_STUB_V(raid_bdev_queue_io_wait, (struct raid_bdev_io *raid_io, struct spdk_bdev *bdev,
+					struct spdk_io_channel *ch, spdk_bdev_io_wait_cb cb_fn));
+DEFINE_STUB(raid_bdev_remap_dix_reftag, int, (void *md_buf, uint64_t num_blocks,
+		struct spdk_bdev *bdev, uint32_t remapped_offset), -1);
+DEFINE_STUB(spdk_bdev_notify_blockcnt_change, int, (struct spdk_bdev *bdev, uint64_t size), 0);
+
+static int
+add_io_output(struct spdk_bdev_desc *desc, enum spdk_bdev_io_type type, uint64_t offset_blocks,
+	      uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct io_output *output;
+
+	SPDK_CU_ASSERT_FATAL(g_io_output_count < MAX_IO_OUTPUT);
+	output = &g_io_output[g_io_output_count++];
+	output->desc = desc;
+	output->type = type;
+	output->offset_blocks = offset_blocks;
+	output->num_blocks = num_blocks;
+	output->cb = cb;
+	output->cb_arg = cb_arg;
+
+	return 0;
+}
+
+int
+spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			   struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			   spdk_bdev_io_completion_cb cb, void *cb_arg, struct spdk_bdev_ext_io_opts *opts)
+{
+	return add_io_output(desc, SPDK_BDEV_IO_TYPE_READ, offset_blocks, num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			    struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			    spdk_bdev_io_completion_cb cb, void *cb_arg, struct spdk_bdev_ext_io_opts *opts)
+{
+	return add_io_output(desc, SPDK_BDEV_IO_TYPE_WRITE, offset_blocks, num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_unmap_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return add_io_output(desc, SPDK_BDEV_IO_TYPE_UNMAP, offset_blocks, num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_flush_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return add_io_output(desc, SPDK_BDEV_IO_TYPE_FLUSH, offset_blocks, num_blocks, cb, cb_arg);
+}
+
+void
+raid_bdev_fail_base_bdev(struct raid_base_bdev_info *base_info)
+{
+	base_info->is_failed = true;
+}
+
+void
+raid_bdev_io_init(struct raid_bdev_io *raid_io, struct raid_bdev_io_channel *raid_ch,
+		  enum spdk_bdev_io_type type, uint64_t offset_blocks,
+		  uint64_t num_blocks, struct iovec *iovs, int iovcnt, void *md_buf,
+		  struct spdk_memory_domain *memory_domain, void *memory_domain_ctx)
+{
+	raid_test_bdev_io_init(raid_io, g_raid_bdev, raid_ch, type, offset_blocks, num_blocks,
+			       iovs, iovcnt, md_buf);
+}
+
+void
+raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	g_process_status = status;
+	g_process_completed++;
+}
+
+void
+raid_test_bdev_io_complete(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
+{
+	g_io_status = status;
+}
+
+static void
+complete_io_output(struct io_output *output, bool success)
+{
+	struct spdk_bdev_io bdev_io = { .bdev = output->desc->bdev };
+
+	output->cb(&bdev_io, success, output->cb_arg);
+}
+
+static int
+test_setup(void)
+{
+	uint8_t num_base_bdevs_values[] = { 4, 6, 8 };
+	uint64_t base_bdev_blockcnt_values[] = { 1024, 1024 * 1024 + 5 };
+	uint32_t base_bdev_blocklen_values[] = { 512, 4096 };
+	uint32_t strip_size_values[] = { 8, 64 };
+	uint8_t *num_base_bdevs;
+	uint64_t *base_bdev_blockcnt;
+	uint32_t *base_bdev_blocklen;
+	uint32_t *strip_size;
+	uint64_t params_count;
+	int rc;
+
+	params_count = SPDK_COUNTOF(num_base_bdevs_values) *
+		       SPDK_COUNTOF(base_bdev_blockcnt_values) *
+		       SPDK_COUNTOF(base_bdev_blocklen_values) *
+		       SPDK_COUNTOF(strip_size_values);
+	rc = raid_test_params_alloc(params_count);
+	if (rc) {
+		return rc;
+	}
+
+	ARRAY_FOR_EACH(num_base_bdevs_values, num_base_bdevs) {
+		ARRAY_FOR_EACH(base_bdev_blockcnt_values, base_bdev_blockcnt) {
+			ARRAY_FOR_EACH(base_bdev_blocklen_values, base_bdev_blocklen) {
+				ARRAY_FOR_EACH(strip_size_values, strip_size) {
+					struct raid_params params = {
+						.num_base_bdevs = *num_base_bdevs,
+						.base_bdev_blockcnt = *base_bdev_blockcnt,
+						.base_bdev_blocklen = *base_bdev_blocklen,
+						.strip_size = *strip_size,
+					};
+					raid_test_params_add(&params);
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int
+test_cleanup(void)
+{
+	raid_test_params_free();
+	return 0;
+}
+
+static struct raid10_info *
+create_raid10(struct raid_params *params)
+{
+	struct raid_bdev *raid_bdev = raid_test_create_raid_bdev(params, &g_raid10_module);
+
+	SPDK_CU_ASSERT_FATAL(raid10_start(raid_bdev) == 0);
+	g_raid_bdev = raid_bdev;
+
+	return raid_bdev->module_private;
+}
+
+static void
+delete_raid10(struct raid10_info *r10info)
+{
+	struct raid_bdev *raid_bdev = r10info->raid_bdev;
+
+	raid10_stop(raid_bdev);
+	poll_threads();
+
+	raid_test_delete_raid_bdev(raid_bdev);
+	g_raid_bdev = NULL;
+}
+
+static void
+run_for_each_raid10_config(void (*test_fn)(struct raid_bdev *raid_bdev,
+			   struct raid_bdev_io_channel *raid_ch))
+{
+	struct raid_params *params;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		struct raid10_info *r10info;
+		struct raid_bdev_io_channel *raid_ch;
+
+		r10info = create_raid10(params);
+		raid_ch = raid_test_create_io_channel(r10info->raid_bdev);
+
+		g_io_output_count = 0;
+		test_fn(r10info->raid_bdev, raid_ch);
+
+		raid_test_destroy_io_channel(raid_ch);
+		delete_raid10(r10info);
+	}
+}
+
+static void
+test_raid10_start(void)
+{
+	struct raid_params *params;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		struct raid10_info *r10info;
+		uint64_t base_bdev_data_size;
+
+		r10info = create_raid10(params);
+		base_bdev_data_size = params->base_bdev_blockcnt / params->strip_size * params->strip_size;
+
+		CU_ASSERT_EQUAL(r10info->raid_bdev->level, RAID10);
+		CU_ASSERT_EQUAL(r10info->num_mirrors, params->num_base_bdevs / 2);
+		CU_ASSERT_EQUAL(r10info->raid_bdev->bdev.blockcnt,
+				base_bdev_data_size * params->num_base_bdevs / 2);
+		CU_ASSERT_EQUAL(r10info->raid_bdev->bdev.optimal_io_boundary, params->strip_size);
+		CU_ASSERT(r10info->raid_bdev->bdev.split_on_optimal_io_boundary == true);
+		CU_ASSERT_EQUAL(r10info->raid_bdev->base_bdev_info[0].data_size, base_bdev_data_size);
+		CU_ASSERT_PTR_EQUAL(r10info->raid_bdev->module, &g_raid10_module);
+
+		delete_raid10(r10info);
+	}
+}
+
+static void
+_test_raid10_rw_mapping(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid10_info *r10info = raid_bdev->module_private;
+	struct raid_bdev_io raid_io;
+	uint64_t strip, offset_blocks, base_offset;
+	uint32_t num_blocks = spdk_min(raid_bdev->strip_size, 5);
+	uint8_t mirror, i;
+
+	for (strip = 0; strip < 3 * r10info->num_mirrors; strip++) {
+		offset_blocks = strip * raid_bdev->strip_size + raid_bdev->strip_size - num_blocks;
+		mirror = strip % r10info->num_mirrors;
+		base_offset = strip / r10info->num_mirrors * raid_bdev->strip_size +
+			      raid_bdev->strip_size - num_blocks;
+
+		/* writes go to both base bdevs of the mirror */
+		g_io_output_count = 0;
+		g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+		raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_WRITE,
+				       offset_blocks, num_blocks, NULL, 0, NULL);
+		raid10_submit_rw_request(&raid_io);
+		SPDK_CU_ASSERT_FATAL(g_io_output_count == 2);
+		for (i = 0; i < 2; i++) {
+			CU_ASSERT(g_io_output[i].desc == raid_bdev->base_bdev_info[mirror * 2 + i].desc);
+			CU_ASSERT(g_io_output[i].type == SPDK_BDEV_IO_TYPE_WRITE);
+			CU_ASSERT(g_io_output[i].offset_blocks == base_offset);
+			CU_ASSERT(g_io_output[i].num_blocks == num_blocks);
+			complete_io_output(&g_io_output[i], true);
+		}
+		CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+		/* reads go to one of them */
+		g_io_output_count = 0;
+		g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+		raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+				       offset_blocks, num_blocks, NULL, 0, NULL);
+		raid10_submit_rw_request(&raid_io);
+		SPDK_CU_ASSERT_FATAL(g_io_output_count == 1);
+		CU_ASSERT(raid_io.base_bdev_io_submitted / 2 == mirror);
+		CU_ASSERT(g_io_output[0].desc ==
+			  raid_bdev->base_bdev_info[raid_io.base_bdev_io_submitted].desc);
+		CU_ASSERT(g_io_output[0].type == SPDK_BDEV_IO_TYPE_READ);
+		CU_ASSERT(g_io_output[0].offset_blocks == base_offset);
+		CU_ASSERT(g_io_output[0].num_blocks == num_blocks);
+		complete_io_output(&g_io_output[0], true);
+		CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+}
+
+static void
+test_raid10_rw_mapping(void)
+{
+	run_for_each_raid10_config(_test_raid10_rw_mapping);
+}
+
+static void
+_test_raid10_read_balancing(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid10_io_channel *raid10_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	struct raid_bdev_io raid_io;
+	uint8_t i;
+
+	/* reads of the same mirror alternate between its base bdevs */
+	for (i = 0; i < 4; i++) {
+		raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+				       raid_bdev->strip_size, 1, NULL, 0, NULL);
+		raid10_submit_read_request(&raid_io);
+		CU_ASSERT(raid_io.base_bdev_io_submitted == 2 + i % 2);
+	}
+	CU_ASSERT(raid10_ch->read_blocks_outstanding[0] == 0);
+	CU_ASSERT(raid10_ch->read_blocks_outstanding[1] == 0);
+	CU_ASSERT(raid10_ch->read_blocks_outstanding[2] == 2);
+	CU_ASSERT(raid10_ch->read_blocks_outstanding[3] == 2);
+
+	/* the less loaded base bdev is selected */
+	raid10_ch->read_blocks_outstanding[2] = 100;
+	for (i = 0; i < 4; i++) {
+		raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+				       raid_bdev->strip_size, 1, NULL, 0, NULL);
+		raid10_submit_read_request(&raid_io);
+		CU_ASSERT(raid_io.base_bdev_io_submitted == 3);
+	}
+
+	/* a missing base bdev is not selected */
+	raid_ch->_base_channels[3] = NULL;
+	raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+			       raid_bdev->strip_size, 1, NULL, 0, NULL);
+	raid10_submit_read_request(&raid_io);
+	CU_ASSERT(raid_io.base_bdev_io_submitted == 2);
+
+	/* the read fails if the whole mirror is missing */
+	raid_ch->_base_channels[2] = NULL;
+	g_io_output_count = 0;
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+	raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+			       raid_bdev->strip_size, 1, NULL, 0, NULL);
+	raid10_submit_read_request(&raid_io);
+	CU_ASSERT(g_io_output_count == 0);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void
+test_raid10_read_balancing(void)
+{
+	run_for_each_raid10_config(_test_raid10_read_balancing);
+}
+
+static void
+_test_raid10_read_error(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[0];
+	struct raid_bdev_io raid_io;
+
+	/* the read fails, the read from the other base bdev succeeds and the data is rewritten */
+	base_info->is_failed = false;
+	g_io_output_count = 0;
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+	raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ, 0, 1,
+			       NULL, 0, NULL);
+	raid10_submit_read_request(&raid_io);
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 1);
+	CU_ASSERT(g_io_output[0].desc == base_info->desc);
+	CU_ASSERT(g_io_output[0].cb == raid10_read_bdev_io_completion);
+	complete_io_output(&g_io_output[0], false);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_PENDING);
+
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 2);
+	CU_ASSERT(g_io_output[1].desc == raid_bdev->base_bdev_info[1].desc);
+	CU_ASSERT(g_io_output[1].cb == raid10_read_other_completion);
+	complete_io_output(&g_io_output[1], true);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_PENDING);
+
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 3);
+	CU_ASSERT(g_io_output[2].desc == base_info->desc);
+	CU_ASSERT(g_io_output[2].type == SPDK_BDEV_IO_TYPE_WRITE);
+	CU_ASSERT(g_io_output[2].cb == raid10_correct_read_error_completion);
+	complete_io_output(&g_io_output[2], true);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(base_info->is_failed == false);
+
+	/* both reads fail */
+	g_io_output_count = 0;
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+	raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ, 0, 1,
+			       NULL, 0, NULL);
+	raid10_submit_read_request(&raid_io);
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 1);
+	complete_io_output(&g_io_output[0], false);
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 2);
+	complete_io_output(&g_io_output[1], false);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_FAILED);
+	CU_ASSERT(base_info->is_failed == true);
+
+	/* the other base bdev is missing */
+	base_info->is_failed = false;
+	raid_ch->_base_channels[1] = NULL;
+	g_io_output_count = 0;
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+	raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ, 0, 1,
+			       NULL, 0, NULL);
+	raid10_submit_read_request(&raid_io);
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 1);
+	complete_io_output(&g_io_output[0], false);
+	CU_ASSERT(g_io_output_count == 1);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_FAILED);
+	CU_ASSERT(base_info->is_failed == true);
+}
+
+static void
+test_raid10_read_error(void)
+{
+	run_for_each_raid10_config(_test_raid10_read_error);
+}
+
+static void
+_test_raid10_write_degraded(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid_bdev_io raid_io;
+
+	raid_ch->_base_channels[0] = NULL;
+
+	/* the write succeeds on the remaining base bdev of the mirror */
+	g_io_output_count = 0;
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+	raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_WRITE, 0, 1,
+			       NULL, 0, NULL);
+	raid10_submit_rw_request(&raid_io);
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 1);
+	CU_ASSERT(g_io_output[0].desc == raid_bdev->base_bdev_info[1].desc);
+	complete_io_output(&g_io_output[0], true);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* and fails if it fails there */
+	g_io_output_count = 0;
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+	raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_WRITE, 0, 1,
+			       NULL, 0, NULL);
+	raid10_submit_rw_request(&raid_io);
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 1);
+	complete_io_output(&g_io_output[0], false);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_FAILED);
+	CU_ASSERT(raid_bdev->base_bdev_info[1].is_failed == true);
+
+	/* a failure of one of the mirrored writes doesn't fail the write */
+	raid_ch->_base_channels[0] = (void *)1;
+	g_io_output_count = 0;
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+	raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_WRITE,
+			       raid_bdev->strip_size, 1, NULL, 0, NULL);
+	raid10_submit_rw_request(&raid_io);
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 2);
+	complete_io_output(&g_io_output[0], false);
+	complete_io_output(&g_io_output[1], true);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(raid_bdev->base_bdev_info[2].is_failed == true);
+	CU_ASSERT(raid_bdev->base_bdev_info[3].is_failed == false);
+}
+
+static void
+test_raid10_write_degraded(void)
+{
+	run_for_each_raid10_config(_test_raid10_write_degraded);
+}
+
+static void
+check_null_payload(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+		   enum spdk_bdev_io_type type, uint64_t offset_blocks, uint64_t num_blocks)
+{
+	struct raid10_info *r10info = raid_bdev->module_private;
+	uint64_t expected_start[UINT8_MAX], expected_end[UINT8_MAX];
+	struct raid_bdev_io raid_io;
+	uint64_t lba, strip, base_lba;
+	uint8_t mirror, slot, num_expected = 0;
+	uint32_t i;
+
+	for (mirror = 0; mirror < r10info->num_mirrors; mirror++) {
+		expected_start[mirror] = UINT64_MAX;
+		expected_end[mirror] = 0;
+	}
+
+	for (lba = offset_blocks; lba < offset_blocks + num_blocks; lba++) {
+		strip = lba / raid_bdev->strip_size;
+		mirror = strip % r10info->num_mirrors;
+		base_lba = strip / r10info->num_mirrors * raid_bdev->strip_size +
+			   lba % raid_bdev->strip_size;
+		expected_start[mirror] = spdk_min(expected_start[mirror], base_lba);
+		expected_end[mirror] = spdk_max(expected_end[mirror], base_lba);
+	}
+
+	for (slot = 0; slot < raid_bdev->num_base_bdevs; slot++) {
+		if (expected_start[slot / 2] != UINT64_MAX &&
+		    raid_bdev_channel_get_base_channel(raid_ch, slot) != NULL) {
+			num_expected++;
+		}
+	}
+
+	g_io_output_count = 0;
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+	raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, type, offset_blocks, num_blocks,
+			       NULL, 0, NULL);
+	raid10_submit_null_payload_request(&raid_io);
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == num_expected);
+
+	for (i = 0; i < g_io_output_count; i++) {
+		slot = raid_bdev_base_bdev_slot(g_io_output[i].desc->bdev->ctxt);
+		mirror = slot / 2;
+		CU_ASSERT(g_io_output[i].type == type);
+		CU_ASSERT(g_io_output[i].offset_blocks == expected_start[mirror]);
+		CU_ASSERT(g_io_output[i].num_blocks == expected_end[mirror] - expected_start[mirror] + 1);
+		CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_PENDING);
+		complete_io_output(&g_io_output[i], true);
+	}
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+static void
+_test_raid10_null_payload(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid10_info *r10info = raid_bdev->module_private;
+	uint64_t strip_size = raid_bdev->strip_size;
+	uint64_t row_size = strip_size * r10info->num_mirrors;
+
+	check_null_payload(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_UNMAP, 0, 1);
+	check_null_payload(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_UNMAP, 1, strip_size);
+	check_null_payload(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_UNMAP, strip_size - 1,
+			   row_size + 2);
+	check_null_payload(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_UNMAP, row_size + 3,
+			   3 * row_size - 5);
+	check_null_payload(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_FLUSH, 0, 4 * row_size);
+
+	raid_ch->_base_channels[1] = NULL;
+	check_null_payload(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_UNMAP, strip_size - 1,
+			   row_size + 2);
+	check_null_payload(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_FLUSH, 0, 4 * row_size);
+}
+
+static void
+test_raid10_null_payload(void)
+{
+	run_for_each_raid10_config(_test_raid10_null_payload);
+}
+
+static void
+_test_raid10_process_request(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid10_info *r10info = raid_bdev->module_private;
+	struct raid_bdev_process_request process_req = {};
+	uint64_t strip_size = raid_bdev->strip_size;
+	uint64_t row_size = strip_size * r10info->num_mirrors;
+	int ret;
+
+	/* rebuild of the second base bdev of mirror #1 */
+	process_req.target = &raid_bdev->base_bdev_info[3];
+	process_req.target_ch = (void *)1;
+	raid_ch->_base_channels[3] = NULL;
+
+	/* the range starts in a strip of another mirror */
+	g_io_output_count = 0;
+	g_process_completed = 0;
+	process_req.offset_blocks = 0;
+	process_req.num_blocks = 4 * row_size;
+	ret = raid10_submit_process_request(&process_req, raid_ch);
+	CU_ASSERT(ret == (int)(2 * strip_size));
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 1);
+	CU_ASSERT(g_io_output[0].desc == raid_bdev->base_bdev_info[2].desc);
+	CU_ASSERT(g_io_output[0].type == SPDK_BDEV_IO_TYPE_READ);
+	CU_ASSERT(g_io_output[0].offset_blocks == 0);
+	CU_ASSERT(g_io_output[0].num_blocks == strip_size);
+	complete_io_output(&g_io_output[0], true);
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 2);
+	CU_ASSERT(g_io_output[1].desc == process_req.target->desc);
+	CU_ASSERT(g_io_output[1].type == SPDK_BDEV_IO_TYPE_WRITE);
+	CU_ASSERT(g_io_output[1].offset_blocks == 0);
+	CU_ASSERT(g_io_output[1].num_blocks == strip_size);
+	CU_ASSERT(g_process_completed == 0);
+	complete_io_output(&g_io_output[1], true);
+	CU_ASSERT(g_process_completed == 1);
+	CU_ASSERT(g_process_status == 0);
+
+	/* the range starts and ends in the middle of a strip of the target's mirror */
+	g_io_output_count = 0;
+	g_process_completed = 0;
+	process_req.offset_blocks = row_size + strip_size + 1;
+	process_req.num_blocks = strip_size - 2;
+	ret = raid10_submit_process_request(&process_req, raid_ch);
+	CU_ASSERT(ret == (int)(strip_size - 2));
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 1);
+	CU_ASSERT(g_io_output[0].offset_blocks == strip_size + 1);
+	CU_ASSERT(g_io_output[0].num_blocks == strip_size - 2);
+	complete_io_output(&g_io_output[0], true);
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 2);
+	CU_ASSERT(g_io_output[1].offset_blocks == strip_size + 1);
+	CU_ASSERT(g_io_output[1].num_blocks == strip_size - 2);
+	complete_io_output(&g_io_output[1], false);
+	CU_ASSERT(g_process_completed == 1);
+	CU_ASSERT(g_process_status == -EIO);
+
+	/* the range doesn't include any strip of the target's mirror */
+	g_io_output_count = 0;
+	g_process_completed = 0;
+	process_req.offset_blocks = row_size;
+	process_req.num_blocks = strip_size;
+	ret = raid10_submit_process_request(&process_req, raid_ch);
+	CU_ASSERT(ret == (int)strip_size);
+	CU_ASSERT(g_io_output_count == 0);
+	CU_ASSERT(g_process_completed == 0);
+	poll_threads();
+	CU_ASSERT(g_process_completed == 1);
+	CU_ASSERT(g_process_status == 0);
+
+	/* the read fails on the other base bdev of the mirror */
+	g_io_output_count = 0;
+	g_process_completed = 0;
+	process_req.offset_blocks = strip_size;
+	process_req.num_blocks = strip_size;
+	ret = raid10_submit_process_request(&process_req, raid_ch);
+	CU_ASSERT(ret == (int)strip_size);
+	SPDK_CU_ASSERT_FATAL(g_io_output_count == 1);
+	complete_io_output(&g_io_output[0], false);
+	CU_ASSERT(g_io_output_count == 1);
+	CU_ASSERT(g_process_completed == 1);
+	CU_ASSERT(g_process_status == -EIO);
+}
+
+static void
+test_raid10_process_request(void)
+{
+	run_for_each_raid10_config(_test_raid10_process_request);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("raid10", test_setup, test_cleanup);
+	CU_ADD_TEST(suite, test_raid10_start);
+	CU_ADD_TEST(suite, test_raid10_rw_mapping);
+	CU_ADD_TEST(suite, test_raid10_read_balancing);
+	CU_ADD_TEST(suite, test_raid10_read_error);
+	CU_ADD_TEST(suite, test_raid10_write_degraded);
+	CU_ADD_TEST(suite, test_raid10_null_payload);
+	CU_ADD_TEST(suite, test_raid10_process_request);
+
+	allocate_threads(1);
+	set_thread(0);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+
+	free_threads();
+
+	return num_failures;
+}
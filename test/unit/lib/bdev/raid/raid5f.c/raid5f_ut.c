@@ -15,22 +15,58 @@
 
 static void *g_accel_p = (void *)0xdeadbeaf;
 static bool g_test_degraded;
+static struct spdk_raid_bdev_opts g_opts;
+
+/* Contents of a single stripe on each base bdev, used by partial stripe writes */
+static void **g_base_bdev_bufs;
+static void **g_base_bdev_md_bufs;
+static uint64_t g_base_bdev_stripe_index;
+static uint64_t g_base_bdev_blocks_read;
+
+/* Base bdev I/O of scrub requests, also served from the stripe contents above */
+static struct raid_io_info *g_scrub_io_info;
+/* Base bdevs, by index, whose reads fail during scrub */
+static uint32_t g_scrub_read_errors;
 
 DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
 DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
 DEFINE_STUB_V(raid_bdev_module_stop_done, (struct raid_bdev *raid_bdev));
 DEFINE_STUB(accel_channel_create, int, (void *io_device, void *ctx_buf), 0);
 DEFINE_STUB_V(accel_channel_destroy, (void *io_device, void *ctx_buf));
-DEFINE_STUB_V(raid_bdev_process_request_complete, (struct raid_bdev_process_request *process_req,
-		int status));
-DEFINE_STUB_V(raid_bdev_io_init, (struct raid_bdev_io *raid_io,
-				  struct raid_bdev_io_channel *raid_ch,
-				  enum spdk_bdev_io_type type, uint64_t offset_blocks,
-				  uint64_t num_blocks, struct iovec *iovs, int iovcnt, void *md_buf,
-				  struct spdk_memory_domain *memory_domain, void *memory_domain_ctx));
+DEFINE_STUB(spdk_json_write_named_object_begin, int, (struct spdk_json_write_ctx *w,
+		const char *name), 0);
+DEFINE_STUB(spdk_json_write_named_uint64, int, (struct spdk_json_write_ctx *w, const char *name,
+		uint64_t val), 0);
+DEFINE_STUB(spdk_json_write_object_end, int, (struct spdk_json_write_ctx *w), 0);
 DEFINE_STUB(raid_bdev_remap_dix_reftag, int, (void *md_buf, uint64_t num_blocks,
 		struct spdk_bdev *bdev, uint32_t remapped_offset), -1);
 
+static int g_process_req_status;
+static bool g_process_req_completed;
+
+void
+raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	g_process_req_status = status;
+	g_process_req_completed = true;
+}
+
+void
+raid_bdev_io_init(struct raid_bdev_io *raid_io, struct raid_bdev_io_channel *raid_ch,
+		  enum spdk_bdev_io_type type, uint64_t offset_blocks,
+		  uint64_t num_blocks, struct iovec *iovs, int iovcnt, void *md_buf,
+		  struct spdk_memory_domain *memory_domain, void *memory_domain_ctx)
+{
+	raid_test_bdev_io_init(raid_io, raid_io->raid_bdev, raid_ch, type, offset_blocks, num_blocks,
+			       iovs, iovcnt, md_buf);
+}
+
+void
+raid_bdev_get_opts(struct spdk_raid_bdev_opts *opts)
+{
+	*opts = g_opts;
+}
+
 struct spdk_io_channel *
 spdk_accel_get_io_channel(void)
 {
@@ -190,6 +226,8 @@ test_raid5f_start(void)
 		CU_ASSERT_EQUAL(r5f_info->raid_bdev->bdev.optimal_io_boundary, params->strip_size);
 		CU_ASSERT_TRUE(r5f_info->raid_bdev->bdev.split_on_optimal_io_boundary);
 		CU_ASSERT_EQUAL(r5f_info->raid_bdev->bdev.write_unit_size, r5f_info->stripe_blocks);
+		CU_ASSERT_TRUE(r5f_info->raid_bdev->bdev.split_on_write_unit);
+		CU_ASSERT_TRUE(r5f_info->raid_bdev->bdev.allow_partial_write_unit);
 
 		delete_raid5f(r5f_info);
 	}
@@ -368,6 +406,8 @@ process_io_completions(struct raid_io_info *io_info)
 		if (io_info->error.type == TEST_BDEV_ERROR_COMPLETE &&
 		    io_info->error.bdev == bdev_io->bdev) {
 			success = false;
+		} else if (bdev_io->internal.status == SPDK_BDEV_IO_STATUS_FAILED) {
+			success = false;
 		} else {
 			success = true;
 		}
@@ -397,6 +437,92 @@ process_io_completions(struct raid_io_info *io_info)
 	}
 }
 
+static int
+base_bdev_rw_partial_write(struct spdk_bdev_desc *desc, struct iovec *iov, int iovcnt,
+			   void *md_buf, uint64_t offset_blocks, uint64_t num_blocks,
+			   spdk_bdev_io_completion_cb cb, void *cb_arg, bool write)
+{
+	struct chunk *chunk = cb_arg;
+	struct stripe_request *stripe_req = raid5f_chunk_stripe_req(chunk);
+	struct test_raid_bdev_io *test_raid_bdev_io;
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	uint64_t stripe_start = g_base_bdev_stripe_index << raid_bdev->strip_size_shift;
+	struct iovec buf_iov;
+	void *buf_md = NULL;
+
+	test_raid_bdev_io = SPDK_CONTAINEROF(stripe_req->raid_io, struct test_raid_bdev_io, raid_io);
+
+	SPDK_CU_ASSERT_FATAL(stripe_req->stripe_index == g_base_bdev_stripe_index);
+	SPDK_CU_ASSERT_FATAL(offset_blocks >= stripe_start);
+	SPDK_CU_ASSERT_FATAL(offset_blocks + num_blocks <= stripe_start + raid_bdev->strip_size);
+	CU_ASSERT(stripe_req->lock.held);
+
+	buf_iov.iov_base = g_base_bdev_bufs[chunk->index] +
+			   (offset_blocks - stripe_start) * raid_bdev->bdev.blocklen;
+	buf_iov.iov_len = num_blocks * raid_bdev->bdev.blocklen;
+	if (g_base_bdev_md_bufs != NULL) {
+		buf_md = g_base_bdev_md_bufs[chunk->index] +
+			 (offset_blocks - stripe_start) * raid_bdev->bdev.md_len;
+	}
+
+	if (write) {
+		spdk_iovcpy(iov, iovcnt, &buf_iov, 1);
+		if (md_buf != NULL) {
+			memcpy(buf_md, md_buf, num_blocks * raid_bdev->bdev.md_len);
+		}
+	} else {
+		spdk_iovcpy(&buf_iov, 1, iov, iovcnt);
+		if (md_buf != NULL) {
+			memcpy(md_buf, buf_md, num_blocks * raid_bdev->bdev.md_len);
+		}
+		g_base_bdev_blocks_read += num_blocks;
+	}
+
+	return submit_io(test_raid_bdev_io->io_info, desc, cb, cb_arg);
+}
+
+static int
+base_bdev_rw_scrub(struct spdk_bdev_desc *desc, struct iovec *iov, int iovcnt, void *md_buf,
+		   uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		   void *cb_arg, bool write)
+{
+	struct raid_base_bdev_info *base_info = desc->bdev->ctxt;
+	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+	uint8_t idx = raid_bdev_base_bdev_slot(base_info);
+	bool fail = !write && (g_scrub_read_errors & (1u << idx)) != 0;
+	struct spdk_bdev_io *bdev_io;
+	struct iovec buf_iov;
+
+	SPDK_CU_ASSERT_FATAL(offset_blocks == g_base_bdev_stripe_index << raid_bdev->strip_size_shift);
+	SPDK_CU_ASSERT_FATAL(num_blocks == raid_bdev->strip_size);
+
+	buf_iov.iov_base = g_base_bdev_bufs[idx];
+	buf_iov.iov_len = num_blocks * raid_bdev->bdev.blocklen;
+
+	if (write) {
+		spdk_iovcpy(iov, iovcnt, &buf_iov, 1);
+		if (md_buf != NULL) {
+			memcpy(g_base_bdev_md_bufs[idx], md_buf, num_blocks * raid_bdev->bdev.md_len);
+		}
+	} else if (!fail) {
+		spdk_iovcpy(&buf_iov, 1, iov, iovcnt);
+		if (md_buf != NULL) {
+			memcpy(md_buf, g_base_bdev_md_bufs[idx], num_blocks * raid_bdev->bdev.md_len);
+		}
+	}
+
+	bdev_io = calloc(1, sizeof(*bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->bdev = desc->bdev;
+	bdev_io->internal.cb = cb;
+	bdev_io->internal.caller_ctx = cb_arg;
+	bdev_io->internal.status = fail ? SPDK_BDEV_IO_STATUS_FAILED : SPDK_BDEV_IO_STATUS_PENDING;
+
+	TAILQ_INSERT_TAIL(&g_scrub_io_info->bdev_io_queue, bdev_io, internal.link);
+
+	return 0;
+}
+
 int
 spdk_bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 				struct iovec *iov, int iovcnt, void *md_buf,
@@ -414,9 +540,19 @@ spdk_bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_chan
 	struct iovec dest;
 	void *dest_md_buf;
 
+	if (g_scrub_io_info != NULL) {
+		return base_bdev_rw_scrub(desc, iov, iovcnt, md_buf, offset_blocks, num_blocks, cb,
+					  cb_arg, true);
+	}
+
 	SPDK_CU_ASSERT_FATAL(cb == raid5f_chunk_complete_bdev_io);
 
 	stripe_req = raid5f_chunk_stripe_req(chunk);
+	if (stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
+		return base_bdev_rw_partial_write(desc, iov, iovcnt, md_buf, offset_blocks, num_blocks,
+						  cb, cb_arg, true);
+	}
+
 	test_raid_bdev_io = SPDK_CONTAINEROF(stripe_req->raid_io, struct test_raid_bdev_io, raid_io);
 	io_info = test_raid_bdev_io->io_info;
 	r5f_info = io_info->r5f_info;
@@ -527,18 +663,28 @@ spdk_bdev_readv_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_chann
 			       spdk_bdev_io_completion_cb cb, void *cb_arg)
 {
 	struct raid_bdev_io *raid_io = cb_arg;
-	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_bdev *raid_bdev;
 	struct test_raid_bdev_io *test_raid_bdev_io = SPDK_CONTAINEROF(raid_io, struct test_raid_bdev_io,
 			raid_io);
 	struct iovec src;
 
+	if (g_scrub_io_info != NULL) {
+		return base_bdev_rw_scrub(desc, iov, iovcnt, md_buf, offset_blocks, num_blocks, cb,
+					  cb_arg, false);
+	}
+
 	if (cb == raid5f_chunk_complete_bdev_io) {
+		if (raid5f_chunk_stripe_req(cb_arg)->type == STRIPE_REQ_PARTIAL_WRITE) {
+			return base_bdev_rw_partial_write(desc, iov, iovcnt, md_buf, offset_blocks, num_blocks,
+							  cb, cb_arg, false);
+		}
 		return spdk_bdev_readv_blocks_degraded(desc, ch, iov, iovcnt, md_buf, offset_blocks,
 						       num_blocks, cb, cb_arg);
 	}
 
 	SPDK_CU_ASSERT_FATAL(cb == raid5f_chunk_read_complete);
 
+	raid_bdev = raid_io->raid_bdev;
 	src.iov_base = test_raid_bdev_io->buf;
 	src.iov_len = num_blocks * raid_bdev->bdev.blocklen;
 
@@ -1115,6 +1261,705 @@ test_raid5f_submit_read_request_degraded(void)
 	run_for_each_raid5f_config(__test_raid5f_submit_read_request);
 }
 
+static void
+fill_random(void *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		((uint8_t *)buf)[i] = rand();
+	}
+}
+
+/* Logical contents of the stripe's data chunks, in the same layout as g_base_bdev_bufs */
+static void **g_ref_bufs;
+static void **g_ref_md_bufs;
+
+static void
+partial_write_init_stripe(struct raid_bdev *raid_bdev, uint64_t stripe_index)
+{
+	uint32_t md_len = raid_bdev->bdev.md_interleave ? 0 : raid_bdev->bdev.md_len;
+	size_t strip_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	size_t strip_md_len = raid_bdev->strip_size * md_len;
+	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, stripe_index);
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	uint8_t i;
+
+	g_base_bdev_stripe_index = stripe_index;
+
+	/* The stripe is changed behind the raid bdev's back, invalidate any cached copies */
+	r5f_info->stripe_locks[stripe_index % RAID5F_STRIPE_LOCK_BUCKETS].gen++;
+
+	g_base_bdev_bufs = calloc(raid_bdev->num_base_bdevs, sizeof(void *));
+	SPDK_CU_ASSERT_FATAL(g_base_bdev_bufs != NULL);
+	g_ref_bufs = calloc(raid_bdev->num_base_bdevs, sizeof(void *));
+	SPDK_CU_ASSERT_FATAL(g_ref_bufs != NULL);
+	if (md_len != 0) {
+		g_base_bdev_md_bufs = calloc(raid_bdev->num_base_bdevs, sizeof(void *));
+		SPDK_CU_ASSERT_FATAL(g_base_bdev_md_bufs != NULL);
+		g_ref_md_bufs = calloc(raid_bdev->num_base_bdevs, sizeof(void *));
+		SPDK_CU_ASSERT_FATAL(g_ref_md_bufs != NULL);
+	}
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		g_base_bdev_bufs[i] = calloc(1, strip_len);
+		SPDK_CU_ASSERT_FATAL(g_base_bdev_bufs[i] != NULL);
+		g_ref_bufs[i] = calloc(1, strip_len);
+		SPDK_CU_ASSERT_FATAL(g_ref_bufs[i] != NULL);
+		if (md_len != 0) {
+			g_base_bdev_md_bufs[i] = calloc(1, strip_md_len);
+			SPDK_CU_ASSERT_FATAL(g_base_bdev_md_bufs[i] != NULL);
+			g_ref_md_bufs[i] = calloc(1, strip_md_len);
+			SPDK_CU_ASSERT_FATAL(g_ref_md_bufs[i] != NULL);
+		}
+	}
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		if (i == p_idx) {
+			continue;
+		}
+
+		fill_random(g_ref_bufs[i], strip_len);
+		memcpy(g_base_bdev_bufs[i], g_ref_bufs[i], strip_len);
+		xor_block(g_base_bdev_bufs[p_idx], g_ref_bufs[i], strip_len);
+		if (md_len != 0) {
+			fill_random(g_ref_md_bufs[i], strip_md_len);
+			memcpy(g_base_bdev_md_bufs[i], g_ref_md_bufs[i], strip_md_len);
+			xor_block(g_base_bdev_md_bufs[p_idx], g_ref_md_bufs[i], strip_md_len);
+		}
+	}
+}
+
+static void
+partial_write_fini_stripe(struct raid_bdev *raid_bdev)
+{
+	uint8_t i;
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		free(g_base_bdev_bufs[i]);
+		free(g_ref_bufs[i]);
+		if (g_base_bdev_md_bufs != NULL) {
+			free(g_base_bdev_md_bufs[i]);
+			free(g_ref_md_bufs[i]);
+		}
+	}
+
+	free(g_base_bdev_bufs);
+	free(g_ref_bufs);
+	free(g_base_bdev_md_bufs);
+	free(g_ref_md_bufs);
+	g_base_bdev_bufs = NULL;
+	g_ref_bufs = NULL;
+	g_base_bdev_md_bufs = NULL;
+	g_ref_md_bufs = NULL;
+}
+
+/* Check that the base bdevs hold the reference data and matching parity */
+static void
+partial_write_check_stripe(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	uint32_t md_len = raid_bdev->bdev.md_interleave ? 0 : raid_bdev->bdev.md_len;
+	size_t strip_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	size_t strip_md_len = raid_bdev->strip_size * md_len;
+	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, g_base_bdev_stripe_index);
+	void *parity, *parity_md = NULL;
+	uint8_t i;
+
+	parity = calloc(1, strip_len);
+	SPDK_CU_ASSERT_FATAL(parity != NULL);
+	if (md_len != 0) {
+		parity_md = calloc(1, strip_md_len);
+		SPDK_CU_ASSERT_FATAL(parity_md != NULL);
+	}
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		if (i == p_idx) {
+			continue;
+		}
+
+		xor_block(parity, g_ref_bufs[i], strip_len);
+		if (md_len != 0) {
+			xor_block(parity_md, g_ref_md_bufs[i], strip_md_len);
+		}
+
+		if (raid_bdev_channel_get_base_channel(raid_ch, i) == NULL) {
+			continue;
+		}
+
+		CU_ASSERT(memcmp(g_base_bdev_bufs[i], g_ref_bufs[i], strip_len) == 0);
+		if (md_len != 0) {
+			CU_ASSERT(memcmp(g_base_bdev_md_bufs[i], g_ref_md_bufs[i], strip_md_len) == 0);
+		}
+	}
+
+	if (raid_bdev_channel_get_base_channel(raid_ch, p_idx) != NULL) {
+		CU_ASSERT(memcmp(g_base_bdev_bufs[p_idx], parity, strip_len) == 0);
+		if (md_len != 0) {
+			CU_ASSERT(memcmp(g_base_bdev_md_bufs[p_idx], parity_md, strip_md_len) == 0);
+		}
+	}
+
+	free(parity);
+	free(parity_md);
+}
+
+static struct raid_bdev_io *
+partial_write_get_raid_io(struct raid_io_info *io_info, struct raid5f_info *r5f_info,
+			  struct raid_bdev_io_channel *raid_ch, uint64_t stripe_offset,
+			  uint64_t num_blocks)
+{
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, g_base_bdev_stripe_index);
+	uint64_t block, row;
+	uint8_t idx;
+
+	SPDK_CU_ASSERT_FATAL(stripe_offset + num_blocks <= r5f_info->stripe_blocks);
+
+	init_io_info(io_info, r5f_info, raid_ch, SPDK_BDEV_IO_TYPE_WRITE, g_base_bdev_stripe_index,
+		     stripe_offset, num_blocks);
+
+	fill_random(io_info->src_buf, io_info->buf_size);
+	if (io_info->src_md_buf != NULL) {
+		fill_random(io_info->src_md_buf, io_info->buf_md_size);
+	}
+
+	/* Update the reference data with what is going to be written */
+	for (block = 0; block < num_blocks; block++) {
+		idx = (stripe_offset + block) >> raid_bdev->strip_size_shift;
+		row = (stripe_offset + block) - (idx << raid_bdev->strip_size_shift);
+		if (idx >= p_idx) {
+			idx++;
+		}
+
+		memcpy(g_ref_bufs[idx] + row * raid_bdev->bdev.blocklen,
+		       io_info->src_buf + block * raid_bdev->bdev.blocklen, raid_bdev->bdev.blocklen);
+		if (io_info->src_md_buf != NULL) {
+			memcpy(g_ref_md_bufs[idx] + row * raid_bdev->bdev.md_len,
+			       io_info->src_md_buf + block * raid_bdev->bdev.md_len, raid_bdev->bdev.md_len);
+		}
+	}
+
+	return get_raid_io(io_info);
+}
+
+static void
+wait_io_completion(struct raid_io_info *io_info)
+{
+	int i;
+
+	for (i = 0; i < 100 && io_info->status == SPDK_BDEV_IO_STATUS_PENDING; i++) {
+		poll_threads();
+		process_io_completions(io_info);
+	}
+
+	CU_ASSERT(io_info->status != SPDK_BDEV_IO_STATUS_PENDING);
+}
+
+static void
+test_raid5f_partial_write(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+			  uint64_t stripe_offset, uint64_t num_blocks)
+{
+	struct raid_io_info io_info;
+	struct raid_bdev_io *raid_io;
+
+	raid_io = partial_write_get_raid_io(&io_info, raid_bdev->module_private, raid_ch,
+					    stripe_offset, num_blocks);
+
+	raid5f_submit_rw_request(raid_io);
+
+	wait_io_completion(&io_info);
+
+	CU_ASSERT(io_info.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	partial_write_check_stripe(raid_bdev, raid_ch);
+
+	deinit_io_info(&io_info);
+}
+
+static void
+__test_raid5f_submit_partial_write_request(struct raid_bdev *raid_bdev,
+		struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	uint64_t stripe_blocks = r5f_info->stripe_blocks;
+	uint64_t stripe_index;
+	uint64_t offset, num_blocks;
+	int i;
+
+	RAID5F_TEST_FOR_EACH_STRIPE(raid_bdev, stripe_index) {
+		partial_write_init_stripe(raid_bdev, stripe_index);
+
+		test_raid5f_partial_write(raid_bdev, raid_ch, 0, 1);
+		test_raid5f_partial_write(raid_bdev, raid_ch, stripe_blocks - 1, 1);
+		if (stripe_blocks > 2) {
+			test_raid5f_partial_write(raid_bdev, raid_ch, raid_bdev->strip_size - 1, 2);
+			test_raid5f_partial_write(raid_bdev, raid_ch, 1, stripe_blocks - 2);
+		}
+
+		for (i = 0; i < 8; i++) {
+			offset = rand() % stripe_blocks;
+			num_blocks = 1 + rand() % (stripe_blocks - offset - (offset == 0 ? 1 : 0));
+			test_raid5f_partial_write(raid_bdev, raid_ch, offset, num_blocks);
+		}
+
+		partial_write_fini_stripe(raid_bdev);
+	}
+}
+static void
+test_raid5f_submit_partial_write_request(void)
+{
+	run_for_each_raid5f_config(__test_raid5f_submit_partial_write_request);
+}
+
+static void
+test_raid5f_submit_partial_write_request_degraded(void)
+{
+	g_test_degraded = true;
+	run_for_each_raid5f_config(__test_raid5f_submit_partial_write_request);
+}
+
+static void
+__test_raid5f_partial_write_error(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	struct raid_base_bdev_info *base_bdev_info;
+	struct raid_io_info io_info;
+	struct raid_bdev_io *raid_io;
+	enum test_bdev_error_type error_type;
+
+	for (error_type = TEST_BDEV_ERROR_SUBMIT; error_type <= TEST_BDEV_ERROR_NOMEM; error_type++) {
+		RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_bdev_info) {
+			partial_write_init_stripe(raid_bdev, 0);
+
+			/* Write to all chunks, so that every base bdev is accessed */
+			raid_io = partial_write_get_raid_io(&io_info, r5f_info, raid_ch, 1,
+							    r5f_info->stripe_blocks - 1);
+			io_info.error.type = error_type;
+			io_info.error.bdev = base_bdev_info->desc->bdev;
+
+			raid5f_submit_rw_request(raid_io);
+			wait_io_completion(&io_info);
+
+			if (error_type == TEST_BDEV_ERROR_NOMEM) {
+				CU_ASSERT(io_info.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+				partial_write_check_stripe(raid_bdev, raid_ch);
+			} else {
+				CU_ASSERT(io_info.status == SPDK_BDEV_IO_STATUS_FAILED);
+			}
+
+			deinit_io_info(&io_info);
+			partial_write_fini_stripe(raid_bdev);
+		}
+	}
+}
+static void
+test_raid5f_partial_write_error(void)
+{
+	run_for_each_raid5f_config(__test_raid5f_partial_write_error);
+}
+
+static void
+__test_raid5f_partial_write_sequential(struct raid_bdev *raid_bdev,
+				       struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	uint64_t stripe_blocks = r5f_info->stripe_blocks;
+	uint64_t step = spdk_max(1, raid_bdev->strip_size / 4);
+	uint64_t last_strip = stripe_blocks - raid_bdev->strip_size;
+	uint64_t stripe_index;
+	uint64_t offset;
+
+	RAID5F_TEST_FOR_EACH_STRIPE(raid_bdev, stripe_index) {
+		partial_write_init_stripe(raid_bdev, stripe_index);
+
+		for (offset = 0; offset < stripe_blocks; offset += step) {
+			g_base_bdev_blocks_read = 0;
+
+			test_raid5f_partial_write(raid_bdev, raid_ch, offset,
+						  spdk_min(step, stripe_blocks - offset));
+
+			/*
+			 * The first write reads ahead to the end of the strip, so the following
+			 * writes to the same strip and the writes completing the stripe are
+			 * served from the stripe cache.
+			 */
+			if (offset % raid_bdev->strip_size != 0 || offset >= last_strip) {
+				CU_ASSERT(g_base_bdev_blocks_read == 0);
+			}
+		}
+
+		partial_write_fini_stripe(raid_bdev);
+	}
+}
+static void
+test_raid5f_partial_write_sequential(void)
+{
+	run_for_each_raid5f_config(__test_raid5f_partial_write_sequential);
+}
+
+static void
+__test_raid5f_partial_write_lock(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid_io_info io_info[2];
+	struct raid_bdev_io *raid_io[2];
+	struct stripe_request *stripe_req[2];
+	int i;
+
+	partial_write_init_stripe(raid_bdev, 0);
+
+	/* Both writes modify the same block, so the second one must wait for the first */
+	for (i = 0; i < 2; i++) {
+		raid_io[i] = partial_write_get_raid_io(&io_info[i], raid_bdev->module_private, raid_ch, 0, 1);
+		raid5f_submit_rw_request(raid_io[i]);
+		stripe_req[i] = raid_io[i]->module_private;
+	}
+
+	CU_ASSERT(stripe_req[0]->lock.held);
+	CU_ASSERT(!stripe_req[1]->lock.held);
+	CU_ASSERT(TAILQ_FIRST(&stripe_req[0]->lock.waiters) == stripe_req[1]);
+	CU_ASSERT(!TAILQ_EMPTY(&io_info[0].bdev_io_queue));
+	CU_ASSERT(TAILQ_EMPTY(&io_info[1].bdev_io_queue));
+
+	wait_io_completion(&io_info[0]);
+	CU_ASSERT(io_info[0].status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	wait_io_completion(&io_info[1]);
+	CU_ASSERT(io_info[1].status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	partial_write_check_stripe(raid_bdev, raid_ch);
+
+	for (i = 0; i < 2; i++) {
+		deinit_io_info(&io_info[i]);
+	}
+
+	partial_write_fini_stripe(raid_bdev);
+}
+static void
+test_raid5f_partial_write_lock(void)
+{
+	run_for_each_raid5f_config(__test_raid5f_partial_write_lock);
+}
+
+static void
+__test_raid5f_partial_write_other_channel(struct raid_bdev *raid_bdev,
+		struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	struct raid_bdev_io_channel *raid_ch2;
+	struct raid_io_info io_info[2];
+	struct raid_bdev_io *raid_io;
+	struct stripe_request *stripe_req;
+
+	set_thread(1);
+	raid_ch2 = raid_test_create_io_channel(raid_bdev);
+	set_thread(0);
+
+	partial_write_init_stripe(raid_bdev, 0);
+
+	/* Fill the stripe cache of the first channel */
+	test_raid5f_partial_write(raid_bdev, raid_ch, 0, r5f_info->stripe_blocks - 1);
+
+	/* Modify the cached stripe through the other channel */
+	set_thread(1);
+	test_raid5f_partial_write(raid_bdev, raid_ch2, 0, 1);
+	set_thread(0);
+
+	/* The first channel must not use its stale copy of the stripe to calculate parity */
+	test_raid5f_partial_write(raid_bdev, raid_ch, raid_bdev->strip_size, 1);
+
+	/* Concurrent writes to the same stripe from different threads are serialized */
+	raid_io = partial_write_get_raid_io(&io_info[0], r5f_info, raid_ch, 0, 1);
+	raid5f_submit_rw_request(raid_io);
+	stripe_req = raid_io->module_private;
+
+	set_thread(1);
+	raid_io = partial_write_get_raid_io(&io_info[1], r5f_info, raid_ch2,
+					    r5f_info->stripe_blocks - 1, 1);
+	raid5f_submit_rw_request(raid_io);
+	CU_ASSERT(TAILQ_FIRST(&stripe_req->lock.waiters) == raid_io->module_private);
+	set_thread(0);
+
+	wait_io_completion(&io_info[0]);
+	CU_ASSERT(io_info[0].status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	set_thread(1);
+	wait_io_completion(&io_info[1]);
+	CU_ASSERT(io_info[1].status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	set_thread(0);
+
+	partial_write_check_stripe(raid_bdev, raid_ch);
+
+	deinit_io_info(&io_info[0]);
+	deinit_io_info(&io_info[1]);
+
+	partial_write_fini_stripe(raid_bdev);
+
+	set_thread(1);
+	raid_test_destroy_io_channel(raid_ch2);
+	set_thread(0);
+}
+static void
+test_raid5f_partial_write_other_channel(void)
+{
+	run_for_each_raid5f_config(__test_raid5f_partial_write_other_channel);
+}
+
+/* Run the stripe pool poller at the end of a shrink period */
+static int
+stripe_pool_poll_shrink(struct raid5f_io_channel *r5ch)
+{
+	r5ch->stripe_pool_polls = RAID5F_STRIPE_POOL_SHRINK_POLLS - 1;
+
+	return raid5f_stripe_pool_poller(r5ch);
+}
+
+static void
+__test_raid5f_stripe_pool(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	struct raid5f_io_channel *r5ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	struct stripe_request *stripe_reqs[RAID5F_MIN_STRIPES * 2];
+	uint64_t initial_bytes = r5ch->stripe_pool_bytes;
+	int i;
+
+	CU_ASSERT(r5ch->write_pool.size == RAID5F_MIN_STRIPES);
+	CU_ASSERT(r5ch->reconstruct_pool.size == RAID5F_MIN_STRIPES);
+	CU_ASSERT(r5f_info->stats.stripe_requests == 2 * RAID5F_MIN_STRIPES);
+	CU_ASSERT(r5f_info->stats.stripe_request_bytes == initial_bytes);
+	r5ch->stripe_pool_polls = 0;
+
+	/* The pool doesn't grow in the I/O path, requests are failed when it runs out */
+	for (i = 0; i < RAID5F_MIN_STRIPES; i++) {
+		stripe_reqs[i] = raid5f_stripe_request_get(r5ch, STRIPE_REQ_WRITE);
+		SPDK_CU_ASSERT_FATAL(stripe_reqs[i] != NULL);
+	}
+	CU_ASSERT(raid5f_stripe_request_get(r5ch, STRIPE_REQ_WRITE) == NULL);
+	CU_ASSERT(r5f_info->stats.starved == 1);
+	CU_ASSERT(r5ch->write_pool.size == RAID5F_MIN_STRIPES);
+	CU_ASSERT(r5f_info->stats.grown == 0);
+
+	/* The poller grows it by half */
+	CU_ASSERT(raid5f_stripe_pool_poller(r5ch) == SPDK_POLLER_BUSY);
+	CU_ASSERT(r5ch->write_pool.size == RAID5F_MIN_STRIPES * 3 / 2);
+	CU_ASSERT(r5ch->reconstruct_pool.size == RAID5F_MIN_STRIPES);
+	CU_ASSERT(r5f_info->stats.grown == RAID5F_MIN_STRIPES / 2);
+	stripe_reqs[i] = raid5f_stripe_request_get(r5ch, STRIPE_REQ_WRITE);
+	SPDK_CU_ASSERT_FATAL(stripe_reqs[i] != NULL);
+	i++;
+
+	/* With more than a quarter of it free, it doesn't grow */
+	CU_ASSERT(raid5f_stripe_pool_poller(r5ch) == SPDK_POLLER_IDLE);
+	CU_ASSERT(r5ch->write_pool.size == RAID5F_MIN_STRIPES * 3 / 2);
+
+	/* Below the watermark, it grows before it runs out */
+	for (; i < RAID5F_MIN_STRIPES * 3 / 2 - 1; i++) {
+		stripe_reqs[i] = raid5f_stripe_request_get(r5ch, STRIPE_REQ_WRITE);
+		SPDK_CU_ASSERT_FATAL(stripe_reqs[i] != NULL);
+	}
+	CU_ASSERT(raid5f_stripe_pool_poller(r5ch) == SPDK_POLLER_BUSY);
+	CU_ASSERT(r5ch->write_pool.size == RAID5F_MIN_STRIPES * 9 / 4);
+	CU_ASSERT(r5f_info->stats.starved == 1);
+
+	for (i = 0; i < RAID5F_MIN_STRIPES * 3 / 2 - 1; i++) {
+		raid5f_stripe_request_release(stripe_reqs[i]);
+	}
+	CU_ASSERT(r5ch->write_pool.in_use == 0);
+
+	/* Half of it was used in this period, so it doesn't shrink yet */
+	CU_ASSERT(stripe_pool_poll_shrink(r5ch) == SPDK_POLLER_IDLE);
+	CU_ASSERT(r5ch->write_pool.size == RAID5F_MIN_STRIPES * 9 / 4);
+
+	/* Unused for a whole period, it is halved */
+	CU_ASSERT(stripe_pool_poll_shrink(r5ch) == SPDK_POLLER_BUSY);
+	CU_ASSERT(r5ch->write_pool.size == RAID5F_MIN_STRIPES * 9 / 8);
+	CU_ASSERT(stripe_pool_poll_shrink(r5ch) == SPDK_POLLER_BUSY);
+	CU_ASSERT(r5ch->write_pool.size == RAID5F_MIN_STRIPES);
+	CU_ASSERT(r5ch->stripe_pool_bytes == initial_bytes);
+	CU_ASSERT(r5f_info->stats.shrunk == RAID5F_MIN_STRIPES * 5 / 4);
+
+	/* The memory limit stops the growth */
+	g_opts.raid5f_stripe_pool_max_kb = initial_bytes / 1024;
+	for (i = 0; i < RAID5F_MIN_STRIPES; i++) {
+		stripe_reqs[i] = raid5f_stripe_request_get(r5ch, STRIPE_REQ_WRITE);
+		SPDK_CU_ASSERT_FATAL(stripe_reqs[i] != NULL);
+	}
+	CU_ASSERT(raid5f_stripe_request_get(r5ch, STRIPE_REQ_WRITE) == NULL);
+	CU_ASSERT(r5f_info->stats.starved == 2);
+	CU_ASSERT(raid5f_stripe_pool_poller(r5ch) == SPDK_POLLER_IDLE);
+	CU_ASSERT(r5ch->write_pool.size == RAID5F_MIN_STRIPES);
+
+	/* Without the limit it grows again */
+	g_opts.raid5f_stripe_pool_max_kb = 0;
+	CU_ASSERT(raid5f_stripe_pool_poller(r5ch) == SPDK_POLLER_BUSY);
+	CU_ASSERT(r5ch->write_pool.size == RAID5F_MIN_STRIPES * 3 / 2);
+
+	for (i = 0; i < RAID5F_MIN_STRIPES; i++) {
+		raid5f_stripe_request_release(stripe_reqs[i]);
+	}
+
+	/* Lowering the limit shrinks the pool right away, even if it was fully used */
+	g_opts.raid5f_stripe_pool_max_kb = initial_bytes / 1024;
+	CU_ASSERT(raid5f_stripe_pool_poller(r5ch) == SPDK_POLLER_BUSY);
+	CU_ASSERT(r5ch->write_pool.size == RAID5F_MIN_STRIPES);
+	CU_ASSERT(r5ch->stripe_pool_bytes == initial_bytes);
+	g_opts.raid5f_stripe_pool_max_kb = 0;
+}
+static void
+test_raid5f_stripe_pool(void)
+{
+	run_for_each_raid5f_config(__test_raid5f_stripe_pool);
+}
+
+static struct raid_bdev_process_request *
+scrub_stripe(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch, bool repair)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	size_t strip_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	size_t strip_md_len = raid_bdev->strip_size * raid_bdev->bdev.md_len;
+	struct raid_bdev_process_request *process_req;
+	struct raid_io_info io_info = {};
+	int i;
+
+	process_req = calloc(1, sizeof(*process_req));
+	SPDK_CU_ASSERT_FATAL(process_req != NULL);
+	process_req->offset_blocks = g_base_bdev_stripe_index * r5f_info->stripe_blocks;
+	process_req->num_blocks = r5f_info->stripe_blocks;
+	process_req->iov.iov_base = calloc(2, strip_len);
+	SPDK_CU_ASSERT_FATAL(process_req->iov.iov_base != NULL);
+	process_req->iov.iov_len = strip_len;
+	process_req->scrub.iov.iov_base = process_req->iov.iov_base + strip_len;
+	process_req->scrub.iov.iov_len = strip_len;
+	if (g_base_bdev_md_bufs != NULL) {
+		process_req->md_buf = calloc(2, strip_md_len);
+		SPDK_CU_ASSERT_FATAL(process_req->md_buf != NULL);
+		process_req->scrub.md_buf = process_req->md_buf + strip_md_len;
+	}
+	process_req->scrub.repair = repair;
+
+	raid_test_bdev_io_init(&process_req->raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+			       process_req->offset_blocks, raid_bdev->strip_size, &process_req->iov, 1,
+			       process_req->md_buf);
+	process_req->raid_io.base_bdev_io_submitted = raid5f_stripe_parity_chunk_index(raid_bdev,
+			g_base_bdev_stripe_index);
+
+	TAILQ_INIT(&io_info.bdev_io_queue);
+	TAILQ_INIT(&io_info.bdev_io_wait_queue);
+	g_scrub_io_info = &io_info;
+	g_process_req_completed = false;
+	g_process_req_status = -1;
+
+	raid5f_scrub_read_chunk(&process_req->raid_io);
+
+	for (i = 0; i < 100 && !g_process_req_completed; i++) {
+		poll_threads();
+		process_io_completions(&io_info);
+	}
+
+	CU_ASSERT(g_process_req_completed == true);
+	CU_ASSERT(g_process_req_status == 0);
+	g_scrub_io_info = NULL;
+
+	return process_req;
+}
+
+static void
+scrub_free(struct raid_bdev_process_request *process_req)
+{
+	free(process_req->iov.iov_base);
+	free(process_req->md_buf);
+	free(process_req);
+}
+
+static void
+__test_raid5f_scrub(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	uint32_t strip_size = raid_bdev->strip_size;
+	size_t strip_len = strip_size * raid_bdev->bdev.blocklen;
+	struct raid_bdev_process_request *process_req;
+	struct raid5f_stripe_lock_bucket *bucket;
+	uint64_t stripe_index;
+	uint64_t gen;
+	uint8_t p_idx, d_idx[2];
+	void *corrupt;
+
+	corrupt = malloc(strip_len);
+	SPDK_CU_ASSERT_FATAL(corrupt != NULL);
+	memset(corrupt, 0xa5, strip_len);
+
+	RAID5F_TEST_FOR_EACH_STRIPE(raid_bdev, stripe_index) {
+		bucket = &r5f_info->stripe_locks[stripe_index % RAID5F_STRIPE_LOCK_BUCKETS];
+		p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, stripe_index);
+		d_idx[0] = p_idx == 0 ? 1 : 0;
+		d_idx[1] = p_idx == d_idx[0] + 1 ? d_idx[0] + 2 : d_idx[0] + 1;
+
+		partial_write_init_stripe(raid_bdev, stripe_index);
+
+		/* A consistent stripe is left as it is */
+		process_req = scrub_stripe(raid_bdev, raid_ch, true);
+		CU_ASSERT(process_req->scrub.mismatched_blocks == 0);
+		CU_ASSERT(process_req->scrub.read_error_blocks == 0);
+		CU_ASSERT(process_req->scrub.repaired_blocks == 0);
+		scrub_free(process_req);
+
+		/* Put the stripe in the stripe cache before its parity goes bad on the base bdev */
+		test_raid5f_partial_write(raid_bdev, raid_ch, 0, 1);
+		memcpy(g_base_bdev_bufs[p_idx], corrupt, strip_len);
+
+		/* Parity mismatch without repair is only counted */
+		process_req = scrub_stripe(raid_bdev, raid_ch, false);
+		CU_ASSERT(process_req->scrub.mismatched_blocks == strip_size);
+		CU_ASSERT(process_req->scrub.read_error_blocks == 0);
+		CU_ASSERT(process_req->scrub.repaired_blocks == 0);
+		CU_ASSERT(memcmp(g_base_bdev_bufs[p_idx], corrupt, strip_len) == 0);
+		scrub_free(process_req);
+
+		/* Parity mismatch with repair rewrites the parity and invalidates the cached stripe */
+		gen = bucket->gen;
+		process_req = scrub_stripe(raid_bdev, raid_ch, true);
+		CU_ASSERT(process_req->scrub.mismatched_blocks == strip_size);
+		CU_ASSERT(process_req->scrub.read_error_blocks == 0);
+		CU_ASSERT(process_req->scrub.repaired_blocks == strip_size);
+		CU_ASSERT(bucket->gen != gen);
+		scrub_free(process_req);
+		partial_write_check_stripe(raid_bdev, raid_ch);
+
+		g_base_bdev_blocks_read = 0;
+		test_raid5f_partial_write(raid_bdev, raid_ch, 1, 1);
+		CU_ASSERT(g_base_bdev_blocks_read != 0);
+
+		/* An unreadable data chunk is reconstructed and rewritten */
+		memcpy(g_base_bdev_bufs[d_idx[0]], corrupt, strip_len);
+		g_scrub_read_errors = 1u << d_idx[0];
+		process_req = scrub_stripe(raid_bdev, raid_ch, true);
+		CU_ASSERT(process_req->scrub.mismatched_blocks == 0);
+		CU_ASSERT(process_req->scrub.read_error_blocks == strip_size);
+		CU_ASSERT(process_req->scrub.repaired_blocks == strip_size);
+		scrub_free(process_req);
+		g_scrub_read_errors = 0;
+		partial_write_check_stripe(raid_bdev, raid_ch);
+
+		/* Two unreadable chunks can't be reconstructed, nothing is written */
+		memcpy(g_base_bdev_bufs[d_idx[0]], corrupt, strip_len);
+		g_scrub_read_errors = (1u << d_idx[0]) | (1u << d_idx[1]);
+		process_req = scrub_stripe(raid_bdev, raid_ch, true);
+		CU_ASSERT(process_req->scrub.mismatched_blocks == 0);
+		CU_ASSERT(process_req->scrub.read_error_blocks == strip_size);
+		CU_ASSERT(process_req->scrub.repaired_blocks == 0);
+		CU_ASSERT(memcmp(g_base_bdev_bufs[d_idx[0]], corrupt, strip_len) == 0);
+		scrub_free(process_req);
+		g_scrub_read_errors = 0;
+
+		partial_write_fini_stripe(raid_bdev);
+	}
+
+	free(corrupt);
+}
+static void
+test_raid5f_scrub(void)
+{
+	run_for_each_raid5f_config(__test_raid5f_scrub);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1133,8 +1978,16 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_raid5f_chunk_write_error_with_enomem);
 	CU_ADD_TEST(suite, test_raid5f_submit_full_stripe_write_request_degraded);
 	CU_ADD_TEST(suite, test_raid5f_submit_read_request_degraded);
-
-	allocate_threads(1);
+	CU_ADD_TEST(suite, test_raid5f_submit_partial_write_request);
+	CU_ADD_TEST(suite, test_raid5f_submit_partial_write_request_degraded);
+	CU_ADD_TEST(suite, test_raid5f_partial_write_error);
+	CU_ADD_TEST(suite, test_raid5f_partial_write_sequential);
+	CU_ADD_TEST(suite, test_raid5f_partial_write_lock);
+	CU_ADD_TEST(suite, test_raid5f_partial_write_other_channel);
+	CU_ADD_TEST(suite, test_raid5f_stripe_pool);
+	CU_ADD_TEST(suite, test_raid5f_scrub);
+
+	allocate_threads(2);
 	set_thread(0);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
@@ -1092,6 +1092,353 @@ test_governor(void)
 	free_cores();
 }
 
+static void
+ut_hybrid_opts_done(void *cb_arg)
+{
+	*(bool *)cb_arg = true;
+}
+
+static void
+ut_hybrid_msg_fn(void *ctx)
+{
+	*(bool *)ctx = true;
+}
+
+static void
+ut_hybrid_event_fn(void *arg1, void *arg2)
+{
+	*(bool *)arg1 = true;
+}
+
+struct ut_hybrid_sender {
+	struct spdk_thread	*thread;
+	bool			*done;
+};
+
+static void *
+ut_hybrid_send_msg(void *arg)
+{
+	struct ut_hybrid_sender *sender = arg;
+
+	usleep(10000);
+	spdk_thread_send_msg(sender->thread, ut_hybrid_msg_fn, sender->done);
+
+	return NULL;
+}
+
+static void *
+ut_hybrid_send_event(void *arg)
+{
+	struct ut_hybrid_sender *sender = arg;
+	struct spdk_event *event;
+
+	usleep(10000);
+	event = spdk_event_allocate(0, ut_hybrid_event_fn, sender->done, NULL);
+	SPDK_CU_ASSERT_FATAL(event != NULL);
+	spdk_event_call(event);
+
+	return NULL;
+}
+
+static void
+test_reactor_hybrid_poll(void)
+{
+	struct spdk_reactor_hybrid_opts opts, saved_opts;
+	struct ut_hybrid_sender sender;
+	struct spdk_reactor *reactor;
+	struct spdk_thread *thread;
+	struct spdk_event *event;
+	struct timespec start, end;
+	pthread_t tid;
+	uint8_t test1 = 0, test2 = 0;
+	bool done = false, msg_done = false, event_done = false;
+	uint32_t i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(1);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	reactor = spdk_reactor_get(0);
+	SPDK_CU_ASSERT_FATAL(reactor != NULL);
+
+	/* The completion of setting the options is sent to the app thread */
+	thread = spdk_thread_create("app_thread", NULL);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+	CU_ASSERT(thread == spdk_thread_get_app_thread());
+	_reactor_run(reactor);
+	CU_ASSERT(reactor->thread_count == 1);
+
+	/* The ticks are mocked, so UMWAIT would never reach its deadline */
+	g_reactor_has_waitpkg = false;
+
+	spdk_reactors_get_hybrid_opts(&saved_opts);
+	CU_ASSERT(saved_opts.enabled == false);
+
+	/* Check that invalid options are rejected */
+	opts = (struct spdk_reactor_hybrid_opts) {
+		.enabled = true, .idle_iterations = 0, .min_sleep_us = 1, .max_sleep_us = 4
+	};
+	CU_ASSERT(spdk_reactors_set_hybrid_opts(&opts, ut_hybrid_opts_done, &done) == -EINVAL);
+	opts.idle_iterations = 3;
+	opts.min_sleep_us = 0;
+	CU_ASSERT(spdk_reactors_set_hybrid_opts(&opts, ut_hybrid_opts_done, &done) == -EINVAL);
+	opts.min_sleep_us = 8;
+	CU_ASSERT(spdk_reactors_set_hybrid_opts(&opts, ut_hybrid_opts_done, &done) == -EINVAL);
+	opts.min_sleep_us = 1;
+	CU_ASSERT(spdk_reactors_set_hybrid_opts(&opts, ut_hybrid_opts_done, &done) == 0);
+	CU_ASSERT(spdk_reactors_set_hybrid_opts(&opts, ut_hybrid_opts_done, &done) == -EBUSY);
+
+	/* The reactor only uses the options once it processed the event */
+	CU_ASSERT(reactor->hybrid_opts.enabled == false);
+	for (i = 0; i < 3 && !done; i++) {
+		_reactor_run(reactor);
+	}
+	CU_ASSERT(done == true);
+	CU_ASSERT(reactor->hybrid_opts.enabled == true);
+	CU_ASSERT(reactor->hybrid_opts.idle_iterations == opts.idle_iterations);
+
+	MOCK_SET(spdk_get_ticks, 100);
+	reactor->tsc_last = spdk_get_ticks();
+
+	/* The reactor shouldn't sleep until it sees idle_iterations idle iterations in a row */
+	for (i = 0; i < opts.idle_iterations - 1; i++) {
+		reactor_hybrid_poll(reactor, false);
+		CU_ASSERT(reactor->sleep_count == 0);
+	}
+	reactor_hybrid_poll(reactor, true);
+	CU_ASSERT(reactor->idle_iterations == 0);
+	for (i = 0; i < opts.idle_iterations - 1; i++) {
+		reactor_hybrid_poll(reactor, false);
+		CU_ASSERT(reactor->sleep_count == 0);
+	}
+
+	/* Once it does, each following idle iteration doubles the sleep length up to the limit */
+	reactor_hybrid_poll(reactor, false);
+	CU_ASSERT(reactor->sleep_count == 1);
+	CU_ASSERT(reactor->sleep_us == 2);
+	reactor_hybrid_poll(reactor, false);
+	CU_ASSERT(reactor->sleep_count == 2);
+	CU_ASSERT(reactor->sleep_us == 4);
+	reactor_hybrid_poll(reactor, false);
+	CU_ASSERT(reactor->sleep_count == 3);
+	CU_ASSERT(reactor->sleep_us == 4);
+	CU_ASSERT(reactor->wakeup_count == 0);
+
+	/* A pending event should prevent the reactor from sleeping */
+	event = spdk_event_allocate(0, ut_event_fn, &test1, &test2);
+	SPDK_CU_ASSERT_FATAL(event != NULL);
+	spdk_event_call(event);
+	reactor_hybrid_poll(reactor, false);
+	CU_ASSERT(reactor->sleep_count == 3);
+
+	/* Finding work brings the reactor back to busy polling with the shortest sleep */
+	CU_ASSERT(_reactor_run(reactor) == true);
+	CU_ASSERT(test1 == 1);
+	reactor_hybrid_poll(reactor, true);
+	CU_ASSERT(reactor->idle_iterations == 0);
+	CU_ASSERT(reactor->sleep_us == opts.min_sleep_us);
+	CU_ASSERT(_reactor_run(reactor) == false);
+
+	/* So should a pending message */
+	reactor->idle_iterations = opts.idle_iterations;
+	spdk_thread_send_msg(thread, ut_hybrid_msg_fn, &msg_done);
+	reactor_hybrid_poll(reactor, false);
+	CU_ASSERT(reactor->sleep_count == 3);
+	CU_ASSERT(_reactor_run(reactor) == true);
+	CU_ASSERT(msg_done == true);
+
+	/* A message or an event sent to a sleeping reactor cuts the sleep short */
+	done = false;
+	opts.min_sleep_us = opts.max_sleep_us = 10 * SPDK_SEC_TO_USEC;
+	CU_ASSERT(spdk_reactors_set_hybrid_opts(&opts, ut_hybrid_opts_done, &done) == 0);
+	for (i = 0; i < 3 && !done; i++) {
+		_reactor_run(reactor);
+	}
+	CU_ASSERT(done == true);
+
+	msg_done = false;
+	sender.thread = thread;
+	sender.done = &msg_done;
+	CU_ASSERT(pthread_create(&tid, NULL, ut_hybrid_send_msg, &sender) == 0);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	reactor->idle_iterations = opts.idle_iterations;
+	reactor_hybrid_poll(reactor, false);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	pthread_join(tid, NULL);
+	CU_ASSERT(end.tv_sec - start.tv_sec < 5);
+	CU_ASSERT(reactor->sleep_count == 4);
+	CU_ASSERT(reactor->wakeup_count == 1);
+	/* Waking up resets the sleep length */
+	CU_ASSERT(reactor->idle_iterations == 0);
+	CU_ASSERT(reactor->sleep_us == opts.min_sleep_us);
+	CU_ASSERT(_reactor_run(reactor) == true);
+	CU_ASSERT(msg_done == true);
+
+	event_done = false;
+	sender.done = &event_done;
+	CU_ASSERT(pthread_create(&tid, NULL, ut_hybrid_send_event, &sender) == 0);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	reactor->idle_iterations = opts.idle_iterations;
+	reactor_hybrid_poll(reactor, false);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	pthread_join(tid, NULL);
+	CU_ASSERT(end.tv_sec - start.tv_sec < 5);
+	CU_ASSERT(reactor->sleep_count == 5);
+	CU_ASSERT(reactor->wakeup_count == 2);
+	CU_ASSERT(_reactor_run(reactor) == true);
+	CU_ASSERT(event_done == true);
+
+	/* The sleep time is a part of the idle time */
+	CU_ASSERT(reactor->sleep_tsc <= reactor->idle_tsc);
+
+	done = false;
+	CU_ASSERT(spdk_reactors_set_hybrid_opts(&saved_opts, ut_hybrid_opts_done, &done) == 0);
+	for (i = 0; i < 3 && !done; i++) {
+		_reactor_run(reactor);
+	}
+	CU_ASSERT(done == true);
+	CU_ASSERT(reactor->hybrid_opts.enabled == false);
+
+	spdk_set_thread(thread);
+	spdk_thread_exit(thread);
+	spdk_set_thread(NULL);
+	_reactor_run(reactor);
+	CU_ASSERT(reactor->thread_count == 0);
+
+	MOCK_CLEAR(spdk_get_ticks);
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
+static int
+poller_run_stall(void *ctx)
+{
+	struct spdk_reactor *reactor = ctx;
+
+	spdk_delay_us(5000);
+	/* Simulate the watchdog monitor interrupting the reactor */
+	reactor->watchdog_signalled_tsc = reactor->watchdog_tsc;
+	reactor_watchdog_signal_handler(REACTOR_WATCHDOG_SIGNAL);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+event_run_stall(void *arg1, void *arg2)
+{
+	poller_run_stall(arg1);
+}
+
+static void
+test_reactor_watchdog(void)
+{
+	struct spdk_cpuset cpuset = {};
+	struct timespec start, end;
+	struct spdk_reactor *reactor;
+	struct spdk_thread *thread;
+	struct spdk_poller *poller;
+	struct spdk_event *event;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(1);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	spdk_cpuset_set_cpu(&cpuset, 0, true);
+
+	reactor = spdk_reactor_get(0);
+	SPDK_CU_ASSERT_FATAL(reactor != NULL);
+
+	/* The monitor thread is only started along with the reactors */
+	CU_ASSERT(spdk_reactors_get_watchdog_budget() == 0);
+	CU_ASSERT(spdk_reactors_set_watchdog_budget(1000) == 0);
+	CU_ASSERT(spdk_reactors_get_watchdog_budget() == 1000);
+	CU_ASSERT(g_reactor_watchdog_running == false);
+
+	/* Stopping the monitor wakes it up instead of waiting for its period (100ms) to end */
+	g_reactor_watchdog_budget_us = SPDK_SEC_TO_USEC;
+	CU_ASSERT(reactor_watchdog_start() == 0);
+	CU_ASSERT(g_reactor_watchdog_running == true);
+	usleep(1000);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	reactor_watchdog_stop();
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	CU_ASSERT(g_reactor_watchdog_running == false);
+	CU_ASSERT((end.tv_sec - start.tv_sec) * SPDK_SEC_TO_NSEC + end.tv_nsec - start.tv_nsec <
+		  50 * 1000 * 1000);
+	CU_ASSERT(spdk_reactors_set_watchdog_budget(1000) == 0);
+
+	MOCK_SET(spdk_get_ticks, 100);
+	reactor->tsc_last = spdk_get_ticks();
+
+	thread = spdk_thread_create("stall_thread", &cpuset);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+
+	spdk_set_thread(thread);
+	poller = SPDK_POLLER_REGISTER(poller_run_stall, reactor, 0);
+	CU_ASSERT(poller != NULL);
+	spdk_set_thread(NULL);
+
+	/* A stall in a poller captures the thread and the poller */
+	reactor->watchdog_tsc = reactor->tsc_last;
+	_reactor_run(reactor);
+	CU_ASSERT(reactor->stall_captured == true);
+	CU_ASSERT(reactor->stall_capture.tsc == 100);
+	CU_ASSERT(strcmp(reactor->stall_capture.thread_name, "stall_thread") == 0);
+	CU_ASSERT(strcmp(reactor->stall_capture.poller_name, "poller_run_stall") == 0);
+	CU_ASSERT(reactor->stall_capture.fn == (void *)poller_run_stall);
+
+	/* It's reported once the iteration is over */
+	reactor_watchdog_report(reactor);
+	CU_ASSERT(reactor->stall_captured == false);
+	CU_ASSERT(reactor->stall_count == 1);
+	CU_ASSERT(reactor->stalls[0].tsc == 100);
+	CU_ASSERT(reactor->stalls[0].duration_tsc == 5000);
+	CU_ASSERT(strcmp(reactor->stalls[0].fn_name, "poller_run_stall") == 0);
+
+	spdk_set_thread(thread);
+	spdk_poller_unregister(&poller);
+	spdk_thread_exit(thread);
+	spdk_set_thread(NULL);
+	_reactor_run(reactor);
+
+	/* A signal arriving after the stalled iteration ended is ignored */
+	reactor->watchdog_tsc = reactor->tsc_last;
+	reactor_watchdog_signal_handler(REACTOR_WATCHDOG_SIGNAL);
+	CU_ASSERT(reactor->stall_captured == false);
+
+	/* A stall in an event has no thread */
+	event = spdk_event_allocate(0, event_run_stall, reactor, NULL);
+	SPDK_CU_ASSERT_FATAL(event != NULL);
+	spdk_event_call(event);
+	reactor->watchdog_tsc = reactor->tsc_last;
+	_reactor_run(reactor);
+	CU_ASSERT(reactor->stall_captured == true);
+	CU_ASSERT(reactor->stall_capture.thread_name[0] == '\0');
+	CU_ASSERT(reactor->stall_capture.poller_name[0] == '\0');
+	CU_ASSERT(reactor->stall_capture.fn == (void *)event_run_stall);
+	CU_ASSERT(reactor->running_event_fn == NULL);
+
+	reactor_watchdog_report(reactor);
+	CU_ASSERT(reactor->stall_count == 2);
+	CU_ASSERT(reactor->stalls[1].duration_tsc == 5000);
+
+	CU_ASSERT(spdk_reactors_set_watchdog_budget(0) == 0);
+
+	MOCK_CLEAR(spdk_get_ticks);
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1112,6 +1459,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_reactor_stats);
 	CU_ADD_TEST(suite, test_scheduler);
 	CU_ADD_TEST(suite, test_governor);
+	CU_ADD_TEST(suite, test_reactor_hybrid_poll);
+	CU_ADD_TEST(suite, test_reactor_watchdog);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
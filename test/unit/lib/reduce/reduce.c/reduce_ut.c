@@ -656,6 +656,8 @@ _load(uint32_t backing_blocklen)
 	params.chunk_size = 16 * 1024;
 	params.backing_io_unit_size = 512;
 	params.logical_block_size = 512;
+	params.comp_algo = 1;
+	params.comp_level = 5;
 	spdk_uuid_generate(&params.uuid);
 
 	backing_dev_init(&backing_dev, &params, backing_blocklen);
@@ -682,6 +684,8 @@ _load(uint32_t backing_blocklen)
 	CU_ASSERT(g_vol->params.vol_size == params.vol_size);
 	CU_ASSERT(g_vol->params.chunk_size == params.chunk_size);
 	CU_ASSERT(g_vol->params.backing_io_unit_size == params.backing_io_unit_size);
+	CU_ASSERT(g_vol->params.comp_algo == params.comp_algo);
+	CU_ASSERT(g_vol->params.comp_level == params.comp_level);
 
 	g_reduce_errno = -1;
 	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
@@ -615,6 +615,192 @@ iobuf_cache(void)
 	free_cores();
 }
 
+#define MEDIUM0_BUFSIZE (16 * 1024)
+#define MEDIUM1_BUFSIZE (64 * 1024)
+#define HUGE_BUFSIZE (128 * 1024)
+
+static void
+ut_iobuf_medium_stats_cb(struct spdk_iobuf_module_stats *modules, uint32_t num_modules,
+			 void *cb_arg)
+{
+	struct spdk_iobuf_module_stats *stats = cb_arg;
+
+	SPDK_CU_ASSERT_FATAL(num_modules == 1);
+	*stats = modules[0];
+}
+
+static void
+iobuf_medium(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 2,
+		.large_pool_count = 2,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = HUGE_BUFSIZE,
+		.medium_pool_count = { 2, 2 },
+		.medium_bufsize = { MEDIUM0_BUFSIZE, MEDIUM1_BUFSIZE },
+	};
+	struct spdk_iobuf_opts set_opts;
+	struct spdk_iobuf_module_stats stats = {};
+	struct spdk_iobuf_channel iobuf_ch = {};
+	struct ut_iobuf_entry entries[3] = {};
+	void *buf;
+	int rc, finish = 0;
+
+	allocate_cores(1);
+	allocate_threads(1);
+
+	set_thread(0);
+
+	/* Check the validation of the medium size classes */
+	set_opts = opts;
+	set_opts.opts_size = sizeof(set_opts);
+	set_opts.small_pool_count = IOBUF_MIN_SMALL_POOL_SIZE;
+	set_opts.large_pool_count = IOBUF_MIN_LARGE_POOL_SIZE;
+	set_opts.medium_pool_count[0] = IOBUF_MIN_MEDIUM_POOL_SIZE;
+	set_opts.medium_pool_count[1] = IOBUF_MIN_MEDIUM_POOL_SIZE;
+	rc = spdk_iobuf_set_opts(&set_opts);
+	CU_ASSERT_EQUAL(rc, 0);
+	/* Sizes need to be in ascending order */
+	set_opts.medium_bufsize[0] = MEDIUM1_BUFSIZE;
+	set_opts.medium_bufsize[1] = MEDIUM0_BUFSIZE;
+	rc = spdk_iobuf_set_opts(&set_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	/* ...and fit between small_bufsize and large_bufsize */
+	set_opts.medium_bufsize[0] = SMALL_BUFSIZE;
+	set_opts.medium_bufsize[1] = 0;
+	rc = spdk_iobuf_set_opts(&set_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	set_opts.medium_bufsize[0] = HUGE_BUFSIZE;
+	rc = spdk_iobuf_set_opts(&set_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	/* The sizes are compared after being rounded up to the buffer alignment */
+	set_opts.medium_bufsize[0] = MEDIUM0_BUFSIZE + 1000;
+	set_opts.medium_bufsize[1] = MEDIUM0_BUFSIZE + 2000;
+	rc = spdk_iobuf_set_opts(&set_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	set_opts.medium_bufsize[0] = HUGE_BUFSIZE - 2000;
+	set_opts.medium_bufsize[1] = 0;
+	set_opts.large_bufsize = HUGE_BUFSIZE - 1000;
+	rc = spdk_iobuf_set_opts(&set_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	set_opts.large_bufsize = HUGE_BUFSIZE;
+	set_opts.medium_bufsize[0] = MEDIUM0_BUFSIZE;
+	set_opts.medium_pool_count[0] = IOBUF_MIN_MEDIUM_POOL_SIZE - 1;
+	rc = spdk_iobuf_set_opts(&set_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	/* Everything past the first zero bufsize is ignored */
+	set_opts.medium_pool_count[0] = IOBUF_MIN_MEDIUM_POOL_SIZE;
+	set_opts.medium_bufsize[1] = 0;
+	set_opts.medium_bufsize[2] = MEDIUM1_BUFSIZE;
+	set_opts.medium_pool_count[2] = 1;
+	rc = spdk_iobuf_set_opts(&set_opts);
+	CU_ASSERT_EQUAL(rc, 0);
+	spdk_iobuf_get_opts(&set_opts, sizeof(set_opts));
+	CU_ASSERT_EQUAL(set_opts.medium_bufsize[0], MEDIUM0_BUFSIZE);
+	CU_ASSERT_EQUAL(set_opts.medium_bufsize[1], 0);
+	CU_ASSERT_EQUAL(set_opts.medium_bufsize[2], 0);
+	CU_ASSERT_EQUAL(set_opts.medium_pool_count[2], 0);
+
+	/* We cannot use spdk_iobuf_set_opts(), as it won't allow us to use such small pools */
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_register_module("ut_module0");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_channel_init(&iobuf_ch, "ut_module0", 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(iobuf_ch.num_medium, 2);
+
+	/* Each request should be served from the smallest size class that fits it */
+	buf = spdk_iobuf_get(&iobuf_ch, SMALL_BUFSIZE + 1, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(buf);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.medium_pool[0]), 1);
+	spdk_iobuf_put(&iobuf_ch, buf, SMALL_BUFSIZE + 1);
+	buf = spdk_iobuf_get(&iobuf_ch, MEDIUM1_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(buf);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.medium_pool[1]), 1);
+	spdk_iobuf_put(&iobuf_ch, buf, MEDIUM1_BUFSIZE);
+	buf = spdk_iobuf_get(&iobuf_ch, MEDIUM1_BUFSIZE + 1, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(buf);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.large_pool), 1);
+	spdk_iobuf_put(&iobuf_ch, buf, MEDIUM1_BUFSIZE + 1);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.small_pool), 2);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.medium_pool[0]), 2);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.medium_pool[1]), 2);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.large_pool), 2);
+
+	/* Exhaust a medium pool and verify that the waiters are queued on that class only */
+	entries[0].buf = spdk_iobuf_get(&iobuf_ch, MEDIUM0_BUFSIZE, &entries[0].iobuf,
+					ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NOT_NULL(entries[0].buf);
+	entries[1].buf = spdk_iobuf_get(&iobuf_ch, MEDIUM0_BUFSIZE, &entries[1].iobuf,
+					ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NOT_NULL(entries[1].buf);
+	entries[2].buf = spdk_iobuf_get(&iobuf_ch, MEDIUM0_BUFSIZE, &entries[2].iobuf,
+					ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NULL(entries[2].buf);
+	CU_ASSERT(STAILQ_EMPTY(iobuf_ch.small.queue));
+	CU_ASSERT(STAILQ_EMPTY(iobuf_ch.large.queue));
+	CU_ASSERT_PTR_EQUAL(STAILQ_FIRST(iobuf_ch.medium[0].queue), &entries[2].iobuf);
+
+	spdk_iobuf_put(&iobuf_ch, entries[0].buf, MEDIUM0_BUFSIZE);
+	CU_ASSERT_PTR_EQUAL(entries[2].buf, entries[0].buf);
+	CU_ASSERT(STAILQ_EMPTY(iobuf_ch.medium[0].queue));
+	spdk_iobuf_put(&iobuf_ch, entries[1].buf, MEDIUM0_BUFSIZE);
+	spdk_iobuf_put(&iobuf_ch, entries[2].buf, MEDIUM0_BUFSIZE);
+
+	/* Check that the statistics are reported per size class */
+	rc = spdk_iobuf_get_stats(ut_iobuf_medium_stats_cb, &stats);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT_EQUAL(stats.num_medium_pools, 2);
+	CU_ASSERT_EQUAL(stats.small_pool.main, 0);
+	CU_ASSERT_EQUAL(stats.medium_pool[0].main, 3);
+	CU_ASSERT_EQUAL(stats.medium_pool[0].retry, 1);
+	CU_ASSERT_EQUAL(stats.medium_pool[1].main, 1);
+	CU_ASSERT_EQUAL(stats.medium_pool[1].retry, 0);
+	CU_ASSERT_EQUAL(stats.large_pool.main, 1);
+
+	spdk_iobuf_channel_fini(&iobuf_ch);
+	poll_threads();
+
+	/* Medium caches are sized per class, independent of the large cache */
+	g_iobuf.opts.medium_cache_size[0] = 2;
+	g_iobuf.opts.medium_cache_size[1] = 1;
+	/* ...but modules that opted out of caching don't get them */
+	rc = spdk_iobuf_channel_init(&iobuf_ch, "ut_module0", 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(iobuf_ch.medium[0].cache_count, 0);
+	CU_ASSERT_EQUAL(iobuf_ch.medium[1].cache_count, 0);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.medium_pool[0]), 2);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.medium_pool[1]), 2);
+	spdk_iobuf_channel_fini(&iobuf_ch);
+	poll_threads();
+
+	rc = spdk_iobuf_channel_init(&iobuf_ch, "ut_module0", 1, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(iobuf_ch.large.cache_count, 0);
+	CU_ASSERT_EQUAL(iobuf_ch.medium[0].cache_count, 2);
+	CU_ASSERT_EQUAL(iobuf_ch.medium[1].cache_count, 1);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.medium_pool[0]), 0);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.medium_pool[1]), 1);
+	spdk_iobuf_channel_fini(&iobuf_ch);
+	poll_threads();
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.medium_pool[0]), 2);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.medium_pool[1]), 2);
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+
+	free_threads();
+	free_cores();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -626,6 +812,7 @@ main(int argc, char **argv)
 	suite = CU_add_suite("io_channel", NULL, NULL);
 	CU_ADD_TEST(suite, iobuf);
 	CU_ADD_TEST(suite, iobuf_cache);
+	CU_ADD_TEST(suite, iobuf_medium);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
@@ -202,6 +202,96 @@ thread_poller(void)
 	free_threads();
 }
 
+static int
+poller_run_delay(void *ctx)
+{
+	uint64_t *delay_ticks = ctx;
+
+	MOCK_SET(spdk_get_ticks, spdk_get_ticks() + *delay_ticks);
+
+	return *delay_ticks != 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static void
+thread_poller_run_stats(void)
+{
+	struct spdk_poller	*poller = NULL;
+	struct spdk_poller_stats stats;
+	uint64_t		delay_ticks = 0;
+
+	allocate_threads(1);
+
+	set_thread(0);
+	MOCK_SET(spdk_get_ticks, 0);
+
+	poller = spdk_poller_register(poller_run_delay, &delay_ticks, 0);
+	CU_ASSERT(poller != NULL);
+
+	/* An execution that took no time lands in the first bucket */
+	poll_thread_times(0, 1);
+	spdk_poller_get_stats(poller, &stats);
+	CU_ASSERT(stats.run_count == 1);
+	CU_ASSERT(stats.run_tsc == 0);
+	CU_ASSERT(stats.max_run_tsc == 0);
+	CU_ASSERT(stats.run_tsc_histogram[0] == 1);
+
+	/* 5 ticks -> [4, 8) bucket */
+	delay_ticks = 5;
+	poll_thread_times(0, 1);
+	spdk_poller_get_stats(poller, &stats);
+	CU_ASSERT(stats.run_count == 2);
+	CU_ASSERT(stats.busy_count == 1);
+	CU_ASSERT(stats.run_tsc == 5);
+	CU_ASSERT(stats.max_run_tsc == 5);
+	CU_ASSERT(stats.run_tsc_histogram[2] == 1);
+
+	/* 1000 ticks -> [512, 1024) bucket, max is updated */
+	delay_ticks = 1000;
+	poll_thread_times(0, 1);
+	spdk_poller_get_stats(poller, &stats);
+	CU_ASSERT(stats.run_tsc == 1005);
+	CU_ASSERT(stats.max_run_tsc == 1000);
+	CU_ASSERT(stats.run_tsc_histogram[9] == 1);
+
+	/* A shorter execution doesn't change max */
+	delay_ticks = 6;
+	poll_thread_times(0, 1);
+	spdk_poller_get_stats(poller, &stats);
+	CU_ASSERT(stats.run_tsc == 1011);
+	CU_ASSERT(stats.max_run_tsc == 1000);
+	CU_ASSERT(stats.run_tsc_histogram[2] == 2);
+
+	/* Anything beyond the histogram range goes to the last bucket */
+	delay_ticks = 1ULL << SPDK_POLLER_RUN_TSC_HISTOGRAM_BUCKETS;
+	poll_thread_times(0, 1);
+	spdk_poller_get_stats(poller, &stats);
+	CU_ASSERT(stats.max_run_tsc == delay_ticks);
+	CU_ASSERT(stats.run_tsc_histogram[SPDK_POLLER_RUN_TSC_HISTOGRAM_BUCKETS - 1] == 1);
+
+	spdk_poller_unregister(&poller);
+	CU_ASSERT(poller == NULL);
+
+	/* Timed pollers are accounted the same way */
+	delay_ticks = 3;
+	poller = spdk_poller_register(poller_run_delay, &delay_ticks, 1000);
+	CU_ASSERT(poller != NULL);
+
+	spdk_delay_us(1000);
+	poll_thread_times(0, 1);
+	spdk_poller_get_stats(poller, &stats);
+	CU_ASSERT(stats.run_count == 1);
+	CU_ASSERT(stats.run_tsc == 3);
+	CU_ASSERT(stats.max_run_tsc == 3);
+	CU_ASSERT(stats.run_tsc_histogram[1] == 1);
+
+	spdk_poller_unregister(&poller);
+	CU_ASSERT(poller == NULL);
+
+	MOCK_CLEAR(spdk_get_ticks);
+
+	free_threads();
+}
+
 struct poller_ctx {
 	struct spdk_poller	*poller;
 	bool			run;
@@ -2015,6 +2105,168 @@ for_each_thread_and_thread_exit_race(void)
 	free_threads();
 }
 
+static void
+obj_cache(void)
+{
+	struct spdk_obj_cache_opts opts = {};
+	struct spdk_obj_cache cache;
+	struct spdk_mempool *pool;
+	void *objs[10];
+	int i, rc;
+
+	pool = spdk_mempool_create("ut_obj_cache", 10, 64, 0, SPDK_ENV_SOCKET_ID_ANY);
+	SPDK_CU_ASSERT_FATAL(pool != NULL);
+
+	/* Invalid options */
+	opts.opts_size = sizeof(opts);
+	opts.high_watermark = 4;
+	opts.low_watermark = 5;
+	opts.batch_size = 3;
+	rc = spdk_obj_cache_init(&cache, pool, &opts);
+	CU_ASSERT(rc == -EINVAL);
+
+	opts.low_watermark = 2;
+	opts.batch_size = 0;
+	rc = spdk_obj_cache_init(&cache, pool, &opts);
+	CU_ASSERT(rc == -EINVAL);
+
+	opts.batch_size = SPDK_OBJ_CACHE_MAX_BATCH + 1;
+	rc = spdk_obj_cache_init(&cache, pool, &opts);
+	CU_ASSERT(rc == -EINVAL);
+
+	opts.batch_size = 3;
+	rc = spdk_obj_cache_init(&cache, pool, &opts);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(spdk_obj_cache_count(&cache) == 0);
+
+	/* An empty cache is refilled with a whole batch */
+	objs[0] = spdk_obj_cache_get(&cache);
+	CU_ASSERT(objs[0] != NULL);
+	CU_ASSERT(spdk_obj_cache_count(&cache) == 2);
+	CU_ASSERT(spdk_mempool_count(pool) == 7);
+	CU_ASSERT(cache.stats.refills == 1);
+
+	objs[1] = spdk_obj_cache_get(&cache);
+	objs[2] = spdk_obj_cache_get(&cache);
+	CU_ASSERT(objs[1] != NULL && objs[2] != NULL);
+	CU_ASSERT(spdk_obj_cache_count(&cache) == 0);
+	CU_ASSERT(cache.stats.refills == 1);
+	CU_ASSERT(cache.stats.gets == 3);
+
+	/* Reserve objects up front */
+	rc = spdk_obj_cache_fill(&cache, 4);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(spdk_obj_cache_count(&cache) == 4);
+	CU_ASSERT(spdk_mempool_count(pool) == 3);
+
+	rc = spdk_obj_cache_fill(&cache, 4);
+	CU_ASSERT(rc == -ENOMEM);
+	CU_ASSERT(spdk_obj_cache_count(&cache) == 4);
+	CU_ASSERT(spdk_mempool_count(pool) == 3);
+
+	/* Exceeding the high watermark returns objects down to the low watermark */
+	spdk_obj_cache_put(&cache, objs[0]);
+	CU_ASSERT(spdk_obj_cache_count(&cache) == 2);
+	CU_ASSERT(spdk_mempool_count(pool) == 6);
+	CU_ASSERT(cache.stats.returns == 1);
+
+	spdk_obj_cache_put(&cache, objs[1]);
+	spdk_obj_cache_put(&cache, objs[2]);
+	CU_ASSERT(spdk_obj_cache_count(&cache) == 4);
+	CU_ASSERT(spdk_mempool_count(pool) == 6);
+	CU_ASSERT(cache.stats.returns == 1);
+	CU_ASSERT(cache.stats.puts == 3);
+
+	/* Drain both the cache and the pool */
+	for (i = 0; i < 4; i++) {
+		objs[i] = spdk_obj_cache_get(&cache);
+		CU_ASSERT(objs[i] != NULL);
+	}
+	rc = spdk_obj_cache_fill(&cache, 5);
+	CU_ASSERT(rc == 0);
+	for (i = 4; i < 9; i++) {
+		objs[i] = spdk_obj_cache_get(&cache);
+		CU_ASSERT(objs[i] != NULL);
+	}
+	CU_ASSERT(spdk_obj_cache_count(&cache) == 0);
+	CU_ASSERT(spdk_mempool_count(pool) == 1);
+
+	/* The pool doesn't have a whole batch left, so a single object is fetched */
+	objs[9] = spdk_obj_cache_get(&cache);
+	CU_ASSERT(objs[9] != NULL);
+	CU_ASSERT(spdk_obj_cache_count(&cache) == 0);
+	CU_ASSERT(spdk_mempool_count(pool) == 0);
+	CU_ASSERT(cache.stats.refills == 2);
+
+	CU_ASSERT(spdk_obj_cache_get(&cache) == NULL);
+	CU_ASSERT(cache.stats.starved == 1);
+	CU_ASSERT(cache.stats.gets == 13);
+
+	for (i = 0; i < 10; i++) {
+		spdk_obj_cache_put(&cache, objs[i]);
+		CU_ASSERT(spdk_obj_cache_count(&cache) <= 4);
+	}
+
+	spdk_obj_cache_fini(&cache);
+	CU_ASSERT(spdk_obj_cache_count(&cache) == 0);
+	CU_ASSERT(spdk_mempool_count(pool) == 10);
+
+	spdk_mempool_free(pool);
+}
+
+static void
+wakeup_cb(void *ctx)
+{
+	int *count = ctx;
+
+	(*count)++;
+}
+
+static void
+thread_wakeup(void)
+{
+	struct spdk_thread *thread0;
+	int count = 0;
+	struct spdk_thread_wakeup wakeup = { .fn = wakeup_cb, .ctx = &count };
+	bool done = false;
+	int rc;
+
+	allocate_threads(2);
+	set_thread(0);
+	thread0 = spdk_get_thread();
+
+	/* The hook is called for each message sent while the thread is armed */
+	rc = spdk_thread_arm_wakeup(thread0, &wakeup);
+	CU_ASSERT(rc == 0);
+	set_thread(1);
+	spdk_thread_send_msg(thread0, send_msg_cb, &done);
+	CU_ASSERT(count == 1);
+
+	/* A thread with messages pending can't be armed */
+	set_thread(0);
+	spdk_thread_disarm_wakeup(thread0);
+	rc = spdk_thread_arm_wakeup(thread0, &wakeup);
+	CU_ASSERT(rc == -EAGAIN);
+	set_thread(1);
+	spdk_thread_send_msg(thread0, send_msg_cb, &done);
+	CU_ASSERT(count == 1);
+
+	poll_thread(0);
+	CU_ASSERT(done);
+
+	/* Nor is the hook called once the thread is disarmed */
+	set_thread(0);
+	rc = spdk_thread_arm_wakeup(thread0, &wakeup);
+	CU_ASSERT(rc == 0);
+	spdk_thread_disarm_wakeup(thread0);
+	set_thread(1);
+	spdk_thread_send_msg(thread0, send_msg_cb, &done);
+	CU_ASSERT(count == 1);
+	poll_thread(0);
+
+	free_threads();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -2028,6 +2280,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, thread_alloc);
 	CU_ADD_TEST(suite, thread_send_msg);
 	CU_ADD_TEST(suite, thread_poller);
+	CU_ADD_TEST(suite, thread_poller_run_stats);
 	CU_ADD_TEST(suite, poller_pause);
 	CU_ADD_TEST(suite, thread_for_each);
 	CU_ADD_TEST(suite, for_each_channel_remove);
@@ -2045,6 +2298,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, spdk_spin);
 	CU_ADD_TEST(suite, for_each_channel_and_thread_exit_race);
 	CU_ADD_TEST(suite, for_each_thread_and_thread_exit_race);
+	CU_ADD_TEST(suite, obj_cache);
+	CU_ADD_TEST(suite, thread_wakeup);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
@@ -6,6 +6,7 @@
 #include "spdk/stdinc.h"
 
 #include "spdk_internal/cunit.h"
+#include "spdk/util.h"
 
 #include "util/crc16.c"
 
@@ -50,6 +51,39 @@ test_crc16_t10dif_copy(void)
 	free(buf3);
 }
 
+static void
+test_crc16_t10dif_clmul(void)
+{
+#ifdef CRC16_HAVE_CLMUL
+	size_t lens[] = { 128, 129, 192, 200, 512, 520, 4096, 4104 };
+	uint8_t *buf;
+	uint16_t crc, ref;
+	size_t i, offset;
+	bool enabled;
+
+	buf = malloc(4104 + 8);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+	for (i = 0; i < 4104 + 8; i++) {
+		buf[i] = rand();
+	}
+
+	enabled = g_crc16_clmul.enabled;
+	/* Compare the results against the table-driven implementation using various lengths and
+	 * unaligned buffers */
+	for (i = 0; i < SPDK_COUNTOF(lens); i++) {
+		for (offset = 0; offset < 8; offset += 3) {
+			g_crc16_clmul.enabled = false;
+			ref = spdk_crc16_t10dif(0x1234, buf + offset, lens[i]);
+			g_crc16_clmul.enabled = enabled;
+			crc = spdk_crc16_t10dif(0x1234, buf + offset, lens[i]);
+			CU_ASSERT(crc == ref);
+		}
+	}
+
+	free(buf);
+#endif
+}
+
 int
 main(int argc, char **argv)
 {
@@ -63,6 +97,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_crc16_t10dif);
 	CU_ADD_TEST(suite, test_crc16_t10dif_seed);
 	CU_ADD_TEST(suite, test_crc16_t10dif_copy);
+	CU_ADD_TEST(suite, test_crc16_t10dif_clmul);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
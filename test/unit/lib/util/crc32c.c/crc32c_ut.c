@@ -164,6 +164,54 @@ test_crc32c_nvme(void)
 	CU_ASSERT(crc == 0x214941A8);
 }
 
+static void
+test_crc32c_streams(void)
+{
+	struct spdk_crc32_table table;
+	size_t lens[] = { 383, 384, 385, 1000, 3071, 3072, 3080, 4096, 8192 + 384 + 17, 65536 };
+	size_t i, offset;
+	uint8_t *buf;
+	uint32_t crc, ref;
+	int clmul, max_clmul = 0;
+
+	crc32_table_init(&table, SPDK_CRC32C_POLYNOMIAL_REFLECT);
+
+	buf = malloc(65536 + 8);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+	for (i = 0; i < 65536 + 8; i++) {
+		buf[i] = rand();
+	}
+
+#if defined(SPDK_HAVE_SSE4_2) || defined(SPDK_HAVE_ARM_CRC)
+	/* Check that both ways of shifting the crc give the same results */
+	if (g_crc32c_have_clmul) {
+		for (i = 0; i < SPDK_COUNTOF(g_crc32c_blocks); i++) {
+			crc = 0xdeadbeef;
+			CU_ASSERT(crc32c_shift_clmul(crc, g_crc32c_blocks[i].clmul_k) ==
+				  crc32c_multmodp(g_crc32c_blocks[i].xpow, crc));
+		}
+		max_clmul = 1;
+	}
+#endif
+
+	for (clmul = 0; clmul <= max_clmul; clmul++) {
+#if defined(SPDK_HAVE_SSE4_2) || defined(SPDK_HAVE_ARM_CRC)
+		g_crc32c_have_clmul = clmul;
+#endif
+		/* Compare the results against the table-based implementation using lengths that
+		 * cover all combinations of long and short streams and unaligned buffers */
+		for (i = 0; i < SPDK_COUNTOF(lens); i++) {
+			for (offset = 0; offset < 8; offset += 3) {
+				ref = crc32_update(&table, buf + offset, lens[i], ~0u);
+				crc = spdk_crc32c_update(buf + offset, lens[i], ~0u);
+				CU_ASSERT(crc == ref);
+			}
+		}
+	}
+
+	free(buf);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -176,6 +224,7 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, test_crc32c);
 	CU_ADD_TEST(suite, test_crc32c_nvme);
+	CU_ADD_TEST(suite, test_crc32c_streams);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
@@ -327,6 +327,70 @@ test_iov_xfer(void)
 	}
 }
 
+static void
+test_iovcpy_nt(void)
+{
+	uint8_t sdata[4096 + 64], ddata[4096 + 64];
+	struct iovec siov[3], diov[2];
+	size_t i, soff, doff, len, rc;
+
+	for (i = 0; i < sizeof(sdata); i++) {
+		sdata[i] = (uint8_t)(i * 7 + 3);
+	}
+
+	CU_ASSERT_EQUAL(spdk_iov_get_nt_threshold(), SPDK_IOV_NT_THRESHOLD_DEFAULT);
+
+	/* Force the non-temporal path and check various alignments and lengths */
+	spdk_iov_set_nt_threshold(1);
+	for (soff = 0; soff < 16; soff += 5) {
+		for (doff = 0; doff < 16; doff += 3) {
+			for (len = 1; len <= 4096; len = len * 3 + 1) {
+				memset(ddata, 0, sizeof(ddata));
+				spdk_memcpy_nt(ddata + doff, sdata + soff, len);
+				CU_ASSERT(memcmp(ddata + doff, sdata + soff, len) == 0);
+				CU_ASSERT(_check_val(ddata, doff, 0) == 0);
+				CU_ASSERT(_check_val(ddata + doff + len,
+						     sizeof(ddata) - doff - len, 0) == 0);
+			}
+		}
+	}
+
+	/* Iovecs split at different offsets on both sides */
+	siov[0].iov_base = sdata + 1;
+	siov[0].iov_len = 100;
+	siov[1].iov_base = sdata + 1 + 100;
+	siov[1].iov_len = 2900;
+	siov[2].iov_base = sdata + 1 + 3000;
+	siov[2].iov_len = 1000;
+	diov[0].iov_base = ddata + 7;
+	diov[0].iov_len = 1500;
+	diov[1].iov_base = ddata + 7 + 1500;
+	diov[1].iov_len = 2600;
+	memset(ddata, 0, sizeof(ddata));
+	rc = spdk_iovcpy_nt(siov, 3, diov, 2);
+	CU_ASSERT(rc == 4000);
+	CU_ASSERT(memcmp(ddata + 7, sdata + 1, 4000) == 0);
+	CU_ASSERT(_check_val(ddata + 7 + 4000, sizeof(ddata) - 7 - 4000, 0) == 0);
+
+	/* Below the threshold regular copy is used, with the same result */
+	spdk_iov_set_nt_threshold(8192);
+	memset(ddata, 0, sizeof(ddata));
+	rc = spdk_iovcpy_nt(siov, 3, diov, 2);
+	CU_ASSERT(rc == 4000);
+	CU_ASSERT(memcmp(ddata + 7, sdata + 1, 4000) == 0);
+
+	/* Destination shorter than the source */
+	spdk_iov_set_nt_threshold(1);
+	diov[1].iov_len = 100;
+	memset(ddata, 0, sizeof(ddata));
+	rc = spdk_iovcpy_nt(siov, 3, diov, 2);
+	CU_ASSERT(rc == 1600);
+	CU_ASSERT(memcmp(ddata + 7, sdata + 1, 1600) == 0);
+	CU_ASSERT(_check_val(ddata + 7 + 1600, sizeof(ddata) - 7 - 1600, 0) == 0);
+
+	spdk_iov_set_nt_threshold(SPDK_IOV_NT_THRESHOLD_DEFAULT);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -345,6 +409,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_memset);
 	CU_ADD_TEST(suite, test_iov_one);
 	CU_ADD_TEST(suite, test_iov_xfer);
+	CU_ADD_TEST(suite, test_iovcpy_nt);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
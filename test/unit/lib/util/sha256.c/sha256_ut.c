@@ -0,0 +1,99 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "util/sha256.c"
+
+static void
+ut_sha256_check(const void *buf, size_t len, const char *expected)
+{
+	uint8_t digest[SPDK_SHA256_DIGEST_LEN];
+	char hex[SPDK_SHA256_DIGEST_LEN * 2 + 1];
+	int i;
+
+	spdk_sha256(buf, len, digest);
+	for (i = 0; i < SPDK_SHA256_DIGEST_LEN; i++) {
+		snprintf(&hex[i * 2], 3, "%02x", digest[i]);
+	}
+
+	CU_ASSERT_STRING_EQUAL(hex, expected);
+}
+
+static void
+ut_sha256_vectors(void)
+{
+	uint8_t buf[4096];
+	size_t i;
+
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = (uint8_t)i;
+	}
+
+	ut_sha256_check("", 0, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	ut_sha256_check("abc", 3, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	/* 56 bytes, the length no longer fits in the first padding block */
+	ut_sha256_check("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56,
+			"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+	ut_sha256_check(buf, sizeof(buf),
+			"c8f5d0341d54d951a71b136e6e2afcb14d11ed8489a7ae126a8fee0df6ecf193");
+}
+
+static void
+test_sha256(void)
+{
+	ut_sha256_vectors();
+#ifdef SHA256_HAVE_SHA_NI
+	/* Run the same vectors using the generic implementation */
+	if (g_sha256_have_sha_ni) {
+		g_sha256_have_sha_ni = false;
+		ut_sha256_vectors();
+		g_sha256_have_sha_ni = true;
+	}
+#endif
+}
+
+static void
+test_sha256_update(void)
+{
+	struct spdk_sha256_ctx ctx;
+	uint8_t buf[1000], expected[SPDK_SHA256_DIGEST_LEN], digest[SPDK_SHA256_DIGEST_LEN];
+	size_t i, off, len;
+
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = (uint8_t)(i * 7);
+	}
+
+	spdk_sha256(buf, sizeof(buf), expected);
+
+	/* Feed the data in chunks of various sizes, crossing the block boundaries */
+	for (len = 1; len < 150; len += 13) {
+		spdk_sha256_init(&ctx);
+		for (off = 0; off < sizeof(buf); off += len) {
+			spdk_sha256_update(&ctx, &buf[off], spdk_min(len, sizeof(buf) - off));
+		}
+		spdk_sha256_final(&ctx, digest);
+		CU_ASSERT(memcmp(digest, expected, sizeof(digest)) == 0);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("sha256", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_sha256);
+	CU_ADD_TEST(suite, test_sha256_update);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+
+	return num_failures;
+}
@@ -97,6 +97,211 @@ test_xor_gen(void)
 	free(ref);
 }
 
+static uint8_t
+ut_gf_mul(uint8_t a, uint8_t b)
+{
+	uint8_t r = 0;
+
+	while (b) {
+		if (b & 1) {
+			r ^= a;
+		}
+		a = (a << 1) ^ ((a & 0x80) ? 0x1d : 0);
+		b >>= 1;
+	}
+
+	return r;
+}
+
+static void
+ut_check_kernels(uint32_t n, uint32_t len, uint32_t misalign)
+{
+	struct {
+		xor_gen_fn xor_fn;
+		xor_gen_pq_fn pq_fn;
+	} kernels[] = {
+		{ xor_gen_basic, xor_gen_pq_basic },
+#ifdef SPDK_XOR_HAVE_X86_DISPATCH
+		{ __builtin_cpu_supports("avx2") ? xor_gen_avx2 : NULL,
+		  __builtin_cpu_supports("avx2") ? xor_gen_pq_avx2 : NULL },
+		{ __builtin_cpu_supports("avx512f") ? xor_gen_avx512 : NULL,
+		  __builtin_cpu_supports("avx512f") ? xor_gen_pq_avx512 : NULL },
+#elif defined(SPDK_XOR_HAVE_NEON)
+		{ xor_gen_neon, xor_gen_pq_neon },
+#endif
+	};
+	uint8_t *bufs[SRC_BUF_COUNT], *ref_p, *ref_q, *p, *q, g;
+	void *sources[SRC_BUF_COUNT];
+	uint32_t i, j, k;
+
+	SPDK_CU_ASSERT_FATAL(n <= SRC_BUF_COUNT);
+
+	ref_p = calloc(1, len);
+	ref_q = calloc(1, len);
+	p = malloc(len + misalign);
+	q = malloc(len + misalign);
+	SPDK_CU_ASSERT_FATAL(ref_p != NULL && ref_q != NULL && p != NULL && q != NULL);
+
+	/* Offset each buffer differently to make sure no alignment is assumed */
+	for (i = 0; i < n; i++) {
+		bufs[i] = malloc(len + misalign + i);
+		SPDK_CU_ASSERT_FATAL(bufs[i] != NULL);
+		sources[i] = bufs[i] + (misalign ? misalign + i : 0);
+		for (j = 0; j < len; j++) {
+			((uint8_t *)sources[i])[j] = rand();
+		}
+	}
+
+	for (i = 0, g = 1; i < n; i++, g = ut_gf_mul(g, 2)) {
+		for (j = 0; j < len; j++) {
+			ref_p[j] ^= ((uint8_t *)sources[i])[j];
+			ref_q[j] ^= ut_gf_mul(g, ((uint8_t *)sources[i])[j]);
+		}
+	}
+
+	for (k = 0; k < SPDK_COUNTOF(kernels); k++) {
+		if (kernels[k].xor_fn == NULL) {
+			continue;
+		}
+
+		memset(p, 0xba, len + misalign);
+		kernels[k].xor_fn(p + misalign, sources, n, len);
+		CU_ASSERT(memcmp(ref_p, p + misalign, len) == 0);
+
+		memset(p, 0xba, len + misalign);
+		memset(q, 0xba, len + misalign);
+		kernels[k].pq_fn(p + misalign, q + misalign, sources, n, len);
+		CU_ASSERT(memcmp(ref_p, p + misalign, len) == 0);
+		CU_ASSERT(memcmp(ref_q, q + misalign, len) == 0);
+	}
+
+	for (i = 0; i < n; i++) {
+		free(bufs[i]);
+	}
+	free(ref_p);
+	free(ref_q);
+	free(p);
+	free(q);
+}
+
+static void
+test_xor_gen_kernels(void)
+{
+	uint32_t lens[] = { 1, 7, 8, 31, 64, 255, 256, 257, 1000, 4096 };
+	uint32_t n, i, misalign;
+
+	for (n = 2; n <= SRC_BUF_COUNT; n++) {
+		for (i = 0; i < SPDK_COUNTOF(lens); i++) {
+			for (misalign = 0; misalign < 2; misalign++) {
+				ut_check_kernels(n, lens[i], misalign);
+			}
+		}
+	}
+}
+
+static void
+test_xor_gen_pq(void)
+{
+	uint8_t src[3][64], p[64], q[64];
+	void *sources[256];
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < SPDK_COUNTOF(sources); i++) {
+		sources[i] = src[i % 3];
+	}
+
+	ret = spdk_xor_gen_pq(p, q, sources, 1, sizeof(p));
+	CU_ASSERT(ret == -EINVAL);
+	ret = spdk_xor_gen_pq(p, q, sources, 256, sizeof(p));
+	CU_ASSERT(ret == -EINVAL);
+
+	/* With D0 = 0, D1 = 1 and D2 = 0x80: P = 0x81, Q = 2 * 1 + 4 * 0x80 = 0x02 ^ 0x3a */
+	memset(src[0], 0, sizeof(src[0]));
+	memset(src[1], 1, sizeof(src[1]));
+	memset(src[2], 0x80, sizeof(src[2]));
+	ret = spdk_xor_gen_pq(p, q, sources, 3, sizeof(p));
+	CU_ASSERT(ret == 0);
+	for (i = 0; i < sizeof(p); i++) {
+		CU_ASSERT(p[i] == 0x81);
+		CU_ASSERT(q[i] == (0x02 ^ 0x3a));
+	}
+
+	ret = spdk_xor_gen_pq(p, q, sources, 255, sizeof(p));
+	CU_ASSERT(ret == 0);
+}
+
+static void
+test_xor_rec_pq(void)
+{
+	uint8_t src[6][67], ref[6][67], p[67], q[67];
+	void *sources[6];
+	uint32_t missing[2];
+	uint32_t n = SPDK_COUNTOF(src), len = sizeof(p);
+	uint32_t i, j, x, y;
+	int ret;
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < len; j++) {
+			ref[i][j] = rand();
+		}
+		memcpy(src[i], ref[i], len);
+		sources[i] = src[i];
+	}
+
+	ret = spdk_xor_gen_pq(p, q, sources, n, len);
+	CU_ASSERT(ret == 0);
+
+	/* Invalid number or indexes of missing buffers, or not enough parity */
+	missing[0] = 0;
+	missing[1] = 0;
+	ret = spdk_xor_rec_pq(p, q, sources, n, missing, 0, len);
+	CU_ASSERT(ret == -EINVAL);
+	ret = spdk_xor_rec_pq(p, q, sources, n, missing, 2, len);
+	CU_ASSERT(ret == -EINVAL);
+	missing[1] = n;
+	ret = spdk_xor_rec_pq(p, q, sources, n, missing, 2, len);
+	CU_ASSERT(ret == -EINVAL);
+	ret = spdk_xor_rec_pq(p, q, sources, n, &missing[1], 1, len);
+	CU_ASSERT(ret == -EINVAL);
+	ret = spdk_xor_rec_pq(NULL, NULL, sources, n, missing, 1, len);
+	CU_ASSERT(ret == -EINVAL);
+	missing[1] = 1;
+	ret = spdk_xor_rec_pq(NULL, q, sources, n, missing, 2, len);
+	CU_ASSERT(ret == -EINVAL);
+	ret = spdk_xor_rec_pq(p, NULL, sources, n, missing, 2, len);
+	CU_ASSERT(ret == -EINVAL);
+
+	for (x = 0; x < n; x++) {
+		/* Single buffer from P */
+		missing[0] = x;
+		memset(src[x], 0xa5, len);
+		ret = spdk_xor_rec_pq(p, NULL, sources, n, missing, 1, len);
+		CU_ASSERT(ret == 0);
+		CU_ASSERT(memcmp(src[x], ref[x], len) == 0);
+
+		/* Single buffer from Q */
+		memset(src[x], 0xa5, len);
+		ret = spdk_xor_rec_pq(NULL, q, sources, n, missing, 1, len);
+		CU_ASSERT(ret == 0);
+		CU_ASSERT(memcmp(src[x], ref[x], len) == 0);
+
+		/* Two buffers, in any order */
+		for (y = 0; y < n; y++) {
+			if (y == x) {
+				continue;
+			}
+			missing[1] = y;
+			memset(src[x], 0xa5, len);
+			memset(src[y], 0x5a, len);
+			ret = spdk_xor_rec_pq(p, q, sources, n, missing, 2, len);
+			CU_ASSERT(ret == 0);
+			CU_ASSERT(memcmp(src[x], ref[x], len) == 0);
+			CU_ASSERT(memcmp(src[y], ref[y], len) == 0);
+		}
+	}
+}
+
 int
 main(int argc, char **argv)
 {
@@ -108,6 +313,9 @@ main(int argc, char **argv)
 	suite = CU_add_suite("xor", NULL, NULL);
 
 	CU_ADD_TEST(suite, test_xor_gen);
+	CU_ADD_TEST(suite, test_xor_gen_kernels);
+	CU_ADD_TEST(suite, test_xor_gen_pq);
+	CU_ADD_TEST(suite, test_xor_rec_pq);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
@@ -0,0 +1,74 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "util/xxhash.c"
+
+static void
+test_xxh64(void)
+{
+	uint8_t buf[4096];
+	size_t i;
+
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = (uint8_t)i;
+	}
+
+	CU_ASSERT(spdk_xxh64("", 0, 0) == 0xef46db3751d8e999ULL);
+	CU_ASSERT(spdk_xxh64("abc", 3, 0) == 0x44bc2cf5ad770999ULL);
+	CU_ASSERT(spdk_xxh64("abc", 3, 1) == 0xbea9ca8199328908ULL);
+	CU_ASSERT(spdk_xxh64(buf, sizeof(buf), 0) == 0x0f6e64be186af6a4ULL);
+	CU_ASSERT(spdk_xxh64(buf, sizeof(buf), 0x1234) == 0x064fcf528e886fb9ULL);
+}
+
+static void
+test_xxh64_update(void)
+{
+	struct spdk_xxh64_state state;
+	uint8_t buf[1000];
+	uint64_t expected;
+	size_t i, off, len;
+
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = (uint8_t)(i * 7);
+	}
+
+	/* Feed the data in chunks of various sizes, crossing the stripe boundaries */
+	for (len = 1; len < 80; len += 3) {
+		expected = spdk_xxh64(buf, sizeof(buf), len);
+		spdk_xxh64_init(&state, len);
+		for (off = 0; off < sizeof(buf); off += len) {
+			spdk_xxh64_update(&state, &buf[off], spdk_min(len, sizeof(buf) - off));
+		}
+		CU_ASSERT(spdk_xxh64_digest(&state) == expected);
+	}
+
+	/* The state can be updated after calculating the digest */
+	spdk_xxh64_init(&state, 0);
+	spdk_xxh64_update(&state, buf, 20);
+	CU_ASSERT(spdk_xxh64_digest(&state) == spdk_xxh64(buf, 20, 0));
+	spdk_xxh64_update(&state, &buf[20], 100);
+	CU_ASSERT(spdk_xxh64_digest(&state) == spdk_xxh64(buf, 120, 0));
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("xxhash", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_xxh64);
+	CU_ADD_TEST(suite, test_xxh64_update);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+
+	return num_failures;
+}
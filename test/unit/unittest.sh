@@ -24,6 +24,7 @@ function unittest_bdev() {
 	$valgrind $testdir/lib/bdev/raid/concat.c/concat_ut
 	$valgrind $testdir/lib/bdev/raid/raid0.c/raid0_ut
 	$valgrind $testdir/lib/bdev/raid/raid1.c/raid1_ut
+	$valgrind $testdir/lib/bdev/raid/raid10.c/raid10_ut
 	$valgrind $testdir/lib/bdev/bdev_zone.c/bdev_zone_ut
 	$valgrind $testdir/lib/bdev/gpt/gpt.c/gpt_ut
 	$valgrind $testdir/lib/bdev/part.c/part_ut
@@ -143,7 +144,9 @@ function unittest_util() {
 	$valgrind $testdir/lib/util/iov.c/iov_ut
 	$valgrind $testdir/lib/util/math.c/math_ut
 	$valgrind $testdir/lib/util/pipe.c/pipe_ut
+	$valgrind $testdir/lib/util/sha256.c/sha256_ut
 	$valgrind $testdir/lib/util/xor.c/xor_ut
+	$valgrind $testdir/lib/util/xxhash.c/xxhash_ut
 }
 
 function unittest_init() {
@@ -230,6 +233,10 @@ if grep -q '#define SPDK_CONFIG_RAID5F 1' $rootdir/include/spdk/config.h; then
 	run_test "unittest_bdev_raid5f" $valgrind $testdir/lib/bdev/raid/raid5f.c/raid5f_ut
 fi
 
+if grep -q '#define SPDK_CONFIG_RAID6F 1' $rootdir/include/spdk/config.h; then
+	run_test "unittest_bdev_raid6f" $valgrind $testdir/lib/bdev/raid/raid6f.c/raid6f_ut
+fi
+
 run_test "unittest_blob_blobfs" unittest_blob
 run_test "unittest_event" unittest_event
 if [ $(uname -s) = Linux ]; then